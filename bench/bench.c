@@ -0,0 +1,395 @@
+/**
+ * @file bench.c
+ * @brief Qalam IDE - Benchmark Harness Implementation
+ *
+ * Every timed repetition is kept, so the median and percentiles come
+ * from the sorted samples rather than from a running mean that a single
+ * page fault or context switch would skew. The 99th percentile uses the
+ * nearest rank, so with the default 31 repetitions it is the slowest.
+ *
+ * The baseline reader only understands the JSON this file writes: it
+ * looks for each "name" and the "median_ns" of the same object.
+ *
+ * @version 0.0.2
+ * @copyright (c) 2026 Qalam Project
+ *
+ * @note Thread Safety: See bench.h.
+ */
+
+#include "bench.h"
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+/*=============================================================================
+ * Internal Structures
+ *============================================================================*/
+
+/**
+ * @brief Benchmark run state
+ */
+struct BenchRun {
+    BenchOptions options;           /**< Harness options */
+    double ns_per_tick;             /**< Nanoseconds per performance counter tick */
+    double* samples;                /**< Per-operation times of the current case */
+    BenchMetric metrics[BENCH_MAX_METRICS]; /**< Results so far */
+    size_t metric_count;            /**< Results in 'metrics' */
+};
+
+/*=============================================================================
+ * Internal Helper Functions
+ *============================================================================*/
+
+static int bench_compare_samples(const void* a, const void* b) {
+    double x = *(const double*)a;
+    double y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+static double bench_median(const double* sorted, size_t count) {
+    if (count % 2) {
+        return sorted[count / 2];
+    }
+    return (sorted[count / 2 - 1] + sorted[count / 2]) / 2.0;
+}
+
+static double bench_percentile(const double* sorted, size_t count, double percent) {
+    size_t rank = (size_t)ceil(percent / 100.0 * (double)count);
+    if (rank == 0) {
+        rank = 1;
+    }
+    return sorted[(rank > count ? count : rank) - 1];
+}
+
+static bool bench_selected(const BenchRun* run, const char* name) {
+    const char* filter = run->options.filter;
+    return !filter || strncmp(name, filter, strlen(filter)) == 0;
+}
+
+/**
+ * @brief Keep the result of samples[0..count) and print it
+ */
+static void bench_keep_metric(BenchRun* run, const char* name, double* samples, uint32_t count,
+                              size_t batch, size_t bytes) {
+    qsort(samples, count, sizeof(double), bench_compare_samples);
+
+    BenchMetric* metric = &run->metrics[run->metric_count++];
+    memset(metric, 0, sizeof(*metric));
+    strncpy(metric->name, name, BENCH_MAX_NAME - 1);
+    metric->median_ns = bench_median(samples, count);
+    metric->p99_ns = bench_percentile(samples, count, 99.0);
+    metric->min_ns = samples[0];
+    metric->repetitions = count;
+    metric->batch = batch;
+    if (bytes && metric->median_ns > 0.0) {
+        metric->mb_per_s = (double)bytes / metric->median_ns * 1e9 / (1024.0 * 1024.0);
+    }
+
+    fprintf(stderr, "  %-36s median %12.1f ns   p99 %12.1f ns", metric->name,
+            metric->median_ns, metric->p99_ns);
+    if (metric->mb_per_s > 0.0) {
+        fprintf(stderr, "   %8.1f MB/s", metric->mb_per_s);
+    }
+    fputc('\n', stderr);
+}
+
+/**
+ * @brief Find a key within [from, end) and return what follows its colon
+ */
+static const char* json_find_value(const char* from, const char* end, const char* key) {
+    size_t key_length = strlen(key);
+
+    for (const char* p = from; p + key_length + 2 <= end; p++) {
+        if (*p != '"' || strncmp(p + 1, key, key_length) != 0 || p[key_length + 1] != '"') {
+            continue;
+        }
+        p += key_length + 2;
+        while (p < end && (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n')) {
+            p++;
+        }
+        if (p < end && *p == ':') {
+            p++;
+            while (p < end && (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n')) {
+                p++;
+            }
+            return p;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief Get the baseline median of a metric, or a negative value if absent
+ */
+static double json_find_median(const char* json, size_t length, const char* name) {
+    const char* end = json + length;
+    const char* p = json;
+    size_t name_length = strlen(name);
+
+    while ((p = json_find_value(p, end, "name")) != NULL) {
+        if (*p != '"' || (size_t)(end - p) < name_length + 2 ||
+            strncmp(p + 1, name, name_length) != 0 || p[name_length + 1] != '"') {
+            continue;
+        }
+
+        const char* object_end = memchr(p, '}', (size_t)(end - p));
+        const char* value = json_find_value(p, object_end ? object_end : end, "median_ns");
+        return value ? strtod(value, NULL) : -1.0;
+    }
+    return -1.0;
+}
+
+static QalamResult bench_read_file(const char* path, char** out_data, size_t* out_length) {
+    FILE* file = fopen(path, "rb");
+    if (!file) {
+        return QALAM_ERROR_FILE_NOT_FOUND;
+    }
+
+    size_t capacity = 4096;
+    size_t length = 0;
+    char* data = malloc(capacity + 1);
+    QalamResult result = data ? QALAM_OK : QALAM_ERROR_OUT_OF_MEMORY;
+
+    while (result == QALAM_OK) {
+        length += fread(data + length, 1, capacity - length, file);
+        if (length < capacity) {
+            if (ferror(file)) {
+                result = QALAM_ERROR_FILE_READ;
+            }
+            break;
+        }
+
+        char* grown = realloc(data, capacity * 2 + 1);
+        if (!grown) {
+            result = QALAM_ERROR_OUT_OF_MEMORY;
+            break;
+        }
+        data = grown;
+        capacity *= 2;
+    }
+    fclose(file);
+
+    if (result != QALAM_OK) {
+        free(data);
+        return result;
+    }
+
+    data[length] = '\0';
+    *out_data = data;
+    *out_length = length;
+    return QALAM_OK;
+}
+
+/*=============================================================================
+ * Lifecycle
+ *============================================================================*/
+
+QalamResult bench_get_default_options(BenchOptions* options) {
+    QALAM_CHECK_NULL(options);
+
+    options->warmup = BENCH_DEFAULT_WARMUP;
+    options->repetitions = BENCH_DEFAULT_REPETITIONS;
+    options->filter = NULL;
+
+    return QALAM_OK;
+}
+
+QalamResult bench_run_create(BenchRun** run, const BenchOptions* options) {
+    QALAM_CHECK_NULL(run);
+
+    *run = NULL;
+
+    BenchRun* new_run = calloc(1, sizeof(BenchRun));
+    if (!new_run) {
+        return QALAM_ERROR_OUT_OF_MEMORY;
+    }
+
+    if (options) {
+        new_run->options = *options;
+    } else {
+        bench_get_default_options(&new_run->options);
+    }
+    if (new_run->options.repetitions == 0) {
+        new_run->options.repetitions = BENCH_DEFAULT_REPETITIONS;
+    }
+
+    new_run->samples = malloc(new_run->options.repetitions * sizeof(double));
+    if (!new_run->samples) {
+        free(new_run);
+        return QALAM_ERROR_OUT_OF_MEMORY;
+    }
+
+    LARGE_INTEGER frequency;
+    QueryPerformanceFrequency(&frequency);
+    new_run->ns_per_tick = 1e9 / (double)frequency.QuadPart;
+
+    *run = new_run;
+    return QALAM_OK;
+}
+
+void bench_run_destroy(BenchRun* run) {
+    if (!run) {
+        return;
+    }
+
+    free(run->samples);
+    free(run);
+}
+
+/*=============================================================================
+ * Measuring
+ *============================================================================*/
+
+bool bench_run_wants(const BenchRun* run, const char* prefix) {
+    if (!run || !prefix) {
+        return false;
+    }
+
+    const char* filter = run->options.filter;
+    if (!filter) {
+        return true;
+    }
+
+    size_t prefix_length = strlen(prefix);
+    size_t filter_length = strlen(filter);
+    return strncmp(prefix, filter,
+                   prefix_length < filter_length ? prefix_length : filter_length) == 0;
+}
+
+QalamResult bench_run_case(BenchRun* run, const BenchCase* bench_case) {
+    QALAM_CHECK_NULL(run);
+    QALAM_CHECK_NULL(bench_case);
+    QALAM_CHECK_NULL(bench_case->name);
+    QALAM_CHECK_NULL(bench_case->body);
+
+    if (!bench_selected(run, bench_case->name)) {
+        return QALAM_OK;
+    }
+    if (run->metric_count == BENCH_MAX_METRICS) {
+        return QALAM_ERROR_BUFFER_FULL;
+    }
+
+    size_t batch = bench_case->batch ? bench_case->batch : 1;
+    uint32_t repetitions = run->options.repetitions;
+
+    for (uint32_t i = 0; i < run->options.warmup; i++) {
+        QALAM_CHECK(bench_case->body(bench_case->user_data, batch));
+    }
+
+    for (uint32_t i = 0; i < repetitions; i++) {
+        LARGE_INTEGER start, end;
+        QueryPerformanceCounter(&start);
+        QalamResult result = bench_case->body(bench_case->user_data, batch);
+        QueryPerformanceCounter(&end);
+
+        if (result != QALAM_OK) {
+            fprintf(stderr, "  %-36s failed (%d)\n", bench_case->name, (int)result);
+            return result;
+        }
+        run->samples[i] = (double)(end.QuadPart - start.QuadPart) * run->ns_per_tick /
+                          (double)batch;
+    }
+
+    bench_keep_metric(run, bench_case->name, run->samples, repetitions, batch, bench_case->bytes);
+    return QALAM_OK;
+}
+
+QalamResult bench_run_add_samples(BenchRun* run, const char* name, double* samples_ns,
+                                  uint32_t count) {
+    QALAM_CHECK_NULL(run);
+    QALAM_CHECK_NULL(name);
+    QALAM_CHECK_NULL(samples_ns);
+
+    if (!bench_selected(run, name)) {
+        return QALAM_OK;
+    }
+    if (count == 0) {
+        return QALAM_ERROR_INVALID_ARGUMENT;
+    }
+    if (run->metric_count == BENCH_MAX_METRICS) {
+        return QALAM_ERROR_BUFFER_FULL;
+    }
+
+    bench_keep_metric(run, name, samples_ns, count, 1, 0);
+    return QALAM_OK;
+}
+
+const BenchOptions* bench_run_get_options(const BenchRun* run) {
+    return run ? &run->options : NULL;
+}
+
+const BenchMetric* bench_run_get_metrics(const BenchRun* run, size_t* count) {
+    if (count) {
+        *count = run ? run->metric_count : 0;
+    }
+    return run ? run->metrics : NULL;
+}
+
+/*=============================================================================
+ * Reporting
+ *============================================================================*/
+
+QalamResult bench_run_write_json(const BenchRun* run, FILE* out) {
+    QALAM_CHECK_NULL(run);
+    QALAM_CHECK_NULL(out);
+
+    fprintf(out, "{\n  \"version\": \"%s\",\n  \"repetitions\": %u,\n"
+                 "  \"warmup\": %u,\n  \"metrics\": [",
+            QALAM_VERSION,
+            run->options.repetitions, run->options.warmup);
+
+    for (size_t i = 0; i < run->metric_count; i++) {
+        const BenchMetric* metric = &run->metrics[i];
+        fprintf(out, "%s\n    {\"name\": \"%s\", \"median_ns\": %.1f, \"p99_ns\": %.1f, "
+                     "\"min_ns\": %.1f, \"mb_per_s\": %.1f, \"repetitions\": %u, "
+                     "\"batch\": %zu}",
+                i ? "," : "", metric->name, metric->median_ns, metric->p99_ns,
+                metric->min_ns, metric->mb_per_s, metric->repetitions, metric->batch);
+    }
+    fprintf(out, "\n  ]\n}\n");
+
+    return ferror(out) ? QALAM_ERROR_FILE_WRITE : QALAM_OK;
+}
+
+QalamResult bench_run_compare(const BenchRun* run, const char* baseline_path, double threshold,
+                              FILE* report, size_t* regressions) {
+    QALAM_CHECK_NULL(run);
+    QALAM_CHECK_NULL(baseline_path);
+    QALAM_CHECK_NULL(report);
+    QALAM_CHECK_NULL(regressions);
+
+    *regressions = 0;
+
+    char* json = NULL;
+    size_t length = 0;
+    QALAM_CHECK(bench_read_file(baseline_path, &json, &length));
+
+    if (!json_find_value(json, json + length, "median_ns")) {
+        free(json);
+        return QALAM_ERROR_INVALID_ARGUMENT;
+    }
+
+    fprintf(report, "\nCompared with %s (threshold %.1f%%):\n", baseline_path, threshold);
+
+    for (size_t i = 0; i < run->metric_count; i++) {
+        const BenchMetric* metric = &run->metrics[i];
+        double baseline = json_find_median(json, length, metric->name);
+
+        if (baseline <= 0.0) {
+            fprintf(report, "  %-36s %12s -> %12.1f ns   new\n", metric->name, "",
+                    metric->median_ns);
+            continue;
+        }
+
+        double change = (metric->median_ns - baseline) / baseline * 100.0;
+        bool regressed = change > threshold;
+        if (regressed) {
+            (*regressions)++;
+        }
+        fprintf(report, "  %-36s %12.1f -> %12.1f ns  %+7.1f%%%s\n", metric->name, baseline,
+                metric->median_ns, change, regressed ? "   REGRESSED" : "");
+    }
+
+    free(json);
+    return QALAM_OK;
+}
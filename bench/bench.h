@@ -0,0 +1,249 @@
+/**
+ * @file bench.h
+ * @brief Qalam IDE - Benchmark Harness
+ *
+ * A small harness for qalam_bench. A benchmark is a named case whose
+ * body runs a batch of the operation being measured; the harness runs
+ * the body a few times untimed to warm caches and page in memory, then
+ * times each repetition with QueryPerformanceCounter() and reports the
+ * median and 99th percentile time of one operation.
+ *
+ * Results are written as JSON, and can be compared against a baseline
+ * written by an earlier run: a metric whose median grew by more than a
+ * threshold is a regression.
+ *
+ * @version 0.0.2
+ * @copyright (c) 2026 Qalam Project
+ *
+ * @note Thread Safety: Not thread-safe.
+ */
+
+#ifndef QALAM_BENCH_H
+#define QALAM_BENCH_H
+
+#include "qalam.h"
+#include <stdio.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*=============================================================================
+ * Configuration Constants
+ *============================================================================*/
+
+/** Longest metric name, including the terminator */
+#define BENCH_MAX_NAME                  64
+
+/** Most metrics one run keeps */
+#define BENCH_MAX_METRICS               64
+
+/** Default untimed repetitions before measuring */
+#define BENCH_DEFAULT_WARMUP            3
+
+/** Default timed repetitions */
+#define BENCH_DEFAULT_REPETITIONS       31
+
+/** Default regression threshold in percent of the baseline median */
+#define BENCH_DEFAULT_THRESHOLD         10.0
+
+/*=============================================================================
+ * Benchmark Structures
+ *============================================================================*/
+
+/**
+ * @brief Run one repetition of a case
+ *
+ * @param user_data Context of the case
+ * @param batch Operations to perform
+ * @return QALAM_OK, or an error code that stops the case
+ */
+typedef QalamResult (*BenchBody)(void* user_data, size_t batch);
+
+/**
+ * @brief A benchmark case
+ */
+typedef struct BenchCase {
+    const char* name;               /**< Metric name, e.g. "buffer.insert.middle" */
+    BenchBody body;                 /**< Runs one repetition */
+    void* user_data;                /**< Context passed to 'body' */
+    size_t batch;                   /**< Operations per repetition (0 for 1) */
+    size_t bytes;                   /**< Bytes one operation processes, for throughput (or 0) */
+} BenchCase;
+
+/**
+ * @brief Harness options
+ */
+typedef struct BenchOptions {
+    uint32_t warmup;                /**< Untimed repetitions */
+    uint32_t repetitions;           /**< Timed repetitions (0 for the default) */
+    const char* filter;             /**< Run only metrics whose name starts with this (or NULL) */
+} BenchOptions;
+
+/**
+ * @brief Result of one case
+ *
+ * Times are of one operation, i.e. a repetition divided by its batch.
+ */
+typedef struct BenchMetric {
+    char name[BENCH_MAX_NAME];      /**< Metric name */
+    double median_ns;               /**< Median time */
+    double p99_ns;                  /**< 99th percentile time */
+    double min_ns;                  /**< Fastest repetition */
+    double mb_per_s;                /**< Throughput at the median (0 without 'bytes') */
+    uint32_t repetitions;           /**< Timed repetitions */
+    size_t batch;                   /**< Operations per repetition */
+} BenchMetric;
+
+/**
+ * @brief Opaque benchmark run
+ */
+typedef struct BenchRun BenchRun;
+
+/*=============================================================================
+ * Lifecycle
+ *============================================================================*/
+
+/**
+ * @brief Get default harness options
+ *
+ * @param[out] options Pointer to options structure to fill
+ * @return QALAM_OK on success
+ */
+QalamResult bench_get_default_options(BenchOptions* options);
+
+/**
+ * @brief Create a benchmark run
+ *
+ * @param[out] run Receives the run
+ * @param options Harness options (NULL for defaults)
+ * @return QALAM_OK on success, error code on failure
+ */
+QalamResult bench_run_create(BenchRun** run, const BenchOptions* options);
+
+/**
+ * @brief Destroy a benchmark run and its results
+ *
+ * @param run Run to destroy (may be NULL)
+ */
+void bench_run_destroy(BenchRun* run);
+
+/*=============================================================================
+ * Measuring
+ *============================================================================*/
+
+/**
+ * @brief Check whether the run's filter selects a metric
+ *
+ * Lets a suite skip building the data of cases it would not run.
+ *
+ * @param run Benchmark run
+ * @param prefix Metric name or the start of several
+ * @return true if a metric starting with the prefix may be selected
+ */
+bool bench_run_wants(const BenchRun* run, const char* prefix);
+
+/**
+ * @brief Measure a case and keep its result
+ *
+ * Prints one line of progress to stderr. A case the filter does not
+ * select is skipped and reports QALAM_OK.
+ *
+ * @param run Benchmark run
+ * @param bench_case Case to measure
+ * @return QALAM_OK on success, QALAM_ERROR_BUFFER_FULL after
+ *         BENCH_MAX_METRICS results, or the error of the case's body
+ */
+QalamResult bench_run_case(BenchRun* run, const BenchCase* bench_case);
+
+/**
+ * @brief Keep a result measured by the caller
+ *
+ * For cases that take several metrics from one repetition, such as the
+ * startup phases: the caller runs the harness's warmup and repetitions
+ * itself and passes one sample per timed repetition. Prints and skips
+ * like bench_run_case().
+ *
+ * @param run Benchmark run
+ * @param name Metric name
+ * @param samples_ns Time of each repetition; reordered by the call
+ * @param count Number of samples (at least 1)
+ * @return QALAM_OK on success, QALAM_ERROR_BUFFER_FULL after
+ *         BENCH_MAX_METRICS results, QALAM_ERROR_INVALID_ARGUMENT without
+ *         samples
+ */
+QalamResult bench_run_add_samples(BenchRun* run, const char* name, double* samples_ns,
+                                  uint32_t count);
+
+/**
+ * @brief Get the options a run was created with
+ *
+ * @param run Benchmark run
+ * @return The options, with repetitions filled in
+ */
+const BenchOptions* bench_run_get_options(const BenchRun* run);
+
+/**
+ * @brief Get the results kept so far
+ *
+ * @param run Benchmark run
+ * @param[out] count Receives the number of results
+ * @return The results, in the order they were measured
+ */
+const BenchMetric* bench_run_get_metrics(const BenchRun* run, size_t* count);
+
+/*=============================================================================
+ * Reporting
+ *============================================================================*/
+
+/**
+ * @brief Write the results as JSON
+ *
+ * The document is an object with a "metrics" array of objects holding
+ * the fields of BenchMetric; it is also the baseline format.
+ *
+ * @param run Benchmark run
+ * @param out Stream to write to
+ * @return QALAM_OK on success, QALAM_ERROR_FILE_WRITE if writing failed
+ */
+QalamResult bench_run_write_json(const BenchRun* run, FILE* out);
+
+/**
+ * @brief Compare the results against a baseline
+ *
+ * Prints a line per metric to 'report'. Metrics the baseline does not
+ * have are listed as new and never regress.
+ *
+ * @param run Benchmark run
+ * @param baseline_path JSON written by bench_run_write_json()
+ * @param threshold Percent the median may grow by before it regresses
+ * @param report Stream to print the comparison to
+ * @param[out] regressions Receives the number of regressed metrics
+ * @return QALAM_OK on success, QALAM_ERROR_FILE_NOT_FOUND or
+ *         QALAM_ERROR_FILE_READ if the baseline could not be read,
+ *         QALAM_ERROR_INVALID_ARGUMENT if it holds no metrics
+ */
+QalamResult bench_run_compare(const BenchRun* run, const char* baseline_path, double threshold,
+                              FILE* report, size_t* regressions);
+
+/*=============================================================================
+ * Suites
+ *============================================================================*/
+
+/** @brief Gap buffer: open, save, edits, line lookup, cursor moves, search */
+QalamResult bench_buffer_suite(BenchRun* run);
+
+/** @brief DirectWrite: layout creation, cached layouts, hit testing */
+QalamResult bench_dwrite_suite(BenchRun* run);
+
+/** @brief Terminal: VT parser and screen throughput */
+QalamResult bench_terminal_suite(BenchRun* run);
+
+/** @brief Startup: time from entry to each startup phase, e.g. first paint */
+QalamResult bench_startup_suite(BenchRun* run);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* QALAM_BENCH_H */
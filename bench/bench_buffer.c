@@ -0,0 +1,380 @@
+/**
+ * @file bench_buffer.c
+ * @brief Qalam IDE - Gap Buffer Benchmarks
+ *
+ * Runs against a generated source file of about 11 MB, a quarter of
+ * whose lines are Arabic comments. The edit cases insert and delete a
+ * short run of text at one place repeatedly, as typing does; each insert
+ * case is followed by the matching delete case, so the buffer keeps its
+ * size from case to case. The search cases look for text the file does
+ * not contain, so each one scans the whole buffer. The growth cases
+ * append to an empty buffer until it holds as much as the file, once
+ * with heap storage and once with reserved virtual memory.
+ *
+ * @version 0.0.2
+ * @copyright (c) 2026 Qalam Project
+ */
+
+#include "bench.h"
+#include "editor.h"
+#include <stdlib.h>
+#include <string.h>
+#include <wchar.h>
+
+/*=============================================================================
+ * Configuration Constants
+ *============================================================================*/
+
+/** Lines in the generated file */
+#define BUFFER_BENCH_LINES              200000
+
+/** Text one edit inserts or deletes */
+#define BUFFER_BENCH_EDIT               "value = value + 1;"
+#define BUFFER_BENCH_EDIT_LENGTH        (sizeof(BUFFER_BENCH_EDIT) - 1)
+
+/** Bytes of UTF-8 one growth append adds */
+#define BUFFER_BENCH_GROW_CHUNK         (64 * 1024)
+
+/*=============================================================================
+ * Internal Structures
+ *============================================================================*/
+
+/** Where an edit case works */
+typedef enum BufferBenchPlace {
+    BUFFER_BENCH_START,
+    BUFFER_BENCH_MIDDLE,
+    BUFFER_BENCH_END
+} BufferBenchPlace;
+
+/**
+ * @brief Data shared by the buffer cases
+ */
+typedef struct BufferBench {
+    QalamBuffer* buffer;            /**< Buffer loaded from 'open_path' */
+    size_t length;                  /**< Length of 'buffer' in UTF-16 units */
+    wchar_t open_path[MAX_PATH];    /**< Generated file */
+    wchar_t save_path[MAX_PATH];    /**< File the save case writes */
+    uint32_t seed;                  /**< State of the pseudo-random positions */
+    char* grow_chunk;               /**< Text of one growth append */
+    size_t grow_appends;            /**< Appends that reach the file's size */
+} BufferBench;
+
+/**
+ * @brief An edit case
+ */
+typedef struct BufferBenchEdit {
+    BufferBench* bench;             /**< Shared data */
+    BufferBenchPlace place;         /**< Where to edit */
+} BufferBenchEdit;
+
+/**
+ * @brief A growth case
+ */
+typedef struct BufferBenchGrow {
+    BufferBench* bench;             /**< Shared data */
+    bool virtual_memory;            /**< Storage to grow */
+} BufferBenchGrow;
+
+/*=============================================================================
+ * Internal Helper Functions
+ *============================================================================*/
+
+static uint32_t buffer_bench_random(BufferBench* bench) {
+    uint32_t x = bench->seed;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    bench->seed = x;
+    return x;
+}
+
+static size_t buffer_bench_offset(const BufferBench* bench, BufferBenchPlace place,
+                                  size_t span) {
+    switch (place) {
+        case BUFFER_BENCH_START:
+            return 0;
+        case BUFFER_BENCH_MIDDLE:
+            return bench->length / 2;
+        case BUFFER_BENCH_END:
+        default:
+            return bench->length > span ? bench->length - span : 0;
+    }
+}
+
+static char* buffer_bench_generate(size_t* out_length) {
+    size_t capacity = (size_t)BUFFER_BENCH_LINES * 96;
+    char* text = malloc(capacity);
+    if (!text) {
+        return NULL;
+    }
+
+    size_t length = 0;
+    for (size_t i = 0; i < BUFFER_BENCH_LINES; i++) {
+        int written;
+        if (i % 4 == 3) {
+            written = snprintf(text + length, capacity - length,
+                               "    // \xd8\xad\xd8\xb3\xd8\xa7\xd8\xa8 "
+                               "\xd8\xa7\xd9\x84\xd9\x82\xd9\x8a\xd9\x85\xd8\xa9 "
+                               "\xd8\xb1\xd9\x82\xd9\x85 %zu\n", i);
+        } else {
+            written = snprintf(text + length, capacity - length,
+                               "    total += values[%zu] * factor; /* step %zu */\n",
+                               i, i % 7);
+        }
+        length += (size_t)written;
+    }
+
+    *out_length = length;
+    return text;
+}
+
+/*=============================================================================
+ * Cases
+ *============================================================================*/
+
+static QalamResult bench_open(void* user_data, size_t batch) {
+    BufferBench* bench = user_data;
+
+    for (size_t i = 0; i < batch; i++) {
+        QalamBuffer* buffer = NULL;
+        QALAM_CHECK(qalam_buffer_create_from_file(&buffer, bench->open_path));
+        qalam_buffer_destroy(buffer);
+    }
+    return QALAM_OK;
+}
+
+static QalamResult bench_save(void* user_data, size_t batch) {
+    BufferBench* bench = user_data;
+
+    for (size_t i = 0; i < batch; i++) {
+        QALAM_CHECK(qalam_buffer_save(bench->buffer, bench->save_path));
+    }
+    return QALAM_OK;
+}
+
+static QalamResult bench_insert(void* user_data, size_t batch) {
+    BufferBenchEdit* edit = user_data;
+
+    for (size_t i = 0; i < batch; i++) {
+        size_t offset = buffer_bench_offset(edit->bench, edit->place, 0);
+        QALAM_CHECK(qalam_buffer_insert_at(edit->bench->buffer, offset, BUFFER_BENCH_EDIT,
+                                           BUFFER_BENCH_EDIT_LENGTH));
+        edit->bench->length += BUFFER_BENCH_EDIT_LENGTH;
+    }
+    return QALAM_OK;
+}
+
+static QalamResult bench_delete(void* user_data, size_t batch) {
+    BufferBenchEdit* edit = user_data;
+
+    for (size_t i = 0; i < batch; i++) {
+        size_t offset = buffer_bench_offset(edit->bench, edit->place, BUFFER_BENCH_EDIT_LENGTH);
+        QALAM_CHECK(qalam_buffer_delete_range(edit->bench->buffer, offset,
+                                              offset + BUFFER_BENCH_EDIT_LENGTH));
+        edit->bench->length -= BUFFER_BENCH_EDIT_LENGTH;
+    }
+    return QALAM_OK;
+}
+
+static QalamResult bench_grow(void* user_data, size_t batch) {
+    BufferBenchGrow* grow = user_data;
+    BufferBench* bench = grow->bench;
+
+    QalamBufferOptions options;
+    qalam_buffer_get_default_options(&options);
+    options.backend = QALAM_BUFFER_BACKEND_GAP;
+    options.virtual_memory = grow->virtual_memory;
+
+    for (size_t i = 0; i < batch; i++) {
+        QalamBuffer* buffer = NULL;
+        QALAM_CHECK(qalam_buffer_create_with_options(&buffer, &options));
+        QalamResult result = QALAM_OK;
+        for (size_t n = 0; n < bench->grow_appends && result == QALAM_OK; n++) {
+            result = qalam_buffer_insert(buffer, bench->grow_chunk, BUFFER_BENCH_GROW_CHUNK);
+        }
+        qalam_buffer_destroy(buffer);
+        QALAM_CHECK(result);
+    }
+    return QALAM_OK;
+}
+
+static QalamResult bench_line_info(void* user_data, size_t batch) {
+    BufferBench* bench = user_data;
+    size_t lines = qalam_buffer_get_line_count(bench->buffer);
+
+    for (size_t i = 0; i < batch; i++) {
+        QalamLineInfo info;
+        QALAM_CHECK(qalam_buffer_get_line_info(bench->buffer,
+                                               buffer_bench_random(bench) % lines, &info));
+    }
+    return QALAM_OK;
+}
+
+static QalamResult bench_cursor_offset(void* user_data, size_t batch) {
+    BufferBench* bench = user_data;
+
+    for (size_t i = 0; i < batch; i++) {
+        QALAM_CHECK(qalam_buffer_set_cursor_offset(bench->buffer,
+                                                   buffer_bench_random(bench) % bench->length));
+    }
+    return QALAM_OK;
+}
+
+static QalamResult bench_cursor_line(void* user_data, size_t batch) {
+    BufferBench* bench = user_data;
+    size_t last_line = qalam_buffer_get_line_count(bench->buffer) - 1;
+
+    for (size_t i = 0; i < batch; i++) {
+        QalamCursor cursor;
+        QALAM_CHECK(qalam_buffer_get_cursor(bench->buffer, &cursor));
+        if (cursor.line >= last_line) {
+            QALAM_CHECK(qalam_buffer_cursor_to_start(bench->buffer));
+        }
+        QALAM_CHECK(qalam_buffer_move_cursor(bench->buffer, 1, 0));
+    }
+    return QALAM_OK;
+}
+
+static QalamResult bench_search(void* user_data, const char* pattern, bool fold) {
+    BufferBench* bench = user_data;
+    QalamSearchOptions options;
+    qalam_buffer_get_default_search_options(&options);
+    options.ignore_case = fold;
+    options.arabic_folding = fold;
+
+    QalamSearchMatch match;
+    bool found = false;
+    return qalam_buffer_find(bench->buffer, pattern, strlen(pattern), 0, &options,
+                             &match, &found);
+}
+
+static QalamResult bench_search_literal(void* user_data, size_t batch) {
+    for (size_t i = 0; i < batch; i++) {
+        QALAM_CHECK(bench_search(user_data, "values[-1]", false));
+    }
+    return QALAM_OK;
+}
+
+static QalamResult bench_search_folded(void* user_data, size_t batch) {
+    for (size_t i = 0; i < batch; i++) {
+        /* "asl" spelled with a hamza-carrying alef, folded onto bare alef */
+        QALAM_CHECK(bench_search(user_data, "\xd8\xa3\xd8\xb5\xd9\x84", true));
+    }
+    return QALAM_OK;
+}
+
+static QalamResult bench_search_all(void* user_data, size_t batch) {
+    BufferBench* bench = user_data;
+
+    for (size_t i = 0; i < batch; i++) {
+        size_t count = 0;
+        QALAM_CHECK(qalam_buffer_find_all(bench->buffer, "factor", 6, NULL, NULL, NULL,
+                                          &count));
+    }
+    return QALAM_OK;
+}
+
+/*=============================================================================
+ * Suite
+ *============================================================================*/
+
+static QalamResult buffer_bench_prepare(BufferBench* bench, size_t* out_size) {
+    DWORD length = GetTempPathW(MAX_PATH - 32, bench->open_path);
+    if (length == 0 || length >= MAX_PATH - 32) {
+        return QALAM_ERROR_FILE_ACCESS;
+    }
+    wcscpy(bench->save_path, bench->open_path);
+    wcscat(bench->open_path, L"qalam_bench_open.txt");
+    wcscat(bench->save_path, L"qalam_bench_save.txt");
+
+    size_t text_length = 0;
+    char* text = buffer_bench_generate(&text_length);
+    if (!text) {
+        return QALAM_ERROR_OUT_OF_MEMORY;
+    }
+
+    QalamBuffer* source = NULL;
+    QalamResult result = qalam_buffer_create_from_text(&source, text, text_length);
+    free(text);
+    if (result == QALAM_OK) {
+        result = qalam_buffer_save(source, bench->open_path);
+        qalam_buffer_destroy(source);
+    }
+    if (result == QALAM_OK) {
+        result = qalam_buffer_create_from_file(&bench->buffer, bench->open_path);
+    }
+
+    bench->grow_chunk = malloc(BUFFER_BENCH_GROW_CHUNK);
+    if (!bench->grow_chunk && result == QALAM_OK) {
+        result = QALAM_ERROR_OUT_OF_MEMORY;
+    }
+    if (bench->grow_chunk) {
+        for (size_t i = 0; i < BUFFER_BENCH_GROW_CHUNK; i++) {
+            bench->grow_chunk[i] = i % 64 == 63 ? '\n' : (char)('a' + i % 26);
+        }
+        bench->grow_appends = text_length / BUFFER_BENCH_GROW_CHUNK;
+    }
+
+    /* Offsets count UTF-16 units; the file ends with a line break */
+    QalamLineInfo last;
+    if (result == QALAM_OK) {
+        result = qalam_buffer_get_line_info(bench->buffer,
+                                            qalam_buffer_get_line_count(bench->buffer) - 1,
+                                            &last);
+        bench->length = last.start_offset + last.length_chars;
+    }
+
+    *out_size = text_length;
+    return result;
+}
+
+QalamResult bench_buffer_suite(BenchRun* run) {
+    QALAM_CHECK_NULL(run);
+
+    if (!bench_run_wants(run, "buffer.")) {
+        return QALAM_OK;
+    }
+
+    BufferBench bench;
+    memset(&bench, 0, sizeof(bench));
+    bench.seed = 0x9e3779b9u;
+
+    size_t size = 0;
+    QalamResult result = buffer_bench_prepare(&bench, &size);
+
+    BufferBenchEdit start = { &bench, BUFFER_BENCH_START };
+    BufferBenchEdit middle = { &bench, BUFFER_BENCH_MIDDLE };
+    BufferBenchEdit end = { &bench, BUFFER_BENCH_END };
+    BufferBenchGrow heap = { &bench, false };
+    BufferBenchGrow vm = { &bench, true };
+    size_t grown = bench.grow_appends * BUFFER_BENCH_GROW_CHUNK;
+
+    const BenchCase cases[] = {
+        { "buffer.open",            bench_open,           &bench,  1,    size },
+        { "buffer.save",            bench_save,           &bench,  1,    size },
+        { "buffer.insert.start",    bench_insert,         &start,  100,  0 },
+        { "buffer.delete.start",    bench_delete,         &start,  100,  0 },
+        { "buffer.insert.middle",   bench_insert,         &middle, 100,  0 },
+        { "buffer.delete.middle",   bench_delete,         &middle, 100,  0 },
+        { "buffer.insert.end",      bench_insert,         &end,    100,  0 },
+        { "buffer.delete.end",      bench_delete,         &end,    100,  0 },
+        { "buffer.grow.heap",       bench_grow,           &heap,   1,    grown },
+        { "buffer.grow.virtual",    bench_grow,           &vm,     1,    grown },
+        { "buffer.line_info",       bench_line_info,      &bench,  1000, 0 },
+        { "buffer.cursor.offset",   bench_cursor_offset,  &bench,  1000, 0 },
+        { "buffer.cursor.line_down", bench_cursor_line,   &bench,  1000, 0 },
+        { "buffer.search.literal",  bench_search_literal, &bench,  1,    size },
+        { "buffer.search.folded",   bench_search_folded,  &bench,  1,    size },
+        { "buffer.search.all",      bench_search_all,     &bench,  1,    size },
+    };
+
+    for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]) && result == QALAM_OK; i++) {
+        result = bench_run_case(run, &cases[i]);
+    }
+
+    qalam_buffer_destroy(bench.buffer);
+    free(bench.grow_chunk);
+    DeleteFileW(bench.open_path);
+    DeleteFileW(bench.save_path);
+    return result;
+}
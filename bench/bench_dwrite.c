@@ -0,0 +1,220 @@
+/**
+ * @file bench_dwrite.c
+ * @brief Qalam IDE - DirectWrite Benchmarks
+ *
+ * Runs on a screenful of editor lines: Arabic comments and strings
+ * between Latin code, so every layout mixes scripts and bidi levels.
+ * Each line has a distinct number in it, so the layout cache cannot
+ * answer one line with another's layout.
+ *
+ * @version 0.0.2
+ * @copyright (c) 2026 Qalam Project
+ */
+
+#include "bench.h"
+#include "dwrite_api.h"
+#include <stdlib.h>
+#include <string.h>
+#include <wchar.h>
+
+/*=============================================================================
+ * Configuration Constants
+ *============================================================================*/
+
+/** Lines laid out per repetition, about one screen */
+#define DWRITE_BENCH_LINES              64
+
+/** Longest generated line in UTF-16 units */
+#define DWRITE_BENCH_LINE_LENGTH        96
+
+/** Layout box of a line in DIPs */
+#define DWRITE_BENCH_WIDTH              4000.0f
+#define DWRITE_BENCH_HEIGHT             32.0f
+
+/** Hit tests per line and repetition */
+#define DWRITE_BENCH_HITS               16
+
+/*=============================================================================
+ * Internal Structures
+ *============================================================================*/
+
+/**
+ * @brief Data shared by the DirectWrite cases
+ */
+typedef struct DWriteBench {
+    QalamDWriteTextFormat* format;  /**< Arabic text format */
+    QalamDWriteLayoutCache* cache;  /**< Warmed layout cache */
+    QalamDWriteTextLayout* layouts[DWRITE_BENCH_LINES]; /**< Layouts for hit testing */
+    wchar_t lines[DWRITE_BENCH_LINES][DWRITE_BENCH_LINE_LENGTH]; /**< Line text */
+    uint32_t lengths[DWRITE_BENCH_LINES]; /**< Line lengths */
+    float widths[DWRITE_BENCH_LINES]; /**< Laid out line widths */
+} DWriteBench;
+
+/*=============================================================================
+ * Internal Helper Functions
+ *============================================================================*/
+
+static void dwrite_bench_generate(DWriteBench* bench) {
+    static const wchar_t* const patterns[] = {
+        L"    // حساب مجموع القيم في الجدول %d",
+        L"    print(\"مرحبا بالعالم\", count + %d);",
+        L"    total += values[%d] * factor;",
+        L"    إذا (العدد > %d) { أرجع خطأ; }",
+    };
+
+    for (int i = 0; i < DWRITE_BENCH_LINES; i++) {
+        int length = swprintf(bench->lines[i], DWRITE_BENCH_LINE_LENGTH,
+                              patterns[i % 4], i);
+        bench->lengths[i] = length > 0 ? (uint32_t)length : 0;
+    }
+}
+
+static void dwrite_bench_key(const DWriteBench* bench, uint32_t generation,
+                             QalamDWriteLayoutKey* key) {
+    memset(key, 0, sizeof(*key));
+    key->format = bench->format;
+    key->max_width = DWRITE_BENCH_WIDTH;
+    key->max_height = DWRITE_BENCH_HEIGHT;
+    key->dpi = 96.0f;
+    key->generation = generation;
+}
+
+/*=============================================================================
+ * Cases
+ *============================================================================*/
+
+static QalamResult bench_layout_create(void* user_data, size_t batch) {
+    DWriteBench* bench = user_data;
+
+    for (size_t i = 0; i < batch; i++) {
+        size_t line = i % DWRITE_BENCH_LINES;
+        QalamDWriteTextLayout* layout = NULL;
+        QALAM_CHECK(qalam_dwrite_text_layout_create(bench->lines[line], bench->lengths[line],
+                                                    bench->format, DWRITE_BENCH_WIDTH,
+                                                    DWRITE_BENCH_HEIGHT, &layout));
+        qalam_dwrite_text_layout_destroy(layout);
+    }
+    return QALAM_OK;
+}
+
+static QalamResult bench_cache_get(void* user_data, size_t batch) {
+    DWriteBench* bench = user_data;
+    QalamDWriteLayoutKey key;
+    dwrite_bench_key(bench, 0, &key);
+
+    qalam_dwrite_layout_cache_begin_frame(bench->cache);
+    for (size_t i = 0; i < batch; i++) {
+        size_t line = i % DWRITE_BENCH_LINES;
+        QalamDWriteTextLayout* layout = NULL;
+        QALAM_CHECK(qalam_dwrite_layout_cache_get(bench->cache, bench->lines[line],
+                                                  bench->lengths[line], &key, &layout));
+    }
+    return QALAM_OK;
+}
+
+static QalamResult bench_cache_find(void* user_data, size_t batch) {
+    DWriteBench* bench = user_data;
+    QalamDWriteLayoutKey key;
+    dwrite_bench_key(bench, 0, &key);
+
+    qalam_dwrite_layout_cache_begin_frame(bench->cache);
+    for (size_t i = 0; i < batch; i++) {
+        key.generation = (uint32_t)(i % DWRITE_BENCH_LINES) + 1;
+        if (!qalam_dwrite_layout_cache_find(bench->cache, &key)) {
+            return QALAM_ERROR_UNKNOWN;
+        }
+    }
+    return QALAM_OK;
+}
+
+static QalamResult bench_hit_test_point(void* user_data, size_t batch) {
+    DWriteBench* bench = user_data;
+
+    for (size_t i = 0; i < batch; i++) {
+        size_t line = (i / DWRITE_BENCH_HITS) % DWRITE_BENCH_LINES;
+        float x = bench->widths[line] * (float)(i % DWRITE_BENCH_HITS) / DWRITE_BENCH_HITS;
+        QalamDWriteHitTestResult hit;
+        QALAM_CHECK(qalam_dwrite_text_layout_hit_test_point(bench->layouts[line], x,
+                                                            DWRITE_BENCH_HEIGHT / 2, &hit));
+    }
+    return QALAM_OK;
+}
+
+static QalamResult bench_hit_test_position(void* user_data, size_t batch) {
+    DWriteBench* bench = user_data;
+
+    for (size_t i = 0; i < batch; i++) {
+        size_t line = (i / DWRITE_BENCH_HITS) % DWRITE_BENCH_LINES;
+        uint32_t position = bench->lengths[line] * (uint32_t)(i % DWRITE_BENCH_HITS) /
+                            DWRITE_BENCH_HITS;
+        float x, y;
+        QALAM_CHECK(qalam_dwrite_text_layout_hit_test_position(bench->layouts[line], position,
+                                                               false, &x, &y, NULL));
+    }
+    return QALAM_OK;
+}
+
+/*=============================================================================
+ * Suite
+ *============================================================================*/
+
+static QalamResult dwrite_bench_prepare(DWriteBench* bench) {
+    dwrite_bench_generate(bench);
+
+    QALAM_CHECK(qalam_dwrite_text_format_create_arabic(L"Segoe UI", 16.0f, &bench->format));
+    QALAM_CHECK(qalam_dwrite_layout_cache_create(0, &bench->cache));
+
+    QalamDWriteLayoutKey key;
+    for (uint32_t i = 0; i < DWRITE_BENCH_LINES; i++) {
+        QalamDWriteTextLayout* cached = NULL;
+        dwrite_bench_key(bench, i + 1, &key);
+        QALAM_CHECK(qalam_dwrite_layout_cache_get(bench->cache, bench->lines[i],
+                                                  bench->lengths[i], &key, &cached));
+
+        QALAM_CHECK(qalam_dwrite_text_layout_create(bench->lines[i], bench->lengths[i],
+                                                    bench->format, DWRITE_BENCH_WIDTH,
+                                                    DWRITE_BENCH_HEIGHT, &bench->layouts[i]));
+        QalamDWriteTextMetrics metrics;
+        QALAM_CHECK(qalam_dwrite_text_layout_get_metrics(bench->layouts[i], &metrics));
+        bench->widths[i] = metrics.width;
+    }
+    return QALAM_OK;
+}
+
+QalamResult bench_dwrite_suite(BenchRun* run) {
+    QALAM_CHECK_NULL(run);
+
+    if (!bench_run_wants(run, "dwrite.")) {
+        return QALAM_OK;
+    }
+
+    QALAM_CHECK(qalam_dwrite_init());
+
+    DWriteBench* bench = calloc(1, sizeof(DWriteBench));
+    QalamResult result = bench ? dwrite_bench_prepare(bench) : QALAM_ERROR_OUT_OF_MEMORY;
+
+    const BenchCase cases[] = {
+        { "dwrite.layout.create",        bench_layout_create,     bench, DWRITE_BENCH_LINES, 0 },
+        { "dwrite.layout_cache.get",     bench_cache_get,         bench, DWRITE_BENCH_LINES, 0 },
+        { "dwrite.layout_cache.find",    bench_cache_find,        bench, DWRITE_BENCH_LINES, 0 },
+        { "dwrite.hit_test.point",       bench_hit_test_point,    bench,
+          DWRITE_BENCH_LINES * DWRITE_BENCH_HITS, 0 },
+        { "dwrite.hit_test.position",    bench_hit_test_position, bench,
+          DWRITE_BENCH_LINES * DWRITE_BENCH_HITS, 0 },
+    };
+
+    for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]) && result == QALAM_OK; i++) {
+        result = bench_run_case(run, &cases[i]);
+    }
+
+    if (bench) {
+        for (size_t i = 0; i < DWRITE_BENCH_LINES; i++) {
+            qalam_dwrite_text_layout_destroy(bench->layouts[i]);
+        }
+        qalam_dwrite_layout_cache_destroy(bench->cache);
+        qalam_dwrite_text_format_destroy(bench->format);
+        free(bench);
+    }
+    qalam_dwrite_shutdown();
+    return result;
+}
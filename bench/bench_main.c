@@ -0,0 +1,144 @@
+/**
+ * @file bench_main.c
+ * @brief Qalam IDE - Benchmark Runner
+ *
+ * Usage: qalam_bench [options]
+ *
+ *   --filter PREFIX      Run only metrics whose name starts with PREFIX
+ *                        (e.g. "buffer." or "terminal.parse")
+ *   --repetitions N      Timed repetitions per metric (default 31)
+ *   --warmup N           Untimed repetitions per metric (default 3)
+ *   --out FILE           Write the results as JSON to FILE (default stdout)
+ *   --baseline FILE      Compare the results against an earlier --out
+ *   --threshold PERCENT  Allowed growth of a median (default 10)
+ *
+ * Progress goes to stderr. The exit code is 0 on success, 1 if any
+ * metric regressed against the baseline, and 2 on a usage error or a
+ * failed benchmark.
+ *
+ * @version 0.0.2
+ * @copyright (c) 2026 Qalam Project
+ */
+
+#include "bench.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*=============================================================================
+ * Internal Helper Functions
+ *============================================================================*/
+
+static void print_usage(void) {
+    fprintf(stderr,
+            "Usage: qalam_bench [--filter PREFIX] [--repetitions N] [--warmup N]\n"
+            "                   [--out FILE] [--baseline FILE] [--threshold PERCENT]\n");
+}
+
+static bool parse_count(const char* text, uint32_t* out_value) {
+    char* end = NULL;
+    unsigned long value = strtoul(text, &end, 10);
+    if (end == text || *end != '\0' || value > 100000) {
+        return false;
+    }
+    *out_value = (uint32_t)value;
+    return true;
+}
+
+/*=============================================================================
+ * Entry Point
+ *============================================================================*/
+
+int main(int argc, char** argv) {
+    BenchOptions options;
+    bench_get_default_options(&options);
+
+    const char* out_path = NULL;
+    const char* baseline_path = NULL;
+    double threshold = BENCH_DEFAULT_THRESHOLD;
+
+    for (int i = 1; i < argc; i++) {
+        const char* arg = argv[i];
+        const char* value = i + 1 < argc ? argv[i + 1] : NULL;
+        bool valid = value != NULL;
+
+        if (valid && strcmp(arg, "--filter") == 0) {
+            options.filter = value;
+        } else if (valid && strcmp(arg, "--repetitions") == 0) {
+            valid = parse_count(value, &options.repetitions) && options.repetitions > 0;
+        } else if (valid && strcmp(arg, "--warmup") == 0) {
+            valid = parse_count(value, &options.warmup);
+        } else if (valid && strcmp(arg, "--out") == 0) {
+            out_path = value;
+        } else if (valid && strcmp(arg, "--baseline") == 0) {
+            baseline_path = value;
+        } else if (valid && strcmp(arg, "--threshold") == 0) {
+            char* end = NULL;
+            threshold = strtod(value, &end);
+            valid = end != value && *end == '\0' && threshold >= 0.0;
+        } else {
+            valid = false;
+        }
+
+        if (!valid) {
+            print_usage();
+            return 2;
+        }
+        i++;
+    }
+
+    BenchRun* run = NULL;
+    if (bench_run_create(&run, &options) != QALAM_OK) {
+        fprintf(stderr, "qalam_bench: out of memory\n");
+        return 2;
+    }
+
+    fprintf(stderr, "Qalam benchmarks (%u repetitions, %u warmup)\n",
+            options.repetitions, options.warmup);
+
+    struct {
+        const char* name;
+        QalamResult (*run)(BenchRun* run);
+    } suites[] = {
+        { "buffer",   bench_buffer_suite },
+        { "dwrite",   bench_dwrite_suite },
+        { "terminal", bench_terminal_suite },
+        { "startup",  bench_startup_suite },
+    };
+
+    int exit_code = 0;
+    for (size_t i = 0; i < sizeof(suites) / sizeof(suites[0]); i++) {
+        QalamResult result = suites[i].run(run);
+        if (result != QALAM_OK) {
+            fprintf(stderr, "qalam_bench: %s suite failed (%d)\n", suites[i].name, (int)result);
+            exit_code = 2;
+        }
+    }
+
+    FILE* out = out_path ? fopen(out_path, "w") : stdout;
+    if (!out || bench_run_write_json(run, out) != QALAM_OK) {
+        fprintf(stderr, "qalam_bench: cannot write %s\n", out_path ? out_path : "results");
+        exit_code = 2;
+    }
+    if (out && out != stdout) {
+        fclose(out);
+    }
+
+    if (baseline_path && exit_code == 0) {
+        size_t regressions = 0;
+        QalamResult result = bench_run_compare(run, baseline_path, threshold, stderr,
+                                               &regressions);
+        if (result != QALAM_OK) {
+            fprintf(stderr, "qalam_bench: cannot read baseline %s (%d)\n", baseline_path,
+                    (int)result);
+            exit_code = 2;
+        } else if (regressions) {
+            fprintf(stderr, "qalam_bench: %zu metric(s) regressed by more than %.1f%%\n",
+                    regressions, threshold);
+            exit_code = 1;
+        }
+    }
+
+    bench_run_destroy(run);
+    return exit_code;
+}
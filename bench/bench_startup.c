@@ -0,0 +1,303 @@
+/**
+ * @file bench_startup.c
+ * @brief Qalam IDE - Startup Benchmarks
+ *
+ * Brings the editor up the way run_application() does: DirectWrite, the
+ * font preload on its worker, a hidden window and its first cleared
+ * frame, a file of about 1 MB opened with background loading, and a
+ * first frame of text once the fonts are ready. Each metric is the time
+ * from the start of a bring-up to one startup phase.
+ *
+ * Every repetition brings everything up and tears it down again in this
+ * process, so after the first one the system font collection and the
+ * family cache are warm. For a cold start, run a fresh process with
+ * "--filter startup. --warmup 0 --repetitions 1".
+ *
+ * @version 0.0.2
+ * @copyright (c) 2026 Qalam Project
+ */
+
+#include "bench.h"
+#include "editor.h"
+#include "dwrite_api.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <wchar.h>
+
+/*=============================================================================
+ * Configuration Constants
+ *============================================================================*/
+
+/** Lines in the generated file */
+#define STARTUP_BENCH_LINES             20000
+
+/** Lines the first frame of text draws, about one screen */
+#define STARTUP_BENCH_SCREEN_LINES      40
+
+/** Size of the hidden window */
+#define STARTUP_BENCH_WIDTH             1280
+#define STARTUP_BENCH_HEIGHT            960
+
+/** Height of one line in DIPs */
+#define STARTUP_BENCH_LINE_HEIGHT       24.0f
+
+/** Window class of the hidden window */
+#define STARTUP_BENCH_CLASS             L"QalamBenchStartup"
+
+/*=============================================================================
+ * Internal Structures
+ *============================================================================*/
+
+/**
+ * @brief Data shared by the repetitions
+ */
+typedef struct StartupBench {
+    wchar_t file_path[MAX_PATH];    /**< Generated file */
+    wchar_t cache_path[MAX_PATH];   /**< Font family cache */
+    HINSTANCE instance;             /**< Module that owns the window class */
+    bool class_registered;          /**< Whether the window class is registered */
+    double* samples;                /**< Per phase, one sample per timed repetition */
+} StartupBench;
+
+/**
+ * @brief What one bring-up created
+ */
+typedef struct StartupBenchApp {
+    QalamDWriteFontPreload* preload;
+    HWND window;
+    QalamDWriteRenderTarget* target;
+    QalamBuffer* buffer;
+    QalamDWriteTextFormat* format;
+    QalamDWriteLayoutCache* cache;
+    QalamDWriteBrush* brush;
+} StartupBenchApp;
+
+/*=============================================================================
+ * Internal Helper Functions
+ *============================================================================*/
+
+static char* startup_bench_generate(size_t* out_length) {
+    size_t capacity = (size_t)STARTUP_BENCH_LINES * 96;
+    char* text = malloc(capacity);
+    if (!text) {
+        return NULL;
+    }
+
+    size_t length = 0;
+    for (size_t i = 0; i < STARTUP_BENCH_LINES; i++) {
+        int written;
+        if (i % 4 == 3) {
+            written = snprintf(text + length, capacity - length,
+                               "    // \xd8\xad\xd8\xb3\xd8\xa7\xd8\xa8 "
+                               "\xd8\xa7\xd9\x84\xd9\x82\xd9\x8a\xd9\x85\xd8\xa9 "
+                               "\xd8\xb1\xd9\x82\xd9\x85 %zu\n", i);
+        } else {
+            written = snprintf(text + length, capacity - length,
+                               "    total += values[%zu] * factor; /* step %zu */\n",
+                               i, i % 7);
+        }
+        length += (size_t)written;
+    }
+
+    *out_length = length;
+    return text;
+}
+
+static QalamResult startup_bench_prepare(StartupBench* bench) {
+    DWORD length = GetTempPathW(MAX_PATH - 32, bench->file_path);
+    if (length == 0 || length >= MAX_PATH - 32) {
+        return QALAM_ERROR_FILE_ACCESS;
+    }
+    wcscpy(bench->cache_path, bench->file_path);
+    wcscat(bench->file_path, L"qalam_bench_startup.txt");
+    wcscat(bench->cache_path, L"qalam_bench_fonts.cache");
+
+    size_t text_length = 0;
+    char* text = startup_bench_generate(&text_length);
+    if (!text) {
+        return QALAM_ERROR_OUT_OF_MEMORY;
+    }
+
+    QalamBuffer* source = NULL;
+    QalamResult result = qalam_buffer_create_from_text(&source, text, text_length);
+    free(text);
+    if (result == QALAM_OK) {
+        result = qalam_buffer_save(source, bench->file_path);
+        qalam_buffer_destroy(source);
+    }
+    if (result != QALAM_OK) {
+        return result;
+    }
+
+    WNDCLASSEXW window_class;
+    memset(&window_class, 0, sizeof(window_class));
+    window_class.cbSize = sizeof(window_class);
+    window_class.lpfnWndProc = DefWindowProcW;
+    window_class.hInstance = bench->instance;
+    window_class.lpszClassName = STARTUP_BENCH_CLASS;
+    if (!RegisterClassExW(&window_class)) {
+        return QALAM_ERROR_WINDOW_REGISTER;
+    }
+    bench->class_registered = true;
+    return QALAM_OK;
+}
+
+/**
+ * @brief Draw the first screen of the buffer, as the first editor frame does
+ */
+static QalamResult startup_bench_draw_text(StartupBenchApp* app) {
+    QalamDWriteLayoutKey key;
+    memset(&key, 0, sizeof(key));
+    key.format = app->format;
+    key.max_width = (float)STARTUP_BENCH_WIDTH;
+    key.max_height = STARTUP_BENCH_LINE_HEIGHT;
+    key.dpi = 96.0f;
+
+    size_t lines = qalam_buffer_get_line_count(app->buffer);
+    if (lines > STARTUP_BENCH_SCREEN_LINES) {
+        lines = STARTUP_BENCH_SCREEN_LINES;
+    }
+
+    qalam_dwrite_layout_cache_begin_frame(app->cache);
+    qalam_dwrite_render_begin(app->target);
+    qalam_dwrite_render_clear(app->target, QALAM_DWRITE_COLOR_BLACK);
+
+    QalamResult result = QALAM_OK;
+    for (size_t i = 0; i < lines && result == QALAM_OK; i++) {
+        QalamTextView view;
+        result = qalam_buffer_get_line_view(app->buffer, i, true, &view);
+        if (result != QALAM_OK || view.length == 0) {
+            continue;
+        }
+
+        QalamDWriteTextLayout* layout = NULL;
+        key.generation = qalam_buffer_get_line_generation(app->buffer, i);
+        result = qalam_dwrite_layout_cache_get(app->cache, view.segments[0],
+                                               (uint32_t)view.length, &key, &layout);
+        if (result == QALAM_OK) {
+            qalam_dwrite_render_draw_text(app->target, layout, 0.0f,
+                                          (float)i * STARTUP_BENCH_LINE_HEIGHT, app->brush);
+        }
+    }
+
+    QalamResult end_result = qalam_dwrite_render_end(app->target);
+    return result != QALAM_OK ? result : end_result;
+}
+
+/**
+ * @brief Bring the editor up, recording each startup phase as it is reached
+ */
+static QalamResult startup_bench_bring_up(StartupBench* bench, StartupBenchApp* app) {
+    qalam_trace_startup_reset();
+    qalam_trace_startup_mark(QALAM_STARTUP_BEGIN);
+
+    QALAM_CHECK(qalam_dwrite_init());
+
+    QalamDWriteFontPreloadOptions font_options;
+    qalam_dwrite_font_preload_get_default_options(&font_options);
+    font_options.cache_path = bench->cache_path;
+    QALAM_CHECK(qalam_dwrite_font_preload_start(&font_options, &app->preload));
+
+    app->window = CreateWindowExW(0, STARTUP_BENCH_CLASS, L"Qalam", WS_OVERLAPPEDWINDOW,
+                                  0, 0, STARTUP_BENCH_WIDTH, STARTUP_BENCH_HEIGHT,
+                                  NULL, NULL, bench->instance, NULL);
+    if (!app->window) {
+        return QALAM_ERROR_WINDOW_CREATE;
+    }
+    qalam_trace_startup_mark(QALAM_STARTUP_WINDOW);
+
+    QALAM_CHECK(qalam_dwrite_render_target_create(app->window, &app->target));
+    qalam_dwrite_render_begin(app->target);
+    qalam_dwrite_render_clear(app->target, QALAM_DWRITE_COLOR_BLACK);
+    QALAM_CHECK(qalam_dwrite_render_end(app->target));
+    qalam_trace_startup_mark(QALAM_STARTUP_FIRST_PAINT);
+
+    QalamBufferOptions buffer_options;
+    qalam_buffer_get_default_options(&buffer_options);
+    buffer_options.background_load = true;
+    QALAM_CHECK(qalam_buffer_create_from_file_with_options(&app->buffer, bench->file_path,
+                                                           &buffer_options));
+    qalam_trace_startup_mark(QALAM_STARTUP_FILE_LOADED);
+
+    QALAM_CHECK(qalam_dwrite_font_preload_wait(app->preload, &app->format));
+    QALAM_CHECK(qalam_dwrite_layout_cache_create(0, &app->cache));
+    QALAM_CHECK(qalam_dwrite_brush_create_solid(app->target, QALAM_DWRITE_COLOR_WHITE,
+                                                &app->brush));
+    QALAM_CHECK(startup_bench_draw_text(app));
+    qalam_trace_startup_mark(QALAM_STARTUP_FIRST_TEXT);
+    return QALAM_OK;
+}
+
+static void startup_bench_tear_down(StartupBenchApp* app) {
+    qalam_dwrite_brush_destroy(app->brush);
+    qalam_dwrite_layout_cache_destroy(app->cache);
+    qalam_dwrite_text_format_destroy(app->format);
+    qalam_dwrite_font_preload_destroy(app->preload);
+    qalam_buffer_destroy(app->buffer);
+    qalam_dwrite_render_target_destroy(app->target);
+    if (app->window) {
+        DestroyWindow(app->window);
+    }
+    qalam_dwrite_shutdown();
+    memset(app, 0, sizeof(StartupBenchApp));
+}
+
+/*=============================================================================
+ * Suite
+ *============================================================================*/
+
+QalamResult bench_startup_suite(BenchRun* run) {
+    QALAM_CHECK_NULL(run);
+
+    if (!bench_run_wants(run, "startup.")) {
+        return QALAM_OK;
+    }
+
+    const BenchOptions* options = bench_run_get_options(run);
+    uint32_t repetitions = options->repetitions;
+    uint32_t total = options->warmup + repetitions;
+
+    StartupBench bench;
+    memset(&bench, 0, sizeof(bench));
+    bench.instance = GetModuleHandleW(NULL);
+    bench.samples = malloc((size_t)QALAM_STARTUP_PHASE_COUNT * repetitions * sizeof(double));
+
+    QalamResult result = bench.samples ? startup_bench_prepare(&bench)
+                                       : QALAM_ERROR_OUT_OF_MEMORY;
+
+    for (uint32_t i = 0; i < total && result == QALAM_OK; i++) {
+        StartupBenchApp app;
+        memset(&app, 0, sizeof(app));
+        result = startup_bench_bring_up(&bench, &app);
+
+        QalamStartupTimings timings;
+        qalam_trace_get_startup(&timings);
+        startup_bench_tear_down(&app);
+
+        if (result == QALAM_OK && i >= options->warmup) {
+            for (uint32_t phase = 0; phase < QALAM_STARTUP_PHASE_COUNT; phase++) {
+                bench.samples[(size_t)phase * repetitions + (i - options->warmup)] =
+                    (double)timings.phase_ns[phase];
+            }
+        }
+    }
+
+    /* BEGIN is the origin of every sample, so it gets no metric */
+    for (uint32_t phase = QALAM_STARTUP_BEGIN + 1;
+         phase < QALAM_STARTUP_PHASE_COUNT && result == QALAM_OK; phase++) {
+        char name[64];
+        snprintf(name, sizeof(name), "startup.%s",
+                 qalam_trace_startup_phase_name((QalamStartupPhase)phase));
+        result = bench_run_add_samples(run, name, &bench.samples[(size_t)phase * repetitions],
+                                       repetitions);
+    }
+
+    if (bench.class_registered) {
+        UnregisterClassW(STARTUP_BENCH_CLASS, bench.instance);
+    }
+    free(bench.samples);
+    DeleteFileW(bench.file_path);
+    DeleteFileW(bench.cache_path);
+    return result;
+}
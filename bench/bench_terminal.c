@@ -0,0 +1,246 @@
+/**
+ * @file bench_terminal.c
+ * @brief Qalam IDE - Terminal Benchmarks
+ *
+ * Measures how fast pseudoconsole output is consumed, on three kinds of
+ * generated output of about 1 MB each: a plain build log with Arabic
+ * messages, a colored listing with a style change every few words, and
+ * a progress display that rewrites one line with carriage returns and
+ * erases. The parser cases use handlers that do nothing, so they time
+ * the parser alone; the screen case applies the mixed output to a
+ * 120x40 screen with scrollback.
+ *
+ * @version 0.0.2
+ * @copyright (c) 2026 Qalam Project
+ */
+
+#include "bench.h"
+#include "vt_parser.h"
+#include "terminal_screen.h"
+#include <stdlib.h>
+#include <string.h>
+
+/*=============================================================================
+ * Configuration Constants
+ *============================================================================*/
+
+/** Bytes of each generated output */
+#define TERMINAL_BENCH_BYTES            (1024 * 1024)
+
+/** Screen the screen case writes to */
+#define TERMINAL_BENCH_COLUMNS          120
+#define TERMINAL_BENCH_ROWS             40
+
+/*=============================================================================
+ * Internal Structures
+ *============================================================================*/
+
+/**
+ * @brief Generated output
+ */
+typedef struct TerminalBenchStream {
+    char* data;                     /**< Output bytes */
+    size_t length;                  /**< Bytes in 'data' */
+} TerminalBenchStream;
+
+/**
+ * @brief Data shared by the terminal cases
+ */
+typedef struct TerminalBench {
+    VtParser* parser;               /**< Parser with do-nothing handlers */
+    TerminalScreen* screen;         /**< Screen for the screen case */
+    TerminalBenchStream text;       /**< Build log */
+    TerminalBenchStream styled;     /**< Colored listing */
+    TerminalBenchStream progress;   /**< Progress display */
+    TerminalBenchStream mixed;      /**< All three interleaved */
+    size_t calls;                   /**< Handler calls, so they are not elided */
+} TerminalBench;
+
+/**
+ * @brief A case over one stream
+ */
+typedef struct TerminalBenchCase {
+    TerminalBench* bench;           /**< Shared data */
+    const TerminalBenchStream* stream; /**< Output to consume */
+} TerminalBenchCase;
+
+/*=============================================================================
+ * Internal Helper Functions
+ *============================================================================*/
+
+static void terminal_bench_print(void* user_data, const char* text, size_t length) {
+    (void)text;
+    ((TerminalBench*)user_data)->calls += length;
+}
+
+static void terminal_bench_execute(void* user_data, unsigned char control) {
+    (void)control;
+    ((TerminalBench*)user_data)->calls++;
+}
+
+static void terminal_bench_sequence(void* user_data, const VtSequence* sequence) {
+    (void)sequence;
+    ((TerminalBench*)user_data)->calls++;
+}
+
+static void terminal_bench_string(void* user_data, const char* data, size_t length) {
+    (void)data;
+    ((TerminalBench*)user_data)->calls += length;
+}
+
+static void terminal_bench_unhook(void* user_data) {
+    ((TerminalBench*)user_data)->calls++;
+}
+
+typedef int (*TerminalBenchLine)(char* out, size_t size, size_t index);
+
+static int terminal_bench_text_line(char* out, size_t size, size_t index) {
+    if (index % 3 == 2) {
+        return snprintf(out, size, "src/core/buffer.c:%zu: \xd8\xaa\xd8\xad\xd8\xb0\xd9\x8a\xd8\xb1: "
+                        "\xd9\x85\xd8\xaa\xd8\xba\xd9\x8a\xd8\xb1 \xd8\xba\xd9\x8a\xd8\xb1 "
+                        "\xd9\x85\xd8\xb3\xd8\xaa\xd8\xae\xd8\xaf\xd9\x85\r\n", index);
+    }
+    return snprintf(out, size, "[%3zu%%] Building C object CMakeFiles/qalam.dir/src/core/"
+                    "file_%zu.c.obj\r\n", index % 101, index);
+}
+
+static int terminal_bench_styled_line(char* out, size_t size, size_t index) {
+    return snprintf(out, size, "\x1b[1;34mdir_%zu\x1b[0m  \x1b[32mbuild.sh\x1b[0m  "
+                    "\x1b[38;2;255;%zu;0mnotes_%zu.txt\x1b[0m  \x1b[4mREADME\x1b[24m  "
+                    "\x1b[7m\xd9\x85\xd9\x84\xd9\x81\x1b[27m\r\n",
+                    index, index % 256, index);
+}
+
+static int terminal_bench_progress_line(char* out, size_t size, size_t index) {
+    return snprintf(out, size, "\r\x1b[K\x1b[32m%3zu%%\x1b[0m [%.*s%*s] %zu/10000\x1b[?25l",
+                    index % 101, (int)(index % 41), "========================================",
+                    (int)(40 - index % 41), "", index);
+}
+
+static QalamResult terminal_bench_generate(TerminalBenchStream* stream, TerminalBenchLine line) {
+    stream->data = malloc(TERMINAL_BENCH_BYTES + 512);
+    if (!stream->data) {
+        return QALAM_ERROR_OUT_OF_MEMORY;
+    }
+
+    stream->length = 0;
+    for (size_t i = 0; stream->length < TERMINAL_BENCH_BYTES; i++) {
+        int written = line(stream->data + stream->length, 512, i);
+        stream->length += written > 0 ? (size_t)written : 0;
+    }
+    return QALAM_OK;
+}
+
+static QalamResult terminal_bench_interleave(TerminalBench* bench) {
+    TerminalBenchStream* mixed = &bench->mixed;
+    const TerminalBenchStream* parts[] = { &bench->text, &bench->styled, &bench->progress };
+
+    mixed->data = malloc(TERMINAL_BENCH_BYTES + 512);
+    if (!mixed->data) {
+        return QALAM_ERROR_OUT_OF_MEMORY;
+    }
+
+    /* Whole lines of each part in turn, so no sequence is cut */
+    size_t offsets[3] = { 0, 0, 0 };
+    mixed->length = 0;
+    for (size_t i = 0; mixed->length < TERMINAL_BENCH_BYTES; i++) {
+        const TerminalBenchStream* part = parts[i % 3];
+        size_t* offset = &offsets[i % 3];
+        const char* start = part->data + *offset;
+        const char* end = memchr(start, (i % 3) == 2 ? 'l' : '\n', part->length - *offset);
+        size_t length = end ? (size_t)(end - start) + 1 : part->length - *offset;
+        if (length > TERMINAL_BENCH_BYTES + 512 - mixed->length) {
+            break;
+        }
+
+        memcpy(mixed->data + mixed->length, start, length);
+        mixed->length += length;
+        *offset = end ? *offset + length : 0;
+    }
+    return QALAM_OK;
+}
+
+/*=============================================================================
+ * Cases
+ *============================================================================*/
+
+static QalamResult bench_parse(void* user_data, size_t batch) {
+    TerminalBenchCase* bench_case = user_data;
+
+    for (size_t i = 0; i < batch; i++) {
+        vt_parser_parse(bench_case->bench->parser, bench_case->stream->data,
+                        bench_case->stream->length);
+    }
+    return QALAM_OK;
+}
+
+static QalamResult bench_screen_write(void* user_data, size_t batch) {
+    TerminalBenchCase* bench_case = user_data;
+
+    for (size_t i = 0; i < batch; i++) {
+        QALAM_CHECK(terminal_screen_write(bench_case->bench->screen, bench_case->stream->data,
+                                          bench_case->stream->length));
+    }
+    return QALAM_OK;
+}
+
+/*=============================================================================
+ * Suite
+ *============================================================================*/
+
+static QalamResult terminal_bench_prepare(TerminalBench* bench) {
+    static const VtParserHandler handler = {
+        terminal_bench_print,
+        terminal_bench_execute,
+        terminal_bench_sequence,
+        terminal_bench_sequence,
+        terminal_bench_string,
+        terminal_bench_sequence,
+        terminal_bench_string,
+        terminal_bench_unhook,
+    };
+
+    QALAM_CHECK(vt_parser_create(&bench->parser, &handler, bench));
+    QALAM_CHECK(terminal_screen_create(&bench->screen, TERMINAL_BENCH_COLUMNS,
+                                       TERMINAL_BENCH_ROWS, 0));
+    QALAM_CHECK(terminal_bench_generate(&bench->text, terminal_bench_text_line));
+    QALAM_CHECK(terminal_bench_generate(&bench->styled, terminal_bench_styled_line));
+    QALAM_CHECK(terminal_bench_generate(&bench->progress, terminal_bench_progress_line));
+    return terminal_bench_interleave(bench);
+}
+
+QalamResult bench_terminal_suite(BenchRun* run) {
+    QALAM_CHECK_NULL(run);
+
+    if (!bench_run_wants(run, "terminal.")) {
+        return QALAM_OK;
+    }
+
+    TerminalBench bench;
+    memset(&bench, 0, sizeof(bench));
+    QalamResult result = terminal_bench_prepare(&bench);
+
+    TerminalBenchCase text = { &bench, &bench.text };
+    TerminalBenchCase styled = { &bench, &bench.styled };
+    TerminalBenchCase progress = { &bench, &bench.progress };
+    TerminalBenchCase mixed = { &bench, &bench.mixed };
+
+    const BenchCase cases[] = {
+        { "terminal.parse.text",     bench_parse,        &text,     1, bench.text.length },
+        { "terminal.parse.styled",   bench_parse,        &styled,   1, bench.styled.length },
+        { "terminal.parse.progress", bench_parse,        &progress, 1, bench.progress.length },
+        { "terminal.screen.write",   bench_screen_write, &mixed,    1, bench.mixed.length },
+    };
+
+    for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]) && result == QALAM_OK; i++) {
+        result = bench_run_case(run, &cases[i]);
+    }
+
+    vt_parser_destroy(bench.parser);
+    terminal_screen_destroy(bench.screen);
+    free(bench.text.data);
+    free(bench.styled.data);
+    free(bench.progress.data);
+    free(bench.mixed.data);
+    return result;
+}
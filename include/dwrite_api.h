@@ -42,7 +42,8 @@ typedef struct QalamDWriteTextLayout QalamDWriteTextLayout;
 /**
  * @brief Opaque handle to D2D render target
  * 
- * Wraps ID2D1HwndRenderTarget for window-based rendering.
+ * Wraps an ID2D1DeviceContext drawing into a flip-model DXGI swap chain
+ * (or an ID2D1HwndRenderTarget where D3D11 is unavailable).
  */
 typedef struct QalamDWriteRenderTarget QalamDWriteRenderTarget;
 
@@ -53,6 +54,29 @@ typedef struct QalamDWriteRenderTarget QalamDWriteRenderTarget;
  */
 typedef struct QalamDWriteBrush QalamDWriteBrush;
 
+/**
+ * @brief Opaque handle to a text layout cache
+ * 
+ * Owns shaped layouts and hands them out again for the same text,
+ * format and layout box.
+ */
+typedef struct QalamDWriteLayoutCache QalamDWriteLayoutCache;
+
+/**
+ * @brief Opaque handle to a glyph atlas
+ * 
+ * Holds rasterized glyphs of one font for drawing a grid of cells.
+ */
+typedef struct QalamDWriteGlyphAtlas QalamDWriteGlyphAtlas;
+
+/**
+ * @brief Opaque handle to a font preload
+ * 
+ * Loads the system fonts and creates the editor's text format on a
+ * worker thread while the window comes up.
+ */
+typedef struct QalamDWriteFontPreload QalamDWriteFontPreload;
+
 /* ============================================================================
  * Text Metrics (C-compatible structure)
  * ============================================================================ */
@@ -160,6 +184,10 @@ typedef struct QalamDWriteColor {
  * Must be called once at application startup before any other
  * DirectWrite functions.
  * 
+ * The system font collection and text analyzer are not loaded here but
+ * on first use (usually by a font preload), so a window can show its
+ * first frame before the installed fonts have been enumerated.
+ * 
  * Thread-safe: Uses reference counting for multiple init calls.
  * 
  * @return QALAM_OK on success, error code on failure
@@ -210,6 +238,12 @@ QalamResult qalam_dwrite_text_format_create(
  * - Arabic locale for proper shaping
  * - Appropriate text alignment
  * 
+ * If font_family is not installed or has no Arabic letters, the format
+ * uses the first installed family of Segoe UI, Tahoma, Arial, Courier
+ * New, Simplified Arabic and Traditional Arabic that has them, so that
+ * lines can be shaped with a single face. The choice is made once per
+ * family and process (and kept between runs by a font preload's cache).
+ * 
  * @param font_family Font family name
  * @param font_size Font size in DIPs
  * @param out_format Pointer to receive the created format handle
@@ -228,6 +262,114 @@ QalamResult qalam_dwrite_text_format_create_arabic(
  */
 void qalam_dwrite_text_format_destroy(QalamDWriteTextFormat* format);
 
+/**
+ * @brief Check whether a text format reads right to left
+ * 
+ * @param format Text format
+ * @return true for a right-to-left format, false otherwise or for NULL
+ */
+bool qalam_dwrite_text_format_is_rtl(const QalamDWriteTextFormat* format);
+
+/**
+ * @brief Get the font family a text format was created with
+ * 
+ * @param format Text format
+ * @param out_name Buffer to receive the null-terminated family name
+ * @param capacity Size of out_name in characters
+ * @return QALAM_OK on success, QALAM_ERROR_INVALID_ARGUMENT if the name
+ *         does not fit, error code on failure
+ */
+QalamResult qalam_dwrite_text_format_get_family_name(
+    const QalamDWriteTextFormat* format,
+    wchar_t* out_name,
+    uint32_t capacity
+);
+
+/* ============================================================================
+ * Font Preloading
+ * ============================================================================ */
+
+/**
+ * @brief Called on the preload's worker thread once its format is ready
+ * 
+ * Keep it short: set an event the UI thread waits on, or post a message.
+ */
+typedef void (*QalamDWriteFontReadyCallback)(void* user_data);
+
+/**
+ * @brief Font preload options
+ */
+typedef struct QalamDWriteFontPreloadOptions {
+    const wchar_t* family;              /**< Editor font family (default "Segoe UI") */
+    float size;                         /**< Font size in DIPs (default 16) */
+    const wchar_t* cache_path;          /**< File keeping Arabic family choices between runs,
+                                             or NULL (default) */
+    QalamDWriteFontReadyCallback ready; /**< Called when the format is ready, or NULL */
+    void* user_data;                    /**< Passed to ready */
+} QalamDWriteFontPreloadOptions;
+
+/**
+ * @brief Get default font preload options
+ * 
+ * @param options Options to fill
+ */
+void qalam_dwrite_font_preload_get_default_options(QalamDWriteFontPreloadOptions* options);
+
+/**
+ * @brief Start loading fonts and creating the editor format on a worker thread
+ * 
+ * The worker loads the system font collection and text analyzer,
+ * creates an Arabic text format with
+ * qalam_dwrite_text_format_create_arabic() and resolves the face its
+ * lines are shaped with, then marks QALAM_STARTUP_FONTS_READY. With a
+ * cache_path, family choices made by earlier runs are read from the
+ * file instead of probing the installed fonts; the file is discarded
+ * when fonts have been installed or removed since, and rewritten when a
+ * choice changes.
+ * 
+ * DirectWrite must stay initialized until the preload is destroyed.
+ * 
+ * @param options Preload options (NULL for defaults)
+ * @param out_preload Pointer to receive the preload handle
+ * @return QALAM_OK on success, error code on failure
+ */
+QalamResult qalam_dwrite_font_preload_start(
+    const QalamDWriteFontPreloadOptions* options,
+    QalamDWriteFontPreload** out_preload
+);
+
+/**
+ * @brief Check whether a preload has finished, without blocking
+ * 
+ * @param preload Font preload
+ * @return true once qalam_dwrite_font_preload_wait() would not block
+ */
+bool qalam_dwrite_font_preload_is_ready(const QalamDWriteFontPreload* preload);
+
+/**
+ * @brief Wait for a preload to finish and take its text format
+ * 
+ * The format is handed over once; the caller destroys it with
+ * qalam_dwrite_text_format_destroy(). Later calls give NULL.
+ * 
+ * @param preload Font preload
+ * @param out_format Pointer to receive the text format
+ * @return QALAM_OK on success, or the error creating the format
+ */
+QalamResult qalam_dwrite_font_preload_wait(
+    QalamDWriteFontPreload* preload,
+    QalamDWriteTextFormat** out_format
+);
+
+/**
+ * @brief Wait for a preload to finish and destroy it
+ * 
+ * Destroys its text format too unless it was taken.
+ * 
+ * @param preload Font preload (may be NULL)
+ */
+void qalam_dwrite_font_preload_destroy(QalamDWriteFontPreload* preload);
+
 /* ============================================================================
  * Text Layout Management
  * ============================================================================ */
@@ -316,6 +458,294 @@ QalamResult qalam_dwrite_text_layout_hit_test_position(
     QalamDWriteHitTestResult* out_result
 );
 
+/* ============================================================================
+ * Caret Navigation
+ * ============================================================================ */
+
+/**
+ * @brief A place the caret can stand: a cluster boundary
+ */
+typedef struct QalamDWriteCaretStop {
+    uint32_t text_position;     /**< Text position of the boundary */
+    float x;                    /**< Caret x in DIPs, in layout coordinates */
+} QalamDWriteCaretStop;
+
+/**
+ * @brief A horizontal span of a layout, e.g. part of a selection
+ */
+typedef struct QalamDWriteSpan {
+    float left;                 /**< Left edge in DIPs, in layout coordinates */
+    float right;                /**< Right edge in DIPs, in layout coordinates */
+} QalamDWriteSpan;
+
+/**
+ * @brief Get a layout's caret stops
+ * 
+ * The table is built on first use and kept with the layout (for a
+ * cached layout, as long as the cache holds it). Layouts shaped by a
+ * layout cache build it from their glyph runs without calling into
+ * DirectWrite; other layouts hit test each cluster once. The caret
+ * functions below are binary searches over this table.
+ * 
+ * Logical stops are in text order, one per cluster start plus one at
+ * the end of the text, each at the leading edge of its cluster. Visual
+ * stops are the cluster edges from left to right, each paired with the
+ * text position whose caret stands there.
+ * 
+ * @param layout Single-line text layout
+ * @param out_logical Receives the logical stops (optional)
+ * @param out_visual Receives the visual stops (optional)
+ * @param out_count Receives the number of stops in each array
+ * @return QALAM_OK on success, QALAM_ERROR_INVALID_ARGUMENT if the
+ *         layout wraps onto more than one line, error code on failure
+ */
+QalamResult qalam_dwrite_text_layout_get_caret_stops(
+    QalamDWriteTextLayout* layout,
+    const QalamDWriteCaretStop** out_logical,
+    const QalamDWriteCaretStop** out_visual,
+    uint32_t* out_count
+);
+
+/**
+ * @brief Get the caret x for a text position
+ * 
+ * @param layout Single-line text layout
+ * @param text_position Text position (inside a cluster it snaps to the
+ *        cluster's start; past the end, to the end)
+ * @param out_x Receives the caret x in layout coordinates
+ * @return QALAM_OK on success, error code on failure
+ */
+QalamResult qalam_dwrite_text_layout_caret_x(
+    QalamDWriteTextLayout* layout,
+    uint32_t text_position,
+    float* out_x
+);
+
+/**
+ * @brief Move the caret one stop left or right on screen
+ * 
+ * Moves in visual order, so in mixed right-to-left and left-to-right
+ * text the caret follows the arrow key's direction.
+ * 
+ * @param layout Single-line text layout
+ * @param text_position Current text position
+ * @param direction Negative to move left, positive to move right
+ * @param out_position Receives the new text position; equal to the
+ *        current one at the edge of the line
+ * @return QALAM_OK on success, error code on failure
+ */
+QalamResult qalam_dwrite_text_layout_caret_move(
+    QalamDWriteTextLayout* layout,
+    uint32_t text_position,
+    int direction,
+    uint32_t* out_position
+);
+
+/**
+ * @brief Get the text position of the caret stop nearest to an x
+ * 
+ * @param layout Single-line text layout
+ * @param x Position in layout coordinates (e.g. a mouse click)
+ * @param out_position Receives the text position
+ * @return QALAM_OK on success, error code on failure
+ */
+QalamResult qalam_dwrite_text_layout_caret_at(
+    QalamDWriteTextLayout* layout,
+    float x,
+    uint32_t* out_position
+);
+
+/**
+ * @brief Get the spans covered by a text range, left to right
+ * 
+ * A range in bidi text can cover several separate spans on screen.
+ * Clusters touched by the range are covered whole.
+ * 
+ * @param layout Single-line text layout
+ * @param start First text position of the range
+ * @param end Text position after the range
+ * @param spans Array to receive the spans (may be NULL to count them)
+ * @param max_spans Entries available in 'spans'
+ * @param out_count Receives the number of spans, including any that
+ *        did not fit
+ * @return QALAM_OK on success, error code on failure
+ */
+QalamResult qalam_dwrite_text_layout_get_range_spans(
+    QalamDWriteTextLayout* layout,
+    uint32_t start,
+    uint32_t end,
+    QalamDWriteSpan* spans,
+    uint32_t max_spans,
+    uint32_t* out_count
+);
+
+/**
+ * @brief Set the style ranges a layout is drawn with
+ *
+ * Each range is drawn with brushes[range.style]; text outside the ranges,
+ * and styles without a brush, use the brush passed to the draw call.
+ * Styles only change brushes: the layout is not reshaped, and setting
+ * the ranges it already has costs a comparison. Layouts shared between
+ * lines with the same text take the styles of whichever line set them
+ * last, so set them right before each draw.
+ *
+ * @param layout Text layout
+ * @param ranges Ranges ordered by start, not overlapping (may be NULL
+ *        when range_count is 0, to draw with the default brush only)
+ * @param range_count Number of ranges
+ * @param brushes Brush of each style, or NULL entries (copied; the
+ *        brushes themselves must outlive the layout's use of them)
+ * @param brush_count Entries in 'brushes'
+ * @return QALAM_OK on success, error code on failure
+ */
+QalamResult qalam_dwrite_text_layout_set_styles(
+    QalamDWriteTextLayout* layout,
+    const QalamStyleRange* ranges,
+    uint32_t range_count,
+    QalamDWriteBrush* const* brushes,
+    uint32_t brush_count
+);
+
+/* ============================================================================
+ * Text Layout Cache
+ * ============================================================================ */
+
+/** Default byte budget of a layout cache */
+#define QALAM_DWRITE_LAYOUT_CACHE_DEFAULT_BUDGET  (16 * 1024 * 1024)
+
+/**
+ * @brief Everything besides the text that a cached layout depends on
+ */
+typedef struct QalamDWriteLayoutKey {
+    QalamDWriteTextFormat* format;  /**< Text format the layout uses */
+    float max_width;                /**< Maximum layout width in DIPs */
+    float max_height;               /**< Maximum layout height in DIPs */
+    float dpi;                      /**< DPI the layout is drawn at */
+    uint32_t generation;            /**< Change generation of the text (e.g.
+                                         qalam_buffer_get_line_generation()), or 0 */
+} QalamDWriteLayoutKey;
+
+/**
+ * @brief Layout cache statistics
+ */
+typedef struct QalamDWriteLayoutCacheStats {
+    size_t entry_count;         /**< Layouts held */
+    size_t bytes_used;          /**< Estimated bytes held */
+    size_t byte_budget;         /**< Budget given at creation */
+    uint64_t hits;              /**< Lookups answered from the cache */
+    uint64_t misses;            /**< Lookups that created a layout */
+    uint64_t evictions;         /**< Layouts dropped to stay within budget */
+    size_t run_count;           /**< Shaped glyph runs held */
+    uint64_t runs_shaped;       /**< Runs shaped by the text analyzer */
+    uint64_t runs_reused;       /**< Runs taken already shaped from other layouts */
+    uint64_t fallbacks;         /**< Layouts created through IDWriteTextLayout */
+} QalamDWriteLayoutCacheStats;
+
+/**
+ * @brief Create a layout cache
+ * 
+ * Layouts are looked up by a hash of their text together with the rest
+ * of the key, and the least recently used ones are released once their
+ * estimated size exceeds the budget.
+ * 
+ * Single lines are shaped with IDWriteTextAnalyzer into runs of one
+ * script and bidi level (long runs are split again after a space). The
+ * glyphs, advances and offsets of every run are shared by all cached
+ * layouts containing the same run text, so an edit reshapes only the
+ * runs it changed. Text with tabs or other control characters, glyphs
+ * missing from the format's font, or more than one line after wrapping
+ * is laid out by IDWriteTextLayout as before.
+ * 
+ * @param byte_budget Estimated bytes to keep (0 for the default)
+ * @param out_cache Pointer to receive the created cache handle
+ * @return QALAM_OK on success, error code on failure
+ */
+QalamResult qalam_dwrite_layout_cache_create(
+    size_t byte_budget,
+    QalamDWriteLayoutCache** out_cache
+);
+
+/**
+ * @brief Destroy a layout cache and every layout it holds
+ * 
+ * @param cache Cache to destroy (may be NULL)
+ */
+void qalam_dwrite_layout_cache_destroy(QalamDWriteLayoutCache* cache);
+
+/**
+ * @brief Start a new frame
+ * 
+ * Layouts returned since the previous call are kept even when the
+ * cache is over budget, so a frame can draw every layout it looked up.
+ * This call releases them and trims the cache back to its budget.
+ * 
+ * @param cache Layout cache
+ */
+void qalam_dwrite_layout_cache_begin_frame(QalamDWriteLayoutCache* cache);
+
+/**
+ * @brief Get a cached layout by generation alone, without the text
+ * 
+ * Finds the layout last returned for key->generation with the same
+ * format and layout box. Lets a renderer skip fetching and hashing
+ * lines whose generation has not changed; a line whose generation
+ * changed simply misses, and its old layout ages out.
+ * 
+ * @param cache Layout cache
+ * @param key Layout key (key->generation must not be 0)
+ * @return Layout owned by the cache (valid until the next
+ *         qalam_dwrite_layout_cache_begin_frame()), or NULL if none
+ */
+QalamDWriteTextLayout* qalam_dwrite_layout_cache_find(
+    QalamDWriteLayoutCache* cache,
+    const QalamDWriteLayoutKey* key
+);
+
+/**
+ * @brief Get the layout for a text, creating it on a miss
+ * 
+ * The returned layout is owned by the cache: do not destroy it. When
+ * key->generation is not 0 the layout becomes findable through
+ * qalam_dwrite_layout_cache_find(). A layout built from shaped runs
+ * creates its IDWriteTextLayout only when it is first hit tested.
+ * 
+ * @param cache Layout cache
+ * @param text Text to layout (UTF-16)
+ * @param text_length Length of text in characters
+ * @param key Format, layout box, DPI and generation
+ * @param out_layout Pointer to receive the layout (valid until the next
+ *        qalam_dwrite_layout_cache_begin_frame())
+ * @return QALAM_OK on success, error code on failure
+ */
+QalamResult qalam_dwrite_layout_cache_get(
+    QalamDWriteLayoutCache* cache,
+    const wchar_t* text,
+    uint32_t text_length,
+    const QalamDWriteLayoutKey* key,
+    QalamDWriteTextLayout** out_layout
+);
+
+/**
+ * @brief Release every layout in the cache
+ * 
+ * Must be called before destroying a text format the cache has seen,
+ * and after font or DPI settings change.
+ * 
+ * @param cache Layout cache
+ */
+void qalam_dwrite_layout_cache_clear(QalamDWriteLayoutCache* cache);
+
+/**
+ * @brief Get layout cache statistics
+ * 
+ * @param cache Layout cache
+ * @param out_stats Pointer to receive the statistics
+ */
+void qalam_dwrite_layout_cache_get_stats(
+    const QalamDWriteLayoutCache* cache,
+    QalamDWriteLayoutCacheStats* out_stats
+);
+
 /* ============================================================================
  * Render Target Management
  * ============================================================================ */
@@ -323,7 +753,9 @@ QalamResult qalam_dwrite_text_layout_hit_test_position(
 /**
  * @brief Create render target for a window
  * 
- * Creates a Direct2D render target bound to the specified window.
+ * Creates a Direct2D device context on a D3D11 device that presents
+ * through a flip-sequential swap chain, queuing at most one frame. If
+ * that fails, falls back to an ID2D1HwndRenderTarget.
  * 
  * @param hwnd Window handle (HWND passed as void* for C compatibility)
  * @param out_target Pointer to receive the created render target handle
@@ -368,6 +800,39 @@ void qalam_dwrite_render_target_get_dpi(
     float* out_dpi_y
 );
 
+/**
+ * @brief Check whether a render target presents through a flip-model swap chain
+ * 
+ * @param target Render target
+ * @return true for the swap chain backend, false for the HWND render target
+ */
+bool qalam_dwrite_render_target_is_flip_model(const QalamDWriteRenderTarget* target);
+
+/**
+ * @brief Get the swap chain's frame latency waitable object
+ * 
+ * Signaled when a new frame can be queued without blocking in present.
+ * Can be added to MsgWaitForMultipleObjects() by a frame scheduler; it
+ * changes when the target recovers from device loss, so fetch it again
+ * each frame.
+ * 
+ * @param target Render target
+ * @return HANDLE (as void*), or NULL for the HWND render target
+ */
+void* qalam_dwrite_render_target_get_frame_waitable(QalamDWriteRenderTarget* target);
+
+/**
+ * @brief Check whether the next frame must be drawn whole
+ * 
+ * True after creation, resize or device loss, and always for the HWND
+ * render target; otherwise the back buffer still holds the previous
+ * frame and only the marked dirty regions need drawing.
+ * 
+ * @param target Render target
+ * @return true if everything has to be drawn
+ */
+bool qalam_dwrite_render_is_full_frame(const QalamDWriteRenderTarget* target);
+
 /* ============================================================================
  * Brush Management
  * ============================================================================ */
@@ -405,10 +870,50 @@ void qalam_dwrite_brush_set_color(QalamDWriteBrush* brush, QalamDWriteColor colo
  * Rendering Operations
  * ============================================================================ */
 
+/**
+ * @brief Wait until the render target can take another frame
+ * 
+ * Call before handling input for a frame and drawing it, so the frame
+ * shows the newest input and present does not block.
+ * 
+ * @param target Render target
+ * @param timeout_ms Longest wait in milliseconds
+ * @return true if a frame can be drawn now (always for the HWND render target)
+ */
+bool qalam_dwrite_render_wait_for_frame(QalamDWriteRenderTarget* target, uint32_t timeout_ms);
+
+/**
+ * @brief Mark a region as changed for the next frame
+ * 
+ * When any region is marked before qalam_dwrite_render_begin(), the frame
+ * is clipped to the union of the marked regions and only the marked
+ * regions are presented; the rest of the window keeps the previous frame.
+ * Regions that overlap or touch are merged, and up to eight separate
+ * ones are passed to Present1() (past that, each new region is merged
+ * into the one it grows least), so a caret moving between distant lines
+ * presents two small rects rather than the band between them. Without a
+ * marked region (or after creation, resize or device loss) the whole
+ * window is presented. Ignored by the HWND render target.
+ * 
+ * @param target Render target
+ * @param x Left edge in DIPs
+ * @param y Top edge in DIPs
+ * @param width Region width in DIPs
+ * @param height Region height in DIPs
+ */
+void qalam_dwrite_render_add_dirty_rect(
+    QalamDWriteRenderTarget* target,
+    float x,
+    float y,
+    float width,
+    float height
+);
+
 /**
  * @brief Begin frame rendering
  * 
- * Must be called before any drawing operations.
+ * Must be called before any drawing operations. Draw the whole scene:
+ * drawing outside the marked dirty regions is clipped away.
  * 
  * @param target Render target
  */
@@ -417,8 +922,14 @@ void qalam_dwrite_render_begin(QalamDWriteRenderTarget* target);
 /**
  * @brief End frame rendering and present to screen
  * 
+ * Presents synchronized to vertical blank. On device loss the target
+ * recreates its device and brushes and invalidates the window, so the
+ * lost frame is drawn again on the next paint. Empties the calling
+ * thread's frame arena (see qalam_frame_reset()) afterwards.
+ * 
  * @param target Render target
- * @return QALAM_OK on success, error code on device lost, etc.
+ * @return QALAM_OK on success (also after recovering from device loss),
+ *         QALAM_ERROR_RENDER_TARGET if the target could not be recreated
  */
 QalamResult qalam_dwrite_render_end(QalamDWriteRenderTarget* target);
 
@@ -489,6 +1000,152 @@ void qalam_dwrite_render_draw_line(
     float stroke_width
 );
 
+/* ============================================================================
+ * Glyph Atlas
+ * ============================================================================ */
+
+/** Glyph style: bold */
+#define QALAM_DWRITE_GLYPH_BOLD     0x1u
+
+/** Glyph style: italic */
+#define QALAM_DWRITE_GLYPH_ITALIC   0x2u
+
+/**
+ * @brief Size of one cell of a glyph atlas' grid
+ * 
+ * Whole pixels at the target's DPI, given in DIPs.
+ */
+typedef struct QalamDWriteCellMetrics {
+    float cell_width;           /**< Advance of one cell */
+    float cell_height;          /**< Line height */
+    float baseline;             /**< Baseline from the top of a cell */
+} QalamDWriteCellMetrics;
+
+/**
+ * @brief Glyph atlas statistics
+ */
+typedef struct QalamDWriteGlyphAtlasStats {
+    size_t glyph_count;         /**< Glyphs held in the atlas */
+    size_t cluster_count;       /**< Shaped clusters held */
+    uint64_t glyphs_rasterized; /**< Glyphs drawn into the atlas */
+    uint64_t clusters_shaped;   /**< Clusters shaped by the text analyzer */
+    uint64_t clusters_reused;   /**< Clusters drawn again without shaping */
+    uint64_t flushes;           /**< Times the atlas filled up and was emptied */
+} QalamDWriteGlyphAtlasStats;
+
+/**
+ * @brief Create a glyph atlas for a font
+ * 
+ * Glyphs are rasterized once into an alpha bitmap on the target's
+ * device, keyed by font face and glyph, and drawn from there as
+ * opacity masks in any brush color. Bold and italic are faces of their
+ * own, resolved from the format's family. Characters the font lacks
+ * come from the system font fallback. When the bitmap fills up it is
+ * emptied and refilled with the glyphs still in use; after device loss
+ * or a DPI change the glyphs are rasterized again.
+ * 
+ * @param target Render target to draw on (must outlive the atlas)
+ * @param format Text format giving the family, size, weight and style
+ *        (only read during creation)
+ * @param out_atlas Pointer to receive the created atlas handle
+ * @return QALAM_OK on success, error code on failure
+ */
+QalamResult qalam_dwrite_glyph_atlas_create(
+    QalamDWriteRenderTarget* target,
+    QalamDWriteTextFormat* format,
+    QalamDWriteGlyphAtlas** out_atlas
+);
+
+/**
+ * @brief Destroy a glyph atlas, its glyphs and shaped clusters
+ * 
+ * @param atlas Atlas to destroy (may be NULL)
+ */
+void qalam_dwrite_glyph_atlas_destroy(QalamDWriteGlyphAtlas* atlas);
+
+/**
+ * @brief Get the cell size at the target's current DPI
+ * 
+ * The cell is as wide as the font's '0' and as tall as its line.
+ * 
+ * @param atlas Glyph atlas
+ * @param out_metrics Pointer to receive the metrics
+ */
+void qalam_dwrite_glyph_atlas_get_cell_metrics(
+    QalamDWriteGlyphAtlas* atlas,
+    QalamDWriteCellMetrics* out_metrics
+);
+
+/**
+ * @brief Draw a row of cells, one character per cell
+ * 
+ * Each character is drawn from the left edge of its cell. Must be called
+ * between qalam_dwrite_render_begin() and qalam_dwrite_render_end().
+ * 
+ * @param atlas Glyph atlas
+ * @param codepoints One Unicode character per cell; 0 leaves the cell
+ *        empty (as for the second cell of a wide character)
+ * @param count Cells to draw
+ * @param style QALAM_DWRITE_GLYPH_* flags
+ * @param x Left edge of the first cell in DIPs
+ * @param y Top edge of the cells in DIPs
+ * @param brush Brush for the text
+ */
+void qalam_dwrite_glyph_atlas_draw_cells(
+    QalamDWriteGlyphAtlas* atlas,
+    const uint32_t* codepoints,
+    uint32_t count,
+    uint32_t style,
+    float x,
+    float y,
+    QalamDWriteBrush* brush
+);
+
+/**
+ * @brief Draw text that has to be shaped as a whole across several cells
+ * 
+ * For joining scripts such as Arabic, and characters carrying combining
+ * marks. The text is shaped once and kept by its text, style and
+ * direction, so drawing it again only places glyphs. It starts at the
+ * span's leading edge (the right one when right-to-left) and is
+ * narrowed to fit the span when it is wider. Must be called between
+ * qalam_dwrite_render_begin() and qalam_dwrite_render_end().
+ * 
+ * @param atlas Glyph atlas
+ * @param text UTF-16 text
+ * @param length Length of the text
+ * @param cells Cells the text spans
+ * @param is_rtl Lay the text out right-to-left
+ * @param style QALAM_DWRITE_GLYPH_* flags
+ * @param x Left edge of the span in DIPs
+ * @param y Top edge of the span in DIPs
+ * @param brush Brush for the text
+ * @return true if drawn, false if the font cannot shape the text (draw
+ *         its cells with qalam_dwrite_glyph_atlas_draw_cells() instead)
+ */
+bool qalam_dwrite_glyph_atlas_draw_cluster(
+    QalamDWriteGlyphAtlas* atlas,
+    const wchar_t* text,
+    uint32_t length,
+    uint32_t cells,
+    bool is_rtl,
+    uint32_t style,
+    float x,
+    float y,
+    QalamDWriteBrush* brush
+);
+
+/**
+ * @brief Get glyph atlas statistics
+ * 
+ * @param atlas Glyph atlas
+ * @param out_stats Pointer to receive the statistics
+ */
+void qalam_dwrite_glyph_atlas_get_stats(
+    const QalamDWriteGlyphAtlas* atlas,
+    QalamDWriteGlyphAtlasStats* out_stats
+);
+
 /* ============================================================================
  * Utility Functions
  * ============================================================================ */
@@ -2,8 +2,8 @@
  * @file editor.h
  * @brief Qalam IDE - Editor and Buffer Interface
  * 
- * Defines the text buffer (gap buffer implementation) and cursor
- * management APIs for the Qalam editor core.
+ * Defines the text buffer (gap buffer or piece table storage) and
+ * cursor management APIs for the Qalam editor core.
  * 
  * @version 0.0.1
  * @copyright (c) 2026 Qalam Project
@@ -54,8 +54,13 @@ typedef struct QalamBufferStats {
     size_t total_lines;             /**< Total number of lines */
     size_t gap_size;                /**< Current gap size (internal) */
     size_t capacity;                /**< Total buffer capacity */
+    size_t resident_bytes;          /**< Text held in memory (see
+                                         qalam_buffer_get_resident_size()) */
     bool is_modified;               /**< Buffer has unsaved changes */
     bool is_readonly;               /**< Buffer is read-only */
+    bool is_hibernated;             /**< Text is kept as UTF-8 until used */
+    QalamMemoryStats memory;        /**< Tagged allocations of the whole process, per
+                                         subsystem (see qalam_memory_get_stats()) */
 } QalamBufferStats;
 
 /**
@@ -80,6 +85,155 @@ typedef struct QalamLineInfo {
     bool has_ltr_chars;             /**< Contains LTR characters */
 } QalamLineInfo;
 
+/** Maximum number of segments in a QalamTextView */
+#define QALAM_TEXT_VIEW_MAX_SEGMENTS 2
+
+/**
+ * @brief Read-only view of buffer text, without copying
+ * 
+ * The text is UTF-16, split into at most two contiguous segments (for
+ * the gap buffer: before and after the gap).
+ */
+typedef struct QalamTextView {
+    const wchar_t* segments[QALAM_TEXT_VIEW_MAX_SEGMENTS]; /**< Segment starts */
+    size_t lengths[QALAM_TEXT_VIEW_MAX_SEGMENTS];          /**< Segment lengths in wchar_t */
+    size_t segment_count;           /**< Used segments (0 for empty text) */
+    size_t length;                  /**< Total length in wchar_t */
+} QalamTextView;
+
+/**
+ * @brief Storage backend used by a buffer
+ */
+typedef enum QalamBufferBackend {
+    QALAM_BUFFER_BACKEND_AUTO = 0,  /**< Gap buffer, or piece table for large content */
+    QALAM_BUFFER_BACKEND_GAP,       /**< Contiguous gap buffer (fast cursor-local edits) */
+    QALAM_BUFFER_BACKEND_PIECE_TABLE, /**< Piece table (O(log n) edits anywhere, no size cap) */
+} QalamBufferBackend;
+
+/**
+ * @brief Callback telling the owner of a loading buffer to poll it
+ * 
+ * Called from a loader thread whenever more of the file is ready, and
+ * once when loading stops. It must not touch the buffer; a UI posts a
+ * message to its own thread, which then calls qalam_buffer_poll_load().
+ * 
+ * @param user_data User-provided context
+ */
+typedef void (*QalamLoadReadyCallback)(void* user_data);
+
+/**
+ * @brief Buffer creation options
+ * 
+ * With virtual_memory a gap buffer reserves address space for its
+ * largest size (100 MB) when created and commits 64 KB steps as text
+ * reaches them, so it grows without copying, and pages the gap leaves
+ * behind by a margin of 1 MB are decommitted. Intended for 64-bit
+ * builds, where the reservation costs nothing but address space.
+ */
+typedef struct QalamBufferOptions {
+    QalamBufferBackend backend;     /**< Storage backend */
+    size_t large_content_threshold; /**< Bytes of UTF-8 at which AUTO picks the piece table */
+    bool map_file;                  /**< Map files and decode lazily (implies piece table) */
+    bool background_load;           /**< Read and decode files on worker threads (implies piece table) */
+    QalamLoadReadyCallback load_ready; /**< Ready callback for background_load, or NULL */
+    void* load_user_data;           /**< Context for load_ready */
+    bool virtual_memory;            /**< Gap buffer: reserve up front, commit on demand */
+} QalamBufferOptions;
+
+/**
+ * @brief Callback for save progress
+ * 
+ * Called after each chunk reaches the file. The buffer must not be
+ * modified from inside the callback.
+ * 
+ * @param buffer The buffer being saved
+ * @param bytes_written UTF-8 bytes written so far
+ * @param bytes_total Total UTF-8 bytes to write
+ * @param user_data User-provided context
+ */
+typedef void (*QalamSaveProgressCallback)(
+    const QalamBuffer* buffer,
+    size_t bytes_written,
+    size_t bytes_total,
+    void* user_data
+);
+
+/**
+ * @brief Lines affected by a change to a buffer
+ * 
+ * Lines [first_line, first_line + old_line_count) of the text before
+ * the change were replaced by lines [first_line, first_line +
+ * new_line_count) of the text after it. Lines outside that run kept
+ * their content, though lines after it may have been renumbered.
+ */
+typedef struct QalamBufferChange {
+    size_t first_line;              /**< First affected line (0-based) */
+    size_t old_line_count;          /**< Lines replaced (at least 1) */
+    size_t new_line_count;          /**< Lines that replaced them (at least 1) */
+} QalamBufferChange;
+
+/**
+ * @brief Callback for buffer changes
+ * 
+ * Called once per edit, undo, redo, committed edit transaction, load or
+ * qalam_buffer_poll_load() that appended lines, after the buffer is
+ * consistent again. Edits made while an undo group is open are reported
+ * together when the outermost group ends. The buffer must not be
+ * modified from inside the callback.
+ * 
+ * @param buffer The buffer that changed
+ * @param change Lines affected
+ * @param user_data User-provided context
+ */
+typedef void (*QalamBufferChangeCallback)(
+    const QalamBuffer* buffer,
+    const QalamBufferChange* change,
+    void* user_data
+);
+
+/**
+ * @brief Callback polled during a long search
+ * 
+ * @param user_data User-provided context
+ * @return true to stop the search
+ */
+typedef bool (*QalamSearchCancelCallback)(void* user_data);
+
+/**
+ * @brief Search options
+ */
+typedef struct QalamSearchOptions {
+    bool ignore_case;               /**< Fold A-Z onto a-z */
+    bool arabic_folding;            /**< Ignore harakat and tatweel, fold alef/hamza forms */
+    bool wrap;                      /**< Continue from the start of the buffer */
+    QalamSearchCancelCallback cancel; /**< Polled while searching, or NULL */
+    void* cancel_user_data;         /**< User-provided context for 'cancel' */
+} QalamSearchOptions;
+
+/**
+ * @brief Text matched by a search
+ */
+typedef struct QalamSearchMatch {
+    size_t start_offset;            /**< Start offset */
+    size_t end_offset;              /**< End offset (exclusive) */
+} QalamSearchMatch;
+
+/**
+ * @brief Callback for each match found by qalam_buffer_find_all()
+ * 
+ * The buffer must not be modified from inside the callback.
+ * 
+ * @param buffer The buffer being searched
+ * @param match Matched range
+ * @param user_data User-provided context
+ * @return true to continue, false to stop the search
+ */
+typedef bool (*QalamSearchMatchCallback)(
+    const QalamBuffer* buffer,
+    const QalamSearchMatch* match,
+    void* user_data
+);
+
 /*=============================================================================
  * Buffer Creation and Destruction
  *============================================================================*/
@@ -120,6 +274,100 @@ QalamResult qalam_buffer_create_from_text(QalamBuffer** buffer, const char* text
  */
 QalamResult qalam_buffer_create_from_file(QalamBuffer** buffer, const wchar_t* filepath);
 
+/**
+ * @brief Get default buffer creation options
+ * 
+ * @param[out] options Pointer to options structure to fill
+ * @return QALAM_OK on success
+ */
+QalamResult qalam_buffer_get_default_options(QalamBufferOptions* options);
+
+/**
+ * @brief Create a new empty buffer with options
+ * 
+ * @param[out] buffer Pointer to receive the new buffer handle
+ * @param options Buffer options (NULL for defaults)
+ * @return QALAM_OK on success, error code on failure
+ */
+QalamResult qalam_buffer_create_with_options(QalamBuffer** buffer, const QalamBufferOptions* options);
+
+/**
+ * @brief Create a buffer from UTF-8 text with options
+ * 
+ * @param[out] buffer Pointer to receive the new buffer handle
+ * @param text UTF-8 encoded text to initialize with
+ * @param length Length of text in bytes, or 0 for null-terminated
+ * @param options Buffer options (NULL for defaults)
+ * @return QALAM_OK on success, error code on failure
+ */
+QalamResult qalam_buffer_create_from_text_with_options(QalamBuffer** buffer, const char* text,
+                                                        size_t length, const QalamBufferOptions* options);
+
+/**
+ * @brief Create a buffer from a file with options
+ * 
+ * The piece table backend decodes the file straight into its immutable
+ * original text, without an intermediate copy, and has no size cap.
+ * With options->background_load, this returns once the first 64 KB is
+ * loaded, without waiting for the rest (see qalam_buffer_poll_load()).
+ * 
+ * @param[out] buffer Pointer to receive the new buffer handle
+ * @param filepath Path to the file
+ * @param options Buffer options (NULL for defaults)
+ * @return QALAM_OK on success, error code on failure
+ */
+QalamResult qalam_buffer_create_from_file_with_options(QalamBuffer** buffer, const wchar_t* filepath,
+                                                        const QalamBufferOptions* options);
+
+/**
+ * @brief Get the storage backend a buffer was created with
+ * 
+ * @param buffer Source buffer
+ * @return Backend in use (never QALAM_BUFFER_BACKEND_AUTO)
+ */
+QalamBufferBackend qalam_buffer_get_backend(const QalamBuffer* buffer);
+
+/*=============================================================================
+ * Background Loading
+ *============================================================================*/
+
+/**
+ * @brief Absorb lines indexed in the background since the last call
+ * 
+ * Buffers opened with QalamBufferOptions.map_file or background_load
+ * start with only the first part of the file; the rest is prepared on
+ * background threads and appended to the buffer when this is called
+ * (e.g. once per frame, or when load_ready fires). Line count and
+ * content grow until loading is complete, and each call that appends
+ * lines is reported to the change callback. A background_load buffer
+ * is read-only until then. For other buffers this does nothing and
+ * reports completion.
+ * 
+ * @param buffer Target buffer
+ * @param[out] complete Set to true once the whole file is available (optional)
+ * @return QALAM_OK on success, error code if background indexing failed
+ */
+QalamResult qalam_buffer_poll_load(QalamBuffer* buffer, bool* complete);
+
+/**
+ * @brief Block until background indexing finishes and absorb the rest
+ * 
+ * @param buffer Target buffer
+ * @return QALAM_OK on success, error code if background indexing failed
+ */
+QalamResult qalam_buffer_wait_load(QalamBuffer* buffer);
+
+/**
+ * @brief Get background loading progress
+ * 
+ * @param buffer Source buffer
+ * @param[out] bytes_loaded File bytes available in the buffer (optional)
+ * @param[out] bytes_total Total file bytes (optional)
+ * @return QALAM_OK on success, error code on failure
+ */
+QalamResult qalam_buffer_get_load_progress(const QalamBuffer* buffer, size_t* bytes_loaded,
+                                            size_t* bytes_total);
+
 /**
  * @brief Destroy a buffer and free its resources
  * 
@@ -184,6 +432,232 @@ QalamResult qalam_buffer_delete_range(QalamBuffer* buffer, size_t start_offset,
 QalamResult qalam_buffer_replace(QalamBuffer* buffer, size_t start_offset, size_t end_offset, 
                                   const char* text, size_t length);
 
+/*=============================================================================
+ * Undo and Redo
+ *============================================================================*/
+
+/**
+ * @brief Undo the most recent group of edits
+ * 
+ * Each insert, delete or replace call is one group, except that runs of
+ * single characters typed, backspaced or forward-deleted at adjoining
+ * positions form a single group. The cursor and selection are restored
+ * to what they were before the group. Undoing a group costs the same
+ * however many keystrokes or characters it covers.
+ * 
+ * @param buffer Target buffer
+ * @return QALAM_OK on success (including when there is nothing to undo),
+ *         QALAM_ERROR_INVALID_ARGUMENT while an undo group is open
+ */
+QalamResult qalam_buffer_undo(QalamBuffer* buffer);
+
+/**
+ * @brief Redo the most recently undone group of edits
+ * 
+ * Redo history is discarded by the next edit.
+ * 
+ * @param buffer Target buffer
+ * @return QALAM_OK on success (including when there is nothing to redo),
+ *         QALAM_ERROR_INVALID_ARGUMENT while an undo group is open
+ */
+QalamResult qalam_buffer_redo(QalamBuffer* buffer);
+
+/**
+ * @brief Check whether qalam_buffer_undo() would change the buffer
+ * 
+ * @param buffer Source buffer
+ * @return true if there is a group to undo
+ */
+bool qalam_buffer_can_undo(const QalamBuffer* buffer);
+
+/**
+ * @brief Check whether qalam_buffer_redo() would change the buffer
+ * 
+ * @param buffer Source buffer
+ * @return true if there is a group to redo
+ */
+bool qalam_buffer_can_redo(const QalamBuffer* buffer);
+
+/**
+ * @brief Start collecting edits into a single undo group
+ * 
+ * Calls may nest; the group ends with the outermost
+ * qalam_buffer_end_undo_group().
+ * 
+ * @param buffer Target buffer
+ * @return QALAM_OK on success, error code on failure
+ */
+QalamResult qalam_buffer_begin_undo_group(QalamBuffer* buffer);
+
+/**
+ * @brief Finish a group started with qalam_buffer_begin_undo_group()
+ * 
+ * @param buffer Target buffer
+ * @return QALAM_OK on success, QALAM_ERROR_INVALID_ARGUMENT if no group is open
+ */
+QalamResult qalam_buffer_end_undo_group(QalamBuffer* buffer);
+
+/**
+ * @brief Discard all undo and redo history
+ * 
+ * Does nothing while an undo group is open.
+ * 
+ * @param buffer Target buffer
+ */
+void qalam_buffer_clear_undo(QalamBuffer* buffer);
+
+/*=============================================================================
+ * Edit Transactions
+ *============================================================================*/
+
+/**
+ * @brief Start collecting replacements to apply in one pass
+ * 
+ * Replace-all and multi-cursor edits queue every replacement with
+ * qalam_buffer_edit_replace() and apply them together with
+ * qalam_buffer_commit_edit(). The storage is traversed once, the line
+ * index is updated once per cluster of nearby edits, and the whole
+ * transaction is one undo group and one change notification.
+ * 
+ * @param buffer Target buffer
+ * @return QALAM_OK on success, QALAM_ERROR_INVALID_ARGUMENT if a
+ *         transaction is already open
+ */
+QalamResult qalam_buffer_begin_edit(QalamBuffer* buffer);
+
+/**
+ * @brief Queue a replacement in the open transaction
+ * 
+ * Ranges are offsets into the buffer as it is when the transaction is
+ * committed, and must be queued in ascending order without overlapping
+ * (adjoining ranges are allowed). An empty range inserts; an empty
+ * replacement deletes. The text is copied, so it need not outlive the call.
+ * 
+ * @param buffer Target buffer
+ * @param start_offset Start offset
+ * @param end_offset End offset (exclusive)
+ * @param text Replacement text (UTF-8)
+ * @param length Length of replacement text
+ * @return QALAM_OK on success, QALAM_ERROR_INVALID_ARGUMENT if no
+ *         transaction is open, QALAM_ERROR_INVALID_RANGE if the range
+ *         starts before the end of the previous one
+ */
+QalamResult qalam_buffer_edit_replace(QalamBuffer* buffer, size_t start_offset, size_t end_offset,
+                                      const char* text, size_t length);
+
+/**
+ * @brief Apply the queued replacements and close the transaction
+ * 
+ * A cursor inside or at the edge of a replaced range ends up after its
+ * replacement; otherwise it keeps its place in the surrounding text.
+ * 
+ * @param buffer Target buffer
+ * @return QALAM_OK on success, QALAM_ERROR_INVALID_ARGUMENT if no
+ *         transaction is open, QALAM_ERROR_INVALID_RANGE if a range is
+ *         past the end of the buffer (nothing is applied), error code
+ *         on other failure
+ */
+QalamResult qalam_buffer_commit_edit(QalamBuffer* buffer);
+
+/**
+ * @brief Discard the queued replacements and close the transaction
+ * 
+ * @param buffer Target buffer
+ */
+void qalam_buffer_cancel_edit(QalamBuffer* buffer);
+
+/*=============================================================================
+ * Change Notification
+ *============================================================================*/
+
+/**
+ * @brief Set the callback told about changes to the buffer
+ * 
+ * @param buffer Target buffer
+ * @param callback Callback, or NULL to stop notifications
+ * @param user_data User-provided context passed to the callback
+ * @return QALAM_OK on success, error code on failure
+ */
+QalamResult qalam_buffer_set_change_callback(QalamBuffer* buffer,
+                                             QalamBufferChangeCallback callback,
+                                             void* user_data);
+
+/*=============================================================================
+ * Search
+ *============================================================================*/
+
+/**
+ * @brief Get the default search options
+ * 
+ * Case-sensitive, without Arabic folding or wrapping, not cancellable.
+ * 
+ * @param[out] options Pointer to receive the defaults
+ * @return QALAM_OK on success, error code on failure
+ */
+QalamResult qalam_buffer_get_default_search_options(QalamSearchOptions* options);
+
+/**
+ * @brief Find the first match at or after an offset
+ * 
+ * The text is searched where it is stored, without being copied. With
+ * arabic_folding, harakat (U+064B-U+065F, U+0670) and tatweel (U+0640)
+ * are skipped in the text and the pattern, and alef and hamza forms
+ * match their base letter (آ أ إ ٱ as ا, ؤ as و, ئ as ي); a match then
+ * also covers the harakat on its last letter. The pattern and options
+ * are kept for qalam_buffer_find_next().
+ * 
+ * @param buffer Target buffer
+ * @param pattern Text to find (UTF-8)
+ * @param length Length of pattern in bytes
+ * @param start_offset Offset to start searching from
+ * @param options Search options (NULL for defaults)
+ * @param[out] match Pointer to receive the match
+ * @param[out] found Set to whether a match was found
+ * @return QALAM_OK on success, QALAM_ERROR_INVALID_ARGUMENT if the
+ *         pattern is empty (after folding), QALAM_ERROR_CANCELLED if
+ *         options->cancel stopped the search, error code on other failure
+ */
+QalamResult qalam_buffer_find(QalamBuffer* buffer, const char* pattern, size_t length,
+                              size_t start_offset, const QalamSearchOptions* options,
+                              QalamSearchMatch* match, bool* found);
+
+/**
+ * @brief Repeat the last qalam_buffer_find() after its match
+ * 
+ * Searches from the end of the last match, or from where the last
+ * search started if it found nothing.
+ * 
+ * @param buffer Target buffer
+ * @param[out] match Pointer to receive the match
+ * @param[out] found Set to whether a match was found
+ * @return QALAM_OK on success, QALAM_ERROR_INVALID_ARGUMENT if there
+ *         was no previous search, QALAM_ERROR_CANCELLED if the search
+ *         was stopped, error code on other failure
+ */
+QalamResult qalam_buffer_find_next(QalamBuffer* buffer, QalamSearchMatch* match, bool* found);
+
+/**
+ * @brief Report every match in the buffer, in order, without overlaps
+ * 
+ * options->wrap is ignored. Matches reported before the search was
+ * cancelled or stopped stand.
+ * 
+ * @param buffer Target buffer
+ * @param pattern Text to find (UTF-8)
+ * @param length Length of pattern in bytes
+ * @param options Search options (NULL for defaults)
+ * @param callback Callback for each match (optional)
+ * @param user_data User-provided context passed to the callback
+ * @param[out] count Receives the number of matches reported (optional)
+ * @return QALAM_OK on success, QALAM_ERROR_INVALID_ARGUMENT if the
+ *         pattern is empty (after folding), QALAM_ERROR_CANCELLED if
+ *         options->cancel stopped the search, error code on other failure
+ */
+QalamResult qalam_buffer_find_all(QalamBuffer* buffer, const char* pattern, size_t length,
+                                  const QalamSearchOptions* options,
+                                  QalamSearchMatchCallback callback, void* user_data,
+                                  size_t* count);
+
 /*=============================================================================
  * Cursor Operations
  *============================================================================*/
@@ -286,6 +760,54 @@ QalamResult qalam_buffer_get_line(const QalamBuffer* buffer, size_t line_number,
 QalamResult qalam_buffer_get_line_info(const QalamBuffer* buffer, size_t line_number,
                                         QalamLineInfo* info);
 
+/**
+ * @brief Get the change generation of a line
+ * 
+ * The value stays the same until an edit, undo, redo or load touches
+ * the line, and is then replaced by one no other line of any buffer
+ * has. Moving the line up or down (by editing lines above it) keeps it.
+ * Renderers can key cached layouts of the line on it.
+ * 
+ * @param buffer Source buffer
+ * @param line_number Line number (0-based)
+ * @return Generation (never 0), or 0 for a NULL buffer or invalid line
+ */
+uint32_t qalam_buffer_get_line_generation(const QalamBuffer* buffer, size_t line_number);
+
+/**
+ * @brief Get a line as a zero-copy view of the buffer's UTF-16 text
+ * 
+ * The newline is not included. The segments point into the buffer and
+ * stay valid until the buffer is modified or another view is requested
+ * (for buffers opened with map_file, until the buffer's text is next
+ * read).
+ * 
+ * @param buffer Source buffer
+ * @param line_number Line number (0-based)
+ * @param contiguous Rearrange storage if needed so the view is a single
+ *        segment (moves the gap out of the line; the cursor is unaffected)
+ * @param[out] view Receives the view
+ * @return QALAM_OK on success, error code on failure
+ */
+QalamResult qalam_buffer_get_line_view(QalamBuffer* buffer, size_t line_number,
+                                        bool contiguous, QalamTextView* view);
+
+/**
+ * @brief Get a range as a zero-copy view of the buffer's UTF-16 text
+ * 
+ * Same validity rules as qalam_buffer_get_line_view().
+ * 
+ * @param buffer Source buffer
+ * @param start_offset Start offset
+ * @param end_offset End offset
+ * @param contiguous Rearrange storage if needed so the view is a single segment
+ * @param[out] view Receives the view
+ * @return QALAM_OK on success, error code on failure
+ */
+QalamResult qalam_buffer_get_range_view(QalamBuffer* buffer, size_t start_offset,
+                                         size_t end_offset, bool contiguous,
+                                         QalamTextView* view);
+
 /**
  * @brief Get entire buffer content
  * 
@@ -357,6 +879,79 @@ bool qalam_buffer_is_modified(const QalamBuffer* buffer);
  */
 void qalam_buffer_clear_modified(QalamBuffer* buffer);
 
+/*=============================================================================
+ * Memory Footprint
+ *============================================================================*/
+
+/**
+ * @brief Give back storage the buffer is not using
+ * 
+ * A gap buffer on the heap is reallocated to its text plus a little room
+ * to type; a virtual one returns the middle of its gap to the system. A
+ * piece table trims its add buffer and drops the text decoded from a
+ * mapped file. The next edit grows the storage again as usual.
+ * 
+ * @param buffer Target buffer
+ * @return QALAM_OK on success, QALAM_ERROR_OUT_OF_MEMORY if the smaller
+ *         storage could not be allocated (the buffer is unchanged)
+ */
+QalamResult qalam_buffer_shrink_to_fit(QalamBuffer* buffer);
+
+/**
+ * @brief Keep the buffer's text as compact UTF-8 until it is used again
+ * 
+ * The UTF-16 storage is released and the text encoded in its place,
+ * which halves ASCII text and keeps Arabic the same size. The line index, cursor,
+ * selection, undo history and modified flag stay as they are, so line
+ * counts, sizes and statistics are answered without waking the buffer.
+ * Any call that reads or edits the text rehydrates it first.
+ * 
+ * A piece table over a memory-mapped file keeps reading the original
+ * text from the file; only its edits are encoded. Views returned
+ * earlier become invalid. Unpaired surrogates in a gap buffer come back
+ * as U+FFFD.
+ * 
+ * @param buffer Target buffer
+ * @return QALAM_OK on success (also if already hibernated),
+ *         QALAM_ERROR_BUFFER_READONLY while the file is still loading,
+ *         QALAM_ERROR_OUT_OF_MEMORY if the UTF-8 copy could not be made
+ *         (the buffer is unchanged)
+ */
+QalamResult qalam_buffer_hibernate(QalamBuffer* buffer);
+
+/**
+ * @brief Decode a hibernated buffer's text back into its storage
+ * 
+ * Happens on its own when the text is next used; calling it ahead of
+ * time moves the cost off the first keystroke.
+ * 
+ * @param buffer Target buffer
+ * @return QALAM_OK on success (also if not hibernated), error code on
+ *         failure (the buffer stays hibernated)
+ */
+QalamResult qalam_buffer_rehydrate(QalamBuffer* buffer);
+
+/**
+ * @brief Check whether a buffer is hibernated
+ * 
+ * @param buffer Source buffer
+ * @return true if its text is kept as UTF-8
+ */
+bool qalam_buffer_is_hibernated(const QalamBuffer* buffer);
+
+/**
+ * @brief Get the bytes of text the buffer holds in memory
+ * 
+ * Counts the text storage (committed pages for a virtual gap buffer,
+ * decoded chunks of a mapped file, the UTF-8 copy of a hibernated
+ * buffer), the copy kept for split views and the text held for undo.
+ * A streamed file's text belongs to its loader and is not counted.
+ * 
+ * @param buffer Source buffer
+ * @return Resident bytes, or 0 on error
+ */
+size_t qalam_buffer_get_resident_size(const QalamBuffer* buffer);
+
 /*=============================================================================
  * File Operations
  *============================================================================*/
@@ -364,12 +959,32 @@ void qalam_buffer_clear_modified(QalamBuffer* buffer);
 /**
  * @brief Save buffer to file
  * 
+ * Same as qalam_buffer_save_with_progress() without a callback.
+ * 
  * @param buffer Source buffer
  * @param filepath Path to save to
  * @return QALAM_OK on success, error code on failure
  */
 QalamResult qalam_buffer_save(QalamBuffer* buffer, const wchar_t* filepath);
 
+/**
+ * @brief Save buffer to file, reporting progress
+ * 
+ * The text is converted to UTF-8 in fixed-size chunks and streamed to a
+ * temporary file next to the target, which then replaces the target
+ * (keeping its attributes and security). Memory use does not grow with
+ * file size, and the target is left untouched if the save fails.
+ * 
+ * @param buffer Source buffer
+ * @param filepath Path to save to
+ * @param callback Progress callback (optional)
+ * @param user_data User context passed to callback
+ * @return QALAM_OK on success, error code on failure
+ */
+QalamResult qalam_buffer_save_with_progress(QalamBuffer* buffer, const wchar_t* filepath,
+                                            QalamSaveProgressCallback callback,
+                                            void* user_data);
+
 /**
  * @brief Load file into buffer (replaces content)
  * 
@@ -425,6 +1040,358 @@ void qalam_buffer_clear_selection(QalamBuffer* buffer);
 QalamResult qalam_buffer_get_selected_text(const QalamBuffer* buffer, char* out_text,
                                             size_t out_size, size_t* bytes_written);
 
+/*=============================================================================
+ * Workspace
+ *
+ * A workspace owns the open buffers and keeps their memory in check.
+ * Buffers left alone for a while give back their spare storage, then
+ * hibernate (see qalam_buffer_hibernate()); while the buffers together
+ * hold more than the budget, the least recently used ones hibernate
+ * first. The active buffer is never shrunk or hibernated. Call
+ * qalam_workspace_apply_policy() every few seconds.
+ *============================================================================*/
+
+/**
+ * @brief Opaque workspace
+ */
+typedef struct QalamWorkspace QalamWorkspace;
+
+/**
+ * @brief Workspace memory policy
+ */
+typedef struct QalamWorkspaceOptions {
+    size_t memory_budget;           /**< Resident bytes the buffers may hold (0: no budget) */
+    uint32_t shrink_after_ms;       /**< Idle time before a buffer is shrunk (0: never) */
+    uint32_t hibernate_after_ms;    /**< Idle time before a buffer hibernates (0: only
+                                         when over budget) */
+} QalamWorkspaceOptions;
+
+/**
+ * @brief Workspace statistics
+ */
+typedef struct QalamWorkspaceStats {
+    size_t buffer_count;            /**< Buffers in the workspace */
+    size_t hibernated_count;        /**< Of them, hibernated */
+    size_t resident_bytes;          /**< Sum of qalam_buffer_get_resident_size() */
+    uint64_t shrinks;               /**< Buffers shrunk by the policy */
+    uint64_t hibernations;          /**< Buffers hibernated by the policy */
+    uint64_t rehydrations;          /**< Hibernated buffers woken by qalam_workspace_focus() */
+} QalamWorkspaceStats;
+
+/**
+ * @brief Get default workspace options
+ * 
+ * A 256 MB budget, shrinking after 30 seconds and hibernating after
+ * 10 minutes.
+ * 
+ * @param[out] options Pointer to options structure to fill
+ * @return QALAM_OK on success
+ */
+QalamResult qalam_workspace_get_default_options(QalamWorkspaceOptions* options);
+
+/**
+ * @brief Create an empty workspace
+ * 
+ * @param[out] workspace Receives the workspace
+ * @param options Memory policy (NULL for defaults)
+ * @return QALAM_OK on success, error code on failure
+ */
+QalamResult qalam_workspace_create(QalamWorkspace** workspace,
+                                   const QalamWorkspaceOptions* options);
+
+/**
+ * @brief Destroy a workspace and every buffer in it
+ * 
+ * @param workspace Workspace to destroy (may be NULL)
+ */
+void qalam_workspace_destroy(QalamWorkspace* workspace);
+
+/**
+ * @brief Add a buffer; the workspace takes ownership
+ * 
+ * The buffer counts as just used. It does not become active.
+ * 
+ * @param workspace Target workspace
+ * @param buffer Buffer to add
+ * @return QALAM_OK on success, QALAM_ERROR_INVALID_ARGUMENT if it is
+ *         already in the workspace, QALAM_ERROR_OUT_OF_MEMORY on failure
+ *         (the caller keeps the buffer)
+ */
+QalamResult qalam_workspace_add(QalamWorkspace* workspace, QalamBuffer* buffer);
+
+/**
+ * @brief Take a buffer out of the workspace; the caller owns it again
+ * 
+ * If it was active, no buffer is. It may still be hibernated.
+ * 
+ * @param workspace Target workspace
+ * @param buffer Buffer to remove
+ * @return QALAM_OK on success, QALAM_ERROR_INVALID_ARGUMENT if it is not
+ *         in the workspace
+ */
+QalamResult qalam_workspace_remove(QalamWorkspace* workspace, QalamBuffer* buffer);
+
+/**
+ * @brief Make a buffer the active one, rehydrating it
+ * 
+ * @param workspace Target workspace
+ * @param buffer Buffer in the workspace (NULL: no buffer is active)
+ * @return QALAM_OK on success, QALAM_ERROR_INVALID_ARGUMENT if it is not
+ *         in the workspace, or the error of qalam_buffer_rehydrate()
+ *         (the buffer is active anyway and wakes on first use)
+ */
+QalamResult qalam_workspace_focus(QalamWorkspace* workspace, QalamBuffer* buffer);
+
+/**
+ * @brief Note that a buffer other than the active one is in use
+ * 
+ * For buffers shown in a second view, or read by a tool. Does not wake
+ * the buffer.
+ * 
+ * @param workspace Target workspace
+ * @param buffer Buffer in the workspace
+ * @return QALAM_OK on success, QALAM_ERROR_INVALID_ARGUMENT if it is not
+ *         in the workspace
+ */
+QalamResult qalam_workspace_touch(QalamWorkspace* workspace, QalamBuffer* buffer);
+
+/**
+ * @brief Get the active buffer
+ * 
+ * @return The buffer last focused, or NULL
+ */
+QalamBuffer* qalam_workspace_get_active(const QalamWorkspace* workspace);
+
+/**
+ * @brief Get the number of buffers
+ */
+size_t qalam_workspace_get_count(const QalamWorkspace* workspace);
+
+/**
+ * @brief Get a buffer by position, in the order they were added
+ * 
+ * @return The buffer, or NULL if 'index' is out of range
+ */
+QalamBuffer* qalam_workspace_get_buffer(const QalamWorkspace* workspace, size_t index);
+
+/**
+ * @brief Change the memory policy
+ * 
+ * Takes effect at the next qalam_workspace_apply_policy().
+ * 
+ * @param workspace Target workspace
+ * @param options New policy
+ * @return QALAM_OK on success, QALAM_ERROR_NULL_POINTER if either is NULL
+ */
+QalamResult qalam_workspace_set_options(QalamWorkspace* workspace,
+                                        const QalamWorkspaceOptions* options);
+
+/**
+ * @brief Get the memory policy
+ * 
+ * @param workspace Source workspace
+ * @param[out] options Receives the policy
+ * @return QALAM_OK on success, QALAM_ERROR_NULL_POINTER if either is NULL
+ */
+QalamResult qalam_workspace_get_options(const QalamWorkspace* workspace,
+                                        QalamWorkspaceOptions* options);
+
+/**
+ * @brief Shrink and hibernate idle buffers, then enforce the budget
+ * 
+ * Buffers that fail to shrink or hibernate (out of memory, still
+ * loading) are skipped.
+ * 
+ * @param workspace Target workspace
+ * @return QALAM_OK on success, QALAM_ERROR_NULL_POINTER if NULL
+ */
+QalamResult qalam_workspace_apply_policy(QalamWorkspace* workspace);
+
+/**
+ * @brief Get workspace statistics
+ * 
+ * @param workspace Source workspace
+ * @param[out] stats Pointer to receive statistics
+ * @return QALAM_OK on success, QALAM_ERROR_NULL_POINTER if either is NULL
+ */
+QalamResult qalam_workspace_get_stats(const QalamWorkspace* workspace, QalamWorkspaceStats* stats);
+
+/*=============================================================================
+ * Syntax Highlighting
+ *
+ * A highlighter lexes a buffer's Baa source on a worker thread and keeps
+ * the style ranges and the lexer state at the end of every line, in an
+ * array that follows the line index through the buffer's change
+ * notifications. After an edit it lexes again from the first changed
+ * line only until a line ends in the state it ended in before; past that
+ * point nothing can have changed. Lines shown in the viewport are lexed
+ * before any others.
+ *
+ * The worker never touches the buffer: qalam_highlighter_update() copies
+ * the lines of the next job out of it, on the buffer's thread, and takes
+ * in the results of the last one. Results for lines an edit has since
+ * changed are dropped.
+ *
+ * Typical use: forward the buffer's change callback to
+ * qalam_highlighter_on_buffer_change(); from the ready callback, post a
+ * message to the window thread that calls qalam_highlighter_update()
+ * and invalidates the lines it restyled.
+ *============================================================================*/
+
+/**
+ * @brief Style of a run of source text
+ */
+typedef enum QalamSyntaxStyle {
+    QALAM_SYNTAX_PLAIN = 0,             /**< Identifiers, punctuation, whitespace */
+    QALAM_SYNTAX_KEYWORD,               /**< Control flow: إذا، طالما، إرجع */
+    QALAM_SYNTAX_TYPE,                  /**< Types: صحيح، نص، حرف */
+    QALAM_SYNTAX_CONSTANT,              /**< Values: صواب، خطأ، عدم */
+    QALAM_SYNTAX_BUILTIN,               /**< Built-in functions: اطبع */
+    QALAM_SYNTAX_STRING,                /**< String literals */
+    QALAM_SYNTAX_CHAR,                  /**< Character literals */
+    QALAM_SYNTAX_NUMBER,                /**< Numbers, in Western or Arabic-Indic digits */
+    QALAM_SYNTAX_COMMENT,               /**< Line and block comments */
+    QALAM_SYNTAX_OPERATOR,              /**< Operators */
+    QALAM_SYNTAX_PREPROCESSOR,          /**< Directives: #تضمين */
+    QALAM_SYNTAX_STYLE_COUNT
+} QalamSyntaxStyle;
+
+/**
+ * @brief Opaque syntax highlighter
+ */
+typedef struct QalamHighlighter QalamHighlighter;
+
+/**
+ * @brief Callback for finished highlighter jobs
+ * 
+ * Called from the worker thread when a job is done; the owner then
+ * calls qalam_highlighter_update() on the buffer's thread.
+ * 
+ * @param user_data User-provided context
+ */
+typedef void (*QalamHighlightReadyCallback)(void* user_data);
+
+/**
+ * @brief Highlighter options
+ */
+typedef struct QalamHighlighterOptions {
+    size_t batch_chars;             /**< Text per job outside the viewport (0 for the default) */
+    QalamHighlightReadyCallback ready; /**< Called when a job is done, or NULL */
+    void* user_data;                /**< Context for 'ready' */
+} QalamHighlighterOptions;
+
+/**
+ * @brief Highlighter statistics
+ */
+typedef struct QalamHighlighterStats {
+    size_t line_count;              /**< Lines tracked */
+    size_t pending_lines;           /**< Lines still to be lexed */
+    size_t range_count;             /**< Style ranges held */
+    uint64_t jobs;                  /**< Jobs taken in */
+    uint64_t lines_lexed;           /**< Lines lexed by the worker */
+    uint64_t lines_dropped;         /**< Lexed lines dropped because an edit changed them */
+} QalamHighlighterStats;
+
+/**
+ * @brief Get default highlighter options
+ * 
+ * @param[out] options Pointer to options structure to fill
+ * @return QALAM_OK on success
+ */
+QalamResult qalam_highlighter_get_default_options(QalamHighlighterOptions* options);
+
+/**
+ * @brief Create a highlighter for a buffer and start its worker
+ * 
+ * Every line starts out pending; nothing is lexed before the first
+ * qalam_highlighter_update().
+ * 
+ * @param[out] highlighter Receives the highlighter
+ * @param buffer Buffer to highlight (must outlive the highlighter)
+ * @param options Highlighter options (NULL for defaults)
+ * @return QALAM_OK on success, error code on failure
+ */
+QalamResult qalam_highlighter_create(QalamHighlighter** highlighter, QalamBuffer* buffer,
+                                     const QalamHighlighterOptions* options);
+
+/**
+ * @brief Stop the worker and destroy a highlighter
+ * 
+ * @param highlighter Highlighter to destroy (may be NULL)
+ */
+void qalam_highlighter_destroy(QalamHighlighter* highlighter);
+
+/**
+ * @brief Follow a change to the buffer
+ * 
+ * Call from the buffer's change callback. The changed lines become
+ * pending and keep their old ranges until they are lexed again.
+ * 
+ * @param highlighter Highlighter
+ * @param change Change reported by the buffer
+ * @return QALAM_OK on success, QALAM_ERROR_OUT_OF_MEMORY if the line
+ *         states could not grow (every line is then lexed again)
+ */
+QalamResult qalam_highlighter_on_buffer_change(QalamHighlighter* highlighter,
+                                               const QalamBufferChange* change);
+
+/**
+ * @brief Set the lines to lex first
+ * 
+ * @param highlighter Highlighter
+ * @param first_line First line of the viewport
+ * @param line_count Lines in the viewport
+ */
+void qalam_highlighter_set_viewport(QalamHighlighter* highlighter, size_t first_line,
+                                    size_t line_count);
+
+/**
+ * @brief Take in the worker's results and hand it the next job
+ * 
+ * Viewport lines that are pending are lexed first, starting from the
+ * state the line above them ended in so far; the lines from the first
+ * pending one down follow in jobs of about batch_chars characters.
+ * Does nothing while the buffer is hibernated.
+ * 
+ * @param highlighter Highlighter
+ * @param[out] first_line Receives the first line whose ranges changed (optional)
+ * @param[out] line_count Receives the lines from there whose ranges
+ *        changed, 0 if none (optional)
+ * @return QALAM_OK on success, error code on failure
+ */
+QalamResult qalam_highlighter_update(QalamHighlighter* highlighter, size_t* first_line,
+                                     size_t* line_count);
+
+/**
+ * @brief Check whether every line has been lexed from its true state
+ */
+bool qalam_highlighter_is_complete(const QalamHighlighter* highlighter);
+
+/**
+ * @brief Get the style ranges of a line
+ * 
+ * Ranges are ordered and do not overlap; text outside them is plain.
+ * A pending line shows its last ranges, which may reach past its end.
+ * 
+ * @param highlighter Highlighter
+ * @param line_number Line number (0-based)
+ * @param[out] ranges Receives the ranges (valid until the next update
+ *        or change)
+ * @return Number of ranges, 0 for none or a line out of range
+ */
+size_t qalam_highlighter_get_line_styles(const QalamHighlighter* highlighter,
+                                         size_t line_number, const QalamStyleRange** ranges);
+
+/**
+ * @brief Get highlighter statistics
+ * 
+ * @param highlighter Source highlighter
+ * @param[out] stats Pointer to receive statistics
+ * @return QALAM_OK on success, QALAM_ERROR_NULL_POINTER if either is NULL
+ */
+QalamResult qalam_highlighter_get_stats(const QalamHighlighter* highlighter,
+                                        QalamHighlighterStats* stats);
+
 #ifdef __cplusplus
 }
 #endif
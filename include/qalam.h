@@ -84,12 +84,15 @@ typedef enum QalamResult {
     QALAM_ERROR_OUT_OF_MEMORY = 4,      /**< Memory allocation failed */
     QALAM_ERROR_NOT_INITIALIZED = 5,    /**< Subsystem not initialized */
     QALAM_ERROR_ALREADY_INITIALIZED = 6,/**< Subsystem already initialized */
+    QALAM_ERROR_CANCELLED = 7,          /**< Operation cancelled by the caller */
+    QALAM_ERROR_TIMEOUT = 8,            /**< Wait timed out */
     
     /* Buffer errors (100-199) */
     QALAM_ERROR_BUFFER_EMPTY = 100,     /**< Buffer is empty */
     QALAM_ERROR_BUFFER_FULL = 101,      /**< Buffer capacity exceeded */
     QALAM_ERROR_INVALID_POSITION = 102, /**< Invalid cursor/position */
     QALAM_ERROR_INVALID_RANGE = 103,    /**< Invalid range specified */
+    QALAM_ERROR_BUFFER_READONLY = 104,  /**< Buffer cannot be modified */
     
     /* Window/UI errors (200-299) */
     QALAM_ERROR_WINDOW_CREATE = 200,    /**< Failed to create window */
@@ -183,6 +186,172 @@ typedef struct QalamTerminal QalamTerminal;
  */
 typedef struct QalamWindow QalamWindow;
 
+/**
+ * @brief A run of a line drawn in one style
+ * 
+ * Produced by the syntax highlighter and applied to text layouts.
+ * Offsets are in UTF-16 units from the start of the line.
+ */
+typedef struct QalamStyleRange {
+    uint32_t start;                 /**< First character of the run */
+    uint32_t length;                /**< Characters in the run */
+    uint32_t style;                 /**< Style index (a QalamSyntaxStyle) */
+} QalamStyleRange;
+
+/*=============================================================================
+ * Memory
+ *
+ * Qalam allocates through tagged functions instead of malloc() and free()
+ * directly, so every block is charged to the subsystem that asked for it
+ * and an embedder can supply the allocator (to cap memory, or to draw
+ * from its own heap). Each block carries a small header with its size
+ * and tag, so it is freed without either.
+ *
+ * Scratch memory needed only while a frame is drawn comes from the frame
+ * arena instead: allocating from it is a pointer bump, and it is emptied
+ * after each present.
+ *============================================================================*/
+
+/**
+ * @brief Subsystem an allocation is charged to
+ */
+typedef enum QalamMemoryTag {
+    QALAM_MEMORY_BUFFER = 0,            /**< Buffer text, pieces, line index, loaders, search */
+    QALAM_MEMORY_UNDO,                  /**< Undo journal */
+    QALAM_MEMORY_LAYOUT_CACHE,          /**< Text formats, layouts, shaped runs, glyph atlas */
+    QALAM_MEMORY_SYNTAX,                /**< Highlighter line states, style ranges and jobs */
+    QALAM_MEMORY_TERMINAL,              /**< ConPTY session, screen, scrollback, terminal view */
+    QALAM_MEMORY_FRAME,                 /**< Blocks of the frame arena */
+    QALAM_MEMORY_UI,                    /**< Other views and window state */
+    QALAM_MEMORY_TAG_COUNT
+} QalamMemoryTag;
+
+/**
+ * @brief Allocator callbacks
+ *
+ * Sizes include Qalam's block header. Blocks must be aligned for any
+ * type, as malloc() aligns them. Returning NULL fails the allocation,
+ * which the caller reports as QALAM_ERROR_OUT_OF_MEMORY.
+ */
+typedef struct QalamAllocator {
+    /** Allocate a block */
+    void* (*allocate)(size_t size, QalamMemoryTag tag, void* user_data);
+    /** Resize a block, keeping its contents (NULL to allocate, copy and release) */
+    void* (*reallocate)(void* block, size_t size, QalamMemoryTag tag, void* user_data);
+    /** Release a block */
+    void (*release)(void* block, QalamMemoryTag tag, void* user_data);
+    void* user_data;                    /**< Passed to each callback */
+} QalamAllocator;
+
+/**
+ * @brief Live and lifetime allocation counts per tag
+ *
+ * Bytes are as requested, without block headers. The frame arena's
+ * blocks count under QALAM_MEMORY_FRAME, not under their users' tags.
+ */
+typedef struct QalamMemoryStats {
+    uint64_t bytes[QALAM_MEMORY_TAG_COUNT];         /**< Bytes live */
+    uint64_t blocks[QALAM_MEMORY_TAG_COUNT];        /**< Blocks live */
+    uint64_t peak_bytes[QALAM_MEMORY_TAG_COUNT];    /**< Most bytes live at once */
+    uint64_t allocations[QALAM_MEMORY_TAG_COUNT];   /**< Blocks allocated in total */
+    uint64_t failures[QALAM_MEMORY_TAG_COUNT];      /**< Allocations that failed */
+} QalamMemoryStats;
+
+/**
+ * @brief Install the allocator every tagged allocation goes through
+ *
+ * A block must be released by the allocator that allocated it, so this
+ * is refused while any block is live; call it before creating anything
+ * (qalam_init() calls it for QalamInitOptions.allocator).
+ *
+ * @param allocator Callbacks to copy, or NULL for the C runtime heap
+ * @return QALAM_OK on success, QALAM_ERROR_INVALID_ARGUMENT if a callback
+ *         is missing, QALAM_ERROR_ALREADY_INITIALIZED if blocks are live
+ */
+QalamResult qalam_memory_set_allocator(const QalamAllocator* allocator);
+
+/**
+ * @brief Get the allocation counts per tag
+ *
+ * Thread-safe.
+ *
+ * @param[out] stats Pointer to receive the counts
+ */
+void qalam_memory_get_stats(QalamMemoryStats* stats);
+
+/**
+ * @brief Allocate a block charged to a tag, like malloc()
+ *
+ * Thread-safe, as are the other qalam_mem_* functions.
+ *
+ * @param tag Subsystem to charge
+ * @param size Bytes to allocate
+ * @return The block, or NULL on failure
+ */
+void* qalam_mem_alloc(QalamMemoryTag tag, size_t size);
+
+/**
+ * @brief Allocate a zeroed array charged to a tag, like calloc()
+ */
+void* qalam_mem_calloc(QalamMemoryTag tag, size_t count, size_t size);
+
+/**
+ * @brief Resize a block, like realloc()
+ *
+ * A block keeps the tag it was allocated with; 'tag' applies when
+ * 'block' is NULL. On failure the block is left as it was.
+ */
+void* qalam_mem_realloc(QalamMemoryTag tag, void* block, size_t size);
+
+/**
+ * @brief Free a block from qalam_mem_alloc() and friends, like free()
+ *
+ * @param block Block to free (may be NULL)
+ */
+void qalam_mem_free(void* block);
+
+/**
+ * @brief Allocate scratch memory from the frame arena
+ *
+ * The memory lasts until the next qalam_frame_reset() (or until
+ * qalam_frame_rewind() past it) and is aligned for any type. Each thread
+ * has its own arena; only the thread that draws the window has it reset
+ * by presents, so code that may run elsewhere brackets its scratch with
+ * qalam_frame_mark() and qalam_frame_rewind().
+ *
+ * @param size Bytes to allocate
+ * @return The memory, or NULL on failure
+ */
+void* qalam_frame_alloc(size_t size);
+
+/**
+ * @brief Get the current position of this thread's frame arena
+ */
+size_t qalam_frame_mark(void);
+
+/**
+ * @brief Drop everything allocated from the frame arena since a mark
+ *
+ * @param mark Position from qalam_frame_mark()
+ */
+void qalam_frame_rewind(size_t mark);
+
+/**
+ * @brief Empty this thread's frame arena
+ *
+ * qalam_dwrite_render_end() calls this after presenting. If the frame
+ * needed more than one block, the arena comes back as a single block
+ * large enough for it.
+ */
+void qalam_frame_reset(void);
+
+/**
+ * @brief Free this thread's frame arena
+ *
+ * A worker thread that used the arena calls this before it exits.
+ */
+void qalam_frame_release(void);
+
 /*=============================================================================
  * Initialization and Shutdown
  *============================================================================*/
@@ -195,6 +364,7 @@ typedef struct QalamInitOptions {
     bool enable_dpi_awareness;          /**< Enable per-monitor DPI awareness */
     bool enable_dark_mode;              /**< Request dark mode if available */
     const wchar_t* app_name;            /**< Application name for window class */
+    const QalamAllocator* allocator;    /**< Allocator to install, or NULL for the C runtime heap */
 } QalamInitOptions;
 
 /**
@@ -229,6 +399,191 @@ void qalam_shutdown(void);
  */
 bool qalam_is_initialized(void);
 
+/*=============================================================================
+ * Tracing
+ *
+ * Hot paths are marked with spans (a timed region) and counters. When
+ * built with QALAM_ENABLE_TRACING (CMake option QALAM_TRACING), every
+ * span and counter is written as a TraceLogging event of the "Qalam" ETW
+ * provider, {85574d3a-5ca4-541d-1e85-08af23a57c72} (the GUID tools derive
+ * from the name, so "*Qalam" works where a provider name is accepted),
+ * with the category's bit as its keyword; and the totals per category
+ * are kept for the tracing overlay. Otherwise the macros compile to
+ * nothing.
+ *
+ * Typical use:
+ *     QALAM_TRACE_BEGIN(span, QALAM_TRACE_BUFFER, "gap_move");
+ *     ...
+ *     QALAM_TRACE_END(span);
+ *============================================================================*/
+
+#ifndef QALAM_ENABLE_TRACING
+    #define QALAM_ENABLE_TRACING 0
+#endif
+
+/**
+ * @brief Subsystem a span or counter is charged to
+ */
+typedef enum QalamTraceCategory {
+    QALAM_TRACE_BUFFER = 0,             /**< Gap buffer moves and growth */
+    QALAM_TRACE_LAYOUT,                 /**< Text layout creation and shaping */
+    QALAM_TRACE_RENDER,                 /**< Ending and presenting frames */
+    QALAM_TRACE_TERMINAL,               /**< Applying terminal output (UI thread) */
+    QALAM_TRACE_TERMINAL_IO,            /**< Terminal reader thread */
+    QALAM_TRACE_SYNTAX,                 /**< Highlighter worker thread */
+    QALAM_TRACE_STARTUP,                /**< Startup phases and font loading */
+    QALAM_TRACE_CATEGORY_COUNT
+} QalamTraceCategory;
+
+/**
+ * @brief An open span (see QALAM_TRACE_BEGIN)
+ */
+typedef struct QalamTraceSpan {
+    const char* name;                   /**< Static name of the span */
+    QalamTraceCategory category;        /**< Category it is charged to */
+    int64_t start;                      /**< Performance counter at the start */
+} QalamTraceSpan;
+
+/**
+ * @brief What each category cost since the last qalam_trace_take_totals()
+ */
+typedef struct QalamTraceTotals {
+    uint64_t span_ns[QALAM_TRACE_CATEGORY_COUNT];   /**< Time in closed spans */
+    uint64_t spans[QALAM_TRACE_CATEGORY_COUNT];     /**< Spans closed */
+    int64_t counters[QALAM_TRACE_CATEGORY_COUNT];   /**< Sum of counter values */
+} QalamTraceTotals;
+
+/**
+ * @brief Register the ETW provider
+ *
+ * Spans are counted without it, but no events are written. Does
+ * nothing in builds without tracing.
+ *
+ * @return QALAM_OK on success, QALAM_ERROR_UNKNOWN if the provider could
+ *         not be registered
+ */
+QalamResult qalam_trace_init(void);
+
+/**
+ * @brief Unregister the ETW provider
+ */
+void qalam_trace_shutdown(void);
+
+/**
+ * @brief Check whether this build was made with tracing
+ */
+bool qalam_trace_is_available(void);
+
+/**
+ * @brief Open a span; prefer QALAM_TRACE_BEGIN
+ *
+ * @param[out] span Span to open
+ * @param category Category to charge it to
+ * @param name Name of the span (a string literal)
+ */
+void qalam_trace_span_begin(QalamTraceSpan* span, QalamTraceCategory category, const char* name);
+
+/**
+ * @brief Close a span, add it to its category and write its event;
+ *        prefer QALAM_TRACE_END
+ *
+ * Thread-safe.
+ *
+ * @param span Span opened by qalam_trace_span_begin()
+ */
+void qalam_trace_span_end(const QalamTraceSpan* span);
+
+/**
+ * @brief Add to a counter and write its event; prefer QALAM_TRACE_COUNTER
+ *
+ * Thread-safe.
+ *
+ * @param category Category to charge it to
+ * @param name Name of the counter (a string literal)
+ * @param value Amount, e.g. bytes moved
+ */
+void qalam_trace_counter(QalamTraceCategory category, const char* name, int64_t value);
+
+/**
+ * @brief Get the totals since the last call, and start new ones
+ *
+ * @param[out] totals Pointer to receive the totals
+ */
+void qalam_trace_take_totals(QalamTraceTotals* totals);
+
+/**
+ * @brief A point reached while the application starts
+ *
+ * Marked in roughly this order, though the worker-thread phases
+ * (FONTS_READY, FILE_LOADED) may land anywhere after DWRITE_INIT.
+ */
+typedef enum QalamStartupPhase {
+    QALAM_STARTUP_BEGIN = 0,            /**< Process entry; other phases are timed from here */
+    QALAM_STARTUP_DWRITE_INIT,          /**< DirectWrite and Direct2D factories created */
+    QALAM_STARTUP_WINDOW,               /**< Main window created */
+    QALAM_STARTUP_FIRST_PAINT,          /**< First frame presented (background only) */
+    QALAM_STARTUP_FONTS_READY,          /**< Font collection loaded and editor font resolved */
+    QALAM_STARTUP_FILE_LOADED,          /**< Initial file's first screen decoded */
+    QALAM_STARTUP_FIRST_TEXT,           /**< First frame with text presented */
+    QALAM_STARTUP_PHASE_COUNT
+} QalamStartupPhase;
+
+/**
+ * @brief When each startup phase was reached
+ */
+typedef struct QalamStartupTimings {
+    uint64_t phase_ns[QALAM_STARTUP_PHASE_COUNT];   /**< Time since BEGIN, 0 if not reached */
+    uint32_t reached;                               /**< Bit (1u << phase) per phase marked */
+} QalamStartupTimings;
+
+/**
+ * @brief Mark a startup phase as reached
+ *
+ * Only the first mark of each phase counts, so a phase may be marked
+ * from every place that can reach it. QALAM_STARTUP_BEGIN is implied by
+ * the first mark if it was never made. Each phase is written as a
+ * "StartupPhase" event of the QALAM_TRACE_STARTUP category, carrying
+ * its time since BEGIN. Marks are kept in builds without tracing too,
+ * for qalam_bench.
+ *
+ * Thread-safe.
+ *
+ * @param phase Phase reached
+ */
+void qalam_trace_startup_mark(QalamStartupPhase phase);
+
+/**
+ * @brief Get the time from BEGIN to each phase marked so far
+ *
+ * @param[out] timings Pointer to receive the timings
+ */
+void qalam_trace_get_startup(QalamStartupTimings* timings);
+
+/**
+ * @brief Forget all startup marks, to time another bring-up
+ */
+void qalam_trace_startup_reset(void);
+
+/**
+ * @brief Get a startup phase's name, e.g. "first_paint"
+ *
+ * @return Static string, "unknown" for an invalid phase
+ */
+const char* qalam_trace_startup_phase_name(QalamStartupPhase phase);
+
+#if QALAM_ENABLE_TRACING
+    #define QALAM_TRACE_BEGIN(span, category, name) \
+        QalamTraceSpan span; \
+        qalam_trace_span_begin(&span, (category), (name))
+    #define QALAM_TRACE_END(span) qalam_trace_span_end(&span)
+    #define QALAM_TRACE_COUNTER(category, name, value) \
+        qalam_trace_counter((category), (name), (int64_t)(value))
+#else
+    #define QALAM_TRACE_BEGIN(span, category, name) ((void)0)
+    #define QALAM_TRACE_END(span) ((void)0)
+    #define QALAM_TRACE_COUNTER(category, name, value) ((void)0)
+#endif
+
 /*=============================================================================
  * Utility Macros
  *============================================================================*/
@@ -41,6 +41,8 @@ typedef struct QalamTerminalOptions {
     bool inherit_handles;           /**< Inherit parent handles */
     bool enable_vt_processing;      /**< Enable VT/ANSI processing */
     bool start_hidden;              /**< Start process hidden */
+    size_t output_buffer_size;      /**< Output ring size in bytes (0 for the default) */
+    size_t scrollback_budget;       /**< Scrollback memory budget in bytes (0 for the default) */
 } QalamTerminalOptions;
 
 /**
@@ -63,11 +65,27 @@ typedef struct QalamTerminalInfo {
     DWORD process_id;               /**< Running process ID (0 if none) */
     DWORD exit_code;                /**< Exit code if process exited */
     bool has_pending_output;        /**< Output available to read */
+    uint64_t scrollback_rows;       /**< Rows held in the scrollback */
+    size_t scrollback_bytes;        /**< Memory the scrollback holds, in bytes */
 } QalamTerminalInfo;
 
+/**
+ * @brief A match found in the scrollback
+ */
+typedef struct QalamTerminalMatch {
+    uint64_t row;                   /**< Scrollback row of the match */
+    size_t column;                  /**< First cell of the match */
+    size_t cells;                   /**< Cells the match covers */
+} QalamTerminalMatch;
+
 /**
  * @brief Callback for terminal output
  * 
+ * Called from qalam_terminal_poll() on the thread that polls, with all
+ * output read since the previous poll: once, or twice when that output
+ * wraps around the end of the output ring. 'data' is only valid during
+ * the call.
+ * 
  * @param terminal The terminal that produced output
  * @param data Output data (UTF-8)
  * @param length Length of data in bytes
@@ -207,7 +225,14 @@ QalamResult qalam_terminal_write_string(QalamTerminal* terminal, const char* tex
 /**
  * @brief Read available output from the terminal
  * 
- * Non-blocking read of available output data.
+ * Non-blocking read of available output data. Output is read from the
+ * pseudoconsole by a background thread into a fixed-size ring; when the
+ * ring is full that thread stops reading until output is consumed, so a
+ * process writing faster than the terminal drains it is slowed down
+ * rather than buffered without limit.
+ * 
+ * Output read here bypasses the terminal's screen; use either this or
+ * qalam_terminal_poll(), not both.
  * 
  * @param terminal Source terminal
  * @param[out] buffer Buffer to receive data
@@ -226,6 +251,32 @@ QalamResult qalam_terminal_read(QalamTerminal* terminal, char* buffer,
  */
 bool qalam_terminal_has_output(const QalamTerminal* terminal);
 
+/**
+ * @brief Deliver pending output and notice process exit
+ * 
+ * Call once per frame from the thread that owns the terminal. Applies all
+ * output read since the previous call to the terminal's screen, hands
+ * the same batch to the output callback if one is set (see
+ * QalamTerminalOutputCallback), then reports a process that has exited
+ * through the state callback.
+ * 
+ * @param terminal Target terminal
+ * @param[out] bytes_delivered Bytes of output delivered (optional)
+ * @return QALAM_OK on success, error code on failure
+ */
+QalamResult qalam_terminal_poll(QalamTerminal* terminal, size_t* bytes_delivered);
+
+/**
+ * @brief Get an event that is set when output arrives
+ * 
+ * Auto-reset; wait on it together with the window's messages (e.g.
+ * MsgWaitForMultipleObjects()) to wake up for output without polling.
+ * 
+ * @param terminal Target terminal
+ * @return Event handle owned by the terminal, or NULL
+ */
+HANDLE qalam_terminal_get_output_waitable(const QalamTerminal* terminal);
+
 /**
  * @brief Send a signal/key to the terminal
  * 
@@ -251,6 +302,11 @@ QalamResult qalam_terminal_send_interrupt(QalamTerminal* terminal);
 /**
  * @brief Resize the terminal
  * 
+ * Reflows the lines on the terminal's screen to the new width, then
+ * resizes the pseudoconsole. Every cell is marked dirty, but a renderer
+ * caching shaped runs by their text (as the terminal view does) shapes
+ * only the runs the reflow actually split.
+ * 
  * @param terminal Target terminal
  * @param cols New column count
  * @param rows New row count
@@ -276,6 +332,44 @@ QalamResult qalam_terminal_get_size(const QalamTerminal* terminal, QalamTerminal
  */
 QalamResult qalam_terminal_get_info(const QalamTerminal* terminal, QalamTerminalInfo* info);
 
+/*=============================================================================
+ * Scrollback
+ *============================================================================*/
+
+/**
+ * @brief Find text in the scrollback
+ * 
+ * Rows are numbered from the first row that ever scrolled off the
+ * screen; rows dropped to stay within the scrollback budget are gone.
+ * Matches do not span rows. Forwards, the first match at or after
+ * 'column' of 'row' is found, then in later rows; backwards, the last
+ * match before 'column' (SIZE_MAX for the whole row), then in earlier
+ * rows. The text is searched without unpacking older rows.
+ * 
+ * @param terminal Target terminal
+ * @param text Text to find (UTF-8)
+ * @param length Length of text in bytes
+ * @param row Row to start at
+ * @param column Cell to start at
+ * @param backwards Search towards older rows
+ * @param ignore_case Fold A-Z onto a-z
+ * @param[out] match Receives the match
+ * @param[out] found Set to whether a match was found
+ * @return QALAM_OK on success, error code on failure
+ */
+QalamResult qalam_terminal_find_in_scrollback(QalamTerminal* terminal, const char* text,
+                                               size_t length, uint64_t row, size_t column,
+                                               bool backwards, bool ignore_case,
+                                               QalamTerminalMatch* match, bool* found);
+
+/**
+ * @brief Drop every row of the scrollback
+ * 
+ * @param terminal Target terminal
+ * @return QALAM_OK on success
+ */
+QalamResult qalam_terminal_clear_scrollback(QalamTerminal* terminal);
+
 /*=============================================================================
  * Callback Registration
  *============================================================================*/
@@ -1,10 +1,12 @@
 /**
  * @file buffer.c
- * @brief Qalam IDE - Gap Buffer Implementation
+ * @brief Qalam IDE - Text Buffer Implementation
  * 
- * Implements the text buffer using a gap buffer data structure.
- * All text is stored internally as UTF-16 (wchar_t) for Windows compatibility.
- * The public API accepts/returns UTF-8 encoded text.
+ * Implements the text buffer on top of one of two storage backends: a
+ * gap buffer (the default for ordinary files) or a piece table (for
+ * very large content). All text is stored internally as UTF-16
+ * (wchar_t) for Windows compatibility. The public API accepts/returns
+ * UTF-8 encoded text.
  * 
  * @version 0.0.1
  * @copyright (c) 2026 Qalam Project
@@ -15,6 +17,14 @@
 
 #include "editor.h"
 #include "qalam.h"
+#include "line_index.h"
+#include "piece_table.h"
+#include "mapped_file.h"
+#include "file_loader.h"
+#include "text_scan.h"
+#include "undo_journal.h"
+#include "search.h"
+#include "virtual_region.h"
 #include <stdlib.h>
 #include <string.h>
 #include <wchar.h>
@@ -35,37 +45,154 @@
 /** Maximum supported buffer size (100 MB in wchar_t) */
 #define QALAM_BUFFER_MAX_SIZE           (100 * 1024 * 1024 / sizeof(wchar_t))
 
+/** Maximum file size the gap buffer backend will load (100 MB) */
+#define QALAM_BUFFER_MAX_FILE_SIZE      (100 * 1024 * 1024)
+
+/** Default content size (UTF-8 bytes) at which AUTO picks the piece table */
+#define QALAM_BUFFER_LARGE_CONTENT      (32 * 1024 * 1024)
+
+/** Bytes read per call when decoding a file into a piece table */
+#define QALAM_BUFFER_READ_CHUNK_SIZE    (1024 * 1024)
+
+/** Size of each of the two UTF-8 staging buffers used when saving */
+#define QALAM_BUFFER_SAVE_CHUNK_SIZE    (1024 * 1024)
+
+/** Convert at least this many wchar_t per step, or write the chunk first */
+#define QALAM_BUFFER_SAVE_MIN_STEP      4096
+
+/** Suffix of the temporary file a save is written to */
+#define QALAM_BUFFER_SAVE_SUFFIX        L".qalam-save"
+
+/** Initial number of edits (and line lengths) an edit transaction holds */
+#define QALAM_BUFFER_EDIT_INITIAL       64
+
+/** Untouched lines between two transaction edits that still share one index update */
+#define QALAM_BUFFER_EDIT_CLUSTER_LINES 1024
+
 /*=============================================================================
  * Internal Buffer Structure
  *============================================================================*/
 
 /**
- * @brief Internal gap buffer structure
+ * @brief One replacement queued in an edit transaction
+ */
+typedef struct BufferEdit {
+    size_t start;               /**< Start of the replaced range */
+    size_t end;                 /**< End of the replaced range (exclusive) */
+    size_t text;                /**< Offset of the replacement in the batch text */
+    size_t length;              /**< Replacement length in wchar_t units */
+} BufferEdit;
+
+/**
+ * @brief Line index update for a cluster of nearby edits
+ */
+typedef struct BufferEditCluster {
+    size_t first_line;          /**< First line touched, before the edits */
+    size_t old_count;           /**< Lines replaced */
+    size_t lens;                /**< Offset of the new line lengths in the batch */
+    size_t new_count;           /**< Number of new lines */
+} BufferEditCluster;
+
+/**
+ * @brief Edit transaction (qalam_buffer_begin_edit)
+ */
+typedef struct BufferEditBatch {
+    bool open;                  /**< A transaction is being collected */
+    BufferEdit* edits;          /**< Queued edits in document order */
+    size_t edit_count;          /**< Edits in use */
+    size_t edit_capacity;       /**< Allocated edits */
+    wchar_t* text;              /**< Replacement text, converted to UTF-16 */
+    size_t text_length;         /**< Text in use */
+    size_t text_capacity;       /**< Allocated text */
+    size_t* lens;               /**< New line lengths of all clusters */
+    size_t lens_count;          /**< Lengths in use */
+    size_t lens_capacity;       /**< Allocated lengths */
+    BufferEditCluster* clusters; /**< Line index updates, in document order */
+    size_t cluster_count;       /**< Clusters in use */
+    size_t cluster_capacity;    /**< Allocated clusters */
+} BufferEditBatch;
+
+/**
+ * @brief Internal buffer structure
  * 
- * The gap buffer stores text in a contiguous array with a "gap" of unused
- * space at the cursor position. This allows O(1) insertions and deletions
- * at the cursor, with O(n) cost to move the cursor.
+ * With the gap buffer backend, text is stored in a contiguous array with
+ * a "gap" of unused space. The gap follows the cursor lazily: it is moved
+ * there by the next edit, which makes insertions and deletions at the
+ * cursor O(1), with O(n) cost for the first edit after a jump. Views may
+ * also move the gap out of a line without touching the cursor.
  * 
  * Layout: [text before gap][---GAP---][text after gap]
  *         ^                ^          ^               ^
  *         0            gap_start   gap_end        capacity
+ * 
+ * A gap buffer created with virtual_memory keeps 'data' in a reserved
+ * range ('vm') of the largest size the buffer may reach; the gap is the
+ * range's uncommitted middle, pages are committed as text lands in them,
+ * and growing never copies. Otherwise 'data' is on the heap.
+ * 
+ * With the piece table backend, the gap fields are unused and the text
+ * lives in 'pieces'. Both backends track the cursor in cursor_offset.
+ * 
+ * A hibernated buffer keeps everything but its text storage, which is
+ * encoded into 'hibernated_text': a gap buffer's data is NULL with an
+ * empty gap at the end (so the content length is still capacity), and a
+ * piece table's owned original and add buffer are NULL with their
+ * lengths kept. Public functions that read or edit the text wake it
+ * first with buffer_wake().
  */
 struct QalamBuffer {
+    QalamBufferBackend backend; /**< Storage backend (GAP or PIECE_TABLE) */
+    
+    /* Gap buffer storage */
     wchar_t* data;              /**< The buffer array */
     size_t capacity;            /**< Total allocated size in wchar_t */
-    size_t gap_start;           /**< Start of gap (cursor position) */
+    size_t gap_start;           /**< Start of gap */
     size_t gap_end;             /**< End of gap (exclusive) */
+    VirtualRegion vm;           /**< Reserved storage behind 'data', or base NULL */
+    
+    /* Piece table storage */
+    PieceTable pieces;          /**< Original + add buffers and piece treap */
+    size_t cursor_offset;       /**< Cursor position in wchar_t units */
+    MappedFile* mapped;         /**< Lazily decoded original text, or NULL */
+    FileLoader* loader;         /**< Original text loading in the background, or NULL */
+    
+    /* View storage */
+    wchar_t* view_copy;         /**< Copy of a view that storage splits too often */
+    size_t view_copy_capacity;  /**< Allocated size of view_copy in wchar_t */
+    
+    /* Hibernation */
+    bool hibernated;            /**< Text storage is released; the text is in 'hibernated_text' */
+    bool hibernated_virtual;    /**< The released gap storage was a VirtualRegion */
+    char* hibernated_text;      /**< Text storage as UTF-8, or NULL when empty */
+    size_t hibernated_size;     /**< Bytes in hibernated_text */
+    size_t hibernated_original; /**< Bytes of it that are the piece table's original */
+    size_t hibernated_utf8;     /**< UTF-8 size of the document */
     
     /* Cursor state */
     size_t cursor_line;         /**< Current line (0-based) */
     size_t cursor_column;       /**< Current column (0-based) */
     
     /* Line tracking */
-    size_t line_count;          /**< Number of lines (at least 1) */
+    LineIndex lines;            /**< Line start index (at least 1 line) */
     
     /* Selection state */
     QalamSelection selection;   /**< Current selection */
     
+    /* Edit history */
+    UndoJournal undo;           /**< Undo/redo groups and deleted text */
+    BufferEditBatch batch;      /**< Open edit transaction */
+    
+    /* Change notification */
+    QalamBufferChangeCallback change_callback; /**< Change callback, or NULL */
+    void* change_user_data;     /**< Context for change_callback */
+    QalamBufferChange change;   /**< Lines changed since the last notification */
+    bool change_pending;        /**< 'change' holds an unreported change */
+    
+    /* Search state */
+    SearchPattern search;       /**< Pattern of the last qalam_buffer_find() */
+    QalamSearchOptions search_options; /**< Options of the last qalam_buffer_find() */
+    size_t search_next;         /**< Where qalam_buffer_find_next() starts */
+    
     /* File metadata */
     wchar_t filepath[MAX_PATH]; /**< Associated file path */
     bool modified;              /**< Has unsaved changes */
@@ -76,15 +203,31 @@ struct QalamBuffer {
  * Internal Helper Functions - Forward Declarations
  *============================================================================*/
 
+static inline bool buffer_is_piece_table(const QalamBuffer* buffer);
+static inline PieceTable* buffer_undo_table(QalamBuffer* buffer);
 static inline size_t buffer_gap_size(const QalamBuffer* buffer);
 static inline size_t buffer_content_length(const QalamBuffer* buffer);
+static inline size_t buffer_cursor_offset(const QalamBuffer* buffer);
 static size_t buffer_logical_to_physical(const QalamBuffer* buffer, size_t pos);
 static wchar_t buffer_char_at_internal(const QalamBuffer* buffer, size_t pos);
-static void buffer_move_gap_to(QalamBuffer* buffer, size_t pos);
+static void buffer_copy_range(const QalamBuffer* buffer, size_t pos, size_t len, wchar_t* out);
+static bool buffer_for_each_segment(const QalamBuffer* buffer, size_t pos, size_t len,
+                                    PieceSegmentFn fn, void* context);
+static QalamResult buffer_move_gap_to(QalamBuffer* buffer, size_t pos);
+static void buffer_move_cursor_to(QalamBuffer* buffer, size_t pos);
 static QalamResult buffer_ensure_gap_size(QalamBuffer* buffer, size_t needed);
-static void buffer_update_line_count(QalamBuffer* buffer);
-static size_t buffer_count_newlines_in_range(const QalamBuffer* buffer, size_t start, size_t len);
+static QalamResult buffer_remove_range(QalamBuffer* buffer, size_t pos, size_t len,
+                                       PieceNode** out_span);
+static inline size_t buffer_line_count(const QalamBuffer* buffer);
+static void buffer_note_lines(QalamBuffer* buffer, size_t first, size_t old_count, size_t new_count);
+static void buffer_note_edit(QalamBuffer* buffer, size_t pos, size_t lines_before);
+static void buffer_flush_change(QalamBuffer* buffer);
+static void buffer_batch_free(BufferEditBatch* batch);
+static QalamResult buffer_wake(const QalamBuffer* buffer);
+static void buffer_free_view_copy(QalamBuffer* buffer);
+static void buffer_free_hibernated(QalamBuffer* buffer);
 static void buffer_update_cursor_from_offset(QalamBuffer* buffer);
+static void buffer_advance_cursor(QalamBuffer* buffer, const wchar_t* text, size_t len, size_t newlines);
 static size_t buffer_offset_from_line_column(const QalamBuffer* buffer, size_t line, size_t column);
 static size_t buffer_get_line_start_offset(const QalamBuffer* buffer, size_t line);
 static size_t buffer_get_line_length(const QalamBuffer* buffer, size_t line);
@@ -97,6 +240,13 @@ static int utf16_to_utf8(const wchar_t* utf16, size_t utf16_len, char* utf8, siz
  * Internal Helper Functions - Implementation
  *============================================================================*/
 
+/**
+ * @brief Check whether the buffer uses the piece table backend
+ */
+static inline bool buffer_is_piece_table(const QalamBuffer* buffer) {
+    return buffer->backend == QALAM_BUFFER_BACKEND_PIECE_TABLE;
+}
+
 /**
  * @brief Get the current gap size
  */
@@ -108,9 +258,19 @@ static inline size_t buffer_gap_size(const QalamBuffer* buffer) {
  * @brief Get the content length (excluding gap)
  */
 static inline size_t buffer_content_length(const QalamBuffer* buffer) {
+    if (buffer_is_piece_table(buffer)) {
+        return piece_table_length(&buffer->pieces);
+    }
     return buffer->capacity - buffer_gap_size(buffer);
 }
 
+/**
+ * @brief Get the cursor position in wchar_t units
+ */
+static inline size_t buffer_cursor_offset(const QalamBuffer* buffer) {
+    return buffer->cursor_offset;
+}
+
 /**
  * @brief Convert logical position to physical position in buffer array
  */
@@ -126,10 +286,275 @@ static size_t buffer_logical_to_physical(const QalamBuffer* buffer, size_t pos)
  * @brief Get character at logical position (internal, no bounds check)
  */
 static wchar_t buffer_char_at_internal(const QalamBuffer* buffer, size_t pos) {
+    if (buffer_is_piece_table(buffer)) {
+        return piece_table_char_at(&buffer->pieces, pos);
+    }
     size_t phys = buffer_logical_to_physical(buffer, pos);
     return buffer->data[phys];
 }
 
+/**
+ * @brief Visit the contiguous runs of text covering a range, in order
+ * 
+ * The gap buffer yields at most two runs (before and after the gap).
+ * 
+ * @return false if the callback stopped the iteration early
+ */
+static bool buffer_for_each_segment(const QalamBuffer* buffer, size_t pos, size_t len,
+                                    PieceSegmentFn fn, void* context) {
+    if (buffer_is_piece_table(buffer)) {
+        return piece_table_for_each_segment(&buffer->pieces, pos, len, fn, context);
+    }
+    
+    size_t end = pos + len;
+    if (pos < buffer->gap_start) {
+        size_t before_end = end < buffer->gap_start ? end : buffer->gap_start;
+        if (!fn(buffer->data + pos, before_end - pos, context)) {
+            return false;
+        }
+        pos = before_end;
+    }
+    if (pos < end) {
+        return fn(buffer->data + buffer_logical_to_physical(buffer, pos), end - pos, context);
+    }
+    return true;
+}
+
+/**
+ * @brief Segment callback used by buffer_copy_range()
+ */
+static bool buffer_copy_segment(const wchar_t* text, size_t len, void* context) {
+    wchar_t** out = (wchar_t**)context;
+    memcpy(*out, text, len * sizeof(wchar_t));
+    *out += len;
+    return true;
+}
+
+/**
+ * @brief Copy a logical range into a caller buffer (no bounds check)
+ */
+static void buffer_copy_range(const QalamBuffer* buffer, size_t pos, size_t len, wchar_t* out) {
+    buffer_for_each_segment(buffer, pos, len, buffer_copy_segment, &out);
+}
+
+/**
+ * @brief UTF-8 length accumulated across segments
+ * 
+ * A surrogate pair may straddle two segments, so a pending high
+ * surrogate is carried over to the next one.
+ */
+typedef struct Utf8Length {
+    size_t bytes;               /**< UTF-8 bytes so far */
+    bool pending_high;          /**< Last unit seen was a high surrogate */
+} Utf8Length;
+
+/**
+ * @brief Segment callback that counts UTF-8 bytes
+ * 
+ * Unpaired surrogates count as U+FFFD (3 bytes), which is what
+ * WideCharToMultiByte produces for them.
+ */
+static bool buffer_count_utf8_segment(const wchar_t* text, size_t len, void* context) {
+    Utf8Length* count = (Utf8Length*)context;
+    
+    for (size_t i = 0; i < len; i++) {
+        wchar_t ch = text[i];
+        
+        if (count->pending_high) {
+            count->pending_high = false;
+            if (is_low_surrogate(ch)) {
+                count->bytes += 4;
+                continue;
+            }
+            count->bytes += 3;
+        }
+        
+        if (ch < 0x80) {
+            count->bytes += 1;
+        } else if (ch < 0x800) {
+            count->bytes += 2;
+        } else if (is_high_surrogate(ch)) {
+            count->pending_high = true;
+        } else {
+            count->bytes += 3;
+        }
+    }
+    
+    return true;
+}
+
+/**
+ * @brief Get the UTF-8 size of a logical range without copying it
+ */
+static size_t buffer_utf8_length(const QalamBuffer* buffer, size_t pos, size_t len) {
+    Utf8Length count = { 0, false };
+    buffer_for_each_segment(buffer, pos, len, buffer_count_utf8_segment, &count);
+    return count.bytes + (count.pending_high ? 3 : 0);
+}
+
+/**
+ * @brief UTF-8 output written across segments
+ * 
+ * As with Utf8Length, a high surrogate ending one segment is held back
+ * until the next segment shows whether it is paired.
+ */
+typedef struct Utf8Writer {
+    char* out;                  /**< Output start */
+    size_t size;                /**< Output capacity in bytes */
+    size_t written;             /**< Bytes written so far */
+    wchar_t pending_high;       /**< Held-back high surrogate, or 0 */
+    bool failed;                /**< Conversion failed or output too small */
+} Utf8Writer;
+
+/**
+ * @brief Append converted UTF-16 text to a writer
+ */
+static bool buffer_write_utf8(Utf8Writer* writer, const wchar_t* text, size_t len) {
+    if (len == 0) {
+        return true;
+    }
+    
+    /* A size of 0 would make WideCharToMultiByte only measure */
+    int converted = 0;
+    if (writer->written < writer->size) {
+        converted = utf16_to_utf8(text, len, writer->out + writer->written,
+                                  writer->size - writer->written);
+    }
+    if (converted <= 0) {
+        writer->failed = true;
+        return false;
+    }
+    
+    writer->written += (size_t)converted;
+    return true;
+}
+
+/**
+ * @brief Segment callback that converts text into a Utf8Writer
+ */
+static bool buffer_write_utf8_segment(const wchar_t* text, size_t len, void* context) {
+    Utf8Writer* writer = (Utf8Writer*)context;
+    
+    if (len == 0) {
+        return true;
+    }
+    
+    if (writer->pending_high) {
+        wchar_t pair[2] = { writer->pending_high, text[0] };
+        bool paired = is_low_surrogate(text[0]);
+        writer->pending_high = 0;
+        if (!buffer_write_utf8(writer, pair, paired ? 2 : 1)) {
+            return false;
+        }
+        if (paired) {
+            text++;
+            len--;
+        }
+    }
+    
+    if (len > 0 && is_high_surrogate(text[len - 1])) {
+        writer->pending_high = text[len - 1];
+        len--;
+    }
+    
+    return buffer_write_utf8(writer, text, len);
+}
+
+/**
+ * @brief Convert a logical range straight into a caller's UTF-8 buffer
+ * 
+ * Converts segment by segment, without an intermediate UTF-16 copy. The
+ * output is always null-terminated.
+ */
+static QalamResult buffer_range_to_utf8(const QalamBuffer* buffer, size_t pos, size_t len,
+                                        char* out_text, size_t out_size, size_t* bytes_written) {
+    Utf8Writer writer = { out_text, out_size - 1, 0, 0, false };
+    
+    buffer_for_each_segment(buffer, pos, len, buffer_write_utf8_segment, &writer);
+    if (!writer.failed && writer.pending_high) {
+        buffer_write_utf8(&writer, &writer.pending_high, 1);
+    }
+    
+    if (writer.failed) {
+        writer.written = 0;
+    }
+    out_text[writer.written] = '\0';
+    if (bytes_written) {
+        *bytes_written = writer.written;
+    }
+    
+    return writer.failed ? QALAM_ERROR_ENCODING : QALAM_OK;
+}
+
+/**
+ * @brief Segment callback that fills a QalamTextView
+ * 
+ * Stops once every view slot is used.
+ */
+static bool buffer_view_segment(const wchar_t* text, size_t len, void* context) {
+    QalamTextView* view = (QalamTextView*)context;
+    
+    if (view->segment_count == QALAM_TEXT_VIEW_MAX_SEGMENTS) {
+        return false;
+    }
+    
+    view->segments[view->segment_count] = text;
+    view->lengths[view->segment_count] = len;
+    view->segment_count++;
+    view->length += len;
+    return true;
+}
+
+/**
+ * @brief Build a view of a logical range (no bounds check)
+ * 
+ * The gap buffer always fits in two segments; with 'contiguous' the gap
+ * is moved to whichever end of the range is closer. Piece table ranges
+ * split into more pieces than the view holds are copied into view_copy,
+ * which is reused from call to call.
+ */
+static QalamResult buffer_get_view(QalamBuffer* buffer, size_t pos, size_t len,
+                                   bool contiguous, QalamTextView* view) {
+    memset(view, 0, sizeof(QalamTextView));
+    if (len == 0) {
+        return QALAM_OK;
+    }
+    
+    size_t end = pos + len;
+    if (contiguous && !buffer_is_piece_table(buffer) &&
+        pos < buffer->gap_start && buffer->gap_start < end) {
+        bool to_start = buffer->gap_start - pos <= end - buffer->gap_start;
+        QalamResult result = buffer_move_gap_to(buffer, to_start ? pos : end);
+        if (result != QALAM_OK) {
+            return result;
+        }
+    }
+    
+    if (buffer_for_each_segment(buffer, pos, len, buffer_view_segment, view) &&
+        (!contiguous || view->segment_count == 1)) {
+        return QALAM_OK;
+    }
+    
+    if (len > buffer->view_copy_capacity) {
+        wchar_t* copy = (wchar_t*)qalam_mem_realloc(QALAM_MEMORY_BUFFER,
+                                                    buffer->view_copy, len * sizeof(wchar_t));
+        if (!copy) {
+            memset(view, 0, sizeof(QalamTextView));
+            return QALAM_ERROR_OUT_OF_MEMORY;
+        }
+        buffer->view_copy = copy;
+        buffer->view_copy_capacity = len;
+    }
+    buffer_copy_range(buffer, pos, len, buffer->view_copy);
+    
+    memset(view, 0, sizeof(QalamTextView));
+    view->segments[0] = buffer->view_copy;
+    view->lengths[0] = len;
+    view->segment_count = 1;
+    view->length = len;
+    return QALAM_OK;
+}
+
 /**
  * @brief Check if character is a high surrogate (UTF-16)
  */
@@ -144,21 +569,64 @@ static bool is_low_surrogate(wchar_t ch) {
     return (ch >= 0xDC00 && ch <= 0xDFFF);
 }
 
+/**
+ * @brief Check whether the gap buffer lives in reserved virtual memory
+ */
+static inline bool buffer_is_virtual(const QalamBuffer* buffer) {
+    return buffer->vm.base != NULL;
+}
+
+/**
+ * @brief Make physical range [start, end) of a virtual gap buffer writable
+ * 
+ * Does nothing for heap storage, which is all writable.
+ */
+static QalamResult buffer_commit(QalamBuffer* buffer, size_t start, size_t end) {
+    if (!buffer_is_virtual(buffer) || start >= end) {
+        return QALAM_OK;
+    }
+    return virtual_region_commit(&buffer->vm, start * sizeof(wchar_t),
+                                 (end - start) * sizeof(wchar_t));
+}
+
+/**
+ * @brief Return the middle of a wide gap to the system
+ * 
+ * Called after the gap widened or moved, so a far gap move or a large
+ * deletion does not leave the vacated pages committed.
+ */
+static void buffer_trim_gap(QalamBuffer* buffer) {
+    if (buffer_is_virtual(buffer)) {
+        virtual_region_trim(&buffer->vm, buffer->gap_start * sizeof(wchar_t),
+                            buffer->gap_end * sizeof(wchar_t));
+    }
+}
+
 /**
  * @brief Move the gap to a specific logical position
  * 
  * This is the key operation that makes cursor-local operations O(1).
+ * Only a virtual gap buffer can fail, when the pages the text moves to
+ * cannot be committed.
  */
-static void buffer_move_gap_to(QalamBuffer* buffer, size_t pos) {
+static QalamResult buffer_move_gap_to(QalamBuffer* buffer, size_t pos) {
     if (pos == buffer->gap_start) {
-        return; /* Already there */
+        return QALAM_OK; /* Already there */
     }
     
     size_t gs = buffer_gap_size(buffer);
+    size_t move_count = pos < buffer->gap_start ? buffer->gap_start - pos
+                                                : pos - buffer->gap_start;
+    QalamResult result = pos < buffer->gap_start
+        ? buffer_commit(buffer, buffer->gap_end - move_count, buffer->gap_end)
+        : buffer_commit(buffer, buffer->gap_start, buffer->gap_start + move_count);
+    if (result != QALAM_OK) {
+        return result;
+    }
     
+    QALAM_TRACE_BEGIN(span, QALAM_TRACE_BUFFER, "gap_move");
     if (pos < buffer->gap_start) {
         /* Move gap left: shift text right into gap */
-        size_t move_count = buffer->gap_start - pos;
         memmove(
             buffer->data + buffer->gap_end - move_count,
             buffer->data + pos,
@@ -168,7 +636,6 @@ static void buffer_move_gap_to(QalamBuffer* buffer, size_t pos) {
         buffer->gap_end = pos + gs;
     } else {
         /* Move gap right: shift text left into gap */
-        size_t move_count = pos - buffer->gap_start;
         memmove(
             buffer->data + buffer->gap_start,
             buffer->data + buffer->gap_end,
@@ -177,39 +644,32 @@ static void buffer_move_gap_to(QalamBuffer* buffer, size_t pos) {
         buffer->gap_start = pos;
         buffer->gap_end = pos + gs;
     }
+    
+    buffer_trim_gap(buffer);
+    QALAM_TRACE_COUNTER(QALAM_TRACE_BUFFER, "gap_move_bytes", move_count * sizeof(wchar_t));
+    QALAM_TRACE_END(span);
+    return QALAM_OK;
 }
 
 /**
- * @brief Ensure gap has at least 'needed' space
+ * @brief Move the cursor to a logical position
  * 
- * If gap is too small, reallocate buffer with doubled capacity plus growth increment.
+ * Only the offset is recorded; the gap buffer moves its gap when the
+ * next edit needs it there.
  */
-static QalamResult buffer_ensure_gap_size(QalamBuffer* buffer, size_t needed) {
-    size_t current_gap = buffer_gap_size(buffer);
-    
-    if (current_gap >= needed) {
-        return QALAM_OK;
-    }
-    
-    /* Calculate new capacity: double current, plus ensure enough for needed + growth */
-    size_t content_len = buffer_content_length(buffer);
-    size_t new_capacity = buffer->capacity * 2;
-    size_t min_capacity = content_len + needed + QALAM_BUFFER_GAP_GROW_SIZE;
-    
-    if (new_capacity < min_capacity) {
-        new_capacity = min_capacity;
-    }
-    
-    /* Check maximum size */
-    if (new_capacity > QALAM_BUFFER_MAX_SIZE) {
-        if (min_capacity > QALAM_BUFFER_MAX_SIZE) {
-            return QALAM_ERROR_OUT_OF_MEMORY;
-        }
-        new_capacity = QALAM_BUFFER_MAX_SIZE;
-    }
-    
-    /* Allocate new buffer */
-    wchar_t* new_data = (wchar_t*)malloc(new_capacity * sizeof(wchar_t));
+static void buffer_move_cursor_to(QalamBuffer* buffer, size_t pos) {
+    buffer->cursor_offset = pos;
+}
+
+/**
+ * @brief Move heap gap buffer text into an array of a new capacity
+ * 
+ * The gap stays where it is and takes up the difference, so
+ * 'new_capacity' must be at least the content length.
+ */
+static QalamResult buffer_resize_gap(QalamBuffer* buffer, size_t new_capacity) {
+    wchar_t* new_data = (wchar_t*)qalam_mem_alloc(QALAM_MEMORY_BUFFER,
+                                                  new_capacity * sizeof(wchar_t));
     if (!new_data) {
         return QALAM_ERROR_OUT_OF_MEMORY;
     }
@@ -230,142 +690,193 @@ static QalamResult buffer_ensure_gap_size(QalamBuffer* buffer, size_t needed) {
     }
     
     /* Update buffer */
-    free(buffer->data);
+    qalam_mem_free(buffer->data);
     buffer->data = new_data;
     buffer->gap_end = new_capacity - after_gap_len;
     buffer->capacity = new_capacity;
-    
     return QALAM_OK;
 }
 
 /**
- * @brief Count newlines in buffer content
+ * @brief Ensure gap has at least 'needed' space
+ * 
+ * If gap is too small, reallocate buffer with doubled capacity plus growth
+ * increment. A virtual gap buffer already spans its largest size, so it
+ * only commits the first 'needed' characters of the gap.
  */
-static void buffer_update_line_count(QalamBuffer* buffer) {
-    size_t count = 1; /* At least one line */
-    size_t len = buffer_content_length(buffer);
+static QalamResult buffer_ensure_gap_size(QalamBuffer* buffer, size_t needed) {
+    size_t current_gap = buffer_gap_size(buffer);
     
-    for (size_t i = 0; i < len; i++) {
-        wchar_t ch = buffer_char_at_internal(buffer, i);
-        if (ch == L'\n') {
-            count++;
+    if (buffer_is_virtual(buffer)) {
+        if (current_gap < needed) {
+            return QALAM_ERROR_OUT_OF_MEMORY;
         }
+        return buffer_commit(buffer, buffer->gap_start, buffer->gap_start + needed);
     }
     
-    buffer->line_count = count;
-}
-
-/**
- * @brief Count newlines in a range of buffer content
- */
-static size_t buffer_count_newlines_in_range(const QalamBuffer* buffer, size_t start, size_t len) {
-    size_t count = 0;
-    size_t end = start + len;
+    if (current_gap >= needed) {
+        return QALAM_OK;
+    }
+    
+    /* Calculate new capacity: double current, plus ensure enough for needed + growth */
     size_t content_len = buffer_content_length(buffer);
+    size_t new_capacity = buffer->capacity * 2;
+    size_t min_capacity = content_len + needed + QALAM_BUFFER_GAP_GROW_SIZE;
     
-    if (end > content_len) {
-        end = content_len;
+    if (new_capacity < min_capacity) {
+        new_capacity = min_capacity;
     }
     
-    for (size_t i = start; i < end; i++) {
-        if (buffer_char_at_internal(buffer, i) == L'\n') {
-            count++;
+    /* Check maximum size */
+    if (new_capacity > QALAM_BUFFER_MAX_SIZE) {
+        if (min_capacity > QALAM_BUFFER_MAX_SIZE) {
+            return QALAM_ERROR_OUT_OF_MEMORY;
         }
+        new_capacity = QALAM_BUFFER_MAX_SIZE;
     }
     
-    return count;
+    QALAM_TRACE_BEGIN(span, QALAM_TRACE_BUFFER, "gap_grow");
+    QalamResult result = buffer_resize_gap(buffer, new_capacity);
+    QALAM_TRACE_COUNTER(QALAM_TRACE_BUFFER, "gap_grow_bytes", new_capacity * sizeof(wchar_t));
+    QALAM_TRACE_END(span);
+    return result;
 }
 
 /**
- * @brief Update cursor line/column from gap_start position
+ * @brief Remove a logical range from storage and the line index
+ * 
+ * Leaves the cursor offset at 'pos'. A range ending at the gap (e.g.
+ * repeated backspace) shrinks the gap from the left without moving any
+ * text; other ranges move the gap to 'pos' and grow it to the right.
+ * With the piece table, 'out_span' (if not NULL) receives the removed
+ * pieces instead of them being released.
  */
-static void buffer_update_cursor_from_offset(QalamBuffer* buffer) {
-    size_t line = 0;
-    size_t col = 0;
+static QalamResult buffer_remove_range(QalamBuffer* buffer, size_t pos, size_t len,
+                                       PieceNode** out_span) {
+    size_t lines_before = buffer_line_count(buffer);
+    QalamResult result;
     
-    for (size_t i = 0; i < buffer->gap_start; i++) {
-        wchar_t ch = buffer_char_at_internal(buffer, i);
-        if (ch == L'\n') {
-            line++;
-            col = 0;
-        } else {
-            col++;
+    if (buffer_is_piece_table(buffer)) {
+        result = out_span ? piece_table_detach(&buffer->pieces, pos, len, out_span)
+                          : piece_table_delete(&buffer->pieces, pos, len);
+        if (result != QALAM_OK) {
+            return result;
         }
+        buffer->cursor_offset = pos;
+        result = line_index_delete(&buffer->lines, pos, len);
+        if (result == QALAM_OK) {
+            buffer_note_edit(buffer, pos, lines_before);
+        }
+        return result;
     }
     
-    buffer->cursor_line = line;
-    buffer->cursor_column = col;
-}
-
-/**
- * @brief Get offset from line and column
- */
-static size_t buffer_offset_from_line_column(const QalamBuffer* buffer, size_t line, size_t column) {
-    size_t current_line = 0;
-    size_t offset = 0;
-    size_t len = buffer_content_length(buffer);
-    
-    /* Find start of target line */
-    while (current_line < line && offset < len) {
-        if (buffer_char_at_internal(buffer, offset) == L'\n') {
-            current_line++;
+    /* Bring the gap to the range first: moving it is harmless if the
+     * index update then fails */
+    bool at_gap = pos + len == buffer->gap_start;
+    if (!at_gap) {
+        result = buffer_move_gap_to(buffer, pos);
+        if (result != QALAM_OK) {
+            return result;
         }
-        offset++;
     }
     
-    /* Move to column */
-    size_t col = 0;
-    while (col < column && offset < len) {
-        wchar_t ch = buffer_char_at_internal(buffer, offset);
-        if (ch == L'\n') {
-            break; /* Don't go past end of line */
-        }
-        offset++;
-        col++;
+    /* Remove deleted lines from the line index */
+    result = line_index_delete(&buffer->lines, pos, len);
+    if (result != QALAM_OK) {
+        return result;
+    }
+    
+    if (at_gap) {
+        buffer->gap_start = pos;
+    } else {
+        buffer->gap_end += len;
     }
+    buffer_trim_gap(buffer);
+    buffer->cursor_offset = pos;
+    buffer_note_edit(buffer, pos, lines_before);
     
-    return offset;
+    return QALAM_OK;
 }
 
 /**
- * @brief Get the offset of the start of a line
+ * @brief Get the number of lines (at least 1)
  */
-static size_t buffer_get_line_start_offset(const QalamBuffer* buffer, size_t line) {
-    if (line == 0) {
-        return 0;
-    }
-    
-    size_t current_line = 0;
-    size_t offset = 0;
-    size_t len = buffer_content_length(buffer);
-    
-    while (offset < len && current_line < line) {
-        if (buffer_char_at_internal(buffer, offset) == L'\n') {
-            current_line++;
-        }
-        offset++;
+static inline size_t buffer_line_count(const QalamBuffer* buffer) {
+    return line_index_line_count(&buffer->lines);
+}
+
+/**
+ * @brief Update cursor line/column from the cursor offset
+ * 
+ * Uses the line index, so the cost is O(log n) regardless of where
+ * the cursor is. Edits that know the span they touched should use
+ * buffer_advance_cursor() instead.
+ */
+static void buffer_update_cursor_from_offset(QalamBuffer* buffer) {
+    size_t line_start;
+    size_t offset = buffer_cursor_offset(buffer);
+    size_t line = line_index_line_from_offset(&buffer->lines, offset, &line_start);
+    
+    buffer->cursor_line = line;
+    buffer->cursor_column = offset - line_start;
+}
+
+/**
+ * @brief Move cursor line/column forward over text just inserted before it
+ * 
+ * Only the inserted span is examined: when it contains newlines the new
+ * column is the distance from the last one, otherwise the column grows
+ * by the span length.
+ */
+static void buffer_advance_cursor(QalamBuffer* buffer, const wchar_t* text, size_t len, size_t newlines) {
+    if (newlines == 0) {
+        buffer->cursor_column += len;
+        return;
+    }
+    
+    size_t col = 0;
+    while (col < len && text[len - 1 - col] != L'\n') {
+        col++;
+    }
+    
+    buffer->cursor_line += newlines;
+    buffer->cursor_column = col;
+}
+
+/**
+ * @brief Get offset from line and column
+ */
+static size_t buffer_offset_from_line_column(const QalamBuffer* buffer, size_t line, size_t column) {
+    size_t line_len = buffer_get_line_length(buffer, line);
+    
+    /* Don't go past end of line */
+    if (column > line_len) {
+        column = line_len;
     }
     
-    return offset;
+    return buffer_get_line_start_offset(buffer, line) + column;
+}
+
+/**
+ * @brief Get the offset of the start of a line
+ */
+static size_t buffer_get_line_start_offset(const QalamBuffer* buffer, size_t line) {
+    if (line >= buffer_line_count(buffer)) {
+        return buffer_content_length(buffer);
+    }
+    
+    return line_index_line_start(&buffer->lines, line);
 }
 
 /**
  * @brief Get the length of a line (excluding newline)
  */
 static size_t buffer_get_line_length(const QalamBuffer* buffer, size_t line) {
-    size_t start = buffer_get_line_start_offset(buffer, line);
-    size_t len = buffer_content_length(buffer);
-    size_t line_len = 0;
-    
-    while (start + line_len < len) {
-        wchar_t ch = buffer_char_at_internal(buffer, start + line_len);
-        if (ch == L'\n') {
-            break;
-        }
-        line_len++;
+    if (line >= buffer_line_count(buffer)) {
+        return 0;
     }
     
-    return line_len;
+    return line_index_line_length(&buffer->lines, line);
 }
 
 /**
@@ -419,47 +930,27 @@ static int utf16_to_utf8(const wchar_t* utf16, size_t utf16_len, char* utf8, siz
  *============================================================================*/
 
 /**
- * @brief Create a new empty buffer
- */
-QalamResult qalam_buffer_create(QalamBuffer** buffer) {
-    return qalam_buffer_create_with_capacity(buffer, QALAM_BUFFER_INITIAL_CAPACITY);
-}
-
-/**
- * @brief Create a buffer with initial capacity
+ * @brief Allocate a buffer structure with an empty line index
+ * 
+ * Storage is left for the caller to set up.
  */
-QalamResult qalam_buffer_create_with_capacity(QalamBuffer** buffer, size_t initial_capacity) {
-    if (!buffer) {
-        return QALAM_ERROR_NULL_POINTER;
-    }
-    
-    /* Enforce minimum capacity */
-    if (initial_capacity < QALAM_BUFFER_INITIAL_CAPACITY) {
-        initial_capacity = QALAM_BUFFER_INITIAL_CAPACITY;
-    }
-    
-    /* Allocate buffer structure */
-    QalamBuffer* buf = (QalamBuffer*)calloc(1, sizeof(QalamBuffer));
+static QalamBuffer* buffer_alloc(QalamBufferBackend backend) {
+    QalamBuffer* buf = (QalamBuffer*)qalam_mem_calloc(QALAM_MEMORY_BUFFER, 1, sizeof(QalamBuffer));
     if (!buf) {
-        return QALAM_ERROR_OUT_OF_MEMORY;
+        return NULL;
     }
     
-    /* Allocate data array */
-    buf->data = (wchar_t*)malloc(initial_capacity * sizeof(wchar_t));
-    if (!buf->data) {
-        free(buf);
-        return QALAM_ERROR_OUT_OF_MEMORY;
+    /* Initialize line index (empty buffer has one line) */
+    if (line_index_init(&buf->lines) != QALAM_OK) {
+        qalam_mem_free(buf);
+        return NULL;
     }
     
-    /* Initialize gap to span entire buffer */
-    buf->capacity = initial_capacity;
-    buf->gap_start = 0;
-    buf->gap_end = initial_capacity;
+    buf->backend = backend;
     
     /* Initialize state */
     buf->cursor_line = 0;
     buf->cursor_column = 0;
-    buf->line_count = 1; /* Empty buffer has one line */
     buf->modified = false;
     buf->readonly = false;
     buf->filepath[0] = L'\0';
@@ -468,412 +959,2323 @@ QalamResult qalam_buffer_create_with_capacity(QalamBuffer** buffer, size_t initi
     buf->selection.is_active = false;
     buf->selection.is_rectangular = false;
     
-    *buffer = buf;
-    return QALAM_OK;
+    return buf;
 }
 
 /**
- * @brief Create a buffer from UTF-8 text
+ * @brief Pick the concrete backend for content of a given UTF-8 size
  */
-QalamResult qalam_buffer_create_from_text(QalamBuffer** buffer, const char* text, size_t length) {
-    if (!buffer) {
-        return QALAM_ERROR_NULL_POINTER;
-    }
-    
-    if (!text) {
-        return qalam_buffer_create(buffer);
-    }
-    
-    /* Handle null-terminated string */
-    if (length == 0) {
-        length = strlen(text);
+static QalamBufferBackend buffer_resolve_backend(const QalamBufferOptions* options, size_t content_bytes) {
+    if (options->backend != QALAM_BUFFER_BACKEND_AUTO) {
+        return options->backend;
     }
     
-    if (length == 0) {
-        return qalam_buffer_create(buffer);
+    size_t threshold = options->large_content_threshold ? options->large_content_threshold
+                                                        : QALAM_BUFFER_LARGE_CONTENT;
+    return content_bytes >= threshold ? QALAM_BUFFER_BACKEND_PIECE_TABLE : QALAM_BUFFER_BACKEND_GAP;
+}
+
+/**
+ * @brief Create a piece table buffer over decoded UTF-16 text
+ * 
+ * On success the buffer owns 'original'; on failure it is freed. The
+ * cursor is placed at the end, matching the gap buffer.
+ */
+static QalamResult buffer_create_piece_table(QalamBuffer** buffer, wchar_t* original, size_t length) {
+    QalamBuffer* buf = buffer_alloc(QALAM_BUFFER_BACKEND_PIECE_TABLE);
+    if (!buf) {
+        qalam_mem_free(original);
+        return QALAM_ERROR_OUT_OF_MEMORY;
     }
     
-    /* Calculate required UTF-16 size */
-    int utf16_len = MultiByteToWideChar(CP_UTF8, 0, text, (int)length, NULL, 0);
-    if (utf16_len <= 0) {
-        return QALAM_ERROR_ENCODING;
+    QalamResult result = piece_table_init(&buf->pieces, original, length);
+    if (result != QALAM_OK) {
+        qalam_mem_free(original);
+        qalam_buffer_destroy(buf);
+        return result;
     }
     
-    /* Create buffer with appropriate capacity */
-    size_t capacity = (size_t)utf16_len + QALAM_BUFFER_INITIAL_GAP_SIZE;
-    QalamResult result = qalam_buffer_create_with_capacity(buffer, capacity);
+    /* Build line index */
+    result = line_index_append(&buf->lines, original, length);
     if (result != QALAM_OK) {
+        qalam_buffer_destroy(buf);
         return result;
     }
     
-    QalamBuffer* buf = *buffer;
-    
-    /* Convert and insert text */
-    int converted = MultiByteToWideChar(
-        CP_UTF8, 0,
-        text, (int)length,
-        buf->data, utf16_len
-    );
+    buf->cursor_offset = length;
+    buffer_update_cursor_from_offset(buf);
     
-    if (converted <= 0) {
-        qalam_buffer_destroy(buf);
-        *buffer = NULL;
-        return QALAM_ERROR_ENCODING;
+    *buffer = buf;
+    return QALAM_OK;
+}
+
+/**
+ * @brief Number of leading bytes that form complete UTF-8 sequences
+ * 
+ * An incomplete sequence at the end (at most 3 bytes) is left for the
+ * next chunk so a character is never split across two conversions.
+ */
+static size_t utf8_complete_prefix(const char* text, size_t length) {
+    size_t back = 0;
+    while (back < 3 && back < length && ((unsigned char)text[length - 1 - back] & 0xC0) == 0x80) {
+        back++;
+    }
+    if (back == length) {
+        return length;
     }
     
-    /* Adjust gap */
-    buf->gap_start = (size_t)converted;
-    
-    /* Update line count */
-    buffer_update_line_count(buf);
+    unsigned char lead = (unsigned char)text[length - 1 - back];
+    size_t expected = lead >= 0xF0 ? 4 : lead >= 0xE0 ? 3 : lead >= 0xC0 ? 2 : 1;
     
-    return QALAM_OK;
+    return expected > back + 1 ? length - 1 - back : length;
 }
 
 /**
- * @brief Create a buffer from a file
+ * @brief Decode UTF-8 into a preallocated UTF-16 array in bounded chunks
+ * 
+ * @param utf16 Destination with room for at least 'length' wchar_t
+ * @return Number of wchar_t written
  */
-QalamResult qalam_buffer_create_from_file(QalamBuffer** buffer, const wchar_t* filepath) {
-    if (!buffer || !filepath) {
-        return QALAM_ERROR_NULL_POINTER;
+static size_t utf8_decode_chunked(const char* text, size_t length, wchar_t* utf16) {
+    size_t written = 0;
+    
+    while (length > 0) {
+        size_t chunk = length > QALAM_BUFFER_READ_CHUNK_SIZE ? QALAM_BUFFER_READ_CHUNK_SIZE : length;
+        if (chunk < length) {
+            size_t complete = utf8_complete_prefix(text, chunk);
+            if (complete > 0) {
+                chunk = complete;
+            }
+        }
+        
+        written += (size_t)utf8_to_utf16(text, chunk, utf16 + written, chunk);
+        text += chunk;
+        length -= chunk;
     }
     
-    /* Open file */
-    HANDLE hFile = CreateFileW(
-        filepath,
-        GENERIC_READ,
-        FILE_SHARE_READ,
-        NULL,
-        OPEN_EXISTING,
-        FILE_ATTRIBUTE_NORMAL,
-        NULL
-    );
+    return written;
+}
+
+/**
+ * @brief Read a file and decode it into a newly allocated UTF-16 array
+ * 
+ * Reads in QALAM_BUFFER_READ_CHUNK_SIZE pieces so only one chunk of
+ * UTF-8 is held at a time. UTF-16 never needs more units than UTF-8
+ * has bytes, so the array is sized from the file and trimmed after.
+ */
+static QalamResult buffer_read_file_utf16(HANDLE file, size_t file_bytes,
+                                          wchar_t** out_text, size_t* out_length) {
+    *out_text = NULL;
+    *out_length = 0;
     
-    if (hFile == INVALID_HANDLE_VALUE) {
-        return QALAM_ERROR_FILE_NOT_FOUND;
+    if (file_bytes == 0) {
+        return QALAM_OK;
     }
     
-    /* Get file size */
-    LARGE_INTEGER fileSize;
-    if (!GetFileSizeEx(hFile, &fileSize)) {
-        CloseHandle(hFile);
-        return QALAM_ERROR_FILE_READ;
+    if (file_bytes > SIZE_MAX / sizeof(wchar_t)) {
+        return QALAM_ERROR_OUT_OF_MEMORY;
     }
     
-    /* Check for reasonable size */
-    if (fileSize.QuadPart > 100 * 1024 * 1024) { /* 100 MB limit */
-        CloseHandle(hFile);
+    wchar_t* text = (wchar_t*)qalam_mem_alloc(QALAM_MEMORY_BUFFER, file_bytes * sizeof(wchar_t));
+    char* chunk = (char*)qalam_mem_alloc(QALAM_MEMORY_BUFFER, QALAM_BUFFER_READ_CHUNK_SIZE + 4);
+    if (!text || !chunk) {
+        qalam_mem_free(text);
+        qalam_mem_free(chunk);
         return QALAM_ERROR_OUT_OF_MEMORY;
     }
     
-    /* Allocate read buffer */
-    size_t file_bytes = (size_t)fileSize.QuadPart;
-    char* file_data = NULL;
+    size_t total_read = 0;
+    size_t carry = 0;
+    size_t written = 0;
     
-    if (file_bytes > 0) {
-        file_data = (char*)malloc(file_bytes + 1);
-        if (!file_data) {
-            CloseHandle(hFile);
-            return QALAM_ERROR_OUT_OF_MEMORY;
+    while (total_read < file_bytes) {
+        size_t want = file_bytes - total_read;
+        if (want > QALAM_BUFFER_READ_CHUNK_SIZE) {
+            want = QALAM_BUFFER_READ_CHUNK_SIZE;
         }
         
-        /* Read file */
         DWORD bytesRead;
-        if (!ReadFile(hFile, file_data, (DWORD)file_bytes, &bytesRead, NULL)) {
-            free(file_data);
-            CloseHandle(hFile);
+        if (!ReadFile(file, chunk + carry, (DWORD)want, &bytesRead, NULL)) {
+            qalam_mem_free(text);
+            qalam_mem_free(chunk);
             return QALAM_ERROR_FILE_READ;
         }
+        if (bytesRead == 0) {
+            break; /* File shrank while reading */
+        }
+        total_read += bytesRead;
+        
+        size_t available = carry + bytesRead;
+        size_t complete = total_read < file_bytes ? utf8_complete_prefix(chunk, available) : available;
+        
+        if (complete > 0) {
+            written += (size_t)utf8_to_utf16(chunk, complete, text + written, complete);
+        }
         
-        file_data[bytesRead] = '\0';
-        file_bytes = bytesRead;
+        carry = available - complete;
+        memmove(chunk, chunk + complete, carry);
     }
     
-    CloseHandle(hFile);
-    
-    /* Create buffer from text */
-    QalamResult result;
-    if (file_data && file_bytes > 0) {
-        result = qalam_buffer_create_from_text(buffer, file_data, file_bytes);
-        free(file_data);
-    } else {
-        result = qalam_buffer_create(buffer);
+    /* Trailing bytes of a truncated sequence decode to U+FFFD */
+    if (carry > 0) {
+        written += (size_t)utf8_to_utf16(chunk, carry, text + written, carry);
     }
     
-    if (result == QALAM_OK && *buffer) {
-        /* Store filepath */
-        wcsncpy((*buffer)->filepath, filepath, MAX_PATH - 1);
-        (*buffer)->filepath[MAX_PATH - 1] = L'\0';
-        (*buffer)->modified = false;
+    qalam_mem_free(chunk);
+    
+    if (written == 0) {
+        qalam_mem_free(text);
+        return QALAM_OK;
     }
     
-    return result;
+    wchar_t* trimmed = (wchar_t*)qalam_mem_realloc(QALAM_MEMORY_BUFFER,
+                                                   text, written * sizeof(wchar_t));
+    *out_text = trimmed ? trimmed : text;
+    *out_length = written;
+    
+    return QALAM_OK;
 }
 
 /**
- * @brief Destroy a buffer and free its resources
+ * @brief Report lines appended at the end by background loading
+ * 
+ * The last line before the append may have been extended, so it counts
+ * as replaced.
  */
-void qalam_buffer_destroy(QalamBuffer* buffer) {
-    if (!buffer) {
-        return;
-    }
-    
-    if (buffer->data) {
-        /* Zero out data before freeing (security) */
-        memset(buffer->data, 0, buffer->capacity * sizeof(wchar_t));
-        free(buffer->data);
-    }
-    
-    memset(buffer, 0, sizeof(QalamBuffer));
-    free(buffer);
+static void buffer_note_appended(QalamBuffer* buffer, size_t lines_before) {
+    size_t lines_after = buffer_line_count(buffer);
+    buffer_note_lines(buffer, lines_before - 1, 1, 1 + lines_after - lines_before);
+    buffer_flush_change(buffer);
 }
 
-/*=============================================================================
- * Buffer Content Operations
- *============================================================================*/
-
 /**
- * @brief Insert text at current cursor position
+ * @brief Append chunks the background indexer has published
+ * 
+ * New original text always belongs at the end of the document, after
+ * any edits, so it extends both the line index and the piece table.
  */
-QalamResult qalam_buffer_insert(QalamBuffer* buffer, const char* text, size_t length) {
-    if (!buffer) {
-        return QALAM_ERROR_NULL_POINTER;
+static QalamResult buffer_absorb_mapped(QalamBuffer* buffer) {
+    const MappedChunkLines* chunk;
+    size_t lines_before = buffer_line_count(buffer);
+    bool appended = false;
+    
+    while ((chunk = mapped_file_peek(buffer->mapped)) != NULL) {
+        QalamResult result = line_index_append_lengths(&buffer->lines, chunk->line_lengths,
+                                                       chunk->line_count, chunk->tail_length);
+        if (result == QALAM_OK) {
+            result = piece_table_append_original(&buffer->pieces, chunk->text_length);
+        }
+        if (result != QALAM_OK) {
+            return result;
+        }
+        mapped_file_advance(buffer->mapped);
+        appended = true;
     }
     
-    if (!text || length == 0) {
-        return QALAM_OK; /* Nothing to insert */
+    if (appended) {
+        buffer_note_appended(buffer, lines_before);
     }
+    return mapped_file_get_status(buffer->mapped);
+}
+
+/**
+ * @brief Append chunks the background loader has finished, in file order
+ * 
+ * The buffer stays read-only until the last chunk is in, since edits
+ * would otherwise have to be merged with text still arriving at the end.
+ */
+static QalamResult buffer_absorb_loader(QalamBuffer* buffer) {
+    const FileLoaderChunk* chunk;
+    size_t lines_before = buffer_line_count(buffer);
+    bool appended = false;
+    QalamResult result = QALAM_OK;
     
-    /* Handle null-terminated string */
-    if (length == 0) {
-        length = strlen(text);
+    while ((chunk = file_loader_peek(buffer->loader)) != NULL) {
+        result = line_index_append_lengths(&buffer->lines, chunk->line_lengths,
+                                           chunk->line_count, chunk->tail_length);
+        if (result == QALAM_OK) {
+            result = piece_table_append_original(&buffer->pieces, chunk->text_length);
+        }
+        if (result != QALAM_OK) {
+            break;
+        }
+        file_loader_advance(buffer->loader);
+        appended = true;
     }
     
-    /* Convert UTF-8 to UTF-16 */
-    int utf16_len = MultiByteToWideChar(CP_UTF8, 0, text, (int)length, NULL, 0);
-    if (utf16_len <= 0) {
-        return QALAM_ERROR_ENCODING;
+    if (appended) {
+        buffer_note_appended(buffer, lines_before);
     }
-    
-    /* Ensure gap is large enough */
-    QalamResult result = buffer_ensure_gap_size(buffer, (size_t)utf16_len);
     if (result != QALAM_OK) {
         return result;
     }
     
-    /* Convert directly into gap */
-    int converted = MultiByteToWideChar(
-        CP_UTF8, 0,
-        text, (int)length,
-        buffer->data + buffer->gap_start, utf16_len
-    );
-    
-    if (converted <= 0) {
-        return QALAM_ERROR_ENCODING;
+    if (file_loader_is_complete(buffer->loader)) {
+        buffer->readonly = false;
+    }
+    return file_loader_get_status(buffer->loader);
+}
+
+/**
+ * @brief Create a piece table buffer over a memory-mapped file
+ * 
+ * Only the first chunk is indexed before returning; the cursor starts
+ * at the top of the file.
+ */
+static QalamResult buffer_create_mapped(QalamBuffer** buffer, const wchar_t* filepath) {
+    MappedFile* file = NULL;
+    QalamResult result = mapped_file_open(&file, filepath);
+    if (result != QALAM_OK) {
+        return result;
     }
     
-    /* Count newlines in inserted text for line count update */
-    size_t newlines = 0;
-    for (int i = 0; i < converted; i++) {
-        if (buffer->data[buffer->gap_start + i] == L'\n') {
-            newlines++;
-        }
+    QalamBuffer* buf = NULL;
+    result = buffer_create_piece_table(&buf, NULL, 0);
+    if (result != QALAM_OK) {
+        mapped_file_close(file);
+        return result;
     }
     
-    /* Advance gap start */
-    buffer->gap_start += converted;
-    buffer->line_count += newlines;
-    buffer->modified = true;
+    buf->mapped = file;
+    piece_table_set_original_source(&buf->pieces, mapped_file_text, file);
     
-    /* Update cursor position */
-    buffer_update_cursor_from_offset(buffer);
+    result = buffer_absorb_mapped(buf);
+    if (result != QALAM_OK) {
+        qalam_buffer_destroy(buf);
+        return result;
+    }
     
+    *buffer = buf;
     return QALAM_OK;
 }
 
 /**
- * @brief Insert text at specified position
+ * @brief Create a piece table buffer whose original text loads on workers
+ * 
+ * Returns once the first chunk is in; the buffer is read-only until
+ * qalam_buffer_poll_load() or qalam_buffer_wait_load() absorbs the rest.
  */
-QalamResult qalam_buffer_insert_at(QalamBuffer* buffer, size_t offset, const char* text, size_t length) {
-    if (!buffer) {
-        return QALAM_ERROR_NULL_POINTER;
+static QalamResult buffer_create_streamed(QalamBuffer** buffer, const wchar_t* filepath,
+                                          const QalamBufferOptions* options) {
+    FileLoader* loader = NULL;
+    QalamResult result = file_loader_open(&loader, filepath, options->load_ready,
+                                          options->load_user_data);
+    if (result != QALAM_OK) {
+        return result;
     }
     
-    size_t content_len = buffer_content_length(buffer);
-    if (offset > content_len) {
-        return QALAM_ERROR_INVALID_POSITION;
+    QalamBuffer* buf = NULL;
+    result = buffer_create_piece_table(&buf, NULL, 0);
+    if (result != QALAM_OK) {
+        file_loader_close(loader);
+        return result;
     }
     
-    /* Move gap to insertion point */
-    buffer_move_gap_to(buffer, offset);
+    buf->loader = loader;
+    buf->readonly = true;
+    piece_table_set_original_source(&buf->pieces, file_loader_text, loader);
+    
+    result = buffer_absorb_loader(buf);
+    if (result != QALAM_OK) {
+        qalam_buffer_destroy(buf);
+        return result;
+    }
+    
+    *buffer = buf;
+    return QALAM_OK;
+}
+
+/**
+ * @brief Replace a mapped original with a fully decoded copy and unmap
+ * 
+ * Needed before the mapped file itself can be overwritten.
+ */
+static QalamResult buffer_detach_mapped(QalamBuffer* buffer) {
+    QalamResult result = qalam_buffer_wait_load(buffer);
+    if (result != QALAM_OK) {
+        return result;
+    }
+    
+    wchar_t* original;
+    size_t original_length;
+    result = mapped_file_materialize(buffer->mapped, &original, &original_length);
+    if (result != QALAM_OK) {
+        return result;
+    }
+    
+    piece_table_adopt_original(&buffer->pieces, original);
+    mapped_file_close(buffer->mapped);
+    buffer->mapped = NULL;
+    
+    return QALAM_OK;
+}
+
+/**
+ * @brief Get default buffer creation options
+ */
+QalamResult qalam_buffer_get_default_options(QalamBufferOptions* options) {
+    if (!options) {
+        return QALAM_ERROR_NULL_POINTER;
+    }
+    
+    options->backend = QALAM_BUFFER_BACKEND_AUTO;
+    options->large_content_threshold = QALAM_BUFFER_LARGE_CONTENT;
+    options->map_file = false;
+    options->background_load = false;
+    options->load_ready = NULL;
+    options->load_user_data = NULL;
+    options->virtual_memory = false;
+    
+    return QALAM_OK;
+}
+
+/**
+ * @brief Create a new empty buffer
+ */
+QalamResult qalam_buffer_create(QalamBuffer** buffer) {
+    return qalam_buffer_create_with_capacity(buffer, QALAM_BUFFER_INITIAL_CAPACITY);
+}
+
+/**
+ * @brief Set up empty gap buffer storage
+ * 
+ * With 'virtual_memory' the buffer's largest size is reserved and the
+ * first 'initial_capacity' characters committed; otherwise that much is
+ * allocated on the heap. The gap spans all of it.
+ */
+static QalamResult buffer_alloc_gap_storage(QalamBuffer* buf, size_t initial_capacity,
+                                            bool virtual_memory) {
+    /* Enforce minimum capacity */
+    if (initial_capacity < QALAM_BUFFER_INITIAL_CAPACITY) {
+        initial_capacity = QALAM_BUFFER_INITIAL_CAPACITY;
+    }
+    
+    if (virtual_memory) {
+        size_t reserve = initial_capacity > QALAM_BUFFER_MAX_SIZE ? initial_capacity
+                                                                  : QALAM_BUFFER_MAX_SIZE;
+        QalamResult result = reserve > SIZE_MAX / sizeof(wchar_t)
+            ? QALAM_ERROR_OUT_OF_MEMORY
+            : virtual_region_reserve(&buf->vm, reserve * sizeof(wchar_t));
+        if (result == QALAM_OK) {
+            result = virtual_region_commit(&buf->vm, 0, initial_capacity * sizeof(wchar_t));
+        }
+        if (result != QALAM_OK) {
+            virtual_region_release(&buf->vm);
+            return result;
+        }
+        buf->data = (wchar_t*)buf->vm.base;
+        buf->capacity = buf->vm.size / sizeof(wchar_t);
+    } else {
+        /* Allocate data array */
+        buf->data = (wchar_t*)qalam_mem_alloc(QALAM_MEMORY_BUFFER,
+                                              initial_capacity * sizeof(wchar_t));
+        if (!buf->data) {
+            return QALAM_ERROR_OUT_OF_MEMORY;
+        }
+        buf->capacity = initial_capacity;
+    }
+    
+    /* Initialize gap to span entire buffer */
+    buf->gap_start = 0;
+    buf->gap_end = buf->capacity;
+    return QALAM_OK;
+}
+
+/**
+ * @brief Zero and release gap buffer storage
+ * 
+ * Leaves 'data' NULL and the gap fields as they were.
+ */
+static void buffer_release_gap_storage(QalamBuffer* buffer) {
+    if (buffer_is_virtual(buffer)) {
+        /* Zeroes the committed pages only */
+        virtual_region_release(&buffer->vm);
+    } else if (buffer->data) {
+        /* Zero out data before freeing (security) */
+        memset(buffer->data, 0, buffer->capacity * sizeof(wchar_t));
+        qalam_mem_free(buffer->data);
+    }
+    buffer->data = NULL;
+}
+
+/**
+ * @brief Create an empty gap buffer
+ * 
+ * See buffer_alloc_gap_storage() for 'initial_capacity' and
+ * 'virtual_memory'.
+ */
+static QalamResult buffer_create_gap(QalamBuffer** buffer, size_t initial_capacity,
+                                     bool virtual_memory) {
+    /* Allocate buffer structure */
+    QalamBuffer* buf = buffer_alloc(QALAM_BUFFER_BACKEND_GAP);
+    if (!buf) {
+        return QALAM_ERROR_OUT_OF_MEMORY;
+    }
+    
+    QalamResult result = buffer_alloc_gap_storage(buf, initial_capacity, virtual_memory);
+    if (result != QALAM_OK) {
+        qalam_buffer_destroy(buf);
+        return result;
+    }
+    
+    *buffer = buf;
+    return QALAM_OK;
+}
+
+/**
+ * @brief Create a buffer with initial capacity
+ */
+QalamResult qalam_buffer_create_with_capacity(QalamBuffer** buffer, size_t initial_capacity) {
+    if (!buffer) {
+        return QALAM_ERROR_NULL_POINTER;
+    }
+    
+    return buffer_create_gap(buffer, initial_capacity, false);
+}
+
+/**
+ * @brief Create a new empty buffer with options
+ */
+QalamResult qalam_buffer_create_with_options(QalamBuffer** buffer, const QalamBufferOptions* options) {
+    if (!buffer) {
+        return QALAM_ERROR_NULL_POINTER;
+    }
+    
+    QalamBufferOptions defaults;
+    if (!options) {
+        qalam_buffer_get_default_options(&defaults);
+        options = &defaults;
+    }
+    
+    if (buffer_resolve_backend(options, 0) == QALAM_BUFFER_BACKEND_PIECE_TABLE) {
+        return buffer_create_piece_table(buffer, NULL, 0);
+    }
+    
+    return buffer_create_gap(buffer, QALAM_BUFFER_INITIAL_CAPACITY, options->virtual_memory);
+}
+
+/**
+ * @brief Create a buffer from UTF-8 text
+ */
+QalamResult qalam_buffer_create_from_text(QalamBuffer** buffer, const char* text, size_t length) {
+    return qalam_buffer_create_from_text_with_options(buffer, text, length, NULL);
+}
+
+/**
+ * @brief Create a buffer from UTF-8 text with options
+ */
+QalamResult qalam_buffer_create_from_text_with_options(QalamBuffer** buffer, const char* text,
+                                                        size_t length, const QalamBufferOptions* options) {
+    if (!buffer) {
+        return QALAM_ERROR_NULL_POINTER;
+    }
+    
+    if (!text) {
+        return qalam_buffer_create_with_options(buffer, options);
+    }
+    
+    /* Handle null-terminated string */
+    if (length == 0) {
+        length = strlen(text);
+    }
+    
+    if (length == 0) {
+        return qalam_buffer_create_with_options(buffer, options);
+    }
+    
+    QalamBufferOptions defaults;
+    if (!options) {
+        qalam_buffer_get_default_options(&defaults);
+        options = &defaults;
+    }
+    
+    if (buffer_resolve_backend(options, length) == QALAM_BUFFER_BACKEND_PIECE_TABLE) {
+        /* Decode straight into the piece table's original text */
+        if (length > SIZE_MAX / sizeof(wchar_t)) {
+            return QALAM_ERROR_OUT_OF_MEMORY;
+        }
+        wchar_t* original = (wchar_t*)qalam_mem_alloc(QALAM_MEMORY_BUFFER,
+                                                      length * sizeof(wchar_t));
+        if (!original) {
+            return QALAM_ERROR_OUT_OF_MEMORY;
+        }
+        
+        size_t converted = utf8_decode_chunked(text, length, original);
+        if (converted == 0) {
+            qalam_mem_free(original);
+            return QALAM_ERROR_ENCODING;
+        }
+        
+        wchar_t* trimmed = (wchar_t*)qalam_mem_realloc(QALAM_MEMORY_BUFFER,
+                                                       original, converted * sizeof(wchar_t));
+        return buffer_create_piece_table(buffer, trimmed ? trimmed : original, converted);
+    }
+    
+    /* Calculate required UTF-16 size */
+    int utf16_len = MultiByteToWideChar(CP_UTF8, 0, text, (int)length, NULL, 0);
+    if (utf16_len <= 0) {
+        return QALAM_ERROR_ENCODING;
+    }
+    
+    /* Create buffer with appropriate capacity */
+    size_t capacity = (size_t)utf16_len + QALAM_BUFFER_INITIAL_GAP_SIZE;
+    QalamResult result = buffer_create_gap(buffer, capacity, options->virtual_memory);
+    if (result != QALAM_OK) {
+        return result;
+    }
+    
+    QalamBuffer* buf = *buffer;
+    
+    /* Convert and insert text */
+    int converted = MultiByteToWideChar(
+        CP_UTF8, 0,
+        text, (int)length,
+        buf->data, utf16_len
+    );
+    
+    if (converted <= 0) {
+        qalam_buffer_destroy(buf);
+        *buffer = NULL;
+        return QALAM_ERROR_ENCODING;
+    }
+    
+    /* Adjust gap; the cursor starts at the end of the text */
+    buf->gap_start = (size_t)converted;
+    buf->cursor_offset = (size_t)converted;
+    
+    /* Build line index */
+    result = line_index_append(&buf->lines, buf->data, (size_t)converted);
+    if (result != QALAM_OK) {
+        qalam_buffer_destroy(buf);
+        *buffer = NULL;
+        return result;
+    }
+    
+    /* Cursor sits at the end of the content, where the gap is */
+    buffer_update_cursor_from_offset(buf);
+    
+    return QALAM_OK;
+}
+
+/**
+ * @brief Create a buffer from a file
+ */
+QalamResult qalam_buffer_create_from_file(QalamBuffer** buffer, const wchar_t* filepath) {
+    return qalam_buffer_create_from_file_with_options(buffer, filepath, NULL);
+}
+
+/**
+ * @brief Create a buffer from a file with options
+ */
+QalamResult qalam_buffer_create_from_file_with_options(QalamBuffer** buffer, const wchar_t* filepath,
+                                                        const QalamBufferOptions* options) {
+    if (!buffer || !filepath) {
+        return QALAM_ERROR_NULL_POINTER;
+    }
+    
+    QalamBufferOptions defaults;
+    if (!options) {
+        qalam_buffer_get_default_options(&defaults);
+        options = &defaults;
+    }
+    
+    if (options->map_file || options->background_load) {
+        QalamResult result = options->map_file ? buffer_create_mapped(buffer, filepath)
+                                               : buffer_create_streamed(buffer, filepath, options);
+        if (result == QALAM_OK) {
+            wcsncpy((*buffer)->filepath, filepath, MAX_PATH - 1);
+            (*buffer)->filepath[MAX_PATH - 1] = L'\0';
+        }
+        return result;
+    }
+    
+    /* Open file */
+    HANDLE hFile = CreateFileW(
+        filepath,
+        GENERIC_READ,
+        FILE_SHARE_READ,
+        NULL,
+        OPEN_EXISTING,
+        FILE_ATTRIBUTE_NORMAL,
+        NULL
+    );
+    
+    if (hFile == INVALID_HANDLE_VALUE) {
+        return QALAM_ERROR_FILE_NOT_FOUND;
+    }
+    
+    /* Get file size */
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(hFile, &fileSize)) {
+        CloseHandle(hFile);
+        return QALAM_ERROR_FILE_READ;
+    }
+    
+    size_t file_bytes = (size_t)fileSize.QuadPart;
+    QalamResult result;
+    
+    if (buffer_resolve_backend(options, file_bytes) == QALAM_BUFFER_BACKEND_PIECE_TABLE) {
+        /* Decode chunk by chunk into the original text; no size cap */
+        wchar_t* original;
+        size_t original_length;
+        result = buffer_read_file_utf16(hFile, file_bytes, &original, &original_length);
+        CloseHandle(hFile);
+        
+        if (result == QALAM_OK) {
+            result = buffer_create_piece_table(buffer, original, original_length);
+        }
+    } else {
+        /* Check for reasonable size */
+        if (fileSize.QuadPart > QALAM_BUFFER_MAX_FILE_SIZE) {
+            CloseHandle(hFile);
+            return QALAM_ERROR_OUT_OF_MEMORY;
+        }
+        
+        /* Allocate read buffer */
+        char* file_data = NULL;
+        
+        if (file_bytes > 0) {
+            file_data = (char*)qalam_mem_alloc(QALAM_MEMORY_BUFFER, file_bytes + 1);
+            if (!file_data) {
+                CloseHandle(hFile);
+                return QALAM_ERROR_OUT_OF_MEMORY;
+            }
+            
+            /* Read file */
+            DWORD bytesRead;
+            if (!ReadFile(hFile, file_data, (DWORD)file_bytes, &bytesRead, NULL)) {
+                qalam_mem_free(file_data);
+                CloseHandle(hFile);
+                return QALAM_ERROR_FILE_READ;
+            }
+            
+            file_data[bytesRead] = '\0';
+            file_bytes = bytesRead;
+        }
+        
+        CloseHandle(hFile);
+        
+        /* Create buffer from text */
+        if (file_data && file_bytes > 0) {
+            QalamBufferOptions gap_options = *options;
+            gap_options.backend = QALAM_BUFFER_BACKEND_GAP;
+            result = qalam_buffer_create_from_text_with_options(buffer, file_data, file_bytes, &gap_options);
+            qalam_mem_free(file_data);
+        } else {
+            result = buffer_create_gap(buffer, QALAM_BUFFER_INITIAL_CAPACITY,
+                                       options->virtual_memory);
+        }
+    }
+    
+    if (result == QALAM_OK && *buffer) {
+        /* Store filepath */
+        wcsncpy((*buffer)->filepath, filepath, MAX_PATH - 1);
+        (*buffer)->filepath[MAX_PATH - 1] = L'\0';
+        (*buffer)->modified = false;
+    }
+    
+    return result;
+}
+
+/**
+ * @brief Get the storage backend a buffer was created with
+ */
+QalamBufferBackend qalam_buffer_get_backend(const QalamBuffer* buffer) {
+    if (!buffer) {
+        return QALAM_BUFFER_BACKEND_AUTO;
+    }
+    return buffer->backend;
+}
+
+/**
+ * @brief Absorb lines indexed in the background since the last call
+ */
+QalamResult qalam_buffer_poll_load(QalamBuffer* buffer, bool* complete) {
+    if (!buffer) {
+        return QALAM_ERROR_NULL_POINTER;
+    }
+    
+    QalamResult result = QALAM_OK;
+    if (buffer->mapped) {
+        result = buffer_absorb_mapped(buffer);
+    } else if (buffer->loader) {
+        result = buffer_absorb_loader(buffer);
+    }
+    
+    if (complete) {
+        if (buffer->mapped) {
+            *complete = mapped_file_is_complete(buffer->mapped);
+        } else {
+            *complete = !buffer->loader || file_loader_is_complete(buffer->loader);
+        }
+    }
+    return result;
+}
+
+/**
+ * @brief Block until background indexing finishes and absorb the rest
+ */
+QalamResult qalam_buffer_wait_load(QalamBuffer* buffer) {
+    if (!buffer) {
+        return QALAM_ERROR_NULL_POINTER;
+    }
+    
+    if (buffer->loader) {
+        QalamResult result = file_loader_wait(buffer->loader);
+        QalamResult absorbed = buffer_absorb_loader(buffer);
+        return result != QALAM_OK ? result : absorbed;
+    }
+    
+    if (!buffer->mapped) {
+        return QALAM_OK;
+    }
+    
+    mapped_file_wait(buffer->mapped);
+    return buffer_absorb_mapped(buffer);
+}
+
+/**
+ * @brief Get background loading progress
+ */
+QalamResult qalam_buffer_get_load_progress(const QalamBuffer* buffer, size_t* bytes_loaded,
+                                            size_t* bytes_total) {
+    if (!buffer) {
+        return QALAM_ERROR_NULL_POINTER;
+    }
+    
+    if (buffer->mapped) {
+        mapped_file_get_progress(buffer->mapped, bytes_loaded, bytes_total);
+        return QALAM_OK;
+    }
+    if (buffer->loader) {
+        file_loader_get_progress(buffer->loader, bytes_loaded, bytes_total);
+        return QALAM_OK;
+    }
+    
+    /* Everything is in memory: report the content as fully loaded */
+    size_t size = qalam_buffer_get_size(buffer);
+    if (bytes_loaded) {
+        *bytes_loaded = size;
+    }
+    if (bytes_total) {
+        *bytes_total = size;
+    }
+    return QALAM_OK;
+}
+
+/**
+ * @brief Destroy a buffer and free its resources
+ */
+void qalam_buffer_destroy(QalamBuffer* buffer) {
+    if (!buffer) {
+        return;
+    }
+    
+    buffer_release_gap_storage(buffer);
+    buffer_free_hibernated(buffer);
+    
+    /* Spans held by the journal go back to the piece table first */
+    undo_journal_free(&buffer->undo, buffer_undo_table(buffer));
+    piece_table_free(&buffer->pieces);
+    mapped_file_close(buffer->mapped);
+    file_loader_close(buffer->loader);
+    buffer_free_view_copy(buffer);
+    line_index_free(&buffer->lines);
+    buffer_batch_free(&buffer->batch);
+    search_pattern_free(&buffer->search);
+    
+    memset(buffer, 0, sizeof(QalamBuffer));
+    qalam_mem_free(buffer);
+}
+
+/*=============================================================================
+ * Internal Helper Functions - Change Notification
+ *============================================================================*/
+
+/**
+ * @brief Add a change to the one waiting to be reported
+ * 
+ * Lines [first, first + old_count) of the current text were replaced by
+ * 'new_count' lines. Changes are merged into the smallest run of lines
+ * that covers all of them.
+ */
+static void buffer_note_lines(QalamBuffer* buffer, size_t first, size_t old_count,
+                              size_t new_count) {
+    if (!buffer->change_callback) {
+        return;
+    }
+    
+    QalamBufferChange* change = &buffer->change;
+    if (!buffer->change_pending) {
+        change->first_line = first;
+        change->old_line_count = old_count;
+        change->new_line_count = new_count;
+        buffer->change_pending = true;
+        return;
+    }
+    
+    /* Cover both runs in the text between the two changes */
+    size_t pending_end = change->first_line + change->new_line_count;
+    size_t start = first < change->first_line ? first : change->first_line;
+    size_t end = first + old_count > pending_end ? first + old_count : pending_end;
+    
+    change->old_line_count = end - start - (change->new_line_count - change->old_line_count);
+    change->new_line_count = end - start + (new_count - old_count);
+    change->first_line = start;
+}
+
+/**
+ * @brief Note a single insertion or deletion at 'pos'
+ * 
+ * Called after the line index is updated; the difference in line count
+ * tells how many lines the edit split or joined.
+ */
+static void buffer_note_edit(QalamBuffer* buffer, size_t pos, size_t lines_before) {
+    if (!buffer->change_callback) {
+        return;
+    }
+    
+    size_t lines_after = buffer_line_count(buffer);
+    size_t first = line_index_line_from_offset(&buffer->lines, pos, NULL);
+    
+    buffer_note_lines(buffer, first,
+                      lines_before > lines_after ? 1 + lines_before - lines_after : 1,
+                      lines_after > lines_before ? 1 + lines_after - lines_before : 1);
+}
+
+/**
+ * @brief Report the pending change, unless an undo group is still open
+ */
+static void buffer_flush_change(QalamBuffer* buffer) {
+    if (!buffer->change_pending || buffer->undo.depth > 0) {
+        return;
+    }
+    
+    buffer->change_pending = false;
+    if (buffer->change_callback) {
+        buffer->change_callback(buffer, &buffer->change, buffer->change_user_data);
+    }
+}
+
+/*=============================================================================
+ * Internal Helper Functions - Undo
+ *============================================================================*/
+
+/**
+ * @brief Get the piece table the undo journal holds spans of, or NULL
+ */
+static inline PieceTable* buffer_undo_table(QalamBuffer* buffer) {
+    return buffer_is_piece_table(buffer) ? &buffer->pieces : NULL;
+}
+
+/**
+ * @brief Capture the cursor and selection for an undo group
+ */
+static UndoState buffer_undo_state(const QalamBuffer* buffer) {
+    UndoState state;
+    state.cursor_offset = buffer_cursor_offset(buffer);
+    state.selection = buffer->selection;
+    return state;
+}
+
+/**
+ * @brief Restore a cursor and selection captured by buffer_undo_state()
+ */
+static void buffer_undo_apply_state(QalamBuffer* buffer, const UndoState* state) {
+    size_t content_len = buffer_content_length(buffer);
+    size_t offset = state->cursor_offset < content_len ? state->cursor_offset : content_len;
+    
+    buffer_move_cursor_to(buffer, offset);
+    buffer_update_cursor_from_offset(buffer);
+    buffer->selection = state->selection;
+}
+
+/**
+ * @brief Remove a range and record the deletion in the undo journal
+ * 
+ * The gap buffer copies the text into the journal first; the piece
+ * table hands the detached pieces over instead.
+ */
+static QalamResult buffer_remove_recorded(QalamBuffer* buffer, size_t pos, size_t len,
+                                          UndoDeleteDirection direction,
+                                          const UndoState* before) {
+    PieceTable* table = buffer_undo_table(buffer);
+    wchar_t* saved = NULL;
+    
+    QalamResult result = undo_journal_reserve(&buffer->undo, table, table ? 0 : len, &saved);
+    if (result != QALAM_OK) {
+        return result;
+    }
+    if (!table) {
+        buffer_copy_range(buffer, pos, len, saved);
+    }
+    
+    PieceNode* span = NULL;
+    result = buffer_remove_range(buffer, pos, len, table ? &span : NULL);
+    if (result != QALAM_OK) {
+        piece_table_release_span(table, span);
+        return result;
+    }
+    
+    UndoState after = buffer_undo_state(buffer);
+    undo_journal_record(&buffer->undo, table, UNDO_RECORD_DELETE, direction,
+                        direction != UNDO_DELETE_RANGE, pos, len, span, before, &after);
+    return QALAM_OK;
+}
+
+/**
+ * @brief Line index insertion fed segment by segment
+ */
+typedef struct BufferIndexInsert {
+    LineIndex* lines;           /**< Index to update */
+    size_t pos;                 /**< Offset of the next segment */
+    QalamResult result;         /**< First failure, or QALAM_OK */
+} BufferIndexInsert;
+
+/**
+ * @brief Segment callback that adds a segment to the line index
+ */
+static bool buffer_index_segment(const wchar_t* text, size_t len, void* context) {
+    BufferIndexInsert* insert = (BufferIndexInsert*)context;
+    insert->result = line_index_insert(insert->lines, insert->pos, text, len);
+    insert->pos += len;
+    return insert->result == QALAM_OK;
+}
+
+/**
+ * @brief Put a record's text back into the document
+ * 
+ * The piece table reattaches the detached pieces; the gap buffer copies
+ * the text back from the journal.
+ */
+static QalamResult buffer_undo_restore(QalamBuffer* buffer, UndoRecord* record) {
+    size_t pos = record->pos;
+    size_t len = record->length;
+    size_t lines_before = buffer_line_count(buffer);
+    QalamResult result;
+    
+    if (buffer_is_piece_table(buffer)) {
+        result = piece_table_attach(&buffer->pieces, pos, record->span);
+        if (result != QALAM_OK) {
+            return result;
+        }
+        record->span = NULL;
+        
+        BufferIndexInsert insert = { &buffer->lines, pos, QALAM_OK };
+        buffer_for_each_segment(buffer, pos, len, buffer_index_segment, &insert);
+        if (insert.result == QALAM_OK) {
+            buffer_note_edit(buffer, pos, lines_before);
+        }
+        return insert.result;
+    }
+    
+    result = buffer_move_gap_to(buffer, pos);
+    if (result == QALAM_OK) {
+        result = buffer_ensure_gap_size(buffer, len);
+    }
+    if (result != QALAM_OK) {
+        return result;
+    }
+    
+    wchar_t* dest = buffer->data + buffer->gap_start;
+    memcpy(dest, undo_journal_record_text(&buffer->undo, record), len * sizeof(wchar_t));
+    result = line_index_insert(&buffer->lines, pos, dest, len);
+    if (result != QALAM_OK) {
+        return result;
+    }
+    buffer->gap_start += len;
+    buffer_note_edit(buffer, pos, lines_before);
+    
+    /* A redone insertion is back in the document; its copy is surplus */
+    if (record->kind == UNDO_RECORD_INSERT) {
+        undo_journal_drop_text(&buffer->undo, record);
+    }
+    return QALAM_OK;
+}
+
+/**
+ * @brief Take a record's text out of the document
+ * 
+ * The piece table detaches the pieces; the gap buffer copies the text
+ * into the journal unless it already holds it.
+ */
+static QalamResult buffer_undo_take(QalamBuffer* buffer, UndoRecord* record) {
+    size_t pos = record->pos;
+    size_t len = record->length;
+    
+    if (buffer_is_piece_table(buffer)) {
+        return buffer_remove_range(buffer, pos, len, &record->span);
+    }
+    
+    if (record->text == UNDO_NO_TEXT) {
+        QalamResult result = undo_journal_reserve_text(&buffer->undo, len);
+        if (result != QALAM_OK) {
+            return result;
+        }
+        /* With the gap at 'pos' the range is one run, which the removal needs anyway */
+        result = buffer_move_gap_to(buffer, pos);
+        if (result != QALAM_OK) {
+            return result;
+        }
+        record->text = undo_journal_push_text(&buffer->undo, buffer->data + buffer->gap_end, len);
+    }
+    return buffer_remove_range(buffer, pos, len, NULL);
+}
+
+/**
+ * @brief Apply one record of a group in the undo or redo direction
+ */
+static QalamResult buffer_undo_step(QalamBuffer* buffer, UndoRecord* record, bool undo) {
+    bool take = (record->kind == UNDO_RECORD_INSERT) == undo;
+    return take ? buffer_undo_take(buffer, record) : buffer_undo_restore(buffer, record);
+}
+
+/**
+ * @brief Undo or redo all records of a group
+ * 
+ * Undo walks the records backwards, redo forwards. Each record is one
+ * storage operation however much text it covers. If a step fails, the
+ * steps already made are reversed so the group stays whole.
+ */
+static QalamResult buffer_undo_apply_group(QalamBuffer* buffer, const UndoGroup* group, bool undo) {
+    UndoRecord* records = buffer->undo.records + group->first_record;
+    size_t count = group->record_count;
+    
+    for (size_t step = 0; step < count; step++) {
+        QalamResult result = buffer_undo_step(buffer, &records[undo ? count - 1 - step : step],
+                                              undo);
+        if (result != QALAM_OK) {
+            while (step-- > 0) {
+                buffer_undo_step(buffer, &records[undo ? count - 1 - step : step], !undo);
+            }
+            return result;
+        }
+    }
+    
+    return QALAM_OK;
+}
+
+/*=============================================================================
+ * Internal Helper Functions - Edit Transactions
+ *============================================================================*/
+
+/**
+ * @brief Grow an array so it holds at least 'needed' elements
+ */
+static QalamResult buffer_batch_grow(void** items, size_t* capacity, size_t needed,
+                                     size_t item_size) {
+    if (needed <= *capacity) {
+        return QALAM_OK;
+    }
+    
+    size_t new_capacity = *capacity ? *capacity : QALAM_BUFFER_EDIT_INITIAL;
+    while (new_capacity < needed) {
+        if (new_capacity > SIZE_MAX / (2 * item_size)) {
+            return QALAM_ERROR_OUT_OF_MEMORY;
+        }
+        new_capacity *= 2;
+    }
+    
+    void* grown = qalam_mem_realloc(QALAM_MEMORY_BUFFER, *items, new_capacity * item_size);
+    if (!grown) {
+        return QALAM_ERROR_OUT_OF_MEMORY;
+    }
+    *items = grown;
+    *capacity = new_capacity;
+    return QALAM_OK;
+}
+
+/**
+ * @brief Release a transaction's storage and close it
+ */
+static void buffer_batch_free(BufferEditBatch* batch) {
+    if (batch->text) {
+        memset(batch->text, 0, batch->text_capacity * sizeof(wchar_t));
+        qalam_mem_free(batch->text);
+    }
+    qalam_mem_free(batch->edits);
+    qalam_mem_free(batch->lens);
+    qalam_mem_free(batch->clusters);
+    
+    memset(batch, 0, sizeof(BufferEditBatch));
+}
+
+/**
+ * @brief Append room for 'count' line lengths
+ * 
+ * @return Where to write them, or NULL if out of memory
+ */
+static size_t* buffer_batch_add_lens(BufferEditBatch* batch, size_t count) {
+    if (buffer_batch_grow((void**)&batch->lens, &batch->lens_capacity,
+                          batch->lens_count + count, sizeof(size_t)) != QALAM_OK) {
+        return NULL;
+    }
+    
+    size_t* lens = batch->lens + batch->lens_count;
+    batch->lens_count += count;
+    return lens;
+}
+
+/**
+ * @brief Work out the new line lengths around the edits
+ * 
+ * Uses the line index as it is before the edits: lines untouched by
+ * any edit keep their stored length, so only the replacement text is
+ * scanned. Edits separated by fewer than QALAM_BUFFER_EDIT_CLUSTER_LINES
+ * untouched lines share a cluster, which becomes one index update.
+ */
+static QalamResult buffer_batch_plan_lines(QalamBuffer* buffer) {
+    BufferEditBatch* batch = &buffer->batch;
+    const LineIndex* lines = &buffer->lines;
+    const BufferEdit* edits = batch->edits;
+    size_t count = batch->edit_count;
+    
+    batch->lens_count = 0;
+    batch->cluster_count = 0;
+    
+    BufferEditCluster cluster;
+    size_t line_start;
+    cluster.first_line = line_index_line_from_offset(lines, edits[0].start, &line_start);
+    cluster.lens = 0;
+    size_t run = edits[0].start - line_start;
+    
+    for (size_t i = 0; i < count; i++) {
+        const BufferEdit* edit = &edits[i];
+        size_t* slot;
+        
+        /* Each newline in the replacement ends a line */
+        const wchar_t* text = batch->text + edit->text;
+        size_t left = edit->length;
+        size_t newline;
+        while ((newline = text_find_newline(text, left)) < left) {
+            slot = buffer_batch_add_lens(batch, 1);
+            if (!slot) {
+                return QALAM_ERROR_OUT_OF_MEMORY;
+            }
+            *slot = run + newline + 1;
+            run = 0;
+            text += newline + 1;
+            left -= newline + 1;
+        }
+        run += left;
+        
+        /* Old text follows up to the next edit, or the end of the line */
+        size_t end_start, end_len;
+        size_t end_line = line_index_line_from_offset(lines, edit->end, &end_start);
+        line_index_copy_lengths(lines, end_line, 1, &end_len);
+        
+        size_t next_line = 0;
+        size_t next_start = 0;
+        if (i + 1 < count) {
+            next_line = line_index_line_from_offset(lines, edits[i + 1].start, &next_start);
+            if (next_line == end_line) {
+                run += edits[i + 1].start - edit->end;
+                continue;
+            }
+        }
+        
+        slot = buffer_batch_add_lens(batch, 1);
+        if (!slot) {
+            return QALAM_ERROR_OUT_OF_MEMORY;
+        }
+        *slot = run + end_start + end_len - edit->end;
+        
+        if (i + 1 < count && next_line - end_line - 1 <= QALAM_BUFFER_EDIT_CLUSTER_LINES) {
+            /* Keep the lines in between and carry on with the same cluster */
+            size_t between = next_line - end_line - 1;
+            slot = buffer_batch_add_lens(batch, between);
+            if (!slot) {
+                return QALAM_ERROR_OUT_OF_MEMORY;
+            }
+            line_index_copy_lengths(lines, end_line + 1, between, slot);
+            run = edits[i + 1].start - next_start;
+            continue;
+        }
+        
+        cluster.old_count = end_line - cluster.first_line + 1;
+        cluster.new_count = batch->lens_count - cluster.lens;
+        QalamResult result = buffer_batch_grow((void**)&batch->clusters, &batch->cluster_capacity,
+                                               batch->cluster_count + 1,
+                                               sizeof(BufferEditCluster));
+        if (result != QALAM_OK) {
+            return result;
+        }
+        batch->clusters[batch->cluster_count++] = cluster;
+        
+        if (i + 1 < count) {
+            cluster.first_line = next_line;
+            cluster.lens = batch->lens_count;
+            run = edits[i + 1].start - next_start;
+        }
+    }
+    
+    return QALAM_OK;
+}
+
+/**
+ * @brief Map an offset through the queued edits
+ * 
+ * An offset inside or at the edge of a replaced range moves to the end
+ * of its replacement.
+ */
+static size_t buffer_batch_map_offset(const BufferEditBatch* batch, size_t offset) {
+    size_t inserted = 0;
+    size_t deleted = 0;
+    
+    for (size_t i = 0; i < batch->edit_count; i++) {
+        const BufferEdit* edit = &batch->edits[i];
+        if (edit->start > offset) {
+            break;
+        }
+        if (offset <= edit->end) {
+            return edit->start - deleted + inserted + edit->length;
+        }
+        inserted += edit->length;
+        deleted += edit->end - edit->start;
+    }
+    
+    return offset - deleted + inserted;
+}
+
+/**
+ * @brief Apply the edits to the gap buffer in one left-to-right pass
+ * 
+ * The gap starts at the first edit and is carried along: each deletion
+ * widens it, each replacement is written at its start, and the text
+ * between two edits crosses it once. The gap must already be at the
+ * first edit and large enough for the peak growth (and committed as far
+ * as the sweep writes), and the journal must hold room for the deleted
+ * text.
+ */
+static void buffer_batch_sweep_gap(QalamBuffer* buffer, const UndoState* state) {
+    BufferEditBatch* batch = &buffer->batch;
+    UndoJournal* journal = &buffer->undo;
+    size_t copied_to = batch->edits[0].start;
+    
+    for (size_t i = 0; i < batch->edit_count; i++) {
+        const BufferEdit* edit = &batch->edits[i];
+        
+        size_t keep = edit->start - copied_to;
+        if (keep > 0) {
+            memmove(buffer->data + buffer->gap_start, buffer->data + buffer->gap_end,
+                    keep * sizeof(wchar_t));
+            buffer->gap_start += keep;
+            buffer->gap_end += keep;
+        }
+        
+        size_t removed = edit->end - edit->start;
+        if (removed > 0) {
+            /* The reserved journal space follows the text recorded so far */
+            memcpy(journal->text + journal->text_length, buffer->data + buffer->gap_end,
+                   removed * sizeof(wchar_t));
+            buffer->gap_end += removed;
+            undo_journal_record(journal, NULL, UNDO_RECORD_DELETE, UNDO_DELETE_RANGE, false,
+                                buffer->gap_start, removed, NULL, state, state);
+        }
+        
+        if (edit->length > 0) {
+            memcpy(buffer->data + buffer->gap_start, batch->text + edit->text,
+                   edit->length * sizeof(wchar_t));
+            undo_journal_record(journal, NULL, UNDO_RECORD_INSERT, UNDO_DELETE_RANGE, false,
+                                buffer->gap_start, edit->length, NULL, state, state);
+            buffer->gap_start += edit->length;
+        }
+        
+        copied_to = edit->end;
+    }
+}
+
+/**
+ * @brief Apply the edits to the piece table, first to last
+ * 
+ * Each edit is a detach and an insert, O(log pieces) however far apart
+ * the edits are. The add buffer must already hold room for all of the
+ * replacement text.
+ */
+static QalamResult buffer_batch_sweep_pieces(QalamBuffer* buffer, const UndoState* state) {
+    BufferEditBatch* batch = &buffer->batch;
+    PieceTable* table = &buffer->pieces;
+    size_t inserted = 0;
+    size_t deleted = 0;
+    
+    for (size_t i = 0; i < batch->edit_count; i++) {
+        const BufferEdit* edit = &batch->edits[i];
+        size_t pos = edit->start - deleted + inserted;
+        size_t removed = edit->end - edit->start;
+        QalamResult result;
+        
+        if (removed > 0) {
+            PieceNode* span = NULL;
+            result = piece_table_detach(table, pos, removed, &span);
+            if (result != QALAM_OK) {
+                return result;
+            }
+            undo_journal_record(&buffer->undo, table, UNDO_RECORD_DELETE, UNDO_DELETE_RANGE,
+                                false, pos, removed, span, state, state);
+        }
+        
+        if (edit->length > 0) {
+            wchar_t* dest;
+            result = piece_table_reserve_add(table, edit->length, &dest);
+            if (result == QALAM_OK) {
+                memcpy(dest, batch->text + edit->text, edit->length * sizeof(wchar_t));
+                result = piece_table_insert(table, pos, edit->length);
+            }
+            if (result != QALAM_OK) {
+                return result;
+            }
+            undo_journal_record(&buffer->undo, table, UNDO_RECORD_INSERT, UNDO_DELETE_RANGE,
+                                false, pos, edit->length, NULL, state, state);
+        }
+        
+        inserted += edit->length;
+        deleted += removed;
+    }
+    
+    return QALAM_OK;
+}
+
+/*=============================================================================
+ * Buffer Content Operations
+ *============================================================================*/
+
+/**
+ * @brief Insert text at current cursor position
+ */
+QalamResult qalam_buffer_insert(QalamBuffer* buffer, const char* text, size_t length) {
+    if (!buffer) {
+        return QALAM_ERROR_NULL_POINTER;
+    }
+    if (buffer->readonly) {
+        return QALAM_ERROR_BUFFER_READONLY;
+    }
+    
+    QalamResult result = buffer_wake(buffer);
+    if (result != QALAM_OK) {
+        return result;
+    }
+    
+    if (!text || length == 0) {
+        return QALAM_OK; /* Nothing to insert */
+    }
+    
+    /* Handle null-terminated string */
+    if (length == 0) {
+        length = strlen(text);
+    }
+    
+    /* Convert UTF-8 to UTF-16 */
+    int utf16_len = MultiByteToWideChar(CP_UTF8, 0, text, (int)length, NULL, 0);
+    if (utf16_len <= 0) {
+        return QALAM_ERROR_ENCODING;
+    }
+    
+    /* Make room: grow the gap, or the piece table's add buffer */
+    size_t pos = buffer_cursor_offset(buffer);
+    UndoState before = buffer_undo_state(buffer);
+    wchar_t* dest;
+    result = undo_journal_reserve(&buffer->undo, buffer_undo_table(buffer), 0, NULL);
+    if (result != QALAM_OK) {
+        return result;
+    }
+    
+    if (buffer_is_piece_table(buffer)) {
+        result = piece_table_reserve_add(&buffer->pieces, (size_t)utf16_len, &dest);
+    } else {
+        result = buffer_move_gap_to(buffer, pos);
+        if (result == QALAM_OK) {
+            result = buffer_ensure_gap_size(buffer, (size_t)utf16_len);
+        }
+        dest = buffer->data + buffer->gap_start;
+    }
+    if (result != QALAM_OK) {
+        return result;
+    }
+    
+    /* Convert directly into the reserved space */
+    int converted = MultiByteToWideChar(
+        CP_UTF8, 0,
+        text, (int)length,
+        dest, utf16_len
+    );
+    
+    if (converted <= 0) {
+        return QALAM_ERROR_ENCODING;
+    }
+    
+    /* A single character typed in may extend the previous undo record */
+    bool keystroke = converted == 1 || (converted == 2 && is_high_surrogate(dest[0]));
+    
+    /* Record new lines in the line index */
+    size_t lines_before = buffer_line_count(buffer);
+    result = line_index_insert(&buffer->lines, pos, dest, (size_t)converted);
+    if (result != QALAM_OK) {
+        return result;
+    }
+    
+    /* Link the new text into the piece table */
+    if (buffer_is_piece_table(buffer)) {
+        result = piece_table_insert(&buffer->pieces, pos, (size_t)converted);
+        if (result != QALAM_OK) {
+            line_index_delete(&buffer->lines, pos, (size_t)converted);
+            return result;
+        }
+    }
+    
+    /* Update cursor position from the inserted span only */
+    buffer_advance_cursor(buffer, dest, (size_t)converted,
+                          buffer_line_count(buffer) - lines_before);
+    
+    /* Advance past the inserted text */
+    buffer->cursor_offset += (size_t)converted;
+    if (!buffer_is_piece_table(buffer)) {
+        buffer->gap_start += converted;
+    }
+    buffer->modified = true;
+    
+    UndoState after = buffer_undo_state(buffer);
+    undo_journal_record(&buffer->undo, buffer_undo_table(buffer), UNDO_RECORD_INSERT,
+                        UNDO_DELETE_RANGE, keystroke, pos, (size_t)converted, NULL, &before,
+                        &after);
+    
+    buffer_note_edit(buffer, pos, lines_before);
+    buffer_flush_change(buffer);
+    
+    return QALAM_OK;
+}
+
+/**
+ * @brief Insert text at specified position
+ */
+QalamResult qalam_buffer_insert_at(QalamBuffer* buffer, size_t offset, const char* text, size_t length) {
+    if (!buffer) {
+        return QALAM_ERROR_NULL_POINTER;
+    }
+    if (buffer->readonly) {
+        return QALAM_ERROR_BUFFER_READONLY;
+    }
+    
+    size_t content_len = buffer_content_length(buffer);
+    if (offset > content_len) {
+        return QALAM_ERROR_INVALID_POSITION;
+    }
+    
+    /* Move cursor (and gap) to insertion point */
+    if (offset != buffer_cursor_offset(buffer)) {
+        buffer_move_cursor_to(buffer, offset);
+        buffer_update_cursor_from_offset(buffer);
+    }
     
     /* Insert using standard function */
     return qalam_buffer_insert(buffer, text, length);
 }
 
 /**
- * @brief Delete characters at current cursor position
+ * @brief Delete characters at current cursor position
+ */
+QalamResult qalam_buffer_delete(QalamBuffer* buffer, int count) {
+    if (!buffer) {
+        return QALAM_ERROR_NULL_POINTER;
+    }
+    if (buffer->readonly) {
+        return QALAM_ERROR_BUFFER_READONLY;
+    }
+    
+    QalamResult result = buffer_wake(buffer);
+    if (result != QALAM_OK) {
+        return result;
+    }
+    
+    if (count == 0) {
+        return QALAM_OK;
+    }
+    
+    size_t content_len = buffer_content_length(buffer);
+    size_t cursor = buffer_cursor_offset(buffer);
+    UndoState before = buffer_undo_state(buffer);
+    
+    /* Single-character deletes coalesce into one undo record */
+    bool keystroke = count == 1 || count == -1;
+    
+    if (count > 0) {
+        /* Delete forward */
+        size_t after_cursor = content_len - cursor;
+        size_t to_delete = (size_t)count;
+        
+        if (to_delete > after_cursor) {
+            to_delete = after_cursor;
+        }
+        
+        if (to_delete == 0) {
+            return QALAM_OK; /* Nothing after cursor */
+        }
+        
+        /* Handle surrogate pairs - don't split them */
+        wchar_t last = buffer_char_at_internal(buffer, cursor + to_delete - 1);
+        if (is_high_surrogate(last) && cursor + to_delete < content_len) {
+            wchar_t next = buffer_char_at_internal(buffer, cursor + to_delete);
+            if (is_low_surrogate(next)) {
+                to_delete++; /* Include the low surrogate */
+            }
+        }
+        
+        QalamResult result = buffer_remove_recorded(buffer, cursor, to_delete,
+                                                    keystroke ? UNDO_DELETE_FORWARD
+                                                              : UNDO_DELETE_RANGE,
+                                                    &before);
+        if (result != QALAM_OK) {
+            return result;
+        }
+    } else {
+        /* Delete backward (negative count = backspace) */
+        size_t to_delete = (size_t)(-count);
+        
+        if (to_delete > cursor) {
+            to_delete = cursor;
+        }
+        
+        if (to_delete == 0) {
+            return QALAM_OK; /* Nothing before cursor */
+        }
+        
+        /* Handle surrogate pairs - don't split them */
+        if (to_delete > 0) {
+            size_t check_pos = cursor - to_delete;
+            wchar_t ch = buffer_char_at_internal(buffer, check_pos);
+            if (is_low_surrogate(ch) && check_pos > 0) {
+                wchar_t prev = buffer_char_at_internal(buffer, check_pos - 1);
+                if (is_high_surrogate(prev)) {
+                    to_delete++; /* Include the high surrogate */
+                }
+            }
+        }
+        
+        size_t lines_before = buffer_line_count(buffer);
+        QalamResult result = buffer_remove_recorded(buffer, cursor - to_delete, to_delete,
+                                                    keystroke ? UNDO_DELETE_BACKWARD
+                                                              : UNDO_DELETE_RANGE,
+                                                    &before);
+        if (result != QALAM_OK) {
+            return result;
+        }
+        
+        /* Within a line the column just shrinks; otherwise ask the index */
+        if (buffer_line_count(buffer) == lines_before) {
+            buffer->cursor_column -= to_delete;
+        } else {
+            buffer_update_cursor_from_offset(buffer);
+        }
+    }
+    
+    /* Forward deletes leave the cursor where it is */
+    buffer->modified = true;
+    buffer_flush_change(buffer);
+    
+    return QALAM_OK;
+}
+
+/**
+ * @brief Delete a range of text
+ */
+QalamResult qalam_buffer_delete_range(QalamBuffer* buffer, size_t start_offset, size_t end_offset) {
+    if (!buffer) {
+        return QALAM_ERROR_NULL_POINTER;
+    }
+    if (buffer->readonly) {
+        return QALAM_ERROR_BUFFER_READONLY;
+    }
+    
+    QalamResult result = buffer_wake(buffer);
+    if (result != QALAM_OK) {
+        return result;
+    }
+    
+    if (start_offset > end_offset) {
+        /* Swap */
+        size_t temp = start_offset;
+        start_offset = end_offset;
+        end_offset = temp;
+    }
+    
+    size_t content_len = buffer_content_length(buffer);
+    
+    if (start_offset > content_len) {
+        return QALAM_ERROR_INVALID_RANGE;
+    }
+    
+    if (end_offset > content_len) {
+        end_offset = content_len;
+    }
+    
+    size_t delete_len = end_offset - start_offset;
+    if (delete_len == 0) {
+        return QALAM_OK;
+    }
+    
+    /* Remove the range; the cursor ends up at its start */
+    UndoState before = buffer_undo_state(buffer);
+    result = buffer_remove_recorded(buffer, start_offset, delete_len, UNDO_DELETE_RANGE,
+                                    &before);
+    if (result != QALAM_OK) {
+        return result;
+    }
+    
+    buffer->modified = true;
+    buffer_update_cursor_from_offset(buffer);
+    buffer_flush_change(buffer);
+    
+    return QALAM_OK;
+}
+
+/**
+ * @brief Replace text in a range
+ */
+QalamResult qalam_buffer_replace(QalamBuffer* buffer, size_t start_offset, size_t end_offset, 
+                                  const char* text, size_t length) {
+    if (!buffer) {
+        return QALAM_ERROR_NULL_POINTER;
+    }
+    
+    /* Both halves are undone together */
+    QalamResult result = qalam_buffer_begin_undo_group(buffer);
+    if (result != QALAM_OK) {
+        return result;
+    }
+    
+    /* Delete range first */
+    result = qalam_buffer_delete_range(buffer, start_offset, end_offset);
+    
+    /* Insert new text at start position */
+    if (result == QALAM_OK) {
+        result = qalam_buffer_insert_at(buffer, start_offset < end_offset ? start_offset : end_offset,
+                                        text, length);
+    }
+    
+    qalam_buffer_end_undo_group(buffer);
+    return result;
+}
+
+/*=============================================================================
+ * Undo and Redo
+ *============================================================================*/
+
+/**
+ * @brief Undo the most recent group of edits
+ */
+QalamResult qalam_buffer_undo(QalamBuffer* buffer) {
+    if (!buffer) {
+        return QALAM_ERROR_NULL_POINTER;
+    }
+    if (buffer->readonly) {
+        return QALAM_ERROR_BUFFER_READONLY;
+    }
+    
+    QalamResult result = buffer_wake(buffer);
+    if (result != QALAM_OK) {
+        return result;
+    }
+    
+    UndoJournal* journal = &buffer->undo;
+    if (journal->depth > 0) {
+        return QALAM_ERROR_INVALID_ARGUMENT;
+    }
+    if (journal->applied == 0) {
+        return QALAM_OK;
+    }
+    
+    const UndoGroup* group = &journal->groups[journal->applied - 1];
+    result = buffer_undo_apply_group(buffer, group, true);
+    if (result != QALAM_OK) {
+        return result;
+    }
+    
+    journal->applied--;
+    undo_journal_seal(journal);
+    buffer_undo_apply_state(buffer, &group->before);
+    buffer->modified = true;
+    buffer_flush_change(buffer);
+    
+    return QALAM_OK;
+}
+
+/**
+ * @brief Redo the most recently undone group of edits
+ */
+QalamResult qalam_buffer_redo(QalamBuffer* buffer) {
+    if (!buffer) {
+        return QALAM_ERROR_NULL_POINTER;
+    }
+    if (buffer->readonly) {
+        return QALAM_ERROR_BUFFER_READONLY;
+    }
+    
+    QalamResult result = buffer_wake(buffer);
+    if (result != QALAM_OK) {
+        return result;
+    }
+    
+    UndoJournal* journal = &buffer->undo;
+    if (journal->depth > 0) {
+        return QALAM_ERROR_INVALID_ARGUMENT;
+    }
+    if (journal->applied == journal->group_count) {
+        return QALAM_OK;
+    }
+    
+    const UndoGroup* group = &journal->groups[journal->applied];
+    result = buffer_undo_apply_group(buffer, group, false);
+    if (result != QALAM_OK) {
+        return result;
+    }
+    
+    journal->applied++;
+    undo_journal_seal(journal);
+    buffer_undo_apply_state(buffer, &group->after);
+    buffer->modified = true;
+    buffer_flush_change(buffer);
+    
+    return QALAM_OK;
+}
+
+/**
+ * @brief Check whether there is anything to undo
+ */
+bool qalam_buffer_can_undo(const QalamBuffer* buffer) {
+    return buffer && buffer->undo.depth == 0 && buffer->undo.applied > 0;
+}
+
+/**
+ * @brief Check whether there is anything to redo
+ */
+bool qalam_buffer_can_redo(const QalamBuffer* buffer) {
+    return buffer && buffer->undo.depth == 0 && buffer->undo.applied < buffer->undo.group_count;
+}
+
+/**
+ * @brief Start grouping edits into one undo step
+ */
+QalamResult qalam_buffer_begin_undo_group(QalamBuffer* buffer) {
+    if (!buffer) {
+        return QALAM_ERROR_NULL_POINTER;
+    }
+    
+    UndoState before = buffer_undo_state(buffer);
+    return undo_journal_begin_group(&buffer->undo, &before);
+}
+
+/**
+ * @brief Finish a group started with qalam_buffer_begin_undo_group()
  */
-QalamResult qalam_buffer_delete(QalamBuffer* buffer, int count) {
+QalamResult qalam_buffer_end_undo_group(QalamBuffer* buffer) {
     if (!buffer) {
         return QALAM_ERROR_NULL_POINTER;
     }
     
-    if (count == 0) {
-        return QALAM_OK;
+    UndoState after = buffer_undo_state(buffer);
+    QalamResult result = undo_journal_end_group(&buffer->undo, &after);
+    
+    /* Edits made inside the group are reported together */
+    buffer_flush_change(buffer);
+    return result;
+}
+
+/**
+ * @brief Discard the undo and redo history
+ */
+void qalam_buffer_clear_undo(QalamBuffer* buffer) {
+    if (!buffer || buffer->undo.depth > 0) {
+        return;
+    }
+    undo_journal_free(&buffer->undo, buffer_undo_table(buffer));
+}
+
+/*=============================================================================
+ * Edit Transactions
+ *============================================================================*/
+
+/**
+ * @brief Start collecting replacements to apply in one pass
+ */
+QalamResult qalam_buffer_begin_edit(QalamBuffer* buffer) {
+    if (!buffer) {
+        return QALAM_ERROR_NULL_POINTER;
+    }
+    if (buffer->readonly) {
+        return QALAM_ERROR_BUFFER_READONLY;
+    }
+    if (buffer->batch.open) {
+        return QALAM_ERROR_INVALID_ARGUMENT;
     }
     
-    size_t content_len = buffer_content_length(buffer);
+    buffer->batch.open = true;
+    buffer->batch.edit_count = 0;
+    buffer->batch.text_length = 0;
+    return QALAM_OK;
+}
+
+/**
+ * @brief Queue a replacement in the open transaction
+ */
+QalamResult qalam_buffer_edit_replace(QalamBuffer* buffer, size_t start_offset, size_t end_offset,
+                                      const char* text, size_t length) {
+    if (!buffer) {
+        return QALAM_ERROR_NULL_POINTER;
+    }
     
-    if (count > 0) {
-        /* Delete forward */
-        size_t after_gap = buffer->capacity - buffer->gap_end;
-        size_t to_delete = (size_t)count;
-        
-        if (to_delete > after_gap) {
-            to_delete = after_gap;
+    BufferEditBatch* batch = &buffer->batch;
+    if (!batch->open) {
+        return QALAM_ERROR_INVALID_ARGUMENT;
+    }
+    
+    if (start_offset > end_offset) {
+        /* Swap */
+        size_t temp = start_offset;
+        start_offset = end_offset;
+        end_offset = temp;
+    }
+    
+    BufferEdit* previous = batch->edit_count > 0 ? &batch->edits[batch->edit_count - 1] : NULL;
+    if (previous && start_offset < previous->end) {
+        return QALAM_ERROR_INVALID_RANGE;
+    }
+    
+    if (!text) {
+        length = 0;
+    }
+    if (start_offset == end_offset && length == 0) {
+        return QALAM_OK; /* Nothing to do */
+    }
+    
+    int utf16_len = 0;
+    if (length > 0) {
+        utf16_len = MultiByteToWideChar(CP_UTF8, 0, text, (int)length, NULL, 0);
+        if (utf16_len <= 0) {
+            return QALAM_ERROR_ENCODING;
         }
-        
-        if (to_delete == 0) {
-            return QALAM_OK; /* Nothing after cursor */
+    }
+    
+    QalamResult result = buffer_batch_grow((void**)&batch->edits, &batch->edit_capacity,
+                                           batch->edit_count + 1, sizeof(BufferEdit));
+    if (result == QALAM_OK) {
+        result = buffer_batch_grow((void**)&batch->text, &batch->text_capacity,
+                                   batch->text_length + (size_t)utf16_len, sizeof(wchar_t));
+    }
+    if (result != QALAM_OK) {
+        return result;
+    }
+    
+    /* The array may have moved */
+    previous = batch->edit_count > 0 ? &batch->edits[batch->edit_count - 1] : NULL;
+    BufferEdit* edit = &batch->edits[batch->edit_count];
+    edit->start = start_offset;
+    edit->end = end_offset;
+    edit->text = batch->text_length;
+    edit->length = 0;
+    
+    if (utf16_len > 0) {
+        wchar_t* dest = batch->text + batch->text_length;
+        int converted = MultiByteToWideChar(CP_UTF8, 0, text, (int)length, dest, utf16_len);
+        if (converted <= 0) {
+            return QALAM_ERROR_ENCODING;
         }
+        edit->length = (size_t)converted;
         
-        /* Count newlines being deleted */
-        size_t newlines = 0;
-        for (size_t i = 0; i < to_delete; i++) {
-            /* Handle surrogate pairs - don't split them */
-            wchar_t ch = buffer->data[buffer->gap_end + i];
-            if (ch == L'\n') {
-                newlines++;
-            }
-            /* If we hit a low surrogate at position 0, skip it */
-            if (i == to_delete - 1 && is_high_surrogate(ch) && 
-                buffer->gap_end + i + 1 < buffer->capacity) {
-                wchar_t next = buffer->data[buffer->gap_end + i + 1];
-                if (is_low_surrogate(next)) {
-                    to_delete++; /* Include the low surrogate */
-                }
-            }
+        /* Replace-all repeats one replacement; keep a single copy of it */
+        if (previous && previous->length == edit->length &&
+            memcmp(batch->text + previous->text, dest, edit->length * sizeof(wchar_t)) == 0) {
+            edit->text = previous->text;
+        } else {
+            batch->text_length += edit->length;
         }
-        
-        /* Expand gap to consume deleted text */
-        buffer->gap_end += to_delete;
-        buffer->line_count -= newlines;
-        if (buffer->line_count < 1) {
-            buffer->line_count = 1;
+    }
+    
+    batch->edit_count++;
+    return QALAM_OK;
+}
+
+/**
+ * @brief Apply an open transaction's edits
+ */
+static QalamResult buffer_batch_apply(QalamBuffer* buffer) {
+    BufferEditBatch* batch = &buffer->batch;
+    size_t count = batch->edit_count;
+    
+    if (count == 0) {
+        return QALAM_OK;
+    }
+    if (batch->edits[count - 1].end > buffer_content_length(buffer)) {
+        return QALAM_ERROR_INVALID_RANGE;
+    }
+    
+    /* Totals, and the most the text grows at any point of the sweep */
+    size_t inserted = 0;
+    size_t deleted = 0;
+    size_t peak = 0;
+    for (size_t i = 0; i < count; i++) {
+        inserted += batch->edits[i].length;
+        deleted += batch->edits[i].end - batch->edits[i].start;
+        if (inserted > deleted && inserted - deleted > peak) {
+            peak = inserted - deleted;
         }
+    }
+    
+    /* Everything that can fail up front is done before the text changes */
+    QalamResult result = buffer_batch_plan_lines(buffer);
+    PieceTable* table = buffer_undo_table(buffer);
+    if (result == QALAM_OK) {
+        result = undo_journal_reserve_records(&buffer->undo, table, 2 * count,
+                                              table ? 0 : deleted);
+    }
+    if (result == QALAM_OK && !table) {
+        /* The sweep starts with the gap at the first edit */
+        result = buffer_move_gap_to(buffer, batch->edits[0].start);
+    }
+    if (result == QALAM_OK) {
+        wchar_t* dest;
+        result = table ? piece_table_reserve_add(table, inserted, &dest)
+                       : buffer_ensure_gap_size(buffer, peak);
+    }
+    if (result == QALAM_OK && !table) {
+        /* ...and writes at most 'peak' past the end of the last */
+        result = buffer_commit(buffer, buffer->gap_start, batch->edits[count - 1].end + peak);
+    }
+    if (result != QALAM_OK) {
+        return result;
+    }
+    
+    size_t cursor = buffer_batch_map_offset(batch, buffer_cursor_offset(buffer));
+    UndoState before = buffer_undo_state(buffer);
+    undo_journal_begin_group(&buffer->undo, &before);
+    
+    if (table) {
+        result = buffer_batch_sweep_pieces(buffer, &before);
     } else {
-        /* Delete backward (negative count = backspace) */
-        size_t to_delete = (size_t)(-count);
-        
-        if (to_delete > buffer->gap_start) {
-            to_delete = buffer->gap_start;
-        }
-        
-        if (to_delete == 0) {
-            return QALAM_OK; /* Nothing before cursor */
-        }
-        
-        /* Handle surrogate pairs - don't split them */
-        if (to_delete > 0) {
-            size_t check_pos = buffer->gap_start - to_delete;
-            wchar_t ch = buffer->data[check_pos];
-            if (is_low_surrogate(ch) && check_pos > 0) {
-                wchar_t prev = buffer->data[check_pos - 1];
-                if (is_high_surrogate(prev)) {
-                    to_delete++; /* Include the high surrogate */
-                }
-            }
-        }
-        
-        /* Count newlines being deleted */
-        size_t newlines = 0;
-        for (size_t i = 0; i < to_delete; i++) {
-            if (buffer->data[buffer->gap_start - 1 - i] == L'\n') {
-                newlines++;
-            }
-        }
-        
-        /* Shrink gap_start to consume deleted text */
-        buffer->gap_start -= to_delete;
-        buffer->line_count -= newlines;
-        if (buffer->line_count < 1) {
-            buffer->line_count = 1;
+        buffer_batch_sweep_gap(buffer, &before);
+        buffer_trim_gap(buffer);
+    }
+    
+    /* Later clusters first, so earlier line numbers still hold */
+    for (size_t i = batch->cluster_count; i-- > 0 && result == QALAM_OK;) {
+        const BufferEditCluster* cluster = &batch->clusters[i];
+        result = line_index_replace_lines(&buffer->lines, cluster->first_line,
+                                          cluster->old_count, batch->lens + cluster->lens,
+                                          cluster->new_count);
+        if (result == QALAM_OK) {
+            buffer_note_lines(buffer, cluster->first_line, cluster->old_count,
+                              cluster->new_count);
         }
     }
     
-    buffer->modified = true;
+    size_t content_len = buffer_content_length(buffer);
+    buffer_move_cursor_to(buffer, cursor < content_len ? cursor : content_len);
     buffer_update_cursor_from_offset(buffer);
+    buffer->modified = true;
     
-    return QALAM_OK;
+    UndoState after = buffer_undo_state(buffer);
+    undo_journal_end_group(&buffer->undo, &after);
+    return result;
 }
 
 /**
- * @brief Delete a range of text
+ * @brief Apply the queued replacements and close the transaction
  */
-QalamResult qalam_buffer_delete_range(QalamBuffer* buffer, size_t start_offset, size_t end_offset) {
+QalamResult qalam_buffer_commit_edit(QalamBuffer* buffer) {
     if (!buffer) {
         return QALAM_ERROR_NULL_POINTER;
     }
+    if (!buffer->batch.open) {
+        return QALAM_ERROR_INVALID_ARGUMENT;
+    }
+    if (buffer->readonly) {
+        buffer_batch_free(&buffer->batch);
+        return QALAM_ERROR_BUFFER_READONLY;
+    }
     
-    if (start_offset > end_offset) {
-        /* Swap */
-        size_t temp = start_offset;
-        start_offset = end_offset;
-        end_offset = temp;
+    QalamResult result = buffer_wake(buffer);
+    if (result != QALAM_OK) {
+        return result;
     }
     
-    size_t content_len = buffer_content_length(buffer);
+    result = buffer_batch_apply(buffer);
+    buffer_batch_free(&buffer->batch);
+    buffer_flush_change(buffer);
     
-    if (start_offset > content_len) {
-        return QALAM_ERROR_INVALID_RANGE;
+    return result;
+}
+
+/**
+ * @brief Discard the queued replacements and close the transaction
+ */
+void qalam_buffer_cancel_edit(QalamBuffer* buffer) {
+    if (buffer) {
+        buffer_batch_free(&buffer->batch);
+    }
+}
+
+/*=============================================================================
+ * Change Notification
+ *============================================================================*/
+
+/**
+ * @brief Set the callback told about changes to the buffer
+ */
+QalamResult qalam_buffer_set_change_callback(QalamBuffer* buffer,
+                                             QalamBufferChangeCallback callback,
+                                             void* user_data) {
+    if (!buffer) {
+        return QALAM_ERROR_NULL_POINTER;
     }
     
-    if (end_offset > content_len) {
-        end_offset = content_len;
+    buffer->change_callback = callback;
+    buffer->change_user_data = user_data;
+    buffer->change_pending = false;
+    return QALAM_OK;
+}
+
+/*=============================================================================
+ * Internal Helper Functions - Search
+ *============================================================================*/
+
+/**
+ * @brief First match of a pass
+ */
+typedef struct BufferSearchFirst {
+    QalamSearchMatch match;     /**< Match found */
+    bool found;                 /**< 'match' is set */
+} BufferSearchFirst;
+
+/**
+ * @brief Matches of a qalam_buffer_find_all() pass
+ */
+typedef struct BufferSearchAll {
+    const QalamBuffer* buffer;  /**< Buffer being searched */
+    QalamSearchMatchCallback callback; /**< User callback, or NULL */
+    void* user_data;            /**< Context for callback */
+    size_t count;               /**< Matches reported */
+} BufferSearchAll;
+
+/**
+ * @brief Compile a UTF-8 pattern
+ */
+static QalamResult buffer_compile_search(SearchPattern* compiled, const char* pattern,
+                                         size_t length, const QalamSearchOptions* options) {
+    if (length == 0) {
+        compiled->length = 0;
+        return QALAM_ERROR_INVALID_ARGUMENT;
     }
     
-    size_t delete_len = end_offset - start_offset;
-    if (delete_len == 0) {
-        return QALAM_OK;
+    int utf16_len = MultiByteToWideChar(CP_UTF8, 0, pattern, (int)length, NULL, 0);
+    if (utf16_len <= 0) {
+        compiled->length = 0;
+        return QALAM_ERROR_ENCODING;
+    }
+    
+    wchar_t* text = (wchar_t*)qalam_mem_alloc(QALAM_MEMORY_BUFFER,
+                                              (size_t)utf16_len * sizeof(wchar_t));
+    if (!text) {
+        compiled->length = 0;
+        return QALAM_ERROR_OUT_OF_MEMORY;
+    }
+    MultiByteToWideChar(CP_UTF8, 0, pattern, (int)length, text, utf16_len);
+    
+    QalamResult result = search_pattern_compile(compiled, text, (size_t)utf16_len,
+                                                options->ignore_case, options->arabic_folding);
+    qalam_mem_free(text);
+    return result;
+}
+
+/**
+ * @brief Segment callback feeding a search pass
+ */
+static bool buffer_search_segment(const wchar_t* text, size_t len, void* context) {
+    return search_scan_feed((SearchScan*)context, text, len);
+}
+
+/**
+ * @brief Report the matches of a pattern that start in [start, limit)
+ * 
+ * The text is fed to the scan straight from storage, from 'start' until
+ * the scan needs no more.
+ */
+static QalamResult buffer_search_pass(const QalamBuffer* buffer, const SearchPattern* pattern,
+                                      const QalamSearchOptions* options, size_t start,
+                                      size_t limit, SearchMatchFn on_match, void* context) {
+    SearchScan scan;
+    search_scan_init(&scan, pattern, start, limit, on_match, context, options);
+    
+    size_t length = buffer_content_length(buffer);
+    if (start < length &&
+        buffer_for_each_segment(buffer, start, length - start, buffer_search_segment, &scan)) {
+        search_scan_finish(&scan);
+    }
+    
+    QalamResult result = scan.result;
+    search_scan_free(&scan);
+    return result;
+}
+
+/**
+ * @brief Match callback keeping the first match
+ */
+static bool buffer_search_first(void* context, size_t start, size_t end) {
+    BufferSearchFirst* first = (BufferSearchFirst*)context;
+    first->match.start_offset = start;
+    first->match.end_offset = end;
+    first->found = true;
+    return false;
+}
+
+/**
+ * @brief Match callback for qalam_buffer_find_all()
+ */
+static bool buffer_search_each(void* context, size_t start, size_t end) {
+    BufferSearchAll* all = (BufferSearchAll*)context;
+    all->count++;
+    if (!all->callback) {
+        return true;
+    }
+    
+    QalamSearchMatch match = { start, end };
+    return all->callback(all->buffer, &match, all->user_data);
+}
+
+/**
+ * @brief Find the buffer's search pattern from an offset, wrapping if asked
+ */
+static QalamResult buffer_search_from(QalamBuffer* buffer, size_t from, QalamSearchMatch* match,
+                                      bool* found) {
+    size_t length = buffer_content_length(buffer);
+    if (from > length) {
+        from = length;
+    }
+    
+    BufferSearchFirst first = { { 0, 0 }, false };
+    QalamResult result = buffer_search_pass(buffer, &buffer->search, &buffer->search_options,
+                                            from, SIZE_MAX, buffer_search_first, &first);
+    if (result == QALAM_OK && !first.found && buffer->search_options.wrap && from > 0) {
+        result = buffer_search_pass(buffer, &buffer->search, &buffer->search_options,
+                                    0, from, buffer_search_first, &first);
+    }
+    if (result != QALAM_OK) {
+        return result;
+    }
+    
+    *found = first.found;
+    if (first.found) {
+        *match = first.match;
+    }
+    buffer->search_next = first.found ? first.match.end_offset : from;
+    return QALAM_OK;
+}
+
+/*=============================================================================
+ * Search
+ *============================================================================*/
+
+/**
+ * @brief Get the default search options
+ */
+QalamResult qalam_buffer_get_default_search_options(QalamSearchOptions* options) {
+    if (!options) {
+        return QALAM_ERROR_NULL_POINTER;
+    }
+    
+    memset(options, 0, sizeof(QalamSearchOptions));
+    return QALAM_OK;
+}
+
+/**
+ * @brief Find the first match at or after an offset
+ */
+QalamResult qalam_buffer_find(QalamBuffer* buffer, const char* pattern, size_t length,
+                              size_t start_offset, const QalamSearchOptions* options,
+                              QalamSearchMatch* match, bool* found) {
+    if (!buffer || !pattern || !match || !found) {
+        return QALAM_ERROR_NULL_POINTER;
+    }
+    *found = false;
+    
+    QalamResult result = buffer_wake(buffer);
+    if (result != QALAM_OK) {
+        return result;
+    }
+    
+    QalamSearchOptions defaults;
+    if (!options) {
+        qalam_buffer_get_default_search_options(&defaults);
+        options = &defaults;
+    }
+    
+    result = buffer_compile_search(&buffer->search, pattern, length, options);
+    if (result != QALAM_OK) {
+        return result;
+    }
+    buffer->search_options = *options;
+    
+    return buffer_search_from(buffer, start_offset, match, found);
+}
+
+/**
+ * @brief Repeat the last search after its match
+ */
+QalamResult qalam_buffer_find_next(QalamBuffer* buffer, QalamSearchMatch* match, bool* found) {
+    if (!buffer || !match || !found) {
+        return QALAM_ERROR_NULL_POINTER;
     }
+    *found = false;
     
-    /* Count newlines in range being deleted */
-    size_t newlines = buffer_count_newlines_in_range(buffer, start_offset, delete_len);
-    
-    /* Move gap to start of range, then delete forward */
-    buffer_move_gap_to(buffer, start_offset);
-    buffer->gap_end += delete_len;
-    
-    buffer->line_count -= newlines;
-    if (buffer->line_count < 1) {
-        buffer->line_count = 1;
+    QalamResult result = buffer_wake(buffer);
+    if (result != QALAM_OK) {
+        return result;
     }
     
-    buffer->modified = true;
-    buffer_update_cursor_from_offset(buffer);
-    
-    return QALAM_OK;
+    if (buffer->search.length == 0) {
+        return QALAM_ERROR_INVALID_ARGUMENT;
+    }
+    return buffer_search_from(buffer, buffer->search_next, match, found);
 }
 
 /**
- * @brief Replace text in a range
+ * @brief Report every match in the buffer
  */
-QalamResult qalam_buffer_replace(QalamBuffer* buffer, size_t start_offset, size_t end_offset, 
-                                  const char* text, size_t length) {
-    if (!buffer) {
+QalamResult qalam_buffer_find_all(QalamBuffer* buffer, const char* pattern, size_t length,
+                                  const QalamSearchOptions* options,
+                                  QalamSearchMatchCallback callback, void* user_data,
+                                  size_t* count) {
+    if (count) {
+        *count = 0;
+    }
+    if (!buffer || !pattern) {
         return QALAM_ERROR_NULL_POINTER;
     }
     
-    /* Delete range first */
-    QalamResult result = qalam_buffer_delete_range(buffer, start_offset, end_offset);
+    QalamResult result = buffer_wake(buffer);
     if (result != QALAM_OK) {
         return result;
     }
     
-    /* Insert new text at start position */
-    buffer_move_gap_to(buffer, start_offset);
-    return qalam_buffer_insert(buffer, text, length);
+    QalamSearchOptions defaults;
+    if (!options) {
+        qalam_buffer_get_default_search_options(&defaults);
+        options = &defaults;
+    }
+    
+    /* A separate pattern leaves qalam_buffer_find_next() where it was */
+    SearchPattern compiled;
+    memset(&compiled, 0, sizeof(SearchPattern));
+    result = buffer_compile_search(&compiled, pattern, length, options);
+    
+    BufferSearchAll all = { buffer, callback, user_data, 0 };
+    if (result == QALAM_OK) {
+        result = buffer_search_pass(buffer, &compiled, options, 0, SIZE_MAX,
+                                    buffer_search_each, &all);
+    }
+    search_pattern_free(&compiled);
+    
+    if (count) {
+        *count = all.count;
+    }
+    return result;
 }
 
 /*=============================================================================
@@ -890,7 +3292,7 @@ QalamResult qalam_buffer_get_cursor(const QalamBuffer* buffer, QalamCursor* curs
     
     cursor->line = buffer->cursor_line;
     cursor->column = buffer->cursor_column;
-    cursor->offset = buffer->gap_start;
+    cursor->offset = buffer_cursor_offset(buffer);
     cursor->visual_column = buffer->cursor_column; /* TODO: handle tabs/RTL */
     
     return QALAM_OK;
@@ -904,8 +3306,8 @@ QalamResult qalam_buffer_set_cursor(QalamBuffer* buffer, size_t line, size_t col
         return QALAM_ERROR_NULL_POINTER;
     }
     
-    if (line >= buffer->line_count) {
-        line = buffer->line_count - 1;
+    if (line >= buffer_line_count(buffer)) {
+        line = buffer_line_count(buffer) - 1;
     }
     
     /* Get line length to clamp column */
@@ -917,8 +3319,8 @@ QalamResult qalam_buffer_set_cursor(QalamBuffer* buffer, size_t line, size_t col
     /* Calculate offset */
     size_t offset = buffer_offset_from_line_column(buffer, line, column);
     
-    /* Move gap to new position */
-    buffer_move_gap_to(buffer, offset);
+    /* Move cursor (and gap) to new position */
+    buffer_move_cursor_to(buffer, offset);
     
     buffer->cursor_line = line;
     buffer->cursor_column = column;
@@ -934,6 +3336,11 @@ QalamResult qalam_buffer_set_cursor_offset(QalamBuffer* buffer, size_t offset) {
         return QALAM_ERROR_NULL_POINTER;
     }
     
+    QalamResult result = buffer_wake(buffer);
+    if (result != QALAM_OK) {
+        return result;
+    }
+    
     size_t content_len = buffer_content_length(buffer);
     if (offset > content_len) {
         offset = content_len;
@@ -947,7 +3354,7 @@ QalamResult qalam_buffer_set_cursor_offset(QalamBuffer* buffer, size_t offset) {
         }
     }
     
-    buffer_move_gap_to(buffer, offset);
+    buffer_move_cursor_to(buffer, offset);
     buffer_update_cursor_from_offset(buffer);
     
     return QALAM_OK;
@@ -972,8 +3379,8 @@ QalamResult qalam_buffer_move_cursor(QalamBuffer* buffer, int delta_line, int de
         }
     } else {
         new_line += (size_t)delta_line;
-        if (new_line >= buffer->line_count) {
-            new_line = buffer->line_count - 1;
+        if (new_line >= buffer_line_count(buffer)) {
+            new_line = buffer_line_count(buffer) - 1;
         }
     }
     
@@ -1001,7 +3408,7 @@ QalamResult qalam_buffer_cursor_to_start(QalamBuffer* buffer) {
         return QALAM_ERROR_NULL_POINTER;
     }
     
-    buffer_move_gap_to(buffer, 0);
+    buffer_move_cursor_to(buffer, 0);
     buffer->cursor_line = 0;
     buffer->cursor_column = 0;
     
@@ -1017,7 +3424,7 @@ QalamResult qalam_buffer_cursor_to_end(QalamBuffer* buffer) {
     }
     
     size_t content_len = buffer_content_length(buffer);
-    buffer_move_gap_to(buffer, content_len);
+    buffer_move_cursor_to(buffer, content_len);
     buffer_update_cursor_from_offset(buffer);
     
     return QALAM_OK;
@@ -1032,7 +3439,7 @@ QalamResult qalam_buffer_cursor_to_line_start(QalamBuffer* buffer) {
     }
     
     size_t line_start = buffer_get_line_start_offset(buffer, buffer->cursor_line);
-    buffer_move_gap_to(buffer, line_start);
+    buffer_move_cursor_to(buffer, line_start);
     buffer->cursor_column = 0;
     
     return QALAM_OK;
@@ -1049,7 +3456,7 @@ QalamResult qalam_buffer_cursor_to_line_end(QalamBuffer* buffer) {
     size_t line_start = buffer_get_line_start_offset(buffer, buffer->cursor_line);
     size_t line_len = buffer_get_line_length(buffer, buffer->cursor_line);
     
-    buffer_move_gap_to(buffer, line_start + line_len);
+    buffer_move_cursor_to(buffer, line_start + line_len);
     buffer->cursor_column = line_len;
     
     return QALAM_OK;
@@ -1068,7 +3475,12 @@ QalamResult qalam_buffer_get_line(const QalamBuffer* buffer, size_t line_number,
         return QALAM_ERROR_NULL_POINTER;
     }
     
-    if (line_number >= buffer->line_count) {
+    QalamResult result = buffer_wake(buffer);
+    if (result != QALAM_OK) {
+        return result;
+    }
+    
+    if (line_number >= buffer_line_count(buffer)) {
         return QALAM_ERROR_INVALID_RANGE;
     }
     
@@ -1084,36 +3496,37 @@ QalamResult qalam_buffer_get_line(const QalamBuffer* buffer, size_t line_number,
         return QALAM_OK;
     }
     
-    /* Allocate temporary buffer for UTF-16 content */
-    wchar_t* temp = (wchar_t*)malloc((line_len + 1) * sizeof(wchar_t));
-    if (!temp) {
-        return QALAM_ERROR_OUT_OF_MEMORY;
-    }
+    return buffer_range_to_utf8(buffer, line_start, line_len, out_text, out_size, bytes_written);
+}
+
+/**
+ * @brief Segment callback that records RTL/LTR characters in a QalamLineInfo
+ */
+static bool buffer_classify_segment(const wchar_t* text, size_t len, void* context) {
+    QalamLineInfo* info = (QalamLineInfo*)context;
+    unsigned int flags = text_classify_bidi(text, len);
     
-    /* Copy line content */
-    for (size_t i = 0; i < line_len; i++) {
-        temp[i] = buffer_char_at_internal(buffer, line_start + i);
+    if (flags & TEXT_BIDI_RTL) {
+        info->has_rtl_chars = true;
     }
-    temp[line_len] = L'\0';
-    
-    /* Convert to UTF-8 */
-    int utf8_len = utf16_to_utf8(temp, line_len, out_text, out_size - 1);
-    free(temp);
-    
-    if (utf8_len <= 0) {
-        out_text[0] = '\0';
-        if (bytes_written) {
-            *bytes_written = 0;
-        }
-        return QALAM_ERROR_ENCODING;
+    if (flags & TEXT_BIDI_LTR) {
+        info->has_ltr_chars = true;
     }
     
-    out_text[utf8_len] = '\0';
-    if (bytes_written) {
-        *bytes_written = (size_t)utf8_len;
+    return !(info->has_rtl_chars && info->has_ltr_chars);
+}
+
+/**
+ * @brief Get the change generation of a line
+ */
+uint32_t qalam_buffer_get_line_generation(const QalamBuffer* buffer, size_t line_number) {
+    if (!buffer || line_number >= buffer_line_count(buffer)) {
+        return 0;
     }
     
-    return QALAM_OK;
+    /* Like the line metadata, generations are handed out lazily through
+     * a const buffer */
+    return line_index_get_generation(&((QalamBuffer*)buffer)->lines, line_number);
 }
 
 /**
@@ -1125,7 +3538,12 @@ QalamResult qalam_buffer_get_line_info(const QalamBuffer* buffer, size_t line_nu
         return QALAM_ERROR_NULL_POINTER;
     }
     
-    if (line_number >= buffer->line_count) {
+    QalamResult result = buffer_wake(buffer);
+    if (result != QALAM_OK) {
+        return result;
+    }
+    
+    if (line_number >= buffer_line_count(buffer)) {
         return QALAM_ERROR_INVALID_RANGE;
     }
     
@@ -1136,351 +3554,888 @@ QalamResult qalam_buffer_get_line_info(const QalamBuffer* buffer, size_t line_nu
     info->start_offset = line_start;
     info->length_chars = line_len;
     
-    /* Calculate byte length (UTF-8) */
-    if (line_len > 0) {
-        wchar_t* temp = (wchar_t*)malloc((line_len + 1) * sizeof(wchar_t));
-        if (temp) {
-            for (size_t i = 0; i < line_len; i++) {
-                temp[i] = buffer_char_at_internal(buffer, line_start + i);
+    LineMeta meta = line_index_get_meta(&buffer->lines, line_number);
+    if (meta & LINE_META_VALID) {
+        info->length_bytes = meta >> LINE_META_BYTES_SHIFT;
+        info->has_rtl_chars = (meta & LINE_META_RTL) != 0;
+        info->has_ltr_chars = (meta & LINE_META_LTR) != 0;
+    } else {
+        /* Calculate byte length (UTF-8) */
+        info->length_bytes = buffer_utf8_length(buffer, line_start, line_len);
+        
+        /* Check for RTL characters */
+        info->has_rtl_chars = false;
+        info->has_ltr_chars = false;
+        buffer_for_each_segment(buffer, line_start, line_len, buffer_classify_segment, info);
+        
+        /* Cache the result until an edit touches the line. The cache is
+         * not part of the buffer's observable state, so it is updated
+         * through a const buffer. */
+        if (info->length_bytes <= LINE_META_MAX_BYTES) {
+            meta = LINE_META_VALID | ((LineMeta)info->length_bytes << LINE_META_BYTES_SHIFT);
+            if (info->has_rtl_chars) {
+                meta |= LINE_META_RTL;
+            }
+            if (info->has_ltr_chars) {
+                meta |= LINE_META_LTR;
+            }
+            line_index_set_meta(&((QalamBuffer*)buffer)->lines, line_number, meta);
+        }
+    }
+    
+    /* Determine direction */
+    if (info->has_rtl_chars && !info->has_ltr_chars) {
+        info->direction = QALAM_DIR_RTL;
+    } else if (info->has_ltr_chars && !info->has_rtl_chars) {
+        info->direction = QALAM_DIR_LTR;
+    } else {
+        info->direction = QALAM_DIR_AUTO;
+    }
+    
+    return QALAM_OK;
+}
+
+/**
+ * @brief Get a line as a zero-copy view
+ */
+QalamResult qalam_buffer_get_line_view(QalamBuffer* buffer, size_t line_number,
+                                        bool contiguous, QalamTextView* view) {
+    if (!buffer || !view) {
+        return QALAM_ERROR_NULL_POINTER;
+    }
+    
+    QalamResult result = buffer_wake(buffer);
+    if (result != QALAM_OK) {
+        return result;
+    }
+    
+    if (line_number >= buffer_line_count(buffer)) {
+        return QALAM_ERROR_INVALID_RANGE;
+    }
+    
+    size_t line_start = buffer_get_line_start_offset(buffer, line_number);
+    size_t line_len = buffer_get_line_length(buffer, line_number);
+    
+    return buffer_get_view(buffer, line_start, line_len, contiguous, view);
+}
+
+/**
+ * @brief Get a range as a zero-copy view
+ */
+QalamResult qalam_buffer_get_range_view(QalamBuffer* buffer, size_t start_offset,
+                                         size_t end_offset, bool contiguous,
+                                         QalamTextView* view) {
+    if (!buffer || !view) {
+        return QALAM_ERROR_NULL_POINTER;
+    }
+    
+    QalamResult result = buffer_wake(buffer);
+    if (result != QALAM_OK) {
+        return result;
+    }
+    
+    size_t content_len = buffer_content_length(buffer);
+    
+    if (start_offset > content_len || end_offset > content_len) {
+        return QALAM_ERROR_INVALID_RANGE;
+    }
+    
+    if (start_offset > end_offset) {
+        size_t temp = start_offset;
+        start_offset = end_offset;
+        end_offset = temp;
+    }
+    
+    return buffer_get_view(buffer, start_offset, end_offset - start_offset, contiguous, view);
+}
+
+/**
+ * @brief Get entire buffer content
+ */
+QalamResult qalam_buffer_get_content(const QalamBuffer* buffer, char* out_text, 
+                                      size_t out_size, size_t* bytes_written) {
+    if (!buffer || !out_text || out_size == 0) {
+        return QALAM_ERROR_NULL_POINTER;
+    }
+    
+    QalamResult result = buffer_wake(buffer);
+    if (result != QALAM_OK) {
+        return result;
+    }
+    
+    size_t content_len = buffer_content_length(buffer);
+    
+    if (content_len == 0) {
+        out_text[0] = '\0';
+        if (bytes_written) {
+            *bytes_written = 0;
+        }
+        return QALAM_OK;
+    }
+    
+    return buffer_range_to_utf8(buffer, 0, content_len, out_text, out_size, bytes_written);
+}
+
+/**
+ * @brief Get a range of content
+ */
+QalamResult qalam_buffer_get_range(const QalamBuffer* buffer, size_t start_offset,
+                                    size_t end_offset, char* out_text, size_t out_size,
+                                    size_t* bytes_written) {
+    if (!buffer || !out_text || out_size == 0) {
+        return QALAM_ERROR_NULL_POINTER;
+    }
+    
+    QalamResult result = buffer_wake(buffer);
+    if (result != QALAM_OK) {
+        return result;
+    }
+    
+    size_t content_len = buffer_content_length(buffer);
+    
+    if (start_offset > content_len || end_offset > content_len) {
+        return QALAM_ERROR_INVALID_RANGE;
+    }
+    
+    if (start_offset > end_offset) {
+        size_t temp = start_offset;
+        start_offset = end_offset;
+        end_offset = temp;
+    }
+    
+    size_t range_len = end_offset - start_offset;
+    
+    if (range_len == 0) {
+        out_text[0] = '\0';
+        if (bytes_written) {
+            *bytes_written = 0;
+        }
+        return QALAM_OK;
+    }
+    
+    return buffer_range_to_utf8(buffer, start_offset, range_len, out_text, out_size,
+                                bytes_written);
+}
+
+/*=============================================================================
+ * Buffer Statistics and Queries
+ *============================================================================*/
+
+/**
+ * @brief Get buffer statistics
+ */
+QalamResult qalam_buffer_get_stats(const QalamBuffer* buffer, QalamBufferStats* stats) {
+    if (!buffer || !stats) {
+        return QALAM_ERROR_NULL_POINTER;
+    }
+    
+    size_t content_len = buffer_content_length(buffer);
+    
+    stats->total_bytes = qalam_buffer_get_size(buffer);
+    stats->total_chars = content_len;
+    stats->total_lines = buffer_line_count(buffer);
+    
+    if (buffer->hibernated) {
+        /* No storage to have room in */
+        stats->gap_size = 0;
+        stats->capacity = 0;
+    } else if (buffer_is_piece_table(buffer)) {
+        /* Free room in the add buffer plays the role of the gap */
+        stats->gap_size = buffer->pieces.add_capacity - buffer->pieces.add_length;
+        stats->capacity = buffer->pieces.original_length + buffer->pieces.add_capacity;
+    } else if (buffer_is_virtual(buffer)) {
+        /* Only what is committed; the rest of the gap is address space */
+        stats->capacity = virtual_region_committed(&buffer->vm) / sizeof(wchar_t);
+        stats->gap_size = stats->capacity > content_len ? stats->capacity - content_len : 0;
+    } else {
+        stats->gap_size = buffer_gap_size(buffer);
+        stats->capacity = buffer->capacity;
+    }
+    stats->resident_bytes = qalam_buffer_get_resident_size(buffer);
+    stats->is_modified = buffer->modified;
+    stats->is_readonly = buffer->readonly;
+    stats->is_hibernated = buffer->hibernated;
+    qalam_memory_get_stats(&stats->memory);
+    
+    return QALAM_OK;
+}
+
+/**
+ * @brief Get total number of lines
+ */
+size_t qalam_buffer_get_line_count(const QalamBuffer* buffer) {
+    if (!buffer) {
+        return 0;
+    }
+    return buffer_line_count(buffer);
+}
+
+/**
+ * @brief Get total byte size
+ */
+size_t qalam_buffer_get_size(const QalamBuffer* buffer) {
+    if (!buffer) {
+        return 0;
+    }
+    
+    if (buffer->hibernated) {
+        return buffer->hibernated_utf8;
+    }
+    
+    /* Calculate UTF-8 byte size */
+    return buffer_utf8_length(buffer, 0, buffer_content_length(buffer));
+}
+
+/**
+ * @brief Check if buffer has been modified
+ */
+bool qalam_buffer_is_modified(const QalamBuffer* buffer) {
+    if (!buffer) {
+        return false;
+    }
+    return buffer->modified;
+}
+
+/**
+ * @brief Mark buffer as unmodified
+ */
+void qalam_buffer_clear_modified(QalamBuffer* buffer) {
+    if (buffer) {
+        buffer->modified = false;
+    }
+}
+
+/*=============================================================================
+ * Internal Helper Functions - Hibernation
+ *============================================================================*/
+
+/**
+ * @brief Check whether the piece table's original text is its own
+ * 
+ * A mapped or streamed original is read through the file instead.
+ */
+static inline bool buffer_owns_original(const QalamBuffer* buffer) {
+    return buffer->pieces.fetch_original == NULL;
+}
+
+/**
+ * @brief Encode UTF-16 as UTF-8 in bounded chunks
+ * 
+ * A chunk never ends between the halves of a surrogate pair. With
+ * 'utf8' NULL the size is only measured.
+ * 
+ * @return Number of bytes written (or needed)
+ */
+static size_t utf16_encode_chunked(const wchar_t* text, size_t length, char* utf8,
+                                   size_t utf8_size) {
+    size_t written = 0;
+    
+    while (length > 0) {
+        size_t chunk = length > QALAM_BUFFER_READ_CHUNK_SIZE ? QALAM_BUFFER_READ_CHUNK_SIZE : length;
+        if (chunk < length && is_high_surrogate(text[chunk - 1])) {
+            chunk--;
+        }
+        
+        if (utf8) {
+            size_t room = utf8_size - written;
+            if (room > chunk * 3) {
+                room = chunk * 3;
             }
-            info->length_bytes = WideCharToMultiByte(CP_UTF8, 0, temp, (int)line_len, NULL, 0, NULL, NULL);
-            free(temp);
+            written += (size_t)utf16_to_utf8(text, chunk, utf8 + written, room);
         } else {
-            info->length_bytes = line_len; /* Fallback */
+            written += (size_t)utf16_to_utf8(text, chunk, NULL, 0);
         }
-    } else {
-        info->length_bytes = 0;
+        text += chunk;
+        length -= chunk;
     }
     
-    /* Check for RTL characters */
-    info->has_rtl_chars = false;
-    info->has_ltr_chars = false;
-    info->direction = QALAM_DIR_AUTO;
+    return written;
+}
+
+/**
+ * @brief Zero and free the copy kept for split views
+ */
+static void buffer_free_view_copy(QalamBuffer* buffer) {
+    if (buffer->view_copy) {
+        memset(buffer->view_copy, 0, buffer->view_copy_capacity * sizeof(wchar_t));
+        qalam_mem_free(buffer->view_copy);
+    }
+    buffer->view_copy = NULL;
+    buffer->view_copy_capacity = 0;
+}
+
+/**
+ * @brief Zero and free the UTF-8 copy of a hibernated buffer's text
+ */
+static void buffer_free_hibernated(QalamBuffer* buffer) {
+    if (buffer->hibernated_text) {
+        memset(buffer->hibernated_text, 0, buffer->hibernated_size);
+        qalam_mem_free(buffer->hibernated_text);
+    }
+    buffer->hibernated_text = NULL;
+    buffer->hibernated_size = 0;
+    buffer->hibernated_original = 0;
+    buffer->hibernated = false;
+}
+
+/**
+ * @brief Encode a gap buffer's text and release its storage
+ * 
+ * The gap is left empty at the end, so the content length is unchanged.
+ */
+static QalamResult buffer_hibernate_gap(QalamBuffer* buffer, size_t utf8_length) {
+    size_t length = buffer_content_length(buffer);
+    char* text = NULL;
     
-    for (size_t i = 0; i < line_len; i++) {
-        wchar_t ch = buffer_char_at_internal(buffer, line_start + i);
-        
-        /* Check for Arabic range */
-        if ((ch >= 0x0600 && ch <= 0x06FF) ||  /* Arabic */
-            (ch >= 0x0750 && ch <= 0x077F) ||  /* Arabic Supplement */
-            (ch >= 0x08A0 && ch <= 0x08FF) ||  /* Arabic Extended-A */
-            (ch >= 0xFB50 && ch <= 0xFDFF) ||  /* Arabic Presentation Forms-A */
-            (ch >= 0xFE70 && ch <= 0xFEFF) ||  /* Arabic Presentation Forms-B */
-            (ch >= 0x0590 && ch <= 0x05FF)) {  /* Hebrew */
-            info->has_rtl_chars = true;
+    if (length > 0) {
+        text = (char*)qalam_mem_alloc(QALAM_MEMORY_BUFFER, utf8_length + 1);
+        if (!text) {
+            return QALAM_ERROR_OUT_OF_MEMORY;
         }
-        
-        /* Check for Latin range */
-        if ((ch >= 0x0041 && ch <= 0x005A) ||  /* A-Z */
-            (ch >= 0x0061 && ch <= 0x007A)) {  /* a-z */
-            info->has_ltr_chars = true;
+        QalamResult result = buffer_range_to_utf8(buffer, 0, length, text, utf8_length + 1, NULL);
+        if (result != QALAM_OK) {
+            qalam_mem_free(text);
+            return result;
         }
     }
     
-    /* Determine direction */
-    if (info->has_rtl_chars && !info->has_ltr_chars) {
-        info->direction = QALAM_DIR_RTL;
-    } else if (info->has_ltr_chars && !info->has_rtl_chars) {
-        info->direction = QALAM_DIR_LTR;
-    } else {
-        info->direction = QALAM_DIR_AUTO;
-    }
+    buffer->hibernated_virtual = buffer_is_virtual(buffer);
+    buffer_release_gap_storage(buffer);
+    buffer->capacity = length;
+    buffer->gap_start = length;
+    buffer->gap_end = length;
     
+    buffer->hibernated_text = text;
+    buffer->hibernated_size = utf8_length;
     return QALAM_OK;
 }
 
 /**
- * @brief Get entire buffer content
+ * @brief Encode a piece table's own text and release it
+ * 
+ * Pieces and undo spans refer to the original and add buffers by
+ * offset, and both hold whole surrogate pairs, so decoding them again
+ * gives back the same offsets. A mapped original only drops its
+ * decoded chunks.
  */
-QalamResult qalam_buffer_get_content(const QalamBuffer* buffer, char* out_text, 
-                                      size_t out_size, size_t* bytes_written) {
-    if (!buffer || !out_text || out_size == 0) {
-        return QALAM_ERROR_NULL_POINTER;
-    }
-    
-    size_t content_len = buffer_content_length(buffer);
-    
-    if (content_len == 0) {
-        out_text[0] = '\0';
-        if (bytes_written) {
-            *bytes_written = 0;
+static QalamResult buffer_hibernate_pieces(QalamBuffer* buffer) {
+    PieceTable* table = &buffer->pieces;
+    const wchar_t* original = buffer_owns_original(buffer) ? table->original : NULL;
+    size_t original_length = original ? table->original_length : 0;
+    
+    size_t original_bytes = utf16_encode_chunked(original, original_length, NULL, 0);
+    size_t bytes = original_bytes + utf16_encode_chunked(table->add, table->add_length, NULL, 0);
+    char* text = NULL;
+    
+    if (bytes > 0) {
+        text = (char*)qalam_mem_alloc(QALAM_MEMORY_BUFFER, bytes);
+        if (!text) {
+            return QALAM_ERROR_OUT_OF_MEMORY;
         }
-        return QALAM_OK;
+        utf16_encode_chunked(original, original_length, text, original_bytes);
+        utf16_encode_chunked(table->add, table->add_length, text + original_bytes,
+                             bytes - original_bytes);
     }
     
-    /* Allocate temporary buffer for UTF-16 content */
-    wchar_t* temp = (wchar_t*)malloc((content_len + 1) * sizeof(wchar_t));
-    if (!temp) {
-        return QALAM_ERROR_OUT_OF_MEMORY;
+    if (original) {
+        memset(table->original, 0, original_length * sizeof(wchar_t));
+        qalam_mem_free(table->original);
+        table->original = NULL;
     }
-    
-    /* Copy content (handle gap) */
-    size_t pos = 0;
-    for (size_t i = 0; i < content_len; i++) {
-        temp[pos++] = buffer_char_at_internal(buffer, i);
+    if (table->add) {
+        memset(table->add, 0, table->add_capacity * sizeof(wchar_t));
+        qalam_mem_free(table->add);
+        table->add = NULL;
+        table->add_capacity = 0;
     }
-    temp[pos] = L'\0';
-    
-    /* Convert to UTF-8 */
-    int utf8_len = utf16_to_utf8(temp, content_len, out_text, out_size - 1);
-    free(temp);
+    mapped_file_trim(buffer->mapped);
     
-    if (utf8_len <= 0 && content_len > 0) {
-        out_text[0] = '\0';
-        if (bytes_written) {
-            *bytes_written = 0;
-        }
-        return QALAM_ERROR_ENCODING;
+    buffer->hibernated_text = text;
+    buffer->hibernated_size = bytes;
+    buffer->hibernated_original = original_bytes;
+    return QALAM_OK;
+}
+
+/**
+ * @brief Decode a hibernated gap buffer into new storage
+ * 
+ * The gap starts at the end of the text, with room to type.
+ */
+static QalamResult buffer_rehydrate_gap(QalamBuffer* buffer) {
+    size_t length = buffer->capacity;
+    QalamResult result = buffer_alloc_gap_storage(buffer, length + QALAM_BUFFER_INITIAL_GAP_SIZE,
+                                                  buffer->hibernated_virtual);
+    if (result != QALAM_OK) {
+        return result;
     }
     
-    out_text[utf8_len] = '\0';
-    if (bytes_written) {
-        *bytes_written = (size_t)utf8_len;
+    if (utf8_decode_chunked(buffer->hibernated_text, buffer->hibernated_size,
+                            buffer->data) != length) {
+        buffer_release_gap_storage(buffer);
+        buffer->capacity = length;
+        buffer->gap_end = length;
+        return QALAM_ERROR_ENCODING;
     }
     
+    buffer->gap_start = length;
     return QALAM_OK;
 }
 
 /**
- * @brief Get a range of content
+ * @brief Decode a hibernated piece table's original and add buffers
  */
-QalamResult qalam_buffer_get_range(const QalamBuffer* buffer, size_t start_offset,
-                                    size_t end_offset, char* out_text, size_t out_size,
-                                    size_t* bytes_written) {
-    if (!buffer || !out_text || out_size == 0) {
-        return QALAM_ERROR_NULL_POINTER;
+static QalamResult buffer_rehydrate_pieces(QalamBuffer* buffer) {
+    PieceTable* table = &buffer->pieces;
+    size_t original_length = buffer_owns_original(buffer) ? table->original_length : 0;
+    wchar_t* original = NULL;
+    wchar_t* add = NULL;
+    
+    if (original_length > 0) {
+        original = (wchar_t*)qalam_mem_alloc(QALAM_MEMORY_BUFFER,
+                                             original_length * sizeof(wchar_t));
     }
-    
-    size_t content_len = buffer_content_length(buffer);
-    
-    if (start_offset > content_len || end_offset > content_len) {
-        return QALAM_ERROR_INVALID_RANGE;
+    if (table->add_length > 0) {
+        add = (wchar_t*)qalam_mem_alloc(QALAM_MEMORY_BUFFER, table->add_length * sizeof(wchar_t));
     }
     
-    if (start_offset > end_offset) {
-        size_t temp = start_offset;
-        start_offset = end_offset;
-        end_offset = temp;
+    QalamResult result = QALAM_OK;
+    if ((original_length > 0 && !original) || (table->add_length > 0 && !add)) {
+        result = QALAM_ERROR_OUT_OF_MEMORY;
+    } else if ((original_length > 0 &&
+                utf8_decode_chunked(buffer->hibernated_text, buffer->hibernated_original,
+                                    original) != original_length) ||
+               (table->add_length > 0 &&
+                utf8_decode_chunked(buffer->hibernated_text + buffer->hibernated_original,
+                                    buffer->hibernated_size - buffer->hibernated_original,
+                                    add) != table->add_length)) {
+        result = QALAM_ERROR_ENCODING;
     }
     
-    size_t range_len = end_offset - start_offset;
+    if (result != QALAM_OK) {
+        qalam_mem_free(original);
+        qalam_mem_free(add);
+        return result;
+    }
     
-    if (range_len == 0) {
-        out_text[0] = '\0';
-        if (bytes_written) {
-            *bytes_written = 0;
-        }
+    if (original_length > 0) {
+        table->original = original;
+    }
+    table->add = add;
+    table->add_capacity = table->add_length;
+    return QALAM_OK;
+}
+
+/**
+ * @brief Bring a hibernated buffer's text back before it is read or edited
+ * 
+ * Hibernation changes where the text is kept, not what it is, so the
+ * readers that take a const buffer wake it as well.
+ */
+static QalamResult buffer_wake(const QalamBuffer* buffer) {
+    if (!buffer->hibernated) {
         return QALAM_OK;
     }
     
-    /* Allocate temporary buffer */
-    wchar_t* temp = (wchar_t*)malloc((range_len + 1) * sizeof(wchar_t));
-    if (!temp) {
-        return QALAM_ERROR_OUT_OF_MEMORY;
+    QalamBuffer* buf = (QalamBuffer*)buffer;
+    QALAM_TRACE_BEGIN(span, QALAM_TRACE_BUFFER, "rehydrate");
+    QalamResult result = buffer_is_piece_table(buf) ? buffer_rehydrate_pieces(buf)
+                                                    : buffer_rehydrate_gap(buf);
+    if (result == QALAM_OK) {
+        buffer_free_hibernated(buf);
     }
-    
-    /* Copy range */
-    for (size_t i = 0; i < range_len; i++) {
-        temp[i] = buffer_char_at_internal(buffer, start_offset + i);
+    QALAM_TRACE_END(span);
+    return result;
+}
+
+/*=============================================================================
+ * Memory Footprint
+ *============================================================================*/
+
+/**
+ * @brief Give back storage the buffer is not using
+ */
+QalamResult qalam_buffer_shrink_to_fit(QalamBuffer* buffer) {
+    if (!buffer) {
+        return QALAM_ERROR_NULL_POINTER;
+    }
+    if (buffer->hibernated) {
+        return QALAM_OK; /* Nothing is resident */
     }
-    temp[range_len] = L'\0';
     
-    /* Convert to UTF-8 */
-    int utf8_len = utf16_to_utf8(temp, range_len, out_text, out_size - 1);
-    free(temp);
+    buffer_free_view_copy(buffer);
     
-    if (utf8_len <= 0 && range_len > 0) {
-        out_text[0] = '\0';
-        if (bytes_written) {
-            *bytes_written = 0;
-        }
-        return QALAM_ERROR_ENCODING;
+    if (buffer_is_piece_table(buffer)) {
+        piece_table_shrink_add(&buffer->pieces);
+        mapped_file_trim(buffer->mapped);
+        return QALAM_OK;
     }
     
-    out_text[utf8_len] = '\0';
-    if (bytes_written) {
-        *bytes_written = (size_t)utf8_len;
+    if (buffer_is_virtual(buffer)) {
+        buffer_trim_gap(buffer);
+        return QALAM_OK;
     }
     
-    return QALAM_OK;
+    size_t capacity = buffer_content_length(buffer) + QALAM_BUFFER_GAP_GROW_SIZE;
+    if (capacity < QALAM_BUFFER_INITIAL_CAPACITY) {
+        capacity = QALAM_BUFFER_INITIAL_CAPACITY;
+    }
+    if (capacity >= buffer->capacity) {
+        return QALAM_OK;
+    }
+    return buffer_resize_gap(buffer, capacity);
 }
 
-/*=============================================================================
- * Buffer Statistics and Queries
- *============================================================================*/
-
 /**
- * @brief Get buffer statistics
+ * @brief Keep the buffer's text as compact UTF-8 until it is used again
  */
-QalamResult qalam_buffer_get_stats(const QalamBuffer* buffer, QalamBufferStats* stats) {
-    if (!buffer || !stats) {
+QalamResult qalam_buffer_hibernate(QalamBuffer* buffer) {
+    if (!buffer) {
         return QALAM_ERROR_NULL_POINTER;
     }
+    if (buffer->hibernated) {
+        return QALAM_OK;
+    }
     
-    size_t content_len = buffer_content_length(buffer);
-    
-    /* Calculate byte size (UTF-8) */
-    size_t byte_size = 0;
-    if (content_len > 0) {
-        wchar_t* temp = (wchar_t*)malloc((content_len + 1) * sizeof(wchar_t));
-        if (temp) {
-            for (size_t i = 0; i < content_len; i++) {
-                temp[i] = buffer_char_at_internal(buffer, i);
-            }
-            byte_size = WideCharToMultiByte(CP_UTF8, 0, temp, (int)content_len, NULL, 0, NULL, NULL);
-            free(temp);
-        }
+    /* The document still grows while a file loads */
+    if ((buffer->mapped && !mapped_file_is_complete(buffer->mapped)) ||
+        (buffer->loader && !file_loader_is_complete(buffer->loader))) {
+        return QALAM_ERROR_BUFFER_READONLY;
     }
     
-    stats->total_bytes = byte_size;
-    stats->total_chars = content_len;
-    stats->total_lines = buffer->line_count;
-    stats->gap_size = buffer_gap_size(buffer);
-    stats->capacity = buffer->capacity;
-    stats->is_modified = buffer->modified;
-    stats->is_readonly = buffer->readonly;
+    QALAM_TRACE_BEGIN(span, QALAM_TRACE_BUFFER, "hibernate");
+    size_t utf8_length = buffer_utf8_length(buffer, 0, buffer_content_length(buffer));
+    buffer_free_view_copy(buffer);
     
-    return QALAM_OK;
+    QalamResult result = buffer_is_piece_table(buffer) ? buffer_hibernate_pieces(buffer)
+                                                       : buffer_hibernate_gap(buffer, utf8_length);
+    if (result == QALAM_OK) {
+        buffer->hibernated = true;
+        buffer->hibernated_utf8 = utf8_length;
+    }
+    QALAM_TRACE_END(span);
+    return result;
 }
 
 /**
- * @brief Get total number of lines
+ * @brief Decode a hibernated buffer's text back into its storage
  */
-size_t qalam_buffer_get_line_count(const QalamBuffer* buffer) {
+QalamResult qalam_buffer_rehydrate(QalamBuffer* buffer) {
     if (!buffer) {
-        return 0;
+        return QALAM_ERROR_NULL_POINTER;
     }
-    return buffer->line_count;
+    return buffer_wake(buffer);
 }
 
 /**
- * @brief Get total byte size
+ * @brief Check whether a buffer is hibernated
  */
-size_t qalam_buffer_get_size(const QalamBuffer* buffer) {
+bool qalam_buffer_is_hibernated(const QalamBuffer* buffer) {
+    return buffer && buffer->hibernated;
+}
+
+/**
+ * @brief Get the bytes of text the buffer holds in memory
+ */
+size_t qalam_buffer_get_resident_size(const QalamBuffer* buffer) {
     if (!buffer) {
         return 0;
     }
     
-    size_t content_len = buffer_content_length(buffer);
-    if (content_len == 0) {
-        return 0;
+    size_t bytes = buffer->hibernated_size;
+    if (buffer_is_piece_table(buffer)) {
+        const PieceTable* table = &buffer->pieces;
+        if (table->original && buffer_owns_original(buffer)) {
+            bytes += table->original_length * sizeof(wchar_t);
+        }
+        bytes += table->add_capacity * sizeof(wchar_t);
+        bytes += mapped_file_cached_bytes(buffer->mapped);
+    } else if (buffer_is_virtual(buffer)) {
+        bytes += virtual_region_committed(&buffer->vm);
+    } else if (buffer->data) {
+        bytes += buffer->capacity * sizeof(wchar_t);
     }
     
-    /* Calculate UTF-8 byte size */
-    wchar_t* temp = (wchar_t*)malloc((content_len + 1) * sizeof(wchar_t));
-    if (!temp) {
-        return content_len; /* Fallback to character count */
+    bytes += buffer->view_copy_capacity * sizeof(wchar_t);
+    bytes += buffer->undo.text_capacity * sizeof(wchar_t);
+    return bytes;
+}
+
+/*=============================================================================
+ * File Operations
+ *============================================================================*/
+
+/**
+ * @brief State of a streaming save
+ * 
+ * Text is converted into one staging buffer while the other is being
+ * written, so memory use is two chunks regardless of file size.
+ */
+typedef struct SaveStream {
+    const QalamBuffer* buffer;  /**< Buffer being saved */
+    HANDLE file;                /**< Temporary file, opened for overlapped I/O */
+    char* staging[2];           /**< Staging buffers */
+    OVERLAPPED overlapped[2];   /**< Write state of each staging buffer */
+    DWORD in_flight[2];         /**< Bytes being written from each, or 0 */
+    int current;                /**< Staging buffer being converted into */
+    Utf8Writer writer;          /**< Converter targeting staging[current] */
+    ULONGLONG offset;           /**< File offset of the next write */
+    size_t bytes_written;       /**< Bytes known to be on disk */
+    size_t bytes_total;         /**< Total bytes to write */
+    QalamSaveProgressCallback callback; /**< Progress callback, or NULL */
+    void* user_data;            /**< Callback context */
+    QalamResult result;         /**< First error, or QALAM_OK */
+} SaveStream;
+
+/**
+ * @brief Wait for the write from a staging buffer to finish
+ */
+static bool save_stream_complete(SaveStream* stream, int slot) {
+    DWORD expected = stream->in_flight[slot];
+    if (expected == 0) {
+        return true;
     }
     
-    for (size_t i = 0; i < content_len; i++) {
-        temp[i] = buffer_char_at_internal(buffer, i);
+    DWORD done = 0;
+    stream->in_flight[slot] = 0;
+    if (!GetOverlappedResult(stream->file, &stream->overlapped[slot], &done, TRUE) ||
+        done != expected) {
+        stream->result = QALAM_ERROR_FILE_WRITE;
+        return false;
     }
     
-    int byte_size = WideCharToMultiByte(CP_UTF8, 0, temp, (int)content_len, NULL, 0, NULL, NULL);
-    free(temp);
-    
-    return byte_size > 0 ? (size_t)byte_size : content_len;
+    stream->bytes_written += done;
+    if (stream->callback) {
+        stream->callback(stream->buffer, stream->bytes_written, stream->bytes_total,
+                         stream->user_data);
+    }
+    return true;
 }
 
 /**
- * @brief Check if buffer has been modified
+ * @brief Start writing the current staging buffer and switch to the other
+ * 
+ * The other buffer's write, if still running, is waited for first.
  */
-bool qalam_buffer_is_modified(const QalamBuffer* buffer) {
-    if (!buffer) {
+static bool save_stream_submit(SaveStream* stream) {
+    int slot = stream->current;
+    DWORD length = (DWORD)stream->writer.written;
+    if (length == 0) {
+        return true;
+    }
+    
+    OVERLAPPED* overlapped = &stream->overlapped[slot];
+    HANDLE event = overlapped->hEvent;
+    memset(overlapped, 0, sizeof(*overlapped));
+    overlapped->hEvent = event;
+    overlapped->Offset = (DWORD)stream->offset;
+    overlapped->OffsetHigh = (DWORD)(stream->offset >> 32);
+    
+    if (!WriteFile(stream->file, stream->staging[slot], length, NULL, overlapped) &&
+        GetLastError() != ERROR_IO_PENDING) {
+        stream->result = QALAM_ERROR_FILE_WRITE;
         return false;
     }
-    return buffer->modified;
+    stream->in_flight[slot] = length;
+    stream->offset += length;
+    
+    stream->current = 1 - slot;
+    if (!save_stream_complete(stream, stream->current)) {
+        return false;
+    }
+    stream->writer.out = stream->staging[stream->current];
+    stream->writer.written = 0;
+    return true;
 }
 
 /**
- * @brief Mark buffer as unmodified
+ * @brief Segment callback that converts text into the staging buffers
+ * 
+ * Each step converts as much as is sure to fit: 3 bytes per wchar_t,
+ * plus room for a surrogate held back from the previous step.
  */
-void qalam_buffer_clear_modified(QalamBuffer* buffer) {
-    if (buffer) {
-        buffer->modified = false;
+static bool save_stream_segment(const wchar_t* text, size_t len, void* context) {
+    SaveStream* stream = (SaveStream*)context;
+    
+    while (len > 0) {
+        size_t space = stream->writer.size - stream->writer.written;
+        if (space < QALAM_BUFFER_SAVE_MIN_STEP * 3 + 4) {
+            if (!save_stream_submit(stream)) {
+                return false;
+            }
+            continue;
+        }
+        
+        size_t step = (space - 4) / 3;
+        if (step > len) {
+            step = len;
+        }
+        if (!buffer_write_utf8_segment(text, step, &stream->writer)) {
+            stream->result = QALAM_ERROR_ENCODING;
+            return false;
+        }
+        text += step;
+        len -= step;
     }
+    
+    return true;
 }
 
-/*=============================================================================
- * File Operations
- *============================================================================*/
+/**
+ * @brief Stream the whole buffer into an open file
+ */
+static QalamResult save_stream_run(SaveStream* stream) {
+    const QalamBuffer* buffer = stream->buffer;
+    
+    /* Reserve the space up front so a full disk fails before any writing */
+    FILE_END_OF_FILE_INFO end_of_file;
+    end_of_file.EndOfFile.QuadPart = (LONGLONG)stream->bytes_total;
+    if (!SetFileInformationByHandle(stream->file, FileEndOfFileInfo, &end_of_file,
+                                    sizeof(end_of_file))) {
+        stream->result = QALAM_ERROR_FILE_WRITE;
+        return stream->result;
+    }
+    
+    if (buffer_for_each_segment(buffer, 0, buffer_content_length(buffer),
+                                save_stream_segment, stream) &&
+        stream->writer.pending_high) {
+        /* An unpaired high surrogate at the very end */
+        if (stream->writer.size - stream->writer.written >= 3 || save_stream_submit(stream)) {
+            buffer_write_utf8(&stream->writer, &stream->writer.pending_high, 1);
+            if (stream->writer.failed) {
+                stream->result = QALAM_ERROR_ENCODING;
+            }
+        }
+    }
+    
+    if (stream->result == QALAM_OK) {
+        save_stream_submit(stream);
+    }
+    /* Never leave a write running against memory about to be freed */
+    save_stream_complete(stream, 0);
+    save_stream_complete(stream, 1);
+    
+    if (stream->result == QALAM_OK) {
+        if (stream->bytes_written != stream->bytes_total ||
+            !FlushFileBuffers(stream->file)) {
+            stream->result = QALAM_ERROR_FILE_WRITE;
+        } else if (stream->bytes_total == 0 && stream->callback) {
+            stream->callback(buffer, 0, 0, stream->user_data);
+        }
+    }
+    
+    return stream->result;
+}
 
 /**
  * @brief Save buffer to file
  */
 QalamResult qalam_buffer_save(QalamBuffer* buffer, const wchar_t* filepath) {
+    return qalam_buffer_save_with_progress(buffer, filepath, NULL, NULL);
+}
+
+/**
+ * @brief Save buffer to file, reporting progress
+ */
+QalamResult qalam_buffer_save_with_progress(QalamBuffer* buffer, const wchar_t* filepath,
+                                            QalamSaveProgressCallback callback,
+                                            void* user_data) {
     if (!buffer || !filepath) {
         return QALAM_ERROR_NULL_POINTER;
     }
     
-    size_t content_len = buffer_content_length(buffer);
-    
-    /* Calculate UTF-8 size */
-    size_t utf8_size = 0;
-    wchar_t* content = NULL;
-    char* utf8_content = NULL;
+    QalamResult result = buffer_wake(buffer);
+    if (result != QALAM_OK) {
+        return result;
+    }
     
-    if (content_len > 0) {
-        content = (wchar_t*)malloc((content_len + 1) * sizeof(wchar_t));
-        if (!content) {
-            return QALAM_ERROR_OUT_OF_MEMORY;
-        }
-        
-        for (size_t i = 0; i < content_len; i++) {
-            content[i] = buffer_char_at_internal(buffer, i);
+    /* The temporary file sits next to the target so it can replace it */
+    static const wchar_t suffix[] = QALAM_BUFFER_SAVE_SUFFIX;
+    size_t suffix_len = sizeof(suffix) / sizeof(suffix[0]) - 1;
+    size_t path_len = wcslen(filepath);
+    if (path_len == 0 || path_len + suffix_len >= MAX_PATH) {
+        return QALAM_ERROR_INVALID_ARGUMENT;
+    }
+    wchar_t temp_path[MAX_PATH];
+    memcpy(temp_path, filepath, path_len * sizeof(wchar_t));
+    memcpy(temp_path + path_len, suffix, (suffix_len + 1) * sizeof(wchar_t));
+    
+    /* Saving needs the whole file; overwriting it also needs it unmapped */
+    if (buffer->mapped) {
+        QalamResult load_result = _wcsicmp(mapped_file_path(buffer->mapped), filepath) == 0
+                                      ? buffer_detach_mapped(buffer)
+                                      : qalam_buffer_wait_load(buffer);
+        if (load_result != QALAM_OK) {
+            return load_result;
         }
-        content[content_len] = L'\0';
-        
-        utf8_size = WideCharToMultiByte(CP_UTF8, 0, content, (int)content_len, NULL, 0, NULL, NULL);
-        if (utf8_size > 0) {
-            utf8_content = (char*)malloc(utf8_size + 1);
-            if (!utf8_content) {
-                free(content);
-                return QALAM_ERROR_OUT_OF_MEMORY;
-            }
-            
-            WideCharToMultiByte(CP_UTF8, 0, content, (int)content_len, utf8_content, (int)utf8_size, NULL, NULL);
-            utf8_content[utf8_size] = '\0';
+    } else if (buffer->loader) {
+        QalamResult load_result = qalam_buffer_wait_load(buffer);
+        if (load_result != QALAM_OK) {
+            return load_result;
         }
-        
-        free(content);
-    }
-    
-    /* Open file for writing */
-    HANDLE hFile = CreateFileW(
-        filepath,
-        GENERIC_WRITE,
-        0,
-        NULL,
-        CREATE_ALWAYS,
-        FILE_ATTRIBUTE_NORMAL,
-        NULL
-    );
-    
-    if (hFile == INVALID_HANDLE_VALUE) {
-        if (utf8_content) free(utf8_content);
-        return QALAM_ERROR_FILE_ACCESS;
     }
     
-    /* Write content */
-    QalamResult result = QALAM_OK;
-    if (utf8_content && utf8_size > 0) {
-        DWORD written;
-        if (!WriteFile(hFile, utf8_content, (DWORD)utf8_size, &written, NULL)) {
-            result = QALAM_ERROR_FILE_WRITE;
+    SaveStream stream;
+    memset(&stream, 0, sizeof(stream));
+    stream.buffer = buffer;
+    stream.bytes_total = buffer_utf8_length(buffer, 0, buffer_content_length(buffer));
+    stream.callback = callback;
+    stream.user_data = user_data;
+    stream.result = QALAM_OK;
+    
+    stream.staging[0] = (char*)qalam_mem_alloc(QALAM_MEMORY_BUFFER,
+                                               2 * QALAM_BUFFER_SAVE_CHUNK_SIZE);
+    stream.overlapped[0].hEvent = CreateEventW(NULL, TRUE, FALSE, NULL);
+    stream.overlapped[1].hEvent = CreateEventW(NULL, TRUE, FALSE, NULL);
+    
+    if (!stream.staging[0] || !stream.overlapped[0].hEvent || !stream.overlapped[1].hEvent) {
+        stream.result = QALAM_ERROR_OUT_OF_MEMORY;
+    } else {
+        stream.staging[1] = stream.staging[0] + QALAM_BUFFER_SAVE_CHUNK_SIZE;
+        stream.writer.out = stream.staging[0];
+        stream.writer.size = QALAM_BUFFER_SAVE_CHUNK_SIZE;
+        
+        stream.file = CreateFileW(
+            temp_path,
+            GENERIC_WRITE,
+            0,
+            NULL,
+            CREATE_ALWAYS,
+            FILE_ATTRIBUTE_NORMAL | FILE_FLAG_OVERLAPPED,
+            NULL
+        );
+        
+        if (stream.file == INVALID_HANDLE_VALUE) {
+            stream.result = QALAM_ERROR_FILE_ACCESS;
+        } else {
+            save_stream_run(&stream);
+            CloseHandle(stream.file);
+            
+            if (stream.result == QALAM_OK &&
+                !ReplaceFileW(filepath, temp_path, NULL, REPLACEFILE_IGNORE_MERGE_ERRORS,
+                              NULL, NULL)) {
+                /* ReplaceFileW needs an existing target; a new file is just renamed */
+                if (GetLastError() != ERROR_FILE_NOT_FOUND ||
+                    !MoveFileExW(temp_path, filepath, MOVEFILE_WRITE_THROUGH)) {
+                    stream.result = QALAM_ERROR_FILE_ACCESS;
+                }
+            }
+            if (stream.result != QALAM_OK) {
+                DeleteFileW(temp_path);
+            }
         }
     }
     
-    CloseHandle(hFile);
-    if (utf8_content) free(utf8_content);
+    if (stream.overlapped[0].hEvent) CloseHandle(stream.overlapped[0].hEvent);
+    if (stream.overlapped[1].hEvent) CloseHandle(stream.overlapped[1].hEvent);
+    qalam_mem_free(stream.staging[0]);
     
-    if (result == QALAM_OK) {
+    if (stream.result == QALAM_OK) {
         wcsncpy(buffer->filepath, filepath, MAX_PATH - 1);
         buffer->filepath[MAX_PATH - 1] = L'\0';
         buffer->modified = false;
     }
     
-    return result;
+    return stream.result;
 }
 
 /**
@@ -1491,33 +4446,63 @@ QalamResult qalam_buffer_load(QalamBuffer* buffer, const wchar_t* filepath) {
         return QALAM_ERROR_NULL_POINTER;
     }
     
-    /* Create temporary buffer from file */
+    /* Create temporary buffer from file, in the same kind of storage */
+    QalamBufferOptions options;
+    qalam_buffer_get_default_options(&options);
+    options.virtual_memory = buffer_is_virtual(buffer) ||
+                             (buffer->hibernated && buffer->hibernated_virtual);
+    
     QalamBuffer* temp_buf = NULL;
-    QalamResult result = qalam_buffer_create_from_file(&temp_buf, filepath);
+    QalamResult result = qalam_buffer_create_from_file_with_options(&temp_buf, filepath, &options);
     
     if (result != QALAM_OK) {
         return result;
     }
     
-    /* Swap contents */
-    wchar_t* old_data = buffer->data;
+    /* Swap storage; the temporary buffer takes the old contents with it */
+    QalamBuffer old = *buffer;
     
+    buffer->backend = temp_buf->backend;
     buffer->data = temp_buf->data;
     buffer->capacity = temp_buf->capacity;
     buffer->gap_start = temp_buf->gap_start;
     buffer->gap_end = temp_buf->gap_end;
-    buffer->cursor_line = 0;
-    buffer->cursor_column = 0;
-    buffer->line_count = temp_buf->line_count;
+    buffer->vm = temp_buf->vm;
+    buffer->pieces = temp_buf->pieces;
+    buffer->cursor_offset = temp_buf->cursor_offset;
+    buffer->mapped = temp_buf->mapped;
+    buffer->loader = temp_buf->loader;
+    buffer->lines = temp_buf->lines;
+    buffer->undo = temp_buf->undo;
+    buffer->cursor_line = temp_buf->cursor_line;
+    buffer->cursor_column = temp_buf->cursor_column;
     buffer->modified = false;
+    buffer->readonly = temp_buf->readonly;
     wcsncpy(buffer->filepath, filepath, MAX_PATH - 1);
     buffer->filepath[MAX_PATH - 1] = L'\0';
     
-    /* Free old data and temp structure */
-    free(old_data);
-    temp_buf->data = NULL;
+    temp_buf->backend = old.backend;
+    temp_buf->data = old.data;
+    temp_buf->capacity = old.capacity;
+    temp_buf->vm = old.vm;
+    temp_buf->pieces = old.pieces;
+    temp_buf->mapped = old.mapped;
+    temp_buf->loader = old.loader;
+    temp_buf->lines = old.lines;
+    temp_buf->undo = old.undo;
+    temp_buf->hibernated_text = old.hibernated_text;
+    temp_buf->hibernated_size = old.hibernated_size;
+    buffer->hibernated_text = NULL;
+    buffer->hibernated_size = 0;
+    buffer->hibernated = false;
+    buffer->hibernated_virtual = false;
+    size_t old_line_count = line_index_line_count(&old.lines);
     qalam_buffer_destroy(temp_buf);
     
+    /* Every line is new */
+    buffer_note_lines(buffer, 0, old_line_count, buffer_line_count(buffer));
+    buffer_flush_change(buffer);
+    
     return QALAM_OK;
 }
 
@@ -1548,11 +4533,11 @@ QalamResult qalam_buffer_set_selection(QalamBuffer* buffer,
     }
     
     /* Validate and clamp positions */
-    if (start_line >= buffer->line_count) {
-        start_line = buffer->line_count - 1;
+    if (start_line >= buffer_line_count(buffer)) {
+        start_line = buffer_line_count(buffer) - 1;
     }
-    if (end_line >= buffer->line_count) {
-        end_line = buffer->line_count - 1;
+    if (end_line >= buffer_line_count(buffer)) {
+        end_line = buffer_line_count(buffer) - 1;
     }
     
     size_t start_line_len = buffer_get_line_length(buffer, start_line);
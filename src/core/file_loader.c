@@ -0,0 +1,459 @@
+/**
+ * @file file_loader.c
+ * @brief Qalam IDE - Background File Loader Implementation
+ *
+ * Chunk i nominally covers bytes [bound(i), bound(i + 1)). Its real
+ * start skips up to three continuation bytes, which belong to the
+ * sequence the previous chunk ends with; its real end takes up the same
+ * bytes after bound(i + 1). Both sides look at the same file bytes, so
+ * every byte lands in exactly one chunk without the chunks having to
+ * talk to each other.
+ *
+ * Workers claim chunk numbers from an interlocked counter and mark each
+ * slot ready once it is complete; the owner absorbs ready slots from the
+ * front, which keeps the document in file order however the workers
+ * interleave.
+ *
+ * @version 0.0.2
+ * @copyright (c) 2026 Qalam Project
+ *
+ * @note Thread Safety: See file_loader.h.
+ */
+
+#include "file_loader.h"
+#include "line_index.h"
+#include <stdlib.h>
+#include <string.h>
+
+/** Longest run of UTF-8 continuation bytes a chunk boundary is moved over */
+#define FILE_LOADER_MAX_CONTINUATION 3
+
+/*=============================================================================
+ * Internal Structures
+ *============================================================================*/
+
+/**
+ * @brief One chunk of the file
+ *
+ * Workers fill every field but text_start, then set 'ready'.
+ */
+typedef struct LoaderSlot {
+    volatile LONG ready;            /**< Set once the worker has filled the slot */
+    size_t byte_length;             /**< Chunk size in bytes */
+    wchar_t* text;                  /**< Decoded text (NULL if empty) */
+    size_t text_length;             /**< Decoded length in wchar_t units */
+    size_t* line_lengths;           /**< Run lengths, freed once absorbed */
+    size_t line_count;              /**< Entries in line_lengths */
+    size_t tail_length;             /**< Characters after the last newline */
+    size_t text_start;              /**< Offset of the text once absorbed */
+} LoaderSlot;
+
+/**
+ * @brief Background file loader state
+ */
+struct FileLoader {
+    HANDLE file;                    /**< File handle, closed once the workers stop */
+    size_t size;                    /**< File size in bytes */
+    LoaderSlot* slots;              /**< One slot per chunk */
+    size_t slot_count;              /**< Number of chunks */
+
+    /* Worker state */
+    volatile LONG next_slot;        /**< Next chunk to be claimed */
+    volatile LONG running;          /**< Workers still running */
+    volatile LONG cancel;           /**< Set to ask the workers to stop */
+    volatile LONG error;            /**< First error a worker ran into */
+    HANDLE threads[FILE_LOADER_MAX_WORKERS]; /**< Worker threads */
+    size_t thread_count;            /**< Workers started and not yet joined */
+    QalamLoadReadyCallback ready;   /**< Ready callback, or NULL */
+    void* user_data;                /**< Context for 'ready' */
+
+    /* Owner state */
+    FileLoaderChunk peeked;         /**< Chunk returned by file_loader_peek() */
+    size_t absorbed;                /**< Chunks absorbed */
+    size_t text_length;             /**< Total absorbed text in wchar_t units */
+    size_t bytes_absorbed;          /**< Total absorbed bytes */
+    size_t last_slot;               /**< Slot of the most recent lookup */
+};
+
+/*=============================================================================
+ * Internal Helper Functions - Loading
+ *============================================================================*/
+
+static inline bool loader_is_continuation(char byte) {
+    return ((unsigned char)byte & 0xC0) == 0x80;
+}
+
+/**
+ * @brief Nominal byte offset where a chunk starts
+ */
+static size_t loader_bound(const FileLoader* loader, size_t index) {
+    if (index == 0) {
+        return 0;
+    }
+
+    /* Checked before multiplying so the offset cannot overflow */
+    size_t chunks = index - 1;
+    if (loader->size <= FILE_LOADER_FIRST_CHUNK ||
+        chunks > (loader->size - FILE_LOADER_FIRST_CHUNK) / FILE_LOADER_CHUNK_SIZE) {
+        return loader->size;
+    }
+    return FILE_LOADER_FIRST_CHUNK + chunks * FILE_LOADER_CHUNK_SIZE;
+}
+
+/**
+ * @brief Read 'length' bytes at a file offset
+ *
+ * Explicit offsets let the workers share one handle.
+ */
+static bool loader_read_at(HANDLE file, size_t offset, char* out, size_t length) {
+    while (length > 0) {
+        OVERLAPPED overlapped;
+        memset(&overlapped, 0, sizeof(overlapped));
+        overlapped.Offset = (DWORD)offset;
+        overlapped.OffsetHigh = (DWORD)((unsigned long long)offset >> 32);
+
+        DWORD bytesRead = 0;
+        if (!ReadFile(file, out, (DWORD)length, &bytesRead, &overlapped) || bytesRead == 0) {
+            return false;   /* Read error, or the file shrank */
+        }
+        out += bytesRead;
+        offset += bytesRead;
+        length -= bytesRead;
+    }
+    return true;
+}
+
+/**
+ * @brief Read, decode and measure one chunk into its slot
+ *
+ * @param bytes Read buffer with room for FILE_LOADER_CHUNK_SIZE + 3 bytes
+ */
+static QalamResult loader_load_slot(FileLoader* loader, size_t index, char* bytes) {
+    size_t lo = loader_bound(loader, index);
+    size_t hi = loader_bound(loader, index + 1);
+    size_t read_end = loader->size - hi > FILE_LOADER_MAX_CONTINUATION
+                          ? hi + FILE_LOADER_MAX_CONTINUATION
+                          : loader->size;
+
+    if (!loader_read_at(loader->file, lo, bytes, read_end - lo)) {
+        return QALAM_ERROR_FILE_READ;
+    }
+
+    /* Leading continuation bytes finish the previous chunk's last character */
+    size_t start = 0;
+    if (index > 0) {
+        while (start < FILE_LOADER_MAX_CONTINUATION && start < hi - lo &&
+               loader_is_continuation(bytes[start])) {
+            start++;
+        }
+    }
+    size_t end = hi - lo;
+    while (end < read_end - lo && loader_is_continuation(bytes[end])) {
+        end++;
+    }
+
+    LoaderSlot* slot = &loader->slots[index];
+    size_t length = end - start;
+    wchar_t* text = NULL;
+    int decoded = 0;
+
+    if (length > 0) {
+        text = (wchar_t*)qalam_mem_alloc(QALAM_MEMORY_BUFFER, length * sizeof(wchar_t));
+        if (!text) {
+            return QALAM_ERROR_OUT_OF_MEMORY;
+        }
+        decoded = MultiByteToWideChar(CP_UTF8, 0, bytes + start, (int)length, text, (int)length);
+        if (decoded <= 0) {
+            qalam_mem_free(text);
+            return QALAM_ERROR_ENCODING;
+        }
+
+        wchar_t* trimmed = (wchar_t*)qalam_mem_realloc(QALAM_MEMORY_BUFFER,
+                                                       text, (size_t)decoded * sizeof(wchar_t));
+        if (trimmed) {
+            text = trimmed;
+        }
+    }
+
+    QalamResult result = line_index_measure(text, (size_t)decoded, &slot->line_lengths,
+                                            &slot->line_count, &slot->tail_length);
+    if (result != QALAM_OK) {
+        qalam_mem_free(text);
+        return result;
+    }
+
+    slot->byte_length = length;
+    slot->text = text;
+    slot->text_length = (size_t)decoded;
+    return QALAM_OK;
+}
+
+/**
+ * @brief Worker thread: load chunks until none is left
+ */
+static DWORD WINAPI loader_worker(LPVOID param) {
+    FileLoader* loader = (FileLoader*)param;
+    QalamResult result = QALAM_OK;
+
+    char* bytes = (char*)qalam_mem_alloc(QALAM_MEMORY_BUFFER,
+                                         FILE_LOADER_CHUNK_SIZE + FILE_LOADER_MAX_CONTINUATION);
+    if (!bytes) {
+        result = QALAM_ERROR_OUT_OF_MEMORY;
+    }
+
+    while (result == QALAM_OK && !InterlockedCompareExchange(&loader->cancel, 0, 0) &&
+           InterlockedCompareExchange(&loader->error, QALAM_OK, QALAM_OK) == QALAM_OK) {
+        size_t index = (size_t)InterlockedIncrement(&loader->next_slot) - 1;
+        if (index >= loader->slot_count) {
+            break;
+        }
+
+        result = loader_load_slot(loader, index, bytes);
+        if (result == QALAM_OK) {
+            InterlockedExchange(&loader->slots[index].ready, 1);
+            if (loader->ready) {
+                loader->ready(loader->user_data);
+            }
+        }
+    }
+
+    qalam_mem_free(bytes);
+    if (result != QALAM_OK) {
+        InterlockedCompareExchange(&loader->error, (LONG)result, QALAM_OK);
+    }
+
+    /* The owner learns about failures, and that nothing more will come */
+    bool last = InterlockedDecrement(&loader->running) == 0;
+    if (loader->ready && (last || result != QALAM_OK)) {
+        loader->ready(loader->user_data);
+    }
+    return 0;
+}
+
+/**
+ * @brief Join the workers and close the file
+ */
+static void loader_join(FileLoader* loader) {
+    for (size_t i = 0; i < loader->thread_count; i++) {
+        WaitForSingleObject(loader->threads[i], INFINITE);
+        CloseHandle(loader->threads[i]);
+    }
+    loader->thread_count = 0;
+
+    if (loader->file != INVALID_HANDLE_VALUE && loader->file) {
+        CloseHandle(loader->file);
+        loader->file = INVALID_HANDLE_VALUE;
+    }
+}
+
+/**
+ * @brief Number of workers worth starting for the chunks left
+ */
+static size_t loader_worker_count(size_t chunks) {
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+
+    /* Leave a core for the thread that absorbs and draws */
+    size_t workers = info.dwNumberOfProcessors > 1 ? info.dwNumberOfProcessors - 1 : 1;
+    if (workers > FILE_LOADER_MAX_WORKERS) {
+        workers = FILE_LOADER_MAX_WORKERS;
+    }
+    return workers < chunks ? workers : chunks;
+}
+
+/*=============================================================================
+ * Lifecycle
+ *============================================================================*/
+
+QalamResult file_loader_open(FileLoader** loader, const wchar_t* filepath,
+                             QalamLoadReadyCallback ready, void* user_data) {
+    if (!loader || !filepath) {
+        return QALAM_ERROR_NULL_POINTER;
+    }
+
+    FileLoader* fl = (FileLoader*)qalam_mem_calloc(QALAM_MEMORY_BUFFER, 1, sizeof(FileLoader));
+    if (!fl) {
+        return QALAM_ERROR_OUT_OF_MEMORY;
+    }
+    fl->ready = ready;
+    fl->user_data = user_data;
+
+    fl->file = CreateFileW(filepath, GENERIC_READ, FILE_SHARE_READ, NULL,
+                           OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (fl->file == INVALID_HANDLE_VALUE) {
+        qalam_mem_free(fl);
+        return QALAM_ERROR_FILE_NOT_FOUND;
+    }
+
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(fl->file, &fileSize)) {
+        file_loader_close(fl);
+        return QALAM_ERROR_FILE_READ;
+    }
+    if ((unsigned long long)fileSize.QuadPart > SIZE_MAX / sizeof(wchar_t)) {
+        file_loader_close(fl);
+        return QALAM_ERROR_OUT_OF_MEMORY;
+    }
+    fl->size = (size_t)fileSize.QuadPart;
+
+    /* Empty files are simply complete */
+    if (fl->size == 0) {
+        loader_join(fl);
+        *loader = fl;
+        return QALAM_OK;
+    }
+
+    fl->slot_count = fl->size > FILE_LOADER_FIRST_CHUNK
+                         ? (fl->size - FILE_LOADER_FIRST_CHUNK - 1) / FILE_LOADER_CHUNK_SIZE + 2
+                         : 1;
+    fl->slots = (LoaderSlot*)qalam_mem_calloc(QALAM_MEMORY_BUFFER,
+                                              fl->slot_count, sizeof(LoaderSlot));
+    char* bytes = (char*)qalam_mem_alloc(QALAM_MEMORY_BUFFER,
+                                         FILE_LOADER_FIRST_CHUNK + FILE_LOADER_MAX_CONTINUATION);
+    if (!fl->slots || !bytes) {
+        qalam_mem_free(bytes);
+        file_loader_close(fl);
+        return QALAM_ERROR_OUT_OF_MEMORY;
+    }
+
+    /* Load the first chunk now so the first screen is available at once */
+    QalamResult result = loader_load_slot(fl, 0, bytes);
+    qalam_mem_free(bytes);
+    if (result != QALAM_OK) {
+        file_loader_close(fl);
+        return result;
+    }
+    fl->slots[0].ready = 1;
+    fl->next_slot = 1;
+
+    size_t workers = loader_worker_count(fl->slot_count - 1);
+    fl->running = (LONG)workers;
+    for (size_t i = 0; i < workers; i++) {
+        fl->threads[i] = CreateThread(NULL, 0, loader_worker, fl, 0, NULL);
+        if (!fl->threads[i]) {
+            file_loader_close(fl);
+            return QALAM_ERROR_OUT_OF_MEMORY;
+        }
+        fl->thread_count++;
+    }
+    if (workers == 0) {
+        loader_join(fl);
+    }
+
+    *loader = fl;
+    return QALAM_OK;
+}
+
+void file_loader_close(FileLoader* loader) {
+    if (!loader) {
+        return;
+    }
+
+    InterlockedExchange(&loader->cancel, 1);
+    loader_join(loader);
+
+    if (loader->slots) {
+        for (size_t i = 0; i < loader->slot_count; i++) {
+            qalam_mem_free(loader->slots[i].text);
+            qalam_mem_free(loader->slots[i].line_lengths);
+        }
+        qalam_mem_free(loader->slots);
+    }
+    qalam_mem_free(loader);
+}
+
+/*=============================================================================
+ * Absorbing
+ *============================================================================*/
+
+const FileLoaderChunk* file_loader_peek(FileLoader* loader) {
+    if (loader->absorbed >= loader->slot_count) {
+        return NULL;
+    }
+
+    LoaderSlot* slot = &loader->slots[loader->absorbed];
+    if (!InterlockedCompareExchange(&slot->ready, 0, 0)) {
+        return NULL;
+    }
+
+    loader->peeked.byte_length = slot->byte_length;
+    loader->peeked.text_length = slot->text_length;
+    loader->peeked.line_lengths = slot->line_lengths;
+    loader->peeked.line_count = slot->line_count;
+    loader->peeked.tail_length = slot->tail_length;
+    return &loader->peeked;
+}
+
+void file_loader_advance(FileLoader* loader) {
+    LoaderSlot* slot = &loader->slots[loader->absorbed];
+
+    slot->text_start = loader->text_length;
+    loader->text_length += slot->text_length;
+    loader->bytes_absorbed += slot->byte_length;
+    loader->absorbed++;
+
+    qalam_mem_free(slot->line_lengths);
+    slot->line_lengths = NULL;
+
+    /* Nothing is left for the workers: release their threads and the file */
+    if (loader->absorbed == loader->slot_count) {
+        loader_join(loader);
+    }
+}
+
+bool file_loader_is_complete(const FileLoader* loader) {
+    return loader->absorbed == loader->slot_count;
+}
+
+QalamResult file_loader_get_status(FileLoader* loader) {
+    return (QalamResult)InterlockedCompareExchange(&loader->error, QALAM_OK, QALAM_OK);
+}
+
+QalamResult file_loader_wait(FileLoader* loader) {
+    loader_join(loader);
+    return (QalamResult)loader->error;
+}
+
+void file_loader_get_progress(const FileLoader* loader, size_t* bytes_loaded,
+                              size_t* bytes_total) {
+    if (bytes_loaded) {
+        *bytes_loaded = loader->bytes_absorbed;
+    }
+    if (bytes_total) {
+        *bytes_total = loader->size;
+    }
+}
+
+/*=============================================================================
+ * Text Access
+ *============================================================================*/
+
+const wchar_t* file_loader_text(void* context, size_t pos, size_t* available) {
+    FileLoader* loader = (FileLoader*)context;
+    if (pos >= loader->text_length) {
+        return NULL;
+    }
+
+    size_t index = loader->last_slot;
+    LoaderSlot* slot = &loader->slots[index];
+    if (pos < slot->text_start || pos >= slot->text_start + slot->text_length) {
+        /* Last absorbed slot starting at or before 'pos' (empty slots are skipped over) */
+        size_t lo = 0;
+        size_t hi = loader->absorbed - 1;
+        while (lo < hi) {
+            size_t mid = lo + (hi - lo + 1) / 2;
+            if (loader->slots[mid].text_start <= pos) {
+                lo = mid;
+            } else {
+                hi = mid - 1;
+            }
+        }
+        index = lo;
+        slot = &loader->slots[index];
+        loader->last_slot = index;
+    }
+
+    size_t offset = pos - slot->text_start;
+    *available = slot->text_length - offset;
+    return slot->text + offset;
+}
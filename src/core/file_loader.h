@@ -0,0 +1,165 @@
+/**
+ * @file file_loader.h
+ * @brief Qalam IDE - Background File Loader (Internal Header)
+ *
+ * Internal header for opening a UTF-8 file without blocking the caller.
+ * The first FILE_LOADER_FIRST_CHUNK bytes are read and decoded before
+ * file_loader_open() returns, so the top of the file can be shown at
+ * once. The rest is split into FILE_LOADER_CHUNK_SIZE chunks that a few
+ * worker threads claim in turn; each worker reads its chunk at its own
+ * file offset, decodes it to UTF-16 and measures its lines, so chunks
+ * are finished in parallel and in any order. The owning buffer absorbs
+ * them strictly in file order, stitching the line split between two
+ * chunks as it appends them to its line index.
+ *
+ * Chunk boundaries are moved past UTF-8 continuation bytes, so every
+ * chunk decodes on its own. Decoded chunks stay in memory and back the
+ * buffer's original text.
+ *
+ * @version 0.0.2
+ * @copyright (c) 2026 Qalam Project
+ *
+ * @note Thread Safety: Workers only fill chunks ahead of the absorbed
+ *       count and call the ready callback. Every function below must be
+ *       called from the owning buffer's thread.
+ */
+
+#ifndef QALAM_FILE_LOADER_H
+#define QALAM_FILE_LOADER_H
+
+#include "qalam.h"
+#include "editor.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*=============================================================================
+ * Configuration Constants
+ *============================================================================*/
+
+/** Bytes loaded before file_loader_open() returns */
+#define FILE_LOADER_FIRST_CHUNK     (64 * 1024)
+
+/** Bytes per chunk loaded by the workers */
+#define FILE_LOADER_CHUNK_SIZE      (1024 * 1024)
+
+/** Most worker threads per file */
+#define FILE_LOADER_MAX_WORKERS     4
+
+/*=============================================================================
+ * File Loader Structures
+ *============================================================================*/
+
+/**
+ * @brief A loaded chunk waiting to be absorbed
+ *
+ * line_lengths holds the newline-terminated runs of the chunk (each
+ * including its L'\n'); tail_length is the text after the last newline.
+ */
+typedef struct FileLoaderChunk {
+    size_t byte_length;             /**< Chunk size in bytes */
+    size_t text_length;             /**< Decoded length in wchar_t units */
+    const size_t* line_lengths;     /**< Newline-terminated run lengths */
+    size_t line_count;              /**< Entries in line_lengths */
+    size_t tail_length;             /**< Characters after the last newline */
+} FileLoaderChunk;
+
+/**
+ * @brief Opaque background file loader
+ */
+typedef struct FileLoader FileLoader;
+
+/*=============================================================================
+ * Lifecycle
+ *============================================================================*/
+
+/**
+ * @brief Open a file, load its first chunk and start the workers
+ *
+ * @param[out] loader Receives the loader
+ * @param filepath Path to the file
+ * @param ready Called from a worker whenever a chunk is ready and once
+ *        the workers have stopped (may be NULL)
+ * @param user_data User-provided context passed to 'ready'
+ * @return QALAM_OK on success, error code on failure
+ */
+QalamResult file_loader_open(FileLoader** loader, const wchar_t* filepath,
+                             QalamLoadReadyCallback ready, void* user_data);
+
+/**
+ * @brief Stop the workers, close the file and free all text
+ *
+ * @param loader Loader to close (may be NULL)
+ */
+void file_loader_close(FileLoader* loader);
+
+/*=============================================================================
+ * Absorbing
+ *============================================================================*/
+
+/**
+ * @brief Get the next chunk in file order if it is ready
+ *
+ * @return Chunk, or NULL if it is still loading (or all are absorbed)
+ */
+const FileLoaderChunk* file_loader_peek(FileLoader* loader);
+
+/**
+ * @brief Mark the chunk returned by file_loader_peek() as absorbed
+ *
+ * Its text becomes readable through file_loader_text().
+ */
+void file_loader_advance(FileLoader* loader);
+
+/**
+ * @brief Check whether every chunk has been absorbed
+ */
+bool file_loader_is_complete(const FileLoader* loader);
+
+/**
+ * @brief Get the workers' status without waiting
+ *
+ * @return QALAM_OK while loading or after success, otherwise the first
+ *         error a worker ran into
+ */
+QalamResult file_loader_get_status(FileLoader* loader);
+
+/**
+ * @brief Wait for the workers to finish and close the file
+ *
+ * @return QALAM_OK, or the first error a worker ran into
+ */
+QalamResult file_loader_wait(FileLoader* loader);
+
+/**
+ * @brief Get loading progress in bytes
+ *
+ * @param[out] bytes_loaded Bytes absorbed so far (optional)
+ * @param[out] bytes_total File size (optional)
+ */
+void file_loader_get_progress(const FileLoader* loader, size_t* bytes_loaded,
+                              size_t* bytes_total);
+
+/*=============================================================================
+ * Text Access
+ *============================================================================*/
+
+/**
+ * @brief Read decoded text at an offset of the absorbed text
+ *
+ * Matches PieceOriginalFn, so it can back a piece table's original text.
+ * The text stays valid until the loader is closed.
+ *
+ * @param context The FileLoader
+ * @param pos Offset in wchar_t units
+ * @param[out] available Receives the characters readable at the result
+ * @return Decoded text, or NULL past the absorbed text
+ */
+const wchar_t* file_loader_text(void* context, size_t pos, size_t* available);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* QALAM_FILE_LOADER_H */
@@ -0,0 +1,727 @@
+/**
+ * @file highlighter.c
+ * @brief Qalam IDE - Incremental Background Syntax Highlighter Implementation
+ *
+ * Each line keeps its ranges and the state it ended in, and a line is
+ * pending when its stored result cannot be trusted: it is new, its text
+ * changed, or the line above it now ends in a different state than the
+ * one it was lexed from. A line that is not pending was lexed from the
+ * end state its predecessor holds now, so the lines before the first
+ * pending one are all correct, and lexing can stop at the first line
+ * that ends as it did before while the next line is not pending.
+ *
+ * An edit replaces a run of lines; the last line of the run takes over
+ * the end state of the last line it replaced, which is the state the
+ * line after the run was lexed from. Lexing the run again converges as
+ * soon as that state comes out again.
+ *
+ * One job is in flight at a time, and whichever side holds it owns it:
+ * the owner fills it and marks it queued, the worker lexes it and marks
+ * it done, and the owner takes the results in. Edits made meanwhile only
+ * note the first line they touched, and results from there on are
+ * dropped when the job is taken in.
+ *
+ * @version 0.0.2
+ * @copyright (c) 2026 Qalam Project
+ *
+ * @note Thread Safety: Every function must be called from the buffer's
+ *       thread. Only the worker and the ready callback run elsewhere.
+ */
+
+#include "editor.h"
+#include "syntax_lexer.h"
+#include <stdlib.h>
+#include <string.h>
+
+/*=============================================================================
+ * Configuration Constants
+ *============================================================================*/
+
+/** Default characters per job outside the viewport */
+#define HIGHLIGHT_DEFAULT_BATCH_CHARS   (256 * 1024)
+
+/** Most lines per job, however short they are */
+#define HIGHLIGHT_MAX_BATCH_LINES       16384
+
+/** Initial number of line slots */
+#define HIGHLIGHT_INITIAL_CAPACITY      1024
+
+/** Job states */
+#define HIGHLIGHT_JOB_IDLE              0
+#define HIGHLIGHT_JOB_QUEUED            1
+#define HIGHLIGHT_JOB_DONE              2
+
+/*=============================================================================
+ * Internal Structures
+ *============================================================================*/
+
+/**
+ * @brief What is kept for a line
+ */
+typedef struct HighlightLine {
+    QalamStyleRange* ranges;        /**< Style ranges (owned), or NULL */
+    uint32_t range_count;           /**< Entries in 'ranges' */
+    uint32_t end_state;             /**< State the line ended in when last lexed */
+} HighlightLine;
+
+/**
+ * @brief A run of lines for the worker to lex
+ *
+ * The owner fills the input arrays, the worker the output.
+ */
+typedef struct HighlightJob {
+    size_t first_line;              /**< First line of the run */
+    size_t line_count;              /**< Lines in the run */
+    size_t line_capacity;           /**< Allocated entries of the per-line arrays */
+    uint32_t start_state;           /**< State the line above the run ends in */
+
+    /* Input */
+    wchar_t* text;                  /**< Text of the lines, back to back */
+    size_t text_capacity;           /**< Allocated characters of 'text' */
+    size_t* line_ends;              /**< End of each line in 'text' */
+    uint32_t* old_states;           /**< End state each line held */
+    bool* settled_after;            /**< The line after it was not pending */
+
+    /* Output */
+    uint32_t* end_states;           /**< End state of each lexed line */
+    size_t* range_ends;             /**< End of each line's ranges in 'ranges' */
+    SyntaxRangeList ranges;         /**< Ranges of all lexed lines */
+    size_t lexed;                   /**< Lines lexed (fewer once they caught up) */
+    QalamResult result;             /**< Why lexing stopped early, or QALAM_OK */
+} HighlightJob;
+
+/**
+ * @brief Highlighter state
+ */
+struct QalamHighlighter {
+    QalamBuffer* buffer;            /**< Buffer highlighted */
+    QalamHighlighterOptions options; /**< Options, batch size resolved */
+
+    /* Per-line state, owned by the buffer's thread */
+    HighlightLine* lines;           /**< One entry per line */
+    uint8_t* pending;               /**< 1 for each line still to be lexed */
+    size_t line_count;              /**< Lines tracked */
+    size_t line_capacity;           /**< Allocated entries of both arrays */
+    size_t pending_hint;            /**< No line before this one is pending */
+    size_t viewport_first;          /**< First line of the viewport */
+    size_t viewport_count;          /**< Lines in the viewport */
+
+    /* Worker */
+    HANDLE thread;                  /**< Worker thread */
+    HANDLE wake;                    /**< Auto-reset event the worker waits on */
+    volatile LONG job_state;        /**< HIGHLIGHT_JOB_* */
+    volatile LONG stop;             /**< Set to ask the worker to exit */
+    HighlightJob job;               /**< The one job, owned as job_state says */
+    size_t stale_from;              /**< Lines of the job in flight changed from here */
+
+    QalamHighlighterStats stats;    /**< Counters (line and range counts filled on request) */
+};
+
+/*=============================================================================
+ * Internal Helper Functions - Lines
+ *============================================================================*/
+
+static void highlight_mark_pending(QalamHighlighter* hl, size_t line) {
+    if (line < hl->line_count) {
+        hl->pending[line] = 1;
+        if (line < hl->pending_hint) {
+            hl->pending_hint = line;
+        }
+    }
+}
+
+/**
+ * @brief Find the first pending line in [from, to)
+ *
+ * @return The line, or 'to' if none is pending
+ */
+static size_t highlight_find_pending(const QalamHighlighter* hl, size_t from, size_t to) {
+    if (from >= to) {
+        return to;
+    }
+    const uint8_t* found = (const uint8_t*)memchr(hl->pending + from, 1, to - from);
+    return found ? (size_t)(found - hl->pending) : to;
+}
+
+static QalamResult highlight_reserve_lines(QalamHighlighter* hl, size_t count) {
+    if (count <= hl->line_capacity) {
+        return QALAM_OK;
+    }
+
+    size_t capacity = hl->line_capacity ? hl->line_capacity : HIGHLIGHT_INITIAL_CAPACITY;
+    while (capacity < count) {
+        capacity = capacity > SIZE_MAX / 2 ? count : capacity * 2;
+    }
+
+    HighlightLine* lines = (HighlightLine*)qalam_mem_realloc(
+        QALAM_MEMORY_SYNTAX, hl->lines, capacity * sizeof(HighlightLine));
+    if (!lines) {
+        return QALAM_ERROR_OUT_OF_MEMORY;
+    }
+    hl->lines = lines;
+
+    uint8_t* pending = (uint8_t*)qalam_mem_realloc(QALAM_MEMORY_SYNTAX, hl->pending, capacity);
+    if (!pending) {
+        return QALAM_ERROR_OUT_OF_MEMORY;
+    }
+    hl->pending = pending;
+    hl->line_capacity = capacity;
+    return QALAM_OK;
+}
+
+static void highlight_free_lines(QalamHighlighter* hl, size_t first, size_t end) {
+    for (size_t i = first; i < end; i++) {
+        qalam_mem_free(hl->lines[i].ranges);
+        hl->lines[i].ranges = NULL;
+        hl->lines[i].range_count = 0;
+    }
+}
+
+/**
+ * @brief Forget every line and track the buffer's lines afresh, all pending
+ */
+static QalamResult highlight_reset(QalamHighlighter* hl) {
+    highlight_free_lines(hl, 0, hl->line_count);
+    hl->line_count = 0;
+    hl->pending_hint = 0;
+    hl->stale_from = 0;
+
+    size_t count = qalam_buffer_get_line_count(hl->buffer);
+    QalamResult result = highlight_reserve_lines(hl, count);
+    if (result != QALAM_OK) {
+        return result;
+    }
+
+    memset(hl->lines, 0, count * sizeof(HighlightLine));
+    memset(hl->pending, 1, count);
+    hl->line_count = count;
+    return QALAM_OK;
+}
+
+/**
+ * @brief Store a lexed line's ranges
+ *
+ * @return true if they differ from the ones it held
+ */
+static bool highlight_store_ranges(QalamHighlighter* hl, size_t line,
+                                   const QalamStyleRange* ranges, size_t count,
+                                   QalamResult* result) {
+    HighlightLine* entry = &hl->lines[line];
+    if (entry->range_count == count &&
+        (count == 0 || memcmp(entry->ranges, ranges, count * sizeof(QalamStyleRange)) == 0)) {
+        return false;
+    }
+
+    QalamStyleRange* copy = NULL;
+    if (count > 0) {
+        copy = (QalamStyleRange*)qalam_mem_alloc(QALAM_MEMORY_SYNTAX,
+                                                 count * sizeof(QalamStyleRange));
+        if (!copy) {
+            *result = QALAM_ERROR_OUT_OF_MEMORY;
+            return false;
+        }
+        memcpy(copy, ranges, count * sizeof(QalamStyleRange));
+    }
+
+    qalam_mem_free(entry->ranges);
+    entry->ranges = copy;
+    entry->range_count = (uint32_t)count;
+    return true;
+}
+
+/*=============================================================================
+ * Internal Helper Functions - Jobs
+ *============================================================================*/
+
+static void highlight_free_job(HighlightJob* job) {
+    qalam_mem_free(job->text);
+    qalam_mem_free(job->line_ends);
+    qalam_mem_free(job->old_states);
+    qalam_mem_free(job->settled_after);
+    qalam_mem_free(job->end_states);
+    qalam_mem_free(job->range_ends);
+    syntax_range_list_free(&job->ranges);
+    memset(job, 0, sizeof(HighlightJob));
+}
+
+static QalamResult highlight_reserve_job_lines(HighlightJob* job, size_t count) {
+    if (count <= job->line_capacity) {
+        return QALAM_OK;
+    }
+
+    size_t capacity = job->line_capacity ? job->line_capacity : 256;
+    while (capacity < count) {
+        capacity *= 2;
+    }
+
+    size_t* line_ends = (size_t*)qalam_mem_realloc(QALAM_MEMORY_SYNTAX, job->line_ends,
+                                                   capacity * sizeof(size_t));
+    if (line_ends) {
+        job->line_ends = line_ends;
+    }
+    uint32_t* old_states = (uint32_t*)qalam_mem_realloc(QALAM_MEMORY_SYNTAX, job->old_states,
+                                                        capacity * sizeof(uint32_t));
+    if (old_states) {
+        job->old_states = old_states;
+    }
+    bool* settled_after = (bool*)qalam_mem_realloc(QALAM_MEMORY_SYNTAX, job->settled_after,
+                                                   capacity * sizeof(bool));
+    if (settled_after) {
+        job->settled_after = settled_after;
+    }
+    uint32_t* end_states = (uint32_t*)qalam_mem_realloc(QALAM_MEMORY_SYNTAX, job->end_states,
+                                                        capacity * sizeof(uint32_t));
+    if (end_states) {
+        job->end_states = end_states;
+    }
+    size_t* range_ends = (size_t*)qalam_mem_realloc(QALAM_MEMORY_SYNTAX, job->range_ends,
+                                                    capacity * sizeof(size_t));
+    if (range_ends) {
+        job->range_ends = range_ends;
+    }
+
+    if (!line_ends || !old_states || !settled_after || !end_states || !range_ends) {
+        return QALAM_ERROR_OUT_OF_MEMORY;
+    }
+    job->line_capacity = capacity;
+    return QALAM_OK;
+}
+
+static QalamResult highlight_append_text(HighlightJob* job, size_t* used,
+                                         const wchar_t* text, size_t length) {
+    if (length > job->text_capacity - *used) {
+        size_t capacity = job->text_capacity ? job->text_capacity : 4096;
+        while (capacity - *used < length) {
+            capacity *= 2;
+        }
+        wchar_t* grown = (wchar_t*)qalam_mem_realloc(QALAM_MEMORY_SYNTAX, job->text,
+                                                     capacity * sizeof(wchar_t));
+        if (!grown) {
+            return QALAM_ERROR_OUT_OF_MEMORY;
+        }
+        job->text = grown;
+        job->text_capacity = capacity;
+    }
+
+    memcpy(job->text + *used, text, length * sizeof(wchar_t));
+    *used += length;
+    return QALAM_OK;
+}
+
+/**
+ * @brief Copy lines [first, end) into the job
+ *
+ * With 'batch_chars', stops after the line that reaches that much text.
+ */
+static QalamResult highlight_fill_job(QalamHighlighter* hl, size_t first, size_t end,
+                                      size_t batch_chars) {
+    HighlightJob* job = &hl->job;
+    size_t used = 0;
+
+    if (end - first > HIGHLIGHT_MAX_BATCH_LINES) {
+        end = first + HIGHLIGHT_MAX_BATCH_LINES;
+    }
+    QalamResult result = highlight_reserve_job_lines(job, end - first);
+    if (result != QALAM_OK) {
+        return result;
+    }
+
+    job->first_line = first;
+    job->line_count = 0;
+    job->start_state = first > 0 ? hl->lines[first - 1].end_state : SYNTAX_STATE_NORMAL;
+
+    for (size_t line = first; line < end; line++) {
+        QalamTextView view;
+        result = qalam_buffer_get_line_view(hl->buffer, line, false, &view);
+        for (size_t s = 0; result == QALAM_OK && s < view.segment_count; s++) {
+            result = highlight_append_text(job, &used, view.segments[s], view.lengths[s]);
+        }
+        if (result != QALAM_OK) {
+            return result;
+        }
+
+        size_t j = job->line_count++;
+        job->line_ends[j] = used;
+        job->old_states[j] = hl->lines[line].end_state;
+        job->settled_after[j] = line + 1 < hl->line_count && !hl->pending[line + 1];
+
+        if (batch_chars > 0 && used >= batch_chars) {
+            break;
+        }
+    }
+
+    job->lexed = 0;
+    job->result = QALAM_OK;
+    return QALAM_OK;
+}
+
+/**
+ * @brief Lex a job's lines (worker thread)
+ */
+static void highlight_run_job(HighlightJob* job) {
+    QALAM_TRACE_BEGIN(span, QALAM_TRACE_SYNTAX, "lex_job");
+
+    uint32_t state = job->start_state;
+    size_t start = 0;
+    job->ranges.count = 0;
+    job->lexed = 0;
+    job->result = QALAM_OK;
+
+    for (size_t j = 0; j < job->line_count; j++) {
+        QalamResult result = syntax_lex_line(job->text + start, job->line_ends[j] - start,
+                                             state, &job->ranges, &state);
+        if (result != QALAM_OK) {
+            job->result = result;
+            break;
+        }
+
+        job->end_states[j] = state;
+        job->range_ends[j] = job->ranges.count;
+        job->lexed = j + 1;
+        start = job->line_ends[j];
+
+        /* Caught up: the next line was lexed from this very state */
+        if (job->settled_after[j] && state == job->old_states[j]) {
+            break;
+        }
+    }
+
+    QALAM_TRACE_COUNTER(QALAM_TRACE_SYNTAX, "lines_lexed", (int64_t)job->lexed);
+    QALAM_TRACE_END(span);
+}
+
+/**
+ * @brief Worker thread: lex each job it is woken for
+ */
+static DWORD WINAPI highlight_worker(LPVOID param) {
+    QalamHighlighter* hl = (QalamHighlighter*)param;
+
+    for (;;) {
+        WaitForSingleObject(hl->wake, INFINITE);
+        if (InterlockedCompareExchange(&hl->stop, 0, 0)) {
+            break;
+        }
+        if (InterlockedCompareExchange(&hl->job_state, HIGHLIGHT_JOB_QUEUED,
+                                       HIGHLIGHT_JOB_QUEUED) != HIGHLIGHT_JOB_QUEUED) {
+            continue;
+        }
+
+        highlight_run_job(&hl->job);
+        InterlockedExchange(&hl->job_state, HIGHLIGHT_JOB_DONE);
+        if (hl->options.ready) {
+            hl->options.ready(hl->options.user_data);
+        }
+    }
+    return 0;
+}
+
+/**
+ * @brief Store the results of a done job
+ *
+ * @param[in,out] changed_first First line whose ranges changed
+ * @param[in,out] changed_end Line after the last one whose ranges changed
+ */
+static QalamResult highlight_absorb_job(QalamHighlighter* hl, size_t* changed_first,
+                                        size_t* changed_end) {
+    HighlightJob* job = &hl->job;
+    QalamResult result = QALAM_OK;
+
+    size_t end = job->first_line + job->lexed;
+    if (end > hl->stale_from) {
+        hl->stats.lines_dropped += end - (hl->stale_from > job->first_line ? hl->stale_from
+                                                                           : job->first_line);
+        end = hl->stale_from;
+    }
+    if (end > hl->line_count) {
+        end = hl->line_count;
+    }
+
+    for (size_t line = job->first_line; line < end && result == QALAM_OK; line++) {
+        size_t j = line - job->first_line;
+        size_t range_start = j > 0 ? job->range_ends[j - 1] : 0;
+        if (highlight_store_ranges(hl, line, job->ranges.ranges + range_start,
+                                   job->range_ends[j] - range_start, &result)) {
+            if (line < *changed_first) {
+                *changed_first = line;
+            }
+            *changed_end = line + 1;
+        }
+        if (result != QALAM_OK) {
+            break;      /* The line stays pending */
+        }
+
+        uint32_t old_state = hl->lines[line].end_state;
+        hl->lines[line].end_state = job->end_states[j];
+        hl->pending[line] = 0;
+        if (job->end_states[j] != old_state) {
+            highlight_mark_pending(hl, line + 1);
+        }
+    }
+
+    hl->stats.jobs++;
+    hl->stats.lines_lexed += job->lexed;
+    return result != QALAM_OK ? result : job->result;
+}
+
+/**
+ * @brief Pick the next lines to lex and hand them to the worker
+ *
+ * @return true if a job was queued
+ */
+static bool highlight_queue_job(QalamHighlighter* hl, QalamResult* result) {
+    size_t viewport_end = hl->viewport_first + hl->viewport_count;
+    if (viewport_end > hl->line_count || viewport_end < hl->viewport_first) {
+        viewport_end = hl->line_count;
+    }
+
+    /* The viewport first, from the state the line above it holds so far */
+    size_t first = highlight_find_pending(hl, hl->viewport_first, viewport_end);
+    size_t end = viewport_end;
+    size_t batch_chars = 0;
+
+    if (first >= viewport_end) {
+        hl->pending_hint = highlight_find_pending(hl, hl->pending_hint, hl->line_count);
+        first = hl->pending_hint;
+        end = hl->line_count;
+        batch_chars = hl->options.batch_chars;
+    }
+    if (first >= end) {
+        return false;
+    }
+
+    *result = highlight_fill_job(hl, first, end, batch_chars);
+    if (*result != QALAM_OK) {
+        return false;
+    }
+
+    hl->stale_from = SIZE_MAX;
+    InterlockedExchange(&hl->job_state, HIGHLIGHT_JOB_QUEUED);
+    SetEvent(hl->wake);
+    return true;
+}
+
+/*=============================================================================
+ * Lifecycle
+ *============================================================================*/
+
+QalamResult qalam_highlighter_get_default_options(QalamHighlighterOptions* options) {
+    if (!options) {
+        return QALAM_ERROR_NULL_POINTER;
+    }
+
+    options->batch_chars = HIGHLIGHT_DEFAULT_BATCH_CHARS;
+    options->ready = NULL;
+    options->user_data = NULL;
+    return QALAM_OK;
+}
+
+QalamResult qalam_highlighter_create(QalamHighlighter** highlighter, QalamBuffer* buffer,
+                                     const QalamHighlighterOptions* options) {
+    if (!highlighter || !buffer) {
+        return QALAM_ERROR_NULL_POINTER;
+    }
+
+    QalamHighlighter* hl = (QalamHighlighter*)qalam_mem_calloc(QALAM_MEMORY_SYNTAX, 1,
+                                                               sizeof(QalamHighlighter));
+    if (!hl) {
+        return QALAM_ERROR_OUT_OF_MEMORY;
+    }
+
+    hl->buffer = buffer;
+    if (options) {
+        hl->options = *options;
+    } else {
+        qalam_highlighter_get_default_options(&hl->options);
+    }
+    if (hl->options.batch_chars == 0) {
+        hl->options.batch_chars = HIGHLIGHT_DEFAULT_BATCH_CHARS;
+    }
+
+    QalamResult result = highlight_reset(hl);
+    if (result != QALAM_OK) {
+        qalam_highlighter_destroy(hl);
+        return result;
+    }
+
+    hl->wake = CreateEventW(NULL, FALSE, FALSE, NULL);
+    if (!hl->wake) {
+        qalam_highlighter_destroy(hl);
+        return QALAM_ERROR_OUT_OF_MEMORY;
+    }
+    hl->thread = CreateThread(NULL, 0, highlight_worker, hl, 0, NULL);
+    if (!hl->thread) {
+        qalam_highlighter_destroy(hl);
+        return QALAM_ERROR_OUT_OF_MEMORY;
+    }
+
+    *highlighter = hl;
+    return QALAM_OK;
+}
+
+void qalam_highlighter_destroy(QalamHighlighter* highlighter) {
+    if (!highlighter) {
+        return;
+    }
+
+    if (highlighter->thread) {
+        InterlockedExchange(&highlighter->stop, 1);
+        SetEvent(highlighter->wake);
+        WaitForSingleObject(highlighter->thread, INFINITE);
+        CloseHandle(highlighter->thread);
+    }
+    if (highlighter->wake) {
+        CloseHandle(highlighter->wake);
+    }
+
+    highlight_free_lines(highlighter, 0, highlighter->line_count);
+    qalam_mem_free(highlighter->lines);
+    qalam_mem_free(highlighter->pending);
+    highlight_free_job(&highlighter->job);
+    qalam_mem_free(highlighter);
+}
+
+/*=============================================================================
+ * Updating
+ *============================================================================*/
+
+QalamResult qalam_highlighter_on_buffer_change(QalamHighlighter* highlighter,
+                                               const QalamBufferChange* change) {
+    if (!highlighter || !change) {
+        return QALAM_ERROR_NULL_POINTER;
+    }
+
+    QalamHighlighter* hl = highlighter;
+    size_t first = change->first_line;
+    size_t old_count = change->old_line_count;
+    size_t new_count = change->new_line_count;
+
+    if (first < hl->stale_from) {
+        hl->stale_from = first;
+    }
+    if (first > hl->line_count || old_count > hl->line_count - first || new_count == 0) {
+        /* Out of step with the buffer: start over */
+        return highlight_reset(hl);
+    }
+
+    /* The line after the run was lexed from the last replaced line's state */
+    uint32_t carried = old_count > 0 ? hl->lines[first + old_count - 1].end_state
+                                     : SYNTAX_STATE_NORMAL;
+    size_t tail = hl->line_count - first - old_count;
+
+    if (new_count > old_count) {
+        QalamResult result = highlight_reserve_lines(hl, hl->line_count + new_count - old_count);
+        if (result != QALAM_OK) {
+            highlight_reset(hl);
+            return result;
+        }
+    } else {
+        highlight_free_lines(hl, first + new_count, first + old_count);
+    }
+
+    memmove(hl->lines + first + new_count, hl->lines + first + old_count,
+            tail * sizeof(HighlightLine));
+    memmove(hl->pending + first + new_count, hl->pending + first + old_count, tail);
+    if (new_count > old_count) {
+        memset(hl->lines + first + old_count, 0, (new_count - old_count) * sizeof(HighlightLine));
+    }
+    hl->line_count = hl->line_count - old_count + new_count;
+
+    /* Replaced lines keep their ranges until lexed again, so they do not flicker */
+    hl->lines[first + new_count - 1].end_state = carried;
+    memset(hl->pending + first, 1, new_count);
+    if (first < hl->pending_hint) {
+        hl->pending_hint = first;
+    }
+    return QALAM_OK;
+}
+
+void qalam_highlighter_set_viewport(QalamHighlighter* highlighter, size_t first_line,
+                                    size_t line_count) {
+    if (highlighter) {
+        highlighter->viewport_first = first_line;
+        highlighter->viewport_count = line_count;
+    }
+}
+
+QalamResult qalam_highlighter_update(QalamHighlighter* highlighter, size_t* first_line,
+                                     size_t* line_count) {
+    if (first_line) {
+        *first_line = 0;
+    }
+    if (line_count) {
+        *line_count = 0;
+    }
+    if (!highlighter) {
+        return QALAM_ERROR_NULL_POINTER;
+    }
+
+    QalamHighlighter* hl = highlighter;
+    QalamResult result = QALAM_OK;
+    size_t changed_first = SIZE_MAX;
+    size_t changed_end = 0;
+
+    LONG state = InterlockedCompareExchange(&hl->job_state, HIGHLIGHT_JOB_DONE,
+                                            HIGHLIGHT_JOB_DONE);
+    if (state == HIGHLIGHT_JOB_DONE) {
+        result = highlight_absorb_job(hl, &changed_first, &changed_end);
+        InterlockedExchange(&hl->job_state, HIGHLIGHT_JOB_IDLE);
+        state = HIGHLIGHT_JOB_IDLE;
+    }
+
+    if (state == HIGHLIGHT_JOB_IDLE && result == QALAM_OK &&
+        !qalam_buffer_is_hibernated(hl->buffer)) {
+        highlight_queue_job(hl, &result);
+    }
+
+    if (changed_first < changed_end) {
+        if (first_line) {
+            *first_line = changed_first;
+        }
+        if (line_count) {
+            *line_count = changed_end - changed_first;
+        }
+    }
+    return result;
+}
+
+/*=============================================================================
+ * Queries
+ *============================================================================*/
+
+bool qalam_highlighter_is_complete(const QalamHighlighter* highlighter) {
+    if (!highlighter) {
+        return false;
+    }
+    return highlight_find_pending(highlighter, highlighter->pending_hint,
+                                  highlighter->line_count) == highlighter->line_count;
+}
+
+size_t qalam_highlighter_get_line_styles(const QalamHighlighter* highlighter,
+                                         size_t line_number, const QalamStyleRange** ranges) {
+    if (ranges) {
+        *ranges = NULL;
+    }
+    if (!highlighter || !ranges || line_number >= highlighter->line_count) {
+        return 0;
+    }
+
+    *ranges = highlighter->lines[line_number].ranges;
+    return highlighter->lines[line_number].range_count;
+}
+
+QalamResult qalam_highlighter_get_stats(const QalamHighlighter* highlighter,
+                                        QalamHighlighterStats* stats) {
+    if (!highlighter || !stats) {
+        return QALAM_ERROR_NULL_POINTER;
+    }
+
+    *stats = highlighter->stats;
+    stats->line_count = highlighter->line_count;
+    stats->pending_lines = 0;
+    stats->range_count = 0;
+    for (size_t i = 0; i < highlighter->line_count; i++) {
+        stats->pending_lines += highlighter->pending[i];
+        stats->range_count += highlighter->lines[i].range_count;
+    }
+    return QALAM_OK;
+}
@@ -0,0 +1,732 @@
+/**
+ * @file line_index.c
+ * @brief Qalam IDE - Line Start Index Implementation
+ *
+ * Line lengths are stored in chunks of up to LINE_INDEX_CHUNK_MAX lines.
+ * Two Fenwick trees over the chunk totals locate the chunk holding a
+ * line or an offset in O(log chunks); the remaining work is bounded by
+ * the chunk size. Edits that stay inside one chunk update the trees with
+ * a single point update; edits that split or merge chunks rebuild the
+ * trees in O(chunks), which is still independent of the text size.
+ *
+ * @version 0.0.2
+ * @copyright (c) 2026 Qalam Project
+ *
+ * @note Thread Safety: Functions in this file are NOT thread-safe.
+ */
+
+#include "line_index.h"
+#include "text_scan.h"
+#include <stdlib.h>
+#include <string.h>
+
+/** Number of new line lengths kept on the stack before allocating */
+#define LINE_INDEX_STACK_LINES  64
+
+/** Last line generation handed out, shared by every index in the process */
+static volatile LONG g_line_generation = 0;
+
+/*=============================================================================
+ * Internal Helper Functions - Chunk Storage
+ *============================================================================*/
+
+/**
+ * @brief Allocate an empty chunk
+ */
+static LineChunk* index_chunk_create(void) {
+    LineChunk* chunk = (LineChunk*)qalam_mem_alloc(QALAM_MEMORY_BUFFER, sizeof(LineChunk));
+    if (chunk) {
+        chunk->count = 0;
+        chunk->chars = 0;
+    }
+    return chunk;
+}
+
+/**
+ * @brief Ensure room for at least 'needed' chunk slots
+ *
+ * The Fenwick trees are sized together with the chunk array.
+ */
+static QalamResult index_reserve_chunks(LineIndex* index, size_t needed) {
+    if (needed <= index->chunk_capacity) {
+        return QALAM_OK;
+    }
+
+    size_t new_capacity = index->chunk_capacity ? index->chunk_capacity * 2 : 16;
+    while (new_capacity < needed) {
+        new_capacity *= 2;
+    }
+
+    LineChunk** chunks = (LineChunk**)qalam_mem_realloc(QALAM_MEMORY_BUFFER, index->chunks,
+                                                        new_capacity * sizeof(LineChunk*));
+    if (!chunks) {
+        return QALAM_ERROR_OUT_OF_MEMORY;
+    }
+    index->chunks = chunks;
+
+    size_t* tree_lines = (size_t*)qalam_mem_realloc(QALAM_MEMORY_BUFFER, index->tree_lines,
+                                                    (new_capacity + 1) * sizeof(size_t));
+    if (!tree_lines) {
+        return QALAM_ERROR_OUT_OF_MEMORY;
+    }
+    index->tree_lines = tree_lines;
+
+    size_t* tree_chars = (size_t*)qalam_mem_realloc(QALAM_MEMORY_BUFFER, index->tree_chars,
+                                                    (new_capacity + 1) * sizeof(size_t));
+    if (!tree_chars) {
+        return QALAM_ERROR_OUT_OF_MEMORY;
+    }
+    index->tree_chars = tree_chars;
+
+    index->chunk_capacity = new_capacity;
+    return QALAM_OK;
+}
+
+/*=============================================================================
+ * Internal Helper Functions - Fenwick Trees
+ *============================================================================*/
+
+/**
+ * @brief Rebuild both Fenwick trees and the totals from the chunk array
+ */
+static void index_rebuild_trees(LineIndex* index) {
+    size_t n = index->chunk_count;
+    size_t lines = 0;
+    size_t chars = 0;
+
+    index->tree_lines[0] = 0;
+    index->tree_chars[0] = 0;
+
+    for (size_t i = 1; i <= n; i++) {
+        index->tree_lines[i] = index->chunks[i - 1]->count;
+        index->tree_chars[i] = index->chunks[i - 1]->chars;
+        lines += index->chunks[i - 1]->count;
+        chars += index->chunks[i - 1]->chars;
+    }
+
+    for (size_t i = 1; i <= n; i++) {
+        size_t parent = i + (i & (~i + 1));
+        if (parent <= n) {
+            index->tree_lines[parent] += index->tree_lines[i];
+            index->tree_chars[parent] += index->tree_chars[i];
+        }
+    }
+
+    index->line_count = lines;
+    index->char_count = chars;
+}
+
+/**
+ * @brief Add a (possibly negative, two's complement) delta to one chunk
+ */
+static void index_tree_add(size_t* tree, size_t n, size_t chunk, size_t delta) {
+    for (size_t i = chunk + 1; i <= n; i += i & (~i + 1)) {
+        tree[i] += delta;
+    }
+}
+
+/**
+ * @brief Sum of the first 'count' chunks
+ */
+static size_t index_tree_prefix(const size_t* tree, size_t count) {
+    size_t sum = 0;
+    for (size_t i = count; i > 0; i -= i & (~i + 1)) {
+        sum += tree[i];
+    }
+    return sum;
+}
+
+/**
+ * @brief Find the chunk containing a line or character position
+ *
+ * Returns the number of leading chunks whose total is <= *value and
+ * subtracts that total from *value, leaving the position inside the
+ * returned chunk.
+ */
+static size_t index_tree_find(const size_t* tree, size_t n, size_t* value) {
+    size_t step = 1;
+    while (step * 2 <= n) {
+        step *= 2;
+    }
+
+    size_t pos = 0;
+    for (; step > 0; step >>= 1) {
+        if (pos + step <= n && tree[pos + step] <= *value) {
+            pos += step;
+            *value -= tree[pos];
+        }
+    }
+
+    return pos;
+}
+
+/*=============================================================================
+ * Internal Helper Functions - Lookup
+ *============================================================================*/
+
+/**
+ * @brief Locate a line as (chunk, position in chunk)
+ */
+static void index_locate_line(const LineIndex* index, size_t line, size_t* chunk, size_t* pos) {
+    if (line >= index->line_count) {
+        line = index->line_count - 1;
+    }
+
+    size_t rem = line;
+    size_t c = index_tree_find(index->tree_lines, index->chunk_count, &rem);
+
+    *chunk = c;
+    *pos = rem;
+}
+
+/**
+ * @brief Locate the line containing an offset
+ *
+ * @return Line number; chunk, position and line start are returned via out params
+ */
+static size_t index_locate_offset(const LineIndex* index, size_t offset,
+                                  size_t* chunk, size_t* pos, size_t* line_start) {
+    size_t last_chunk = index->chunk_count - 1;
+
+    if (offset >= index->char_count) {
+        /* At or past the end: the last line */
+        const LineChunk* tail = index->chunks[last_chunk];
+        *chunk = last_chunk;
+        *pos = tail->count - 1;
+        *line_start = index->char_count - tail->lens[tail->count - 1];
+        return index->line_count - 1;
+    }
+
+    size_t rem = offset;
+    size_t c = index_tree_find(index->tree_chars, index->chunk_count, &rem);
+    const LineChunk* ch = index->chunks[c];
+
+    size_t i = 0;
+    while (rem >= ch->lens[i]) {
+        rem -= ch->lens[i];
+        i++;
+    }
+
+    *chunk = c;
+    *pos = i;
+    *line_start = offset - rem;
+    return index_tree_prefix(index->tree_lines, c) + i;
+}
+
+/*=============================================================================
+ * Internal Helper Functions - Structural Edits
+ *============================================================================*/
+
+/**
+ * @brief Replace a run of lines with new line lengths
+ *
+ * Lines [first, first + remove_count) are replaced by new_lens[0..new_count).
+ * Callers always pass new_count >= 1 (the merged/split line), so the
+ * index never becomes empty.
+ */
+static QalamResult index_splice(LineIndex* index, size_t first, size_t remove_count,
+                                const size_t* new_lens, size_t new_count) {
+    size_t ci, pos;
+    index_locate_line(index, first, &ci, &pos);
+
+    /* Find the chunk holding the first line kept after the removed run */
+    size_t cj = ci;
+    size_t end = pos + remove_count;
+    while (end > index->chunks[cj]->count) {
+        end -= index->chunks[cj]->count;
+        cj++;
+    }
+
+    LineChunk* head = index->chunks[ci];
+    LineChunk* last = index->chunks[cj];
+    size_t tail = last->count - end;
+    size_t total = pos + new_count + tail;
+
+    size_t added_chars = 0;
+    for (size_t i = 0; i < new_count; i++) {
+        added_chars += new_lens[i];
+    }
+
+    /* Fast path: the edit stays inside one chunk */
+    if (ci == cj && total <= LINE_INDEX_CHUNK_MAX) {
+        size_t removed_chars = 0;
+        for (size_t i = pos; i < end; i++) {
+            removed_chars += head->lens[i];
+        }
+
+        memmove(&head->lens[pos + new_count], &head->lens[end], tail * sizeof(size_t));
+        memcpy(&head->lens[pos], new_lens, new_count * sizeof(size_t));
+        memmove(&head->meta[pos + new_count], &head->meta[end], tail * sizeof(LineMeta));
+        memset(&head->meta[pos], 0, new_count * sizeof(LineMeta));
+        memmove(&head->gens[pos + new_count], &head->gens[end], tail * sizeof(uint32_t));
+        memset(&head->gens[pos], 0, new_count * sizeof(uint32_t));
+        head->count = total;
+        head->chars = head->chars - removed_chars + added_chars;
+
+        index_tree_add(index->tree_lines, index->chunk_count, ci, new_count - remove_count);
+        index_tree_add(index->tree_chars, index->chunk_count, ci, added_chars - removed_chars);
+        index->line_count = index->line_count - remove_count + new_count;
+        index->char_count = index->char_count - removed_chars + added_chars;
+        return QALAM_OK;
+    }
+
+    /* General path: rebuild chunks ci..cj from the merged run of lengths */
+    size_t span = cj - ci + 1;
+    size_t needed = (total + LINE_INDEX_CHUNK_FILL - 1) / LINE_INDEX_CHUNK_FILL;
+    size_t extra = needed > span ? needed - span : 0;
+
+    QalamResult result = index_reserve_chunks(index, index->chunk_count - span + needed);
+    if (result != QALAM_OK) {
+        return result;
+    }
+
+    size_t* merged = (size_t*)qalam_mem_alloc(QALAM_MEMORY_BUFFER, total * sizeof(size_t));
+    LineMeta* merged_meta = (LineMeta*)qalam_mem_alloc(QALAM_MEMORY_BUFFER,
+                                                       total * sizeof(LineMeta));
+    uint32_t* merged_gens = (uint32_t*)qalam_mem_alloc(QALAM_MEMORY_BUFFER,
+                                                       total * sizeof(uint32_t));
+    LineChunk** reuse = (LineChunk**)qalam_mem_alloc(QALAM_MEMORY_BUFFER,
+                                                     (span + extra) * sizeof(LineChunk*));
+    if (!merged || !merged_meta || !merged_gens || !reuse) {
+        qalam_mem_free(merged);
+        qalam_mem_free(merged_meta);
+        qalam_mem_free(merged_gens);
+        qalam_mem_free(reuse);
+        return QALAM_ERROR_OUT_OF_MEMORY;
+    }
+
+    /* Allocate any additional chunks before touching the index */
+    for (size_t k = 0; k < extra; k++) {
+        reuse[span + k] = index_chunk_create();
+        if (!reuse[span + k]) {
+            for (size_t j = 0; j < k; j++) {
+                qalam_mem_free(reuse[span + j]);
+            }
+            qalam_mem_free(merged);
+            qalam_mem_free(merged_meta);
+            qalam_mem_free(merged_gens);
+            qalam_mem_free(reuse);
+            return QALAM_ERROR_OUT_OF_MEMORY;
+        }
+    }
+
+    memcpy(merged, head->lens, pos * sizeof(size_t));
+    memcpy(merged + pos, new_lens, new_count * sizeof(size_t));
+    memcpy(merged + pos + new_count, &last->lens[end], tail * sizeof(size_t));
+    memcpy(merged_meta, head->meta, pos * sizeof(LineMeta));
+    memset(merged_meta + pos, 0, new_count * sizeof(LineMeta));
+    memcpy(merged_meta + pos + new_count, &last->meta[end], tail * sizeof(LineMeta));
+    memcpy(merged_gens, head->gens, pos * sizeof(uint32_t));
+    memset(merged_gens + pos, 0, new_count * sizeof(uint32_t));
+    memcpy(merged_gens + pos + new_count, &last->gens[end], tail * sizeof(uint32_t));
+
+    memcpy(reuse, &index->chunks[ci], span * sizeof(LineChunk*));
+    memmove(&index->chunks[ci + needed], &index->chunks[cj + 1],
+            (index->chunk_count - cj - 1) * sizeof(LineChunk*));
+
+    /* Distribute the merged lengths evenly over the new chunks */
+    size_t per_chunk = (total + needed - 1) / needed;
+    size_t src = 0;
+    for (size_t k = 0; k < needed; k++) {
+        LineChunk* chunk = reuse[k];
+        size_t n = total - src < per_chunk ? total - src : per_chunk;
+
+        memcpy(chunk->lens, merged + src, n * sizeof(size_t));
+        memcpy(chunk->meta, merged_meta + src, n * sizeof(LineMeta));
+        memcpy(chunk->gens, merged_gens + src, n * sizeof(uint32_t));
+        chunk->count = n;
+        chunk->chars = 0;
+        for (size_t i = 0; i < n; i++) {
+            chunk->chars += chunk->lens[i];
+        }
+
+        index->chunks[ci + k] = chunk;
+        src += n;
+    }
+
+    for (size_t k = needed; k < span; k++) {
+        qalam_mem_free(reuse[k]);
+    }
+
+    index->chunk_count = index->chunk_count - span + needed;
+    index_rebuild_trees(index);
+
+    qalam_mem_free(merged);
+    qalam_mem_free(merged_meta);
+    qalam_mem_free(merged_gens);
+    qalam_mem_free(reuse);
+    return QALAM_OK;
+}
+
+/*=============================================================================
+ * Lifecycle
+ *============================================================================*/
+
+QalamResult line_index_init(LineIndex* index) {
+    if (!index) {
+        return QALAM_ERROR_NULL_POINTER;
+    }
+
+    memset(index, 0, sizeof(LineIndex));
+
+    QalamResult result = index_reserve_chunks(index, 1);
+    if (result != QALAM_OK) {
+        line_index_free(index);
+        return result;
+    }
+
+    LineChunk* chunk = index_chunk_create();
+    if (!chunk) {
+        line_index_free(index);
+        return QALAM_ERROR_OUT_OF_MEMORY;
+    }
+
+    /* An empty document has one empty line */
+    chunk->count = 1;
+    chunk->lens[0] = 0;
+    chunk->meta[0] = 0;
+    chunk->gens[0] = 0;
+
+    index->chunks[0] = chunk;
+    index->chunk_count = 1;
+    index_rebuild_trees(index);
+
+    return QALAM_OK;
+}
+
+void line_index_free(LineIndex* index) {
+    if (!index) {
+        return;
+    }
+
+    for (size_t i = 0; i < index->chunk_count; i++) {
+        qalam_mem_free(index->chunks[i]);
+    }
+    qalam_mem_free(index->chunks);
+    qalam_mem_free(index->tree_lines);
+    qalam_mem_free(index->tree_chars);
+
+    memset(index, 0, sizeof(LineIndex));
+}
+
+/**
+ * @brief Close the document's last line with 'run' more characters
+ *
+ * 'run' includes the terminating newline. A new empty last line is
+ * opened after it, in a fresh chunk once the tail chunk is full. The
+ * trees are left for the caller to rebuild.
+ */
+static QalamResult index_close_last_line(LineIndex* index, LineChunk** tail, size_t run) {
+    (*tail)->lens[(*tail)->count - 1] += run;
+    (*tail)->meta[(*tail)->count - 1] = 0;
+    (*tail)->gens[(*tail)->count - 1] = 0;
+    (*tail)->chars += run;
+
+    if ((*tail)->count >= LINE_INDEX_CHUNK_FILL) {
+        QalamResult result = index_reserve_chunks(index, index->chunk_count + 1);
+        LineChunk* chunk = (result == QALAM_OK) ? index_chunk_create() : NULL;
+        if (!chunk) {
+            return QALAM_ERROR_OUT_OF_MEMORY;
+        }
+        index->chunks[index->chunk_count++] = chunk;
+        *tail = chunk;
+    }
+
+    (*tail)->lens[(*tail)->count] = 0;
+    (*tail)->meta[(*tail)->count] = 0;
+    (*tail)->gens[(*tail)->count] = 0;
+    (*tail)->count++;
+    return QALAM_OK;
+}
+
+QalamResult line_index_append(LineIndex* index, const wchar_t* text, size_t length) {
+    if (!index || (!text && length > 0)) {
+        return QALAM_ERROR_NULL_POINTER;
+    }
+
+    LineChunk* tail = index->chunks[index->chunk_count - 1];
+
+    for (;;) {
+        size_t run = text_find_newline(text, length);
+        if (run == length) {
+            break;
+        }
+        run++;
+
+        /* Close the current last line and open a new empty one */
+        if (index_close_last_line(index, &tail, run) != QALAM_OK) {
+            index_rebuild_trees(index);
+            return QALAM_ERROR_OUT_OF_MEMORY;
+        }
+        text += run;
+        length -= run;
+    }
+
+    tail->lens[tail->count - 1] += length;
+    tail->meta[tail->count - 1] = 0;
+    tail->gens[tail->count - 1] = 0;
+    tail->chars += length;
+
+    index_rebuild_trees(index);
+    return QALAM_OK;
+}
+
+QalamResult line_index_append_lengths(LineIndex* index, const size_t* line_lengths,
+                                      size_t count, size_t tail_length) {
+    if (!index || (!line_lengths && count > 0)) {
+        return QALAM_ERROR_NULL_POINTER;
+    }
+
+    LineChunk* tail = index->chunks[index->chunk_count - 1];
+
+    for (size_t i = 0; i < count; i++) {
+        if (index_close_last_line(index, &tail, line_lengths[i]) != QALAM_OK) {
+            index_rebuild_trees(index);
+            return QALAM_ERROR_OUT_OF_MEMORY;
+        }
+    }
+
+    tail->lens[tail->count - 1] += tail_length;
+    tail->meta[tail->count - 1] = 0;
+    tail->gens[tail->count - 1] = 0;
+    tail->chars += tail_length;
+
+    index_rebuild_trees(index);
+    return QALAM_OK;
+}
+
+QalamResult line_index_measure(const wchar_t* text, size_t length, size_t** out_lengths,
+                               size_t* out_count, size_t* out_tail) {
+    if ((!text && length > 0) || !out_lengths || !out_count || !out_tail) {
+        return QALAM_ERROR_NULL_POINTER;
+    }
+
+    size_t newlines = text_count_newlines(text, length);
+    size_t* lengths = NULL;
+    if (newlines > 0) {
+        lengths = (size_t*)qalam_mem_alloc(QALAM_MEMORY_BUFFER, newlines * sizeof(size_t));
+        if (!lengths) {
+            return QALAM_ERROR_OUT_OF_MEMORY;
+        }
+    }
+
+    for (size_t line = 0; line < newlines; line++) {
+        size_t run = text_find_newline(text, length) + 1;
+        lengths[line] = run;
+        text += run;
+        length -= run;
+    }
+
+    *out_lengths = lengths;
+    *out_count = newlines;
+    *out_tail = length;
+    return QALAM_OK;
+}
+
+/*=============================================================================
+ * Queries
+ *============================================================================*/
+
+size_t line_index_line_count(const LineIndex* index) {
+    return index->line_count;
+}
+
+size_t line_index_line_start(const LineIndex* index, size_t line) {
+    size_t ci, pos;
+    index_locate_line(index, line, &ci, &pos);
+
+    const LineChunk* chunk = index->chunks[ci];
+    size_t start = index_tree_prefix(index->tree_chars, ci);
+    for (size_t i = 0; i < pos; i++) {
+        start += chunk->lens[i];
+    }
+
+    return start;
+}
+
+size_t line_index_line_length(const LineIndex* index, size_t line) {
+    if (line >= index->line_count) {
+        line = index->line_count - 1;
+    }
+
+    size_t ci, pos;
+    index_locate_line(index, line, &ci, &pos);
+
+    size_t len = index->chunks[ci]->lens[pos];
+    if (line + 1 < index->line_count) {
+        len--; /* Exclude the trailing newline */
+    }
+
+    return len;
+}
+
+size_t line_index_line_from_offset(const LineIndex* index, size_t offset, size_t* line_start) {
+    size_t ci, pos, start;
+    size_t line = index_locate_offset(index, offset, &ci, &pos, &start);
+
+    if (line_start) {
+        *line_start = start;
+    }
+
+    return line;
+}
+
+void line_index_copy_lengths(const LineIndex* index, size_t first, size_t count, size_t* out_lens) {
+    if (count == 0) {
+        return;
+    }
+
+    size_t ci, pos;
+    index_locate_line(index, first, &ci, &pos);
+
+    while (count > 0) {
+        const LineChunk* chunk = index->chunks[ci++];
+        size_t n = chunk->count - pos < count ? chunk->count - pos : count;
+        memcpy(out_lens, &chunk->lens[pos], n * sizeof(size_t));
+        out_lens += n;
+        count -= n;
+        pos = 0;
+    }
+}
+
+LineMeta line_index_get_meta(const LineIndex* index, size_t line) {
+    size_t ci, pos;
+    index_locate_line(index, line, &ci, &pos);
+    return index->chunks[ci]->meta[pos];
+}
+
+void line_index_set_meta(LineIndex* index, size_t line, LineMeta meta) {
+    size_t ci, pos;
+    index_locate_line(index, line, &ci, &pos);
+    index->chunks[ci]->meta[pos] = meta;
+}
+
+uint32_t line_index_get_generation(LineIndex* index, size_t line) {
+    size_t ci, pos;
+    index_locate_line(index, line, &ci, &pos);
+
+    /* Hand out a fresh generation the first time a changed line is asked for */
+    uint32_t* generation = &index->chunks[ci]->gens[pos];
+    while (*generation == 0) {
+        *generation = (uint32_t)InterlockedIncrement(&g_line_generation);
+    }
+    return *generation;
+}
+
+/*=============================================================================
+ * Updates
+ *============================================================================*/
+
+QalamResult line_index_insert(LineIndex* index, size_t offset, const wchar_t* text, size_t length) {
+    if (!index || (!text && length > 0)) {
+        return QALAM_ERROR_NULL_POINTER;
+    }
+
+    if (length == 0) {
+        return QALAM_OK;
+    }
+
+    if (offset > index->char_count) {
+        offset = index->char_count;
+    }
+
+    size_t ci, pos, start;
+    size_t line = index_locate_offset(index, offset, &ci, &pos, &start);
+
+    size_t newlines = text_count_newlines(text, length);
+
+    /* Common case: the edit stays on one line */
+    if (newlines == 0) {
+        index->chunks[ci]->lens[pos] += length;
+        index->chunks[ci]->meta[pos] = 0;
+        index->chunks[ci]->gens[pos] = 0;
+        index->chunks[ci]->chars += length;
+        index_tree_add(index->tree_chars, index->chunk_count, ci, length);
+        index->char_count += length;
+        return QALAM_OK;
+    }
+
+    size_t stack_lens[LINE_INDEX_STACK_LINES];
+    size_t* new_lens = stack_lens;
+    if (newlines + 1 > LINE_INDEX_STACK_LINES) {
+        new_lens = (size_t*)qalam_mem_alloc(QALAM_MEMORY_BUFFER, (newlines + 1) * sizeof(size_t));
+        if (!new_lens) {
+            return QALAM_ERROR_OUT_OF_MEMORY;
+        }
+    }
+
+    /* Split the target line at the insertion point */
+    size_t column = offset - start;
+    size_t old_len = index->chunks[ci]->lens[pos];
+    size_t n = 0;
+    size_t run = column;
+
+    while (n < newlines) {
+        size_t span = text_find_newline(text, length) + 1;
+        new_lens[n++] = run + span;
+        run = 0;
+        text += span;
+        length -= span;
+    }
+    new_lens[n++] = run + length + (old_len - column);
+
+    QalamResult result = index_splice(index, line, 1, new_lens, n);
+
+    if (new_lens != stack_lens) {
+        qalam_mem_free(new_lens);
+    }
+
+    return result;
+}
+
+QalamResult line_index_delete(LineIndex* index, size_t offset, size_t length) {
+    if (!index) {
+        return QALAM_ERROR_NULL_POINTER;
+    }
+
+    if (length == 0 || offset >= index->char_count) {
+        return QALAM_OK;
+    }
+
+    if (length > index->char_count - offset) {
+        length = index->char_count - offset;
+    }
+
+    size_t ci, pos, start;
+    size_t first = index_locate_offset(index, offset, &ci, &pos, &start);
+    size_t end = offset + length;
+
+    /* Deletion inside a single line (no newline removed) */
+    if (end - start < index->chunks[ci]->lens[pos] ||
+        (first + 1 == index->line_count)) {
+        index->chunks[ci]->lens[pos] -= length;
+        index->chunks[ci]->meta[pos] = 0;
+        index->chunks[ci]->gens[pos] = 0;
+        index->chunks[ci]->chars -= length;
+        index_tree_add(index->tree_chars, index->chunk_count, ci, (size_t)0 - length);
+        index->char_count -= length;
+        return QALAM_OK;
+    }
+
+    size_t cj, pos_j, start_j;
+    size_t last = index_locate_offset(index, end, &cj, &pos_j, &start_j);
+    size_t last_len = index->chunks[cj]->lens[pos_j];
+
+    /* Merge what remains of the first and last lines */
+    size_t merged = (offset - start) + (start_j + last_len - end);
+
+    return index_splice(index, first, last - first + 1, &merged, 1);
+}
+
+QalamResult line_index_replace_lines(LineIndex* index, size_t first, size_t count,
+                                     const size_t* new_lens, size_t new_count) {
+    if (!index || !new_lens) {
+        return QALAM_ERROR_NULL_POINTER;
+    }
+    if (count == 0 || new_count == 0 || first >= index->line_count ||
+        count > index->line_count - first) {
+        return QALAM_ERROR_INVALID_RANGE;
+    }
+
+    return index_splice(index, first, count, new_lens, new_count);
+}
@@ -0,0 +1,307 @@
+/**
+ * @file line_index.h
+ * @brief Qalam IDE - Line Start Index (Internal Header)
+ *
+ * Internal header for the line index used by the gap buffer. The index
+ * stores the length of every line (including its trailing newline) in
+ * fixed-size chunks, with Fenwick trees over the per-chunk line and
+ * character totals. This makes line <-> offset lookups O(log n) instead
+ * of a scan from offset 0. Each line also carries a small metadata word
+ * (UTF-8 length and direction flags) and a change generation, both of
+ * which edits reset and readers fill in lazily.
+ *
+ * @version 0.0.2
+ * @copyright (c) 2026 Qalam Project
+ *
+ * @note Thread Safety: Not thread-safe. Owned by a single QalamBuffer.
+ */
+
+#ifndef QALAM_LINE_INDEX_H
+#define QALAM_LINE_INDEX_H
+
+#include "qalam.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*=============================================================================
+ * Configuration Constants
+ *============================================================================*/
+
+/** Maximum number of lines stored in one chunk before it is split */
+#define LINE_INDEX_CHUNK_MAX    1024
+
+/** Number of lines placed in a chunk when (re)building chunks */
+#define LINE_INDEX_CHUNK_FILL   512
+
+/*=============================================================================
+ * Line Metadata
+ *============================================================================*/
+
+/**
+ * @brief Cached per-line facts, bit-packed
+ *
+ * Bits 0-2 are flags; the remaining bits hold the UTF-8 length of the
+ * line (excluding its newline). A value without LINE_META_VALID (such
+ * as 0, set on every line an edit touches) must be recomputed.
+ */
+typedef uint32_t LineMeta;
+
+/** The cached fields are up to date */
+#define LINE_META_VALID         0x1u
+
+/** Line contains RTL (Arabic/Hebrew) characters */
+#define LINE_META_RTL           0x2u
+
+/** Line contains Latin letters */
+#define LINE_META_LTR           0x4u
+
+/** Position of the UTF-8 length field */
+#define LINE_META_BYTES_SHIFT   3
+
+/** Longest UTF-8 length that can be cached; longer lines stay uncached */
+#define LINE_META_MAX_BYTES     (UINT32_MAX >> LINE_META_BYTES_SHIFT)
+
+/*=============================================================================
+ * Line Index Structures
+ *============================================================================*/
+
+/**
+ * @brief A run of consecutive line lengths
+ *
+ * Each entry is the length of one line in wchar_t units, including the
+ * trailing L'\n' (the last line of the document has no newline). meta
+ * and gens run parallel to lens.
+ */
+typedef struct LineChunk {
+    size_t count;                           /**< Lines stored in this chunk */
+    size_t chars;                           /**< Sum of lens[0..count) */
+    size_t lens[LINE_INDEX_CHUNK_MAX];      /**< Per-line lengths */
+    LineMeta meta[LINE_INDEX_CHUNK_MAX];    /**< Per-line cached metadata */
+    uint32_t gens[LINE_INDEX_CHUNK_MAX];    /**< Per-line generations (0 = not assigned) */
+} LineChunk;
+
+/**
+ * @brief Line start index
+ *
+ * Chunks are kept in document order. tree_lines and tree_chars are
+ * 1-based Fenwick trees over chunk->count and chunk->chars, so the
+ * chunk containing a given line or offset is found in O(log chunks).
+ */
+typedef struct LineIndex {
+    LineChunk** chunks;         /**< Chunk array in document order */
+    size_t chunk_count;         /**< Number of chunks in use */
+    size_t chunk_capacity;      /**< Allocated chunk slots */
+    size_t* tree_lines;         /**< Fenwick tree of line counts */
+    size_t* tree_chars;         /**< Fenwick tree of character counts */
+    size_t line_count;          /**< Total number of lines (at least 1) */
+    size_t char_count;          /**< Total number of characters */
+} LineIndex;
+
+/*=============================================================================
+ * Lifecycle
+ *============================================================================*/
+
+/**
+ * @brief Initialize an index describing an empty document (one empty line)
+ *
+ * @param index Index to initialize
+ * @return QALAM_OK on success, QALAM_ERROR_OUT_OF_MEMORY on failure
+ */
+QalamResult line_index_init(LineIndex* index);
+
+/**
+ * @brief Release all memory owned by the index
+ *
+ * @param index Index to free (may be NULL)
+ */
+void line_index_free(LineIndex* index);
+
+/**
+ * @brief Append text to the end of the indexed document
+ *
+ * Used when building the index for freshly loaded content. Can be
+ * called repeatedly with consecutive segments.
+ *
+ * @param index Target index
+ * @param text UTF-16 text being appended
+ * @param length Length of text in wchar_t units
+ * @return QALAM_OK on success, error code on failure
+ */
+QalamResult line_index_append(LineIndex* index, const wchar_t* text, size_t length);
+
+/**
+ * @brief Append pre-measured lines to the end of the indexed document
+ *
+ * Equivalent to line_index_append() on text whose newline-terminated
+ * runs have the given lengths (each including its L'\n'), followed by
+ * 'tail_length' characters without a newline. Used when lines were
+ * measured elsewhere, e.g. by a background indexer.
+ *
+ * @param index Target index
+ * @param line_lengths Lengths of the newline-terminated runs
+ * @param count Number of entries in line_lengths
+ * @param tail_length Characters after the last newline
+ * @return QALAM_OK on success, error code on failure
+ */
+QalamResult line_index_append_lengths(LineIndex* index, const size_t* line_lengths,
+                                      size_t count, size_t tail_length);
+
+/**
+ * @brief Measure text for a later line_index_append_lengths()
+ *
+ * Touches no index, so separate spans can be measured on separate
+ * threads and appended in order: a line split between two spans is
+ * joined by the append.
+ *
+ * @param text UTF-16 text
+ * @param length Length of text in wchar_t units
+ * @param[out] out_lengths Receives the malloc'd run lengths (NULL if none)
+ * @param[out] out_count Receives the number of newline-terminated runs
+ * @param[out] out_tail Receives the characters after the last newline
+ * @return QALAM_OK on success, QALAM_ERROR_OUT_OF_MEMORY on failure
+ */
+QalamResult line_index_measure(const wchar_t* text, size_t length, size_t** out_lengths,
+                               size_t* out_count, size_t* out_tail);
+
+/*=============================================================================
+ * Queries
+ *============================================================================*/
+
+/**
+ * @brief Get the total number of lines (always at least 1)
+ */
+size_t line_index_line_count(const LineIndex* index);
+
+/**
+ * @brief Get the offset of the first character of a line
+ *
+ * @param index Source index
+ * @param line Line number (0-based, clamped to the last line)
+ * @return Offset in wchar_t units
+ */
+size_t line_index_line_start(const LineIndex* index, size_t line);
+
+/**
+ * @brief Get the length of a line excluding its trailing newline
+ *
+ * @param index Source index
+ * @param line Line number (0-based, clamped to the last line)
+ * @return Length in wchar_t units
+ */
+size_t line_index_line_length(const LineIndex* index, size_t line);
+
+/**
+ * @brief Get the line containing an offset
+ *
+ * An offset directly after a newline belongs to the following line.
+ * Offsets past the end of the document map to the last line.
+ *
+ * @param index Source index
+ * @param offset Offset in wchar_t units
+ * @param[out] line_start Receives the start offset of that line (optional)
+ * @return Line number (0-based)
+ */
+size_t line_index_line_from_offset(const LineIndex* index, size_t offset, size_t* line_start);
+
+/**
+ * @brief Copy the stored lengths of a run of lines
+ *
+ * Unlike line_index_line_length(), each length includes the line's
+ * trailing newline, so the values can be passed back to
+ * line_index_replace_lines().
+ *
+ * @param index Source index
+ * @param first First line to copy
+ * @param count Number of lines (first + count <= line count)
+ * @param[out] out_lens Receives 'count' lengths
+ */
+void line_index_copy_lengths(const LineIndex* index, size_t first, size_t count, size_t* out_lens);
+
+/**
+ * @brief Get the cached metadata of a line
+ *
+ * @param index Source index
+ * @param line Line number (0-based, clamped to the last line)
+ * @return Cached value; check LINE_META_VALID before using it
+ */
+LineMeta line_index_get_meta(const LineIndex* index, size_t line);
+
+/**
+ * @brief Store freshly computed metadata for a line
+ *
+ * @param index Target index
+ * @param line Line number (0-based, clamped to the last line)
+ * @param meta Value to cache (normally with LINE_META_VALID set)
+ */
+void line_index_set_meta(LineIndex* index, size_t line, LineMeta meta);
+
+/**
+ * @brief Get the change generation of a line
+ *
+ * A line keeps its generation until an edit touches it; the next call
+ * then hands out a new one. Generations are never 0 and come from one
+ * counter shared by all indexes, so they are unique across buffers
+ * (until the 32-bit counter wraps).
+ *
+ * @param index Source index (the line's slot is filled on first use)
+ * @param line Line number (0-based, clamped to the last line)
+ * @return Generation of the line's current text
+ */
+uint32_t line_index_get_generation(LineIndex* index, size_t line);
+
+/*=============================================================================
+ * Updates
+ *============================================================================*/
+
+/**
+ * @brief Record an insertion of text at an offset
+ *
+ * The metadata of every line the insertion touches is reset.
+ *
+ * @param index Target index
+ * @param offset Insertion offset in wchar_t units
+ * @param text Inserted UTF-16 text
+ * @param length Length of text in wchar_t units
+ * @return QALAM_OK on success, error code on failure
+ */
+QalamResult line_index_insert(LineIndex* index, size_t offset, const wchar_t* text, size_t length);
+
+/**
+ * @brief Record a deletion of a range
+ *
+ * The metadata of the line left at the deletion point is reset.
+ *
+ * The deleted text is not needed: the lines it spans are found through
+ * the index itself.
+ *
+ * @param index Target index
+ * @param offset Start offset of the deleted range
+ * @param length Number of wchar_t units deleted
+ * @return QALAM_OK on success, error code on failure
+ */
+QalamResult line_index_delete(LineIndex* index, size_t offset, size_t length);
+
+/**
+ * @brief Replace a run of lines with lines of the given lengths
+ *
+ * Lets a caller that already knows the new line structure of a region
+ * (such as a batch of edits) update the index in one step. Lengths
+ * include trailing newlines; the metadata of every new line is reset.
+ *
+ * @param index Target index
+ * @param first First line replaced
+ * @param count Number of lines replaced (>= 1)
+ * @param new_lens Lengths of the replacement lines
+ * @param new_count Number of replacement lines (>= 1)
+ * @return QALAM_OK on success, error code on failure
+ */
+QalamResult line_index_replace_lines(LineIndex* index, size_t first, size_t count,
+                                     const size_t* new_lens, size_t new_count);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* QALAM_LINE_INDEX_H */
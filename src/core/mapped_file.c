@@ -0,0 +1,473 @@
+/**
+ * @file mapped_file.c
+ * @brief Qalam IDE - Memory-Mapped Lazy File Source Implementation
+ *
+ * The indexer walks the mapping one chunk at a time, decoding into a
+ * private scratch buffer only to measure the chunk, and publishes
+ * results by bumping an interlocked counter after the slot is filled.
+ * The owner absorbs published slots in order; from then on the chunk's
+ * text offsets are known and its text can be decoded on demand. At
+ * most MAPPED_FILE_CACHE_CHUNKS decoded chunks are kept, evicting the
+ * least recently used one.
+ *
+ * @version 0.0.2
+ * @copyright (c) 2026 Qalam Project
+ *
+ * @note Thread Safety: See mapped_file.h.
+ */
+
+#include "mapped_file.h"
+#include "line_index.h"
+#include <stdlib.h>
+#include <string.h>
+#include <wchar.h>
+
+/*=============================================================================
+ * Internal Structures
+ *============================================================================*/
+
+/**
+ * @brief An absorbed chunk, owned by the buffer's thread
+ */
+typedef struct MappedChunk {
+    size_t byte_start;              /**< Offset of the chunk in the file */
+    size_t byte_length;             /**< Chunk size in bytes */
+    size_t text_start;              /**< Offset of the chunk's text in wchar_t units */
+    size_t text_length;             /**< Decoded length in wchar_t units */
+    wchar_t* text;                  /**< Decoded text, or NULL if not cached */
+    uint64_t last_use;              /**< Cache clock of the last access */
+} MappedChunk;
+
+/**
+ * @brief Memory-mapped file state
+ */
+struct MappedFile {
+    HANDLE file;                    /**< File handle */
+    HANDLE mapping;                 /**< File mapping handle */
+    const char* bytes;              /**< Mapped view (NULL for empty files) */
+    size_t size;                    /**< File size in bytes */
+    wchar_t path[MAX_PATH];         /**< Path the file was opened from */
+
+    /* Indexer output: slots [0, published) are complete */
+    MappedChunkLines* results;      /**< Result slots, one per chunk */
+    size_t result_capacity;         /**< Allocated result slots */
+    volatile LONG published;        /**< Number of published slots */
+    volatile LONG finished;         /**< Set once the indexer has stopped */
+    volatile LONG cancel;           /**< Set to ask the indexer to stop */
+    QalamResult indexer_error;      /**< Why the indexer stopped (valid once finished) */
+    size_t indexer_start;           /**< Byte offset the indexer starts from */
+    HANDLE thread;                  /**< Indexer thread, or NULL */
+
+    /* Owner state */
+    MappedChunk* chunks;            /**< Absorbed chunks in file order */
+    size_t chunk_count;             /**< Number of absorbed chunks */
+    size_t text_length;             /**< Total absorbed text in wchar_t units */
+    size_t bytes_absorbed;          /**< Total absorbed bytes */
+    size_t last_chunk;              /**< Chunk of the most recent lookup */
+    size_t cache[MAPPED_FILE_CACHE_CHUNKS]; /**< Indices of decoded chunks */
+    size_t cache_count;             /**< Entries in cache */
+    uint64_t use_clock;             /**< Cache access counter */
+};
+
+/*=============================================================================
+ * Internal Helper Functions - Indexing
+ *============================================================================*/
+
+/**
+ * @brief Measure the chunk starting at byte 'start'
+ *
+ * The chunk ends before a UTF-8 lead byte so it decodes on its own.
+ *
+ * @param scratch Decode buffer with room for MAPPED_FILE_CHUNK_SIZE wchar_t
+ */
+static QalamResult mapped_measure_chunk(const char* bytes, size_t size, size_t start,
+                                        wchar_t* scratch, MappedChunkLines* out) {
+    size_t end = size - start > MAPPED_FILE_CHUNK_SIZE ? start + MAPPED_FILE_CHUNK_SIZE : size;
+
+    /* If the next chunk would start on a continuation byte, back up to its lead byte */
+    if (end < size) {
+        size_t back = end;
+        while (back > start && end - back < 3 && ((unsigned char)bytes[back] & 0xC0) == 0x80) {
+            back--;
+        }
+        if (((unsigned char)bytes[back] & 0xC0) != 0x80 && back > start) {
+            end = back;
+        }
+    }
+
+    int decoded = MultiByteToWideChar(CP_UTF8, 0, bytes + start, (int)(end - start),
+                                      scratch, MAPPED_FILE_CHUNK_SIZE);
+    if (decoded <= 0) {
+        return QALAM_ERROR_ENCODING;
+    }
+
+    size_t* lengths;
+    size_t count;
+    size_t tail;
+    QalamResult result = line_index_measure(scratch, (size_t)decoded, &lengths, &count, &tail);
+    if (result != QALAM_OK) {
+        return result;
+    }
+
+    out->byte_start = start;
+    out->byte_length = end - start;
+    out->text_length = (size_t)decoded;
+    out->line_lengths = lengths;
+    out->line_count = count;
+    out->tail_length = tail;
+
+    return QALAM_OK;
+}
+
+/**
+ * @brief Indexer thread: measure and publish the remaining chunks
+ */
+static DWORD WINAPI mapped_indexer_thread(LPVOID param) {
+    MappedFile* file = (MappedFile*)param;
+    QalamResult result = QALAM_OK;
+
+    wchar_t* scratch = (wchar_t*)qalam_mem_alloc(QALAM_MEMORY_BUFFER,
+                                                 MAPPED_FILE_CHUNK_SIZE * sizeof(wchar_t));
+    if (!scratch) {
+        result = QALAM_ERROR_OUT_OF_MEMORY;
+    }
+
+    size_t slot = (size_t)InterlockedCompareExchange(&file->published, 0, 0);
+    size_t pos = file->indexer_start;
+
+    while (result == QALAM_OK && pos < file->size && slot < file->result_capacity &&
+           !InterlockedCompareExchange(&file->cancel, 0, 0)) {
+        result = mapped_measure_chunk(file->bytes, file->size, pos, scratch, &file->results[slot]);
+        if (result == QALAM_OK) {
+            pos += file->results[slot].byte_length;
+            slot++;
+            InterlockedExchange(&file->published, (LONG)slot);
+        }
+    }
+
+    qalam_mem_free(scratch);
+    file->indexer_error = result;
+    InterlockedExchange(&file->finished, 1);
+    return 0;
+}
+
+/*=============================================================================
+ * Internal Helper Functions - Decoded Text Cache
+ *============================================================================*/
+
+/**
+ * @brief Find the absorbed chunk containing a text offset
+ */
+static size_t mapped_find_chunk(MappedFile* file, size_t pos) {
+    MappedChunk* last = &file->chunks[file->last_chunk];
+    if (pos >= last->text_start && pos < last->text_start + last->text_length) {
+        return file->last_chunk;
+    }
+
+    size_t lo = 0;
+    size_t hi = file->chunk_count - 1;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo + 1) / 2;
+        if (file->chunks[mid].text_start <= pos) {
+            lo = mid;
+        } else {
+            hi = mid - 1;
+        }
+    }
+    return lo;
+}
+
+/**
+ * @brief Decode a chunk into the cache, evicting the least recently used
+ */
+static QalamResult mapped_decode_chunk(MappedFile* file, size_t index) {
+    MappedChunk* chunk = &file->chunks[index];
+
+    wchar_t* text = (wchar_t*)qalam_mem_alloc(QALAM_MEMORY_BUFFER,
+                                              chunk->text_length * sizeof(wchar_t));
+    if (!text) {
+        return QALAM_ERROR_OUT_OF_MEMORY;
+    }
+    MultiByteToWideChar(CP_UTF8, 0, file->bytes + chunk->byte_start, (int)chunk->byte_length,
+                        text, (int)chunk->text_length);
+
+    if (file->cache_count == MAPPED_FILE_CACHE_CHUNKS) {
+        size_t victim = 0;
+        for (size_t i = 1; i < file->cache_count; i++) {
+            if (file->chunks[file->cache[i]].last_use < file->chunks[file->cache[victim]].last_use) {
+                victim = i;
+            }
+        }
+        MappedChunk* evicted = &file->chunks[file->cache[victim]];
+        qalam_mem_free(evicted->text);
+        evicted->text = NULL;
+        file->cache[victim] = index;
+    } else {
+        file->cache[file->cache_count++] = index;
+    }
+
+    chunk->text = text;
+    return QALAM_OK;
+}
+
+/*=============================================================================
+ * Lifecycle
+ *============================================================================*/
+
+QalamResult mapped_file_open(MappedFile** file, const wchar_t* filepath) {
+    if (!file || !filepath) {
+        return QALAM_ERROR_NULL_POINTER;
+    }
+
+    MappedFile* mf = (MappedFile*)qalam_mem_calloc(QALAM_MEMORY_BUFFER, 1, sizeof(MappedFile));
+    if (!mf) {
+        return QALAM_ERROR_OUT_OF_MEMORY;
+    }
+    wcsncpy(mf->path, filepath, MAX_PATH - 1);
+    mf->path[MAX_PATH - 1] = L'\0';
+
+    mf->file = CreateFileW(filepath, GENERIC_READ, FILE_SHARE_READ, NULL,
+                           OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (mf->file == INVALID_HANDLE_VALUE) {
+        qalam_mem_free(mf);
+        return QALAM_ERROR_FILE_NOT_FOUND;
+    }
+
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(mf->file, &fileSize)) {
+        mapped_file_close(mf);
+        return QALAM_ERROR_FILE_READ;
+    }
+    if ((unsigned long long)fileSize.QuadPart > SIZE_MAX / sizeof(wchar_t)) {
+        mapped_file_close(mf);
+        return QALAM_ERROR_OUT_OF_MEMORY;
+    }
+    mf->size = (size_t)fileSize.QuadPart;
+    mf->finished = 1;
+
+    /* Empty files cannot be mapped; they are simply complete */
+    if (mf->size == 0) {
+        *file = mf;
+        return QALAM_OK;
+    }
+
+    mf->mapping = CreateFileMappingW(mf->file, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (!mf->mapping) {
+        mapped_file_close(mf);
+        return QALAM_ERROR_FILE_READ;
+    }
+    mf->bytes = (const char*)MapViewOfFile(mf->mapping, FILE_MAP_READ, 0, 0, 0);
+    if (!mf->bytes) {
+        mapped_file_close(mf);
+        return QALAM_ERROR_FILE_READ;
+    }
+
+    /* Every chunk but the last is at least CHUNK_SIZE - 3 bytes */
+    mf->result_capacity = mf->size / (MAPPED_FILE_CHUNK_SIZE - 3) + 1;
+    mf->results = (MappedChunkLines*)qalam_mem_calloc(QALAM_MEMORY_BUFFER, mf->result_capacity,
+                                                      sizeof(MappedChunkLines));
+    mf->chunks = (MappedChunk*)qalam_mem_calloc(QALAM_MEMORY_BUFFER,
+                                                mf->result_capacity, sizeof(MappedChunk));
+    wchar_t* scratch = (wchar_t*)qalam_mem_alloc(QALAM_MEMORY_BUFFER,
+                                                 MAPPED_FILE_CHUNK_SIZE * sizeof(wchar_t));
+    if (!mf->results || !mf->chunks || !scratch) {
+        qalam_mem_free(scratch);
+        mapped_file_close(mf);
+        return QALAM_ERROR_OUT_OF_MEMORY;
+    }
+
+    /* Measure the first chunk now so the first screen is available at once */
+    QalamResult result = mapped_measure_chunk(mf->bytes, mf->size, 0, scratch, &mf->results[0]);
+    qalam_mem_free(scratch);
+    if (result != QALAM_OK) {
+        mapped_file_close(mf);
+        return result;
+    }
+    mf->published = 1;
+    mf->indexer_start = mf->results[0].byte_length;
+
+    if (mf->indexer_start < mf->size) {
+        mf->finished = 0;
+        mf->thread = CreateThread(NULL, 0, mapped_indexer_thread, mf, 0, NULL);
+        if (!mf->thread) {
+            mf->finished = 1;
+            mapped_file_close(mf);
+            return QALAM_ERROR_OUT_OF_MEMORY;
+        }
+    }
+
+    *file = mf;
+    return QALAM_OK;
+}
+
+void mapped_file_close(MappedFile* file) {
+    if (!file) {
+        return;
+    }
+
+    if (file->thread) {
+        InterlockedExchange(&file->cancel, 1);
+        WaitForSingleObject(file->thread, INFINITE);
+        CloseHandle(file->thread);
+    }
+
+    /* Published but never absorbed slots still own their line arrays */
+    for (size_t i = file->chunk_count; i < (size_t)file->published; i++) {
+        qalam_mem_free(file->results[i].line_lengths);
+    }
+    for (size_t i = 0; i < file->cache_count; i++) {
+        qalam_mem_free(file->chunks[file->cache[i]].text);
+    }
+    qalam_mem_free(file->results);
+    qalam_mem_free(file->chunks);
+
+    if (file->bytes) {
+        UnmapViewOfFile(file->bytes);
+    }
+    if (file->mapping) {
+        CloseHandle(file->mapping);
+    }
+    if (file->file != INVALID_HANDLE_VALUE && file->file) {
+        CloseHandle(file->file);
+    }
+
+    qalam_mem_free(file);
+}
+
+/*=============================================================================
+ * Indexing
+ *============================================================================*/
+
+const MappedChunkLines* mapped_file_peek(MappedFile* file) {
+    size_t published = (size_t)InterlockedCompareExchange(&file->published, 0, 0);
+    return file->chunk_count < published ? &file->results[file->chunk_count] : NULL;
+}
+
+void mapped_file_advance(MappedFile* file) {
+    MappedChunkLines* result = &file->results[file->chunk_count];
+    MappedChunk* chunk = &file->chunks[file->chunk_count];
+
+    chunk->byte_start = result->byte_start;
+    chunk->byte_length = result->byte_length;
+    chunk->text_start = file->text_length;
+    chunk->text_length = result->text_length;
+    chunk->text = NULL;
+    chunk->last_use = 0;
+
+    file->text_length += result->text_length;
+    file->bytes_absorbed += result->byte_length;
+    file->chunk_count++;
+
+    qalam_mem_free(result->line_lengths);
+    result->line_lengths = NULL;
+}
+
+bool mapped_file_is_complete(MappedFile* file) {
+    return file->bytes_absorbed == file->size;
+}
+
+QalamResult mapped_file_get_status(MappedFile* file) {
+    if (!InterlockedCompareExchange(&file->finished, 0, 0)) {
+        return QALAM_OK;
+    }
+    return file->indexer_error;
+}
+
+QalamResult mapped_file_wait(MappedFile* file) {
+    if (file->thread) {
+        WaitForSingleObject(file->thread, INFINITE);
+    }
+    return file->indexer_error;
+}
+
+void mapped_file_get_progress(MappedFile* file, size_t* bytes_indexed, size_t* bytes_total) {
+    if (bytes_indexed) {
+        *bytes_indexed = file->bytes_absorbed;
+    }
+    if (bytes_total) {
+        *bytes_total = file->size;
+    }
+}
+
+/*=============================================================================
+ * Text Access
+ *============================================================================*/
+
+const wchar_t* mapped_file_text(void* context, size_t pos, size_t* available) {
+    MappedFile* file = (MappedFile*)context;
+    if (pos >= file->text_length) {
+        return NULL;
+    }
+
+    size_t index = mapped_find_chunk(file, pos);
+    MappedChunk* chunk = &file->chunks[index];
+
+    if (!chunk->text && mapped_decode_chunk(file, index) != QALAM_OK) {
+        return NULL;
+    }
+
+    chunk->last_use = ++file->use_clock;
+    file->last_chunk = index;
+
+    size_t offset = pos - chunk->text_start;
+    *available = chunk->text_length - offset;
+    return chunk->text + offset;
+}
+
+void mapped_file_trim(MappedFile* file) {
+    if (!file) {
+        return;
+    }
+
+    for (size_t i = 0; i < file->cache_count; i++) {
+        MappedChunk* chunk = &file->chunks[file->cache[i]];
+        qalam_mem_free(chunk->text);
+        chunk->text = NULL;
+    }
+    file->cache_count = 0;
+}
+
+size_t mapped_file_cached_bytes(const MappedFile* file) {
+    if (!file) {
+        return 0;
+    }
+
+    size_t bytes = 0;
+    for (size_t i = 0; i < file->cache_count; i++) {
+        bytes += file->chunks[file->cache[i]].text_length * sizeof(wchar_t);
+    }
+    return bytes;
+}
+
+QalamResult mapped_file_materialize(MappedFile* file, wchar_t** out_text, size_t* out_length) {
+    *out_text = NULL;
+    *out_length = 0;
+
+    if (file->text_length == 0) {
+        return QALAM_OK;
+    }
+
+    wchar_t* text = (wchar_t*)qalam_mem_alloc(QALAM_MEMORY_BUFFER,
+                                              file->text_length * sizeof(wchar_t));
+    if (!text) {
+        return QALAM_ERROR_OUT_OF_MEMORY;
+    }
+
+    for (size_t i = 0; i < file->chunk_count; i++) {
+        MappedChunk* chunk = &file->chunks[i];
+        if (chunk->text) {
+            memcpy(text + chunk->text_start, chunk->text, chunk->text_length * sizeof(wchar_t));
+        } else {
+            MultiByteToWideChar(CP_UTF8, 0, file->bytes + chunk->byte_start, (int)chunk->byte_length,
+                                text + chunk->text_start, (int)chunk->text_length);
+        }
+    }
+
+    *out_text = text;
+    *out_length = file->text_length;
+    return QALAM_OK;
+}
+
+const wchar_t* mapped_file_path(const MappedFile* file) {
+    return file->path;
+}
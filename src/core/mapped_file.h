@@ -0,0 +1,181 @@
+/**
+ * @file mapped_file.h
+ * @brief Qalam IDE - Memory-Mapped Lazy File Source (Internal Header)
+ *
+ * Internal header for opening a UTF-8 file as a read-only memory mapping.
+ * The file is split into chunks that end on UTF-8 sequence boundaries.
+ * A background indexer measures each chunk (UTF-16 length and line
+ * lengths) and publishes the results in order; the owning buffer absorbs
+ * them into its line index and piece table. Chunk text is decoded to
+ * UTF-16 only when something reads it, and a bounded number of decoded
+ * chunks is cached.
+ *
+ * @version 0.0.2
+ * @copyright (c) 2026 Qalam Project
+ *
+ * @note Thread Safety: The indexer thread only reads the mapping and
+ *       fills result slots ahead of the published count. Every function
+ *       below must be called from the owning buffer's thread.
+ */
+
+#ifndef QALAM_MAPPED_FILE_H
+#define QALAM_MAPPED_FILE_H
+
+#include "qalam.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*=============================================================================
+ * Configuration Constants
+ *============================================================================*/
+
+/** Target chunk size in bytes of UTF-8 */
+#define MAPPED_FILE_CHUNK_SIZE      (64 * 1024)
+
+/** Maximum number of chunks kept decoded at once */
+#define MAPPED_FILE_CACHE_CHUNKS    64
+
+/*=============================================================================
+ * Mapped File Structures
+ *============================================================================*/
+
+/**
+ * @brief Measurements of one chunk, produced by the indexer
+ *
+ * line_lengths holds the newline-terminated runs of the chunk (each
+ * including its L'\n'); tail_length is the text after the last newline.
+ */
+typedef struct MappedChunkLines {
+    size_t byte_start;              /**< Offset of the chunk in the file */
+    size_t byte_length;             /**< Chunk size in bytes */
+    size_t text_length;             /**< Decoded length in wchar_t units */
+    size_t* line_lengths;           /**< Newline-terminated run lengths */
+    size_t line_count;              /**< Entries in line_lengths */
+    size_t tail_length;             /**< Characters after the last newline */
+} MappedChunkLines;
+
+/**
+ * @brief Opaque memory-mapped file source
+ */
+typedef struct MappedFile MappedFile;
+
+/*=============================================================================
+ * Lifecycle
+ *============================================================================*/
+
+/**
+ * @brief Map a file and start indexing it
+ *
+ * The first chunk is measured before returning, so its lines can be
+ * absorbed (and shown) immediately; the rest is measured on a
+ * background thread.
+ *
+ * @param[out] file Receives the mapped file
+ * @param filepath Path to the file
+ * @return QALAM_OK on success, error code on failure
+ */
+QalamResult mapped_file_open(MappedFile** file, const wchar_t* filepath);
+
+/**
+ * @brief Stop the indexer, unmap the file and free all memory
+ *
+ * @param file File to close (may be NULL)
+ */
+void mapped_file_close(MappedFile* file);
+
+/*=============================================================================
+ * Indexing
+ *============================================================================*/
+
+/**
+ * @brief Get the next published chunk that has not been absorbed yet
+ *
+ * @return Chunk measurements, or NULL if none is ready
+ */
+const MappedChunkLines* mapped_file_peek(MappedFile* file);
+
+/**
+ * @brief Mark the chunk returned by mapped_file_peek() as absorbed
+ *
+ * Its text becomes readable through mapped_file_text().
+ */
+void mapped_file_advance(MappedFile* file);
+
+/**
+ * @brief Check whether every chunk has been published and absorbed
+ */
+bool mapped_file_is_complete(MappedFile* file);
+
+/**
+ * @brief Get the indexer's status without waiting
+ *
+ * @return QALAM_OK while indexing or after success, otherwise the error
+ *         that stopped the indexer
+ */
+QalamResult mapped_file_get_status(MappedFile* file);
+
+/**
+ * @brief Wait for the indexer thread to finish
+ *
+ * @return QALAM_OK, or the error that stopped the indexer
+ */
+QalamResult mapped_file_wait(MappedFile* file);
+
+/**
+ * @brief Get indexing progress in bytes
+ *
+ * @param[out] bytes_indexed Bytes absorbed so far (optional)
+ * @param[out] bytes_total File size (optional)
+ */
+void mapped_file_get_progress(MappedFile* file, size_t* bytes_indexed, size_t* bytes_total);
+
+/*=============================================================================
+ * Text Access
+ *============================================================================*/
+
+/**
+ * @brief Read decoded text at an offset of the absorbed text
+ *
+ * Matches PieceOriginalFn, so it can back a piece table's original text.
+ *
+ * @param context The MappedFile
+ * @param pos Offset in wchar_t units
+ * @param[out] available Receives the characters readable at the result
+ * @return Decoded text (valid until a later call evicts its chunk), or NULL
+ */
+const wchar_t* mapped_file_text(void* context, size_t pos, size_t* available);
+
+/**
+ * @brief Free every decoded chunk
+ *
+ * Text read later is decoded from the mapping again. Invalidates the
+ * pointers mapped_file_text() returned.
+ */
+void mapped_file_trim(MappedFile* file);
+
+/**
+ * @brief Get the bytes held by decoded chunks
+ */
+size_t mapped_file_cached_bytes(const MappedFile* file);
+
+/**
+ * @brief Decode all absorbed text into one newly allocated array
+ *
+ * @param[out] out_text Receives the malloc'd text (NULL when empty)
+ * @param[out] out_length Receives its length
+ * @return QALAM_OK on success, error code on failure
+ */
+QalamResult mapped_file_materialize(MappedFile* file, wchar_t** out_text, size_t* out_length);
+
+/**
+ * @brief Get the path the file was opened from
+ */
+const wchar_t* mapped_file_path(const MappedFile* file);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* QALAM_MAPPED_FILE_H */
@@ -0,0 +1,346 @@
+/**
+ * @file memory.c
+ * @brief Qalam IDE - Tagged Allocation and Frame Arena Implementation
+ *
+ * Every block starts with a header holding its requested size and tag,
+ * so frees and reallocations can charge the right counters without the
+ * caller passing either. The header is MEMORY_HEADER_SIZE bytes so the
+ * memory after it keeps the allocator's alignment.
+ *
+ * The frame arena is a chain of blocks per thread. A mark is a position
+ * counted across the chain, so rewinding frees the blocks started after
+ * it; a reset frees them all, and the next allocation makes one block
+ * the size of the busiest frame so far, so a steady frame rate settles
+ * on a single block and no allocator calls.
+ *
+ * @version 0.0.2
+ * @copyright (c) 2026 Qalam Project
+ *
+ * @note Thread Safety: The qalam_mem_* functions and the stats may be
+ *       used from any thread. Install the allocator before other threads
+ *       start. The frame arena is per thread.
+ */
+
+#include "qalam.h"
+#include <stdlib.h>
+#include <string.h>
+
+/*=============================================================================
+ * Configuration Constants
+ *============================================================================*/
+
+/** Bytes in front of each block (keeps the alignment of the allocator's) */
+#define MEMORY_HEADER_SIZE      16
+
+/** Alignment of frame arena allocations */
+#define FRAME_ARENA_ALIGN       16
+
+/** Smallest frame arena block (bytes) */
+#define FRAME_ARENA_BLOCK_SIZE  (64 * 1024)
+
+#if defined(_MSC_VER)
+    #define FRAME_THREAD_LOCAL __declspec(thread)
+#else
+    #define FRAME_THREAD_LOCAL _Thread_local
+#endif
+
+/*=============================================================================
+ * Internal Structures
+ *============================================================================*/
+
+/**
+ * @brief What is kept in front of each block
+ */
+typedef struct MemoryHeader {
+    size_t size;                /**< Bytes requested */
+    QalamMemoryTag tag;         /**< Tag the block is charged to */
+} MemoryHeader;
+
+/**
+ * @brief A block of the frame arena; its memory follows the header
+ */
+typedef struct FrameBlock {
+    struct FrameBlock* prev;    /**< Block started before this one, or NULL */
+    size_t start;               /**< Arena position of the block's first byte */
+    size_t size;                /**< Usable bytes */
+} FrameBlock;
+
+/** Bytes reserved for a FrameBlock in front of its memory */
+#define FRAME_BLOCK_HEADER_SIZE \
+    ((sizeof(FrameBlock) + FRAME_ARENA_ALIGN - 1) / FRAME_ARENA_ALIGN * FRAME_ARENA_ALIGN)
+
+/*=============================================================================
+ * Internal State
+ *============================================================================*/
+
+static void* memory_crt_allocate(size_t size, QalamMemoryTag tag, void* user_data) {
+    (void)tag;
+    (void)user_data;
+    return malloc(size);
+}
+
+static void* memory_crt_reallocate(void* block, size_t size, QalamMemoryTag tag, void* user_data) {
+    (void)tag;
+    (void)user_data;
+    return realloc(block, size);
+}
+
+static void memory_crt_release(void* block, QalamMemoryTag tag, void* user_data) {
+    (void)tag;
+    (void)user_data;
+    free(block);
+}
+
+static QalamAllocator g_allocator = {
+    memory_crt_allocate,
+    memory_crt_reallocate,
+    memory_crt_release,
+    NULL
+};
+
+static volatile LONG64 g_bytes[QALAM_MEMORY_TAG_COUNT];
+static volatile LONG64 g_blocks[QALAM_MEMORY_TAG_COUNT];
+static volatile LONG64 g_peak_bytes[QALAM_MEMORY_TAG_COUNT];
+static volatile LONG64 g_allocations[QALAM_MEMORY_TAG_COUNT];
+static volatile LONG64 g_failures[QALAM_MEMORY_TAG_COUNT];
+
+static FRAME_THREAD_LOCAL FrameBlock* t_frame_block = NULL;    /**< Newest block */
+static FRAME_THREAD_LOCAL size_t t_frame_used = 0;             /**< Bytes used of it */
+static FRAME_THREAD_LOCAL size_t t_frame_peak = 0;             /**< Most used since reset */
+static FRAME_THREAD_LOCAL size_t t_frame_block_size = FRAME_ARENA_BLOCK_SIZE;
+
+/*=============================================================================
+ * Internal Helper Functions
+ *============================================================================*/
+
+static QalamMemoryTag memory_valid_tag(QalamMemoryTag tag) {
+    return (unsigned)tag < QALAM_MEMORY_TAG_COUNT ? tag : QALAM_MEMORY_UI;
+}
+
+static MemoryHeader* memory_header(void* block) {
+    return (MemoryHeader*)((uint8_t*)block - MEMORY_HEADER_SIZE);
+}
+
+static void memory_charge(QalamMemoryTag tag, int64_t bytes, int64_t blocks) {
+    LONG64 live = InterlockedExchangeAdd64(&g_bytes[tag], bytes) + bytes;
+    if (blocks != 0) {
+        InterlockedExchangeAdd64(&g_blocks[tag], blocks);
+    }
+
+    LONG64 peak = g_peak_bytes[tag];
+    while (live > peak) {
+        LONG64 seen = InterlockedCompareExchange64(&g_peak_bytes[tag], live, peak);
+        if (seen == peak) {
+            break;
+        }
+        peak = seen;
+    }
+}
+
+static void* memory_fail(QalamMemoryTag tag) {
+    InterlockedIncrement64(&g_failures[tag]);
+    return NULL;
+}
+
+/*=============================================================================
+ * Allocator and Statistics
+ *============================================================================*/
+
+QalamResult qalam_memory_set_allocator(const QalamAllocator* allocator) {
+    if (allocator && (!allocator->allocate || !allocator->release)) {
+        return QALAM_ERROR_INVALID_ARGUMENT;
+    }
+
+    for (int i = 0; i < QALAM_MEMORY_TAG_COUNT; i++) {
+        if (g_blocks[i] != 0) {
+            return QALAM_ERROR_ALREADY_INITIALIZED;
+        }
+    }
+
+    if (allocator) {
+        g_allocator = *allocator;
+    } else {
+        g_allocator.allocate = memory_crt_allocate;
+        g_allocator.reallocate = memory_crt_reallocate;
+        g_allocator.release = memory_crt_release;
+        g_allocator.user_data = NULL;
+    }
+    return QALAM_OK;
+}
+
+void qalam_memory_get_stats(QalamMemoryStats* stats) {
+    if (!stats) {
+        return;
+    }
+
+    for (int i = 0; i < QALAM_MEMORY_TAG_COUNT; i++) {
+        stats->bytes[i] = (uint64_t)g_bytes[i];
+        stats->blocks[i] = (uint64_t)g_blocks[i];
+        stats->peak_bytes[i] = (uint64_t)g_peak_bytes[i];
+        stats->allocations[i] = (uint64_t)g_allocations[i];
+        stats->failures[i] = (uint64_t)g_failures[i];
+    }
+}
+
+/*=============================================================================
+ * Tagged Allocation
+ *============================================================================*/
+
+void* qalam_mem_alloc(QalamMemoryTag tag, size_t size) {
+    tag = memory_valid_tag(tag);
+    if (size > SIZE_MAX - MEMORY_HEADER_SIZE) {
+        return memory_fail(tag);
+    }
+
+    uint8_t* base = (uint8_t*)g_allocator.allocate(MEMORY_HEADER_SIZE + size, tag,
+                                                   g_allocator.user_data);
+    if (!base) {
+        return memory_fail(tag);
+    }
+
+    MemoryHeader* header = (MemoryHeader*)base;
+    header->size = size;
+    header->tag = tag;
+
+    InterlockedIncrement64(&g_allocations[tag]);
+    memory_charge(tag, (int64_t)size, 1);
+    return base + MEMORY_HEADER_SIZE;
+}
+
+void* qalam_mem_calloc(QalamMemoryTag tag, size_t count, size_t size) {
+    if (size != 0 && count > SIZE_MAX / size) {
+        return memory_fail(memory_valid_tag(tag));
+    }
+
+    void* block = qalam_mem_alloc(tag, count * size);
+    if (block) {
+        memset(block, 0, count * size);
+    }
+    return block;
+}
+
+void* qalam_mem_realloc(QalamMemoryTag tag, void* block, size_t size) {
+    if (!block) {
+        return qalam_mem_alloc(tag, size);
+    }
+
+    MemoryHeader* header = memory_header(block);
+    size_t old_size = header->size;
+    tag = header->tag;
+    if (size > SIZE_MAX - MEMORY_HEADER_SIZE) {
+        return memory_fail(tag);
+    }
+
+    uint8_t* base;
+    if (g_allocator.reallocate) {
+        base = (uint8_t*)g_allocator.reallocate(header, MEMORY_HEADER_SIZE + size, tag,
+                                                g_allocator.user_data);
+        if (!base) {
+            return memory_fail(tag);
+        }
+    } else {
+        base = (uint8_t*)g_allocator.allocate(MEMORY_HEADER_SIZE + size, tag,
+                                              g_allocator.user_data);
+        if (!base) {
+            return memory_fail(tag);
+        }
+        memcpy(base, header, MEMORY_HEADER_SIZE + (old_size < size ? old_size : size));
+        g_allocator.release(header, tag, g_allocator.user_data);
+    }
+
+    ((MemoryHeader*)base)->size = size;
+    memory_charge(tag, (int64_t)size - (int64_t)old_size, 0);
+    return base + MEMORY_HEADER_SIZE;
+}
+
+void qalam_mem_free(void* block) {
+    if (!block) {
+        return;
+    }
+
+    MemoryHeader* header = memory_header(block);
+    QalamMemoryTag tag = header->tag;
+    memory_charge(tag, -(int64_t)header->size, -1);
+    g_allocator.release(header, tag, g_allocator.user_data);
+}
+
+/*=============================================================================
+ * Frame Arena
+ *============================================================================*/
+
+static size_t frame_position(void) {
+    return t_frame_block ? t_frame_block->start + t_frame_used : 0;
+}
+
+void* qalam_frame_alloc(size_t size) {
+    if (size > SIZE_MAX - FRAME_BLOCK_HEADER_SIZE - FRAME_ARENA_ALIGN) {
+        return NULL;
+    }
+    size = (size + FRAME_ARENA_ALIGN - 1) / FRAME_ARENA_ALIGN * FRAME_ARENA_ALIGN;
+
+    if (!t_frame_block || t_frame_block->size - t_frame_used < size) {
+        size_t block_size = size > t_frame_block_size ? size : t_frame_block_size;
+        FrameBlock* block = (FrameBlock*)qalam_mem_alloc(QALAM_MEMORY_FRAME,
+                                                         FRAME_BLOCK_HEADER_SIZE + block_size);
+        if (!block) {
+            return NULL;
+        }
+
+        block->prev = t_frame_block;
+        block->start = frame_position();
+        block->size = block_size;
+        t_frame_block = block;
+        t_frame_used = 0;
+    }
+
+    void* memory = (uint8_t*)t_frame_block + FRAME_BLOCK_HEADER_SIZE + t_frame_used;
+    t_frame_used += size;
+    if (frame_position() > t_frame_peak) {
+        t_frame_peak = frame_position();
+    }
+    return memory;
+}
+
+size_t qalam_frame_mark(void) {
+    return frame_position();
+}
+
+void qalam_frame_rewind(size_t mark) {
+    while (t_frame_block && t_frame_block->start > mark) {
+        FrameBlock* prev = t_frame_block->prev;
+        qalam_mem_free(t_frame_block);
+        t_frame_block = prev;
+        t_frame_used = t_frame_block ? t_frame_block->size : 0;
+    }
+
+    if (t_frame_block && mark - t_frame_block->start < t_frame_used) {
+        t_frame_used = mark - t_frame_block->start;
+    }
+}
+
+void qalam_frame_reset(void) {
+    if (t_frame_block && t_frame_block->prev) {
+        /* The frame outgrew one block: come back as one that fits it */
+        while (t_frame_block) {
+            FrameBlock* prev = t_frame_block->prev;
+            qalam_mem_free(t_frame_block);
+            t_frame_block = prev;
+        }
+        if (t_frame_peak > t_frame_block_size) {
+            t_frame_block_size = t_frame_peak;
+        }
+    }
+
+    t_frame_used = 0;
+    t_frame_peak = 0;
+}
+
+void qalam_frame_release(void) {
+    while (t_frame_block) {
+        FrameBlock* prev = t_frame_block->prev;
+        qalam_mem_free(t_frame_block);
+        t_frame_block = prev;
+    }
+    t_frame_used = 0;
+    t_frame_peak = 0;
+}
@@ -0,0 +1,723 @@
+/**
+ * @file piece_table.c
+ * @brief Qalam IDE - Piece Table Storage Implementation
+ *
+ * The document is the in-order concatenation of the pieces in a treap.
+ * Each node caches the total length of its subtree, so a position is
+ * located by descending from the root. Edits split the treap at the
+ * edit boundaries and merge the parts back together; neither the
+ * original text nor earlier additions are ever moved, so the cost of an
+ * edit does not depend on the document size.
+ *
+ * @version 0.0.2
+ * @copyright (c) 2026 Qalam Project
+ *
+ * @note Thread Safety: Functions in this file are NOT thread-safe.
+ */
+
+#include "piece_table.h"
+#include <stdlib.h>
+#include <string.h>
+
+/** Initial size of the add buffer in wchar_t units */
+#define PIECE_TABLE_ADD_INITIAL     4096
+
+/** Maximum number of recycled nodes kept for reuse */
+#define PIECE_TABLE_FREE_MAX        64
+
+/** Nodes an insert or delete may need (two splits, or a split and a new piece) */
+#define PIECE_TABLE_SPARE_NODES     2
+
+/*=============================================================================
+ * Internal Helper Functions - Nodes
+ *============================================================================*/
+
+/**
+ * @brief Next treap priority (xorshift32)
+ */
+static uint32_t piece_next_priority(PieceTable* table) {
+    uint32_t x = table->seed;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    table->seed = x;
+    return x;
+}
+
+/**
+ * @brief Subtree length of a possibly-NULL node
+ */
+static inline size_t piece_subtree_length(const PieceNode* node) {
+    return node ? node->subtree_length : 0;
+}
+
+/**
+ * @brief Recompute a node's cached subtree length from its children
+ */
+static inline void piece_update(PieceNode* node) {
+    node->subtree_length = piece_subtree_length(node->left) + node->length +
+                           piece_subtree_length(node->right);
+}
+
+/**
+ * @brief Get the backing text of a piece
+ */
+static inline const wchar_t* piece_text(const PieceTable* table, const PieceNode* node) {
+    return (node->source == PIECE_SOURCE_ORIGINAL ? table->original : table->add) + node->start;
+}
+
+/**
+ * @brief Make sure enough recycled nodes exist for one edit
+ *
+ * Allocating up front means the split/merge code below never fails
+ * halfway through restructuring the treap.
+ */
+static QalamResult piece_reserve_nodes(PieceTable* table) {
+    while (table->free_count < PIECE_TABLE_SPARE_NODES) {
+        PieceNode* node = (PieceNode*)qalam_mem_alloc(QALAM_MEMORY_BUFFER, sizeof(PieceNode));
+        if (!node) {
+            return QALAM_ERROR_OUT_OF_MEMORY;
+        }
+        node->right = table->free_nodes;
+        table->free_nodes = node;
+        table->free_count++;
+    }
+    return QALAM_OK;
+}
+
+/**
+ * @brief Take a node from the recycled list (reserved beforehand)
+ */
+static PieceNode* piece_take_node(PieceTable* table) {
+    PieceNode* node = table->free_nodes;
+    table->free_nodes = node->right;
+    table->free_count--;
+    table->piece_count++;
+    node->left = NULL;
+    node->right = NULL;
+    return node;
+}
+
+/**
+ * @brief Return a node to the recycled list, or free it if the list is full
+ */
+static void piece_release_node(PieceTable* table, PieceNode* node) {
+    table->piece_count--;
+    if (table->free_count < PIECE_TABLE_FREE_MAX) {
+        node->left = NULL;
+        node->right = table->free_nodes;
+        table->free_nodes = node;
+        table->free_count++;
+    } else {
+        qalam_mem_free(node);
+    }
+}
+
+/**
+ * @brief Release every node of a subtree
+ */
+static void piece_release_tree(PieceTable* table, PieceNode* node) {
+    while (node) {
+        piece_release_tree(table, node->left);
+        PieceNode* right = node->right;
+        piece_release_node(table, node);
+        node = right;
+    }
+}
+
+/*=============================================================================
+ * Internal Helper Functions - Treap Operations
+ *============================================================================*/
+
+/**
+ * @brief Split a subtree into the first 'pos' characters and the rest
+ *
+ * A piece straddling the split point is cut in two; the new tail piece
+ * inherits the priority of the original so the heap order still holds.
+ */
+static void piece_split(PieceTable* table, PieceNode* node, size_t pos,
+                        PieceNode** left, PieceNode** right) {
+    if (!node) {
+        *left = NULL;
+        *right = NULL;
+        return;
+    }
+
+    size_t left_length = piece_subtree_length(node->left);
+
+    if (pos <= left_length) {
+        piece_split(table, node->left, pos, left, &node->left);
+        piece_update(node);
+        *right = node;
+    } else if (pos >= left_length + node->length) {
+        piece_split(table, node->right, pos - left_length - node->length, &node->right, right);
+        piece_update(node);
+        *left = node;
+    } else {
+        size_t cut = pos - left_length;
+        PieceNode* tail = piece_take_node(table);
+        tail->priority = node->priority;
+        tail->source = node->source;
+        tail->start = node->start + cut;
+        tail->length = node->length - cut;
+        tail->right = node->right;
+        piece_update(tail);
+
+        node->length = cut;
+        node->right = NULL;
+        piece_update(node);
+
+        *left = node;
+        *right = tail;
+    }
+}
+
+/**
+ * @brief Concatenate two subtrees (all of 'left' precedes all of 'right')
+ */
+static PieceNode* piece_merge(PieceNode* left, PieceNode* right) {
+    if (!left) {
+        return right;
+    }
+    if (!right) {
+        return left;
+    }
+
+    if (left->priority >= right->priority) {
+        left->right = piece_merge(left->right, right);
+        piece_update(left);
+        return left;
+    }
+
+    right->left = piece_merge(left, right->left);
+    piece_update(right);
+    return right;
+}
+
+/**
+ * @brief Grow the piece ending exactly at 'pos' if it is the add tail
+ *
+ * Typing appends to the add buffer and inserts right after the previous
+ * insertion, so the most recent add piece can simply be lengthened.
+ *
+ * @return true if a piece was extended
+ */
+static bool piece_try_extend(PieceTable* table, PieceNode* node, size_t pos,
+                             size_t add_start, size_t length) {
+    if (!node) {
+        return false;
+    }
+
+    size_t left_length = piece_subtree_length(node->left);
+    bool extended;
+
+    if (pos <= left_length) {
+        extended = piece_try_extend(table, node->left, pos, add_start, length);
+    } else if (pos <= left_length + node->length) {
+        extended = pos == left_length + node->length &&
+                   node->source == PIECE_SOURCE_ADD &&
+                   node->start + node->length == add_start;
+        if (extended) {
+            node->length += length;
+        }
+    } else {
+        extended = piece_try_extend(table, node->right, pos - left_length - node->length,
+                                    add_start, length);
+    }
+
+    if (extended) {
+        node->subtree_length += length;
+    }
+    return extended;
+}
+
+/**
+ * @brief Pass a piece's text in [from, from + length) to a segment callback
+ *
+ * A lazy original source may hand its text out in several runs.
+ */
+static bool piece_emit(const PieceTable* table, const PieceNode* node, size_t from, size_t length,
+                       PieceSegmentFn fn, void* context) {
+    if (node->source == PIECE_SOURCE_ADD || !table->fetch_original) {
+        return fn(piece_text(table, node) + from, length, context);
+    }
+
+    size_t pos = node->start + from;
+    while (length > 0) {
+        size_t available;
+        const wchar_t* text = table->fetch_original(table->fetch_context, pos, &available);
+        if (!text || available == 0) {
+            return false;
+        }
+        if (available > length) {
+            available = length;
+        }
+        if (!fn(text, available, context)) {
+            return false;
+        }
+        pos += available;
+        length -= available;
+    }
+    return true;
+}
+
+/**
+ * @brief In-order visit of the pieces overlapping [start, end)
+ *
+ * @param base Document offset of the first character of 'node's subtree
+ */
+static bool piece_visit(const PieceTable* table, const PieceNode* node, size_t base,
+                        size_t start, size_t end, PieceSegmentFn fn, void* context) {
+    while (node && start < end) {
+        size_t node_start = base + piece_subtree_length(node->left);
+        size_t node_end = node_start + node->length;
+
+        if (start < node_start &&
+            !piece_visit(table, node->left, base, start, end, fn, context)) {
+            return false;
+        }
+
+        size_t from = start > node_start ? start : node_start;
+        size_t to = end < node_end ? end : node_end;
+        if (from < to && !piece_emit(table, node, from - node_start, to - from, fn, context)) {
+            return false;
+        }
+
+        if (end <= node_end) {
+            break;
+        }
+        base = node_end;
+        node = node->right;
+    }
+    return true;
+}
+
+/**
+ * @brief Grow the last piece if it ends at the original text's tail
+ *
+ * @return true if a piece was extended
+ */
+static bool piece_try_extend_last(PieceNode* node, size_t original_end, size_t length) {
+    if (!node) {
+        return false;
+    }
+
+    bool extended;
+    if (node->right) {
+        extended = piece_try_extend_last(node->right, original_end, length);
+    } else {
+        extended = node->source == PIECE_SOURCE_ORIGINAL &&
+                   node->start + node->length == original_end;
+        if (extended) {
+            node->length += length;
+        }
+    }
+
+    if (extended) {
+        node->subtree_length += length;
+    }
+    return extended;
+}
+
+/**
+ * @brief Lengthen the first or last piece of a subtree
+ *
+ * Growing the first piece moves its start back, so the new text
+ * precedes the old.
+ */
+static void piece_grow_edge(PieceNode* node, bool at_start, size_t length) {
+    for (;;) {
+        node->subtree_length += length;
+        PieceNode* next = at_start ? node->left : node->right;
+        if (!next) {
+            break;
+        }
+        node = next;
+    }
+
+    node->length += length;
+    if (at_start) {
+        node->start -= length;
+    }
+}
+
+/**
+ * @brief Get the first or last piece of a subtree
+ */
+static PieceNode* piece_edge(PieceNode* node, bool at_start) {
+    for (;;) {
+        PieceNode* next = at_start ? node->left : node->right;
+        if (!next) {
+            return node;
+        }
+        node = next;
+    }
+}
+
+/**
+ * @brief Segment callback used by piece_table_copy()
+ */
+static bool piece_copy_segment(const wchar_t* text, size_t length, void* context) {
+    wchar_t** out = (wchar_t**)context;
+    memcpy(*out, text, length * sizeof(wchar_t));
+    *out += length;
+    return true;
+}
+
+/*=============================================================================
+ * Lifecycle
+ *============================================================================*/
+
+QalamResult piece_table_init(PieceTable* table, wchar_t* original, size_t original_length) {
+    if (!table) {
+        return QALAM_ERROR_NULL_POINTER;
+    }
+
+    memset(table, 0, sizeof(PieceTable));
+    table->seed = 0x9E3779B9u;
+    table->original = original;
+    table->original_length = original_length;
+
+    if (original_length > 0) {
+        QalamResult result = piece_reserve_nodes(table);
+        if (result != QALAM_OK) {
+            table->original = NULL;
+            piece_table_free(table);
+            return result;
+        }
+
+        PieceNode* node = piece_take_node(table);
+        node->priority = piece_next_priority(table);
+        node->source = PIECE_SOURCE_ORIGINAL;
+        node->start = 0;
+        node->length = original_length;
+        piece_update(node);
+        table->root = node;
+    }
+
+    return QALAM_OK;
+}
+
+void piece_table_free(PieceTable* table) {
+    if (!table) {
+        return;
+    }
+
+    piece_release_tree(table, table->root);
+    while (table->free_nodes) {
+        PieceNode* next = table->free_nodes->right;
+        qalam_mem_free(table->free_nodes);
+        table->free_nodes = next;
+    }
+
+    qalam_mem_free(table->original);
+    qalam_mem_free(table->add);
+
+    memset(table, 0, sizeof(PieceTable));
+}
+
+void piece_table_set_original_source(PieceTable* table, PieceOriginalFn fn, void* context) {
+    table->fetch_original = fn;
+    table->fetch_context = context;
+}
+
+void piece_table_adopt_original(PieceTable* table, wchar_t* original) {
+    qalam_mem_free(table->original);
+    table->original = original;
+    table->fetch_original = NULL;
+    table->fetch_context = NULL;
+}
+
+/*=============================================================================
+ * Queries
+ *============================================================================*/
+
+size_t piece_table_length(const PieceTable* table) {
+    return piece_subtree_length(table->root);
+}
+
+wchar_t piece_table_char_at(const PieceTable* table, size_t pos) {
+    const PieceNode* node = table->root;
+
+    while (node) {
+        size_t left_length = piece_subtree_length(node->left);
+        if (pos < left_length) {
+            node = node->left;
+        } else if (pos < left_length + node->length) {
+            if (node->source == PIECE_SOURCE_ORIGINAL && table->fetch_original) {
+                size_t available;
+                const wchar_t* text = table->fetch_original(table->fetch_context,
+                                                            node->start + pos - left_length,
+                                                            &available);
+                return text ? text[0] : L'\0';
+            }
+            return piece_text(table, node)[pos - left_length];
+        } else {
+            pos -= left_length + node->length;
+            node = node->right;
+        }
+    }
+
+    return L'\0';
+}
+
+void piece_table_copy(const PieceTable* table, size_t pos, size_t length, wchar_t* out) {
+    piece_visit(table, table->root, 0, pos, pos + length, piece_copy_segment, &out);
+}
+
+bool piece_table_for_each_segment(const PieceTable* table, size_t pos, size_t length,
+                                  PieceSegmentFn fn, void* context) {
+    if (!table || !fn) {
+        return false;
+    }
+    return piece_visit(table, table->root, 0, pos, pos + length, fn, context);
+}
+
+/*=============================================================================
+ * Updates
+ *============================================================================*/
+
+QalamResult piece_table_reserve_add(PieceTable* table, size_t needed, wchar_t** out_tail) {
+    if (!table || !out_tail) {
+        return QALAM_ERROR_NULL_POINTER;
+    }
+
+    if (needed > SIZE_MAX / sizeof(wchar_t) - table->add_length) {
+        return QALAM_ERROR_OUT_OF_MEMORY;
+    }
+
+    size_t required = table->add_length + needed;
+    if (required > table->add_capacity) {
+        size_t new_capacity = table->add_capacity ? table->add_capacity : PIECE_TABLE_ADD_INITIAL;
+        while (new_capacity < required) {
+            new_capacity = new_capacity > SIZE_MAX / (2 * sizeof(wchar_t)) ? required
+                                                                            : new_capacity * 2;
+        }
+
+        wchar_t* add = (wchar_t*)qalam_mem_realloc(QALAM_MEMORY_BUFFER,
+                                                   table->add, new_capacity * sizeof(wchar_t));
+        if (!add) {
+            return QALAM_ERROR_OUT_OF_MEMORY;
+        }
+        table->add = add;
+        table->add_capacity = new_capacity;
+    }
+
+    *out_tail = table->add + table->add_length;
+    return QALAM_OK;
+}
+
+void piece_table_shrink_add(PieceTable* table) {
+    if (!table || table->add_capacity == table->add_length) {
+        return;
+    }
+
+    if (table->add_length == 0) {
+        qalam_mem_free(table->add);
+        table->add = NULL;
+        table->add_capacity = 0;
+        return;
+    }
+
+    wchar_t* add = (wchar_t*)qalam_mem_realloc(QALAM_MEMORY_BUFFER, table->add,
+                                               table->add_length * sizeof(wchar_t));
+    if (add) {
+        table->add = add;
+        table->add_capacity = table->add_length;
+    }
+}
+
+QalamResult piece_table_insert(PieceTable* table, size_t pos, size_t length) {
+    if (!table) {
+        return QALAM_ERROR_NULL_POINTER;
+    }
+    if (pos > piece_table_length(table) || length > table->add_capacity - table->add_length) {
+        return QALAM_ERROR_INVALID_RANGE;
+    }
+    if (length == 0) {
+        return QALAM_OK;
+    }
+
+    size_t add_start = table->add_length;
+
+    if (!piece_try_extend(table, table->root, pos, add_start, length)) {
+        QalamResult result = piece_reserve_nodes(table);
+        if (result != QALAM_OK) {
+            return result;
+        }
+
+        PieceNode* node = piece_take_node(table);
+        node->priority = piece_next_priority(table);
+        node->source = PIECE_SOURCE_ADD;
+        node->start = add_start;
+        node->length = length;
+        piece_update(node);
+
+        PieceNode* left;
+        PieceNode* right;
+        piece_split(table, table->root, pos, &left, &right);
+        table->root = piece_merge(piece_merge(left, node), right);
+    }
+
+    table->add_length += length;
+    return QALAM_OK;
+}
+
+QalamResult piece_table_append_original(PieceTable* table, size_t length) {
+    if (!table) {
+        return QALAM_ERROR_NULL_POINTER;
+    }
+    if (length == 0) {
+        return QALAM_OK;
+    }
+
+    size_t original_end = table->original_length;
+
+    if (!piece_try_extend_last(table->root, original_end, length)) {
+        QalamResult result = piece_reserve_nodes(table);
+        if (result != QALAM_OK) {
+            return result;
+        }
+
+        PieceNode* node = piece_take_node(table);
+        node->priority = piece_next_priority(table);
+        node->source = PIECE_SOURCE_ORIGINAL;
+        node->start = original_end;
+        node->length = length;
+        piece_update(node);
+        table->root = piece_merge(table->root, node);
+    }
+
+    table->original_length += length;
+    return QALAM_OK;
+}
+
+QalamResult piece_table_delete(PieceTable* table, size_t pos, size_t length) {
+    if (!table) {
+        return QALAM_ERROR_NULL_POINTER;
+    }
+
+    size_t total = piece_table_length(table);
+    if (pos > total || length > total - pos) {
+        return QALAM_ERROR_INVALID_RANGE;
+    }
+    if (length == 0) {
+        return QALAM_OK;
+    }
+
+    QalamResult result = piece_reserve_nodes(table);
+    if (result != QALAM_OK) {
+        return result;
+    }
+
+    PieceNode* left;
+    PieceNode* middle;
+    PieceNode* right;
+    piece_split(table, table->root, pos, &left, &right);
+    piece_split(table, right, length, &middle, &right);
+    piece_release_tree(table, middle);
+    table->root = piece_merge(left, right);
+
+    return QALAM_OK;
+}
+
+/*=============================================================================
+ * Detached Spans
+ *============================================================================*/
+
+QalamResult piece_table_detach(PieceTable* table, size_t pos, size_t length,
+                               PieceNode** out_span) {
+    if (!table || !out_span) {
+        return QALAM_ERROR_NULL_POINTER;
+    }
+
+    size_t total = piece_table_length(table);
+    if (length == 0 || pos > total || length > total - pos) {
+        return QALAM_ERROR_INVALID_RANGE;
+    }
+
+    QalamResult result = piece_reserve_nodes(table);
+    if (result != QALAM_OK) {
+        return result;
+    }
+
+    PieceNode* left;
+    PieceNode* right;
+    piece_split(table, table->root, pos, &left, &right);
+    piece_split(table, right, length, out_span, &right);
+    table->root = piece_merge(left, right);
+
+    return QALAM_OK;
+}
+
+QalamResult piece_table_attach(PieceTable* table, size_t pos, PieceNode* span) {
+    if (!table) {
+        return QALAM_ERROR_NULL_POINTER;
+    }
+    if (pos > piece_table_length(table)) {
+        return QALAM_ERROR_INVALID_RANGE;
+    }
+    if (!span) {
+        return QALAM_OK;
+    }
+
+    /* Splitting may cut a piece in two */
+    QalamResult result = piece_reserve_nodes(table);
+    if (result != QALAM_OK) {
+        return result;
+    }
+
+    PieceNode* left;
+    PieceNode* right;
+    piece_split(table, table->root, pos, &left, &right);
+    table->root = piece_merge(piece_merge(left, span), right);
+
+    return QALAM_OK;
+}
+
+PieceNode* piece_table_join_spans(PieceTable* table, PieceNode* left, PieceNode* right) {
+    if (!left) {
+        return right;
+    }
+    if (!right) {
+        return left;
+    }
+
+    if (!left->left && !left->right) {
+        PieceNode* first = piece_edge(right, true);
+        if (first->source == left->source && left->start + left->length == first->start) {
+            piece_grow_edge(right, true, left->length);
+            piece_release_node(table, left);
+            return right;
+        }
+    }
+
+    if (!right->left && !right->right) {
+        PieceNode* last = piece_edge(left, false);
+        if (last->source == right->source && last->start + last->length == right->start) {
+            piece_grow_edge(left, false, right->length);
+            piece_release_node(table, right);
+            return left;
+        }
+    }
+
+    return piece_merge(left, right);
+}
+
+size_t piece_span_length(const PieceNode* span) {
+    return piece_subtree_length(span);
+}
+
+bool piece_table_for_each_span_segment(const PieceTable* table, const PieceNode* span,
+                                       PieceSegmentFn fn, void* context) {
+    if (!table || !fn) {
+        return false;
+    }
+    return piece_visit(table, span, 0, 0, piece_subtree_length(span), fn, context);
+}
+
+void piece_table_release_span(PieceTable* table, PieceNode* span) {
+    if (table) {
+        piece_release_tree(table, span);
+    }
+}
@@ -0,0 +1,297 @@
+/**
+ * @file piece_table.h
+ * @brief Qalam IDE - Piece Table Storage (Internal Header)
+ *
+ * Internal header for the piece table buffer backend. Text is described
+ * by a sequence of pieces, each referencing a span of either the
+ * immutable original text or an append-only add buffer. Pieces are kept
+ * in a treap keyed implicitly by position, so locating, splitting and
+ * joining pieces is O(log pieces) no matter where in the document an
+ * edit lands.
+ *
+ * @version 0.0.2
+ * @copyright (c) 2026 Qalam Project
+ *
+ * @note Thread Safety: Not thread-safe. Owned by a single QalamBuffer.
+ */
+
+#ifndef QALAM_PIECE_TABLE_H
+#define QALAM_PIECE_TABLE_H
+
+#include "qalam.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*=============================================================================
+ * Piece Table Structures
+ *============================================================================*/
+
+/**
+ * @brief Which backing buffer a piece refers to
+ */
+typedef enum PieceSource {
+    PIECE_SOURCE_ORIGINAL = 0,      /**< Immutable original text */
+    PIECE_SOURCE_ADD = 1,           /**< Append-only add buffer */
+} PieceSource;
+
+/**
+ * @brief Treap node describing one piece
+ */
+typedef struct PieceNode {
+    struct PieceNode* left;         /**< Pieces before this one */
+    struct PieceNode* right;        /**< Pieces after this one */
+    uint32_t priority;              /**< Treap heap priority */
+    PieceSource source;             /**< Backing buffer */
+    size_t start;                   /**< Start offset in the backing buffer */
+    size_t length;                  /**< Length in wchar_t units */
+    size_t subtree_length;          /**< Total length of this subtree */
+} PieceNode;
+
+/**
+ * @brief Callback supplying original text on demand
+ *
+ * Lets the original text live outside the table, e.g. decoded lazily
+ * from a memory-mapped file.
+ *
+ * @param context Source context
+ * @param pos Offset in the original text
+ * @param[out] available Receives the number of characters readable at the result
+ * @return Text at 'pos' (valid until the next call), or NULL on failure
+ */
+typedef const wchar_t* (*PieceOriginalFn)(void* context, size_t pos, size_t* available);
+
+/**
+ * @brief Piece table state
+ */
+typedef struct PieceTable {
+    wchar_t* original;              /**< Original text (owned, never modified) */
+    size_t original_length;         /**< Length of original text */
+    PieceOriginalFn fetch_original; /**< Lazy original source (NULL: use 'original') */
+    void* fetch_context;            /**< Context for fetch_original */
+    wchar_t* add;                   /**< Append-only add buffer */
+    size_t add_length;              /**< Committed length of add buffer */
+    size_t add_capacity;            /**< Allocated size of add buffer */
+    PieceNode* root;                /**< Treap root */
+    size_t piece_count;             /**< Live nodes (in the treap or detached spans) */
+    PieceNode* free_nodes;          /**< Recycled nodes (linked via right) */
+    size_t free_count;              /**< Number of recycled nodes */
+    uint32_t seed;                  /**< Priority generator state */
+} PieceTable;
+
+/**
+ * @brief Callback receiving contiguous text segments
+ *
+ * @param text Segment start (valid until the next mutation)
+ * @param length Segment length in wchar_t units
+ * @param context User context
+ * @return true to continue, false to stop iterating
+ */
+typedef bool (*PieceSegmentFn)(const wchar_t* text, size_t length, void* context);
+
+/*=============================================================================
+ * Lifecycle
+ *============================================================================*/
+
+/**
+ * @brief Initialize a piece table over an original text
+ *
+ * On success the table takes ownership of 'original', which must have
+ * been allocated with malloc (may be NULL when original_length is 0).
+ * On failure it is left to the caller.
+ *
+ * @param table Table to initialize
+ * @param original Original UTF-16 text
+ * @param original_length Length of original text
+ * @return QALAM_OK on success, error code on failure
+ */
+QalamResult piece_table_init(PieceTable* table, wchar_t* original, size_t original_length);
+
+/**
+ * @brief Release the table, its pieces and both backing buffers
+ *
+ * @param table Table to free (may be NULL)
+ */
+void piece_table_free(PieceTable* table);
+
+/**
+ * @brief Read the original text through a callback instead of 'original'
+ *
+ * The table should be empty; original text is then announced with
+ * piece_table_append_original() as it becomes known.
+ */
+void piece_table_set_original_source(PieceTable* table, PieceOriginalFn fn, void* context);
+
+/**
+ * @brief Replace the lazy original source with a materialized copy
+ *
+ * @param table Target table
+ * @param original Whole original text (original_length units, malloc'd;
+ *        the table takes ownership)
+ */
+void piece_table_adopt_original(PieceTable* table, wchar_t* original);
+
+/*=============================================================================
+ * Queries
+ *============================================================================*/
+
+/**
+ * @brief Get the document length in wchar_t units
+ */
+size_t piece_table_length(const PieceTable* table);
+
+/**
+ * @brief Get the character at a position (no bounds check)
+ */
+wchar_t piece_table_char_at(const PieceTable* table, size_t pos);
+
+/**
+ * @brief Copy a range of the document into a caller buffer
+ *
+ * @param table Source table
+ * @param pos Start position
+ * @param length Number of wchar_t to copy
+ * @param[out] out Destination (at least 'length' elements)
+ */
+void piece_table_copy(const PieceTable* table, size_t pos, size_t length, wchar_t* out);
+
+/**
+ * @brief Visit the contiguous segments covering a range, in order
+ *
+ * @return false if the callback stopped the iteration early
+ */
+bool piece_table_for_each_segment(const PieceTable* table, size_t pos, size_t length,
+                                  PieceSegmentFn fn, void* context);
+
+/*=============================================================================
+ * Updates
+ *============================================================================*/
+
+/**
+ * @brief Reserve room at the end of the add buffer
+ *
+ * The caller writes up to 'needed' characters at *out_tail and then
+ * commits them with piece_table_insert().
+ *
+ * @param table Target table
+ * @param needed Number of wchar_t to reserve
+ * @param[out] out_tail Receives the write position
+ * @return QALAM_OK on success, QALAM_ERROR_OUT_OF_MEMORY on failure
+ */
+QalamResult piece_table_reserve_add(PieceTable* table, size_t needed, wchar_t** out_tail);
+
+/**
+ * @brief Give the add buffer's unused room back
+ *
+ * Pieces refer to the add buffer by offset, so it may move. Keeps the
+ * buffer as it is if it cannot be reallocated.
+ *
+ * @param table Target table
+ */
+void piece_table_shrink_add(PieceTable* table);
+
+/**
+ * @brief Insert the characters just written at the add buffer tail
+ *
+ * Consecutive typing at the end of the previous insertion extends the
+ * existing piece instead of creating a new one.
+ *
+ * @param table Target table
+ * @param pos Document position to insert at
+ * @param length Number of characters written at the add tail
+ * @return QALAM_OK on success, error code on failure
+ */
+QalamResult piece_table_insert(PieceTable* table, size_t pos, size_t length);
+
+/**
+ * @brief Extend the original text by 'length' characters
+ *
+ * The new original text is appended at the end of the document,
+ * growing the last piece when it already ends at the original tail.
+ *
+ * @param table Target table
+ * @param length Number of characters added to the original
+ * @return QALAM_OK on success, error code on failure
+ */
+QalamResult piece_table_append_original(PieceTable* table, size_t length);
+
+/**
+ * @brief Delete a range of the document
+ *
+ * @param table Target table
+ * @param pos Start position
+ * @param length Number of wchar_t to delete
+ * @return QALAM_OK on success, error code on failure
+ */
+QalamResult piece_table_delete(PieceTable* table, size_t pos, size_t length);
+
+/*=============================================================================
+ * Detached Spans
+ *============================================================================*/
+
+/**
+ * @brief Delete a range of the document, keeping its pieces
+ *
+ * The removed pieces form a detached span that still references the
+ * backing buffers, so the text can be put back by piece_table_attach()
+ * without being copied. Both are O(log pieces) regardless of length.
+ *
+ * @param table Target table
+ * @param pos Start position
+ * @param length Number of wchar_t to delete (> 0)
+ * @param[out] out_span Receives the detached span
+ * @return QALAM_OK on success, error code on failure
+ */
+QalamResult piece_table_detach(PieceTable* table, size_t pos, size_t length,
+                               PieceNode** out_span);
+
+/**
+ * @brief Insert a detached span at a position
+ *
+ * The table takes the span back; it must not be used afterwards.
+ *
+ * @param table Target table
+ * @param pos Document position to insert at
+ * @param span Span from piece_table_detach()
+ * @return QALAM_OK on success, QALAM_ERROR_INVALID_RANGE if pos is past the end
+ */
+QalamResult piece_table_attach(PieceTable* table, size_t pos, PieceNode* span);
+
+/**
+ * @brief Concatenate two detached spans
+ *
+ * A single piece continuing the text of the adjoining piece (as with
+ * repeated backspace or delete over typed text) is folded into it, so
+ * a long run of one-character deletions stays one piece.
+ *
+ * @return The combined span
+ */
+PieceNode* piece_table_join_spans(PieceTable* table, PieceNode* left, PieceNode* right);
+
+/**
+ * @brief Get the length of a detached span in wchar_t units
+ */
+size_t piece_span_length(const PieceNode* span);
+
+/**
+ * @brief Visit the contiguous segments of a detached span, in order
+ *
+ * @return false if the callback stopped the iteration early
+ */
+bool piece_table_for_each_span_segment(const PieceTable* table, const PieceNode* span,
+                                       PieceSegmentFn fn, void* context);
+
+/**
+ * @brief Release the pieces of a detached span
+ *
+ * @param table Table the span was detached from
+ * @param span Span to release (may be NULL)
+ */
+void piece_table_release_span(PieceTable* table, PieceNode* span);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* QALAM_PIECE_TABLE_H */
@@ -0,0 +1,476 @@
+/**
+ * @file search.c
+ * @brief Qalam IDE - Text Search Engine Implementation
+ *
+ * Each run fed to a scan is searched together with the carry left by
+ * the previous one, seen through a two-part window. Positions in the
+ * carry are tried one by one; the run itself goes through the fast
+ * loops. A candidate whose verification reaches the end of the window
+ * is undecided: everything from it onwards becomes the new carry and is
+ * retried once more text arrives. Later candidates can only need more
+ * text than it does, so nothing else is lost by stopping there.
+ *
+ * @version 0.0.2
+ * @copyright (c) 2026 Qalam Project
+ *
+ * @note Thread Safety: Functions in this file are NOT thread-safe.
+ */
+
+#include "search.h"
+#include <stdlib.h>
+#include <string.h>
+
+/** Initial size of a scan's carry in wchar_t units */
+#define SEARCH_CARRY_INITIAL        64
+
+/**
+ * @brief Outcome of verifying one candidate
+ */
+typedef enum SearchVerdict {
+    SEARCH_MISMATCH = 0,            /**< No match starts here */
+    SEARCH_MATCH = 1,               /**< A match starts here */
+    SEARCH_UNDECIDED = 2,           /**< More text is needed to tell */
+} SearchVerdict;
+
+/**
+ * @brief Text visible to a scan: the carry followed by the current run
+ */
+typedef struct SearchWindow {
+    const wchar_t* head;            /**< Carry */
+    size_t head_length;             /**< Characters in 'head' */
+    const wchar_t* tail;            /**< Current run (NULL when finishing) */
+    size_t length;                  /**< Characters in the whole window */
+    bool at_end;                    /**< No text follows the window */
+} SearchWindow;
+
+/*=============================================================================
+ * Internal Helper Functions - Folding
+ *============================================================================*/
+
+/**
+ * @brief Check whether a character is one of the harakat
+ */
+static inline bool search_is_haraka(wchar_t ch) {
+    return (ch >= 0x064B && ch <= 0x065F) || ch == 0x0670;
+}
+
+/**
+ * @brief Check whether Arabic folding skips a character
+ */
+static inline bool search_is_ignorable(wchar_t ch) {
+    return search_is_haraka(ch) || ch == 0x0640;    /* Tatweel */
+}
+
+/**
+ * @brief Fold a character as the pattern's options require
+ */
+static inline wchar_t search_fold(const SearchPattern* pattern, wchar_t ch) {
+    if (ch < 0x80) {
+        if (pattern->ignore_case && ch >= L'A' && ch <= L'Z') {
+            return (wchar_t)(ch + (L'a' - L'A'));
+        }
+        return ch;
+    }
+    if (pattern->arabic_folding) {
+        switch (ch) {
+            case 0x0622:                            /* Alef with madda */
+            case 0x0623:                            /* Alef with hamza above */
+            case 0x0625:                            /* Alef with hamza below */
+            case 0x0671:                            /* Alef wasla */
+                return 0x0627;
+            case 0x0624:                            /* Waw with hamza */
+                return 0x0648;
+            case 0x0626:                            /* Yeh with hamza */
+                return 0x064A;
+            default:
+                break;
+        }
+    }
+    return ch;
+}
+
+/**
+ * @brief Collect the raw characters that fold to the pattern's first unit
+ */
+static void search_build_first_set(SearchPattern* pattern) {
+    wchar_t first = pattern->units[0];
+    size_t count = 0;
+
+    pattern->first_set[count++] = first;
+    if (pattern->ignore_case && first >= L'a' && first <= L'z') {
+        pattern->first_set[count++] = (wchar_t)(first - (L'a' - L'A'));
+    }
+    if (pattern->arabic_folding) {
+        if (first == 0x0627) {
+            pattern->first_set[count++] = 0x0622;
+            pattern->first_set[count++] = 0x0623;
+            pattern->first_set[count++] = 0x0625;
+            pattern->first_set[count++] = 0x0671;
+        } else if (first == 0x0648) {
+            pattern->first_set[count++] = 0x0624;
+        } else if (first == 0x064A) {
+            pattern->first_set[count++] = 0x0626;
+        }
+    }
+    pattern->first_count = count;
+}
+
+/*=============================================================================
+ * Internal Helper Functions - Scanning
+ *============================================================================*/
+
+static inline wchar_t search_window_at(const SearchWindow* window, size_t index) {
+    return index < window->head_length ? window->head[index]
+                                       : window->tail[index - window->head_length];
+}
+
+/**
+ * @brief Check for a match starting at a window position
+ *
+ * With Arabic folding, ignorable characters between the pattern's units
+ * are skipped, and harakat after the last one are part of the match.
+ */
+static SearchVerdict search_verify(const SearchPattern* pattern, const SearchWindow* window,
+                                   size_t pos, size_t* out_end) {
+    size_t i = pos;
+
+    for (size_t j = 0; j < pattern->length; j++, i++) {
+        if (pattern->arabic_folding && j > 0) {
+            while (i < window->length && search_is_ignorable(search_window_at(window, i))) {
+                i++;
+            }
+        }
+        if (i >= window->length) {
+            return window->at_end ? SEARCH_MISMATCH : SEARCH_UNDECIDED;
+        }
+        if (search_fold(pattern, search_window_at(window, i)) != pattern->units[j]) {
+            return SEARCH_MISMATCH;
+        }
+    }
+
+    if (pattern->arabic_folding) {
+        while (i < window->length && search_is_haraka(search_window_at(window, i))) {
+            i++;
+        }
+        if (i >= window->length && !window->at_end) {
+            return SEARCH_UNDECIDED;
+        }
+    }
+
+    *out_end = i;
+    return SEARCH_MATCH;
+}
+
+/**
+ * @brief Count scanned characters, polling the cancel callback now and then
+ *
+ * @return false if the scan was cancelled
+ */
+static inline bool search_scan_poll(SearchScan* scan, size_t scanned) {
+    scan->polled += scanned;
+    if (scan->polled < SEARCH_POLL_CHARS) {
+        return true;
+    }
+
+    scan->polled = 0;
+    if (scan->cancel && scan->cancel(scan->cancel_user_data)) {
+        scan->result = QALAM_ERROR_CANCELLED;
+        scan->done = true;
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Verify a candidate and report it if it matches
+ *
+ * @return Window position to continue from
+ */
+static size_t search_scan_try(SearchScan* scan, const SearchWindow* window, size_t base,
+                              size_t pos, bool* undecided) {
+    size_t end = 0;
+    switch (search_verify(scan->pattern, window, pos, &end)) {
+        case SEARCH_MATCH:
+            if (!scan->on_match(scan->context, base + pos, base + end)) {
+                scan->done = true;
+            }
+            return end;
+        case SEARCH_UNDECIDED:
+            *undecided = true;
+            return pos;
+        default:
+            return pos + 1;
+    }
+}
+
+/**
+ * @brief Try each position of the carry in turn
+ */
+static size_t search_scan_head(SearchScan* scan, const SearchWindow* window, size_t base,
+                               size_t stop, bool* undecided) {
+    const SearchPattern* pattern = scan->pattern;
+    size_t pos = 0;
+
+    while (pos < window->head_length && pos < stop && !scan->done && !*undecided) {
+        if (search_fold(pattern, window->head[pos]) != pattern->units[0]) {
+            pos++;
+            continue;
+        }
+        pos = search_scan_try(scan, window, base, pos, undecided);
+    }
+    return pos;
+}
+
+/**
+ * @brief Search the current run with Boyer-Moore-Horspool
+ *
+ * Windows that would run past the end of the run are left undecided.
+ */
+static size_t search_scan_bmh(SearchScan* scan, const SearchWindow* window, size_t base,
+                              size_t pos, size_t stop, bool* undecided) {
+    const SearchPattern* pattern = scan->pattern;
+    const wchar_t* text = window->tail;
+    size_t head = window->head_length;
+    size_t text_length = window->length - head;
+    size_t pattern_length = pattern->length;
+    wchar_t last = pattern->units[pattern_length - 1];
+    size_t shift = 0;
+
+    size_t i = pos - head;
+    while (head + i < stop && !scan->done) {
+        if (i + pattern_length > text_length) {
+            *undecided = true;
+            break;
+        }
+        if (!search_scan_poll(scan, shift)) {
+            break;
+        }
+
+        wchar_t ch = search_fold(pattern, text[i + pattern_length - 1]);
+        if (ch == last) {
+            size_t next = search_scan_try(scan, window, base, head + i, undecided);
+            if (next != head + i + 1) {
+                shift = next - (head + i);
+                i = next - head;
+                continue;
+            }
+        }
+        shift = pattern->shift[ch & 0xFF];
+        i += shift;
+    }
+    return head + i;
+}
+
+/**
+ * @brief Search the current run for first-character candidates
+ */
+static size_t search_scan_candidates(SearchScan* scan, const SearchWindow* window,
+                                     size_t base, size_t pos, size_t stop, bool* undecided) {
+    const SearchPattern* pattern = scan->pattern;
+    size_t head = window->head_length;
+
+    while (pos < stop && !scan->done && !*undecided) {
+        if (!search_scan_poll(scan, 0)) {
+            break;
+        }
+
+        size_t span = stop - pos;
+        if (span > SEARCH_POLL_CHARS) {
+            span = SEARCH_POLL_CHARS;
+        }
+        size_t found = text_find_any(window->tail + (pos - head), span,
+                                     pattern->first_set, pattern->first_count);
+        scan->polled += found;
+        if (found == span) {
+            pos += span;
+            continue;
+        }
+        pos = search_scan_try(scan, window, base, pos + found, undecided);
+    }
+    return pos;
+}
+
+/**
+ * @brief Keep the window from 'keep' onwards as the next carry
+ */
+static void search_scan_keep(SearchScan* scan, const SearchWindow* window, size_t keep) {
+    size_t length = window->length - keep;
+
+    if (length > scan->carry_capacity) {
+        size_t capacity = scan->carry_capacity ? scan->carry_capacity : SEARCH_CARRY_INITIAL;
+        while (capacity < length) {
+            capacity *= 2;
+        }
+        wchar_t* carry = (wchar_t*)qalam_mem_realloc(QALAM_MEMORY_BUFFER,
+                                                     scan->carry, capacity * sizeof(wchar_t));
+        if (!carry) {
+            scan->result = QALAM_ERROR_OUT_OF_MEMORY;
+            scan->done = true;
+            return;
+        }
+        scan->carry = carry;
+        scan->carry_capacity = capacity;
+    }
+
+    size_t head = window->head_length;
+    if (keep < head) {
+        memmove(scan->carry, scan->carry + keep, (head - keep) * sizeof(wchar_t));
+        memcpy(scan->carry + (head - keep), window->tail,
+               (window->length - head) * sizeof(wchar_t));
+    } else if (length > 0) {
+        memcpy(scan->carry, window->tail + (keep - head), length * sizeof(wchar_t));
+    }
+    scan->carry_length = length;
+    scan->carry_offset += keep;
+}
+
+/**
+ * @brief Report the matches in a window and decide what to carry over
+ */
+static void search_scan_window(SearchScan* scan, const SearchWindow* window) {
+    size_t base = scan->carry_offset;
+    size_t stop = scan->limit > base ? scan->limit - base : 0;
+    bool limited = stop <= window->length;
+    if (!limited) {
+        stop = window->length;
+    }
+
+    bool undecided = false;
+    size_t pos = search_scan_head(scan, window, base, stop, &undecided);
+    if (!scan->done && !undecided && pos < stop) {
+        pos = scan->pattern->use_bmh
+                  ? search_scan_bmh(scan, window, base, pos, stop, &undecided)
+                  : search_scan_candidates(scan, window, base, pos, stop, &undecided);
+    }
+
+    if (scan->done) {
+        return;
+    }
+    if (undecided) {
+        search_scan_keep(scan, window, pos);
+    } else if (limited || window->at_end) {
+        scan->done = true;
+    } else {
+        search_scan_keep(scan, window, window->length);
+    }
+}
+
+/*=============================================================================
+ * Patterns
+ *============================================================================*/
+
+QalamResult search_pattern_compile(SearchPattern* pattern, const wchar_t* text, size_t length,
+                                   bool ignore_case, bool arabic_folding) {
+    if (!pattern || (!text && length > 0)) {
+        return QALAM_ERROR_NULL_POINTER;
+    }
+
+    pattern->length = 0;
+    if (length == 0) {
+        return QALAM_ERROR_INVALID_ARGUMENT;
+    }
+
+    if (length > pattern->capacity) {
+        wchar_t* units = (wchar_t*)qalam_mem_realloc(QALAM_MEMORY_BUFFER,
+                                                     pattern->units, length * sizeof(wchar_t));
+        if (!units) {
+            return QALAM_ERROR_OUT_OF_MEMORY;
+        }
+        pattern->units = units;
+        pattern->capacity = length;
+    }
+
+    pattern->ignore_case = ignore_case;
+    pattern->arabic_folding = arabic_folding;
+
+    size_t count = 0;
+    for (size_t i = 0; i < length; i++) {
+        if (arabic_folding && search_is_ignorable(text[i])) {
+            continue;
+        }
+        pattern->units[count++] = search_fold(pattern, text[i]);
+    }
+    if (count == 0) {
+        return QALAM_ERROR_INVALID_ARGUMENT;
+    }
+    pattern->length = count;
+
+    search_build_first_set(pattern);
+
+    /* Folding can change a match's length, which BMH windows cannot follow */
+    pattern->use_bmh = !arabic_folding && count >= SEARCH_BMH_MIN_LENGTH;
+    if (pattern->use_bmh) {
+        for (size_t k = 0; k < 256; k++) {
+            pattern->shift[k] = count;
+        }
+        for (size_t i = 0; i + 1 < count; i++) {
+            pattern->shift[pattern->units[i] & 0xFF] = count - 1 - i;
+        }
+    }
+    return QALAM_OK;
+}
+
+void search_pattern_free(SearchPattern* pattern) {
+    if (!pattern) {
+        return;
+    }
+    qalam_mem_free(pattern->units);
+    memset(pattern, 0, sizeof(SearchPattern));
+}
+
+/*=============================================================================
+ * Scanning
+ *============================================================================*/
+
+void search_scan_init(SearchScan* scan, const SearchPattern* pattern, size_t start,
+                      size_t limit, SearchMatchFn on_match, void* context,
+                      const QalamSearchOptions* options) {
+    memset(scan, 0, sizeof(SearchScan));
+    scan->pattern = pattern;
+    scan->limit = limit;
+    scan->on_match = on_match;
+    scan->context = context;
+    scan->carry_offset = start;
+    scan->result = QALAM_OK;
+    if (options) {
+        scan->cancel = options->cancel;
+        scan->cancel_user_data = options->cancel_user_data;
+    }
+    /* Poll before the first character, so a pending cancel is seen at once */
+    scan->polled = SEARCH_POLL_CHARS;
+    scan->done = !pattern || pattern->length == 0 || start >= limit;
+}
+
+bool search_scan_feed(SearchScan* scan, const wchar_t* text, size_t length) {
+    if (scan->done) {
+        return false;
+    }
+    if (length == 0) {
+        return true;
+    }
+
+    SearchWindow window = { scan->carry, scan->carry_length, text,
+                            scan->carry_length + length, false };
+    search_scan_window(scan, &window);
+    return !scan->done;
+}
+
+void search_scan_finish(SearchScan* scan) {
+    if (scan->done) {
+        return;
+    }
+
+    SearchWindow window = { scan->carry, scan->carry_length, NULL, scan->carry_length, true };
+    search_scan_window(scan, &window);
+    scan->done = true;
+}
+
+void search_scan_free(SearchScan* scan) {
+    if (!scan) {
+        return;
+    }
+    qalam_mem_free(scan->carry);
+    scan->carry = NULL;
+    scan->carry_length = 0;
+    scan->carry_capacity = 0;
+}
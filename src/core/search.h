@@ -0,0 +1,152 @@
+/**
+ * @file search.h
+ * @brief Qalam IDE - Text Search Engine (Internal Header)
+ *
+ * Internal header for the search behind qalam_buffer_find(). A pattern
+ * is compiled once into folded UTF-16 units; a scan then consumes the
+ * document as a sequence of contiguous runs (the two sides of a gap, or
+ * the pieces of a piece table) straight from storage.
+ *
+ * Within a run, patterns of SEARCH_BMH_MIN_LENGTH units or more are
+ * found with Boyer-Moore-Horspool; shorter patterns, and every pattern
+ * when Arabic folding is on, locate candidates with the vectorized
+ * text_find_any() and verify them in place. Only a match that may cross
+ * into the next run is held back: the few characters from its start are
+ * copied to a small carry, so runs need not stay valid after they have
+ * been fed (as with decoded chunks of a mapped file).
+ *
+ * @version 0.0.2
+ * @copyright (c) 2026 Qalam Project
+ *
+ * @note Thread Safety: Not thread-safe. Each scan is owned by one caller.
+ */
+
+#ifndef QALAM_SEARCH_H
+#define QALAM_SEARCH_H
+
+#include "qalam.h"
+#include "editor.h"
+#include "text_scan.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*=============================================================================
+ * Search Structures
+ *============================================================================*/
+
+/** Shortest pattern searched with Boyer-Moore-Horspool */
+#define SEARCH_BMH_MIN_LENGTH       4
+
+/** Characters scanned between polls of the cancel callback */
+#define SEARCH_POLL_CHARS           (64 * 1024)
+
+/**
+ * @brief Compiled search pattern
+ */
+typedef struct SearchPattern {
+    wchar_t* units;                 /**< Folded pattern */
+    size_t length;                  /**< Folded length (0 until compiled) */
+    size_t capacity;                /**< Allocated units */
+    bool ignore_case;               /**< Fold A-Z onto a-z */
+    bool arabic_folding;            /**< Skip harakat/tatweel, fold alef/hamza forms */
+    bool use_bmh;                   /**< Boyer-Moore-Horspool rather than candidate scan */
+    wchar_t first_set[TEXT_SCAN_MAX_SET]; /**< Raw characters folding to units[0] */
+    size_t first_count;             /**< Characters in 'first_set' */
+    size_t shift[256];              /**< BMH shifts, by low byte of a folded character */
+} SearchPattern;
+
+/**
+ * @brief Callback for each match of a scan
+ *
+ * @return true to continue, false to stop the scan
+ */
+typedef bool (*SearchMatchFn)(void* context, size_t start, size_t end);
+
+/**
+ * @brief State of one pass over the document
+ */
+typedef struct SearchScan {
+    const SearchPattern* pattern;   /**< Pattern to find */
+    size_t limit;                   /**< Matches must start before this offset */
+    SearchMatchFn on_match;         /**< Match callback */
+    void* context;                  /**< Context for 'on_match' */
+    QalamSearchCancelCallback cancel; /**< Polled while scanning, or NULL */
+    void* cancel_user_data;         /**< Context for 'cancel' */
+    wchar_t* carry;                 /**< Text from the first undecided position */
+    size_t carry_length;            /**< Characters in 'carry' */
+    size_t carry_capacity;          /**< Allocated carry */
+    size_t carry_offset;            /**< Document offset of carry[0] */
+    size_t polled;                  /**< Characters scanned since the last poll */
+    bool done;                      /**< Stopped, cancelled, or past the limit */
+    QalamResult result;             /**< QALAM_OK, or why the scan failed */
+} SearchScan;
+
+/*=============================================================================
+ * Patterns
+ *============================================================================*/
+
+/**
+ * @brief Compile a pattern, reusing the allocation of a previous one
+ *
+ * @param pattern Pattern to compile into (zeroed, or previously compiled)
+ * @param text Pattern text in UTF-16
+ * @param length Length of 'text'
+ * @param ignore_case Fold A-Z onto a-z
+ * @param arabic_folding Skip harakat/tatweel, fold alef/hamza forms
+ * @return QALAM_OK on success, QALAM_ERROR_INVALID_ARGUMENT if nothing
+ *         is left after folding, QALAM_ERROR_OUT_OF_MEMORY on failure
+ */
+QalamResult search_pattern_compile(SearchPattern* pattern, const wchar_t* text, size_t length,
+                                   bool ignore_case, bool arabic_folding);
+
+/**
+ * @brief Release a compiled pattern
+ */
+void search_pattern_free(SearchPattern* pattern);
+
+/*=============================================================================
+ * Scanning
+ *============================================================================*/
+
+/**
+ * @brief Start a pass that reports matches starting in [start, limit)
+ *
+ * @param scan Scan to initialize
+ * @param pattern Compiled pattern (must outlive the scan)
+ * @param start Document offset of the first run to be fed
+ * @param limit Matches must start before this offset
+ * @param on_match Match callback
+ * @param context Context for 'on_match'
+ * @param options Cancel callback (NULL for none)
+ */
+void search_scan_init(SearchScan* scan, const SearchPattern* pattern, size_t start,
+                      size_t limit, SearchMatchFn on_match, void* context,
+                      const QalamSearchOptions* options);
+
+/**
+ * @brief Scan the next run of the document
+ *
+ * Matches are reported in order and do not overlap. The run is not
+ * referenced after the call returns.
+ *
+ * @return false once the scan is done and needs no more text
+ */
+bool search_scan_feed(SearchScan* scan, const wchar_t* text, size_t length);
+
+/**
+ * @brief Resolve matches held back at the end of the document
+ */
+void search_scan_finish(SearchScan* scan);
+
+/**
+ * @brief Release the scan's carry
+ */
+void search_scan_free(SearchScan* scan);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* QALAM_SEARCH_H */
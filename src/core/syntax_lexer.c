@@ -0,0 +1,300 @@
+/**
+ * @file syntax_lexer.c
+ * @brief Qalam IDE - Baa Line Lexer Implementation
+ *
+ * Baa is written in Arabic: identifiers and keywords are Arabic words,
+ * numbers may use Arabic-Indic digits and the Arabic decimal separator,
+ * and the Arabic comma and semicolon are punctuation like their ASCII
+ * counterparts. Comments, strings and character literals follow C.
+ *
+ * A block comment is the only construct that reaches past the end of a
+ * line; strings and character literals left open end with their line.
+ *
+ * @version 0.0.2
+ * @copyright (c) 2026 Qalam Project
+ *
+ * @note Thread Safety: See syntax_lexer.h.
+ */
+
+#include "syntax_lexer.h"
+#include <string.h>
+
+/** Initial capacity of a range list */
+#define SYNTAX_RANGES_INITIAL   64
+
+/*=============================================================================
+ * Word Tables
+ *============================================================================*/
+
+/**
+ * @brief A reserved word and its style
+ */
+typedef struct SyntaxWord {
+    const wchar_t* text;
+    size_t length;
+    QalamSyntaxStyle style;
+} SyntaxWord;
+
+#define SYNTAX_WORD(text, style) { text, sizeof(text) / sizeof(wchar_t) - 1, style }
+
+static const SyntaxWord g_words[] = {
+    /* Control flow */
+    SYNTAX_WORD(L"إذا", QALAM_SYNTAX_KEYWORD),
+    SYNTAX_WORD(L"وإلا", QALAM_SYNTAX_KEYWORD),
+    SYNTAX_WORD(L"طالما", QALAM_SYNTAX_KEYWORD),
+    SYNTAX_WORD(L"لكل", QALAM_SYNTAX_KEYWORD),
+    SYNTAX_WORD(L"توقف", QALAM_SYNTAX_KEYWORD),
+    SYNTAX_WORD(L"استمر", QALAM_SYNTAX_KEYWORD),
+    SYNTAX_WORD(L"إرجع", QALAM_SYNTAX_KEYWORD),
+    SYNTAX_WORD(L"اختر", QALAM_SYNTAX_KEYWORD),
+    SYNTAX_WORD(L"حالة", QALAM_SYNTAX_KEYWORD),
+    SYNTAX_WORD(L"افتراضي", QALAM_SYNTAX_KEYWORD),
+
+    /* Types */
+    SYNTAX_WORD(L"صحيح", QALAM_SYNTAX_TYPE),
+    SYNTAX_WORD(L"نص", QALAM_SYNTAX_TYPE),
+    SYNTAX_WORD(L"حرف", QALAM_SYNTAX_TYPE),
+
+    /* Values */
+    SYNTAX_WORD(L"صواب", QALAM_SYNTAX_CONSTANT),
+    SYNTAX_WORD(L"خطأ", QALAM_SYNTAX_CONSTANT),
+    SYNTAX_WORD(L"عدم", QALAM_SYNTAX_CONSTANT),
+
+    /* Built-in functions */
+    SYNTAX_WORD(L"اطبع", QALAM_SYNTAX_BUILTIN),
+    SYNTAX_WORD(L"الرئيسية", QALAM_SYNTAX_BUILTIN),
+};
+
+/*=============================================================================
+ * Internal Helper Functions - Character Classes
+ *============================================================================*/
+
+static bool lexer_is_space(wchar_t c) {
+    return c == L' ' || c == L'\t' || c == L'\r' || c == L'\f' || c == L'\v' || c == 0x00A0;
+}
+
+static bool lexer_is_digit(wchar_t c) {
+    return (c >= L'0' && c <= L'9') ||
+           (c >= 0x0660 && c <= 0x0669) ||      /* Arabic-Indic */
+           (c >= 0x06F0 && c <= 0x06F9);        /* Extended Arabic-Indic */
+}
+
+static bool lexer_is_arabic_letter(wchar_t c) {
+    return (c >= 0x0621 && c <= 0x065F) ||      /* Letters, tatweel and harakat */
+           c == 0x0670 ||
+           (c >= 0x0671 && c <= 0x06D3) ||
+           c == 0x06D5 ||
+           (c >= 0x06E5 && c <= 0x06E6) ||
+           (c >= 0x06EE && c <= 0x06EF) ||
+           (c >= 0x06FA && c <= 0x06FC) ||
+           (c >= 0x0750 && c <= 0x077F) ||      /* Arabic Supplement */
+           (c >= 0xFB50 && c <= 0xFDFF) ||      /* Presentation Forms-A */
+           (c >= 0xFE70 && c <= 0xFEFC);        /* Presentation Forms-B */
+}
+
+static bool lexer_is_word_start(wchar_t c) {
+    return (c >= L'a' && c <= L'z') || (c >= L'A' && c <= L'Z') || c == L'_' ||
+           lexer_is_arabic_letter(c);
+}
+
+static bool lexer_is_word_part(wchar_t c) {
+    /* Joiners keep a word together wherever the writer placed them */
+    return lexer_is_word_start(c) || lexer_is_digit(c) || c == 0x200C || c == 0x200D;
+}
+
+static bool lexer_is_operator(wchar_t c) {
+    switch (c) {
+        case L'+': case L'-': case L'*': case L'/': case L'%':
+        case L'=': case L'<': case L'>': case L'!':
+        case L'&': case L'|': case L'^': case L'~':
+        case 0x066A:                            /* Arabic percent sign */
+            return true;
+        default:
+            return false;
+    }
+}
+
+/*=============================================================================
+ * Internal Helper Functions - Ranges
+ *============================================================================*/
+
+static QalamResult lexer_emit(SyntaxRangeList* list, size_t start, size_t end,
+                              QalamSyntaxStyle style) {
+    if (end <= start) {
+        return QALAM_OK;
+    }
+
+    if (list->count == list->capacity) {
+        size_t capacity = list->capacity ? list->capacity * 2 : SYNTAX_RANGES_INITIAL;
+        QalamStyleRange* ranges = (QalamStyleRange*)qalam_mem_realloc(
+            QALAM_MEMORY_SYNTAX, list->ranges, capacity * sizeof(QalamStyleRange));
+        if (!ranges) {
+            return QALAM_ERROR_OUT_OF_MEMORY;
+        }
+        list->ranges = ranges;
+        list->capacity = capacity;
+    }
+
+    QalamStyleRange* range = &list->ranges[list->count++];
+    range->start = (uint32_t)start;
+    range->length = (uint32_t)(end - start);
+    range->style = (uint32_t)style;
+    return QALAM_OK;
+}
+
+/**
+ * @brief Find the end of a block comment
+ *
+ * @return Offset just past its closing delimiter, or 'length' if the
+ *         comment goes on past the line (with *closed false)
+ */
+static size_t lexer_comment_end(const wchar_t* text, size_t length, size_t from, bool* closed) {
+    for (size_t i = from; i + 1 < length; i++) {
+        if (text[i] == L'*' && text[i + 1] == L'/') {
+            *closed = true;
+            return i + 2;
+        }
+    }
+    *closed = false;
+    return length;
+}
+
+/**
+ * @brief Find the end of a string or character literal opened at 'from'
+ */
+static size_t lexer_quote_end(const wchar_t* text, size_t length, size_t from) {
+    wchar_t quote = text[from];
+    for (size_t i = from + 1; i < length; i++) {
+        if (text[i] == L'\\') {
+            i++;
+        } else if (text[i] == quote) {
+            return i + 1;
+        }
+    }
+    return length;
+}
+
+/**
+ * @brief Find the end of a number (digits, hex letters, a decimal point)
+ */
+static size_t lexer_number_end(const wchar_t* text, size_t length, size_t from) {
+    size_t i = from;
+    while (i < length) {
+        wchar_t c = text[i];
+        bool point = (c == L'.' || c == 0x066B) && i + 1 < length && lexer_is_digit(text[i + 1]);
+        if (!lexer_is_digit(c) && !point && !(c < 0x80 && lexer_is_word_start(c))) {
+            break;
+        }
+        i++;
+    }
+    return i;
+}
+
+static QalamSyntaxStyle lexer_word_style(const wchar_t* word, size_t length) {
+    for (size_t i = 0; i < sizeof(g_words) / sizeof(g_words[0]); i++) {
+        if (g_words[i].length == length &&
+            memcmp(g_words[i].text, word, length * sizeof(wchar_t)) == 0) {
+            return g_words[i].style;
+        }
+    }
+    return QALAM_SYNTAX_PLAIN;
+}
+
+/*=============================================================================
+ * Lexing
+ *============================================================================*/
+
+QalamResult syntax_lex_line(const wchar_t* text, size_t length, uint32_t state,
+                            SyntaxRangeList* list, uint32_t* end_state) {
+    if ((!text && length > 0) || !list || !end_state) {
+        return QALAM_ERROR_NULL_POINTER;
+    }
+
+    QalamResult result = QALAM_OK;
+    size_t i = 0;
+    bool line_start = true;
+
+    if (state == SYNTAX_STATE_BLOCK_COMMENT) {
+        bool closed;
+        i = lexer_comment_end(text, length, 0, &closed);
+        result = lexer_emit(list, 0, i, QALAM_SYNTAX_COMMENT);
+        if (!closed) {
+            *end_state = SYNTAX_STATE_BLOCK_COMMENT;
+            return result;
+        }
+        line_start = false;
+    }
+
+    state = SYNTAX_STATE_NORMAL;
+    while (i < length && result == QALAM_OK) {
+        wchar_t c = text[i];
+        wchar_t next = i + 1 < length ? text[i + 1] : 0;
+        size_t end;
+
+        if (lexer_is_space(c)) {
+            i++;
+            continue;
+        }
+
+        if (c == L'/' && next == L'/') {
+            result = lexer_emit(list, i, length, QALAM_SYNTAX_COMMENT);
+            break;
+        }
+
+        if (c == L'/' && next == L'*') {
+            bool closed;
+            end = lexer_comment_end(text, length, i + 2, &closed);
+            result = lexer_emit(list, i, end, QALAM_SYNTAX_COMMENT);
+            if (!closed) {
+                state = SYNTAX_STATE_BLOCK_COMMENT;
+            }
+        } else if (c == L'"' || c == L'\'') {
+            end = lexer_quote_end(text, length, i);
+            result = lexer_emit(list, i, end,
+                                c == L'"' ? QALAM_SYNTAX_STRING : QALAM_SYNTAX_CHAR);
+        } else if (c == L'#' && line_start) {
+            end = i + 1;
+            while (end < length && lexer_is_word_part(text[end])) {
+                end++;
+            }
+            result = lexer_emit(list, i, end, QALAM_SYNTAX_PREPROCESSOR);
+        } else if (lexer_is_digit(c)) {
+            end = lexer_number_end(text, length, i);
+            result = lexer_emit(list, i, end, QALAM_SYNTAX_NUMBER);
+        } else if (lexer_is_word_start(c)) {
+            end = i + 1;
+            while (end < length && lexer_is_word_part(text[end])) {
+                end++;
+            }
+            QalamSyntaxStyle style = lexer_word_style(text + i, end - i);
+            if (style != QALAM_SYNTAX_PLAIN) {
+                result = lexer_emit(list, i, end, style);
+            }
+        } else if (lexer_is_operator(c)) {
+            end = i + 1;
+            while (end < length && lexer_is_operator(text[end]) &&
+                   !(text[end] == L'/' && end + 1 < length &&
+                     (text[end + 1] == L'/' || text[end + 1] == L'*'))) {
+                end++;
+            }
+            result = lexer_emit(list, i, end, QALAM_SYNTAX_OPERATOR);
+        } else {
+            /* Punctuation and anything else stays plain */
+            end = i + 1;
+        }
+
+        i = end;
+        line_start = false;
+    }
+
+    *end_state = state;
+    return result;
+}
+
+void syntax_range_list_free(SyntaxRangeList* list) {
+    if (!list) {
+        return;
+    }
+    qalam_mem_free(list->ranges);
+    memset(list, 0, sizeof(SyntaxRangeList));
+}
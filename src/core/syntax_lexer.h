@@ -0,0 +1,86 @@
+/**
+ * @file syntax_lexer.h
+ * @brief Qalam IDE - Baa Line Lexer (Internal Header)
+ *
+ * Internal header for the lexer behind the syntax highlighter. It lexes
+ * one line at a time: the only thing a line takes from the lines above
+ * it is the state the previous line ended in, so a highlighter that
+ * keeps each line's end state can start lexing at any line and stop
+ * as soon as a line ends in the state it ended in before.
+ *
+ * Only styled text produces ranges; plain identifiers, punctuation and
+ * whitespace are left out, so most lines carry a handful of ranges.
+ *
+ * @version 0.0.2
+ * @copyright (c) 2026 Qalam Project
+ *
+ * @note Thread Safety: All functions are thread-safe; a range list
+ *       belongs to its caller.
+ */
+
+#ifndef QALAM_SYNTAX_LEXER_H
+#define QALAM_SYNTAX_LEXER_H
+
+#include "qalam.h"
+#include "editor.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*=============================================================================
+ * Lexer States
+ *============================================================================*/
+
+/** Start of the file, or a line that began outside any construct */
+#define SYNTAX_STATE_NORMAL         0u
+
+/** Inside a block comment */
+#define SYNTAX_STATE_BLOCK_COMMENT  1u
+
+/*=============================================================================
+ * Lexer Structures
+ *============================================================================*/
+
+/**
+ * @brief Growable list of style ranges
+ *
+ * Ranges of consecutive lines are appended to the same list; callers
+ * remember where each line's ranges end.
+ */
+typedef struct SyntaxRangeList {
+    QalamStyleRange* ranges;        /**< Ranges, ordered by line and start */
+    size_t count;                   /**< Ranges in use */
+    size_t capacity;                /**< Allocated entries */
+} SyntaxRangeList;
+
+/*=============================================================================
+ * Lexing
+ *============================================================================*/
+
+/**
+ * @brief Lex one line and append its style ranges
+ *
+ * @param text Line text without its newline (UTF-16)
+ * @param length Length of the line
+ * @param state State the previous line ended in
+ * @param list List to append the ranges to
+ * @param[out] end_state Receives the state the line ends in
+ * @return QALAM_OK on success, QALAM_ERROR_OUT_OF_MEMORY if the list
+ *         could not grow (the line's ranges are then incomplete)
+ */
+QalamResult syntax_lex_line(const wchar_t* text, size_t length, uint32_t state,
+                            SyntaxRangeList* list, uint32_t* end_state);
+
+/**
+ * @brief Free a range list's storage
+ *
+ * @param list List to empty (may be NULL)
+ */
+void syntax_range_list_free(SyntaxRangeList* list);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* QALAM_SYNTAX_LEXER_H */
@@ -0,0 +1,546 @@
+/**
+ * @file text_scan.c
+ * @brief Qalam IDE - Vectorized Text Scanning Kernels Implementation
+ *
+ * The SSE2 and AVX2 kernels compare 8 or 16 UTF-16 units per step.
+ * Newline counts are accumulated in 16-bit lanes and folded into a
+ * size_t before a lane can overflow; range checks use a wrapping
+ * subtract followed by a saturating one, since SSE2 has no unsigned
+ * 16-bit compare. Leftover characters at the end of a span go through
+ * the scalar code, so every level produces identical results.
+ *
+ * text_find_control() works on bytes, 16 or 32 per step. Controls are
+ * found with a saturating subtract (x - 0x1F is zero only for x <= 0x1F,
+ * read unsigned) and a compare with DEL.
+ *
+ * @version 0.0.2
+ * @copyright (c) 2026 Qalam Project
+ *
+ * @note Thread Safety: Functions in this file are thread-safe.
+ */
+
+#include "text_scan.h"
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define TEXT_SCAN_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#define TEXT_SCAN_TARGET_SSE2
+#define TEXT_SCAN_TARGET_AVX2
+#else
+#define TEXT_SCAN_TARGET_SSE2 __attribute__((target("sse2")))
+#define TEXT_SCAN_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+
+/** Vector steps before 16-bit newline counters are folded (signed madd limit) */
+#define TEXT_SCAN_MAX_STEPS         32767
+
+/*=============================================================================
+ * Scalar Kernels
+ *============================================================================*/
+
+/**
+ * @brief Check whether a character is in one of the RTL blocks
+ */
+static inline bool text_is_rtl(wchar_t ch) {
+    return (ch >= 0x0590 && ch <= 0x06FF) ||   /* Hebrew, Arabic */
+           (ch >= 0x0750 && ch <= 0x077F) ||   /* Arabic Supplement */
+           (ch >= 0x08A0 && ch <= 0x08FF) ||   /* Arabic Extended-A */
+           (ch >= 0xFB50 && ch <= 0xFDFF) ||   /* Arabic Presentation Forms-A */
+           (ch >= 0xFE70 && ch <= 0xFEFF);     /* Arabic Presentation Forms-B */
+}
+
+/**
+ * @brief Check whether a character is a Latin letter
+ */
+static inline bool text_is_ltr(wchar_t ch) {
+    return (ch >= 0x0041 && ch <= 0x005A) ||   /* A-Z */
+           (ch >= 0x0061 && ch <= 0x007A);     /* a-z */
+}
+
+static size_t text_count_newlines_scalar(const wchar_t* text, size_t length) {
+    size_t count = 0;
+    for (size_t i = 0; i < length; i++) {
+        count += text[i] == L'\n';
+    }
+    return count;
+}
+
+static size_t text_find_newline_scalar(const wchar_t* text, size_t length) {
+    for (size_t i = 0; i < length; i++) {
+        if (text[i] == L'\n') {
+            return i;
+        }
+    }
+    return length;
+}
+
+static size_t text_find_any_scalar(const wchar_t* text, size_t length,
+                                   const wchar_t* set, size_t set_count) {
+    for (size_t i = 0; i < length; i++) {
+        for (size_t k = 0; k < set_count; k++) {
+            if (text[i] == set[k]) {
+                return i;
+            }
+        }
+    }
+    return length;
+}
+
+/**
+ * @brief Check whether a byte is a C0 control or DEL
+ */
+static inline bool text_is_control(char ch) {
+    return (unsigned char)ch < 0x20 || ch == 0x7F;
+}
+
+static size_t text_find_control_scalar(const char* text, size_t length) {
+    for (size_t i = 0; i < length; i++) {
+        if (text_is_control(text[i])) {
+            return i;
+        }
+    }
+    return length;
+}
+
+/**
+ * @brief Classify a span, continuing from flags already found
+ */
+static unsigned int text_classify_bidi_from(const wchar_t* text, size_t length,
+                                            unsigned int flags) {
+    for (size_t i = 0; i < length && flags != (TEXT_BIDI_RTL | TEXT_BIDI_LTR); i++) {
+        if (text_is_rtl(text[i])) {
+            flags |= TEXT_BIDI_RTL;
+        } else if (text_is_ltr(text[i])) {
+            flags |= TEXT_BIDI_LTR;
+        }
+    }
+    return flags;
+}
+
+static unsigned int text_classify_bidi_scalar(const wchar_t* text, size_t length) {
+    return text_classify_bidi_from(text, length, 0);
+}
+
+#ifdef TEXT_SCAN_X86
+
+/*=============================================================================
+ * SSE2 Kernels
+ *============================================================================*/
+
+/**
+ * @brief Index of the lowest set bit (mask must be non-zero)
+ */
+static inline unsigned int text_lowest_bit(unsigned int mask) {
+#if defined(_MSC_VER) && !defined(__clang__)
+    unsigned long index;
+    _BitScanForward(&index, mask);
+    return (unsigned int)index;
+#else
+    return (unsigned int)__builtin_ctz(mask);
+#endif
+}
+
+/**
+ * @brief Sum the four 32-bit lanes of a vector
+ */
+TEXT_SCAN_TARGET_SSE2
+static inline size_t text_sum_epi32_sse2(__m128i v) {
+    v = _mm_add_epi32(v, _mm_shuffle_epi32(v, _MM_SHUFFLE(1, 0, 3, 2)));
+    v = _mm_add_epi32(v, _mm_shuffle_epi32(v, _MM_SHUFFLE(2, 3, 0, 1)));
+    return (size_t)(unsigned int)_mm_cvtsi128_si32(v);
+}
+
+/**
+ * @brief Lanes of 'x' in [lo, hi] become all ones
+ */
+TEXT_SCAN_TARGET_SSE2
+static inline __m128i text_in_range_sse2(__m128i x, wchar_t lo, wchar_t hi) {
+    __m128i offset = _mm_sub_epi16(x, _mm_set1_epi16((short)lo));
+    __m128i excess = _mm_subs_epu16(offset, _mm_set1_epi16((short)(hi - lo)));
+    return _mm_cmpeq_epi16(excess, _mm_setzero_si128());
+}
+
+TEXT_SCAN_TARGET_SSE2
+static size_t text_count_newlines_sse2(const wchar_t* text, size_t length) {
+    const __m128i newline = _mm_set1_epi16(L'\n');
+    const __m128i ones = _mm_set1_epi16(1);
+    size_t count = 0;
+    size_t i = 0;
+
+    while (length - i >= 8) {
+        size_t steps = (length - i) / 8;
+        if (steps > TEXT_SCAN_MAX_STEPS) {
+            steps = TEXT_SCAN_MAX_STEPS;
+        }
+
+        /* Matches are all ones (-1), so subtracting counts them per lane */
+        __m128i lanes = _mm_setzero_si128();
+        for (size_t s = 0; s < steps; s++, i += 8) {
+            __m128i chars = _mm_loadu_si128((const __m128i*)(text + i));
+            lanes = _mm_sub_epi16(lanes, _mm_cmpeq_epi16(chars, newline));
+        }
+        count += text_sum_epi32_sse2(_mm_madd_epi16(lanes, ones));
+    }
+
+    return count + text_count_newlines_scalar(text + i, length - i);
+}
+
+TEXT_SCAN_TARGET_SSE2
+static size_t text_find_newline_sse2(const wchar_t* text, size_t length) {
+    const __m128i newline = _mm_set1_epi16(L'\n');
+    size_t i = 0;
+
+    for (; length - i >= 8; i += 8) {
+        __m128i chars = _mm_loadu_si128((const __m128i*)(text + i));
+        unsigned int mask = (unsigned int)_mm_movemask_epi8(_mm_cmpeq_epi16(chars, newline));
+        if (mask) {
+            return i + text_lowest_bit(mask) / 2;
+        }
+    }
+
+    return i + text_find_newline_scalar(text + i, length - i);
+}
+
+TEXT_SCAN_TARGET_SSE2
+static size_t text_find_any_sse2(const wchar_t* text, size_t length,
+                                 const wchar_t* set, size_t set_count) {
+    __m128i values[TEXT_SCAN_MAX_SET];
+    for (size_t k = 0; k < set_count; k++) {
+        values[k] = _mm_set1_epi16((short)set[k]);
+    }
+    size_t i = 0;
+
+    for (; length - i >= 8; i += 8) {
+        __m128i chars = _mm_loadu_si128((const __m128i*)(text + i));
+        __m128i hits = _mm_cmpeq_epi16(chars, values[0]);
+        for (size_t k = 1; k < set_count; k++) {
+            hits = _mm_or_si128(hits, _mm_cmpeq_epi16(chars, values[k]));
+        }
+        unsigned int mask = (unsigned int)_mm_movemask_epi8(hits);
+        if (mask) {
+            return i + text_lowest_bit(mask) / 2;
+        }
+    }
+
+    return i + text_find_any_scalar(text + i, length - i, set, set_count);
+}
+
+TEXT_SCAN_TARGET_SSE2
+static unsigned int text_classify_bidi_sse2(const wchar_t* text, size_t length) {
+    const __m128i case_bit = _mm_set1_epi16(0x20);
+    unsigned int flags = 0;
+    size_t i = 0;
+
+    for (; length - i >= 8; i += 8) {
+        __m128i chars = _mm_loadu_si128((const __m128i*)(text + i));
+
+        __m128i rtl = text_in_range_sse2(chars, 0x0590, 0x06FF);
+        rtl = _mm_or_si128(rtl, text_in_range_sse2(chars, 0x0750, 0x077F));
+        rtl = _mm_or_si128(rtl, text_in_range_sse2(chars, 0x08A0, 0x08FF));
+        rtl = _mm_or_si128(rtl, text_in_range_sse2(chars, 0xFB50, 0xFDFF));
+        rtl = _mm_or_si128(rtl, text_in_range_sse2(chars, 0xFE70, 0xFEFF));
+
+        /* Setting bit 5 folds A-Z onto a-z */
+        __m128i ltr = text_in_range_sse2(_mm_or_si128(chars, case_bit), 0x0061, 0x007A);
+
+        if (_mm_movemask_epi8(rtl)) {
+            flags |= TEXT_BIDI_RTL;
+        }
+        if (_mm_movemask_epi8(ltr)) {
+            flags |= TEXT_BIDI_LTR;
+        }
+        if (flags == (TEXT_BIDI_RTL | TEXT_BIDI_LTR)) {
+            return flags;
+        }
+    }
+
+    return text_classify_bidi_from(text + i, length - i, flags);
+}
+
+TEXT_SCAN_TARGET_SSE2
+static size_t text_find_control_sse2(const char* text, size_t length) {
+    const __m128i last_c0 = _mm_set1_epi8(0x1F);
+    const __m128i del = _mm_set1_epi8(0x7F);
+    const __m128i zero = _mm_setzero_si128();
+    size_t i = 0;
+
+    for (; length - i >= 16; i += 16) {
+        __m128i bytes = _mm_loadu_si128((const __m128i*)(text + i));
+        __m128i c0 = _mm_cmpeq_epi8(_mm_subs_epu8(bytes, last_c0), zero);
+        __m128i hits = _mm_or_si128(c0, _mm_cmpeq_epi8(bytes, del));
+        unsigned int mask = (unsigned int)_mm_movemask_epi8(hits);
+        if (mask) {
+            return i + text_lowest_bit(mask);
+        }
+    }
+
+    return i + text_find_control_scalar(text + i, length - i);
+}
+
+/*=============================================================================
+ * AVX2 Kernels
+ *============================================================================*/
+
+/**
+ * @brief Lanes of 'x' in [lo, hi] become all ones
+ */
+TEXT_SCAN_TARGET_AVX2
+static inline __m256i text_in_range_avx2(__m256i x, wchar_t lo, wchar_t hi) {
+    __m256i offset = _mm256_sub_epi16(x, _mm256_set1_epi16((short)lo));
+    __m256i excess = _mm256_subs_epu16(offset, _mm256_set1_epi16((short)(hi - lo)));
+    return _mm256_cmpeq_epi16(excess, _mm256_setzero_si256());
+}
+
+TEXT_SCAN_TARGET_AVX2
+static size_t text_count_newlines_avx2(const wchar_t* text, size_t length) {
+    const __m256i newline = _mm256_set1_epi16(L'\n');
+    const __m256i ones = _mm256_set1_epi16(1);
+    size_t count = 0;
+    size_t i = 0;
+
+    while (length - i >= 16) {
+        size_t steps = (length - i) / 16;
+        if (steps > TEXT_SCAN_MAX_STEPS) {
+            steps = TEXT_SCAN_MAX_STEPS;
+        }
+
+        __m256i lanes = _mm256_setzero_si256();
+        for (size_t s = 0; s < steps; s++, i += 16) {
+            __m256i chars = _mm256_loadu_si256((const __m256i*)(text + i));
+            lanes = _mm256_sub_epi16(lanes, _mm256_cmpeq_epi16(chars, newline));
+        }
+
+        __m256i sums = _mm256_madd_epi16(lanes, ones);
+        __m128i folded = _mm_add_epi32(_mm256_castsi256_si128(sums),
+                                       _mm256_extracti128_si256(sums, 1));
+        folded = _mm_add_epi32(folded, _mm_shuffle_epi32(folded, _MM_SHUFFLE(1, 0, 3, 2)));
+        folded = _mm_add_epi32(folded, _mm_shuffle_epi32(folded, _MM_SHUFFLE(2, 3, 0, 1)));
+        count += (size_t)(unsigned int)_mm_cvtsi128_si32(folded);
+    }
+
+    return count + text_count_newlines_scalar(text + i, length - i);
+}
+
+TEXT_SCAN_TARGET_AVX2
+static size_t text_find_newline_avx2(const wchar_t* text, size_t length) {
+    const __m256i newline = _mm256_set1_epi16(L'\n');
+    size_t i = 0;
+
+    for (; length - i >= 16; i += 16) {
+        __m256i chars = _mm256_loadu_si256((const __m256i*)(text + i));
+        unsigned int mask =
+            (unsigned int)_mm256_movemask_epi8(_mm256_cmpeq_epi16(chars, newline));
+        if (mask) {
+            return i + text_lowest_bit(mask) / 2;
+        }
+    }
+
+    return i + text_find_newline_scalar(text + i, length - i);
+}
+
+TEXT_SCAN_TARGET_AVX2
+static size_t text_find_any_avx2(const wchar_t* text, size_t length,
+                                 const wchar_t* set, size_t set_count) {
+    __m256i values[TEXT_SCAN_MAX_SET];
+    for (size_t k = 0; k < set_count; k++) {
+        values[k] = _mm256_set1_epi16((short)set[k]);
+    }
+    size_t i = 0;
+
+    for (; length - i >= 16; i += 16) {
+        __m256i chars = _mm256_loadu_si256((const __m256i*)(text + i));
+        __m256i hits = _mm256_cmpeq_epi16(chars, values[0]);
+        for (size_t k = 1; k < set_count; k++) {
+            hits = _mm256_or_si256(hits, _mm256_cmpeq_epi16(chars, values[k]));
+        }
+        unsigned int mask = (unsigned int)_mm256_movemask_epi8(hits);
+        if (mask) {
+            return i + text_lowest_bit(mask) / 2;
+        }
+    }
+
+    return i + text_find_any_scalar(text + i, length - i, set, set_count);
+}
+
+TEXT_SCAN_TARGET_AVX2
+static unsigned int text_classify_bidi_avx2(const wchar_t* text, size_t length) {
+    const __m256i case_bit = _mm256_set1_epi16(0x20);
+    unsigned int flags = 0;
+    size_t i = 0;
+
+    for (; length - i >= 16; i += 16) {
+        __m256i chars = _mm256_loadu_si256((const __m256i*)(text + i));
+
+        __m256i rtl = text_in_range_avx2(chars, 0x0590, 0x06FF);
+        rtl = _mm256_or_si256(rtl, text_in_range_avx2(chars, 0x0750, 0x077F));
+        rtl = _mm256_or_si256(rtl, text_in_range_avx2(chars, 0x08A0, 0x08FF));
+        rtl = _mm256_or_si256(rtl, text_in_range_avx2(chars, 0xFB50, 0xFDFF));
+        rtl = _mm256_or_si256(rtl, text_in_range_avx2(chars, 0xFE70, 0xFEFF));
+
+        __m256i ltr = text_in_range_avx2(_mm256_or_si256(chars, case_bit), 0x0061, 0x007A);
+
+        if (_mm256_movemask_epi8(rtl)) {
+            flags |= TEXT_BIDI_RTL;
+        }
+        if (_mm256_movemask_epi8(ltr)) {
+            flags |= TEXT_BIDI_LTR;
+        }
+        if (flags == (TEXT_BIDI_RTL | TEXT_BIDI_LTR)) {
+            return flags;
+        }
+    }
+
+    return text_classify_bidi_from(text + i, length - i, flags);
+}
+
+TEXT_SCAN_TARGET_AVX2
+static size_t text_find_control_avx2(const char* text, size_t length) {
+    const __m256i last_c0 = _mm256_set1_epi8(0x1F);
+    const __m256i del = _mm256_set1_epi8(0x7F);
+    const __m256i zero = _mm256_setzero_si256();
+    size_t i = 0;
+
+    for (; length - i >= 32; i += 32) {
+        __m256i bytes = _mm256_loadu_si256((const __m256i*)(text + i));
+        __m256i c0 = _mm256_cmpeq_epi8(_mm256_subs_epu8(bytes, last_c0), zero);
+        __m256i hits = _mm256_or_si256(c0, _mm256_cmpeq_epi8(bytes, del));
+        unsigned int mask = (unsigned int)_mm256_movemask_epi8(hits);
+        if (mask) {
+            return i + text_lowest_bit(mask);
+        }
+    }
+
+    return i + text_find_control_scalar(text + i, length - i);
+}
+
+#endif /* TEXT_SCAN_X86 */
+
+/*=============================================================================
+ * Kernel Selection
+ *============================================================================*/
+
+/**
+ * @brief Kernel table for one level
+ */
+typedef struct TextScanKernels {
+    size_t (*count_newlines)(const wchar_t* text, size_t length);
+    size_t (*find_newline)(const wchar_t* text, size_t length);
+    unsigned int (*classify_bidi)(const wchar_t* text, size_t length);
+    size_t (*find_any)(const wchar_t* text, size_t length, const wchar_t* set,
+                       size_t set_count);
+    size_t (*find_control)(const char* text, size_t length);
+} TextScanKernels;
+
+static const TextScanKernels g_scan_kernels[] = {
+    { text_count_newlines_scalar, text_find_newline_scalar, text_classify_bidi_scalar,
+      text_find_any_scalar, text_find_control_scalar },
+#ifdef TEXT_SCAN_X86
+    { text_count_newlines_sse2, text_find_newline_sse2, text_classify_bidi_sse2,
+      text_find_any_sse2, text_find_control_sse2 },
+    { text_count_newlines_avx2, text_find_newline_avx2, text_classify_bidi_avx2,
+      text_find_any_avx2, text_find_control_avx2 },
+#endif
+};
+
+/**
+ * @brief Kernels in use, or NULL before the first call
+ *
+ * Threads racing on the first call all store the same table.
+ */
+static const TextScanKernels* volatile g_scan_active = NULL;
+
+/**
+ * @brief Query the CPU for SSE2/AVX2 support
+ */
+static TextScanLevel text_scan_detect(void) {
+#if defined(TEXT_SCAN_X86) && defined(_MSC_VER) && !defined(__clang__)
+    int info[4];
+    __cpuid(info, 0);
+    int max_leaf = info[0];
+
+    __cpuid(info, 1);
+    bool sse2 = (info[3] & (1 << 26)) != 0;
+    bool osxsave = (info[2] & (1 << 27)) != 0;
+    bool avx = (info[2] & (1 << 28)) != 0;
+
+    bool avx2 = false;
+    if (max_leaf >= 7 && osxsave && avx) {
+        /* The OS must save the YMM registers too (XCR0 bits 1 and 2) */
+        bool ymm_enabled = (_xgetbv(0) & 0x6) == 0x6;
+        __cpuidex(info, 7, 0);
+        avx2 = ymm_enabled && (info[1] & (1 << 5)) != 0;
+    }
+
+    if (avx2) {
+        return TEXT_SCAN_AVX2;
+    }
+    return sse2 ? TEXT_SCAN_SSE2 : TEXT_SCAN_SCALAR;
+#elif defined(TEXT_SCAN_X86)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        return TEXT_SCAN_AVX2;
+    }
+    return __builtin_cpu_supports("sse2") ? TEXT_SCAN_SSE2 : TEXT_SCAN_SCALAR;
+#else
+    return TEXT_SCAN_SCALAR;
+#endif
+}
+
+/**
+ * @brief Get the active kernel table, selecting it on first use
+ */
+static inline const TextScanKernels* text_scan_kernels(void) {
+    const TextScanKernels* kernels = g_scan_active;
+    if (!kernels) {
+        kernels = &g_scan_kernels[text_scan_detect()];
+        g_scan_active = kernels;
+    }
+    return kernels;
+}
+
+TextScanLevel text_scan_get_supported_level(void) {
+    return text_scan_detect();
+}
+
+TextScanLevel text_scan_get_level(void) {
+    return (TextScanLevel)(text_scan_kernels() - g_scan_kernels);
+}
+
+TextScanLevel text_scan_set_level(TextScanLevel level) {
+    TextScanLevel supported = text_scan_detect();
+    if (level > supported) {
+        level = supported;
+    }
+    g_scan_active = &g_scan_kernels[level];
+    return level;
+}
+
+/*=============================================================================
+ * Kernels
+ *============================================================================*/
+
+size_t text_count_newlines(const wchar_t* text, size_t length) {
+    return text_scan_kernels()->count_newlines(text, length);
+}
+
+size_t text_find_newline(const wchar_t* text, size_t length) {
+    return text_scan_kernels()->find_newline(text, length);
+}
+
+unsigned int text_classify_bidi(const wchar_t* text, size_t length) {
+    return text_scan_kernels()->classify_bidi(text, length);
+}
+
+size_t text_find_any(const wchar_t* text, size_t length, const wchar_t* set, size_t set_count) {
+    if (set_count == 0 || set_count > TEXT_SCAN_MAX_SET) {
+        return length;
+    }
+    return text_scan_kernels()->find_any(text, length, set, set_count);
+}
+
+size_t text_find_control(const char* text, size_t length) {
+    return text_scan_kernels()->find_control(text, length);
+}
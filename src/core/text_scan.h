@@ -0,0 +1,125 @@
+/**
+ * @file text_scan.h
+ * @brief Qalam IDE - Vectorized Text Scanning Kernels (Internal Header)
+ *
+ * Internal header for the scanning loops that dominate file loading and
+ * per-line layout: counting and locating L'\n', classifying a span's
+ * bidirectional content, and locating search candidates, plus finding
+ * the control bytes that end a printable run of terminal output. Each
+ * kernel has a scalar, an SSE2 and an AVX2 implementation; the widest one
+ * the CPU supports is picked at runtime on first use. All kernels work on
+ * a single contiguous run of text, so callers scan the segments on each
+ * side of a gap separately.
+ *
+ * @version 0.0.2
+ * @copyright (c) 2026 Qalam Project
+ *
+ * @note Thread Safety: All functions are thread-safe.
+ */
+
+#ifndef QALAM_TEXT_SCAN_H
+#define QALAM_TEXT_SCAN_H
+
+#include "qalam.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*=============================================================================
+ * Scan Types
+ *============================================================================*/
+
+/**
+ * @brief Kernel implementation level
+ */
+typedef enum TextScanLevel {
+    TEXT_SCAN_SCALAR = 0,           /**< Portable C loops */
+    TEXT_SCAN_SSE2 = 1,             /**< 8 characters per step */
+    TEXT_SCAN_AVX2 = 2,             /**< 16 characters per step */
+} TextScanLevel;
+
+/** Span contains Arabic or Hebrew characters */
+#define TEXT_BIDI_RTL               0x1u
+
+/** Span contains Latin letters */
+#define TEXT_BIDI_LTR               0x2u
+
+/** Most characters text_find_any() looks for at once */
+#define TEXT_SCAN_MAX_SET           8
+
+/*=============================================================================
+ * Kernels
+ *============================================================================*/
+
+/**
+ * @brief Count the L'\n' characters in a span
+ */
+size_t text_count_newlines(const wchar_t* text, size_t length);
+
+/**
+ * @brief Find the first L'\n' in a span
+ *
+ * @return Index of the newline, or 'length' if there is none
+ */
+size_t text_find_newline(const wchar_t* text, size_t length);
+
+/**
+ * @brief Classify the bidirectional content of a span
+ *
+ * RTL covers the Hebrew, Arabic, Arabic Supplement, Arabic Extended-A
+ * and Arabic Presentation Forms blocks; LTR covers A-Z and a-z. Stops
+ * early once both have been seen.
+ *
+ * @return Combination of TEXT_BIDI_RTL and TEXT_BIDI_LTR
+ */
+unsigned int text_classify_bidi(const wchar_t* text, size_t length);
+
+/**
+ * @brief Find the first character of a span that is one of 'set'
+ *
+ * @param set Characters to look for
+ * @param set_count Number of characters in 'set' (1 to TEXT_SCAN_MAX_SET)
+ * @return Index of the character, or 'length' if there is none
+ */
+size_t text_find_any(const wchar_t* text, size_t length, const wchar_t* set, size_t set_count);
+
+/**
+ * @brief Find the first C0 control (0x00-0x1F) or DEL (0x7F) byte of a
+ *        UTF-8 span
+ *
+ * Bytes of multi-byte UTF-8 sequences are never controls, so everything
+ * before the result is printable text.
+ *
+ * @return Index of the byte, or 'length' if there is none
+ */
+size_t text_find_control(const char* text, size_t length);
+
+/*=============================================================================
+ * Kernel Selection
+ *============================================================================*/
+
+/**
+ * @brief Get the widest kernel level supported by this CPU and build
+ */
+TextScanLevel text_scan_get_supported_level(void);
+
+/**
+ * @brief Get the kernel level in use
+ */
+TextScanLevel text_scan_get_level(void);
+
+/**
+ * @brief Use a specific kernel level (for tests and benchmarks)
+ *
+ * Levels above text_scan_get_supported_level() are clamped to it.
+ *
+ * @return The level now in use
+ */
+TextScanLevel text_scan_set_level(TextScanLevel level);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* QALAM_TEXT_SCAN_H */
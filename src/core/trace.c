@@ -0,0 +1,288 @@
+/**
+ * @file trace.c
+ * @brief Qalam IDE - Hot-Path Tracing Implementation
+ *
+ * A span costs two QueryPerformanceCounter() calls and three interlocked
+ * adds; its event is only formatted when an ETW session has enabled the
+ * provider for the span's category, which TraceLoggingProviderEnabled()
+ * checks without a call into the kernel. Spans end as a single event
+ * carrying their duration rather than as a start and stop pair.
+ *
+ * TraceLogging needs its keyword as a constant, so each category has
+ * its own TraceLoggingWrite() site.
+ *
+ * Startup marks are a performance counter value per phase, set once
+ * with a compare-exchange so that racing threads keep the earliest.
+ *
+ * @version 0.0.2
+ * @copyright (c) 2026 Qalam Project
+ *
+ * @note Thread Safety: Spans and counters may be recorded from any
+ *       thread. Call qalam_trace_init() and qalam_trace_shutdown() from
+ *       one thread.
+ */
+
+#include "qalam.h"
+
+#if QALAM_ENABLE_TRACING
+#include <TraceLoggingProvider.h>
+#include <winmeta.h>
+
+/* "Qalam", with the GUID EventSource derives from the name */
+TRACELOGGING_DEFINE_PROVIDER(
+    g_qalam_provider,
+    "Qalam",
+    (0x85574d3a, 0x5ca4, 0x541d, 0x1e, 0x85, 0x08, 0xaf, 0x23, 0xa5, 0x7c, 0x72));
+#endif
+
+/*=============================================================================
+ * Internal State
+ *============================================================================*/
+
+static volatile LONG64 g_span_ticks[QALAM_TRACE_CATEGORY_COUNT];
+static volatile LONG64 g_span_count[QALAM_TRACE_CATEGORY_COUNT];
+static volatile LONG64 g_counter_sum[QALAM_TRACE_CATEGORY_COUNT];
+static volatile LONG64 g_startup_qpc[QALAM_STARTUP_PHASE_COUNT];
+static volatile LONG64 g_frequency = 0;
+static bool g_registered = false;
+
+/*=============================================================================
+ * Internal Helper Functions
+ *============================================================================*/
+
+static int64_t trace_frequency(void) {
+    LONG64 frequency = g_frequency;
+    if (frequency == 0) {
+        LARGE_INTEGER value;
+        QueryPerformanceFrequency(&value);
+        frequency = value.QuadPart;
+        InterlockedExchange64(&g_frequency, frequency);
+    }
+    return frequency;
+}
+
+static uint64_t trace_ticks_to_ns(int64_t ticks) {
+    int64_t frequency = trace_frequency();
+    /* Split to keep ticks * 1e9 from overflowing */
+    return (uint64_t)(ticks / frequency) * 1000000000ull +
+           (uint64_t)(ticks % frequency) * 1000000000ull / (uint64_t)frequency;
+}
+
+static bool trace_valid_category(QalamTraceCategory category) {
+    return (unsigned)category < QALAM_TRACE_CATEGORY_COUNT;
+}
+
+#if QALAM_ENABLE_TRACING
+
+#define TRACE_WRITE_SPAN(keyword, span, duration_ns) \
+    TraceLoggingWrite(g_qalam_provider, "Span", \
+                      TraceLoggingLevel(WINEVENT_LEVEL_VERBOSE), \
+                      TraceLoggingKeyword(keyword), \
+                      TraceLoggingString((span)->name, "Name"), \
+                      TraceLoggingUInt64((duration_ns), "DurationNs"), \
+                      TraceLoggingInt64((span)->start, "StartQpc"))
+
+#define TRACE_WRITE_COUNTER(keyword, name, value) \
+    TraceLoggingWrite(g_qalam_provider, "Counter", \
+                      TraceLoggingLevel(WINEVENT_LEVEL_VERBOSE), \
+                      TraceLoggingKeyword(keyword), \
+                      TraceLoggingString((name), "Name"), \
+                      TraceLoggingInt64((value), "Value"))
+
+static void trace_write_span(const QalamTraceSpan* span, uint64_t duration_ns) {
+    switch (span->category) {
+        case QALAM_TRACE_BUFFER:      TRACE_WRITE_SPAN(0x1, span, duration_ns); break;
+        case QALAM_TRACE_LAYOUT:      TRACE_WRITE_SPAN(0x2, span, duration_ns); break;
+        case QALAM_TRACE_RENDER:      TRACE_WRITE_SPAN(0x4, span, duration_ns); break;
+        case QALAM_TRACE_TERMINAL:    TRACE_WRITE_SPAN(0x8, span, duration_ns); break;
+        case QALAM_TRACE_TERMINAL_IO: TRACE_WRITE_SPAN(0x10, span, duration_ns); break;
+        case QALAM_TRACE_SYNTAX:      TRACE_WRITE_SPAN(0x20, span, duration_ns); break;
+        case QALAM_TRACE_STARTUP:     TRACE_WRITE_SPAN(0x40, span, duration_ns); break;
+        default: break;
+    }
+}
+
+static void trace_write_counter(QalamTraceCategory category, const char* name, int64_t value) {
+    switch (category) {
+        case QALAM_TRACE_BUFFER:      TRACE_WRITE_COUNTER(0x1, name, value); break;
+        case QALAM_TRACE_LAYOUT:      TRACE_WRITE_COUNTER(0x2, name, value); break;
+        case QALAM_TRACE_RENDER:      TRACE_WRITE_COUNTER(0x4, name, value); break;
+        case QALAM_TRACE_TERMINAL:    TRACE_WRITE_COUNTER(0x8, name, value); break;
+        case QALAM_TRACE_TERMINAL_IO: TRACE_WRITE_COUNTER(0x10, name, value); break;
+        case QALAM_TRACE_SYNTAX:      TRACE_WRITE_COUNTER(0x20, name, value); break;
+        case QALAM_TRACE_STARTUP:     TRACE_WRITE_COUNTER(0x40, name, value); break;
+        default: break;
+    }
+}
+
+static void trace_write_startup(const char* name, uint64_t since_begin_ns) {
+    TraceLoggingWrite(g_qalam_provider, "StartupPhase",
+                      TraceLoggingLevel(WINEVENT_LEVEL_INFO),
+                      TraceLoggingKeyword(0x40),
+                      TraceLoggingString(name, "Name"),
+                      TraceLoggingUInt64(since_begin_ns, "SinceStartNs"));
+}
+
+static bool trace_listening(QalamTraceCategory category) {
+    return g_registered &&
+           TraceLoggingProviderEnabled(g_qalam_provider, WINEVENT_LEVEL_VERBOSE,
+                                       1ull << category);
+}
+
+#endif /* QALAM_ENABLE_TRACING */
+
+/*=============================================================================
+ * Lifecycle
+ *============================================================================*/
+
+QalamResult qalam_trace_init(void) {
+    trace_frequency();
+
+#if QALAM_ENABLE_TRACING
+    if (!g_registered) {
+        if (FAILED(TraceLoggingRegister(g_qalam_provider))) {
+            return QALAM_ERROR_UNKNOWN;
+        }
+        g_registered = true;
+    }
+#endif
+
+    return QALAM_OK;
+}
+
+void qalam_trace_shutdown(void) {
+#if QALAM_ENABLE_TRACING
+    if (g_registered) {
+        TraceLoggingUnregister(g_qalam_provider);
+    }
+#endif
+    g_registered = false;
+}
+
+bool qalam_trace_is_available(void) {
+    return QALAM_ENABLE_TRACING != 0;
+}
+
+/*=============================================================================
+ * Spans and Counters
+ *============================================================================*/
+
+void qalam_trace_span_begin(QalamTraceSpan* span, QalamTraceCategory category, const char* name) {
+    if (!span) {
+        return;
+    }
+
+    LARGE_INTEGER now;
+    QueryPerformanceCounter(&now);
+    span->name = name ? name : "";
+    span->category = category;
+    span->start = now.QuadPart;
+}
+
+void qalam_trace_span_end(const QalamTraceSpan* span) {
+    if (!span || !trace_valid_category(span->category)) {
+        return;
+    }
+
+    LARGE_INTEGER now;
+    QueryPerformanceCounter(&now);
+    int64_t ticks = now.QuadPart - span->start;
+
+    InterlockedExchangeAdd64(&g_span_ticks[span->category], ticks);
+    InterlockedIncrement64(&g_span_count[span->category]);
+
+#if QALAM_ENABLE_TRACING
+    if (trace_listening(span->category)) {
+        trace_write_span(span, trace_ticks_to_ns(ticks));
+    }
+#endif
+}
+
+void qalam_trace_counter(QalamTraceCategory category, const char* name, int64_t value) {
+    if (!trace_valid_category(category)) {
+        return;
+    }
+
+    InterlockedExchangeAdd64(&g_counter_sum[category], value);
+
+#if QALAM_ENABLE_TRACING
+    if (trace_listening(category)) {
+        trace_write_counter(category, name ? name : "", value);
+    }
+#else
+    (void)name;
+#endif
+}
+
+void qalam_trace_take_totals(QalamTraceTotals* totals) {
+    if (!totals) {
+        return;
+    }
+
+    for (int i = 0; i < QALAM_TRACE_CATEGORY_COUNT; i++) {
+        totals->span_ns[i] = trace_ticks_to_ns(InterlockedExchange64(&g_span_ticks[i], 0));
+        totals->spans[i] = (uint64_t)InterlockedExchange64(&g_span_count[i], 0);
+        totals->counters[i] = InterlockedExchange64(&g_counter_sum[i], 0);
+    }
+}
+
+/*=============================================================================
+ * Startup Phases
+ *============================================================================*/
+
+static const char* const g_startup_names[QALAM_STARTUP_PHASE_COUNT] = {
+    "begin",
+    "dwrite_init",
+    "window",
+    "first_paint",
+    "fonts_ready",
+    "file_loaded",
+    "first_text",
+};
+
+void qalam_trace_startup_mark(QalamStartupPhase phase) {
+    if ((unsigned)phase >= QALAM_STARTUP_PHASE_COUNT) {
+        return;
+    }
+
+    LARGE_INTEGER now;
+    QueryPerformanceCounter(&now);
+    InterlockedCompareExchange64(&g_startup_qpc[QALAM_STARTUP_BEGIN], now.QuadPart, 0);
+    if (phase == QALAM_STARTUP_BEGIN ||
+        InterlockedCompareExchange64(&g_startup_qpc[phase], now.QuadPart, 0) != 0) {
+        return;
+    }
+
+#if QALAM_ENABLE_TRACING
+    if (trace_listening(QALAM_TRACE_STARTUP)) {
+        trace_write_startup(g_startup_names[phase],
+                            trace_ticks_to_ns(now.QuadPart - g_startup_qpc[QALAM_STARTUP_BEGIN]));
+    }
+#endif
+}
+
+void qalam_trace_get_startup(QalamStartupTimings* timings) {
+    if (!timings) {
+        return;
+    }
+
+    int64_t begin = g_startup_qpc[QALAM_STARTUP_BEGIN];
+    timings->reached = 0;
+    for (int i = 0; i < QALAM_STARTUP_PHASE_COUNT; i++) {
+        int64_t mark = g_startup_qpc[i];
+        timings->phase_ns[i] = mark > begin ? trace_ticks_to_ns(mark - begin) : 0;
+        if (mark != 0) {
+            timings->reached |= 1u << i;
+        }
+    }
+}
+
+void qalam_trace_startup_reset(void) {
+    for (int i = 0; i < QALAM_STARTUP_PHASE_COUNT; i++) {
+        InterlockedExchange64(&g_startup_qpc[i], 0);
+    }
+}
+
+const char* qalam_trace_startup_phase_name(QalamStartupPhase phase) {
+    return (unsigned)phase < QALAM_STARTUP_PHASE_COUNT ? g_startup_names[phase] : "unknown";
+}
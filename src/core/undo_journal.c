@@ -0,0 +1,332 @@
+/**
+ * @file undo_journal.c
+ * @brief Qalam IDE - Undo/Redo Journal Implementation
+ *
+ * Stores the edit history of a buffer. Applying and reverting records
+ * needs the buffer's storage and line index, so that part lives in
+ * buffer.c; this file owns the group/record slabs and the text stack.
+ *
+ * @version 0.0.2
+ * @copyright (c) 2026 Qalam Project
+ *
+ * @note Thread Safety: Functions in this file are NOT thread-safe.
+ */
+
+#include "undo_journal.h"
+#include <stdlib.h>
+#include <string.h>
+
+/** Initial number of groups and records in each slab */
+#define UNDO_JOURNAL_INITIAL_SLOTS  64
+
+/** Initial size of the text stack in wchar_t units */
+#define UNDO_JOURNAL_INITIAL_TEXT   4096
+
+/*=============================================================================
+ * Internal Helper Functions
+ *============================================================================*/
+
+/**
+ * @brief Grow an array so it holds at least 'needed' elements
+ */
+static QalamResult undo_grow(void** items, size_t* capacity, size_t needed,
+                             size_t item_size, size_t initial) {
+    if (needed <= *capacity) {
+        return QALAM_OK;
+    }
+
+    size_t new_capacity = *capacity ? *capacity : initial;
+    while (new_capacity < needed) {
+        if (new_capacity > SIZE_MAX / (2 * item_size)) {
+            return QALAM_ERROR_OUT_OF_MEMORY;
+        }
+        new_capacity *= 2;
+    }
+
+    void* grown = qalam_mem_realloc(QALAM_MEMORY_UNDO, *items, new_capacity * item_size);
+    if (!grown) {
+        return QALAM_ERROR_OUT_OF_MEMORY;
+    }
+    *items = grown;
+    *capacity = new_capacity;
+    return QALAM_OK;
+}
+
+/**
+ * @brief Reverse a run of UTF-16 units in place
+ */
+static void undo_reverse(wchar_t* text, size_t length) {
+    for (size_t i = 0, j = length; i + 1 < j; i++, j--) {
+        wchar_t ch = text[i];
+        text[i] = text[j - 1];
+        text[j - 1] = ch;
+    }
+}
+
+/**
+ * @brief Release the records of groups [first_group, group_count)
+ */
+static void undo_release_groups(UndoJournal* journal, PieceTable* table, size_t first_group) {
+    if (first_group >= journal->group_count) {
+        return;
+    }
+
+    UndoGroup* first = &journal->groups[first_group];
+    for (size_t i = first->first_record; i < journal->record_count; i++) {
+        piece_table_release_span(table, journal->records[i].span);
+    }
+
+    journal->record_count = first->first_record;
+    journal->text_length = first->text_mark;
+    journal->group_count = first_group;
+}
+
+/**
+ * @brief Get the last record if the next keystroke may be folded into it
+ */
+static UndoRecord* undo_coalesce_target(UndoJournal* journal, UndoRecordKind kind) {
+    if (journal->depth > 0 || !journal->coalesce || journal->group_count == 0 ||
+        journal->applied != journal->group_count) {
+        return NULL;
+    }
+
+    UndoGroup* group = &journal->groups[journal->group_count - 1];
+    if (group->record_count != 1) {
+        return NULL;
+    }
+
+    UndoRecord* record = &journal->records[group->first_record];
+    return record->kind == kind ? record : NULL;
+}
+
+/**
+ * @brief Fold a one-character deletion into the previous one
+ *
+ * @return false if the deletion does not continue the previous one
+ */
+static bool undo_coalesce_delete(UndoJournal* journal, PieceTable* table, UndoRecord* record,
+                                 UndoDeleteDirection direction, size_t pos, size_t length,
+                                 PieceNode* span) {
+    bool backward = direction == UNDO_DELETE_BACKWARD;
+
+    if (record->direction != direction ||
+        (backward ? pos + length != record->pos : pos != record->pos)) {
+        return false;
+    }
+
+    if (span) {
+        record->span = backward ? piece_table_join_spans(table, span, record->span)
+                                : piece_table_join_spans(table, record->span, span);
+    } else {
+        /* The new text was copied right above the record's own */
+        if (record->text + record->length != journal->text_length) {
+            return false;
+        }
+        if (backward) {
+            /* Backspaces are stacked back to front so each one is an append */
+            if (!record->reversed) {
+                undo_reverse(journal->text + record->text, record->length);
+                record->reversed = true;
+            }
+            undo_reverse(journal->text + journal->text_length, length);
+        }
+        journal->text_length += length;
+    }
+
+    if (backward) {
+        record->pos = pos;
+    }
+    record->length += length;
+    return true;
+}
+
+/*=============================================================================
+ * Lifecycle
+ *============================================================================*/
+
+void undo_journal_free(UndoJournal* journal, PieceTable* table) {
+    if (!journal) {
+        return;
+    }
+
+    for (size_t i = 0; i < journal->record_count; i++) {
+        piece_table_release_span(table, journal->records[i].span);
+    }
+
+    if (journal->text) {
+        /* Deleted text may be sensitive, as with the buffer itself */
+        memset(journal->text, 0, journal->text_capacity * sizeof(wchar_t));
+        qalam_mem_free(journal->text);
+    }
+    qalam_mem_free(journal->groups);
+    qalam_mem_free(journal->records);
+
+    memset(journal, 0, sizeof(UndoJournal));
+}
+
+/*=============================================================================
+ * Recording
+ *============================================================================*/
+
+QalamResult undo_journal_reserve(UndoJournal* journal, PieceTable* table,
+                                 size_t text_length, wchar_t** out_text) {
+    QalamResult result = undo_journal_reserve_records(journal, table, 1, text_length);
+    if (result != QALAM_OK) {
+        return result;
+    }
+
+    if (out_text) {
+        *out_text = journal->text + journal->text_length;
+    }
+    return QALAM_OK;
+}
+
+QalamResult undo_journal_reserve_records(UndoJournal* journal, PieceTable* table,
+                                         size_t record_count, size_t text_length) {
+    if (!journal) {
+        return QALAM_ERROR_NULL_POINTER;
+    }
+
+    /* A new edit makes the undone groups unreachable */
+    undo_release_groups(journal, table, journal->applied);
+
+    if (record_count > SIZE_MAX - journal->record_count) {
+        return QALAM_ERROR_OUT_OF_MEMORY;
+    }
+
+    QalamResult result = undo_grow((void**)&journal->groups, &journal->group_capacity,
+                                   journal->group_count + 1, sizeof(UndoGroup),
+                                   UNDO_JOURNAL_INITIAL_SLOTS);
+    if (result == QALAM_OK) {
+        result = undo_grow((void**)&journal->records, &journal->record_capacity,
+                           journal->record_count + record_count, sizeof(UndoRecord),
+                           UNDO_JOURNAL_INITIAL_SLOTS);
+    }
+    if (result == QALAM_OK) {
+        result = undo_journal_reserve_text(journal, text_length);
+    }
+    return result;
+}
+
+void undo_journal_record(UndoJournal* journal, PieceTable* table, UndoRecordKind kind,
+                         UndoDeleteDirection direction, bool keystroke, size_t pos,
+                         size_t length, PieceNode* span, const UndoState* before,
+                         const UndoState* after) {
+    UndoRecord* target = keystroke ? undo_coalesce_target(journal, kind) : NULL;
+    if (target) {
+        bool folded = kind == UNDO_RECORD_INSERT
+                          ? pos == target->pos + target->length
+                          : undo_coalesce_delete(journal, table, target, direction, pos,
+                                                 length, span);
+        if (folded) {
+            if (kind == UNDO_RECORD_INSERT) {
+                target->length += length;
+            }
+            journal->groups[journal->group_count - 1].after = *after;
+            return;
+        }
+    }
+
+    if (journal->depth == 0 || !journal->group_open) {
+        UndoGroup* group = &journal->groups[journal->group_count++];
+        group->first_record = journal->record_count;
+        group->record_count = 0;
+        group->text_mark = journal->text_length;
+        group->before = journal->depth > 0 ? journal->group_before : *before;
+        journal->applied = journal->group_count;
+        journal->group_open = journal->depth > 0;
+    }
+
+    UndoRecord* record = &journal->records[journal->record_count++];
+    record->kind = kind;
+    record->direction = kind == UNDO_RECORD_DELETE && keystroke ? direction : UNDO_DELETE_RANGE;
+    record->reversed = false;
+    record->pos = pos;
+    record->length = length;
+    record->span = span;
+    record->text = UNDO_NO_TEXT;
+    if (kind == UNDO_RECORD_DELETE && !span) {
+        record->text = journal->text_length;
+        journal->text_length += length;
+    }
+
+    UndoGroup* group = &journal->groups[journal->group_count - 1];
+    group->record_count++;
+    group->after = *after;
+    journal->coalesce = journal->depth == 0 && keystroke;
+}
+
+QalamResult undo_journal_begin_group(UndoJournal* journal, const UndoState* before) {
+    if (!journal || !before) {
+        return QALAM_ERROR_NULL_POINTER;
+    }
+
+    /* The group is only created by its first record, so an empty one leaves no trace */
+    if (journal->depth++ == 0) {
+        journal->group_before = *before;
+        journal->group_open = false;
+    }
+    return QALAM_OK;
+}
+
+QalamResult undo_journal_end_group(UndoJournal* journal, const UndoState* after) {
+    if (!journal || !after) {
+        return QALAM_ERROR_NULL_POINTER;
+    }
+    if (journal->depth == 0) {
+        return QALAM_ERROR_INVALID_ARGUMENT;
+    }
+
+    if (--journal->depth == 0 && journal->group_open) {
+        journal->groups[journal->group_count - 1].after = *after;
+        journal->group_open = false;
+    }
+    return QALAM_OK;
+}
+
+void undo_journal_seal(UndoJournal* journal) {
+    if (journal) {
+        journal->coalesce = false;
+    }
+}
+
+/*=============================================================================
+ * Text Stack
+ *============================================================================*/
+
+QalamResult undo_journal_reserve_text(UndoJournal* journal, size_t length) {
+    if (length > SIZE_MAX - journal->text_length) {
+        return QALAM_ERROR_OUT_OF_MEMORY;
+    }
+    return undo_grow((void**)&journal->text, &journal->text_capacity,
+                     journal->text_length + length, sizeof(wchar_t),
+                     UNDO_JOURNAL_INITIAL_TEXT);
+}
+
+size_t undo_journal_push_text(UndoJournal* journal, const wchar_t* text, size_t length) {
+    size_t offset = journal->text_length;
+    if (length > 0) {
+        memcpy(journal->text + offset, text, length * sizeof(wchar_t));
+    }
+    journal->text_length += length;
+    return offset;
+}
+
+const wchar_t* undo_journal_record_text(UndoJournal* journal, UndoRecord* record) {
+    wchar_t* text = journal->text + record->text;
+    if (record->reversed) {
+        undo_reverse(text, record->length);
+        record->reversed = false;
+    }
+    return text;
+}
+
+void undo_journal_drop_text(UndoJournal* journal, UndoRecord* record) {
+    if (record->text == UNDO_NO_TEXT) {
+        return;
+    }
+    if (record->text + record->length == journal->text_length) {
+        journal->text_length = record->text;
+    }
+    record->text = UNDO_NO_TEXT;
+}
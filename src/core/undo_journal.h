@@ -0,0 +1,249 @@
+/**
+ * @file undo_journal.h
+ * @brief Qalam IDE - Undo/Redo Journal (Internal Header)
+ *
+ * Internal header for the per-buffer edit history. Each undo group holds
+ * the primitive insertions and deletions made by one user action, along
+ * with the cursor and selection on either side of it. Groups and records
+ * live in two growable slabs owned by the journal, so recording an edit
+ * never allocates on its own.
+ *
+ * Text that leaves the document is kept in one of two ways:
+ *  - Piece table: the removed pieces are detached from the treap and
+ *    kept as a span, still referencing the immutable original and add
+ *    buffers. Nothing is copied, however long the text.
+ *  - Gap buffer: the text is copied onto a stack owned by the journal.
+ *    Records are created and undone in stack order, so discarding redo
+ *    history is a single rewind.
+ *
+ * Consecutive one-character insertions, backspaces or forward deletes
+ * at adjoining positions are folded into a single record, so undoing a
+ * long run of typing is one operation rather than a replay.
+ *
+ * @version 0.0.2
+ * @copyright (c) 2026 Qalam Project
+ *
+ * @note Thread Safety: Not thread-safe. Owned by a single QalamBuffer.
+ */
+
+#ifndef QALAM_UNDO_JOURNAL_H
+#define QALAM_UNDO_JOURNAL_H
+
+#include "qalam.h"
+#include "editor.h"
+#include "piece_table.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*=============================================================================
+ * Journal Structures
+ *============================================================================*/
+
+/** Record has no text on the journal's text stack */
+#define UNDO_NO_TEXT                SIZE_MAX
+
+/**
+ * @brief Kind of a primitive edit
+ */
+typedef enum UndoRecordKind {
+    UNDO_RECORD_INSERT = 0,         /**< Text was inserted at 'pos' */
+    UNDO_RECORD_DELETE = 1,         /**< Text was deleted from 'pos' */
+} UndoRecordKind;
+
+/**
+ * @brief Direction of a one-character deletion, for coalescing
+ */
+typedef enum UndoDeleteDirection {
+    UNDO_DELETE_RANGE = 0,          /**< Not a keystroke; never coalesces */
+    UNDO_DELETE_BACKWARD = 1,       /**< Backspace */
+    UNDO_DELETE_FORWARD = 2,        /**< Delete key */
+} UndoDeleteDirection;
+
+/**
+ * @brief One primitive edit
+ *
+ * While the record's text is out of the document (a deletion that is
+ * applied, or an insertion that is undone) it is held in 'span' (piece
+ * table) or at 'text' on the text stack (gap buffer).
+ */
+typedef struct UndoRecord {
+    UndoRecordKind kind;            /**< Insertion or deletion */
+    UndoDeleteDirection direction;  /**< Keystroke direction of a deletion */
+    bool reversed;                  /**< Stacked text is stored back to front */
+    size_t pos;                     /**< Document offset in wchar_t units */
+    size_t length;                  /**< Text length in wchar_t units */
+    size_t text;                    /**< Offset on the text stack, or UNDO_NO_TEXT */
+    PieceNode* span;                /**< Detached pieces, or NULL */
+} UndoRecord;
+
+/**
+ * @brief Cursor and selection captured around an undo group
+ */
+typedef struct UndoState {
+    size_t cursor_offset;           /**< Cursor offset in wchar_t units */
+    QalamSelection selection;       /**< Selection */
+} UndoState;
+
+/**
+ * @brief One undoable user action
+ */
+typedef struct UndoGroup {
+    size_t first_record;            /**< Index of the first record */
+    size_t record_count;            /**< Number of records */
+    size_t text_mark;               /**< Text stack height when the group began */
+    UndoState before;               /**< State to restore on undo */
+    UndoState after;                /**< State to restore on redo */
+} UndoGroup;
+
+/**
+ * @brief Edit history of a buffer
+ *
+ * Groups [0, applied) are in the document and can be undone; groups
+ * [applied, group_count) were undone and can be redone.
+ */
+typedef struct UndoJournal {
+    UndoGroup* groups;              /**< Group slab */
+    size_t group_count;             /**< Groups in use */
+    size_t group_capacity;          /**< Allocated groups */
+    size_t applied;                 /**< Groups currently applied */
+    UndoRecord* records;            /**< Record slab */
+    size_t record_count;            /**< Records in use */
+    size_t record_capacity;         /**< Allocated records */
+    wchar_t* text;                  /**< Text stack */
+    size_t text_length;             /**< Text stack height */
+    size_t text_capacity;           /**< Allocated text stack size */
+    unsigned int depth;             /**< Nesting depth of explicit groups */
+    bool group_open;                /**< The explicit group has its UndoGroup */
+    UndoState group_before;         /**< State when the explicit group began */
+    bool coalesce;                  /**< Last group may absorb the next keystroke */
+} UndoJournal;
+
+/*=============================================================================
+ * Lifecycle
+ *============================================================================*/
+
+/**
+ * @brief Release the history and everything it holds
+ *
+ * @param journal Journal to free
+ * @param table Piece table the spans belong to (NULL for a gap buffer)
+ */
+void undo_journal_free(UndoJournal* journal, PieceTable* table);
+
+/*=============================================================================
+ * Recording
+ *============================================================================*/
+
+/**
+ * @brief Prepare to record one edit
+ *
+ * Discards any redo history and allocates everything the following
+ * undo_journal_record() may need, so that the edit can be made knowing
+ * it will be recorded.
+ *
+ * @param journal Target journal
+ * @param table Piece table the spans belong to (NULL for a gap buffer)
+ * @param text_length Deleted characters to be copied (gap buffer only)
+ * @param[out] out_text Receives where to copy them (optional)
+ * @return QALAM_OK on success, QALAM_ERROR_OUT_OF_MEMORY on failure
+ */
+QalamResult undo_journal_reserve(UndoJournal* journal, PieceTable* table,
+                                 size_t text_length, wchar_t** out_text);
+
+/**
+ * @brief Prepare to record several edits as part of one group
+ *
+ * As undo_journal_reserve(), with room for 'record_count' records and
+ * 'text_length' characters of deleted text in total.
+ *
+ * @param journal Target journal
+ * @param table Piece table the spans belong to (NULL for a gap buffer)
+ * @param record_count Number of records to be made
+ * @param text_length Deleted characters to be copied (gap buffer only)
+ * @return QALAM_OK on success, QALAM_ERROR_OUT_OF_MEMORY on failure
+ */
+QalamResult undo_journal_reserve_records(UndoJournal* journal, PieceTable* table,
+                                         size_t record_count, size_t text_length);
+
+/**
+ * @brief Record an edit made after undo_journal_reserve()
+ *
+ * A deletion's text is either 'span' (piece table) or the text copied
+ * to the reserved space (gap buffer). Outside an explicit group, the
+ * edit starts a new group or is folded into the previous keystroke.
+ *
+ * @param journal Target journal
+ * @param table Piece table the spans belong to (NULL for a gap buffer)
+ * @param kind Insertion or deletion
+ * @param direction Keystroke direction of a deletion
+ * @param keystroke true if the edit is a single character
+ * @param pos Document offset of the edit
+ * @param length Length of the edit in wchar_t units (> 0)
+ * @param span Detached pieces of a piece table deletion, or NULL
+ * @param before State before the edit
+ * @param after State after the edit
+ */
+void undo_journal_record(UndoJournal* journal, PieceTable* table, UndoRecordKind kind,
+                         UndoDeleteDirection direction, bool keystroke, size_t pos,
+                         size_t length, PieceNode* span, const UndoState* before,
+                         const UndoState* after);
+
+/**
+ * @brief Open an explicit group; nested calls join the outermost one
+ *
+ * Nothing is added to the history until the first record, so a group
+ * that records nothing leaves the redo history intact.
+ *
+ * @return QALAM_OK on success, error code on failure
+ */
+QalamResult undo_journal_begin_group(UndoJournal* journal, const UndoState* before);
+
+/**
+ * @brief Close an explicit group
+ *
+ * @return QALAM_OK on success, QALAM_ERROR_INVALID_ARGUMENT if no group is open
+ */
+QalamResult undo_journal_end_group(UndoJournal* journal, const UndoState* after);
+
+/**
+ * @brief Stop the next keystroke from joining the previous group
+ */
+void undo_journal_seal(UndoJournal* journal);
+
+/*=============================================================================
+ * Text Stack
+ *============================================================================*/
+
+/**
+ * @brief Make room for 'length' more characters on the text stack
+ *
+ * @return QALAM_OK on success, QALAM_ERROR_OUT_OF_MEMORY on failure
+ */
+QalamResult undo_journal_reserve_text(UndoJournal* journal, size_t length);
+
+/**
+ * @brief Push text onto the stack (room must have been reserved)
+ *
+ * @return Offset of the text on the stack
+ */
+size_t undo_journal_push_text(UndoJournal* journal, const wchar_t* text, size_t length);
+
+/**
+ * @brief Get a record's stacked text in document order
+ *
+ * Text stored back to front is turned around in place first.
+ */
+const wchar_t* undo_journal_record_text(UndoJournal* journal, UndoRecord* record);
+
+/**
+ * @brief Drop a record's stacked text, rewinding the stack if it is on top
+ */
+void undo_journal_drop_text(UndoJournal* journal, UndoRecord* record);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* QALAM_UNDO_JOURNAL_H */
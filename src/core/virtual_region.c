@@ -0,0 +1,193 @@
+/**
+ * @file virtual_region.c
+ * @brief Qalam IDE - Reserved Address Range Implementation
+ *
+ * MEM_COMMIT over pages that are already committed leaves them as they
+ * are, and MEM_DECOMMIT over pages that are not is allowed, so the runs
+ * only have to be a lower bound on what is committed: anything that
+ * falls out of them is at worst committed again, and release walks the
+ * range with VirtualQuery() rather than trusting them.
+ *
+ * @version 0.0.2
+ * @copyright (c) 2026 Qalam Project
+ *
+ * @note Thread Safety: See virtual_region.h.
+ */
+
+#include "virtual_region.h"
+#include <string.h>
+
+/*=============================================================================
+ * Internal Helper Functions
+ *============================================================================*/
+
+static size_t region_round_up(size_t value, size_t step) {
+    return (value + step - 1) / step * step;
+}
+
+static size_t region_round_down(size_t value, size_t step) {
+    return value / step * step;
+}
+
+static size_t region_page_size(void) {
+    static size_t page_size = 0;
+    if (page_size == 0) {
+        SYSTEM_INFO info;
+        GetSystemInfo(&info);
+        page_size = info.dwPageSize ? info.dwPageSize : 4096;
+    }
+    return page_size;
+}
+
+static bool region_commit_pages(VirtualRegion* region, size_t start, size_t end) {
+    if (start >= end) {
+        return true;
+    }
+    return VirtualAlloc(region->base + start, end - start, MEM_COMMIT, PAGE_READWRITE) != NULL;
+}
+
+/*=============================================================================
+ * Lifecycle
+ *============================================================================*/
+
+QalamResult virtual_region_reserve(VirtualRegion* region, size_t size) {
+    if (!region) {
+        return QALAM_ERROR_NULL_POINTER;
+    }
+
+    memset(region, 0, sizeof(VirtualRegion));
+    if (size == 0 || size > SIZE_MAX - VIRTUAL_REGION_COMMIT_STEP) {
+        return QALAM_ERROR_INVALID_ARGUMENT;
+    }
+
+    size = region_round_up(size, VIRTUAL_REGION_COMMIT_STEP);
+    void* base = VirtualAlloc(NULL, size, MEM_RESERVE, PAGE_NOACCESS);
+    if (!base) {
+        return QALAM_ERROR_OUT_OF_MEMORY;
+    }
+
+    region->base = (uint8_t*)base;
+    region->size = size;
+    region->low = 0;
+    region->high = size;
+    return QALAM_OK;
+}
+
+void virtual_region_release(VirtualRegion* region) {
+    if (!region || !region->base) {
+        return;
+    }
+
+    /* Zero out committed data before releasing (security) */
+    size_t offset = 0;
+    while (offset < region->size) {
+        MEMORY_BASIC_INFORMATION info;
+        if (VirtualQuery(region->base + offset, &info, sizeof(info)) == 0) {
+            break;
+        }
+        size_t length = info.RegionSize;
+        if (length > region->size - offset) {
+            length = region->size - offset;
+        }
+        if (info.State == MEM_COMMIT) {
+            memset(region->base + offset, 0, length);
+        }
+        offset += length;
+    }
+
+    VirtualFree(region->base, 0, MEM_RELEASE);
+    memset(region, 0, sizeof(VirtualRegion));
+}
+
+/*=============================================================================
+ * Commit and Decommit
+ *============================================================================*/
+
+QalamResult virtual_region_commit(VirtualRegion* region, size_t offset, size_t length) {
+    if (!region || !region->base) {
+        return QALAM_ERROR_NULL_POINTER;
+    }
+    if (offset >= region->size || length == 0) {
+        return QALAM_OK;
+    }
+
+    size_t end = length > region->size - offset ? region->size : offset + length;
+    if (end <= region->low || offset >= region->high) {
+        return QALAM_OK;
+    }
+
+    if (offset <= region->low) {
+        size_t low = region_round_up(end, VIRTUAL_REGION_COMMIT_STEP);
+        if (low > region->size) {
+            low = region->size;
+        }
+        if (!region_commit_pages(region, region->low, low)) {
+            return QALAM_ERROR_OUT_OF_MEMORY;
+        }
+        region->low = low;
+        return QALAM_OK;
+    }
+
+    if (end >= region->high) {
+        size_t high = region_round_down(offset, VIRTUAL_REGION_COMMIT_STEP);
+        if (!region_commit_pages(region, high, region->high)) {
+            return QALAM_ERROR_OUT_OF_MEMORY;
+        }
+        region->high = high;
+        return QALAM_OK;
+    }
+
+    /* Away from both runs: commit just the pages, untracked */
+    size_t page = region_page_size();
+    if (!region_commit_pages(region, region_round_down(offset, page), region_round_up(end, page))) {
+        return QALAM_ERROR_OUT_OF_MEMORY;
+    }
+    return QALAM_OK;
+}
+
+void virtual_region_trim(VirtualRegion* region, size_t start, size_t end) {
+    if (!region || !region->base || end > region->size || start >= end ||
+        end - start < 2 * VIRTUAL_REGION_TRIM_SLACK + VIRTUAL_REGION_COMMIT_STEP) {
+        return;
+    }
+
+    size_t lo = region_round_up(start + VIRTUAL_REGION_TRIM_SLACK, VIRTUAL_REGION_COMMIT_STEP);
+    size_t hi = region_round_down(end - VIRTUAL_REGION_TRIM_SLACK, VIRTUAL_REGION_COMMIT_STEP);
+    if (lo >= hi || (region->low <= lo && region->high >= hi)) {
+        return;
+    }
+
+    VirtualFree(region->base + lo, hi - lo, MEM_DECOMMIT);
+
+    /* Whatever each run kept outside the hole is still committed */
+    if (region->low > lo) {
+        region->low = lo;
+    }
+    if (region->high < hi) {
+        region->high = hi;
+    }
+}
+
+size_t virtual_region_committed(const VirtualRegion* region) {
+    if (!region || !region->base) {
+        return 0;
+    }
+
+    size_t committed = 0;
+    size_t offset = 0;
+    while (offset < region->size) {
+        MEMORY_BASIC_INFORMATION info;
+        if (VirtualQuery(region->base + offset, &info, sizeof(info)) == 0) {
+            break;
+        }
+        size_t length = info.RegionSize;
+        if (length > region->size - offset) {
+            length = region->size - offset;
+        }
+        if (info.State == MEM_COMMIT) {
+            committed += length;
+        }
+        offset += length;
+    }
+    return committed;
+}
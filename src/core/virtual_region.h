@@ -0,0 +1,127 @@
+/**
+ * @file virtual_region.h
+ * @brief Qalam IDE - Reserved Address Range With On-Demand Commit (Internal Header)
+ *
+ * Internal header for the storage behind a gap buffer created with
+ * QalamBufferOptions.virtual_memory. The whole range is reserved up
+ * front and pages are committed only where text lands, so the gap spans
+ * the uncommitted middle of the range and growing it never moves text.
+ *
+ * Commits are tracked as two runs, one up from the start of the range
+ * and one down from its end, which is how the text before and after a
+ * gap lies; committing next to either run only extends it, so edits at
+ * the gap make a system call once per VIRTUAL_REGION_COMMIT_STEP.
+ *
+ * @version 0.0.2
+ * @copyright (c) 2026 Qalam Project
+ *
+ * @note Thread Safety: Not thread-safe. Owned by a single QalamBuffer.
+ */
+
+#ifndef QALAM_VIRTUAL_REGION_H
+#define QALAM_VIRTUAL_REGION_H
+
+#include "qalam.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*=============================================================================
+ * Configuration Constants
+ *============================================================================*/
+
+/** Granularity of commits (bytes) */
+#define VIRTUAL_REGION_COMMIT_STEP  (64 * 1024)
+
+/** Committed bytes left on each side of a hole when it is decommitted */
+#define VIRTUAL_REGION_TRIM_SLACK   (1024 * 1024)
+
+/*=============================================================================
+ * Virtual Region Structures
+ *============================================================================*/
+
+/**
+ * @brief A reserved range of address space
+ *
+ * [0, low) and [high, size) are known to be committed; pages between
+ * them may be committed too (see virtual_region_commit()), which only
+ * costs a redundant commit later.
+ */
+typedef struct VirtualRegion {
+    uint8_t* base;              /**< Start of the range, or NULL if not reserved */
+    size_t size;                /**< Reserved bytes (a multiple of the commit step) */
+    size_t low;                 /**< End of the committed run at the start */
+    size_t high;                /**< Start of the committed run at the end */
+} VirtualRegion;
+
+/*=============================================================================
+ * Lifecycle
+ *============================================================================*/
+
+/**
+ * @brief Reserve a range without committing any of it
+ *
+ * @param region Region to set up
+ * @param size Bytes to reserve (rounded up to the commit step)
+ * @return QALAM_OK on success, QALAM_ERROR_OUT_OF_MEMORY if the address
+ *         space is not available
+ */
+QalamResult virtual_region_reserve(VirtualRegion* region, size_t size);
+
+/**
+ * @brief Zero every committed page and release the range
+ *
+ * Pages that were never committed are not touched.
+ *
+ * @param region Region to release (may be NULL or not reserved)
+ */
+void virtual_region_release(VirtualRegion* region);
+
+/*=============================================================================
+ * Commit and Decommit
+ *============================================================================*/
+
+/**
+ * @brief Make [offset, offset + length) writable
+ *
+ * Ranges that touch the run at the start or the end extend that run by
+ * whole commit steps; others commit just their own pages.
+ *
+ * @param region Reserved region
+ * @param offset Start of the range in bytes
+ * @param length Length of the range in bytes (clamped to the region)
+ * @return QALAM_OK on success, QALAM_ERROR_OUT_OF_MEMORY if the system
+ *         cannot back the pages
+ */
+QalamResult virtual_region_commit(VirtualRegion* region, size_t offset, size_t length);
+
+/**
+ * @brief Decommit the inside of a hole that holds nothing worth keeping
+ *
+ * Whole commit steps more than VIRTUAL_REGION_TRIM_SLACK inside
+ * [start, end) go back to the system; nothing happens unless the hole
+ * is at least twice the slack plus one step and reaches into a tracked
+ * run. Decommitted pages read as zero when committed again.
+ *
+ * @param region Reserved region
+ * @param start Start of the hole in bytes
+ * @param end End of the hole in bytes (exclusive)
+ */
+void virtual_region_trim(VirtualRegion* region, size_t start, size_t end);
+
+/**
+ * @brief Count the committed bytes of the range
+ *
+ * Asks the system, so pages committed outside the tracked runs count.
+ *
+ * @param region Reserved region
+ * @return Committed bytes, 0 if not reserved
+ */
+size_t virtual_region_committed(const VirtualRegion* region);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* QALAM_VIRTUAL_REGION_H */
@@ -0,0 +1,386 @@
+/**
+ * @file workspace.c
+ * @brief Qalam IDE - Workspace and Buffer Memory Policy Implementation
+ *
+ * Buffers are kept in the order they were added, each with the tick of
+ * its last use. The policy makes two passes: one by idle time (shrink,
+ * then hibernate), and one that hibernates the least recently used
+ * buffers while the total is over the budget. A workspace holds a few
+ * dozen buffers, so both scan the whole list.
+ *
+ * @version 0.0.2
+ * @copyright (c) 2026 Qalam Project
+ *
+ * @note Thread Safety: Not thread-safe. Use a workspace and its buffers
+ *       from one thread.
+ */
+
+#include "editor.h"
+#include <stdlib.h>
+#include <string.h>
+
+/*=============================================================================
+ * Configuration Constants
+ *============================================================================*/
+
+/** Default budget for the resident text of all buffers (bytes) */
+#define WORKSPACE_DEFAULT_BUDGET        (256 * 1024 * 1024)
+
+/** Default idle time before a buffer is shrunk */
+#define WORKSPACE_DEFAULT_SHRINK_MS     (30 * 1000)
+
+/** Default idle time before a buffer hibernates */
+#define WORKSPACE_DEFAULT_HIBERNATE_MS  (10 * 60 * 1000)
+
+/** Initial number of buffer slots */
+#define WORKSPACE_INITIAL_CAPACITY      16
+
+/*=============================================================================
+ * Internal Structures
+ *============================================================================*/
+
+/**
+ * @brief A buffer of the workspace
+ */
+typedef struct WorkspaceEntry {
+    QalamBuffer* buffer;            /**< Owned buffer */
+    uint64_t last_use;              /**< GetTickCount64() of the last focus or touch */
+    bool shrunk;                    /**< Shrunk since its last use */
+    bool tried;                     /**< Already picked by this budget pass */
+} WorkspaceEntry;
+
+/**
+ * @brief Workspace state
+ */
+struct QalamWorkspace {
+    WorkspaceEntry* entries;        /**< Buffers in the order they were added */
+    size_t count;                   /**< Entries in use */
+    size_t capacity;                /**< Allocated entries */
+    QalamBuffer* active;            /**< Focused buffer, or NULL */
+    QalamWorkspaceOptions options;  /**< Memory policy */
+    uint64_t shrinks;               /**< Buffers shrunk by the policy */
+    uint64_t hibernations;          /**< Buffers hibernated by the policy */
+    uint64_t rehydrations;          /**< Buffers woken by focus */
+};
+
+/*=============================================================================
+ * Internal Helper Functions
+ *============================================================================*/
+
+static WorkspaceEntry* workspace_find(const QalamWorkspace* workspace, const QalamBuffer* buffer) {
+    for (size_t i = 0; i < workspace->count; i++) {
+        if (workspace->entries[i].buffer == buffer) {
+            return &workspace->entries[i];
+        }
+    }
+    return NULL;
+}
+
+static void workspace_mark_used(WorkspaceEntry* entry) {
+    entry->last_use = GetTickCount64();
+    entry->shrunk = false;
+}
+
+static size_t workspace_resident_bytes(const QalamWorkspace* workspace) {
+    size_t bytes = 0;
+    for (size_t i = 0; i < workspace->count; i++) {
+        bytes += qalam_buffer_get_resident_size(workspace->entries[i].buffer);
+    }
+    return bytes;
+}
+
+/**
+ * @brief Shrink or hibernate one buffer, keeping the counters
+ *
+ * @return Resident bytes given back
+ */
+static size_t workspace_release(QalamWorkspace* workspace, WorkspaceEntry* entry, bool hibernate) {
+    size_t before = qalam_buffer_get_resident_size(entry->buffer);
+
+    if (hibernate) {
+        if (qalam_buffer_hibernate(entry->buffer) != QALAM_OK) {
+            return 0;
+        }
+        workspace->hibernations++;
+    } else {
+        /* Marked even if it fails, so it is not retried every pass */
+        entry->shrunk = true;
+        if (qalam_buffer_shrink_to_fit(entry->buffer) != QALAM_OK) {
+            return 0;
+        }
+        workspace->shrinks++;
+    }
+
+    size_t after = qalam_buffer_get_resident_size(entry->buffer);
+    return before > after ? before - after : 0;
+}
+
+/**
+ * @brief Find the least recently used buffer that could still hibernate
+ */
+static WorkspaceEntry* workspace_least_recent(QalamWorkspace* workspace) {
+    WorkspaceEntry* oldest = NULL;
+    for (size_t i = 0; i < workspace->count; i++) {
+        WorkspaceEntry* entry = &workspace->entries[i];
+        if (entry->tried || entry->buffer == workspace->active ||
+            qalam_buffer_is_hibernated(entry->buffer)) {
+            continue;
+        }
+        if (!oldest || entry->last_use < oldest->last_use) {
+            oldest = entry;
+        }
+    }
+    return oldest;
+}
+
+/*=============================================================================
+ * Lifecycle
+ *============================================================================*/
+
+QalamResult qalam_workspace_get_default_options(QalamWorkspaceOptions* options) {
+    if (!options) {
+        return QALAM_ERROR_NULL_POINTER;
+    }
+
+    options->memory_budget = WORKSPACE_DEFAULT_BUDGET;
+    options->shrink_after_ms = WORKSPACE_DEFAULT_SHRINK_MS;
+    options->hibernate_after_ms = WORKSPACE_DEFAULT_HIBERNATE_MS;
+    return QALAM_OK;
+}
+
+QalamResult qalam_workspace_create(QalamWorkspace** workspace,
+                                   const QalamWorkspaceOptions* options) {
+    if (!workspace) {
+        return QALAM_ERROR_NULL_POINTER;
+    }
+
+    QalamWorkspace* ws = (QalamWorkspace*)qalam_mem_calloc(QALAM_MEMORY_BUFFER, 1,
+                                                           sizeof(QalamWorkspace));
+    if (!ws) {
+        return QALAM_ERROR_OUT_OF_MEMORY;
+    }
+
+    if (options) {
+        ws->options = *options;
+    } else {
+        qalam_workspace_get_default_options(&ws->options);
+    }
+
+    *workspace = ws;
+    return QALAM_OK;
+}
+
+void qalam_workspace_destroy(QalamWorkspace* workspace) {
+    if (!workspace) {
+        return;
+    }
+
+    for (size_t i = 0; i < workspace->count; i++) {
+        qalam_buffer_destroy(workspace->entries[i].buffer);
+    }
+    qalam_mem_free(workspace->entries);
+    qalam_mem_free(workspace);
+}
+
+/*=============================================================================
+ * Buffers
+ *============================================================================*/
+
+QalamResult qalam_workspace_add(QalamWorkspace* workspace, QalamBuffer* buffer) {
+    if (!workspace || !buffer) {
+        return QALAM_ERROR_NULL_POINTER;
+    }
+    if (workspace_find(workspace, buffer)) {
+        return QALAM_ERROR_INVALID_ARGUMENT;
+    }
+
+    if (workspace->count == workspace->capacity) {
+        size_t capacity = workspace->capacity ? workspace->capacity * 2
+                                              : WORKSPACE_INITIAL_CAPACITY;
+        WorkspaceEntry* entries = (WorkspaceEntry*)qalam_mem_realloc(
+            QALAM_MEMORY_BUFFER, workspace->entries, capacity * sizeof(WorkspaceEntry));
+        if (!entries) {
+            return QALAM_ERROR_OUT_OF_MEMORY;
+        }
+        workspace->entries = entries;
+        workspace->capacity = capacity;
+    }
+
+    WorkspaceEntry* entry = &workspace->entries[workspace->count++];
+    entry->buffer = buffer;
+    entry->tried = false;
+    workspace_mark_used(entry);
+    return QALAM_OK;
+}
+
+QalamResult qalam_workspace_remove(QalamWorkspace* workspace, QalamBuffer* buffer) {
+    if (!workspace || !buffer) {
+        return QALAM_ERROR_NULL_POINTER;
+    }
+
+    WorkspaceEntry* entry = workspace_find(workspace, buffer);
+    if (!entry) {
+        return QALAM_ERROR_INVALID_ARGUMENT;
+    }
+
+    size_t index = (size_t)(entry - workspace->entries);
+    memmove(entry, entry + 1, (workspace->count - index - 1) * sizeof(WorkspaceEntry));
+    workspace->count--;
+
+    if (workspace->active == buffer) {
+        workspace->active = NULL;
+    }
+    return QALAM_OK;
+}
+
+QalamResult qalam_workspace_focus(QalamWorkspace* workspace, QalamBuffer* buffer) {
+    if (!workspace) {
+        return QALAM_ERROR_NULL_POINTER;
+    }
+    if (!buffer) {
+        workspace->active = NULL;
+        return QALAM_OK;
+    }
+
+    WorkspaceEntry* entry = workspace_find(workspace, buffer);
+    if (!entry) {
+        return QALAM_ERROR_INVALID_ARGUMENT;
+    }
+
+    workspace->active = buffer;
+    workspace_mark_used(entry);
+
+    if (!qalam_buffer_is_hibernated(buffer)) {
+        return QALAM_OK;
+    }
+    QalamResult result = qalam_buffer_rehydrate(buffer);
+    if (result == QALAM_OK) {
+        workspace->rehydrations++;
+    }
+    return result;
+}
+
+QalamResult qalam_workspace_touch(QalamWorkspace* workspace, QalamBuffer* buffer) {
+    if (!workspace || !buffer) {
+        return QALAM_ERROR_NULL_POINTER;
+    }
+
+    WorkspaceEntry* entry = workspace_find(workspace, buffer);
+    if (!entry) {
+        return QALAM_ERROR_INVALID_ARGUMENT;
+    }
+
+    workspace_mark_used(entry);
+    return QALAM_OK;
+}
+
+QalamBuffer* qalam_workspace_get_active(const QalamWorkspace* workspace) {
+    return workspace ? workspace->active : NULL;
+}
+
+size_t qalam_workspace_get_count(const QalamWorkspace* workspace) {
+    return workspace ? workspace->count : 0;
+}
+
+QalamBuffer* qalam_workspace_get_buffer(const QalamWorkspace* workspace, size_t index) {
+    if (!workspace || index >= workspace->count) {
+        return NULL;
+    }
+    return workspace->entries[index].buffer;
+}
+
+/*=============================================================================
+ * Memory Policy
+ *============================================================================*/
+
+QalamResult qalam_workspace_set_options(QalamWorkspace* workspace,
+                                        const QalamWorkspaceOptions* options) {
+    if (!workspace || !options) {
+        return QALAM_ERROR_NULL_POINTER;
+    }
+
+    workspace->options = *options;
+    return QALAM_OK;
+}
+
+QalamResult qalam_workspace_get_options(const QalamWorkspace* workspace,
+                                        QalamWorkspaceOptions* options) {
+    if (!workspace || !options) {
+        return QALAM_ERROR_NULL_POINTER;
+    }
+
+    *options = workspace->options;
+    return QALAM_OK;
+}
+
+QalamResult qalam_workspace_apply_policy(QalamWorkspace* workspace) {
+    if (!workspace) {
+        return QALAM_ERROR_NULL_POINTER;
+    }
+
+    const QalamWorkspaceOptions* options = &workspace->options;
+    uint64_t now = GetTickCount64();
+
+    /* Idle buffers first, however much memory is free */
+    for (size_t i = 0; i < workspace->count; i++) {
+        WorkspaceEntry* entry = &workspace->entries[i];
+        if (entry->buffer == workspace->active || qalam_buffer_is_hibernated(entry->buffer)) {
+            continue;
+        }
+
+        uint64_t idle = now - entry->last_use;
+        if (options->hibernate_after_ms && idle >= options->hibernate_after_ms) {
+            workspace_release(workspace, entry, true);
+        } else if (options->shrink_after_ms && !entry->shrunk &&
+                   idle >= options->shrink_after_ms) {
+            workspace_release(workspace, entry, false);
+        }
+    }
+
+    if (options->memory_budget == 0 || workspace->count == 0) {
+        return QALAM_OK;
+    }
+
+    size_t resident = workspace_resident_bytes(workspace);
+    if (resident <= options->memory_budget) {
+        return QALAM_OK;
+    }
+
+    /* Over budget: every inactive buffer shrinks, then the least recent hibernate */
+    for (size_t i = 0; i < workspace->count; i++) {
+        WorkspaceEntry* entry = &workspace->entries[i];
+        entry->tried = false;
+        if (entry->buffer != workspace->active && !entry->shrunk &&
+            !qalam_buffer_is_hibernated(entry->buffer)) {
+            resident -= workspace_release(workspace, entry, false);
+        }
+    }
+
+    WorkspaceEntry* entry;
+    while (resident > options->memory_budget &&
+           (entry = workspace_least_recent(workspace)) != NULL) {
+        entry->tried = true;
+        resident -= workspace_release(workspace, entry, true);
+    }
+    return QALAM_OK;
+}
+
+QalamResult qalam_workspace_get_stats(const QalamWorkspace* workspace, QalamWorkspaceStats* stats) {
+    if (!workspace || !stats) {
+        return QALAM_ERROR_NULL_POINTER;
+    }
+
+    memset(stats, 0, sizeof(QalamWorkspaceStats));
+    stats->buffer_count = workspace->count;
+    for (size_t i = 0; i < workspace->count; i++) {
+        const QalamBuffer* buffer = workspace->entries[i].buffer;
+        stats->resident_bytes += qalam_buffer_get_resident_size(buffer);
+        if (qalam_buffer_is_hibernated(buffer)) {
+            stats->hibernated_count++;
+        }
+    }
+    stats->shrinks = workspace->shrinks;
+    stats->hibernations = workspace->hibernations;
+    stats->rehydrations = workspace->rehydrations;
+    return QALAM_OK;
+}
@@ -48,7 +48,7 @@ static void cleanup_application(void);
  *============================================================================*/
 
 static QalamWindow* g_main_window = NULL;
-static QalamBuffer* g_active_buffer = NULL;
+static QalamWorkspace* g_workspace = NULL;
 static QalamTerminal* g_terminal = NULL;
 static bool g_is_running = false;
 
@@ -77,10 +77,15 @@ int WINAPI WinMain(
     
     int exit_code = 0;
     
+    /* Startup phases are timed from here (see qalam_trace_get_startup()) */
+    qalam_trace_startup_mark(QALAM_STARTUP_BEGIN);
+    
     /*-------------------------------------------------------------------------
      * Step 1: Initialize UTF-8 Console Support
      *------------------------------------------------------------------------*/
-    if (!initialize_utf8_console()) {
+    /* A GUI process usually has no console; loading the UTF-8 locale for
+     * one would only delay the first frame */
+    if (GetConsoleWindow() && !initialize_utf8_console()) {
         /* Non-fatal: console output may not display Arabic correctly */
         OutputDebugStringW(L"[Qalam] Warning: Failed to initialize UTF-8 console\n");
     }
@@ -122,6 +127,7 @@ int main(int argc, char* argv[])
     (void)argc;
     (void)argv;
     
+    qalam_trace_startup_mark(QALAM_STARTUP_BEGIN);
     HINSTANCE hInstance = GetModuleHandleW(NULL);
     
     /* Initialize UTF-8 console */
@@ -271,6 +277,44 @@ static int run_application(HINSTANCE hInstance, int nCmdShow)
     }
     */
     
+    /* Registers the "Qalam" ETW provider in tracing builds; spans are
+     * counted for the overlay either way */
+    result = qalam_trace_init();
+    if (result != QALAM_OK) {
+        OutputDebugStringW(L"[Qalam] Failed to register trace provider\n");
+    }
+    
+    /*-------------------------------------------------------------------------
+     * Start Background Work
+     *------------------------------------------------------------------------*/
+    
+    /* TODO: Start font loading and file loading before the window */
+    /*
+    // qalam_dwrite_init() only creates the factories. The system fonts,
+    // the Arabic family choice and the editor's text format come from a
+    // worker thread, with the family chosen by the last run read from
+    // %LOCALAPPDATA%\Qalam\fonts.cache instead of probing the fonts
+    result = qalam_dwrite_init();
+    if (result != QALAM_OK) {
+        OutputDebugStringW(L"[Qalam] Failed to initialize DirectWrite\n");
+        qalam_shutdown();
+        return 1;
+    }
+    
+    QalamDWriteFontPreloadOptions font_options;
+    qalam_dwrite_font_preload_get_default_options(&font_options);
+    font_options.family = L"Segoe UI";
+    font_options.size = 16.0f;
+    font_options.cache_path = g_font_cache_path;
+    g_fonts_ready = CreateEventW(NULL, FALSE, FALSE, NULL);
+    font_options.ready = on_fonts_ready_signal;
+    font_options.user_data = g_fonts_ready;
+    result = qalam_dwrite_font_preload_start(&font_options, &g_font_preload);
+    if (result != QALAM_OK) {
+        OutputDebugStringW(L"[Qalam] Failed to start font loading\n");
+    }
+    */
+    
     /*-------------------------------------------------------------------------
      * Create Main Window
      *------------------------------------------------------------------------*/
@@ -296,6 +340,15 @@ static int run_application(HINSTANCE hInstance, int nCmdShow)
         qalam_shutdown();
         return 1;
     }
+    qalam_trace_startup_mark(QALAM_STARTUP_WINDOW);
+    
+    // The first frame is just the editor background: it needs neither
+    // fonts nor the file, so the window shows while both are loading
+    qalam_dwrite_render_target_create(qalam_window_get_hwnd(g_main_window), &g_render_target);
+    qalam_dwrite_render_begin(g_render_target);
+    qalam_dwrite_render_clear(g_render_target, g_theme_background);
+    qalam_dwrite_render_end(g_render_target);
+    qalam_trace_startup_mark(QALAM_STARTUP_FIRST_PAINT);
     */
     
     /*-------------------------------------------------------------------------
@@ -304,13 +357,35 @@ static int run_application(HINSTANCE hInstance, int nCmdShow)
     
     /* TODO: Create empty buffer for editing */
     /*
-    result = qalam_buffer_create(&g_active_buffer);
+    // Open buffers live in the workspace, which hibernates the ones not
+    // used for a while and keeps them all within its memory budget.
+    // Opened after the first frame and while fonts load: a file named on
+    // the command line returns with its first 64 KB, and the rest is
+    // read and decoded on worker threads
+    QalamBufferOptions buffer_options;
+    qalam_buffer_get_default_options(&buffer_options);
+    buffer_options.background_load = true;
+    QalamBuffer* buffer = NULL;
+    result = qalam_workspace_create(&g_workspace, NULL);
+    if (result == QALAM_OK && g_initial_path) {
+        result = qalam_buffer_create_from_file_with_options(&buffer, g_initial_path,
+                                                            &buffer_options);
+        qalam_trace_startup_mark(QALAM_STARTUP_FILE_LOADED);
+    } else if (result == QALAM_OK) {
+        result = qalam_buffer_create(&buffer);
+    }
+    if (result == QALAM_OK) {
+        result = qalam_workspace_add(g_workspace, buffer);
+    }
     if (result != QALAM_OK) {
         OutputDebugStringW(L"[Qalam] Failed to create buffer\n");
+        qalam_buffer_destroy(buffer);
+        qalam_workspace_destroy(g_workspace);
         qalam_window_destroy(g_main_window);
         qalam_shutdown();
         return 1;
     }
+    qalam_workspace_focus(g_workspace, buffer);
     */
     
     /*-------------------------------------------------------------------------
@@ -325,7 +400,36 @@ static int run_application(HINSTANCE hInstance, int nCmdShow)
         exit_code = 1;
     } else {
         g_is_running = true;
-        exit_code = qalam_window_run(g_main_window);
+        
+        // Drains all pending input, types it into the buffer in one insert
+        // and draws at most one frame per vblank; sleeps when nothing is dirty
+        frame_scheduler_create(&g_scheduler, g_render_target, NULL);
+        trace_overlay_create(&g_trace_overlay, g_render_target, g_text_format, NULL);
+        frame_scheduler_set_buffer(g_scheduler, qalam_workspace_get_active(g_workspace));
+        // Every few seconds: shrink and hibernate idle buffers
+        LARGE_INTEGER due = { .QuadPart = -5 * 10000000LL };
+        g_policy_timer = CreateWaitableTimerW(NULL, FALSE, NULL);
+        SetWaitableTimer(g_policy_timer, &due, 5000, NULL, NULL, FALSE);
+        frame_scheduler_add_handle(g_scheduler, g_policy_timer, on_policy_timer, NULL);
+        frame_scheduler_set_frame_callback(g_scheduler, paint_frame, NULL);
+        frame_scheduler_add_handle(g_scheduler, qalam_terminal_get_output_waitable(g_terminal),
+                                   on_terminal_output, NULL);
+        // Lines are lexed on a worker, viewport first; its ready callback
+        // sets an event, and on_highlight_ready() calls
+        // qalam_highlighter_update() and invalidates the lines it reports.
+        // The buffer's change callback forwards to the highlighter too.
+        QalamHighlighterOptions highlight_options;
+        qalam_highlighter_get_default_options(&highlight_options);
+        g_highlight_ready = CreateEventW(NULL, FALSE, FALSE, NULL);
+        highlight_options.ready = on_highlighter_ready;
+        highlight_options.user_data = g_highlight_ready;
+        qalam_highlighter_create(&g_highlighter, qalam_workspace_get_active(g_workspace),
+                                 &highlight_options);
+        frame_scheduler_add_handle(g_scheduler, g_highlight_ready, on_highlight_ready, NULL);
+        // The editor view is created by on_fonts_ready() once the preload
+        // has its text format; until then frames draw the background only
+        frame_scheduler_add_handle(g_scheduler, g_fonts_ready, on_fonts_ready, NULL);
+        exit_code = frame_scheduler_run(g_scheduler);
     }
     */
     
@@ -333,9 +437,6 @@ static int run_application(HINSTANCE hInstance, int nCmdShow)
      * Placeholder: Simple message box for testing
      *------------------------------------------------------------------------*/
     
-    result = QALAM_OK;  /* Suppress unused variable warning */
-    (void)result;
-    
     MessageBoxW(
         NULL,
         L"Qalam IDE - محرر قلم\n\n"
@@ -358,15 +459,29 @@ static void cleanup_application(void)
     
     /* TODO: Cleanup in reverse order of initialization */
     /*
+    trace_overlay_destroy(g_trace_overlay);
+    g_trace_overlay = NULL;
+    
+    frame_scheduler_destroy(g_scheduler);
+    g_scheduler = NULL;
+    
+    // Waits for the worker if fonts were still loading
+    qalam_dwrite_font_preload_destroy(g_font_preload);
+    g_font_preload = NULL;
+    CloseHandle(g_fonts_ready);
+    g_fonts_ready = NULL;
+    
     if (g_terminal) {
         qalam_terminal_destroy(g_terminal);
         g_terminal = NULL;
     }
     
-    if (g_active_buffer) {
-        qalam_buffer_destroy(g_active_buffer);
-        g_active_buffer = NULL;
-    }
+    CloseHandle(g_policy_timer);
+    g_policy_timer = NULL;
+    
+    // Destroys every open buffer
+    qalam_workspace_destroy(g_workspace);
+    g_workspace = NULL;
     
     if (g_main_window) {
         qalam_window_destroy(g_main_window);
@@ -376,6 +491,8 @@ static void cleanup_application(void)
     qalam_shutdown();
     */
     
+    qalam_trace_shutdown();
+    
     OutputDebugStringW(L"[Qalam] Application cleanup complete\n");
 }
 
@@ -383,6 +500,108 @@ static void cleanup_application(void)
  * Event Handlers (Stubs for future implementation)
  *============================================================================*/
 
+/**
+ * @brief Invalidate only the rows of the editor view that changed
+ * 
+ * Edits reach the view through the buffer's change callback
+ * (editor_view_on_buffer_change()), which marks the rows they touched.
+ */
+#if 0  /* Will be enabled when UI is implemented */
+static void invalidate_editor_view(QalamWindow* window)
+{
+    QalamRect rects[EDITOR_VIEW_MAX_DIRTY_RECTS];
+    size_t count = editor_view_get_dirty_rects(g_editor_view, rects, EDITOR_VIEW_MAX_DIRTY_RECTS);
+    
+    for (size_t i = 0; i < count && i < EDITOR_VIEW_MAX_DIRTY_RECTS; i++) {
+        qalam_window_invalidate_rect(window, &rects[i]);
+    }
+    frame_scheduler_invalidate(g_scheduler);
+}
+#endif
+
+/**
+ * @brief Draw one frame, called by the frame scheduler
+ * 
+ * Only when something changed, and no more than once per vblank.
+ */
+#if 0  /* Will be enabled when UI is implemented */
+static void paint_frame(void* user_data)
+{
+    (void)user_data;
+    
+    trace_overlay_begin_frame(g_trace_overlay);
+    editor_view_submit_dirty_rects(g_editor_view, g_render_target);
+    terminal_view_submit_dirty_rects(g_terminal_view);
+    qalam_dwrite_render_begin(g_render_target);
+    editor_view_layout(g_editor_view);
+    editor_view_draw_selection(g_editor_view, g_render_target, g_selection_brush);
+    editor_view_draw_text(g_editor_view, g_render_target, g_text_brush);
+    terminal_view_render(g_terminal_view);
+    trace_overlay_render(g_trace_overlay);
+    qalam_dwrite_render_end(g_render_target);
+    trace_overlay_end_frame(g_trace_overlay);
+    if (g_first_text_pending) {
+        g_first_text_pending = false;
+        qalam_trace_startup_mark(QALAM_STARTUP_FIRST_TEXT);
+    }
+}
+
+/**
+ * @brief Take the terminal's output into its screen
+ * 
+ * @return true if the terminal view has something to draw
+ */
+static bool on_terminal_output(HANDLE handle, void* user_data)
+{
+    (void)handle;
+    (void)user_data;
+    
+    qalam_terminal_poll(g_terminal, NULL);
+    return terminal_view_is_dirty(g_terminal_view);
+}
+
+/**
+ * @brief Set the fonts-ready event; called on the font preload's thread
+ */
+static void on_fonts_ready_signal(void* user_data)
+{
+    SetEvent((HANDLE)user_data);
+}
+
+/**
+ * @brief Create the editor view with the preloaded text format
+ * 
+ * @return true; the next frame is the first with text
+ */
+static bool on_fonts_ready(HANDLE handle, void* user_data)
+{
+    (void)handle;
+    (void)user_data;
+    
+    qalam_dwrite_font_preload_wait(g_font_preload, &g_text_format);
+    editor_view_create(&g_editor_view, g_text_format, NULL);
+    editor_view_set_buffer(g_editor_view, qalam_workspace_get_active(g_workspace));
+    editor_view_set_highlighter(g_editor_view, g_highlighter, g_style_brushes,
+                                QALAM_SYNTAX_STYLE_COUNT);
+    g_first_text_pending = true;
+    return true;
+}
+
+/**
+ * @brief Apply the workspace memory policy
+ * 
+ * @return false; hibernating buffers draws nothing
+ */
+static bool on_policy_timer(HANDLE handle, void* user_data)
+{
+    (void)handle;
+    (void)user_data;
+    
+    qalam_workspace_apply_policy(g_workspace);
+    return false;
+}
+#endif
+
 /**
  * @brief Handle window events
  * 
@@ -403,22 +622,37 @@ static bool on_window_event(QalamWindow* window, const QalamEvent* event, void*
             
         case QALAM_EVENT_RESIZE:
             /* Handle window resize */
+            /* editor_view_resize(g_editor_view, width_dips, height_dips, dpi); */
+            qalam_window_invalidate(window);
+            return true;
+            
+        case QALAM_EVENT_MOUSE_WHEEL:
+            /* Scroll the editor view; only lines coming into view are laid out */
+            /* editor_view_scroll_by(g_editor_view, -event->data.mouse.wheel_delta); */
             qalam_window_invalidate(window);
             return true;
             
         case QALAM_EVENT_PAINT:
-            /* Handle paint request */
-            /* render_editor(window, g_active_buffer); */
+            /* Drawn by paint_frame() on the scheduler's next frame, clipped
+             * to and presented as the views' dirty rects */
+            /* frame_scheduler_invalidate(g_scheduler); */
             return true;
             
         case QALAM_EVENT_KEY_DOWN:
-            /* Handle keyboard input */
-            /* handle_key_input(window, g_active_buffer, event); */
+            /* Handle keyboard input; Left/Right move in visual order.
+             * Characters typed before the key go in first. */
+            /* F12 shows or hides the tracing overlay (hiding it also
+             * invalidates the views beneath) */
+            /* frame_scheduler_flush_input(g_scheduler); */
+            /* editor_view_move_cursor_visual(g_editor_view, direction); */
+            /* handle_key_input(window, qalam_workspace_get_active(g_workspace), event); */
+            /* invalidate_editor_view(window); */
             return false;  /* Allow default processing */
             
         case QALAM_EVENT_CHAR:
-            /* Handle character input */
-            /* handle_char_input(g_active_buffer, event->data.character.codepoint); */
+            /* Queued, and inserted with the rest of the burst before the
+             * next frame */
+            /* frame_scheduler_queue_char(g_scheduler, event->data.character.codepoint); */
             return true;
             
         default:
@@ -0,0 +1,1019 @@
+/**
+ * @file conpty.c
+ * @brief Qalam IDE - ConPTY Terminal Implementation
+ *
+ * Each terminal owns a pseudoconsole and two pipes. Input is an
+ * anonymous pipe written synchronously from the caller's thread. Output
+ * is a named pipe opened for overlapped I/O, read by a dedicated reader
+ * thread in reads of up to TERMINAL_READ_SIZE bytes straight into the
+ * free space of an OutputRing. The thread that owns the terminal drains
+ * the ring in qalam_terminal_poll(), once per frame, and hands the whole
+ * batch to the output callback; neither side takes a lock or allocates
+ * per read.
+ *
+ * When the ring has less than TERMINAL_MIN_READ bytes free the reader
+ * stops reading and waits for the owner to consume. The output pipe then
+ * fills up and the console's writes block, which slows the process down
+ * to the rate the terminal is drained at.
+ *
+ * Closing a pseudoconsole waits for its console host to exit, and the
+ * host may be blocked writing output. So destroy switches the reader to
+ * discarding output and keeps it reading until ClosePseudoConsole()
+ * breaks the pipe, instead of stopping it first.
+ *
+ * Polling also runs the output through the terminal's TerminalScreen,
+ * so the grid of cells a view draws is up to date before the callback
+ * sees the same bytes. Rows that scroll off the screen are kept in the
+ * screen's Scrollback store within the memory budget in the options (see
+ * terminal_screen.h and scrollback.h).
+ *
+ * @version 0.0.2
+ * @copyright (c) 2026 Qalam Project
+ *
+ * @note Thread Safety: Every function must be called from the thread
+ *       that owns the terminal; only the reader thread runs beside it.
+ */
+
+#include "terminal.h"
+#include "output_ring.h"
+#include "terminal_screen.h"
+#include <stdlib.h>
+#include <string.h>
+#include <wchar.h>
+
+/** Default output ring size */
+#define TERMINAL_DEFAULT_OUTPUT_BUFFER  (4 * 1024 * 1024)
+
+/** Largest single read from the output pipe */
+#define TERMINAL_READ_SIZE              (256 * 1024)
+
+/** Free ring space the reader waits for before it reads again */
+#define TERMINAL_MIN_READ               (16 * 1024)
+
+/** Buffer size requested for the output pipe */
+#define TERMINAL_PIPE_BUFFER            (1024 * 1024)
+
+/** Default terminal size in cells */
+#define TERMINAL_DEFAULT_COLS           120
+#define TERMINAL_DEFAULT_ROWS           30
+
+/** Time a process gets to exit after Ctrl+C before it is terminated */
+#define TERMINAL_GRACEFUL_TIMEOUT_MS    1000
+
+/** terminal_read_pipe() result for a read that returned no bytes */
+#define TERMINAL_READ_EMPTY             ((DWORD)-1)
+
+/** Longest pipe name */
+#define TERMINAL_PIPE_NAME_LENGTH       64
+
+/*=============================================================================
+ * Internal Structures
+ *============================================================================*/
+
+/**
+ * @brief Terminal state
+ */
+struct QalamTerminal {
+    QalamTerminalOptions options;   /**< Options, strings owned by the terminal */
+    QalamTerminalState state;       /**< Current state */
+    QalamTerminalSize size;         /**< Current size in cells */
+    UINT codepage;                  /**< Code page for shells spawned next */
+
+    /* Pseudoconsole and process */
+    HPCON console;                  /**< Pseudoconsole, or NULL */
+    HANDLE input_write;             /**< Our end of the input pipe */
+    HANDLE output_read;             /**< Our end of the output pipe (overlapped) */
+    HANDLE output_write;            /**< Console end of the output pipe, until handed over */
+    PROCESS_INFORMATION process;    /**< Spawned process (handles NULL if none) */
+    DWORD exit_code;                /**< Exit code once the process has exited */
+
+    /* Reader thread */
+    OutputRing* ring;               /**< Output read but not yet delivered */
+    HANDLE reader;                  /**< Reader thread, or NULL */
+    HANDLE stop_event;              /**< Manual-reset: ends the reader's waits for space */
+    HANDLE output_event;            /**< Auto-reset: set after each read */
+    volatile LONG closing;          /**< Set once the reader should discard output */
+    volatile LONG reader_error;     /**< First error the reader ran into */
+
+    /* Screen contents */
+    TerminalScreen* screen;         /**< Cells on screen and the scrollback */
+
+    /* Callbacks */
+    QalamTerminalOutputCallback output_callback; /**< Output callback, or NULL */
+    void* output_user_data;         /**< Context for 'output_callback' */
+    QalamTerminalStateCallback state_callback; /**< State callback, or NULL */
+    void* state_user_data;          /**< Context for 'state_callback' */
+};
+
+/** Tells the output pipes of this process apart */
+static volatile LONG g_pipe_serial = 0;
+
+/*=============================================================================
+ * Internal Helper Functions
+ *============================================================================*/
+
+/**
+ * @brief Copy a string (NULL stays NULL)
+ */
+static QalamResult terminal_copy_string(const wchar_t* text, const wchar_t** out) {
+    *out = NULL;
+    if (!text) {
+        return QALAM_OK;
+    }
+
+    size_t length = wcslen(text) + 1;
+    wchar_t* copy = (wchar_t*)qalam_mem_alloc(QALAM_MEMORY_TERMINAL, length * sizeof(wchar_t));
+    if (!copy) {
+        return QALAM_ERROR_OUT_OF_MEMORY;
+    }
+    memcpy(copy, text, length * sizeof(wchar_t));
+    *out = copy;
+    return QALAM_OK;
+}
+
+/**
+ * @brief Copy an environment block, which ends with an empty string
+ */
+static QalamResult terminal_copy_environment(const wchar_t* block, const wchar_t** out) {
+    *out = NULL;
+    if (!block) {
+        return QALAM_OK;
+    }
+
+    size_t length = 0;
+    while (block[length] || block[length + 1]) {
+        length++;
+    }
+    length += 2;
+
+    wchar_t* copy = (wchar_t*)qalam_mem_alloc(QALAM_MEMORY_TERMINAL, length * sizeof(wchar_t));
+    if (!copy) {
+        return QALAM_ERROR_OUT_OF_MEMORY;
+    }
+    memcpy(copy, block, length * sizeof(wchar_t));
+    *out = copy;
+    return QALAM_OK;
+}
+
+/**
+ * @brief Columns or rows of the screen for a console dimension
+ */
+static size_t terminal_grid_extent(short extent) {
+    return extent > TERMINAL_SCREEN_MAX_SIZE ? TERMINAL_SCREEN_MAX_SIZE : (size_t)extent;
+}
+
+/**
+ * @brief Change state and tell the state callback
+ */
+static void terminal_set_state(QalamTerminal* terminal, QalamTerminalState state) {
+    QalamTerminalState old_state = terminal->state;
+    if (old_state == state) {
+        return;
+    }
+
+    terminal->state = state;
+    if (terminal->state_callback) {
+        terminal->state_callback(terminal, old_state, state, terminal->state_user_data);
+    }
+}
+
+/**
+ * @brief Close the handles of the spawned process
+ */
+static void terminal_release_process(QalamTerminal* terminal) {
+    if (terminal->process.hThread) {
+        CloseHandle(terminal->process.hThread);
+    }
+    if (terminal->process.hProcess) {
+        CloseHandle(terminal->process.hProcess);
+    }
+    memset(&terminal->process, 0, sizeof(PROCESS_INFORMATION));
+}
+
+/**
+ * @brief Record the exit of a process that has stopped
+ */
+static void terminal_note_exit(QalamTerminal* terminal) {
+    DWORD exit_code = 0;
+    if (GetExitCodeProcess(terminal->process.hProcess, &exit_code)) {
+        terminal->exit_code = exit_code;
+    }
+    terminal_set_state(terminal, QALAM_TERMINAL_EXITED);
+}
+
+/**
+ * @brief Create the output pipe: an overlapped named pipe
+ *
+ * Anonymous pipes do not support overlapped I/O, so the output pipe is a
+ * single-instance named pipe private to this process.
+ */
+static QalamResult terminal_create_output_pipe(QalamTerminal* terminal) {
+    wchar_t name[TERMINAL_PIPE_NAME_LENGTH];
+    swprintf(name, TERMINAL_PIPE_NAME_LENGTH, L"\\\\.\\pipe\\qalam-terminal-%lu-%ld",
+             (unsigned long)GetCurrentProcessId(), (long)InterlockedIncrement(&g_pipe_serial));
+
+    terminal->output_read = CreateNamedPipeW(
+        name, PIPE_ACCESS_INBOUND | FILE_FLAG_OVERLAPPED | FILE_FLAG_FIRST_PIPE_INSTANCE,
+        PIPE_TYPE_BYTE | PIPE_READMODE_BYTE | PIPE_WAIT | PIPE_REJECT_REMOTE_CLIENTS,
+        1, 0, TERMINAL_PIPE_BUFFER, 0, NULL);
+    if (terminal->output_read == INVALID_HANDLE_VALUE) {
+        terminal->output_read = NULL;
+        return QALAM_ERROR_PIPE_CREATE;
+    }
+
+    terminal->output_write = CreateFileW(name, GENERIC_WRITE, 0, NULL, OPEN_EXISTING,
+                                         FILE_ATTRIBUTE_NORMAL, NULL);
+    if (terminal->output_write == INVALID_HANDLE_VALUE) {
+        terminal->output_write = NULL;
+        return QALAM_ERROR_PIPE_CREATE;
+    }
+    return QALAM_OK;
+}
+
+/**
+ * @brief Wait for one overlapped read to finish
+ *
+ * @return Bytes read, TERMINAL_READ_EMPTY for an empty read, or 0 once
+ *         the pipe is closed or broken
+ */
+static DWORD terminal_read_pipe(QalamTerminal* terminal, OVERLAPPED* overlapped,
+                                char* target, DWORD length) {
+    DWORD bytes = 0;
+
+    ResetEvent(overlapped->hEvent);
+    if (!ReadFile(terminal->output_read, target, length, NULL, overlapped) &&
+        GetLastError() != ERROR_IO_PENDING) {
+        DWORD error = GetLastError();
+        if (error != ERROR_BROKEN_PIPE && error != ERROR_PIPE_NOT_CONNECTED) {
+            InterlockedCompareExchange(&terminal->reader_error, QALAM_ERROR_IO_READ, QALAM_OK);
+        }
+        return 0;
+    }
+
+    if (!GetOverlappedResult(terminal->output_read, overlapped, &bytes, TRUE)) {
+        DWORD error = GetLastError();
+        if (error != ERROR_BROKEN_PIPE && error != ERROR_OPERATION_ABORTED) {
+            InterlockedCompareExchange(&terminal->reader_error, QALAM_ERROR_IO_READ, QALAM_OK);
+        }
+        return 0;
+    }
+
+    /* A zero-byte write reads as zero bytes from an open pipe; keep 0
+     * for a closed one */
+    return bytes > 0 ? bytes : TERMINAL_READ_EMPTY;
+}
+
+/**
+ * @brief Reader thread: move console output into the ring until the pipe closes
+ */
+static DWORD WINAPI terminal_reader(LPVOID param) {
+    QalamTerminal* terminal = (QalamTerminal*)param;
+    OutputRing* ring = terminal->ring;
+    char discard[4096];
+
+    OVERLAPPED overlapped;
+    memset(&overlapped, 0, sizeof(overlapped));
+    overlapped.hEvent = CreateEventW(NULL, TRUE, FALSE, NULL);
+    if (!overlapped.hEvent) {
+        InterlockedCompareExchange(&terminal->reader_error, QALAM_ERROR_OUT_OF_MEMORY, QALAM_OK);
+        return 0;
+    }
+
+    for (;;) {
+        bool closing = InterlockedCompareExchange(&terminal->closing, 0, 0) != 0;
+        char* target = discard;
+        size_t length = sizeof(discard);
+
+        if (!closing) {
+            /* Backpressure: leave the output in the pipe until the owner
+             * catches up */
+            if (output_ring_free_space(ring) < TERMINAL_MIN_READ) {
+                QALAM_TRACE_BEGIN(stall, QALAM_TRACE_TERMINAL_IO, "reader_stall");
+                output_ring_wait_space(ring, TERMINAL_MIN_READ, terminal->stop_event, INFINITE);
+                QALAM_TRACE_END(stall);
+                continue;
+            }
+
+            target = output_ring_write_span(ring, &length);
+            if (length > TERMINAL_READ_SIZE) {
+                length = TERMINAL_READ_SIZE;
+            }
+        }
+
+        DWORD bytes = terminal_read_pipe(terminal, &overlapped, target, (DWORD)length);
+        if (bytes == 0) {
+            break;
+        }
+        if (closing || bytes == TERMINAL_READ_EMPTY) {
+            continue;
+        }
+
+        output_ring_commit(ring, bytes);
+        SetEvent(terminal->output_event);
+        QALAM_TRACE_COUNTER(QALAM_TRACE_TERMINAL_IO, "read_bytes", bytes);
+    }
+
+    CloseHandle(overlapped.hEvent);
+    SetEvent(terminal->output_event);
+    return 0;
+}
+
+/**
+ * @brief Get the default shell's path
+ *
+ * @param[out] path Receives the path
+ * @param capacity Characters available in 'path'
+ */
+static void terminal_default_shell(wchar_t* path, DWORD capacity) {
+    DWORD length = GetEnvironmentVariableW(L"ComSpec", path, capacity);
+    if (length == 0 || length >= capacity) {
+        wcsncpy(path, L"cmd.exe", capacity);
+        path[capacity - 1] = L'\0';
+    }
+}
+
+/**
+ * @brief Write all of 'data' to the input pipe
+ */
+static QalamResult terminal_write_all(QalamTerminal* terminal, const char* data, size_t length,
+                                      size_t* bytes_written) {
+    size_t done = 0;
+    QalamResult result = QALAM_OK;
+
+    while (done < length) {
+        DWORD chunk = length - done > 0x40000000 ? 0x40000000 : (DWORD)(length - done);
+        DWORD written = 0;
+        if (!WriteFile(terminal->input_write, data + done, chunk, &written, NULL) ||
+            written == 0) {
+            result = QALAM_ERROR_IO_WRITE;
+            break;
+        }
+        done += written;
+    }
+
+    if (bytes_written) {
+        *bytes_written = done;
+    }
+    return result;
+}
+
+/*=============================================================================
+ * Terminal Creation and Destruction
+ *============================================================================*/
+
+QalamResult qalam_terminal_get_default_options(QalamTerminalOptions* options) {
+    if (!options) {
+        return QALAM_ERROR_NULL_POINTER;
+    }
+
+    memset(options, 0, sizeof(QalamTerminalOptions));
+    options->size.cols = TERMINAL_DEFAULT_COLS;
+    options->size.rows = TERMINAL_DEFAULT_ROWS;
+    options->shell_path = NULL;
+    options->working_dir = NULL;
+    options->environment = NULL;
+    options->inherit_handles = false;
+    options->enable_vt_processing = true;
+    options->start_hidden = true;
+    options->output_buffer_size = TERMINAL_DEFAULT_OUTPUT_BUFFER;
+    options->scrollback_budget = SCROLLBACK_DEFAULT_BUDGET;
+
+    return QALAM_OK;
+}
+
+QalamResult qalam_terminal_create(QalamTerminal** terminal, const QalamTerminalOptions* options) {
+    if (!terminal) {
+        return QALAM_ERROR_NULL_POINTER;
+    }
+
+    *terminal = NULL;
+
+    QalamTerminalOptions defaults;
+    qalam_terminal_get_default_options(&defaults);
+    if (!options) {
+        options = &defaults;
+    }
+    if (options->size.cols <= 0 || options->size.rows <= 0) {
+        return QALAM_ERROR_INVALID_ARGUMENT;
+    }
+
+    QalamTerminal* t = (QalamTerminal*)qalam_mem_calloc(QALAM_MEMORY_TERMINAL, 1,
+                                                        sizeof(QalamTerminal));
+    if (!t) {
+        return QALAM_ERROR_OUT_OF_MEMORY;
+    }
+    t->options = *options;
+    t->options.shell_path = NULL;
+    t->options.working_dir = NULL;
+    t->options.environment = NULL;
+    t->size = options->size;
+    t->codepage = CP_UTF8;
+
+    QalamResult result = terminal_copy_string(options->shell_path, &t->options.shell_path);
+    if (result == QALAM_OK) {
+        result = terminal_copy_string(options->working_dir, &t->options.working_dir);
+    }
+    if (result == QALAM_OK) {
+        result = terminal_copy_environment(options->environment, &t->options.environment);
+    }
+    if (result == QALAM_OK) {
+        size_t ring_size = options->output_buffer_size ? options->output_buffer_size
+                                                       : TERMINAL_DEFAULT_OUTPUT_BUFFER;
+        result = output_ring_create(&t->ring, ring_size);
+    }
+    if (result == QALAM_OK) {
+        result = terminal_screen_create(&t->screen, terminal_grid_extent(options->size.cols),
+                                        terminal_grid_extent(options->size.rows),
+                                        options->scrollback_budget);
+    }
+    if (result == QALAM_OK) {
+        t->stop_event = CreateEventW(NULL, TRUE, FALSE, NULL);
+        t->output_event = CreateEventW(NULL, FALSE, FALSE, NULL);
+        if (!t->stop_event || !t->output_event) {
+            result = QALAM_ERROR_OUT_OF_MEMORY;
+        }
+    }
+    if (result != QALAM_OK) {
+        qalam_terminal_destroy(t);
+        return result;
+    }
+
+    /* Input: the console reads one end, we write the other */
+    HANDLE input_read = NULL;
+    if (!CreatePipe(&input_read, &t->input_write, NULL, 0)) {
+        t->input_write = NULL;
+        qalam_terminal_destroy(t);
+        return QALAM_ERROR_PIPE_CREATE;
+    }
+
+    result = terminal_create_output_pipe(t);
+    if (result != QALAM_OK) {
+        CloseHandle(input_read);
+        qalam_terminal_destroy(t);
+        return result;
+    }
+
+    COORD size = { t->size.cols, t->size.rows };
+    HRESULT hr = CreatePseudoConsole(size, input_read, t->output_write, 0, &t->console);
+
+    /* The console holds its own references to its pipe ends */
+    CloseHandle(input_read);
+    CloseHandle(t->output_write);
+    t->output_write = NULL;
+    if (FAILED(hr)) {
+        t->console = NULL;
+        qalam_terminal_destroy(t);
+        return QALAM_ERROR_CONPTY_CREATE;
+    }
+
+    t->reader = CreateThread(NULL, 0, terminal_reader, t, 0, NULL);
+    if (!t->reader) {
+        qalam_terminal_destroy(t);
+        return QALAM_ERROR_TERMINAL_CREATE;
+    }
+
+    t->state = QALAM_TERMINAL_READY;
+    *terminal = t;
+    return QALAM_OK;
+}
+
+void qalam_terminal_destroy(QalamTerminal* terminal) {
+    if (!terminal) {
+        return;
+    }
+
+    if (terminal->process.hProcess && qalam_terminal_is_running(terminal)) {
+        TerminateProcess(terminal->process.hProcess, 1);
+    }
+
+    /* Keep the reader draining, discarding, until the console has gone */
+    InterlockedExchange(&terminal->closing, 1);
+    if (terminal->stop_event) {
+        SetEvent(terminal->stop_event);
+    }
+    if (terminal->console) {
+        ClosePseudoConsole(terminal->console);
+    }
+    if (terminal->output_write) {
+        CloseHandle(terminal->output_write);
+    }
+    if (terminal->reader) {
+        WaitForSingleObject(terminal->reader, INFINITE);
+        CloseHandle(terminal->reader);
+    }
+
+    terminal_release_process(terminal);
+    if (terminal->input_write) {
+        CloseHandle(terminal->input_write);
+    }
+    if (terminal->output_read) {
+        CloseHandle(terminal->output_read);
+    }
+    if (terminal->stop_event) {
+        CloseHandle(terminal->stop_event);
+    }
+    if (terminal->output_event) {
+        CloseHandle(terminal->output_event);
+    }
+    output_ring_destroy(terminal->ring);
+    terminal_screen_destroy(terminal->screen);
+
+    qalam_mem_free((void*)terminal->options.shell_path);
+    qalam_mem_free((void*)terminal->options.working_dir);
+    qalam_mem_free((void*)terminal->options.environment);
+    qalam_mem_free(terminal);
+}
+
+/*=============================================================================
+ * Process Management
+ *============================================================================*/
+
+QalamResult qalam_terminal_spawn(QalamTerminal* terminal, const wchar_t* command_line) {
+    wchar_t shell[MAX_PATH];
+
+    if (!terminal) {
+        return QALAM_ERROR_NULL_POINTER;
+    }
+    if (!terminal->console || terminal->state == QALAM_TERMINAL_ERROR) {
+        return QALAM_ERROR_NOT_INITIALIZED;
+    }
+    if (qalam_terminal_is_running(terminal)) {
+        return QALAM_ERROR_INVALID_ARGUMENT;
+    }
+
+    if (!command_line) {
+        if (terminal->options.shell_path) {
+            command_line = terminal->options.shell_path;
+        } else {
+            terminal_default_shell(shell, MAX_PATH);
+            command_line = shell;
+        }
+    }
+
+    /* CreateProcessW() may write to the command line */
+    size_t length = wcslen(command_line) + 1;
+    wchar_t* command = (wchar_t*)qalam_mem_alloc(QALAM_MEMORY_TERMINAL, length * sizeof(wchar_t));
+    SIZE_T list_size = 0;
+    InitializeProcThreadAttributeList(NULL, 1, 0, &list_size);
+    LPPROC_THREAD_ATTRIBUTE_LIST list =
+        (LPPROC_THREAD_ATTRIBUTE_LIST)qalam_mem_alloc(QALAM_MEMORY_TERMINAL, list_size);
+    if (!command || !list) {
+        qalam_mem_free(command);
+        qalam_mem_free(list);
+        return QALAM_ERROR_OUT_OF_MEMORY;
+    }
+    memcpy(command, command_line, length * sizeof(wchar_t));
+
+    QalamResult result = QALAM_OK;
+    if (!InitializeProcThreadAttributeList(list, 1, 0, &list_size)) {
+        qalam_mem_free(command);
+        qalam_mem_free(list);
+        return QALAM_ERROR_PROCESS_SPAWN;
+    }
+    if (!UpdateProcThreadAttribute(list, 0, PROC_THREAD_ATTRIBUTE_PSEUDOCONSOLE,
+                                   terminal->console, sizeof(HPCON), NULL, NULL)) {
+        result = QALAM_ERROR_PROCESS_SPAWN;
+    }
+
+    if (result == QALAM_OK) {
+        STARTUPINFOEXW startup;
+        memset(&startup, 0, sizeof(startup));
+        startup.StartupInfo.cb = sizeof(STARTUPINFOEXW);
+        startup.lpAttributeList = list;
+
+        /* Null standard handles, so the process cannot pick up ours
+         * instead of the pseudoconsole's */
+        startup.StartupInfo.dwFlags = STARTF_USESTDHANDLES;
+        if (terminal->options.start_hidden) {
+            startup.StartupInfo.dwFlags |= STARTF_USESHOWWINDOW;
+            startup.StartupInfo.wShowWindow = SW_HIDE;
+        }
+
+        DWORD flags = EXTENDED_STARTUPINFO_PRESENT;
+        if (terminal->options.environment) {
+            flags |= CREATE_UNICODE_ENVIRONMENT;
+        }
+
+        terminal_release_process(terminal);
+        if (!CreateProcessW(NULL, command, NULL, NULL, terminal->options.inherit_handles, flags,
+                            (LPVOID)terminal->options.environment,
+                            terminal->options.working_dir, &startup.StartupInfo,
+                            &terminal->process)) {
+            memset(&terminal->process, 0, sizeof(PROCESS_INFORMATION));
+            result = QALAM_ERROR_PROCESS_SPAWN;
+        }
+    }
+
+    DeleteProcThreadAttributeList(list);
+    qalam_mem_free(list);
+    qalam_mem_free(command);
+    if (result != QALAM_OK) {
+        return result;
+    }
+
+    terminal->exit_code = 0;
+    terminal_set_state(terminal, QALAM_TERMINAL_RUNNING);
+    return QALAM_OK;
+}
+
+QalamResult qalam_terminal_spawn_shell(QalamTerminal* terminal) {
+    wchar_t shell[MAX_PATH];
+    wchar_t command[MAX_PATH + 32];
+
+    if (!terminal) {
+        return QALAM_ERROR_NULL_POINTER;
+    }
+    if (terminal->options.shell_path) {
+        return qalam_terminal_spawn(terminal, NULL);
+    }
+
+    /* The console starts in the OEM code page; switch cmd.exe over
+     * before its prompt so non-ASCII output survives */
+    terminal_default_shell(shell, MAX_PATH);
+    swprintf(command, MAX_PATH + 32, L"\"%ls\" /K chcp %u >NUL", shell, terminal->codepage);
+    return qalam_terminal_spawn(terminal, command);
+}
+
+QalamResult qalam_terminal_kill(QalamTerminal* terminal, bool force) {
+    if (!terminal) {
+        return QALAM_ERROR_NULL_POINTER;
+    }
+    if (!qalam_terminal_is_running(terminal)) {
+        return QALAM_OK;
+    }
+
+    if (!force) {
+        qalam_terminal_send_interrupt(terminal);
+        if (WaitForSingleObject(terminal->process.hProcess,
+                                TERMINAL_GRACEFUL_TIMEOUT_MS) == WAIT_OBJECT_0) {
+            terminal_note_exit(terminal);
+            return QALAM_OK;
+        }
+    }
+
+    if (!TerminateProcess(terminal->process.hProcess, 1)) {
+        return QALAM_ERROR_UNKNOWN;
+    }
+    WaitForSingleObject(terminal->process.hProcess, INFINITE);
+    terminal_note_exit(terminal);
+    return QALAM_OK;
+}
+
+QalamResult qalam_terminal_wait(QalamTerminal* terminal, DWORD timeout_ms, DWORD* exit_code) {
+    if (!terminal) {
+        return QALAM_ERROR_NULL_POINTER;
+    }
+    if (!terminal->process.hProcess) {
+        return QALAM_ERROR_INVALID_ARGUMENT;
+    }
+
+    if (terminal->state == QALAM_TERMINAL_RUNNING) {
+        if (WaitForSingleObject(terminal->process.hProcess, timeout_ms) != WAIT_OBJECT_0) {
+            return QALAM_ERROR_TIMEOUT;
+        }
+        terminal_note_exit(terminal);
+    }
+
+    if (exit_code) {
+        *exit_code = terminal->exit_code;
+    }
+    return QALAM_OK;
+}
+
+bool qalam_terminal_is_running(const QalamTerminal* terminal) {
+    if (!terminal || terminal->state != QALAM_TERMINAL_RUNNING || !terminal->process.hProcess) {
+        return false;
+    }
+    return WaitForSingleObject(terminal->process.hProcess, 0) == WAIT_TIMEOUT;
+}
+
+/*=============================================================================
+ * Input/Output Operations
+ *============================================================================*/
+
+QalamResult qalam_terminal_write(QalamTerminal* terminal, const char* data,
+                                  size_t length, size_t* bytes_written) {
+    if (bytes_written) {
+        *bytes_written = 0;
+    }
+    if (!terminal || (!data && length > 0)) {
+        return QALAM_ERROR_NULL_POINTER;
+    }
+    if (!terminal->input_write) {
+        return QALAM_ERROR_NOT_INITIALIZED;
+    }
+
+    return terminal_write_all(terminal, data, length, bytes_written);
+}
+
+QalamResult qalam_terminal_write_string(QalamTerminal* terminal, const char* text) {
+    if (!text) {
+        return QALAM_ERROR_NULL_POINTER;
+    }
+    return qalam_terminal_write(terminal, text, strlen(text), NULL);
+}
+
+QalamResult qalam_terminal_read(QalamTerminal* terminal, char* buffer,
+                                 size_t buffer_size, size_t* bytes_read) {
+    if (!terminal || !buffer || !bytes_read) {
+        return QALAM_ERROR_NULL_POINTER;
+    }
+
+    /* At most two spans: up to the end of the ring, then from its start */
+    size_t done = 0;
+    for (int span = 0; span < 2 && done < buffer_size; span++) {
+        size_t length = 0;
+        const char* data = output_ring_read_span(terminal->ring, &length);
+        if (length > buffer_size - done) {
+            length = buffer_size - done;
+        }
+        if (length == 0) {
+            break;
+        }
+        memcpy(buffer + done, data, length);
+        output_ring_consume(terminal->ring, length);
+        done += length;
+    }
+
+    *bytes_read = done;
+    return (QalamResult)InterlockedCompareExchange(&terminal->reader_error, QALAM_OK, QALAM_OK);
+}
+
+bool qalam_terminal_has_output(const QalamTerminal* terminal) {
+    return terminal && output_ring_used_space(terminal->ring) > 0;
+}
+
+QalamResult qalam_terminal_poll(QalamTerminal* terminal, size_t* bytes_delivered) {
+    if (bytes_delivered) {
+        *bytes_delivered = 0;
+    }
+    if (!terminal) {
+        return QALAM_ERROR_NULL_POINTER;
+    }
+
+    /* Everything read so far in one batch; output that arrives meanwhile
+     * waits for the next frame */
+    QALAM_TRACE_BEGIN(span, QALAM_TRACE_TERMINAL, "terminal_poll");
+    size_t pending = output_ring_used_space(terminal->ring);
+    size_t delivered = 0;
+    QalamResult screen_result = QALAM_OK;
+    while (delivered < pending) {
+        size_t length = 0;
+        const char* data = output_ring_read_span(terminal->ring, &length);
+        if (length > pending - delivered) {
+            length = pending - delivered;
+        }
+        QalamResult result = terminal_screen_write(terminal->screen, data, length);
+        if (screen_result == QALAM_OK) {
+            screen_result = result;
+        }
+        if (terminal->output_callback) {
+            terminal->output_callback(terminal, data, length, terminal->output_user_data);
+        }
+        output_ring_consume(terminal->ring, length);
+        delivered += length;
+    }
+    QALAM_TRACE_COUNTER(QALAM_TRACE_TERMINAL, "delivered_bytes", delivered);
+    QALAM_TRACE_END(span);
+    if (bytes_delivered) {
+        *bytes_delivered = delivered;
+    }
+
+    if (terminal->state == QALAM_TERMINAL_RUNNING &&
+        WaitForSingleObject(terminal->process.hProcess, 0) == WAIT_OBJECT_0) {
+        terminal_note_exit(terminal);
+    }
+
+    QalamResult result =
+        (QalamResult)InterlockedCompareExchange(&terminal->reader_error, QALAM_OK, QALAM_OK);
+    return result != QALAM_OK ? result : screen_result;
+}
+
+HANDLE qalam_terminal_get_output_waitable(const QalamTerminal* terminal) {
+    return terminal ? terminal->output_event : NULL;
+}
+
+QalamResult qalam_terminal_send_key(QalamTerminal* terminal, WORD key, bool ctrl) {
+    char sequence[8];
+    const char* text = NULL;
+
+    if (!terminal) {
+        return QALAM_ERROR_NULL_POINTER;
+    }
+
+    /* Cursor keys with Ctrl carry the xterm modifier parameter */
+    const char* cursor = NULL;
+    switch (key) {
+        case VK_UP:     cursor = "A"; break;
+        case VK_DOWN:   cursor = "B"; break;
+        case VK_RIGHT:  cursor = "C"; break;
+        case VK_LEFT:   cursor = "D"; break;
+        case VK_HOME:   cursor = "H"; break;
+        case VK_END:    cursor = "F"; break;
+        default:        break;
+    }
+    if (cursor) {
+        text = sequence;
+        sequence[0] = '\x1b';
+        sequence[1] = '[';
+        if (ctrl) {
+            memcpy(sequence + 2, "1;5", 3);
+            sequence[5] = cursor[0];
+            sequence[6] = '\0';
+        } else {
+            sequence[2] = cursor[0];
+            sequence[3] = '\0';
+        }
+        return qalam_terminal_write_string(terminal, text);
+    }
+
+    switch (key) {
+        case VK_RETURN: text = "\r"; break;
+        case VK_BACK:   text = ctrl ? "\x08" : "\x7f"; break;
+        case VK_TAB:    text = "\t"; break;
+        case VK_ESCAPE: text = "\x1b"; break;
+        case VK_INSERT: text = "\x1b[2~"; break;
+        case VK_DELETE: text = "\x1b[3~"; break;
+        case VK_PRIOR:  text = "\x1b[5~"; break;
+        case VK_NEXT:   text = "\x1b[6~"; break;
+        case VK_F1:     text = "\x1bOP"; break;
+        case VK_F2:     text = "\x1bOQ"; break;
+        case VK_F3:     text = "\x1bOR"; break;
+        case VK_F4:     text = "\x1bOS"; break;
+        case VK_F5:     text = "\x1b[15~"; break;
+        case VK_F6:     text = "\x1b[17~"; break;
+        case VK_F7:     text = "\x1b[18~"; break;
+        case VK_F8:     text = "\x1b[19~"; break;
+        case VK_F9:     text = "\x1b[20~"; break;
+        case VK_F10:    text = "\x1b[21~"; break;
+        case VK_F11:    text = "\x1b[23~"; break;
+        case VK_F12:    text = "\x1b[24~"; break;
+        default:        break;
+    }
+
+    /* Ctrl+letter is the matching C0 control */
+    if (!text && ctrl && key >= 'A' && key <= 'Z') {
+        sequence[0] = (char)(key - 'A' + 1);
+        sequence[1] = '\0';
+        text = sequence;
+    }
+    if (!text) {
+        return QALAM_ERROR_INVALID_ARGUMENT;
+    }
+    return qalam_terminal_write_string(terminal, text);
+}
+
+QalamResult qalam_terminal_send_interrupt(QalamTerminal* terminal) {
+    return qalam_terminal_write(terminal, "\x03", 1, NULL);
+}
+
+/*=============================================================================
+ * Terminal Configuration
+ *============================================================================*/
+
+QalamResult qalam_terminal_resize(QalamTerminal* terminal, short cols, short rows) {
+    if (!terminal) {
+        return QALAM_ERROR_NULL_POINTER;
+    }
+    if (cols <= 0 || rows <= 0) {
+        return QALAM_ERROR_INVALID_ARGUMENT;
+    }
+    if (!terminal->console) {
+        return QALAM_ERROR_NOT_INITIALIZED;
+    }
+
+    /* Reflow what is on screen now; the console repaints after it resizes */
+    QalamResult result = terminal_screen_resize(terminal->screen, terminal_grid_extent(cols),
+                                                terminal_grid_extent(rows));
+    if (result != QALAM_OK && result != QALAM_ERROR_OUT_OF_MEMORY) {
+        return result;
+    }
+
+    COORD size = { cols, rows };
+    if (FAILED(ResizePseudoConsole(terminal->console, size))) {
+        return QALAM_ERROR_CONPTY_CREATE;
+    }
+
+    terminal->size.cols = cols;
+    terminal->size.rows = rows;
+    return result;
+}
+
+QalamResult qalam_terminal_get_size(const QalamTerminal* terminal, QalamTerminalSize* size) {
+    if (!terminal || !size) {
+        return QALAM_ERROR_NULL_POINTER;
+    }
+
+    *size = terminal->size;
+    return QALAM_OK;
+}
+
+QalamResult qalam_terminal_get_info(const QalamTerminal* terminal, QalamTerminalInfo* info) {
+    if (!terminal || !info) {
+        return QALAM_ERROR_NULL_POINTER;
+    }
+
+    memset(info, 0, sizeof(QalamTerminalInfo));
+    info->state = terminal->state;
+    info->size = terminal->size;
+    info->process_id = terminal->state == QALAM_TERMINAL_RUNNING ? terminal->process.dwProcessId : 0;
+    info->exit_code = terminal->exit_code;
+    info->has_pending_output = qalam_terminal_has_output(terminal);
+
+    ScrollbackStats stats;
+    scrollback_get_stats(terminal_screen_get_scrollback(terminal->screen), &stats);
+    info->scrollback_rows = stats.rows;
+    info->scrollback_bytes = stats.bytes + stats.cache_bytes;
+    return QALAM_OK;
+}
+
+/*=============================================================================
+ * Scrollback
+ *============================================================================*/
+
+QalamResult qalam_terminal_find_in_scrollback(QalamTerminal* terminal, const char* text,
+                                               size_t length, uint64_t row, size_t column,
+                                               bool backwards, bool ignore_case,
+                                               QalamTerminalMatch* match, bool* found) {
+    if (!terminal || !match || !found) {
+        return QALAM_ERROR_NULL_POINTER;
+    }
+
+    ScrollbackMatch m;
+    QalamResult result = scrollback_find(terminal_screen_get_scrollback(terminal->screen), text,
+                                         length, row, column, backwards, ignore_case, &m, found);
+    if (result == QALAM_OK && *found) {
+        match->row = m.row;
+        match->column = m.column;
+        match->cells = m.cells;
+    }
+    return result;
+}
+
+QalamResult qalam_terminal_clear_scrollback(QalamTerminal* terminal) {
+    if (!terminal) {
+        return QALAM_ERROR_NULL_POINTER;
+    }
+
+    scrollback_clear(terminal_screen_get_scrollback(terminal->screen));
+    return QALAM_OK;
+}
+
+TerminalScreen* qalam_terminal_get_screen(QalamTerminal* terminal) {
+    return terminal ? terminal->screen : NULL;
+}
+
+/*=============================================================================
+ * Callback Registration
+ *============================================================================*/
+
+QalamResult qalam_terminal_set_output_callback(QalamTerminal* terminal,
+                                                QalamTerminalOutputCallback callback,
+                                                void* user_data) {
+    if (!terminal) {
+        return QALAM_ERROR_NULL_POINTER;
+    }
+
+    terminal->output_callback = callback;
+    terminal->output_user_data = user_data;
+    return QALAM_OK;
+}
+
+QalamResult qalam_terminal_set_state_callback(QalamTerminal* terminal,
+                                               QalamTerminalStateCallback callback,
+                                               void* user_data) {
+    if (!terminal) {
+        return QALAM_ERROR_NULL_POINTER;
+    }
+
+    terminal->state_callback = callback;
+    terminal->state_user_data = user_data;
+    return QALAM_OK;
+}
+
+/*=============================================================================
+ * Arabic Console Support
+ *============================================================================*/
+
+QalamResult qalam_terminal_enable_arabic(QalamTerminal* terminal) {
+    if (!terminal) {
+        return QALAM_ERROR_NULL_POINTER;
+    }
+
+    /* The pseudoconsole always talks UTF-8 to us; Arabic shaping and
+     * bidi are up to the renderer, which needs the VT stream */
+    terminal->options.enable_vt_processing = true;
+    return qalam_terminal_set_codepage(terminal, CP_UTF8);
+}
+
+QalamResult qalam_terminal_set_codepage(QalamTerminal* terminal, UINT codepage) {
+    if (!terminal) {
+        return QALAM_ERROR_NULL_POINTER;
+    }
+    if (!IsValidCodePage(codepage)) {
+        return QALAM_ERROR_INVALID_ARGUMENT;
+    }
+
+    terminal->codepage = codepage;
+    return QALAM_OK;
+}
@@ -0,0 +1,172 @@
+/**
+ * @file output_ring.c
+ * @brief Qalam IDE - Terminal Output Ring Implementation
+ *
+ * 'head' counts bytes ever committed and 'tail' bytes ever consumed;
+ * both run freely and wrap at 2^32, so the filled space is always
+ * head - tail in unsigned arithmetic and the ring never has to tell a
+ * full ring from an empty one by position. The capacity is a power of
+ * two, so a position maps to an offset with a mask.
+ *
+ * The producer writes 'head' and only reads 'tail'; the consumer the
+ * other way round. Interlocked stores publish the bytes before the
+ * position that covers them, and interlocked loads see them after it.
+ *
+ * A waiting producer raises 'waiting' and checks for space once more
+ * before it sleeps; a consumer that frees space after that sees the flag
+ * and sets the event, so a wakeup is never lost.
+ *
+ * @version 0.0.2
+ * @copyright (c) 2026 Qalam Project
+ *
+ * @note Thread Safety: See output_ring.h.
+ */
+
+#include "output_ring.h"
+#include <stdlib.h>
+
+/*=============================================================================
+ * Internal Structures
+ *============================================================================*/
+
+/**
+ * @brief Output ring state
+ */
+struct OutputRing {
+    char* data;                     /**< Ring memory */
+    uint32_t capacity;              /**< Bytes in 'data', a power of two */
+    volatile LONG head;             /**< Bytes committed, written by the producer */
+    volatile LONG tail;             /**< Bytes consumed, written by the consumer */
+    volatile LONG waiting;          /**< Set while the producer waits for space */
+    HANDLE space_event;             /**< Auto-reset event set when space is freed */
+};
+
+/*=============================================================================
+ * Internal Helper Functions
+ *============================================================================*/
+
+static inline uint32_t ring_load(volatile LONG* position) {
+    return (uint32_t)InterlockedCompareExchange(position, 0, 0);
+}
+
+static inline void ring_store(volatile LONG* position, uint32_t value) {
+    InterlockedExchange(position, (LONG)value);
+}
+
+/*=============================================================================
+ * Lifecycle
+ *============================================================================*/
+
+QalamResult output_ring_create(OutputRing** ring, size_t capacity) {
+    if (!ring) {
+        return QALAM_ERROR_NULL_POINTER;
+    }
+
+    *ring = NULL;
+
+    uint32_t size = OUTPUT_RING_MIN_CAPACITY;
+    while (size < capacity && size < OUTPUT_RING_MAX_CAPACITY) {
+        size <<= 1;
+    }
+
+    OutputRing* r = (OutputRing*)qalam_mem_calloc(QALAM_MEMORY_TERMINAL, 1, sizeof(OutputRing));
+    if (!r) {
+        return QALAM_ERROR_OUT_OF_MEMORY;
+    }
+
+    r->data = (char*)qalam_mem_alloc(QALAM_MEMORY_TERMINAL, size);
+    r->space_event = CreateEventW(NULL, FALSE, FALSE, NULL);
+    if (!r->data || !r->space_event) {
+        output_ring_destroy(r);
+        return QALAM_ERROR_OUT_OF_MEMORY;
+    }
+    r->capacity = size;
+
+    *ring = r;
+    return QALAM_OK;
+}
+
+void output_ring_destroy(OutputRing* ring) {
+    if (!ring) {
+        return;
+    }
+
+    if (ring->space_event) {
+        CloseHandle(ring->space_event);
+    }
+    qalam_mem_free(ring->data);
+    qalam_mem_free(ring);
+}
+
+size_t output_ring_capacity(const OutputRing* ring) {
+    return ring->capacity;
+}
+
+/*=============================================================================
+ * Producer
+ *============================================================================*/
+
+char* output_ring_write_span(OutputRing* ring, size_t* length) {
+    uint32_t head = ring_load(&ring->head);
+    uint32_t used = head - ring_load(&ring->tail);
+    uint32_t offset = head & (ring->capacity - 1);
+    uint32_t to_end = ring->capacity - offset;
+    uint32_t free_space = ring->capacity - used;
+
+    *length = free_space < to_end ? free_space : to_end;
+    return ring->data + offset;
+}
+
+size_t output_ring_free_space(const OutputRing* ring) {
+    OutputRing* r = (OutputRing*)ring;
+    return r->capacity - (ring_load(&r->head) - ring_load(&r->tail));
+}
+
+void output_ring_commit(OutputRing* ring, size_t length) {
+    ring_store(&ring->head, ring_load(&ring->head) + (uint32_t)length);
+}
+
+bool output_ring_wait_space(OutputRing* ring, size_t wanted, HANDLE cancel, DWORD timeout_ms) {
+    InterlockedExchange(&ring->waiting, 1);
+
+    /* The consumer may have freed space before it could see the flag */
+    bool freed = output_ring_free_space(ring) >= wanted;
+    if (!freed) {
+        HANDLE handles[2] = { ring->space_event, cancel };
+        DWORD count = cancel ? 2 : 1;
+        freed = WaitForMultipleObjects(count, handles, FALSE, timeout_ms) == WAIT_OBJECT_0;
+    }
+
+    InterlockedExchange(&ring->waiting, 0);
+    return freed;
+}
+
+/*=============================================================================
+ * Consumer
+ *============================================================================*/
+
+const char* output_ring_read_span(OutputRing* ring, size_t* length) {
+    uint32_t tail = ring_load(&ring->tail);
+    uint32_t used = ring_load(&ring->head) - tail;
+    uint32_t offset = tail & (ring->capacity - 1);
+    uint32_t to_end = ring->capacity - offset;
+
+    *length = used < to_end ? used : to_end;
+    return ring->data + offset;
+}
+
+size_t output_ring_used_space(const OutputRing* ring) {
+    OutputRing* r = (OutputRing*)ring;
+    return ring_load(&r->head) - ring_load(&r->tail);
+}
+
+void output_ring_consume(OutputRing* ring, size_t length) {
+    if (length == 0) {
+        return;
+    }
+
+    ring_store(&ring->tail, ring_load(&ring->tail) + (uint32_t)length);
+    if (InterlockedCompareExchange(&ring->waiting, 0, 0)) {
+        SetEvent(ring->space_event);
+    }
+}
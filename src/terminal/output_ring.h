@@ -0,0 +1,158 @@
+/**
+ * @file output_ring.h
+ * @brief Qalam IDE - Terminal Output Ring (Internal Header)
+ *
+ * Internal header for the fixed-size byte ring between a terminal's
+ * reader thread and the UI thread. There is exactly one producer and one
+ * consumer, so the ring needs no lock: each side owns one free-running
+ * position and only reads the other's. The producer reads straight into
+ * the free space returned by output_ring_write_span() and publishes the
+ * bytes with output_ring_commit(); the consumer reads the filled space
+ * returned by output_ring_read_span() and frees it with
+ * output_ring_consume(). Neither side allocates or copies.
+ *
+ * When the ring is full the producer waits on output_ring_wait_space()
+ * instead of reading on; the pipe behind it then fills and the writing
+ * process blocks, which is the backpressure.
+ *
+ * @version 0.0.2
+ * @copyright (c) 2026 Qalam Project
+ *
+ * @note Thread Safety: The write functions may only be called from one
+ *       thread and the read functions from one other thread at a time.
+ */
+
+#ifndef QALAM_OUTPUT_RING_H
+#define QALAM_OUTPUT_RING_H
+
+#include "qalam.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*=============================================================================
+ * Configuration Constants
+ *============================================================================*/
+
+/** Smallest ring capacity in bytes */
+#define OUTPUT_RING_MIN_CAPACITY    (64 * 1024)
+
+/** Largest ring capacity in bytes (positions are 32-bit counters) */
+#define OUTPUT_RING_MAX_CAPACITY    (1024 * 1024 * 1024)
+
+/*=============================================================================
+ * Output Ring Structures
+ *============================================================================*/
+
+/**
+ * @brief Opaque output ring
+ */
+typedef struct OutputRing OutputRing;
+
+/*=============================================================================
+ * Lifecycle
+ *============================================================================*/
+
+/**
+ * @brief Create an output ring
+ *
+ * @param[out] ring Receives the ring
+ * @param capacity Capacity in bytes (rounded up to a power of two and
+ *        clamped to [OUTPUT_RING_MIN_CAPACITY, OUTPUT_RING_MAX_CAPACITY])
+ * @return QALAM_OK on success, error code on failure
+ */
+QalamResult output_ring_create(OutputRing** ring, size_t capacity);
+
+/**
+ * @brief Destroy an output ring
+ *
+ * @param ring Ring to destroy (may be NULL)
+ */
+void output_ring_destroy(OutputRing* ring);
+
+/**
+ * @brief Get the ring's capacity in bytes
+ */
+size_t output_ring_capacity(const OutputRing* ring);
+
+/*=============================================================================
+ * Producer
+ *============================================================================*/
+
+/**
+ * @brief Get the free space the producer can write next
+ *
+ * Space past the end of the ring's memory is returned by the next call,
+ * after this span is committed.
+ *
+ * @param ring Output ring
+ * @param[out] length Receives the contiguous free bytes at the result
+ * @return Start of the free space (valid even when 'length' is 0)
+ */
+char* output_ring_write_span(OutputRing* ring, size_t* length);
+
+/**
+ * @brief Get the total free space, contiguous or not
+ */
+size_t output_ring_free_space(const OutputRing* ring);
+
+/**
+ * @brief Publish bytes written into the span from output_ring_write_span()
+ *
+ * @param ring Output ring
+ * @param length Bytes written (at most the span's length)
+ */
+void output_ring_commit(OutputRing* ring, size_t length);
+
+/**
+ * @brief Wait until the consumer frees space or a cancel event is set
+ *
+ * Returns at once if 'wanted' bytes are already free. Otherwise it
+ * returns after the consumer has freed some space, which may still be
+ * less than 'wanted'; callers check again.
+ *
+ * @param ring Output ring
+ * @param wanted Free bytes the producer needs to go on
+ * @param cancel Manual-reset event that ends the wait early (may be NULL)
+ * @param timeout_ms Timeout in milliseconds (INFINITE for none)
+ * @return true if space may have been freed, false on cancel or timeout
+ */
+bool output_ring_wait_space(OutputRing* ring, size_t wanted, HANDLE cancel, DWORD timeout_ms);
+
+/*=============================================================================
+ * Consumer
+ *============================================================================*/
+
+/**
+ * @brief Get the filled space the consumer can read next
+ *
+ * Data past the end of the ring's memory is returned by the next call,
+ * after this span is consumed, so a full drain takes at most two spans.
+ *
+ * @param ring Output ring
+ * @param[out] length Receives the contiguous filled bytes at the result
+ * @return Start of the data (valid even when 'length' is 0)
+ */
+const char* output_ring_read_span(OutputRing* ring, size_t* length);
+
+/**
+ * @brief Get the total filled space, contiguous or not
+ */
+size_t output_ring_used_space(const OutputRing* ring);
+
+/**
+ * @brief Free bytes read from the span from output_ring_read_span()
+ *
+ * Wakes the producer if it is waiting for space.
+ *
+ * @param ring Output ring
+ * @param length Bytes read (at most the span's length)
+ */
+void output_ring_consume(OutputRing* ring, size_t length);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* QALAM_OUTPUT_RING_H */
@@ -0,0 +1,953 @@
+/**
+ * @file scrollback.c
+ * @brief Qalam IDE - Terminal Scrollback Store Implementation
+ *
+ * A packed block is one allocation: the header, then per-row offsets
+ * into its text and its attribute runs, the runs, the row lengths and
+ * flags, and the text. A row's text holds one UTF-8 character for each
+ * cell (followed by its mark, if it has one) except the tails of wide
+ * characters, which exist only in the runs, and an empty cell is stored
+ * as a space. Walking a row's runs and its text together recovers every
+ * cell, and from that the cell a byte of the text belongs to.
+ *
+ * Packed blocks sit in a ring of pointers ordered by first row and are
+ * found by binary search. A hot row is searched by packing it into the
+ * scratch buffers first, so packed and hot rows share one search path.
+ *
+ * @version 0.0.2
+ * @copyright (c) 2026 Qalam Project
+ *
+ * @note Thread Safety: See scrollback.h.
+ */
+
+#include "scrollback.h"
+#include <stdlib.h>
+#include <string.h>
+
+/*=============================================================================
+ * Internal Structures
+ *============================================================================*/
+
+/**
+ * @brief Cells with equal attributes, packed
+ */
+typedef struct AttrRun {
+    uint32_t foreground;            /**< Foreground color */
+    uint32_t background;            /**< Background color */
+    uint16_t flags;                 /**< TERMINAL_ATTR_* flags */
+    uint16_t length;                /**< Cells in the run */
+} AttrRun;
+
+/**
+ * @brief A packed block
+ *
+ * The arrays point into the same allocation, after the header.
+ */
+typedef struct PackedBlock {
+    uint64_t first_row;             /**< Number of the block's first row */
+    size_t bytes;                   /**< Size of the allocation */
+    uint32_t row_count;             /**< Rows in the block */
+    uint32_t* text_offsets;         /**< Start of each row's text (row_count + 1 entries) */
+    uint32_t* run_offsets;          /**< First run of each row (row_count + 1 entries) */
+    AttrRun* runs;                  /**< Attribute runs */
+    uint16_t* lengths;              /**< Row lengths in cells */
+    uint8_t* flags;                 /**< Row flags */
+    char* text;                     /**< UTF-8 text */
+} PackedBlock;
+
+/**
+ * @brief A hot block: rows of cells at one width
+ */
+typedef struct HotBlock {
+    uint64_t first_row;             /**< Number of the block's first row */
+    TerminalCell* cells;            /**< SCROLLBACK_BLOCK_ROWS rows of 'width' cells */
+    size_t capacity;                /**< Cells allocated */
+    uint32_t row_count;             /**< Rows in the block */
+    uint16_t width;                 /**< Cells in each row */
+    uint16_t lengths[SCROLLBACK_BLOCK_ROWS]; /**< Row lengths without trailing blanks */
+    uint8_t flags[SCROLLBACK_BLOCK_ROWS];    /**< Row flags */
+} HotBlock;
+
+/**
+ * @brief A packed block unpacked for reading
+ */
+typedef struct CacheBlock {
+    bool valid;                     /**< Entry holds a block */
+    uint64_t first_row;             /**< First row of the block held */
+    TerminalCell* cells;            /**< Rows of 'width' cells */
+    size_t capacity;                /**< Cells allocated */
+    size_t width;                   /**< Cells in each row (the longest row) */
+    uint64_t last_used;             /**< Read clock at the last read */
+} CacheBlock;
+
+/**
+ * @brief A block holding a row, hot or packed
+ */
+typedef struct BlockRef {
+    const PackedBlock* packed;      /**< Packed block, or NULL */
+    HotBlock* hot;                  /**< Hot block, or NULL */
+    uint64_t first_row;             /**< Number of the block's first row */
+    uint32_t row_count;             /**< Rows in the block */
+} BlockRef;
+
+/**
+ * @brief One row in packed form
+ */
+typedef struct RowView {
+    const char* text;               /**< UTF-8 text */
+    size_t text_length;             /**< Bytes of text */
+    const AttrRun* runs;            /**< Attribute runs */
+    size_t run_count;               /**< Number of runs */
+} RowView;
+
+/**
+ * @brief Scrollback store state
+ */
+struct Scrollback {
+    size_t budget;                  /**< Memory budget in bytes */
+    size_t bytes;                   /**< Bytes of hot and packed blocks */
+    uint64_t first_row;             /**< Oldest row held */
+    uint64_t end_row;               /**< One past the newest row */
+    uint64_t rows_dropped;          /**< Rows dropped for the budget */
+
+    HotBlock hot[SCROLLBACK_HOT_BLOCKS]; /**< Ring of hot blocks */
+    size_t hot_start;               /**< Index of the oldest hot block */
+    size_t hot_count;               /**< Hot blocks in use */
+
+    PackedBlock** packed;           /**< Ring of packed blocks, oldest first */
+    size_t packed_capacity;         /**< Entries in 'packed' */
+    size_t packed_start;            /**< Index of the oldest packed block */
+    size_t packed_count;            /**< Packed blocks held */
+
+    CacheBlock cache[SCROLLBACK_CACHE_BLOCKS]; /**< Unpacked blocks */
+    uint64_t cache_clock;           /**< Read clock */
+    size_t cache_bytes;             /**< Bytes of unpacked blocks */
+
+    char* scratch_text;             /**< Text of rows being packed */
+    size_t scratch_text_capacity;   /**< Bytes in 'scratch_text' */
+    AttrRun* scratch_runs;          /**< Runs of rows being packed */
+    size_t scratch_runs_capacity;   /**< Entries in 'scratch_runs' */
+};
+
+/*=============================================================================
+ * Internal Helper Functions
+ *============================================================================*/
+
+static inline bool cell_is_blank(const TerminalCell* cell) {
+    return (cell->codepoint == 0 || cell->codepoint == ' ') &&
+           cell->attributes.foreground == TERMINAL_COLOR_DEFAULT &&
+           cell->attributes.background == TERMINAL_COLOR_DEFAULT &&
+           cell->attributes.flags == 0;
+}
+
+/**
+ * @brief Decode the character and mark of the cell whose text starts at 'text'
+ *
+ * @param end End of the row's text
+ * @param[out] length Receives the bytes the cell takes
+ */
+static uint32_t cell_decode(const char* text, const char* end, size_t* length) {
+    size_t n;
+    uint32_t codepoint = terminal_utf8_decode(text, (size_t)(end - text), &n);
+    *length = n;
+
+    if (text + n < end) {
+        size_t m;
+        uint32_t next = terminal_utf8_decode(text + n, (size_t)(end - text - n), &m);
+        unsigned int mark = terminal_mark_index(next);
+        if (mark) {
+            codepoint = TERMINAL_CELL_WITH_MARK(codepoint, mark);
+            *length += m;
+        }
+    }
+    return codepoint;
+}
+
+static inline unsigned char fold_ascii(unsigned char c) {
+    return (c >= 'A' && c <= 'Z') ? (unsigned char)(c + ('a' - 'A')) : c;
+}
+
+static QalamResult ensure_scratch(Scrollback* sb, size_t text_bytes, size_t runs) {
+    if (text_bytes > sb->scratch_text_capacity) {
+        size_t capacity = sb->scratch_text_capacity ? sb->scratch_text_capacity : 4096;
+        while (capacity < text_bytes) {
+            capacity *= 2;
+        }
+        char* text = (char*)qalam_mem_realloc(QALAM_MEMORY_TERMINAL, sb->scratch_text, capacity);
+        if (!text) {
+            return QALAM_ERROR_OUT_OF_MEMORY;
+        }
+        sb->scratch_text = text;
+        sb->scratch_text_capacity = capacity;
+    }
+
+    if (runs > sb->scratch_runs_capacity) {
+        size_t capacity = sb->scratch_runs_capacity ? sb->scratch_runs_capacity : 256;
+        while (capacity < runs) {
+            capacity *= 2;
+        }
+        AttrRun* r = (AttrRun*)qalam_mem_realloc(QALAM_MEMORY_TERMINAL, sb->scratch_runs,
+                                                 capacity * sizeof(AttrRun));
+        if (!r) {
+            return QALAM_ERROR_OUT_OF_MEMORY;
+        }
+        sb->scratch_runs = r;
+        sb->scratch_runs_capacity = capacity;
+    }
+
+    return QALAM_OK;
+}
+
+/**
+ * @brief Pack a row onto the end of the scratch buffers
+ *
+ * @param text_used In: bytes of scratch text in use; out: after the row
+ * @param runs_used In: scratch runs in use; out: after the row
+ */
+static QalamResult pack_row(Scrollback* sb, const TerminalCell* cells, size_t length,
+                            size_t* text_used, size_t* runs_used) {
+    QalamResult result = ensure_scratch(sb, *text_used + length * TERMINAL_CELL_MAX_UTF8,
+                                        *runs_used + length);
+    if (result != QALAM_OK) {
+        return result;
+    }
+
+    char* text = sb->scratch_text + *text_used;
+    AttrRun* runs = sb->scratch_runs + *runs_used;
+    size_t run_count = 0;
+
+    for (size_t i = 0; i < length; i++) {
+        const TerminalAttributes* a = &cells[i].attributes;
+
+        if (run_count > 0 &&
+            runs[run_count - 1].foreground == a->foreground &&
+            runs[run_count - 1].background == a->background &&
+            runs[run_count - 1].flags == a->flags) {
+            runs[run_count - 1].length++;
+        } else {
+            runs[run_count].foreground = a->foreground;
+            runs[run_count].background = a->background;
+            runs[run_count].flags = a->flags;
+            runs[run_count].length = 1;
+            run_count++;
+        }
+
+        if (!(a->flags & TERMINAL_ATTR_WIDE_TAIL)) {
+            text += terminal_cell_to_utf8(cells[i].codepoint ? cells[i].codepoint : ' ', text);
+        }
+    }
+
+    *text_used = (size_t)(text - sb->scratch_text);
+    *runs_used += run_count;
+    return QALAM_OK;
+}
+
+/** Unpack a row into cells; writes exactly the row's length */
+static void unpack_row(const RowView* view, TerminalCell* cells) {
+    const char* text = view->text;
+    const char* end = view->text + view->text_length;
+    size_t column = 0;
+
+    for (size_t r = 0; r < view->run_count; r++) {
+        const AttrRun* run = &view->runs[r];
+        TerminalAttributes attributes;
+        attributes.foreground = run->foreground;
+        attributes.background = run->background;
+        attributes.flags = run->flags;
+
+        for (uint16_t i = 0; i < run->length; i++) {
+            TerminalCell* cell = &cells[column++];
+            cell->attributes = attributes;
+            if (run->flags & TERMINAL_ATTR_WIDE_TAIL) {
+                cell->codepoint = 0;
+            } else {
+                size_t n;
+                cell->codepoint = cell_decode(text, end, &n);
+                text += n;
+            }
+        }
+    }
+}
+
+/**
+ * @brief Get the cells covered by a byte range of a row's text
+ *
+ * @param start Byte where the range starts (on a character)
+ * @param end Byte one past the range
+ * @param[out] first_column Cell of the byte at 'start'
+ * @param[out] end_column Cell after the range, past any wide tails
+ */
+static void view_columns(const RowView* view, size_t start, size_t end,
+                         size_t* first_column, size_t* end_column) {
+    size_t offset = 0;
+    size_t column = 0;
+    bool started = false;
+
+    for (size_t r = 0; r < view->run_count; r++) {
+        const AttrRun* run = &view->runs[r];
+        if (run->flags & TERMINAL_ATTR_WIDE_TAIL) {
+            column += run->length;
+            continue;
+        }
+
+        for (uint16_t i = 0; i < run->length; i++) {
+            if (!started && offset >= start) {
+                *first_column = column;
+                started = true;
+            }
+            if (offset >= end) {
+                *end_column = column;
+                return;
+            }
+            size_t n;
+            cell_decode(view->text + offset, view->text + view->text_length, &n);
+            offset += n;
+            column++;
+        }
+    }
+
+    if (!started) {
+        *first_column = column;
+    }
+    *end_column = column;
+}
+
+/** Get the byte of a row's text where the first character at or after 'column' starts */
+static size_t view_offset(const RowView* view, size_t column) {
+    size_t offset = 0;
+    size_t c = 0;
+
+    for (size_t r = 0; r < view->run_count; r++) {
+        const AttrRun* run = &view->runs[r];
+        if (run->flags & TERMINAL_ATTR_WIDE_TAIL) {
+            c += run->length;
+            continue;
+        }
+
+        for (uint16_t i = 0; i < run->length; i++) {
+            if (c >= column) {
+                return offset;
+            }
+            size_t n;
+            cell_decode(view->text + offset, view->text + view->text_length, &n);
+            offset += n;
+            c++;
+        }
+    }
+
+    return offset;
+}
+
+static inline bool matches_at(const char* text, const char* pattern, size_t length,
+                              bool ignore_case) {
+    if (!ignore_case) {
+        return memcmp(text, pattern, length) == 0;
+    }
+    for (size_t i = 0; i < length; i++) {
+        if (fold_ascii((unsigned char)text[i]) != fold_ascii((unsigned char)pattern[i])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Find a pattern in a row's text between two bytes
+ *
+ * Finds the first match starting in [from, to) forwards, or the last
+ * backwards.
+ */
+static bool view_find(const RowView* view, const char* pattern, size_t length,
+                      size_t from, size_t to, bool backwards, bool ignore_case,
+                      size_t* offset) {
+    if (view->text_length < length) {
+        return false;
+    }
+    size_t last = view->text_length - length;
+    if (to > last + 1) {
+        to = last + 1;
+    }
+    if (from >= to) {
+        return false;
+    }
+
+    if (backwards) {
+        for (size_t i = to; i-- > from;) {
+            if (matches_at(view->text + i, pattern, length, ignore_case)) {
+                *offset = i;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    if (!ignore_case) {
+        const char* p = view->text + from;
+        const char* end = view->text + to;
+        while (p < end) {
+            p = (const char*)memchr(p, pattern[0], (size_t)(end - p));
+            if (!p) {
+                return false;
+            }
+            if (memcmp(p, pattern, length) == 0) {
+                *offset = (size_t)(p - view->text);
+                return true;
+            }
+            p++;
+        }
+        return false;
+    }
+
+    for (size_t i = from; i < to; i++) {
+        if (matches_at(view->text + i, pattern, length, true)) {
+            *offset = i;
+            return true;
+        }
+    }
+    return false;
+}
+
+static inline HotBlock* hot_block(Scrollback* sb, size_t index) {
+    return &sb->hot[(sb->hot_start + index) % SCROLLBACK_HOT_BLOCKS];
+}
+
+static inline PackedBlock* packed_block(const Scrollback* sb, size_t index) {
+    return sb->packed[(sb->packed_start + index) % sb->packed_capacity];
+}
+
+/** Find the block holding a row the store holds */
+static bool find_block(Scrollback* sb, uint64_t row, BlockRef* ref) {
+    if (row < sb->first_row || row >= sb->end_row) {
+        return false;
+    }
+
+    ref->packed = NULL;
+    ref->hot = NULL;
+
+    if (sb->hot_count > 0 && row >= hot_block(sb, 0)->first_row) {
+        for (size_t i = sb->hot_count; i-- > 0;) {
+            HotBlock* block = hot_block(sb, i);
+            if (row >= block->first_row) {
+                ref->hot = block;
+                ref->first_row = block->first_row;
+                ref->row_count = block->row_count;
+                return true;
+            }
+        }
+    }
+
+    size_t low = 0;
+    size_t high = sb->packed_count;
+    while (high - low > 1) {
+        size_t mid = low + (high - low) / 2;
+        if (packed_block(sb, mid)->first_row <= row) {
+            low = mid;
+        } else {
+            high = mid;
+        }
+    }
+
+    if (sb->packed_count == 0) {
+        return false;
+    }
+    ref->packed = packed_block(sb, low);
+    ref->first_row = ref->packed->first_row;
+    ref->row_count = ref->packed->row_count;
+    return true;
+}
+
+static inline void packed_row_view(const PackedBlock* block, uint32_t index, RowView* view) {
+    view->text = block->text + block->text_offsets[index];
+    view->text_length = block->text_offsets[index + 1] - block->text_offsets[index];
+    view->runs = block->runs + block->run_offsets[index];
+    view->run_count = block->run_offsets[index + 1] - block->run_offsets[index];
+}
+
+/** Get a row of a block in packed form; hot rows are packed into the scratch buffers */
+static QalamResult block_row_view(Scrollback* sb, const BlockRef* ref, uint32_t index,
+                                  RowView* view) {
+    if (ref->packed) {
+        packed_row_view(ref->packed, index, view);
+        return QALAM_OK;
+    }
+
+    size_t text_used = 0;
+    size_t runs_used = 0;
+    QalamResult result = pack_row(sb, ref->hot->cells + (size_t)index * ref->hot->width,
+                                  ref->hot->lengths[index], &text_used, &runs_used);
+    if (result != QALAM_OK) {
+        return result;
+    }
+
+    view->text = sb->scratch_text;
+    view->text_length = text_used;
+    view->runs = sb->scratch_runs;
+    view->run_count = runs_used;
+    return QALAM_OK;
+}
+
+static inline size_t align_up(size_t value, size_t alignment) {
+    return (value + alignment - 1) & ~(alignment - 1);
+}
+
+/** Pack a hot block into a new packed block */
+static QalamResult pack_block(Scrollback* sb, const HotBlock* hot, PackedBlock** packed) {
+    uint32_t text_offsets[SCROLLBACK_BLOCK_ROWS + 1];
+    uint32_t run_offsets[SCROLLBACK_BLOCK_ROWS + 1];
+    size_t text_used = 0;
+    size_t runs_used = 0;
+
+    for (uint32_t i = 0; i < hot->row_count; i++) {
+        text_offsets[i] = (uint32_t)text_used;
+        run_offsets[i] = (uint32_t)runs_used;
+        QalamResult result = pack_row(sb, hot->cells + (size_t)i * hot->width, hot->lengths[i],
+                                      &text_used, &runs_used);
+        if (result != QALAM_OK) {
+            return result;
+        }
+    }
+    text_offsets[hot->row_count] = (uint32_t)text_used;
+    run_offsets[hot->row_count] = (uint32_t)runs_used;
+
+    size_t rows = hot->row_count;
+    size_t offsets_at = align_up(sizeof(PackedBlock), sizeof(uint64_t));
+    size_t runs_at = offsets_at + 2 * (rows + 1) * sizeof(uint32_t);
+    size_t lengths_at = runs_at + runs_used * sizeof(AttrRun);
+    size_t flags_at = lengths_at + rows * sizeof(uint16_t);
+    size_t text_at = flags_at + rows;
+    size_t bytes = text_at + text_used;
+
+    char* memory = (char*)qalam_mem_alloc(QALAM_MEMORY_TERMINAL, bytes);
+    if (!memory) {
+        return QALAM_ERROR_OUT_OF_MEMORY;
+    }
+
+    PackedBlock* block = (PackedBlock*)memory;
+    block->first_row = hot->first_row;
+    block->bytes = bytes;
+    block->row_count = hot->row_count;
+    block->text_offsets = (uint32_t*)(memory + offsets_at);
+    block->run_offsets = block->text_offsets + rows + 1;
+    block->runs = (AttrRun*)(memory + runs_at);
+    block->lengths = (uint16_t*)(memory + lengths_at);
+    block->flags = (uint8_t*)(memory + flags_at);
+    block->text = memory + text_at;
+
+    memcpy(block->text_offsets, text_offsets, (rows + 1) * sizeof(uint32_t));
+    memcpy(block->run_offsets, run_offsets, (rows + 1) * sizeof(uint32_t));
+    memcpy(block->runs, sb->scratch_runs, runs_used * sizeof(AttrRun));
+    memcpy(block->lengths, hot->lengths, rows * sizeof(uint16_t));
+    memcpy(block->flags, hot->flags, rows);
+    memcpy(block->text, sb->scratch_text, text_used);
+
+    *packed = block;
+    return QALAM_OK;
+}
+
+static QalamResult append_packed(Scrollback* sb, PackedBlock* block) {
+    if (sb->packed_count == sb->packed_capacity) {
+        size_t capacity = sb->packed_capacity ? sb->packed_capacity * 2 : 64;
+        PackedBlock** ring = (PackedBlock**)qalam_mem_alloc(QALAM_MEMORY_TERMINAL,
+                                                            capacity * sizeof(PackedBlock*));
+        if (!ring) {
+            return QALAM_ERROR_OUT_OF_MEMORY;
+        }
+        for (size_t i = 0; i < sb->packed_count; i++) {
+            ring[i] = packed_block(sb, i);
+        }
+        qalam_mem_free(sb->packed);
+        sb->packed = ring;
+        sb->packed_capacity = capacity;
+        sb->packed_start = 0;
+    }
+
+    sb->packed[(sb->packed_start + sb->packed_count) % sb->packed_capacity] = block;
+    sb->packed_count++;
+    sb->bytes += block->bytes;
+    return QALAM_OK;
+}
+
+/** Drop the oldest packed blocks until the store fits its budget */
+static void enforce_budget(Scrollback* sb) {
+    while (sb->bytes > sb->budget && sb->packed_count > 0) {
+        PackedBlock* block = packed_block(sb, 0);
+        sb->packed_start = (sb->packed_start + 1) % sb->packed_capacity;
+        sb->packed_count--;
+        sb->bytes -= block->bytes;
+        sb->rows_dropped += block->row_count;
+        sb->first_row = block->first_row + block->row_count;
+        qalam_mem_free(block);
+    }
+}
+
+/** Make the newest hot block one with room for a row of 'width' cells */
+static QalamResult open_hot_block(Scrollback* sb, uint16_t width) {
+    HotBlock* block;
+
+    if (sb->hot_count == SCROLLBACK_HOT_BLOCKS) {
+        HotBlock* oldest = hot_block(sb, 0);
+        PackedBlock* packed;
+        QalamResult result = pack_block(sb, oldest, &packed);
+        if (result != QALAM_OK) {
+            return result;
+        }
+        result = append_packed(sb, packed);
+        if (result != QALAM_OK) {
+            qalam_mem_free(packed);
+            return result;
+        }
+        sb->hot_start = (sb->hot_start + 1) % SCROLLBACK_HOT_BLOCKS;
+        sb->hot_count--;
+        block = oldest;
+    } else {
+        block = hot_block(sb, sb->hot_count);
+    }
+
+    size_t cells = (size_t)SCROLLBACK_BLOCK_ROWS * width;
+    if (block->capacity < cells) {
+        TerminalCell* memory = (TerminalCell*)qalam_mem_realloc(
+            QALAM_MEMORY_TERMINAL, block->cells, cells * sizeof(TerminalCell));
+        if (!memory) {
+            return QALAM_ERROR_OUT_OF_MEMORY;
+        }
+        sb->bytes += (cells - block->capacity) * sizeof(TerminalCell);
+        block->cells = memory;
+        block->capacity = cells;
+    }
+
+    block->first_row = sb->end_row;
+    block->row_count = 0;
+    block->width = width;
+    sb->hot_count++;
+
+    enforce_budget(sb);
+    return QALAM_OK;
+}
+
+/** Get an unpacked copy of a packed block from the cache */
+static QalamResult cache_get(Scrollback* sb, const PackedBlock* block, CacheBlock** entry) {
+    CacheBlock* victim = &sb->cache[0];
+
+    sb->cache_clock++;
+    for (size_t i = 0; i < SCROLLBACK_CACHE_BLOCKS; i++) {
+        CacheBlock* c = &sb->cache[i];
+        if (c->valid && c->first_row == block->first_row) {
+            c->last_used = sb->cache_clock;
+            *entry = c;
+            return QALAM_OK;
+        }
+        if (!c->valid || (victim->valid && c->last_used < victim->last_used)) {
+            victim = c;
+        }
+    }
+
+    size_t width = 1;
+    for (uint32_t i = 0; i < block->row_count; i++) {
+        if (block->lengths[i] > width) {
+            width = block->lengths[i];
+        }
+    }
+
+    size_t cells = width * block->row_count;
+    if (victim->capacity < cells) {
+        TerminalCell* memory = (TerminalCell*)qalam_mem_realloc(
+            QALAM_MEMORY_TERMINAL, victim->cells, cells * sizeof(TerminalCell));
+        if (!memory) {
+            return QALAM_ERROR_OUT_OF_MEMORY;
+        }
+        sb->cache_bytes += (cells - victim->capacity) * sizeof(TerminalCell);
+        victim->cells = memory;
+        victim->capacity = cells;
+    }
+
+    for (uint32_t i = 0; i < block->row_count; i++) {
+        RowView view;
+        packed_row_view(block, i, &view);
+        unpack_row(&view, victim->cells + (size_t)i * width);
+    }
+
+    victim->valid = true;
+    victim->first_row = block->first_row;
+    victim->width = width;
+    victim->last_used = sb->cache_clock;
+    *entry = victim;
+    return QALAM_OK;
+}
+
+static void free_blocks(Scrollback* sb) {
+    for (size_t i = 0; i < sb->packed_count; i++) {
+        qalam_mem_free(packed_block(sb, i));
+    }
+    sb->packed_start = 0;
+    sb->packed_count = 0;
+
+    for (size_t i = 0; i < SCROLLBACK_HOT_BLOCKS; i++) {
+        qalam_mem_free(sb->hot[i].cells);
+        sb->hot[i].cells = NULL;
+        sb->hot[i].capacity = 0;
+    }
+    sb->hot_start = 0;
+    sb->hot_count = 0;
+
+    for (size_t i = 0; i < SCROLLBACK_CACHE_BLOCKS; i++) {
+        qalam_mem_free(sb->cache[i].cells);
+        sb->cache[i].cells = NULL;
+        sb->cache[i].capacity = 0;
+        sb->cache[i].valid = false;
+    }
+
+    sb->bytes = 0;
+    sb->cache_bytes = 0;
+}
+
+/*=============================================================================
+ * Lifecycle
+ *============================================================================*/
+
+QalamResult scrollback_create(Scrollback** scrollback, size_t budget) {
+    if (!scrollback) {
+        return QALAM_ERROR_NULL_POINTER;
+    }
+
+    *scrollback = NULL;
+
+    Scrollback* sb = (Scrollback*)qalam_mem_calloc(QALAM_MEMORY_TERMINAL, 1, sizeof(Scrollback));
+    if (!sb) {
+        return QALAM_ERROR_OUT_OF_MEMORY;
+    }
+
+    sb->budget = budget ? budget : SCROLLBACK_DEFAULT_BUDGET;
+
+    *scrollback = sb;
+    return QALAM_OK;
+}
+
+void scrollback_destroy(Scrollback* scrollback) {
+    if (!scrollback) {
+        return;
+    }
+
+    free_blocks(scrollback);
+    qalam_mem_free(scrollback->packed);
+    qalam_mem_free(scrollback->scratch_text);
+    qalam_mem_free(scrollback->scratch_runs);
+    qalam_mem_free(scrollback);
+}
+
+void scrollback_clear(Scrollback* scrollback) {
+    if (!scrollback) {
+        return;
+    }
+
+    free_blocks(scrollback);
+    scrollback->first_row = scrollback->end_row;
+}
+
+/*=============================================================================
+ * Rows
+ *============================================================================*/
+
+QalamResult scrollback_push_row(Scrollback* scrollback, const TerminalCell* cells,
+                                size_t width, unsigned int flags) {
+    if (!scrollback || !cells) {
+        return QALAM_ERROR_NULL_POINTER;
+    }
+    if (width == 0 || width > UINT16_MAX) {
+        return QALAM_ERROR_INVALID_ARGUMENT;
+    }
+
+    HotBlock* block = scrollback->hot_count ? hot_block(scrollback, scrollback->hot_count - 1) : NULL;
+    if (!block || block->row_count == SCROLLBACK_BLOCK_ROWS || block->width != width) {
+        QalamResult result = open_hot_block(scrollback, (uint16_t)width);
+        if (result != QALAM_OK) {
+            return result;
+        }
+        block = hot_block(scrollback, scrollback->hot_count - 1);
+    }
+
+    size_t length = width;
+    while (length > 0 && cell_is_blank(&cells[length - 1])) {
+        length--;
+    }
+
+    uint32_t index = block->row_count++;
+    memcpy(block->cells + (size_t)index * width, cells, width * sizeof(TerminalCell));
+    block->lengths[index] = (uint16_t)length;
+    block->flags[index] = (uint8_t)flags;
+    scrollback->end_row++;
+    return QALAM_OK;
+}
+
+uint64_t scrollback_get_first_row(const Scrollback* scrollback) {
+    return scrollback ? scrollback->first_row : 0;
+}
+
+uint64_t scrollback_get_end_row(const Scrollback* scrollback) {
+    return scrollback ? scrollback->end_row : 0;
+}
+
+QalamResult scrollback_read_row(Scrollback* scrollback, uint64_t row, TerminalCell* cells,
+                                size_t max_cells, size_t* length, unsigned int* flags) {
+    if (!scrollback || (!cells && max_cells > 0)) {
+        return QALAM_ERROR_NULL_POINTER;
+    }
+
+    BlockRef ref;
+    if (!find_block(scrollback, row, &ref)) {
+        return QALAM_ERROR_INVALID_POSITION;
+    }
+
+    uint32_t index = (uint32_t)(row - ref.first_row);
+    const TerminalCell* source;
+    size_t row_length;
+    unsigned int row_flags;
+
+    if (ref.hot) {
+        source = ref.hot->cells + (size_t)index * ref.hot->width;
+        row_length = ref.hot->lengths[index];
+        row_flags = ref.hot->flags[index];
+    } else {
+        CacheBlock* entry;
+        QalamResult result = cache_get(scrollback, ref.packed, &entry);
+        if (result != QALAM_OK) {
+            return result;
+        }
+        source = entry->cells + (size_t)index * entry->width;
+        row_length = ref.packed->lengths[index];
+        row_flags = ref.packed->flags[index];
+    }
+
+    size_t copy = row_length < max_cells ? row_length : max_cells;
+    if (copy > 0) {
+        memcpy(cells, source, copy * sizeof(TerminalCell));
+    }
+    if (max_cells > copy) {
+        memset(cells + copy, 0, (max_cells - copy) * sizeof(TerminalCell));
+    }
+
+    if (length) *length = row_length;
+    if (flags) *flags = row_flags;
+    return QALAM_OK;
+}
+
+void scrollback_get_stats(const Scrollback* scrollback, ScrollbackStats* stats) {
+    if (!stats) {
+        return;
+    }
+
+    memset(stats, 0, sizeof(ScrollbackStats));
+    if (!scrollback) {
+        return;
+    }
+
+    stats->rows = scrollback->end_row - scrollback->first_row;
+    stats->rows_dropped = scrollback->rows_dropped;
+    for (size_t i = 0; i < scrollback->hot_count; i++) {
+        stats->hot_rows += scrollback->hot[(scrollback->hot_start + i) % SCROLLBACK_HOT_BLOCKS].row_count;
+    }
+    stats->packed_blocks = scrollback->packed_count;
+    stats->bytes = scrollback->bytes;
+    stats->cache_bytes = scrollback->cache_bytes;
+}
+
+/*=============================================================================
+ * Search
+ *============================================================================*/
+
+QalamResult scrollback_find(Scrollback* scrollback, const char* pattern, size_t length,
+                            uint64_t row, size_t column, bool backwards, bool ignore_case,
+                            ScrollbackMatch* match, bool* found) {
+    if (!scrollback || !pattern || !match || !found) {
+        return QALAM_ERROR_NULL_POINTER;
+    }
+
+    *found = false;
+
+    if (length == 0) {
+        return QALAM_ERROR_INVALID_ARGUMENT;
+    }
+
+    if (scrollback->first_row == scrollback->end_row) {
+        return QALAM_OK;
+    }
+
+    if (backwards) {
+        if (row < scrollback->first_row) {
+            return QALAM_OK;
+        }
+        if (row >= scrollback->end_row) {
+            row = scrollback->end_row - 1;
+            column = SIZE_MAX;
+        }
+    } else {
+        if (row >= scrollback->end_row) {
+            return QALAM_OK;
+        }
+        if (row < scrollback->first_row) {
+            row = scrollback->first_row;
+            column = 0;
+        }
+    }
+
+    bool first = true;
+    for (;;) {
+        BlockRef ref;
+        if (!find_block(scrollback, row, &ref)) {
+            return QALAM_OK;
+        }
+
+        /* Walk the block's rows from 'row' in the search direction */
+        uint32_t index = (uint32_t)(row - ref.first_row);
+        for (;;) {
+            RowView view;
+            QalamResult result = block_row_view(scrollback, &ref, index, &view);
+            if (result != QALAM_OK) {
+                return result;
+            }
+
+            size_t from = 0;
+            size_t to = view.text_length;
+            if (first) {
+                if (backwards) {
+                    to = column == SIZE_MAX ? to : view_offset(&view, column);
+                } else {
+                    from = view_offset(&view, column);
+                }
+                first = false;
+            }
+
+            size_t offset;
+            if (view_find(&view, pattern, length, from, to, backwards, ignore_case, &offset)) {
+                size_t first_column = 0;
+                size_t end_column = 0;
+                view_columns(&view, offset, offset + length, &first_column, &end_column);
+                match->row = ref.first_row + index;
+                match->column = first_column;
+                match->cells = end_column - first_column;
+                *found = true;
+                return QALAM_OK;
+            }
+
+            if (backwards) {
+                if (index == 0) {
+                    break;
+                }
+                index--;
+            } else {
+                if (index + 1 == ref.row_count) {
+                    break;
+                }
+                index++;
+            }
+        }
+
+        if (backwards) {
+            if (ref.first_row == 0) {
+                return QALAM_OK;
+            }
+            row = ref.first_row - 1;
+        } else {
+            row = ref.first_row + ref.row_count;
+        }
+    }
+}
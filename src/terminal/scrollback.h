@@ -0,0 +1,206 @@
+/**
+ * @file scrollback.h
+ * @brief Qalam IDE - Terminal Scrollback Store (Internal Header)
+ *
+ * Internal header for the rows that have scrolled off the top of a
+ * terminal's screen. Rows are kept in blocks of SCROLLBACK_BLOCK_ROWS:
+ *
+ * - The newest SCROLLBACK_HOT_BLOCKS blocks are hot: a ring of arrays of
+ *   cells, one row after another at the width they were pushed with, so
+ *   pushing a row is a copy.
+ * - When the ring is full its oldest block is packed: each row becomes
+ *   its UTF-8 text plus runs of equal attributes, with trailing blanks
+ *   dropped. A line of plain output shrinks from 16 bytes a cell to
+ *   about one byte a character.
+ * - When hot and packed blocks together exceed the memory budget the
+ *   oldest packed blocks are dropped.
+ *
+ * Packed rows are unpacked only when they are read, a block at a time,
+ * into a small cache, so scrolling through history unpacks each block
+ * once. Search runs over the packed text directly.
+ *
+ * Rows are numbered from the first row ever pushed, so a row keeps its
+ * number while older rows are dropped; scrollback_get_first_row() and
+ * scrollback_get_end_row() give the range still held.
+ *
+ * @version 0.0.2
+ * @copyright (c) 2026 Qalam Project
+ *
+ * @note Thread Safety: Not thread-safe. Use a store from one thread.
+ */
+
+#ifndef QALAM_SCROLLBACK_H
+#define QALAM_SCROLLBACK_H
+
+#include "qalam.h"
+#include "terminal_cell.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*=============================================================================
+ * Configuration Constants
+ *============================================================================*/
+
+/** Rows in a block */
+#define SCROLLBACK_BLOCK_ROWS           64
+
+/** Blocks kept unpacked at the newest end */
+#define SCROLLBACK_HOT_BLOCKS           4
+
+/** Packed blocks kept unpacked after a read */
+#define SCROLLBACK_CACHE_BLOCKS         4
+
+/** Default memory budget in bytes */
+#define SCROLLBACK_DEFAULT_BUDGET       (64 * 1024 * 1024)
+
+/** The row's line continues on the next row (it was wrapped) */
+#define SCROLLBACK_ROW_WRAPPED          0x1u
+
+/*=============================================================================
+ * Scrollback Structures
+ *============================================================================*/
+
+/**
+ * @brief A search match
+ */
+typedef struct ScrollbackMatch {
+    uint64_t row;                   /**< Row of the match */
+    size_t column;                  /**< First cell of the match */
+    size_t cells;                   /**< Cells the match covers */
+} ScrollbackMatch;
+
+/**
+ * @brief Memory use and contents
+ */
+typedef struct ScrollbackStats {
+    uint64_t rows;                  /**< Rows held */
+    uint64_t rows_dropped;          /**< Rows dropped to stay within the budget */
+    size_t hot_rows;                /**< Rows in hot blocks */
+    size_t packed_blocks;           /**< Packed blocks */
+    size_t bytes;                   /**< Bytes of hot and packed blocks (counted against the budget) */
+    size_t cache_bytes;             /**< Bytes of unpacked blocks in the read cache */
+} ScrollbackStats;
+
+/**
+ * @brief Opaque scrollback store
+ */
+typedef struct Scrollback Scrollback;
+
+/*=============================================================================
+ * Lifecycle
+ *============================================================================*/
+
+/**
+ * @brief Create a scrollback store
+ *
+ * @param[out] scrollback Receives the store
+ * @param budget Memory budget in bytes (0 for SCROLLBACK_DEFAULT_BUDGET).
+ *        The newest blocks are kept even when they alone exceed it.
+ * @return QALAM_OK on success, error code on failure
+ */
+QalamResult scrollback_create(Scrollback** scrollback, size_t budget);
+
+/**
+ * @brief Destroy a scrollback store
+ *
+ * @param scrollback Store to destroy (may be NULL)
+ */
+void scrollback_destroy(Scrollback* scrollback);
+
+/**
+ * @brief Drop every row
+ *
+ * Row numbers carry on from where they were.
+ *
+ * @param scrollback Scrollback store
+ */
+void scrollback_clear(Scrollback* scrollback);
+
+/*=============================================================================
+ * Rows
+ *============================================================================*/
+
+/**
+ * @brief Add a row at the newest end
+ *
+ * @param scrollback Scrollback store
+ * @param cells The row's cells
+ * @param width Number of cells (1 to 65535)
+ * @param flags SCROLLBACK_ROW_* flags
+ * @return QALAM_OK on success, error code on failure
+ */
+QalamResult scrollback_push_row(Scrollback* scrollback, const TerminalCell* cells,
+                                size_t width, unsigned int flags);
+
+/**
+ * @brief Get the number of the oldest row held
+ */
+uint64_t scrollback_get_first_row(const Scrollback* scrollback);
+
+/**
+ * @brief Get the number one past the newest row
+ */
+uint64_t scrollback_get_end_row(const Scrollback* scrollback);
+
+/**
+ * @brief Copy a row out
+ *
+ * Cells past the row's stored length, up to 'max_cells', are filled
+ * with empty cells; cells past 'max_cells' are cut off.
+ *
+ * @param scrollback Scrollback store
+ * @param row Row number
+ * @param[out] cells Array to receive the cells
+ * @param max_cells Entries in 'cells'
+ * @param[out] length Receives the row's length without trailing blanks (optional)
+ * @param[out] flags Receives the row's SCROLLBACK_ROW_* flags (optional)
+ * @return QALAM_OK on success, QALAM_ERROR_INVALID_POSITION if the row is
+ *         not held, error code on other failure
+ */
+QalamResult scrollback_read_row(Scrollback* scrollback, uint64_t row, TerminalCell* cells,
+                                size_t max_cells, size_t* length, unsigned int* flags);
+
+/**
+ * @brief Get memory use and contents
+ *
+ * @param scrollback Scrollback store
+ * @param[out] stats Pointer to receive the statistics
+ */
+void scrollback_get_stats(const Scrollback* scrollback, ScrollbackStats* stats);
+
+/*=============================================================================
+ * Search
+ *============================================================================*/
+
+/**
+ * @brief Find text in the rows held
+ *
+ * Searches each row's text as stored, without unpacking it. Matches do
+ * not span rows. Forwards, the first match at or after 'column' of
+ * 'row' is found, then in the rows after it; backwards, the last match
+ * before 'column' (SIZE_MAX for the whole row), then in the rows before.
+ * Empty cells match spaces.
+ *
+ * @param scrollback Scrollback store
+ * @param pattern Text to find (UTF-8)
+ * @param length Length of pattern in bytes
+ * @param row Row to start at (clamped to the rows held)
+ * @param column Cell to start at
+ * @param backwards Search towards older rows
+ * @param ignore_case Fold A-Z onto a-z
+ * @param[out] match Receives the match
+ * @param[out] found Set to whether a match was found
+ * @return QALAM_OK on success, QALAM_ERROR_INVALID_ARGUMENT for an empty
+ *         pattern, error code on other failure
+ */
+QalamResult scrollback_find(Scrollback* scrollback, const char* pattern, size_t length,
+                            uint64_t row, size_t column, bool backwards, bool ignore_case,
+                            ScrollbackMatch* match, bool* found);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* QALAM_SCROLLBACK_H */
@@ -0,0 +1,312 @@
+/**
+ * @file terminal_cell.c
+ * @brief Qalam IDE - Terminal Cell Character Functions
+ *
+ * Widths follow the East Asian Width property (W and F) and the emoji
+ * blocks for wide characters, and general category Mn/Me plus format
+ * characters for zero width, over the ranges a terminal meets in
+ * practice rather than the whole of Unicode.
+ *
+ * Marks a cell can carry are numbered through a table of ranges, so an
+ * index fits the 11 bits above a cell's character.
+ *
+ * @version 0.0.2
+ * @copyright (c) 2026 Qalam Project
+ */
+
+#include "terminal_cell.h"
+
+/*=============================================================================
+ * Character Tables
+ *============================================================================*/
+
+/**
+ * @brief A range of characters, inclusive
+ */
+typedef struct CharRange {
+    uint32_t first;
+    uint32_t last;
+} CharRange;
+
+/** Combining marks a cell can carry, in index order */
+static const CharRange g_marks[] = {
+    { 0x0300, 0x036F },     /* Combining diacritical marks */
+    { 0x0483, 0x0489 },     /* Cyrillic */
+    { 0x0591, 0x05BD },     /* Hebrew points */
+    { 0x05BF, 0x05BF },
+    { 0x05C1, 0x05C2 },
+    { 0x05C4, 0x05C5 },
+    { 0x05C7, 0x05C7 },
+    { 0x0610, 0x061A },     /* Arabic honorifics */
+    { 0x064B, 0x065F },     /* Arabic harakat */
+    { 0x0670, 0x0670 },     /* Superscript alef */
+    { 0x06D6, 0x06DC },     /* Quranic annotation */
+    { 0x06DF, 0x06E4 },
+    { 0x06E7, 0x06E8 },
+    { 0x06EA, 0x06ED },
+    { 0x08D3, 0x08E1 },     /* Arabic extended-A marks */
+    { 0x08E3, 0x08FF },
+    { 0x1AB0, 0x1AFF },     /* Combining diacritical marks extended */
+    { 0x1DC0, 0x1DFF },     /* Combining diacritical marks supplement */
+    { 0x20D0, 0x20F0 },     /* Combining marks for symbols */
+    { 0xFE00, 0xFE0F },     /* Variation selectors */
+    { 0xFE20, 0xFE2F },     /* Combining half marks */
+};
+
+/** Zero-width characters that are not marks a cell carries */
+static const CharRange g_zero_width[] = {
+    { 0x00AD, 0x00AD },     /* Soft hyphen */
+    { 0x061C, 0x061C },     /* Arabic letter mark */
+    { 0x180E, 0x180E },
+    { 0x200B, 0x200F },     /* Zero-width space, joiners, directional marks */
+    { 0x202A, 0x202E },     /* Directional embeddings */
+    { 0x2060, 0x2064 },
+    { 0x2066, 0x206F },     /* Directional isolates */
+    { 0xFEFF, 0xFEFF },     /* Byte order mark */
+    { 0xE0000, 0xE0FFF },   /* Tags and variation selectors supplement */
+};
+
+/** Wide and fullwidth characters */
+static const CharRange g_wide[] = {
+    { 0x1100, 0x115F },     /* Hangul jamo */
+    { 0x231A, 0x231B },
+    { 0x2329, 0x232A },
+    { 0x23E9, 0x23EC },
+    { 0x23F0, 0x23F0 },
+    { 0x23F3, 0x23F3 },
+    { 0x25FD, 0x25FE },
+    { 0x2614, 0x2615 },
+    { 0x2648, 0x2653 },
+    { 0x267F, 0x267F },
+    { 0x2693, 0x2693 },
+    { 0x26A1, 0x26A1 },
+    { 0x26AA, 0x26AB },
+    { 0x26BD, 0x26BE },
+    { 0x26C4, 0x26C5 },
+    { 0x26CE, 0x26CE },
+    { 0x26D4, 0x26D4 },
+    { 0x26EA, 0x26EA },
+    { 0x26F2, 0x26F3 },
+    { 0x26F5, 0x26F5 },
+    { 0x26FA, 0x26FA },
+    { 0x26FD, 0x26FD },
+    { 0x2705, 0x2705 },
+    { 0x270A, 0x270B },
+    { 0x2728, 0x2728 },
+    { 0x274C, 0x274C },
+    { 0x274E, 0x274E },
+    { 0x2753, 0x2755 },
+    { 0x2757, 0x2757 },
+    { 0x2795, 0x2797 },
+    { 0x27B0, 0x27B0 },
+    { 0x27BF, 0x27BF },
+    { 0x2B1B, 0x2B1C },
+    { 0x2B50, 0x2B50 },
+    { 0x2B55, 0x2B55 },
+    { 0x2E80, 0x303E },     /* CJK radicals, punctuation */
+    { 0x3041, 0x33FF },     /* Kana, CJK compatibility */
+    { 0x3400, 0x4DBF },     /* CJK extension A */
+    { 0x4E00, 0x9FFF },     /* CJK unified ideographs */
+    { 0xA000, 0xA4CF },     /* Yi */
+    { 0xA960, 0xA97F },
+    { 0xAC00, 0xD7A3 },     /* Hangul syllables */
+    { 0xF900, 0xFAFF },     /* CJK compatibility ideographs */
+    { 0xFE10, 0xFE19 },
+    { 0xFE30, 0xFE6F },     /* CJK compatibility forms */
+    { 0xFF00, 0xFF60 },     /* Fullwidth forms */
+    { 0xFFE0, 0xFFE6 },
+    { 0x16FE0, 0x18CFF },   /* Tangut, Khitan */
+    { 0x1B000, 0x1B2FF },   /* Kana supplement */
+    { 0x1F004, 0x1F004 },
+    { 0x1F0CF, 0x1F0CF },
+    { 0x1F18E, 0x1F18E },
+    { 0x1F191, 0x1F19A },
+    { 0x1F200, 0x1F251 },
+    { 0x1F300, 0x1F64F },   /* Pictographs, emoticons */
+    { 0x1F680, 0x1F6FF },   /* Transport and map */
+    { 0x1F7E0, 0x1F7EB },
+    { 0x1F90C, 0x1F9FF },   /* Supplemental pictographs */
+    { 0x1FA70, 0x1FAFF },
+    { 0x20000, 0x2FFFD },   /* CJK extensions B-F */
+    { 0x30000, 0x3FFFD },   /* CJK extension G */
+};
+
+#define RANGE_COUNT(table) (sizeof(table) / sizeof((table)[0]))
+
+/*=============================================================================
+ * Internal Helper Functions
+ *============================================================================*/
+
+static bool in_ranges(const CharRange* ranges, size_t count, uint32_t codepoint) {
+    size_t low = 0;
+    size_t high = count;
+    while (low < high) {
+        size_t mid = low + (high - low) / 2;
+        if (codepoint < ranges[mid].first) {
+            high = mid;
+        } else if (codepoint > ranges[mid].last) {
+            low = mid + 1;
+        } else {
+            return true;
+        }
+    }
+    return false;
+}
+
+/*=============================================================================
+ * Character Functions
+ *============================================================================*/
+
+int terminal_char_width(uint32_t codepoint) {
+    /* Most output is ASCII and Arabic letters */
+    if (codepoint < 0x0300) {
+        return codepoint == 0x00AD ? 0 : 1;
+    }
+    if (codepoint < 0x1100) {
+        return terminal_mark_index(codepoint) ||
+               in_ranges(g_zero_width, RANGE_COUNT(g_zero_width), codepoint) ? 0 : 1;
+    }
+    if (in_ranges(g_wide, RANGE_COUNT(g_wide), codepoint)) {
+        return 2;
+    }
+    return terminal_mark_index(codepoint) ||
+           in_ranges(g_zero_width, RANGE_COUNT(g_zero_width), codepoint) ? 0 : 1;
+}
+
+unsigned int terminal_mark_index(uint32_t codepoint) {
+    if (codepoint < g_marks[0].first) {
+        return 0;
+    }
+
+    unsigned int index = 1;
+    for (size_t i = 0; i < RANGE_COUNT(g_marks); i++) {
+        if (codepoint < g_marks[i].first) {
+            return 0;
+        }
+        if (codepoint <= g_marks[i].last) {
+            return index + (codepoint - g_marks[i].first);
+        }
+        index += g_marks[i].last - g_marks[i].first + 1;
+    }
+    return 0;
+}
+
+uint32_t terminal_mark_codepoint(unsigned int index) {
+    if (index == 0) {
+        return 0;
+    }
+
+    index--;
+    for (size_t i = 0; i < RANGE_COUNT(g_marks); i++) {
+        uint32_t size = g_marks[i].last - g_marks[i].first + 1;
+        if (index < size) {
+            return g_marks[i].first + index;
+        }
+        index -= size;
+    }
+    return 0;
+}
+
+uint32_t terminal_utf8_decode(const char* text, size_t length, size_t* consumed) {
+    const unsigned char* s = (const unsigned char*)text;
+    unsigned char lead = s[0];
+    size_t needed;
+    uint32_t codepoint;
+    uint32_t minimum;
+
+    if (lead < 0x80) {
+        *consumed = 1;
+        return lead;
+    } else if (lead >= 0xC2 && lead <= 0xDF) {
+        needed = 1;
+        codepoint = lead & 0x1F;
+        minimum = 0x80;
+    } else if (lead >= 0xE0 && lead <= 0xEF) {
+        needed = 2;
+        codepoint = lead & 0x0F;
+        minimum = 0x800;
+    } else if (lead >= 0xF0 && lead <= 0xF4) {
+        needed = 3;
+        codepoint = lead & 0x07;
+        minimum = 0x10000;
+    } else {
+        *consumed = 1;
+        return 0xFFFD;
+    }
+
+    size_t i = 1;
+    for (; i <= needed; i++) {
+        if (i >= length || (s[i] & 0xC0) != 0x80) {
+            *consumed = i;
+            return 0xFFFD;
+        }
+        codepoint = (codepoint << 6) | (s[i] & 0x3F);
+    }
+
+    *consumed = i;
+    if (codepoint < minimum || codepoint > 0x10FFFF ||
+        (codepoint >= 0xD800 && codepoint <= 0xDFFF)) {
+        return 0xFFFD;
+    }
+    return codepoint;
+}
+
+static size_t utf8_encode(uint32_t codepoint, char* out) {
+    if (codepoint > 0x10FFFF || (codepoint >= 0xD800 && codepoint <= 0xDFFF)) {
+        codepoint = 0xFFFD;
+    }
+
+    if (codepoint < 0x80) {
+        out[0] = (char)codepoint;
+        return 1;
+    }
+    if (codepoint < 0x800) {
+        out[0] = (char)(0xC0 | (codepoint >> 6));
+        out[1] = (char)(0x80 | (codepoint & 0x3F));
+        return 2;
+    }
+    if (codepoint < 0x10000) {
+        out[0] = (char)(0xE0 | (codepoint >> 12));
+        out[1] = (char)(0x80 | ((codepoint >> 6) & 0x3F));
+        out[2] = (char)(0x80 | (codepoint & 0x3F));
+        return 3;
+    }
+    out[0] = (char)(0xF0 | (codepoint >> 18));
+    out[1] = (char)(0x80 | ((codepoint >> 12) & 0x3F));
+    out[2] = (char)(0x80 | ((codepoint >> 6) & 0x3F));
+    out[3] = (char)(0x80 | (codepoint & 0x3F));
+    return 4;
+}
+
+static size_t utf16_encode(uint32_t codepoint, wchar_t* out) {
+    if (codepoint > 0x10FFFF || (codepoint >= 0xD800 && codepoint <= 0xDFFF)) {
+        codepoint = 0xFFFD;
+    }
+
+    if (codepoint < 0x10000) {
+        out[0] = (wchar_t)codepoint;
+        return 1;
+    }
+    codepoint -= 0x10000;
+    out[0] = (wchar_t)(0xD800 | (codepoint >> 10));
+    out[1] = (wchar_t)(0xDC00 | (codepoint & 0x3FF));
+    return 2;
+}
+
+size_t terminal_cell_to_utf8(uint32_t codepoint, char* out) {
+    size_t length = utf8_encode(TERMINAL_CELL_CHAR(codepoint), out);
+    uint32_t mark = terminal_mark_codepoint(TERMINAL_CELL_MARK(codepoint));
+    if (mark) {
+        length += utf8_encode(mark, out + length);
+    }
+    return length;
+}
+
+size_t terminal_cell_to_utf16(uint32_t codepoint, wchar_t* out) {
+    size_t length = utf16_encode(TERMINAL_CELL_CHAR(codepoint), out);
+    uint32_t mark = terminal_mark_codepoint(TERMINAL_CELL_MARK(codepoint));
+    if (mark) {
+        length += utf16_encode(mark, out + length);
+    }
+    return length;
+}
@@ -0,0 +1,172 @@
+/**
+ * @file terminal_cell.h
+ * @brief Qalam IDE - Terminal Cell Types (Internal Header)
+ *
+ * Internal header for the cell a terminal row is made of: one character
+ * and the attributes it was written with. The screen, the scrollback and
+ * the renderer all share this layout. A character two cells wide takes
+ * its own cell and a following cell flagged TERMINAL_ATTR_WIDE_TAIL.
+ *
+ * A cell may also carry one combining mark (an Arabic haraka, a Latin
+ * accent) drawn over its character, packed into the top bits of its
+ * codepoint; see "Characters".
+ *
+ * @version 0.0.2
+ * @copyright (c) 2026 Qalam Project
+ */
+
+#ifndef QALAM_TERMINAL_CELL_H
+#define QALAM_TERMINAL_CELL_H
+
+#include "qalam.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*=============================================================================
+ * Colors
+ *
+ * A color is the default, a palette index or an RGB value, told apart by
+ * the top byte.
+ *============================================================================*/
+
+/** The default foreground or background */
+#define TERMINAL_COLOR_DEFAULT          0x00000000u
+
+/** Palette color 0-255 */
+#define TERMINAL_COLOR_INDEXED(index)   (0x01000000u | ((uint32_t)(index) & 0xFFu))
+
+/** Direct RGB color */
+#define TERMINAL_COLOR_RGB(r, g, b)     (0x02000000u | ((uint32_t)(r) & 0xFFu) << 16 | \
+                                         ((uint32_t)(g) & 0xFFu) << 8 | ((uint32_t)(b) & 0xFFu))
+
+/** Kind of a color: 0 default, 1 indexed, 2 RGB */
+#define TERMINAL_COLOR_KIND(color)      ((color) >> 24)
+
+/*=============================================================================
+ * Characters
+ *
+ * A cell's codepoint holds its character in the low 21 bits and, in the
+ * high 11 bits, the index of a combining mark on it (0 for none) from
+ * terminal_mark_index(). The character itself is never a combining mark.
+ *============================================================================*/
+
+/** The character of a cell's codepoint */
+#define TERMINAL_CELL_CHAR(codepoint)   ((codepoint) & 0x1FFFFFu)
+
+/** The mark index of a cell's codepoint (0 for none) */
+#define TERMINAL_CELL_MARK(codepoint)   ((codepoint) >> 21)
+
+/** A cell codepoint from a character and a mark index */
+#define TERMINAL_CELL_WITH_MARK(character, mark) \
+    (TERMINAL_CELL_CHAR(character) | (uint32_t)(mark) << 21)
+
+/** Most bytes terminal_cell_to_utf8() writes */
+#define TERMINAL_CELL_MAX_UTF8          8
+
+/** Most UTF-16 units terminal_cell_to_utf16() writes */
+#define TERMINAL_CELL_MAX_UTF16         4
+
+/*=============================================================================
+ * Attribute Flags
+ *============================================================================*/
+
+#define TERMINAL_ATTR_BOLD              0x0001u
+#define TERMINAL_ATTR_FAINT             0x0002u
+#define TERMINAL_ATTR_ITALIC            0x0004u
+#define TERMINAL_ATTR_UNDERLINE         0x0008u
+#define TERMINAL_ATTR_BLINK             0x0010u
+#define TERMINAL_ATTR_INVERSE           0x0020u
+#define TERMINAL_ATTR_INVISIBLE         0x0040u
+#define TERMINAL_ATTR_STRIKETHROUGH     0x0080u
+
+/** Second cell of a wide character; its codepoint is 0 */
+#define TERMINAL_ATTR_WIDE_TAIL         0x8000u
+
+/*=============================================================================
+ * Cell Structures
+ *============================================================================*/
+
+/**
+ * @brief How a cell is drawn
+ */
+typedef struct TerminalAttributes {
+    uint32_t foreground;            /**< Foreground color */
+    uint32_t background;            /**< Background color */
+    uint16_t flags;                 /**< TERMINAL_ATTR_* flags */
+} TerminalAttributes;
+
+/**
+ * @brief One cell of a terminal row
+ */
+typedef struct TerminalCell {
+    uint32_t codepoint;             /**< Character and mark, or 0 for an empty cell */
+    TerminalAttributes attributes;  /**< Attributes */
+} TerminalCell;
+
+/*=============================================================================
+ * Character Functions
+ *============================================================================*/
+
+/**
+ * @brief Get the cells a character takes
+ *
+ * @param codepoint Unicode character
+ * @return 2 for East Asian wide and fullwidth characters and emoji, 0 for
+ *         combining marks and other zero-width characters, 1 otherwise
+ */
+int terminal_char_width(uint32_t codepoint);
+
+/**
+ * @brief Get the index a combining mark is stored under
+ *
+ * @param codepoint Unicode character
+ * @return Index (1 to 2047), or 0 if the character is not a mark a cell
+ *         can carry
+ */
+unsigned int terminal_mark_index(uint32_t codepoint);
+
+/**
+ * @brief Get the combining mark stored under an index
+ *
+ * @param index Mark index from terminal_mark_index()
+ * @return The mark, or 0 for an unknown index
+ */
+uint32_t terminal_mark_codepoint(unsigned int index);
+
+/**
+ * @brief Decode one character of UTF-8
+ *
+ * @param text UTF-8 text
+ * @param length Bytes available (at least 1)
+ * @param[out] consumed Receives the bytes used (at least 1)
+ * @return The character, or U+FFFD for a malformed sequence
+ */
+uint32_t terminal_utf8_decode(const char* text, size_t length, size_t* consumed);
+
+/**
+ * @brief Write a cell's character and mark as UTF-8
+ *
+ * Characters that are not valid Unicode come out as U+FFFD.
+ *
+ * @param codepoint Cell codepoint
+ * @param[out] out Receives up to TERMINAL_CELL_MAX_UTF8 bytes
+ * @return Bytes written
+ */
+size_t terminal_cell_to_utf8(uint32_t codepoint, char* out);
+
+/**
+ * @brief Write a cell's character and mark as UTF-16
+ *
+ * @param codepoint Cell codepoint
+ * @param[out] out Receives up to TERMINAL_CELL_MAX_UTF16 units
+ * @return Units written
+ */
+size_t terminal_cell_to_utf16(uint32_t codepoint, wchar_t* out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* QALAM_TERMINAL_CELL_H */
@@ -0,0 +1,1335 @@
+/**
+ * @file terminal_screen.c
+ * @brief Qalam IDE - Terminal Screen Grid Implementation
+ *
+ * Each screen's cells are one allocation, and its rows are an array of
+ * pointers into it, so scrolling a region rotates pointers rather than
+ * moving cells. A row's flags travel with its pointer.
+ *
+ * Erasing fills cells with the pen's background, as xterm does. Writing
+ * over either half of a wide character blanks the other half, so a tail
+ * cell always follows its character.
+ *
+ * Reflow walks the old rows a line at a time, placing cells into rows of
+ * the new width; a wide character that would straddle the edge moves to
+ * the next row. It runs twice: once to count the rows and find the
+ * cursor, then again to fill the new grid, sending the rows that do not
+ * fit above the cursor to the scrollback.
+ *
+ * @version 0.0.2
+ * @copyright (c) 2026 Qalam Project
+ *
+ * @note Thread Safety: See terminal_screen.h.
+ */
+
+#include "terminal_screen.h"
+#include "vt_parser.h"
+#include <stdlib.h>
+#include <string.h>
+
+/*=============================================================================
+ * Internal Structures
+ *============================================================================*/
+
+/** The main screen */
+#define GRID_MAIN           0
+
+/** The alternate screen */
+#define GRID_ALTERNATE      1
+
+/**
+ * @brief A row of a screen
+ */
+typedef struct ScreenRow {
+    TerminalCell* cells;            /**< The row's cells, within the grid's allocation */
+    unsigned int flags;             /**< SCROLLBACK_ROW_* flags */
+} ScreenRow;
+
+/**
+ * @brief The cells of one screen
+ */
+typedef struct ScreenGrid {
+    TerminalCell* cells;            /**< Every row's cells */
+    ScreenRow* rows;                /**< Rows, top to bottom */
+} ScreenGrid;
+
+/**
+ * @brief Cursor and what DECSC saves with it
+ */
+typedef struct CursorState {
+    size_t column;                  /**< Column */
+    size_t row;                     /**< Row */
+    bool pending_wrap;              /**< The last column was written; the next character wraps */
+    bool origin_mode;               /**< Rows count from the top margin (DECOM) */
+    TerminalAttributes pen;         /**< Attributes new characters get */
+} CursorState;
+
+/**
+ * @brief The dirty columns of a row (first == end when clean)
+ */
+typedef struct DirtySpan {
+    uint16_t first;
+    uint16_t end;
+} DirtySpan;
+
+/**
+ * @brief Terminal screen
+ */
+struct TerminalScreen {
+    VtParser* parser;               /**< Parser of the output */
+    Scrollback* scrollback;         /**< Rows scrolled off the main screen */
+    size_t columns;                 /**< Columns */
+    size_t rows;                    /**< Rows */
+    ScreenGrid grids[2];            /**< Main and alternate screens */
+    int shown;                      /**< GRID_MAIN or GRID_ALTERNATE */
+    DirtySpan* dirty;               /**< Dirty columns of each row */
+    bool dirty_any;                 /**< Some row is dirty */
+    CursorState cursor;             /**< The cursor */
+    CursorState saved[2];           /**< Cursor saved by DECSC on each screen */
+    size_t top;                     /**< First row of the scroll region */
+    size_t bottom;                  /**< Row after the scroll region */
+    bool autowrap;                  /**< Wrap at the last column (DECAWM) */
+    bool cursor_visible;            /**< Show the cursor (DECTCEM) */
+    QalamResult error;              /**< First failure since the last write */
+};
+
+/**
+ * @brief Where reflow is placing cells
+ */
+typedef struct ReflowState {
+    TerminalScreen* screen;         /**< Screen being resized */
+    ScreenGrid* grid;               /**< New grid, or NULL while counting */
+    TerminalCell* scratch;          /**< A row for rows the grid does not keep */
+    size_t columns;                 /**< New columns */
+    size_t rows;                    /**< New rows */
+    size_t skip;                    /**< Rows sent to the scrollback */
+    size_t row;                     /**< Rows finished so far */
+    size_t column;                  /**< Cells used of the row being built */
+    TerminalCell* cells;            /**< The row being built */
+    size_t cursor_row;              /**< Row the cursor lands on */
+    size_t cursor_column;           /**< Column the cursor lands on */
+    bool cursor_pending;            /**< The cursor lands past a full row */
+    QalamResult error;              /**< First failure while placing rows */
+} ReflowState;
+
+/** An empty cell with default attributes */
+static const TerminalCell g_blank = { 0, { TERMINAL_COLOR_DEFAULT, TERMINAL_COLOR_DEFAULT, 0 } };
+
+/*=============================================================================
+ * Internal Helper Functions
+ *============================================================================*/
+
+static void fill_cells(TerminalCell* cells, size_t count, TerminalCell value) {
+    for (size_t i = 0; i < count; i++) {
+        cells[i] = value;
+    }
+}
+
+static bool cell_is_blank(const TerminalCell* cell) {
+    return cell->codepoint == 0 && cell->attributes.background == TERMINAL_COLOR_DEFAULT &&
+           cell->attributes.flags == 0;
+}
+
+static bool cell_is_tail(const TerminalCell* cell) {
+    return (cell->attributes.flags & TERMINAL_ATTR_WIDE_TAIL) != 0;
+}
+
+/**
+ * @brief A cell erased with the pen's background
+ */
+static TerminalCell erased_cell(const TerminalScreen* s) {
+    TerminalCell cell = g_blank;
+    cell.attributes.background = s->cursor.pen.background;
+    return cell;
+}
+
+static size_t row_length(const TerminalCell* cells, size_t columns) {
+    while (columns > 0 && cell_is_blank(&cells[columns - 1])) {
+        columns--;
+    }
+    return columns;
+}
+
+static QalamResult grid_create(ScreenGrid* grid, size_t columns, size_t rows) {
+    grid->cells = (TerminalCell*)qalam_mem_alloc(QALAM_MEMORY_TERMINAL,
+                                                 columns * rows * sizeof(TerminalCell));
+    grid->rows = (ScreenRow*)qalam_mem_alloc(QALAM_MEMORY_TERMINAL, rows * sizeof(ScreenRow));
+    if (!grid->cells || !grid->rows) {
+        qalam_mem_free(grid->cells);
+        qalam_mem_free(grid->rows);
+        grid->cells = NULL;
+        grid->rows = NULL;
+        return QALAM_ERROR_OUT_OF_MEMORY;
+    }
+
+    fill_cells(grid->cells, columns * rows, g_blank);
+    for (size_t r = 0; r < rows; r++) {
+        grid->rows[r].cells = grid->cells + r * columns;
+        grid->rows[r].flags = 0;
+    }
+    return QALAM_OK;
+}
+
+static void grid_destroy(ScreenGrid* grid) {
+    qalam_mem_free(grid->cells);
+    qalam_mem_free(grid->rows);
+    grid->cells = NULL;
+    grid->rows = NULL;
+}
+
+static ScreenRow* current_row(TerminalScreen* s, size_t row) {
+    return &s->grids[s->shown].rows[row];
+}
+
+static void reverse_rows(ScreenRow* rows, size_t count) {
+    for (size_t i = 0; i < count / 2; i++) {
+        ScreenRow row = rows[i];
+        rows[i] = rows[count - 1 - i];
+        rows[count - 1 - i] = row;
+    }
+}
+
+/**
+ * @brief Rotate rows so that rows[by] comes first
+ */
+static void rotate_rows(ScreenRow* rows, size_t count, size_t by) {
+    reverse_rows(rows, by);
+    reverse_rows(rows + by, count - by);
+    reverse_rows(rows, count);
+}
+
+/*=============================================================================
+ * Dirty Tracking
+ *============================================================================*/
+
+static void mark_dirty(TerminalScreen* s, size_t row, size_t first, size_t end) {
+    if (first >= end) {
+        return;
+    }
+
+    DirtySpan* span = &s->dirty[row];
+    if (span->first == span->end) {
+        span->first = (uint16_t)first;
+        span->end = (uint16_t)end;
+    } else {
+        if (first < span->first) {
+            span->first = (uint16_t)first;
+        }
+        if (end > span->end) {
+            span->end = (uint16_t)end;
+        }
+    }
+    s->dirty_any = true;
+}
+
+static void mark_rows_dirty(TerminalScreen* s, size_t first_row, size_t end_row) {
+    for (size_t r = first_row; r < end_row; r++) {
+        mark_dirty(s, r, 0, s->columns);
+    }
+}
+
+/*=============================================================================
+ * Editing
+ *============================================================================*/
+
+/**
+ * @brief Erase cells of a row, with whole wide characters at the edges
+ */
+static void erase_cells(TerminalScreen* s, size_t row, size_t first, size_t end) {
+    TerminalCell* cells = current_row(s, row)->cells;
+    if (end > s->columns) {
+        end = s->columns;
+    }
+    if (first >= end) {
+        return;
+    }
+
+    if (first > 0 && cell_is_tail(&cells[first])) {
+        first--;
+    }
+    if (end < s->columns && cell_is_tail(&cells[end])) {
+        end++;
+    }
+    fill_cells(cells + first, end - first, erased_cell(s));
+    mark_dirty(s, row, first, end);
+}
+
+static void clear_row(TerminalScreen* s, size_t row) {
+    ScreenRow* screen_row = current_row(s, row);
+    fill_cells(screen_row->cells, s->columns, erased_cell(s));
+    screen_row->flags = 0;
+    mark_dirty(s, row, 0, s->columns);
+}
+
+static void keep_row(TerminalScreen* s, const ScreenRow* row) {
+    QalamResult result = scrollback_push_row(s->scrollback, row->cells, s->columns,
+                                             row->flags & SCROLLBACK_ROW_WRAPPED);
+    if (result != QALAM_OK && s->error == QALAM_OK) {
+        s->error = result;
+    }
+}
+
+/**
+ * @brief Scroll rows [top, bottom) up, blanking rows at the bottom
+ *
+ * @param keep Send the rows scrolled off to the scrollback
+ */
+static void scroll_up(TerminalScreen* s, size_t top, size_t bottom, size_t count, bool keep) {
+    if (top >= bottom || count == 0) {
+        return;
+    }
+    if (count > bottom - top) {
+        count = bottom - top;
+    }
+
+    ScreenRow* rows = s->grids[s->shown].rows;
+    if (keep) {
+        for (size_t i = 0; i < count; i++) {
+            keep_row(s, &rows[top + i]);
+        }
+    }
+
+    rotate_rows(rows + top, bottom - top, count);
+    for (size_t r = bottom - count; r < bottom; r++) {
+        clear_row(s, r);
+    }
+    mark_rows_dirty(s, top, bottom);
+}
+
+/**
+ * @brief Scroll rows [top, bottom) down, blanking rows at the top
+ */
+static void scroll_down(TerminalScreen* s, size_t top, size_t bottom, size_t count) {
+    if (top >= bottom || count == 0) {
+        return;
+    }
+    if (count > bottom - top) {
+        count = bottom - top;
+    }
+
+    rotate_rows(s->grids[s->shown].rows + top, bottom - top, bottom - top - count);
+    for (size_t r = top; r < top + count; r++) {
+        clear_row(s, r);
+    }
+    mark_rows_dirty(s, top, bottom);
+}
+
+static void line_feed(TerminalScreen* s) {
+    s->cursor.pending_wrap = false;
+    if (s->cursor.row + 1 == s->bottom) {
+        scroll_up(s, s->top, s->bottom, 1, s->shown == GRID_MAIN && s->top == 0);
+    } else if (s->cursor.row + 1 < s->rows) {
+        s->cursor.row++;
+    }
+}
+
+static void reverse_index(TerminalScreen* s) {
+    s->cursor.pending_wrap = false;
+    if (s->cursor.row == s->top) {
+        scroll_down(s, s->top, s->bottom, 1);
+    } else if (s->cursor.row > 0) {
+        s->cursor.row--;
+    }
+}
+
+static void wrap_line(TerminalScreen* s) {
+    current_row(s, s->cursor.row)->flags |= SCROLLBACK_ROW_WRAPPED;
+    line_feed(s);
+    s->cursor.column = 0;
+}
+
+static void attach_mark(TerminalScreen* s, uint32_t codepoint) {
+    unsigned int mark = terminal_mark_index(codepoint);
+    if (mark == 0) {
+        return;
+    }
+
+    size_t column;
+    if (s->cursor.pending_wrap) {
+        column = s->columns - 1;
+    } else if (s->cursor.column > 0) {
+        column = s->cursor.column - 1;
+    } else {
+        return;
+    }
+
+    TerminalCell* cells = current_row(s, s->cursor.row)->cells;
+    if (column > 0 && cell_is_tail(&cells[column])) {
+        column--;
+    }
+
+    uint32_t current = cells[column].codepoint;
+    if (TERMINAL_CELL_CHAR(current) == 0 || TERMINAL_CELL_MARK(current) != 0) {
+        return;
+    }
+    cells[column].codepoint = TERMINAL_CELL_WITH_MARK(current, mark);
+    mark_dirty(s, s->cursor.row, column, column + 1);
+}
+
+static void put_char(TerminalScreen* s, uint32_t codepoint) {
+    int char_width = terminal_char_width(codepoint);
+    if (char_width == 0) {
+        attach_mark(s, codepoint);
+        return;
+    }
+
+    size_t width = (size_t)char_width;
+    if (width > s->columns) {
+        width = 1;
+    }
+
+    CursorState* cursor = &s->cursor;
+    if (cursor->pending_wrap) {
+        wrap_line(s);
+    }
+    if (cursor->column + width > s->columns) {
+        if (s->autowrap) {
+            erase_cells(s, cursor->row, cursor->column, s->columns);
+            wrap_line(s);
+        } else {
+            cursor->column = s->columns - width;
+        }
+    }
+
+    TerminalCell* cells = current_row(s, cursor->row)->cells;
+    size_t first = cursor->column;
+    size_t end = first + width;
+    size_t dirty_first = first;
+    size_t dirty_end = end;
+
+    /* Blank the halves of wide characters this one covers part of */
+    if (first > 0 && cell_is_tail(&cells[first])) {
+        cells[first - 1] = erased_cell(s);
+        dirty_first--;
+    }
+    if (end < s->columns && cell_is_tail(&cells[end])) {
+        cells[end] = erased_cell(s);
+        dirty_end++;
+    }
+
+    cells[first].codepoint = codepoint;
+    cells[first].attributes = cursor->pen;
+    if (width == 2) {
+        cells[first + 1].codepoint = 0;
+        cells[first + 1].attributes = cursor->pen;
+        cells[first + 1].attributes.flags |= TERMINAL_ATTR_WIDE_TAIL;
+    }
+    mark_dirty(s, cursor->row, dirty_first, dirty_end);
+
+    if (end >= s->columns) {
+        cursor->column = s->columns - 1;
+        cursor->pending_wrap = s->autowrap;
+    } else {
+        cursor->column = end;
+    }
+}
+
+static void insert_chars(TerminalScreen* s, size_t count) {
+    size_t column = s->cursor.column;
+    if (count > s->columns - column) {
+        count = s->columns - column;
+    }
+
+    TerminalCell* cells = current_row(s, s->cursor.row)->cells;
+    if (cell_is_tail(&cells[column])) {
+        erase_cells(s, s->cursor.row, column, column + 1);
+    }
+    memmove(cells + column + count, cells + column,
+            (s->columns - column - count) * sizeof(TerminalCell));
+    fill_cells(cells + column, count, erased_cell(s));
+
+    /* A wide character pushed to the last column has lost its tail */
+    TerminalCell* last = &cells[s->columns - 1];
+    if (!cell_is_tail(last) && terminal_char_width(TERMINAL_CELL_CHAR(last->codepoint)) == 2) {
+        *last = erased_cell(s);
+    }
+    mark_dirty(s, s->cursor.row, column, s->columns);
+    s->cursor.pending_wrap = false;
+}
+
+static void delete_chars(TerminalScreen* s, size_t count) {
+    size_t column = s->cursor.column;
+    if (count > s->columns - column) {
+        count = s->columns - column;
+    }
+
+    TerminalCell* cells = current_row(s, s->cursor.row)->cells;
+    if (cell_is_tail(&cells[column])) {
+        erase_cells(s, s->cursor.row, column, column + 1);
+    }
+    if (column + count < s->columns && cell_is_tail(&cells[column + count])) {
+        cells[column + count] = erased_cell(s);
+    }
+    memmove(cells + column, cells + column + count,
+            (s->columns - column - count) * sizeof(TerminalCell));
+    fill_cells(cells + s->columns - count, count, erased_cell(s));
+    mark_dirty(s, s->cursor.row, column, s->columns);
+    s->cursor.pending_wrap = false;
+}
+
+static void erase_display(TerminalScreen* s, uint16_t mode) {
+    switch (mode) {
+    case 0:
+        erase_cells(s, s->cursor.row, s->cursor.column, s->columns);
+        current_row(s, s->cursor.row)->flags = 0;
+        for (size_t r = s->cursor.row + 1; r < s->rows; r++) {
+            clear_row(s, r);
+        }
+        break;
+    case 1:
+        for (size_t r = 0; r < s->cursor.row; r++) {
+            clear_row(s, r);
+        }
+        erase_cells(s, s->cursor.row, 0, s->cursor.column + 1);
+        break;
+    case 2:
+        for (size_t r = 0; r < s->rows; r++) {
+            clear_row(s, r);
+        }
+        break;
+    case 3:
+        scrollback_clear(s->scrollback);
+        break;
+    default:
+        break;
+    }
+}
+
+static void erase_line(TerminalScreen* s, uint16_t mode) {
+    switch (mode) {
+    case 0:
+        erase_cells(s, s->cursor.row, s->cursor.column, s->columns);
+        current_row(s, s->cursor.row)->flags = 0;
+        break;
+    case 1:
+        erase_cells(s, s->cursor.row, 0, s->cursor.column + 1);
+        break;
+    case 2:
+        clear_row(s, s->cursor.row);
+        break;
+    default:
+        break;
+    }
+}
+
+/*=============================================================================
+ * Cursor Movement
+ *============================================================================*/
+
+static void move_cursor(TerminalScreen* s, size_t column, size_t row) {
+    s->cursor.column = column < s->columns ? column : s->columns - 1;
+    s->cursor.row = row < s->rows ? row : s->rows - 1;
+    s->cursor.pending_wrap = false;
+}
+
+/**
+ * @brief Move to a position given by CUP or VPA, within the margins in
+ *        origin mode
+ */
+static void set_position(TerminalScreen* s, size_t column, size_t row) {
+    if (s->cursor.origin_mode) {
+        row += s->top;
+        if (row >= s->bottom) {
+            row = s->bottom - 1;
+        }
+    }
+    move_cursor(s, column, row);
+}
+
+static void cursor_up(TerminalScreen* s, size_t count) {
+    size_t limit = s->cursor.row >= s->top ? s->top : 0;
+    size_t row = s->cursor.row - limit > count ? s->cursor.row - count : limit;
+    move_cursor(s, s->cursor.column, row);
+}
+
+static void cursor_down(TerminalScreen* s, size_t count) {
+    size_t limit = s->cursor.row < s->bottom ? s->bottom - 1 : s->rows - 1;
+    size_t row = limit - s->cursor.row > count ? s->cursor.row + count : limit;
+    move_cursor(s, s->cursor.column, row);
+}
+
+static void save_cursor(TerminalScreen* s) {
+    s->saved[s->shown] = s->cursor;
+}
+
+static void restore_cursor(TerminalScreen* s) {
+    s->cursor = s->saved[s->shown];
+    if (s->cursor.column >= s->columns) {
+        s->cursor.column = s->columns - 1;
+        s->cursor.pending_wrap = false;
+    }
+    if (s->cursor.row >= s->rows) {
+        s->cursor.row = s->rows - 1;
+    }
+}
+
+/*=============================================================================
+ * Modes and Attributes
+ *============================================================================*/
+
+static void show_grid(TerminalScreen* s, int grid) {
+    if (s->shown != grid) {
+        s->shown = grid;
+        mark_rows_dirty(s, 0, s->rows);
+    }
+}
+
+static void clear_grid(TerminalScreen* s) {
+    for (size_t r = 0; r < s->rows; r++) {
+        clear_row(s, r);
+    }
+}
+
+static void set_private_modes(TerminalScreen* s, const VtSequence* sequence, bool set) {
+    size_t count = sequence->param_count < VT_MAX_PARAMS ? sequence->param_count : VT_MAX_PARAMS;
+    for (size_t i = 0; i < count; i++) {
+        switch (sequence->params[i]) {
+        case 6:
+            s->cursor.origin_mode = set;
+            set_position(s, 0, 0);
+            break;
+        case 7:
+            s->autowrap = set;
+            if (!set) {
+                s->cursor.pending_wrap = false;
+            }
+            break;
+        case 25:
+            s->cursor_visible = set;
+            break;
+        case 47:
+            show_grid(s, set ? GRID_ALTERNATE : GRID_MAIN);
+            break;
+        case 1047:
+            if (set) {
+                show_grid(s, GRID_ALTERNATE);
+                clear_grid(s);
+            } else if (s->shown == GRID_ALTERNATE) {
+                clear_grid(s);
+                show_grid(s, GRID_MAIN);
+            }
+            break;
+        case 1049:
+            if (set && s->shown == GRID_MAIN) {
+                save_cursor(s);
+                show_grid(s, GRID_ALTERNATE);
+                clear_grid(s);
+            } else if (!set && s->shown == GRID_ALTERNATE) {
+                show_grid(s, GRID_MAIN);
+                restore_cursor(s);
+            }
+            break;
+        default:
+            break;
+        }
+    }
+}
+
+static bool is_subparam(const VtSequence* sequence, size_t index) {
+    return ((sequence->subparams >> index) & 1u) != 0;
+}
+
+static uint32_t color_byte(uint16_t value) {
+    return value > 255 ? 255 : value;
+}
+
+/**
+ * @brief Parse the color after SGR 38 or 48, in ';' or ':' form
+ *
+ * @param[in,out] index Index of the 38 or 48; receives the index of the
+ *        last parameter of the color
+ * @return true if a color was given
+ */
+static bool parse_color(const VtSequence* sequence, size_t count, size_t* index, uint32_t* color) {
+    size_t i = *index;
+    if (i + 1 >= count) {
+        return false;
+    }
+
+    const uint16_t* p = &sequence->params[i + 1];
+    if (is_subparam(sequence, i + 1)) {
+        size_t subparams = 0;
+        while (i + 1 + subparams < count && is_subparam(sequence, i + 1 + subparams)) {
+            subparams++;
+        }
+        *index = i + subparams;
+
+        if (p[0] == 5 && subparams >= 2) {
+            *color = TERMINAL_COLOR_INDEXED(color_byte(p[1]));
+            return true;
+        }
+        if (p[0] == 2 && subparams >= 5) {
+            /* 38:2:<color space>:r:g:b */
+            *color = TERMINAL_COLOR_RGB(color_byte(p[2]), color_byte(p[3]), color_byte(p[4]));
+            return true;
+        }
+        if (p[0] == 2 && subparams == 4) {
+            *color = TERMINAL_COLOR_RGB(color_byte(p[1]), color_byte(p[2]), color_byte(p[3]));
+            return true;
+        }
+        return false;
+    }
+
+    if (p[0] == 5 && i + 2 < count) {
+        *color = TERMINAL_COLOR_INDEXED(color_byte(p[1]));
+        *index = i + 2;
+        return true;
+    }
+    if (p[0] == 2 && i + 4 < count) {
+        *color = TERMINAL_COLOR_RGB(color_byte(p[1]), color_byte(p[2]), color_byte(p[3]));
+        *index = i + 4;
+        return true;
+    }
+    *index = count - 1;
+    return false;
+}
+
+static void set_graphics(TerminalScreen* s, const VtSequence* sequence) {
+    TerminalAttributes* pen = &s->cursor.pen;
+    size_t count = sequence->param_count < VT_MAX_PARAMS ? sequence->param_count : VT_MAX_PARAMS;
+    if (count == 0) {
+        *pen = g_blank.attributes;
+        return;
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        uint16_t p = sequence->params[i];
+        uint32_t color;
+
+        switch (p) {
+        case 0:  *pen = g_blank.attributes; break;
+        case 1:  pen->flags |= TERMINAL_ATTR_BOLD; break;
+        case 2:  pen->flags |= TERMINAL_ATTR_FAINT; break;
+        case 3:  pen->flags |= TERMINAL_ATTR_ITALIC; break;
+        case 4:
+            /* 4:0 turns underline off; other styles draw as one */
+            if (i + 1 < count && is_subparam(sequence, i + 1) && sequence->params[i + 1] == 0) {
+                pen->flags &= ~TERMINAL_ATTR_UNDERLINE;
+            } else {
+                pen->flags |= TERMINAL_ATTR_UNDERLINE;
+            }
+            break;
+        case 5:
+        case 6:  pen->flags |= TERMINAL_ATTR_BLINK; break;
+        case 7:  pen->flags |= TERMINAL_ATTR_INVERSE; break;
+        case 8:  pen->flags |= TERMINAL_ATTR_INVISIBLE; break;
+        case 9:  pen->flags |= TERMINAL_ATTR_STRIKETHROUGH; break;
+        case 21: pen->flags |= TERMINAL_ATTR_UNDERLINE; break;
+        case 22: pen->flags &= ~(TERMINAL_ATTR_BOLD | TERMINAL_ATTR_FAINT); break;
+        case 23: pen->flags &= ~TERMINAL_ATTR_ITALIC; break;
+        case 24: pen->flags &= ~TERMINAL_ATTR_UNDERLINE; break;
+        case 25: pen->flags &= ~TERMINAL_ATTR_BLINK; break;
+        case 27: pen->flags &= ~TERMINAL_ATTR_INVERSE; break;
+        case 28: pen->flags &= ~TERMINAL_ATTR_INVISIBLE; break;
+        case 29: pen->flags &= ~TERMINAL_ATTR_STRIKETHROUGH; break;
+        case 38:
+            if (parse_color(sequence, count, &i, &color)) {
+                pen->foreground = color;
+            }
+            break;
+        case 39: pen->foreground = TERMINAL_COLOR_DEFAULT; break;
+        case 48:
+            if (parse_color(sequence, count, &i, &color)) {
+                pen->background = color;
+            }
+            break;
+        case 49: pen->background = TERMINAL_COLOR_DEFAULT; break;
+        default:
+            if (p >= 30 && p <= 37) {
+                pen->foreground = TERMINAL_COLOR_INDEXED(p - 30);
+            } else if (p >= 40 && p <= 47) {
+                pen->background = TERMINAL_COLOR_INDEXED(p - 40);
+            } else if (p >= 90 && p <= 97) {
+                pen->foreground = TERMINAL_COLOR_INDEXED(p - 90 + 8);
+            } else if (p >= 100 && p <= 107) {
+                pen->background = TERMINAL_COLOR_INDEXED(p - 100 + 8);
+            }
+            break;
+        }
+
+        /* Skip sub-parameters of anything not understood */
+        while (i + 1 < count && is_subparam(sequence, i + 1)) {
+            i++;
+        }
+    }
+}
+
+static void set_margins(TerminalScreen* s, const VtSequence* sequence) {
+    size_t top = (size_t)vt_sequence_param(sequence, 0, 1) - 1;
+    size_t bottom = vt_sequence_param(sequence, 1, (uint16_t)s->rows);
+    if (bottom > s->rows) {
+        bottom = s->rows;
+    }
+    if (top + 1 < bottom) {
+        s->top = top;
+        s->bottom = bottom;
+        set_position(s, 0, 0);
+    }
+}
+
+static void reset_state(TerminalScreen* s) {
+    for (int g = GRID_MAIN; g <= GRID_ALTERNATE; g++) {
+        fill_cells(s->grids[g].cells, s->columns * s->rows, g_blank);
+        for (size_t r = 0; r < s->rows; r++) {
+            s->grids[g].rows[r].flags = 0;
+        }
+    }
+
+    s->shown = GRID_MAIN;
+    memset(&s->cursor, 0, sizeof(s->cursor));
+    s->cursor.pen = g_blank.attributes;
+    s->saved[GRID_MAIN] = s->cursor;
+    s->saved[GRID_ALTERNATE] = s->cursor;
+    s->top = 0;
+    s->bottom = s->rows;
+    s->autowrap = true;
+    s->cursor_visible = true;
+    mark_rows_dirty(s, 0, s->rows);
+}
+
+/*=============================================================================
+ * Parser Handler
+ *============================================================================*/
+
+static void on_print(void* user_data, const char* text, size_t length) {
+    TerminalScreen* s = (TerminalScreen*)user_data;
+    size_t i = 0;
+    while (i < length) {
+        size_t consumed;
+        uint32_t codepoint = terminal_utf8_decode(text + i, length - i, &consumed);
+        put_char(s, codepoint);
+        i += consumed;
+    }
+}
+
+static void on_execute(void* user_data, unsigned char control) {
+    TerminalScreen* s = (TerminalScreen*)user_data;
+    switch (control) {
+    case 0x08:  /* BS */
+        if (s->cursor.pending_wrap) {
+            s->cursor.pending_wrap = false;
+        } else if (s->cursor.column > 0) {
+            s->cursor.column--;
+        }
+        break;
+    case 0x09: {  /* HT */
+        size_t next = (s->cursor.column / TERMINAL_SCREEN_TAB_WIDTH + 1) * TERMINAL_SCREEN_TAB_WIDTH;
+        move_cursor(s, next, s->cursor.row);
+        break;
+    }
+    case 0x0A:  /* LF */
+    case 0x0B:  /* VT */
+    case 0x0C:  /* FF */
+        line_feed(s);
+        break;
+    case 0x0D:  /* CR */
+        s->cursor.column = 0;
+        s->cursor.pending_wrap = false;
+        break;
+    default:
+        break;
+    }
+}
+
+static void on_esc(void* user_data, const VtSequence* sequence) {
+    TerminalScreen* s = (TerminalScreen*)user_data;
+    if (sequence->intermediate_count != 0) {
+        return;
+    }
+
+    switch (sequence->final) {
+    case '7': save_cursor(s); break;
+    case '8': restore_cursor(s); break;
+    case 'D': line_feed(s); break;
+    case 'E':
+        s->cursor.column = 0;
+        line_feed(s);
+        break;
+    case 'M': reverse_index(s); break;
+    case 'c': reset_state(s); break;
+    default: break;
+    }
+}
+
+static void on_csi(void* user_data, const VtSequence* sequence) {
+    TerminalScreen* s = (TerminalScreen*)user_data;
+    if (sequence->intermediate_count == 1 && sequence->intermediates[0] == '?') {
+        if (sequence->final == 'h' || sequence->final == 'l') {
+            set_private_modes(s, sequence, sequence->final == 'h');
+        }
+        return;
+    }
+    if (sequence->intermediate_count != 0) {
+        return;
+    }
+
+    size_t count = vt_sequence_param(sequence, 0, 1);
+    uint16_t mode = sequence->param_count > 0 ? sequence->params[0] : 0;
+
+    switch (sequence->final) {
+    case 'A': cursor_up(s, count); break;
+    case 'B':
+    case 'e': cursor_down(s, count); break;
+    case 'C':
+    case 'a': move_cursor(s, s->cursor.column + count, s->cursor.row); break;
+    case 'D':
+        move_cursor(s, s->cursor.column > count ? s->cursor.column - count : 0, s->cursor.row);
+        break;
+    case 'E':
+        cursor_down(s, count);
+        s->cursor.column = 0;
+        break;
+    case 'F':
+        cursor_up(s, count);
+        s->cursor.column = 0;
+        break;
+    case 'G':
+    case '`': move_cursor(s, count - 1, s->cursor.row); break;
+    case 'H':
+    case 'f':
+        set_position(s, (size_t)vt_sequence_param(sequence, 1, 1) - 1, count - 1);
+        break;
+    case 'd': set_position(s, s->cursor.column, count - 1); break;
+    case 'J': erase_display(s, mode); break;
+    case 'K': erase_line(s, mode); break;
+    case 'L':
+        if (s->cursor.row >= s->top && s->cursor.row < s->bottom) {
+            scroll_down(s, s->cursor.row, s->bottom, count);
+            move_cursor(s, 0, s->cursor.row);
+        }
+        break;
+    case 'M':
+        if (s->cursor.row >= s->top && s->cursor.row < s->bottom) {
+            scroll_up(s, s->cursor.row, s->bottom, count, false);
+            move_cursor(s, 0, s->cursor.row);
+        }
+        break;
+    case '@': insert_chars(s, count); break;
+    case 'P': delete_chars(s, count); break;
+    case 'X':
+        erase_cells(s, s->cursor.row, s->cursor.column, s->cursor.column + count);
+        s->cursor.pending_wrap = false;
+        break;
+    case 'S': scroll_up(s, s->top, s->bottom, count, s->shown == GRID_MAIN && s->top == 0); break;
+    case 'T': scroll_down(s, s->top, s->bottom, count); break;
+    case 'm': set_graphics(s, sequence); break;
+    case 'r': set_margins(s, sequence); break;
+    case 's': save_cursor(s); break;
+    case 'u': restore_cursor(s); break;
+    default: break;
+    }
+}
+
+/*=============================================================================
+ * Reflow
+ *============================================================================*/
+
+static void reflow_begin_row(ReflowState* st) {
+    size_t kept = st->row - st->skip;
+    if (st->grid && st->row >= st->skip && kept < st->rows) {
+        st->cells = st->grid->rows[kept].cells;
+    } else {
+        st->cells = st->scratch;
+    }
+    fill_cells(st->cells, st->columns, g_blank);
+    st->column = 0;
+}
+
+static void reflow_end_row(ReflowState* st, unsigned int flags) {
+    if (st->grid) {
+        if (st->row < st->skip) {
+            QalamResult result = scrollback_push_row(st->screen->scrollback, st->scratch,
+                                                     st->columns, flags);
+            if (result != QALAM_OK && st->error == QALAM_OK) {
+                st->error = result;
+            }
+        } else if (st->row - st->skip < st->rows) {
+            st->grid->rows[st->row - st->skip].flags = flags;
+        }
+    }
+    st->row++;
+}
+
+/**
+ * @brief Place the lines of the first 'used' rows of a grid at the new width
+ */
+static void reflow_lines(ReflowState* st, const ScreenGrid* old, size_t old_columns, size_t used,
+                         const CursorState* cursor) {
+    size_t start = 0;
+    while (start < used) {
+        size_t end = start;
+        while (end + 1 < used && (old->rows[end].flags & SCROLLBACK_ROW_WRAPPED)) {
+            end++;
+        }
+
+        bool has_cursor = cursor->row >= start && cursor->row <= end;
+        size_t offset = has_cursor ? (cursor->row - start) * old_columns + cursor->column +
+                                     (cursor->pending_wrap ? 1 : 0) : 0;
+        size_t line_length = 0;
+
+        reflow_begin_row(st);
+        for (size_t r = start; r <= end; r++) {
+            const TerminalCell* cells = old->rows[r].cells;
+            size_t length = r < end ? old_columns : row_length(cells, old_columns);
+
+            /* The blank left where a wide character did not fit is not part of the line */
+            if (r < end && old_columns > 1 && cell_is_blank(&cells[old_columns - 1]) &&
+                cell_is_tail(&old->rows[r + 1].cells[1])) {
+                length--;
+            }
+            size_t base = (r - start) * old_columns;
+            line_length = base + length;
+
+            for (size_t col = 0; col < length; col++) {
+                if (cell_is_tail(&cells[col])) {
+                    continue;
+                }
+
+                size_t width = col + 1 < old_columns && cell_is_tail(&cells[col + 1]) ? 2 : 1;
+                if (width > st->columns) {
+                    width = 1;
+                }
+                if (st->column + width > st->columns) {
+                    reflow_end_row(st, SCROLLBACK_ROW_WRAPPED);
+                    reflow_begin_row(st);
+                }
+
+                st->cells[st->column] = cells[col];
+                if (width == 2) {
+                    st->cells[st->column + 1] = cells[col + 1];
+                }
+                if (has_cursor && offset >= base + col && offset < base + col + width) {
+                    st->cursor_row = st->row;
+                    st->cursor_column = st->column + (offset - base - col);
+                    st->cursor_pending = false;
+                }
+                st->column += width;
+            }
+        }
+
+        if (has_cursor && offset >= line_length) {
+            if (offset == line_length && st->column == st->columns && line_length > 0) {
+                st->cursor_row = st->row;
+                st->cursor_column = st->columns - 1;
+                st->cursor_pending = true;
+            } else {
+                size_t position = st->column + (offset - line_length);
+                while (position >= st->columns) {
+                    reflow_end_row(st, 0);
+                    reflow_begin_row(st);
+                    position -= st->columns;
+                }
+                st->cursor_row = st->row;
+                st->cursor_column = position;
+                st->cursor_pending = false;
+            }
+        }
+
+        reflow_end_row(st, 0);
+        start = end + 1;
+    }
+}
+
+/**
+ * @brief Reflow the main screen into a new grid
+ *
+ * @param[in,out] cursor The main screen's cursor, moved with its character
+ */
+static QalamResult reflow_main(TerminalScreen* s, ScreenGrid* grid, TerminalCell* scratch,
+                               size_t columns, size_t rows, CursorState* cursor) {
+    const ScreenGrid* old = &s->grids[GRID_MAIN];
+
+    size_t used = cursor->row + 1;
+    for (size_t r = s->rows; r > used; r--) {
+        if (old->rows[r - 1].flags != 0 || row_length(old->rows[r - 1].cells, s->columns) > 0) {
+            used = r;
+            break;
+        }
+    }
+
+    ReflowState st;
+    memset(&st, 0, sizeof(st));
+    st.screen = s;
+    st.scratch = scratch;
+    st.columns = columns;
+    st.rows = rows;
+    reflow_lines(&st, old, s->columns, used, cursor);
+
+    /* Keep the bottom rows, but never scroll the cursor off the top */
+    size_t skip = st.row > rows ? st.row - rows : 0;
+    if (skip > st.cursor_row) {
+        skip = st.cursor_row;
+    }
+
+    st.grid = grid;
+    st.skip = skip;
+    st.row = 0;
+    reflow_lines(&st, old, s->columns, used, cursor);
+
+    cursor->row = st.cursor_row - skip;
+    cursor->column = st.cursor_column;
+    cursor->pending_wrap = st.cursor_pending && s->autowrap;
+    return st.error;
+}
+
+/**
+ * @brief Copy a grid into a new grid, cutting or padding each row
+ */
+static void copy_grid(const ScreenGrid* old, size_t old_columns, size_t old_rows,
+                      ScreenGrid* grid, size_t columns, size_t rows) {
+    size_t copy_columns = old_columns < columns ? old_columns : columns;
+    size_t copy_rows = old_rows < rows ? old_rows : rows;
+    for (size_t r = 0; r < copy_rows; r++) {
+        TerminalCell* cells = grid->rows[r].cells;
+        memcpy(cells, old->rows[r].cells, copy_columns * sizeof(TerminalCell));
+        if (copy_columns < old_columns && cell_is_tail(&old->rows[r].cells[copy_columns])) {
+            cells[copy_columns - 1] = g_blank;
+        }
+        grid->rows[r].flags = old->rows[r].flags;
+    }
+}
+
+static void clamp_cursor(CursorState* cursor, size_t columns, size_t rows) {
+    if (cursor->column >= columns) {
+        cursor->column = columns - 1;
+        cursor->pending_wrap = false;
+    }
+    if (cursor->row >= rows) {
+        cursor->row = rows - 1;
+    }
+}
+
+/*=============================================================================
+ * Lifecycle
+ *============================================================================*/
+
+QalamResult terminal_screen_create(TerminalScreen** screen, size_t columns, size_t rows,
+                                   size_t scrollback_budget) {
+    QALAM_CHECK_NULL(screen);
+    *screen = NULL;
+    if (columns == 0 || rows == 0 ||
+        columns > TERMINAL_SCREEN_MAX_SIZE || rows > TERMINAL_SCREEN_MAX_SIZE) {
+        return QALAM_ERROR_INVALID_ARGUMENT;
+    }
+
+    TerminalScreen* s = (TerminalScreen*)qalam_mem_calloc(QALAM_MEMORY_TERMINAL, 1,
+                                                          sizeof(TerminalScreen));
+    if (!s) {
+        return QALAM_ERROR_OUT_OF_MEMORY;
+    }
+    s->columns = columns;
+    s->rows = rows;
+
+    VtParserHandler handler;
+    memset(&handler, 0, sizeof(handler));
+    handler.print = on_print;
+    handler.execute = on_execute;
+    handler.esc_dispatch = on_esc;
+    handler.csi_dispatch = on_csi;
+
+    QalamResult result = vt_parser_create(&s->parser, &handler, s);
+    if (result == QALAM_OK) {
+        result = scrollback_create(&s->scrollback, scrollback_budget);
+    }
+    if (result == QALAM_OK) {
+        result = grid_create(&s->grids[GRID_MAIN], columns, rows);
+    }
+    if (result == QALAM_OK) {
+        result = grid_create(&s->grids[GRID_ALTERNATE], columns, rows);
+    }
+    if (result == QALAM_OK) {
+        s->dirty = (DirtySpan*)qalam_mem_calloc(QALAM_MEMORY_TERMINAL, rows, sizeof(DirtySpan));
+        if (!s->dirty) {
+            result = QALAM_ERROR_OUT_OF_MEMORY;
+        }
+    }
+    if (result != QALAM_OK) {
+        terminal_screen_destroy(s);
+        return result;
+    }
+
+    reset_state(s);
+    *screen = s;
+    return QALAM_OK;
+}
+
+void terminal_screen_destroy(TerminalScreen* screen) {
+    if (!screen) {
+        return;
+    }
+
+    vt_parser_destroy(screen->parser);
+    scrollback_destroy(screen->scrollback);
+    grid_destroy(&screen->grids[GRID_MAIN]);
+    grid_destroy(&screen->grids[GRID_ALTERNATE]);
+    qalam_mem_free(screen->dirty);
+    qalam_mem_free(screen);
+}
+
+void terminal_screen_reset(TerminalScreen* screen) {
+    if (!screen) {
+        return;
+    }
+
+    vt_parser_reset(screen->parser);
+    reset_state(screen);
+}
+
+/*=============================================================================
+ * Output
+ *============================================================================*/
+
+QalamResult terminal_screen_write(TerminalScreen* screen, const char* data, size_t length) {
+    QALAM_CHECK_NULL(screen);
+    if (length == 0) {
+        return QALAM_OK;
+    }
+    QALAM_CHECK_NULL(data);
+
+    vt_parser_parse(screen->parser, data, length);
+    QalamResult result = screen->error;
+    screen->error = QALAM_OK;
+    return result;
+}
+
+QalamResult terminal_screen_resize(TerminalScreen* screen, size_t columns, size_t rows) {
+    QALAM_CHECK_NULL(screen);
+    if (columns == 0 || rows == 0 ||
+        columns > TERMINAL_SCREEN_MAX_SIZE || rows > TERMINAL_SCREEN_MAX_SIZE) {
+        return QALAM_ERROR_INVALID_ARGUMENT;
+    }
+    if (columns == screen->columns && rows == screen->rows) {
+        return QALAM_OK;
+    }
+
+    ScreenGrid grids[2];
+    memset(grids, 0, sizeof(grids));
+    TerminalCell* scratch = (TerminalCell*)qalam_mem_alloc(QALAM_MEMORY_TERMINAL,
+                                                           columns * sizeof(TerminalCell));
+    DirtySpan* dirty = (DirtySpan*)qalam_mem_calloc(QALAM_MEMORY_TERMINAL, rows, sizeof(DirtySpan));
+    QalamResult result = scratch && dirty ? QALAM_OK : QALAM_ERROR_OUT_OF_MEMORY;
+    if (result == QALAM_OK) {
+        result = grid_create(&grids[GRID_MAIN], columns, rows);
+    }
+    if (result == QALAM_OK) {
+        result = grid_create(&grids[GRID_ALTERNATE], columns, rows);
+    }
+    if (result != QALAM_OK) {
+        grid_destroy(&grids[GRID_MAIN]);
+        grid_destroy(&grids[GRID_ALTERNATE]);
+        qalam_mem_free(scratch);
+        qalam_mem_free(dirty);
+        return result;
+    }
+
+    /* The main screen's cursor is the saved one while the alternate is shown */
+    bool main_shown = screen->shown == GRID_MAIN;
+    CursorState* main_cursor = main_shown ? &screen->cursor : &screen->saved[GRID_MAIN];
+    result = reflow_main(screen, &grids[GRID_MAIN], scratch, columns, rows, main_cursor);
+    copy_grid(&screen->grids[GRID_ALTERNATE], screen->columns, screen->rows,
+              &grids[GRID_ALTERNATE], columns, rows);
+
+    if (main_shown) {
+        clamp_cursor(&screen->saved[GRID_MAIN], columns, rows);
+    } else {
+        clamp_cursor(&screen->cursor, columns, rows);
+    }
+    clamp_cursor(&screen->saved[GRID_ALTERNATE], columns, rows);
+
+    grid_destroy(&screen->grids[GRID_MAIN]);
+    grid_destroy(&screen->grids[GRID_ALTERNATE]);
+    qalam_mem_free(screen->dirty);
+    qalam_mem_free(scratch);
+    screen->grids[GRID_MAIN] = grids[GRID_MAIN];
+    screen->grids[GRID_ALTERNATE] = grids[GRID_ALTERNATE];
+    screen->dirty = dirty;
+    screen->columns = columns;
+    screen->rows = rows;
+    screen->top = 0;
+    screen->bottom = rows;
+    mark_rows_dirty(screen, 0, rows);
+    return result;
+}
+
+/*=============================================================================
+ * Contents
+ *============================================================================*/
+
+void terminal_screen_get_size(const TerminalScreen* screen, size_t* columns, size_t* rows) {
+    if (columns) {
+        *columns = screen ? screen->columns : 0;
+    }
+    if (rows) {
+        *rows = screen ? screen->rows : 0;
+    }
+}
+
+const TerminalCell* terminal_screen_get_row(const TerminalScreen* screen, size_t row,
+                                            unsigned int* flags) {
+    if (!screen || row >= screen->rows) {
+        return NULL;
+    }
+
+    const ScreenRow* screen_row = &screen->grids[screen->shown].rows[row];
+    if (flags) {
+        *flags = screen_row->flags;
+    }
+    return screen_row->cells;
+}
+
+void terminal_screen_get_cursor(const TerminalScreen* screen, TerminalCursor* cursor) {
+    if (!screen || !cursor) {
+        return;
+    }
+
+    cursor->column = screen->cursor.column;
+    cursor->row = screen->cursor.row;
+    cursor->visible = screen->cursor_visible;
+}
+
+bool terminal_screen_is_alternate(const TerminalScreen* screen) {
+    return screen && screen->shown == GRID_ALTERNATE;
+}
+
+Scrollback* terminal_screen_get_scrollback(TerminalScreen* screen) {
+    return screen ? screen->scrollback : NULL;
+}
+
+/*=============================================================================
+ * Dirty Cells
+ *============================================================================*/
+
+bool terminal_screen_get_dirty(const TerminalScreen* screen, size_t row, size_t* first,
+                               size_t* end) {
+    if (!screen || row >= screen->rows) {
+        return false;
+    }
+
+    const DirtySpan* span = &screen->dirty[row];
+    if (first) {
+        *first = span->first;
+    }
+    if (end) {
+        *end = span->end;
+    }
+    return span->first != span->end;
+}
+
+bool terminal_screen_is_dirty(const TerminalScreen* screen) {
+    return screen && screen->dirty_any;
+}
+
+void terminal_screen_invalidate(TerminalScreen* screen) {
+    if (screen) {
+        mark_rows_dirty(screen, 0, screen->rows);
+    }
+}
+
+void terminal_screen_clear_dirty(TerminalScreen* screen) {
+    if (!screen) {
+        return;
+    }
+
+    memset(screen->dirty, 0, screen->rows * sizeof(DirtySpan));
+    screen->dirty_any = false;
+}
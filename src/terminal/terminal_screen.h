@@ -0,0 +1,232 @@
+/**
+ * @file terminal_screen.h
+ * @brief Qalam IDE - Terminal Screen Grid (Internal Header)
+ *
+ * Internal header for the grid of cells a terminal shows, kept up to
+ * date from the pseudoconsole's output. The screen runs that output
+ * through a VtParser and applies what it recognizes: text with its SGR
+ * attributes, cursor movement, erasing, inserting and deleting, scroll
+ * regions, and the alternate screen full-screen programs switch to.
+ * Rows that scroll off the top of the main screen go to its Scrollback.
+ *
+ * Every change marks the cells it touched dirty, as one span of columns
+ * per row, so a renderer can redraw just those and then call
+ * terminal_screen_clear_dirty().
+ *
+ * Rows remember whether their line was wrapped onto the next row. On a
+ * resize the main screen is reflowed: wrapped rows are joined back into
+ * lines and split again at the new width, and the cursor stays on the
+ * character it was on. The alternate screen is cut or padded instead,
+ * since the program drawing on it redraws after a resize anyway.
+ *
+ * @version 0.0.2
+ * @copyright (c) 2026 Qalam Project
+ *
+ * @note Thread Safety: Not thread-safe. Use a screen from one thread.
+ */
+
+#ifndef QALAM_TERMINAL_SCREEN_H
+#define QALAM_TERMINAL_SCREEN_H
+
+#include "qalam.h"
+#include "terminal.h"
+#include "terminal_cell.h"
+#include "scrollback.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*=============================================================================
+ * Configuration Constants
+ *============================================================================*/
+
+/** Columns between tab stops */
+#define TERMINAL_SCREEN_TAB_WIDTH       8
+
+/** Most columns or rows of a screen */
+#define TERMINAL_SCREEN_MAX_SIZE        4096
+
+/*=============================================================================
+ * Terminal Screen Structures
+ *============================================================================*/
+
+/**
+ * @brief Cursor position and visibility
+ */
+typedef struct TerminalCursor {
+    size_t column;                  /**< Column, 0-based */
+    size_t row;                     /**< Screen row, 0-based */
+    bool visible;                   /**< Shown (DECTCEM) */
+} TerminalCursor;
+
+/**
+ * @brief Opaque terminal screen
+ */
+typedef struct TerminalScreen TerminalScreen;
+
+/*=============================================================================
+ * Lifecycle
+ *============================================================================*/
+
+/**
+ * @brief Create a terminal screen
+ *
+ * @param[out] screen Receives the screen
+ * @param columns Columns (1 to TERMINAL_SCREEN_MAX_SIZE)
+ * @param rows Rows (1 to TERMINAL_SCREEN_MAX_SIZE)
+ * @param scrollback_budget Memory budget of its scrollback (0 for the default)
+ * @return QALAM_OK on success, error code on failure
+ */
+QalamResult terminal_screen_create(TerminalScreen** screen, size_t columns, size_t rows,
+                                   size_t scrollback_budget);
+
+/**
+ * @brief Destroy a terminal screen and its scrollback
+ *
+ * @param screen Screen to destroy (may be NULL)
+ */
+void terminal_screen_destroy(TerminalScreen* screen);
+
+/**
+ * @brief Reset the screen as a full reset (RIS) would
+ *
+ * Clears both screens, attributes, modes and margins; keeps the
+ * scrollback.
+ *
+ * @param screen Terminal screen
+ */
+void terminal_screen_reset(TerminalScreen* screen);
+
+/*=============================================================================
+ * Output
+ *============================================================================*/
+
+/**
+ * @brief Apply the next part of the terminal's output
+ *
+ * Sequences and characters may be split across calls in any way.
+ *
+ * @param screen Terminal screen
+ * @param data UTF-8 output
+ * @param length Bytes of output
+ * @return QALAM_OK, or QALAM_ERROR_OUT_OF_MEMORY if rows could not be
+ *         kept in the scrollback (they are dropped)
+ */
+QalamResult terminal_screen_write(TerminalScreen* screen, const char* data, size_t length);
+
+/**
+ * @brief Resize the screen, reflowing the main screen
+ *
+ * Rows that no longer fit above the cursor go to the scrollback.
+ * Everything is marked dirty.
+ *
+ * @param screen Terminal screen
+ * @param columns New columns (1 to TERMINAL_SCREEN_MAX_SIZE)
+ * @param rows New rows (1 to TERMINAL_SCREEN_MAX_SIZE)
+ * @return QALAM_OK on success, QALAM_ERROR_OUT_OF_MEMORY if the new grids
+ *         could not be allocated (the screen is unchanged) or rows could
+ *         not be kept in the scrollback (they are dropped)
+ */
+QalamResult terminal_screen_resize(TerminalScreen* screen, size_t columns, size_t rows);
+
+/*=============================================================================
+ * Contents
+ *============================================================================*/
+
+/**
+ * @brief Get the screen's size
+ *
+ * @param screen Terminal screen
+ * @param[out] columns Receives the columns (optional)
+ * @param[out] rows Receives the rows (optional)
+ */
+void terminal_screen_get_size(const TerminalScreen* screen, size_t* columns, size_t* rows);
+
+/**
+ * @brief Get a row of the screen being shown
+ *
+ * @param screen Terminal screen
+ * @param row Screen row
+ * @param[out] flags Receives the row's SCROLLBACK_ROW_* flags (optional)
+ * @return The row's cells, one per column (valid until the next write or
+ *         resize), or NULL past the last row
+ */
+const TerminalCell* terminal_screen_get_row(const TerminalScreen* screen, size_t row,
+                                            unsigned int* flags);
+
+/**
+ * @brief Get the cursor
+ *
+ * @param screen Terminal screen
+ * @param[out] cursor Receives the cursor
+ */
+void terminal_screen_get_cursor(const TerminalScreen* screen, TerminalCursor* cursor);
+
+/**
+ * @brief Check whether the alternate screen is shown
+ */
+bool terminal_screen_is_alternate(const TerminalScreen* screen);
+
+/**
+ * @brief Get the scrollback the main screen scrolls into
+ *
+ * @param screen Terminal screen
+ * @return The screen's scrollback store
+ */
+Scrollback* terminal_screen_get_scrollback(TerminalScreen* screen);
+
+/*=============================================================================
+ * Dirty Cells
+ *============================================================================*/
+
+/**
+ * @brief Get the dirty cells of a row
+ *
+ * @param screen Terminal screen
+ * @param row Screen row
+ * @param[out] first Receives the first dirty column
+ * @param[out] end Receives the column after the last dirty one
+ * @return true if the row has dirty cells
+ */
+bool terminal_screen_get_dirty(const TerminalScreen* screen, size_t row, size_t* first,
+                               size_t* end);
+
+/**
+ * @brief Check whether any cell is dirty
+ */
+bool terminal_screen_is_dirty(const TerminalScreen* screen);
+
+/**
+ * @brief Mark every cell dirty
+ *
+ * @param screen Terminal screen
+ */
+void terminal_screen_invalidate(TerminalScreen* screen);
+
+/**
+ * @brief Mark every cell clean, once a frame has drawn them
+ *
+ * @param screen Terminal screen
+ */
+void terminal_screen_clear_dirty(TerminalScreen* screen);
+
+/*=============================================================================
+ * Terminal Integration
+ *============================================================================*/
+
+/**
+ * @brief Get the screen a terminal keeps from its output
+ *
+ * Defined with the terminal (conpty.c).
+ *
+ * @param terminal Terminal
+ * @return The terminal's screen, or NULL
+ */
+TerminalScreen* qalam_terminal_get_screen(QalamTerminal* terminal);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* QALAM_TERMINAL_SCREEN_H */
@@ -0,0 +1,577 @@
+/**
+ * @file vt_parser.c
+ * @brief Qalam IDE - VT/ANSI Escape Sequence Parser Implementation
+ *
+ * Each byte is first mapped to one of VT_CLASS_COUNT classes, the byte
+ * ranges that Williams' state diagram tells apart; the class and the
+ * current state then index a transition table. A transition holds an
+ * action and a next state, or VT_STATE_STAY for none. As in the diagram,
+ * moving to a state runs the old state's exit action, then the
+ * transition's action, then the new state's entry action; staying runs
+ * only the transition's action. "Anywhere" transitions (CAN, SUB, ESC)
+ * are repeated in every row.
+ *
+ * The table is consulted only for bytes that end a run. In the ground,
+ * OSC string and DCS passthrough states most bytes have the same action,
+ * so the parser finds the next control byte with text_find_control() and
+ * hands the run before it over in one call.
+ *
+ * @version 0.0.2
+ * @copyright (c) 2026 Qalam Project
+ *
+ * @note Thread Safety: See vt_parser.h.
+ */
+
+#include "vt_parser.h"
+#include "text_scan.h"
+#include <stdlib.h>
+#include <string.h>
+
+/*=============================================================================
+ * Parser Tables
+ *============================================================================*/
+
+/**
+ * @brief Parser states (Williams' names)
+ */
+typedef enum VtState {
+    VT_STATE_GROUND = 0,
+    VT_STATE_ESCAPE,
+    VT_STATE_ESCAPE_INTERMEDIATE,
+    VT_STATE_CSI_ENTRY,
+    VT_STATE_CSI_PARAM,
+    VT_STATE_CSI_INTERMEDIATE,
+    VT_STATE_CSI_IGNORE,
+    VT_STATE_DCS_ENTRY,
+    VT_STATE_DCS_PARAM,
+    VT_STATE_DCS_INTERMEDIATE,
+    VT_STATE_DCS_PASSTHROUGH,
+    VT_STATE_DCS_IGNORE,
+    VT_STATE_OSC_STRING,
+    VT_STATE_SOS_PM_APC_STRING,
+    VT_STATE_COUNT,
+    VT_STATE_STAY = 15,             /**< Transition without a state change */
+} VtState;
+
+/**
+ * @brief Transition actions
+ */
+typedef enum VtAction {
+    VT_ACTION_NONE = 0,
+    VT_ACTION_IGNORE,
+    VT_ACTION_PRINT,
+    VT_ACTION_EXECUTE,
+    VT_ACTION_COLLECT,
+    VT_ACTION_PARAM,
+    VT_ACTION_ESC_DISPATCH,
+    VT_ACTION_CSI_DISPATCH,
+    VT_ACTION_PUT,
+    VT_ACTION_OSC_PUT,
+} VtAction;
+
+/**
+ * @brief Byte classes
+ */
+typedef enum VtClass {
+    VT_CLASS_C0 = 0,                /**< 0x00-0x17, 0x19, 0x1C-0x1F except BEL */
+    VT_CLASS_BEL,                   /**< 0x07 */
+    VT_CLASS_CAN,                   /**< 0x18, 0x1A */
+    VT_CLASS_ESC,                   /**< 0x1B */
+    VT_CLASS_INTERMEDIATE,          /**< 0x20-0x2F */
+    VT_CLASS_DIGIT,                 /**< 0x30-0x39 */
+    VT_CLASS_COLON,                 /**< 0x3A */
+    VT_CLASS_SEMICOLON,             /**< 0x3B */
+    VT_CLASS_PRIVATE,               /**< 0x3C-0x3F */
+    VT_CLASS_FINAL,                 /**< 0x40-0x7E except the five below */
+    VT_CLASS_DCS,                   /**< 'P' */
+    VT_CLASS_STRING,                /**< 'X', '^', '_' (SOS, PM, APC) */
+    VT_CLASS_CSI,                   /**< '[' */
+    VT_CLASS_OSC,                   /**< ']' */
+    VT_CLASS_DEL,                   /**< 0x7F */
+    VT_CLASS_HIGH,                  /**< 0x80-0xFF, UTF-8 text */
+    VT_CLASS_COUNT,
+} VtClass;
+
+#define C0 VT_CLASS_C0
+#define BL VT_CLASS_BEL
+#define CN VT_CLASS_CAN
+#define ES VT_CLASS_ESC
+#define IN VT_CLASS_INTERMEDIATE
+#define DG VT_CLASS_DIGIT
+#define CO VT_CLASS_COLON
+#define SC VT_CLASS_SEMICOLON
+#define PV VT_CLASS_PRIVATE
+#define FN VT_CLASS_FINAL
+#define DC VT_CLASS_DCS
+#define ST VT_CLASS_STRING
+#define CS VT_CLASS_CSI
+#define OS VT_CLASS_OSC
+#define DL VT_CLASS_DEL
+#define HI VT_CLASS_HIGH
+
+static const uint8_t g_vt_class[256] = {
+    C0, C0, C0, C0, C0, C0, C0, BL, C0, C0, C0, C0, C0, C0, C0, C0,   /* 0x00 */
+    C0, C0, C0, C0, C0, C0, C0, C0, CN, C0, CN, ES, C0, C0, C0, C0,   /* 0x10 */
+    IN, IN, IN, IN, IN, IN, IN, IN, IN, IN, IN, IN, IN, IN, IN, IN,   /* 0x20 */
+    DG, DG, DG, DG, DG, DG, DG, DG, DG, DG, CO, SC, PV, PV, PV, PV,   /* 0x30 */
+    FN, FN, FN, FN, FN, FN, FN, FN, FN, FN, FN, FN, FN, FN, FN, FN,   /* 0x40 */
+    DC, FN, FN, FN, FN, FN, FN, FN, ST, FN, FN, CS, FN, OS, ST, ST,   /* 0x50 */
+    FN, FN, FN, FN, FN, FN, FN, FN, FN, FN, FN, FN, FN, FN, FN, FN,   /* 0x60 */
+    FN, FN, FN, FN, FN, FN, FN, FN, FN, FN, FN, FN, FN, FN, FN, DL,   /* 0x70 */
+    HI, HI, HI, HI, HI, HI, HI, HI, HI, HI, HI, HI, HI, HI, HI, HI,   /* 0x80 */
+    HI, HI, HI, HI, HI, HI, HI, HI, HI, HI, HI, HI, HI, HI, HI, HI,   /* 0x90 */
+    HI, HI, HI, HI, HI, HI, HI, HI, HI, HI, HI, HI, HI, HI, HI, HI,   /* 0xA0 */
+    HI, HI, HI, HI, HI, HI, HI, HI, HI, HI, HI, HI, HI, HI, HI, HI,   /* 0xB0 */
+    HI, HI, HI, HI, HI, HI, HI, HI, HI, HI, HI, HI, HI, HI, HI, HI,   /* 0xC0 */
+    HI, HI, HI, HI, HI, HI, HI, HI, HI, HI, HI, HI, HI, HI, HI, HI,   /* 0xD0 */
+    HI, HI, HI, HI, HI, HI, HI, HI, HI, HI, HI, HI, HI, HI, HI, HI,   /* 0xE0 */
+    HI, HI, HI, HI, HI, HI, HI, HI, HI, HI, HI, HI, HI, HI, HI, HI,   /* 0xF0 */
+};
+
+#undef C0
+#undef BL
+#undef CN
+#undef ES
+#undef IN
+#undef DG
+#undef CO
+#undef SC
+#undef PV
+#undef FN
+#undef DC
+#undef ST
+#undef CS
+#undef OS
+#undef DL
+#undef HI
+
+/** A transition: action in the high nibble, next state in the low one */
+#define T(action, state) ((uint8_t)((VT_ACTION_##action << 4) | VT_STATE_##state))
+
+/** Transitions for the bytes 0x40-0x7E except DEL */
+#define T_FINALS(t) t, t, t, t, t
+
+/** Transitions every state shares: CAN and SUB abort, ESC starts over */
+#define T_ANYWHERE T(EXECUTE, GROUND), T(NONE, ESCAPE)
+
+static const uint8_t g_vt_transitions[VT_STATE_COUNT][VT_CLASS_COUNT] = {
+    /* Columns in VtClass order: C0, BEL, CAN and ESC, intermediate, digit,
+     * colon, semicolon, private, the five finals, DEL, high */
+    [VT_STATE_GROUND] = {
+        T(EXECUTE, STAY), T(EXECUTE, STAY), T_ANYWHERE, T(PRINT, STAY),
+        T(PRINT, STAY), T(PRINT, STAY), T(PRINT, STAY), T(PRINT, STAY),
+        T_FINALS(T(PRINT, STAY)), T(IGNORE, STAY), T(PRINT, STAY) },
+    [VT_STATE_ESCAPE] = {
+        T(EXECUTE, STAY), T(EXECUTE, STAY), T_ANYWHERE, T(COLLECT, ESCAPE_INTERMEDIATE),
+        T(ESC_DISPATCH, GROUND), T(ESC_DISPATCH, GROUND), T(ESC_DISPATCH, GROUND),
+        T(ESC_DISPATCH, GROUND), T(ESC_DISPATCH, GROUND), T(NONE, DCS_ENTRY),
+        T(NONE, SOS_PM_APC_STRING), T(NONE, CSI_ENTRY), T(NONE, OSC_STRING),
+        T(IGNORE, STAY), T(IGNORE, STAY) },
+    [VT_STATE_ESCAPE_INTERMEDIATE] = {
+        T(EXECUTE, STAY), T(EXECUTE, STAY), T_ANYWHERE, T(COLLECT, STAY),
+        T(ESC_DISPATCH, GROUND), T(ESC_DISPATCH, GROUND), T(ESC_DISPATCH, GROUND),
+        T(ESC_DISPATCH, GROUND), T_FINALS(T(ESC_DISPATCH, GROUND)),
+        T(IGNORE, STAY), T(IGNORE, STAY) },
+    [VT_STATE_CSI_ENTRY] = {
+        T(EXECUTE, STAY), T(EXECUTE, STAY), T_ANYWHERE, T(COLLECT, CSI_INTERMEDIATE),
+        T(PARAM, CSI_PARAM), T(PARAM, CSI_PARAM), T(PARAM, CSI_PARAM), T(COLLECT, CSI_PARAM),
+        T_FINALS(T(CSI_DISPATCH, GROUND)), T(IGNORE, STAY), T(IGNORE, STAY) },
+    [VT_STATE_CSI_PARAM] = {
+        T(EXECUTE, STAY), T(EXECUTE, STAY), T_ANYWHERE, T(COLLECT, CSI_INTERMEDIATE),
+        T(PARAM, STAY), T(PARAM, STAY), T(PARAM, STAY), T(NONE, CSI_IGNORE),
+        T_FINALS(T(CSI_DISPATCH, GROUND)), T(IGNORE, STAY), T(IGNORE, STAY) },
+    [VT_STATE_CSI_INTERMEDIATE] = {
+        T(EXECUTE, STAY), T(EXECUTE, STAY), T_ANYWHERE, T(COLLECT, STAY),
+        T(NONE, CSI_IGNORE), T(NONE, CSI_IGNORE), T(NONE, CSI_IGNORE), T(NONE, CSI_IGNORE),
+        T_FINALS(T(CSI_DISPATCH, GROUND)), T(IGNORE, STAY), T(IGNORE, STAY) },
+    [VT_STATE_CSI_IGNORE] = {
+        T(EXECUTE, STAY), T(EXECUTE, STAY), T_ANYWHERE, T(IGNORE, STAY),
+        T(IGNORE, STAY), T(IGNORE, STAY), T(IGNORE, STAY), T(IGNORE, STAY),
+        T_FINALS(T(NONE, GROUND)), T(IGNORE, STAY), T(IGNORE, STAY) },
+    [VT_STATE_DCS_ENTRY] = {
+        T(IGNORE, STAY), T(IGNORE, STAY), T_ANYWHERE, T(COLLECT, DCS_INTERMEDIATE),
+        T(PARAM, DCS_PARAM), T(PARAM, DCS_PARAM), T(PARAM, DCS_PARAM), T(COLLECT, DCS_PARAM),
+        T_FINALS(T(NONE, DCS_PASSTHROUGH)), T(IGNORE, STAY), T(IGNORE, STAY) },
+    [VT_STATE_DCS_PARAM] = {
+        T(IGNORE, STAY), T(IGNORE, STAY), T_ANYWHERE, T(COLLECT, DCS_INTERMEDIATE),
+        T(PARAM, STAY), T(PARAM, STAY), T(PARAM, STAY), T(NONE, DCS_IGNORE),
+        T_FINALS(T(NONE, DCS_PASSTHROUGH)), T(IGNORE, STAY), T(IGNORE, STAY) },
+    [VT_STATE_DCS_INTERMEDIATE] = {
+        T(IGNORE, STAY), T(IGNORE, STAY), T_ANYWHERE, T(COLLECT, STAY),
+        T(NONE, DCS_IGNORE), T(NONE, DCS_IGNORE), T(NONE, DCS_IGNORE), T(NONE, DCS_IGNORE),
+        T_FINALS(T(NONE, DCS_PASSTHROUGH)), T(IGNORE, STAY), T(IGNORE, STAY) },
+    [VT_STATE_DCS_PASSTHROUGH] = {
+        T(PUT, STAY), T(PUT, STAY), T_ANYWHERE, T(PUT, STAY),
+        T(PUT, STAY), T(PUT, STAY), T(PUT, STAY), T(PUT, STAY),
+        T_FINALS(T(PUT, STAY)), T(IGNORE, STAY), T(PUT, STAY) },
+    [VT_STATE_DCS_IGNORE] = {
+        T(IGNORE, STAY), T(IGNORE, STAY), T_ANYWHERE, T(IGNORE, STAY),
+        T(IGNORE, STAY), T(IGNORE, STAY), T(IGNORE, STAY), T(IGNORE, STAY),
+        T_FINALS(T(IGNORE, STAY)), T(IGNORE, STAY), T(IGNORE, STAY) },
+    [VT_STATE_OSC_STRING] = {
+        T(IGNORE, STAY), T(NONE, GROUND), T_ANYWHERE, T(OSC_PUT, STAY),
+        T(OSC_PUT, STAY), T(OSC_PUT, STAY), T(OSC_PUT, STAY), T(OSC_PUT, STAY),
+        T_FINALS(T(OSC_PUT, STAY)), T(OSC_PUT, STAY), T(OSC_PUT, STAY) },
+    [VT_STATE_SOS_PM_APC_STRING] = {
+        T(IGNORE, STAY), T(IGNORE, STAY), T_ANYWHERE, T(IGNORE, STAY),
+        T(IGNORE, STAY), T(IGNORE, STAY), T(IGNORE, STAY), T(IGNORE, STAY),
+        T_FINALS(T(IGNORE, STAY)), T(IGNORE, STAY), T(IGNORE, STAY) },
+};
+
+#undef T
+#undef T_FINALS
+#undef T_ANYWHERE
+
+/*=============================================================================
+ * Internal Structures
+ *============================================================================*/
+
+/**
+ * @brief VT parser state
+ */
+struct VtParser {
+    VtParserHandler handler;        /**< Handler to call */
+    void* user_data;                /**< Context for 'handler' */
+    uint8_t state;                  /**< Current VtState */
+
+    VtSequence sequence;            /**< Sequence being collected */
+    bool dropped;                   /**< Too many intermediates: do not dispatch */
+
+    char osc[VT_MAX_OSC_LENGTH + 1]; /**< OSC string being collected */
+    size_t osc_length;              /**< Bytes in 'osc' */
+
+    char carry[4];                  /**< Start of a character split by the last call */
+    size_t carry_length;            /**< Bytes in 'carry' */
+    size_t carry_needed;            /**< Length of the whole character */
+};
+
+/*=============================================================================
+ * Internal Helper Functions
+ *============================================================================*/
+
+/**
+ * @brief Length of the UTF-8 sequence a byte starts (1 for anything else)
+ */
+static inline size_t vt_utf8_length(unsigned char lead) {
+    if (lead < 0xC0) {
+        return 1;
+    }
+    if (lead < 0xE0) {
+        return 2;
+    }
+    if (lead < 0xF0) {
+        return 3;
+    }
+    return lead < 0xF8 ? 4 : 1;
+}
+
+static void vt_parser_clear(VtParser* parser) {
+    parser->sequence.param_count = 0;
+    parser->sequence.subparams = 0;
+    parser->sequence.intermediate_count = 0;
+    parser->sequence.final = 0;
+    parser->dropped = false;
+}
+
+static void vt_parser_collect(VtParser* parser, unsigned char byte) {
+    VtSequence* sequence = &parser->sequence;
+    if (sequence->intermediate_count == VT_MAX_INTERMEDIATES) {
+        parser->dropped = true;
+        return;
+    }
+    sequence->intermediates[sequence->intermediate_count++] = (char)byte;
+}
+
+static void vt_parser_param(VtParser* parser, unsigned char byte) {
+    VtSequence* sequence = &parser->sequence;
+
+    /* The first parameter byte opens the first parameter */
+    if (sequence->param_count == 0) {
+        sequence->params[0] = 0;
+        sequence->param_count = 1;
+    }
+
+    if (byte == ';' || byte == ':') {
+        if (sequence->param_count < VT_MAX_PARAMS) {
+            sequence->params[sequence->param_count] = 0;
+            if (byte == ':') {
+                sequence->subparams |= 1u << sequence->param_count;
+            }
+        }
+        /* Past the limit the count keeps growing, so later digits are dropped */
+        if (sequence->param_count <= VT_MAX_PARAMS) {
+            sequence->param_count++;
+        }
+        return;
+    }
+
+    if (sequence->param_count > VT_MAX_PARAMS) {
+        return;
+    }
+    uint16_t* value = &sequence->params[sequence->param_count - 1];
+    uint32_t next = (uint32_t)*value * 10 + (uint32_t)(byte - '0');
+    *value = next > 0xFFFF ? 0xFFFF : (uint16_t)next;
+}
+
+/**
+ * @brief Dispatch a sequence through one of the handler's members
+ */
+static void vt_parser_dispatch(VtParser* parser,
+                               void (*dispatch)(void*, const VtSequence*),
+                               unsigned char final) {
+    if (!dispatch || parser->dropped) {
+        return;
+    }
+
+    /* Only VT_MAX_PARAMS are kept however many were sent */
+    size_t count = parser->sequence.param_count;
+    if (count > VT_MAX_PARAMS) {
+        parser->sequence.param_count = VT_MAX_PARAMS;
+    }
+    parser->sequence.final = (char)final;
+    dispatch(parser->user_data, &parser->sequence);
+    parser->sequence.param_count = count;
+}
+
+static void vt_parser_osc_put(VtParser* parser, const char* data, size_t length) {
+    size_t room = VT_MAX_OSC_LENGTH - parser->osc_length;
+    if (length > room) {
+        length = room;
+    }
+    memcpy(parser->osc + parser->osc_length, data, length);
+    parser->osc_length += length;
+}
+
+/**
+ * @brief Exit action of the current state
+ */
+static void vt_parser_exit(VtParser* parser) {
+    if (parser->state == VT_STATE_OSC_STRING) {
+        if (parser->handler.osc_dispatch) {
+            parser->osc[parser->osc_length] = '\0';
+            parser->handler.osc_dispatch(parser->user_data, parser->osc, parser->osc_length);
+        }
+    } else if (parser->state == VT_STATE_DCS_PASSTHROUGH) {
+        if (parser->handler.dcs_unhook) {
+            parser->handler.dcs_unhook(parser->user_data);
+        }
+    }
+}
+
+/**
+ * @brief Entry action of the current state
+ *
+ * @param byte Byte that caused the transition
+ */
+static void vt_parser_enter(VtParser* parser, unsigned char byte) {
+    switch (parser->state) {
+        case VT_STATE_ESCAPE:
+        case VT_STATE_CSI_ENTRY:
+        case VT_STATE_DCS_ENTRY:
+            vt_parser_clear(parser);
+            break;
+        case VT_STATE_OSC_STRING:
+            parser->osc_length = 0;
+            break;
+        case VT_STATE_DCS_PASSTHROUGH:
+            vt_parser_dispatch(parser, parser->handler.dcs_hook, byte);
+            break;
+        default:
+            break;
+    }
+}
+
+/**
+ * @brief Run a transition for one byte
+ */
+static void vt_parser_transition(VtParser* parser, unsigned char byte) {
+    uint8_t transition = g_vt_transitions[parser->state][g_vt_class[byte]];
+    unsigned int next = transition & 0x0F;
+    char text = (char)byte;
+
+    if (next != VT_STATE_STAY) {
+        vt_parser_exit(parser);
+    }
+
+    switch ((VtAction)(transition >> 4)) {
+        case VT_ACTION_PRINT:
+            if (parser->handler.print) {
+                parser->handler.print(parser->user_data, &text, 1);
+            }
+            break;
+        case VT_ACTION_EXECUTE:
+            if (parser->handler.execute) {
+                parser->handler.execute(parser->user_data, byte);
+            }
+            break;
+        case VT_ACTION_COLLECT:
+            vt_parser_collect(parser, byte);
+            break;
+        case VT_ACTION_PARAM:
+            vt_parser_param(parser, byte);
+            break;
+        case VT_ACTION_ESC_DISPATCH:
+            vt_parser_dispatch(parser, parser->handler.esc_dispatch, byte);
+            break;
+        case VT_ACTION_CSI_DISPATCH:
+            vt_parser_dispatch(parser, parser->handler.csi_dispatch, byte);
+            break;
+        case VT_ACTION_PUT:
+            if (parser->handler.dcs_put) {
+                parser->handler.dcs_put(parser->user_data, &text, 1);
+            }
+            break;
+        case VT_ACTION_OSC_PUT:
+            vt_parser_osc_put(parser, &text, 1);
+            break;
+        case VT_ACTION_NONE:
+        case VT_ACTION_IGNORE:
+        default:
+            break;
+    }
+
+    if (next != VT_STATE_STAY) {
+        parser->state = (uint8_t)next;
+        vt_parser_enter(parser, byte);
+    }
+}
+
+/**
+ * @brief Print a run of text, holding back a character it ends inside of
+ *
+ * @param at_end Whether the run reaches the end of the data
+ */
+static void vt_parser_print(VtParser* parser, const char* text, size_t length, bool at_end) {
+    if (at_end) {
+        /* Find the start of the last character */
+        size_t back = length < 3 ? length : 3;
+        for (size_t k = 1; k <= back; k++) {
+            unsigned char byte = (unsigned char)text[length - k];
+            if ((byte & 0xC0) != 0x80) {
+                size_t needed = vt_utf8_length(byte);
+                if (needed > k) {
+                    memcpy(parser->carry, text + length - k, k);
+                    parser->carry_length = k;
+                    parser->carry_needed = needed;
+                    length -= k;
+                }
+                break;
+            }
+        }
+    }
+
+    if (length > 0 && parser->handler.print) {
+        parser->handler.print(parser->user_data, text, length);
+    }
+}
+
+/**
+ * @brief Complete the character held back by the last call
+ *
+ * @return First byte after the character's continuation bytes
+ */
+static const char* vt_parser_finish_carry(VtParser* parser, const char* data, const char* end) {
+    while (parser->carry_length < parser->carry_needed && data < end &&
+           ((unsigned char)*data & 0xC0) == 0x80) {
+        parser->carry[parser->carry_length++] = *data++;
+    }
+
+    /* Print it once complete, or as it is when it turns out malformed */
+    if (parser->carry_length == parser->carry_needed || data < end) {
+        size_t length = parser->carry_length;
+        parser->carry_length = 0;
+        if (parser->handler.print) {
+            parser->handler.print(parser->user_data, parser->carry, length);
+        }
+    }
+    return data;
+}
+
+/*=============================================================================
+ * Lifecycle
+ *============================================================================*/
+
+QalamResult vt_parser_create(VtParser** parser, const VtParserHandler* handler, void* user_data) {
+    if (!parser || !handler) {
+        return QALAM_ERROR_NULL_POINTER;
+    }
+
+    *parser = NULL;
+
+    VtParser* p = (VtParser*)qalam_mem_calloc(QALAM_MEMORY_TERMINAL, 1, sizeof(VtParser));
+    if (!p) {
+        return QALAM_ERROR_OUT_OF_MEMORY;
+    }
+    p->handler = *handler;
+    p->user_data = user_data;
+    p->state = VT_STATE_GROUND;
+
+    *parser = p;
+    return QALAM_OK;
+}
+
+void vt_parser_destroy(VtParser* parser) {
+    qalam_mem_free(parser);
+}
+
+void vt_parser_reset(VtParser* parser) {
+    if (!parser) {
+        return;
+    }
+
+    if (parser->state == VT_STATE_DCS_PASSTHROUGH && parser->handler.dcs_unhook) {
+        parser->handler.dcs_unhook(parser->user_data);
+    }
+    parser->state = VT_STATE_GROUND;
+    parser->osc_length = 0;
+    parser->carry_length = 0;
+    vt_parser_clear(parser);
+}
+
+/*=============================================================================
+ * Parsing
+ *============================================================================*/
+
+void vt_parser_parse(VtParser* parser, const char* data, size_t length) {
+    if (!parser || !data) {
+        return;
+    }
+
+    const char* end = data + length;
+    if (parser->carry_length > 0) {
+        data = vt_parser_finish_carry(parser, data, end);
+    }
+
+    while (data < end) {
+        /* Runs with a single action go through in one call */
+        if (parser->state == VT_STATE_GROUND ||
+            parser->state == VT_STATE_OSC_STRING ||
+            parser->state == VT_STATE_DCS_PASSTHROUGH) {
+            size_t run = text_find_control(data, (size_t)(end - data));
+            if (run > 0) {
+                if (parser->state == VT_STATE_GROUND) {
+                    vt_parser_print(parser, data, run, data + run == end);
+                } else if (parser->state == VT_STATE_OSC_STRING) {
+                    vt_parser_osc_put(parser, data, run);
+                } else if (parser->handler.dcs_put) {
+                    parser->handler.dcs_put(parser->user_data, data, run);
+                }
+                data += run;
+                continue;
+            }
+        }
+
+        vt_parser_transition(parser, (unsigned char)*data++);
+    }
+}
+
+bool vt_parser_is_ground(const VtParser* parser) {
+    return parser && parser->state == VT_STATE_GROUND;
+}
+
+uint16_t vt_sequence_param(const VtSequence* sequence, size_t index, uint16_t default_value) {
+    if (!sequence || index >= sequence->param_count || sequence->params[index] == 0) {
+        return default_value;
+    }
+    return sequence->params[index];
+}
@@ -0,0 +1,181 @@
+/**
+ * @file vt_parser.h
+ * @brief Qalam IDE - VT/ANSI Escape Sequence Parser (Internal Header)
+ *
+ * Internal header for the parser that turns the UTF-8 byte stream of a
+ * pseudoconsole into calls on a VtParserHandler: runs of printable text,
+ * C0 controls, and complete ESC, CSI, OSC and DCS sequences. It is the
+ * state machine of Paul Williams' DEC-compatible parser, driven by two
+ * constant tables, with these departures for a UTF-8 stream:
+ *
+ * - Bytes 0x80-0xFF are text, never C1 controls, so multi-byte
+ *   characters pass through as they are.
+ * - ':' separates sub-parameters (as in "CSI 38:2::255:0:0 m") instead
+ *   of sending the sequence to CSI IGNORE.
+ * - BEL ends an OSC string as well as ST does.
+ *
+ * Printable text is found with text_find_control() and handed over a run
+ * at a time, so output that is mostly text, Arabic or not, costs one
+ * vector scan and one print call per line. A character split across two
+ * vt_parser_parse() calls is held back and printed whole.
+ *
+ * Parameters, intermediates and OSC strings are kept in fixed buffers
+ * within the parser; parsing never allocates. Sequences with more than
+ * VT_MAX_INTERMEDIATES intermediates are dropped, parameters past
+ * VT_MAX_PARAMS are ignored, and OSC strings are cut at
+ * VT_MAX_OSC_LENGTH bytes.
+ *
+ * Typical use: feed the data from the terminal's output callback to
+ * vt_parser_parse().
+ *
+ * @version 0.0.2
+ * @copyright (c) 2026 Qalam Project
+ *
+ * @note Thread Safety: Not thread-safe. Use a parser from one thread.
+ */
+
+#ifndef QALAM_VT_PARSER_H
+#define QALAM_VT_PARSER_H
+
+#include "qalam.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*=============================================================================
+ * Configuration Constants
+ *============================================================================*/
+
+/** Most parameters kept for one sequence */
+#define VT_MAX_PARAMS               32
+
+/** Most intermediate (and private marker) bytes of one sequence */
+#define VT_MAX_INTERMEDIATES        2
+
+/** Most bytes kept of one OSC string */
+#define VT_MAX_OSC_LENGTH           4096
+
+/*=============================================================================
+ * VT Parser Structures
+ *============================================================================*/
+
+/**
+ * @brief A parsed ESC, CSI or DCS sequence
+ *
+ * Valid only during the handler call it is passed to.
+ */
+typedef struct VtSequence {
+    uint16_t params[VT_MAX_PARAMS]; /**< Parameters (0 when left empty; clamped to 65535) */
+    uint32_t subparams;             /**< Bit i is set when params[i] followed a ':' */
+    size_t param_count;             /**< Parameters given (0 for none) */
+    char intermediates[VT_MAX_INTERMEDIATES]; /**< Intermediates and private markers, in order */
+    size_t intermediate_count;      /**< Bytes in 'intermediates' */
+    char final;                     /**< Final byte */
+} VtSequence;
+
+/**
+ * @brief What the parser calls as it recognizes the stream
+ *
+ * Any member may be NULL to ignore that kind of input.
+ */
+typedef struct VtParserHandler {
+    /** Printable UTF-8 text, never split inside a character */
+    void (*print)(void* user_data, const char* text, size_t length);
+
+    /** A C0 control (DEL is ignored, not passed) */
+    void (*execute)(void* user_data, unsigned char control);
+
+    /** ESC followed by intermediates and a final byte */
+    void (*esc_dispatch)(void* user_data, const VtSequence* sequence);
+
+    /** A complete control sequence (CSI) */
+    void (*csi_dispatch)(void* user_data, const VtSequence* sequence);
+
+    /** A complete OSC string, NUL-terminated, without its terminator */
+    void (*osc_dispatch)(void* user_data, const char* data, size_t length);
+
+    /** Start of a DCS string, with its parameters and final byte */
+    void (*dcs_hook)(void* user_data, const VtSequence* sequence);
+
+    /** Data of the DCS string begun by the last dcs_hook */
+    void (*dcs_put)(void* user_data, const char* data, size_t length);
+
+    /** End of the DCS string begun by the last dcs_hook */
+    void (*dcs_unhook)(void* user_data);
+} VtParserHandler;
+
+/**
+ * @brief Opaque VT parser
+ */
+typedef struct VtParser VtParser;
+
+/*=============================================================================
+ * Lifecycle
+ *============================================================================*/
+
+/**
+ * @brief Create a VT parser
+ *
+ * @param[out] parser Receives the parser
+ * @param handler Handler to call (copied)
+ * @param user_data Context passed to every handler call
+ * @return QALAM_OK on success, error code on failure
+ */
+QalamResult vt_parser_create(VtParser** parser, const VtParserHandler* handler, void* user_data);
+
+/**
+ * @brief Destroy a VT parser
+ *
+ * @param parser Parser to destroy (may be NULL)
+ */
+void vt_parser_destroy(VtParser* parser);
+
+/**
+ * @brief Drop any partial sequence or character and return to text
+ *
+ * An open DCS string is ended with dcs_unhook; an open OSC string is
+ * dropped.
+ *
+ * @param parser VT parser
+ */
+void vt_parser_reset(VtParser* parser);
+
+/*=============================================================================
+ * Parsing
+ *============================================================================*/
+
+/**
+ * @brief Parse the next part of the stream
+ *
+ * Sequences and characters may be split across calls in any way.
+ *
+ * @param parser VT parser
+ * @param data Bytes to parse
+ * @param length Number of bytes
+ */
+void vt_parser_parse(VtParser* parser, const char* data, size_t length);
+
+/**
+ * @brief Check whether the parser is between sequences
+ *
+ * @return true if the last byte parsed ended a sequence or was text,
+ *         even if a character is still held back
+ */
+bool vt_parser_is_ground(const VtParser* parser);
+
+/**
+ * @brief Get a parameter, or its default when it was left out or is 0
+ *
+ * @param sequence Parsed sequence
+ * @param index Parameter index
+ * @param default_value Value for a missing or 0 parameter
+ * @return The parameter
+ */
+uint16_t vt_sequence_param(const VtSequence* sequence, size_t index, uint16_t default_value);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* QALAM_VT_PARSER_H */
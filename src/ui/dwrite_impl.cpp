@@ -18,18 +18,110 @@
 
 #include <windows.h>
 #include <d2d1.h>
+#include <d2d1_1.h>
+#include <d3d11.h>
+#include <dxgi1_3.h>
 #include <dwrite.h>
+#include <dwrite_2.h>  // System font fallback for the glyph atlas
 #include <wrl/client.h>  // For ComPtr smart pointers
 
+#include <algorithm>
+#include <atomic>
 #include <cstdio>
 #include <cstdlib>
+#include <cmath>
+#include <cstring>
+#include <cwchar>
+#include <memory>
 #include <mutex>
+#include <new>
+#include <type_traits>
 
 // Include our C header - extern "C" is already in the header
 #include "dwrite_api.h"
 
 using Microsoft::WRL::ComPtr;
 
+/* ============================================================================
+ * Tagged Allocation
+ * 
+ * Everything this file keeps - formats, layouts, cache entries, shaped
+ * runs, render targets and the glyph atlas - is charged to
+ * QALAM_MEMORY_LAYOUT_CACHE (see "Memory" in qalam.h). Scratch arrays
+ * that only live for one call come from the frame arena instead.
+ * ============================================================================ */
+
+/**
+ * @brief Construct an object in tagged memory; free it with layout_delete()
+ */
+template <typename T>
+T* layout_new() {
+    void* memory = qalam_mem_alloc(QALAM_MEMORY_LAYOUT_CACHE, sizeof(T));
+    return memory ? new (memory) T() : nullptr;
+}
+
+/**
+ * @brief Destroy an object from layout_new() (may be nullptr)
+ */
+template <typename T>
+void layout_delete(T* object) {
+    if (object) {
+        object->~T();
+        qalam_mem_free(object);
+    }
+}
+
+/**
+ * @brief Allocate an array of plain values in tagged memory, zeroed if asked;
+ *        free it with layout_free()
+ */
+template <typename T>
+T* layout_array(size_t count, bool zeroed = false) {
+    static_assert(std::is_trivially_copyable<T>::value, "layout_array() does not construct");
+    if (zeroed) {
+        return static_cast<T*>(qalam_mem_calloc(QALAM_MEMORY_LAYOUT_CACHE, count, sizeof(T)));
+    }
+    if (count > SIZE_MAX / sizeof(T)) {
+        return nullptr;
+    }
+    return static_cast<T*>(qalam_mem_alloc(QALAM_MEMORY_LAYOUT_CACHE, count * sizeof(T)));
+}
+
+/**
+ * @brief Free an array from layout_array() (may be nullptr)
+ */
+inline void layout_free(void* array) {
+    qalam_mem_free(array);
+}
+
+/**
+ * @brief Scratch arrays from the frame arena, given back when it goes out of scope
+ * 
+ * Rewinding at the end of the call keeps layouts made outside a frame,
+ * or on a thread that never presents, from piling up in the arena.
+ */
+struct FrameScratch {
+    size_t mark;
+    
+    FrameScratch() : mark(qalam_frame_mark()) {}
+    ~FrameScratch() { qalam_frame_rewind(mark); }
+    FrameScratch(const FrameScratch&) = delete;
+    FrameScratch& operator=(const FrameScratch&) = delete;
+    
+    template <typename T>
+    T* array(size_t count, bool zeroed = false) {
+        static_assert(std::is_trivially_copyable<T>::value, "FrameScratch does not construct");
+        if (count > SIZE_MAX / sizeof(T)) {
+            return nullptr;
+        }
+        void* memory = qalam_frame_alloc(count * sizeof(T));
+        if (memory && zeroed) {
+            std::memset(memory, 0, count * sizeof(T));
+        }
+        return static_cast<T*>(memory);
+    }
+};
+
 /* ============================================================================
  * Opaque Handle Structures
  * ============================================================================ */
@@ -40,35 +132,383 @@ using Microsoft::WRL::ComPtr;
 struct QalamDWriteTextFormat {
     ComPtr<IDWriteTextFormat> format;
     bool is_rtl;
+    const wchar_t* locale;
+    
+    // Resolved on first shaping
+    ComPtr<IDWriteFontFace> font_face;
+    DWRITE_FONT_METRICS font_metrics;
+    bool face_failed;                           // No face: shape through IDWriteTextLayout
     
-    QalamDWriteTextFormat() : is_rtl(false) {}
+    QalamDWriteTextFormat() : is_rtl(false), locale(L"en-US"), font_metrics(), face_failed(false) {}
+};
+
+struct ShapedRun;
+
+/**
+ * @brief A shaped run placed on a line
+ */
+struct PlacedRun {
+    ShapedRun* run;
+    uint32_t text_position;
+    uint8_t bidi_level;
+    float x;                                    // Left edge, from the start of the text
+};
+
+/**
+ * @brief A cluster's place on its line, for caret navigation
+ */
+struct CaretCluster {
+    uint32_t position;
+    uint32_t length;
+    float left;
+    float right;
+    bool is_rtl;
 };
 
 /**
  * @brief DirectWrite text layout wrapper
+ * 
+ * Layouts from a layout cache are usually shaped runs instead: glyphs
+ * drawn with DrawGlyphRun(), and an IDWriteTextLayout created only if
+ * the layout is hit tested.
  */
 struct QalamDWriteTextLayout {
-    ComPtr<IDWriteTextLayout> layout;
+    ComPtr<IDWriteTextLayout> layout;           // Created on demand for shaped layouts
     bool is_rtl;
     
-    QalamDWriteTextLayout() : is_rtl(false) {}
+    // Shaped layout
+    bool shaped;
+    PlacedRun* runs;                            // In visual order, left to right
+    uint32_t run_count;
+    float origin_x;                             // Alignment offset in the layout box
+    float width;                                // Sum of the run widths
+    float height;                               // Line height of the font
+    float baseline;
+    QalamDWriteTextFormat* format;
+    const wchar_t* text;                        // Owned by the cache entry
+    uint32_t text_length;
+    float max_width;
+    float max_height;
+    
+    // Caret table, built on first use (outside the cache budget: a few
+    // bytes per cluster, next to the runs the layout already holds)
+    CaretCluster* clusters;                     // In visual order, left to right
+    QalamDWriteCaretStop* caret_stops;          // Logical stops, then as many visual stops
+    uint32_t cluster_count;
+    
+    // Style ranges: shaped layouts split their runs by brush when drawn,
+    // others carry them as drawing effects of the IDWriteTextLayout
+    QalamStyleRange* styles;                    // Ordered by start, clamped to the text
+    uint32_t style_count;
+    QalamDWriteBrush** style_brushes;           // Brush of each style, or NULL
+    uint32_t style_brush_count;
+    uint32_t effects_generation;                // Device generation of the set effects
+    bool effects_dirty;                         // Drawing effects need setting again
+    bool has_effects;                           // IDWriteTextLayout holds drawing effects
+    
+    QalamDWriteTextLayout()
+        : is_rtl(false), shaped(false), runs(nullptr), run_count(0), origin_x(0.0f),
+          width(0.0f), height(0.0f), baseline(0.0f), format(nullptr), text(nullptr),
+          text_length(0), max_width(0.0f), max_height(0.0f), clusters(nullptr),
+          caret_stops(nullptr), cluster_count(0), styles(nullptr), style_count(0),
+          style_brushes(nullptr), style_brush_count(0), effects_generation(0),
+          effects_dirty(false), has_effects(false) {}
+    
+    ~QalamDWriteTextLayout() {
+        layout_free(runs);
+        layout_free(clusters);
+        layout_free(caret_stops);
+        layout_free(styles);
+        layout_free(style_brushes);
+    }
 };
 
+/** Most separate dirty rects presented in one frame; more are merged */
+constexpr UINT kMaxDirtyRects = 8;
+
 /**
  * @brief Direct2D render target wrapper
+ * 
+ * Draws through an ID2D1DeviceContext into a flip-model DXGI swap chain
+ * on a D3D11 device, or through an ID2D1HwndRenderTarget where that
+ * cannot be created. 'target' is whichever of the two is in use, so the
+ * drawing functions do not depend on the backend.
  */
 struct QalamDWriteRenderTarget {
-    ComPtr<ID2D1HwndRenderTarget> target;
+    ComPtr<ID2D1RenderTarget> target;           // Drawing interface of the backend in use
     HWND hwnd;
     
-    QalamDWriteRenderTarget() : hwnd(nullptr) {}
+    // Flip-model backend
+    ComPtr<ID3D11Device> d3d_device;
+    ComPtr<IDXGISwapChain1> swap_chain;
+    ComPtr<ID2D1DeviceContext> context;
+    ComPtr<ID2D1Bitmap1> back_buffer;
+    HANDLE frame_waitable;                      // Signaled when a frame can be queued
+    
+    // HWND render target backend
+    ComPtr<ID2D1HwndRenderTarget> hwnd_target;
+    
+    RECT dirty_rects[kMaxDirtyRects];           // Dirty rects of this frame, in pixels
+    UINT dirty_count;                           // Entries in 'dirty_rects'
+    RECT dirty;                                 // Union of dirty rects, in pixels
+    bool has_dirty;                             // 'dirty' holds a rect for this frame
+    bool full_present;                          // Back buffer must be redrawn and presented whole
+    bool clipped;                               // render_begin() pushed a clip to 'dirty'
+    QalamDWriteBrush* brushes;                  // Brushes to recreate after device loss
+    uint32_t device_generation;                 // Bumped whenever the device is created
+    
+    QalamDWriteRenderTarget()
+        : hwnd(nullptr), frame_waitable(nullptr), dirty_rects(), dirty_count(0), dirty(),
+          has_dirty(false),
+          full_present(true), clipped(false), brushes(nullptr), device_generation(0) {}
 };
 
 /**
  * @brief Direct2D brush wrapper
+ * 
+ * Keeps its color so the owning target can recreate it on a new device.
  */
 struct QalamDWriteBrush {
     ComPtr<ID2D1SolidColorBrush> brush;
+    D2D1_COLOR_F color;
+    QalamDWriteRenderTarget* owner;             // Target that recreates it, or NULL
+    QalamDWriteBrush* next;                     // Next brush of the same target
+    
+    QalamDWriteBrush() : color(), owner(nullptr), next(nullptr) {}
+};
+
+/**
+ * @brief Glyphs of one shaped run
+ * 
+ * A run is text of a single script and bidi level, split again after a
+ * space once it is long, so an edit reshapes only the run it falls in.
+ * Runs are looked up by their text and shared by every cached layout
+ * that contains them; the last layout to let go frees the run.
+ */
+struct ShapedRun {
+    ShapedRun* hash_next;               // Next run in the run bucket
+    uint64_t hash;                      // Hash of the text, format, script and direction
+    QalamDWriteTextFormat* format;
+    DWRITE_SCRIPT_ANALYSIS script;
+    bool is_rtl;
+    uint32_t refs;                      // Layouts holding the run
+    uint32_t text_length;
+    uint32_t glyph_count;
+    float width;                        // Sum of the advances
+    size_t bytes;                       // Size, counted in the cache's bytes_used
+    wchar_t* text;
+    uint16_t* cluster_map;              // First glyph of each character
+    uint16_t* glyphs;
+    float* advances;
+    DWRITE_GLYPH_OFFSET* offsets;
+};
+
+struct LayoutCacheEntry;
+
+/**
+ * @brief A generation a cached layout was returned for
+ * 
+ * Lines with the same text share one layout, so an entry may carry a
+ * tag for each of them.
+ */
+struct LayoutGenTag {
+    LayoutGenTag* gen_next;             // Next tag in the generation bucket
+    LayoutGenTag* entry_next;           // Next older tag of the same entry
+    LayoutCacheEntry* entry;
+    uint32_t generation;
+};
+
+/**
+ * @brief One layout held by a layout cache
+ * 
+ * Linked into the cache's LRU list and a text hash bucket; each of its
+ * generation tags is linked into a generation bucket.
+ */
+struct LayoutCacheEntry {
+    LayoutCacheEntry* lru_prev;         // Towards the most recently used
+    LayoutCacheEntry* lru_next;         // Towards the least recently used
+    LayoutCacheEntry* hash_next;        // Next entry in the text bucket
+    LayoutGenTag* tags;                 // Generation tags, newest first
+    uint32_t tag_count;
+    uint64_t hash;                      // Hash of the text and key
+    QalamDWriteTextFormat* format;
+    float max_width;
+    float max_height;
+    float dpi;
+    uint64_t frame;                     // Frame of the last lookup
+    size_t bytes;                       // Estimated size
+    uint32_t text_length;
+    wchar_t* text;                      // Copy of the text, to rule out collisions
+    QalamDWriteTextLayout* layout;
+};
+
+/**
+ * @brief DirectWrite text layout cache
+ */
+struct QalamDWriteLayoutCache {
+    LayoutCacheEntry** buckets;         // Entries by text hash
+    LayoutGenTag** gen_buckets;         // Generation tags by generation
+    size_t bucket_count;                // Power of two, shared by both tables
+    ShapedRun** run_buckets;            // Shaped runs by hash
+    size_t run_bucket_count;            // Power of two
+    size_t run_count;
+    LayoutCacheEntry* lru_head;
+    LayoutCacheEntry* lru_tail;
+    size_t entry_count;
+    size_t tag_count;
+    size_t bytes_used;
+    size_t byte_budget;
+    uint64_t frame;
+    uint64_t hits;
+    uint64_t misses;
+    uint64_t evictions;
+    uint64_t runs_shaped;
+    uint64_t runs_reused;
+    uint64_t fallbacks;
+    
+    QalamDWriteLayoutCache()
+        : buckets(nullptr), gen_buckets(nullptr), bucket_count(0), run_buckets(nullptr),
+          run_bucket_count(0), run_count(0), lru_head(nullptr), lru_tail(nullptr),
+          entry_count(0), tag_count(0), bytes_used(0), byte_budget(0), frame(0), hits(0),
+          misses(0), evictions(0), runs_shaped(0), runs_reused(0), fallbacks(0) {}
+};
+
+/** Width and height of the glyph atlas bitmap in pixels */
+constexpr uint32_t kAtlasSize = 1024;
+
+/** Most font faces a glyph atlas draws from: four styles, then fallbacks */
+constexpr uint32_t kAtlasMaxFaces = 32;
+
+/** Faces of the four styles, indexed by QALAM_DWRITE_GLYPH_* flags */
+constexpr uint32_t kAtlasStyleCount = 4;
+
+/**
+ * @brief Where a glyph sits in the atlas bitmap
+ * 
+ * 'left' and 'top' place the glyph's box relative to its origin on the
+ * baseline, in pixels. A glyph with nothing to draw (a space) has a
+ * width of 0.
+ */
+struct AtlasGlyph {
+    uint16_t x;
+    uint16_t y;
+    uint16_t width;
+    uint16_t height;
+    int16_t left;
+    int16_t top;
+};
+
+/**
+ * @brief Open-addressing table from nonzero 32-bit keys to values
+ */
+template <typename Value>
+struct AtlasTable {
+    uint32_t* keys;                     // 0 marks a free slot
+    Value* values;
+    uint32_t capacity;                  // Power of two, or 0 before the first insert
+    uint32_t count;
+    
+    AtlasTable() : keys(nullptr), values(nullptr), capacity(0), count(0) {}
+};
+
+/**
+ * @brief A font face a glyph atlas draws glyphs from
+ */
+struct AtlasFace {
+    ComPtr<IDWriteFontFace> face;
+    float design_scale;                 // DIPs per design unit at the atlas' font size
+    
+    AtlasFace() : design_scale(0.0f) {}
+};
+
+/**
+ * @brief Text shaped once by a glyph atlas and drawn again by its text
+ */
+struct AtlasCluster {
+    AtlasCluster* hash_next;
+    uint64_t hash;                      // Hash of the text, style and direction
+    uint32_t style;
+    bool is_rtl;
+    uint32_t text_length;
+    wchar_t* text;
+    ShapedRun* run;                     // nullptr if the font cannot shape the text
+};
+
+/**
+ * @brief Glyph atlas for drawing a grid of cells
+ * 
+ * Glyph keys are (face + 1) << 16 | glyph; a character resolves to
+ * face << 16 | glyph, per style.
+ */
+struct QalamDWriteGlyphAtlas {
+    QalamDWriteRenderTarget* target;
+    QalamDWriteTextFormat* styles[kAtlasStyleCount];   // Regular, bold, italic, bold italic
+    AtlasFace faces[kAtlasMaxFaces];   // Style faces (may be missing), then fallback faces
+    uint32_t face_count;
+    ComPtr<IDWriteFontFallback> fallback;
+    ComPtr<IDWriteFontCollection> fonts;
+    wchar_t* family;
+    float font_size;
+    
+    // Device resources, recreated for a new device or DPI
+    ComPtr<ID2D1BitmapRenderTarget> bitmap_target;
+    ComPtr<ID2D1Bitmap> bitmap;
+    ComPtr<ID2D1SolidColorBrush> white;
+    uint32_t device_generation;         // Target generation the bitmap belongs to
+    float dpi;
+    float scale;                        // Pixels per DIP
+    bool needs_clear;                   // Bitmap holds glyphs no longer in the table
+    bool drawn;                         // Target drew from the bitmap since its last flush
+    
+    // Shelf packing of the bitmap
+    uint32_t shelf_x;
+    uint32_t shelf_y;
+    uint32_t shelf_height;
+    
+    QalamDWriteCellMetrics cell;        // At 'dpi'
+    uint32_t ascii[kAtlasStyleCount][128];             // Resolved ASCII characters
+    AtlasTable<uint32_t> chars;         // (codepoint | style << 21) -> face << 16 | glyph
+    AtlasTable<AtlasGlyph> glyphs;      // Glyph key -> place in the bitmap
+    AtlasCluster** cluster_buckets;
+    size_t cluster_count;
+    uint32_t* keys;                     // Glyph keys of the call being drawn
+    uint32_t key_capacity;
+    
+    uint64_t glyphs_rasterized;
+    uint64_t clusters_shaped;
+    uint64_t clusters_reused;
+    uint64_t flushes;
+    
+    QalamDWriteGlyphAtlas()
+        : target(nullptr), styles(), face_count(kAtlasStyleCount), family(nullptr),
+          font_size(0.0f), device_generation(0), dpi(96.0f), scale(1.0f), needs_clear(true),
+          drawn(false), shelf_x(0), shelf_y(0), shelf_height(0), cell(), ascii(),
+          cluster_buckets(nullptr), cluster_count(0), keys(nullptr), key_capacity(0),
+          glyphs_rasterized(0), clusters_shaped(0), clusters_reused(0), flushes(0) {}
+};
+
+/** Longest font family name kept by the Arabic family table and its cache */
+constexpr uint32_t kFamilyNameMax = 64;
+
+/**
+ * @brief Font preload
+ */
+struct QalamDWriteFontPreload {
+    HANDLE thread;
+    wchar_t family[kFamilyNameMax];
+    float size;
+    wchar_t* cache_path;
+    QalamDWriteFontReadyCallback ready;
+    void* user_data;
+    
+    // Written by the worker before 'done' is set
+    QalamDWriteTextFormat* format;      // Until taken by qalam_dwrite_font_preload_wait()
+    QalamResult result;
+    volatile LONG done;
+    
+    QalamDWriteFontPreload()
+        : thread(nullptr), family(), size(0.0f), cache_path(nullptr), ready(nullptr),
+          user_data(nullptr), format(nullptr), result(QALAM_OK), done(0) {}
 };
 
 /* ============================================================================
@@ -77,18 +517,41 @@ struct QalamDWriteBrush {
 
 namespace {
 
+/** Most Arabic family choices kept per process and in the cache file */
+constexpr uint32_t kFamilyResolutionMax = 16;
+
+/**
+ * @brief The family an Arabic format asked for, and the one it got
+ */
+struct FamilyResolution {
+    wchar_t requested[kFamilyNameMax];
+    wchar_t resolved[kFamilyNameMax];
+};
+
 /**
  * @brief Global DirectWrite/D2D context
  */
 struct DWriteGlobals {
     ComPtr<ID2D1Factory> d2d_factory;
     ComPtr<IDWriteFactory> dwrite_factory;
-    ComPtr<IDWriteFontCollection> system_fonts;
     bool initialized;
     int ref_count;
     std::mutex init_mutex;
     
-    DWriteGlobals() : initialized(false), ref_count(0) {}
+    // Loaded on first use (see dwrite_load_fonts())
+    ComPtr<IDWriteFontCollection> system_fonts;
+    ComPtr<IDWriteTextAnalyzer> text_analyzer;
+    std::atomic<bool> fonts_loaded;
+    std::mutex fonts_mutex;
+    
+    // Arabic family choices (see resolve_arabic_family()), under fonts_mutex
+    FamilyResolution families[kFamilyResolutionMax];
+    uint32_t family_count;
+    bool families_dirty;                // Not yet in the cache file
+    
+    DWriteGlobals()
+        : initialized(false), ref_count(0), fonts_loaded(false), families(), family_count(0),
+          families_dirty(false) {}
 };
 
 // Global singleton instance
@@ -110,6 +573,8 @@ inline QalamResult hr_to_result(HRESULT hr) {
         case E_POINTER:
             return QALAM_ERROR_NULL_POINTER;
         case D2DERR_RECREATE_TARGET:
+        case DXGI_ERROR_DEVICE_REMOVED:
+        case DXGI_ERROR_DEVICE_RESET:
             return QALAM_ERROR_RENDER_TARGET;
         default:
             if (HRESULT_FACILITY(hr) == FACILITY_DWRITE) {
@@ -134,6 +599,2414 @@ inline D2D1_COLOR_F to_d2d_color(QalamDWriteColor color) {
     return D2D1::ColorF(color.r, color.g, color.b, color.a);
 }
 
+/** Buckets allocated by a new layout cache */
+constexpr size_t kLayoutCacheInitialBuckets = 256;
+
+/** Estimated fixed size of a cached layout (COM objects, line metrics) */
+constexpr size_t kLayoutCacheEntryBytes = 1024;
+
+/** Estimated size per character (glyphs, clusters, bidi levels, text copy) */
+constexpr size_t kLayoutCacheCharBytes = 64;
+
+/** Most generation tags kept per cached layout */
+constexpr uint32_t kLayoutCacheMaxTags = 256;
+
+/** Characters a run reaches before it is split after its next space */
+constexpr uint32_t kShapedRunSplitLength = 32;
+
+/** Longest run shaped by the text analyzer; longer lines use IDWriteTextLayout */
+constexpr uint32_t kShapedRunMaxLength = 4096;
+
+/**
+ * @brief Mix a 64-bit value into a hash (splitmix64 finalizer)
+ */
+inline uint64_t hash_mix(uint64_t h) {
+    h ^= h >> 30;
+    h *= 0xBF58476D1CE4E5B9ULL;
+    h ^= h >> 27;
+    h *= 0x94D049BB133111EBULL;
+    h ^= h >> 31;
+    return h;
+}
+
+/**
+ * @brief Reinterpret a float's bits for hashing and comparison
+ */
+inline uint32_t float_bits(float value) {
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+/**
+ * @brief Hash everything in a key except the generation
+ */
+inline uint64_t hash_layout_key(const QalamDWriteLayoutKey* key) {
+    uint64_t h = hash_mix(reinterpret_cast<uintptr_t>(key->format));
+    h = hash_mix(h ^ float_bits(key->max_width));
+    h = hash_mix(h ^ (static_cast<uint64_t>(float_bits(key->max_height)) << 32 | float_bits(key->dpi)));
+    return h;
+}
+
+/**
+ * @brief Hash a text (FNV-1a over UTF-16 units)
+ */
+uint64_t hash_text(const wchar_t* text, uint32_t length) {
+    uint64_t h = 0xCBF29CE484222325ULL;
+    for (uint32_t i = 0; i < length; i++) {
+        h ^= static_cast<uint16_t>(text[i]);
+        h *= 0x100000001B3ULL;
+    }
+    return hash_mix(h ^ length);
+}
+
+/**
+ * @brief Hash a text together with its key
+ */
+inline uint64_t hash_layout_text(const wchar_t* text, uint32_t length, const QalamDWriteLayoutKey* key) {
+    return hash_text(text, length) ^ hash_layout_key(key);
+}
+
+/**
+ * @brief Hash a run's text together with what it is shaped with
+ */
+inline uint64_t hash_run(const wchar_t* text, uint32_t length, const QalamDWriteTextFormat* format,
+                         const DWRITE_SCRIPT_ANALYSIS& script, bool is_rtl) {
+    uint64_t h = hash_mix(reinterpret_cast<uintptr_t>(format));
+    h = hash_mix(h ^ (static_cast<uint64_t>(script.script) << 8 |
+                      static_cast<uint64_t>(script.shapes) << 1 | (is_rtl ? 1 : 0)));
+    return hash_text(text, length) ^ h;
+}
+
+/**
+ * @brief Check whether an entry was laid out with the same key
+ */
+inline bool entry_matches_key(const LayoutCacheEntry* entry, const QalamDWriteLayoutKey* key) {
+    return entry->format == key->format &&
+           float_bits(entry->max_width) == float_bits(key->max_width) &&
+           float_bits(entry->max_height) == float_bits(key->max_height) &&
+           float_bits(entry->dpi) == float_bits(key->dpi);
+}
+
+inline size_t gen_bucket_of(const QalamDWriteLayoutCache* cache, uint32_t generation) {
+    return static_cast<size_t>(hash_mix(generation)) & (cache->bucket_count - 1);
+}
+
+/**
+ * @brief Move an entry to the front of the LRU list
+ */
+void cache_lru_push_front(QalamDWriteLayoutCache* cache, LayoutCacheEntry* entry) {
+    entry->lru_prev = nullptr;
+    entry->lru_next = cache->lru_head;
+    if (cache->lru_head) {
+        cache->lru_head->lru_prev = entry;
+    } else {
+        cache->lru_tail = entry;
+    }
+    cache->lru_head = entry;
+}
+
+void cache_lru_unlink(QalamDWriteLayoutCache* cache, LayoutCacheEntry* entry) {
+    if (entry->lru_prev) {
+        entry->lru_prev->lru_next = entry->lru_next;
+    } else {
+        cache->lru_head = entry->lru_next;
+    }
+    if (entry->lru_next) {
+        entry->lru_next->lru_prev = entry->lru_prev;
+    } else {
+        cache->lru_tail = entry->lru_prev;
+    }
+}
+
+/**
+ * @brief Remove a node from a bucket chain linked through 'link'
+ */
+template <typename Node>
+void cache_chain_unlink(Node** bucket, Node* node, Node* Node::*link) {
+    while (*bucket != node) {
+        bucket = &((*bucket)->*link);
+    }
+    *bucket = node->*link;
+}
+
+/**
+ * @brief Unlink a tag from its generation bucket and free it
+ * 
+ * The caller has already removed it from the entry's tag list.
+ */
+void cache_drop_tag(QalamDWriteLayoutCache* cache, LayoutGenTag* tag) {
+    LayoutCacheEntry* entry = tag->entry;
+    cache_chain_unlink(&cache->gen_buckets[gen_bucket_of(cache, tag->generation)],
+                       tag, &LayoutGenTag::gen_next);
+    entry->tag_count--;
+    entry->bytes -= sizeof(LayoutGenTag);
+    cache->tag_count--;
+    cache->bytes_used -= sizeof(LayoutGenTag);
+    layout_delete(tag);
+}
+
+/**
+ * @brief Tag an entry with a generation it was returned for
+ * 
+ * Past kLayoutCacheMaxTags the oldest tag goes, which at worst makes
+ * that line miss once. Allocation failure is not an error for the same
+ * reason.
+ */
+void cache_add_generation(QalamDWriteLayoutCache* cache, LayoutCacheEntry* entry, uint32_t generation) {
+    if (generation == 0) {
+        return;
+    }
+    for (LayoutGenTag* tag = entry->tags; tag; tag = tag->entry_next) {
+        if (tag->generation == generation) {
+            return;
+        }
+    }
+    
+    auto* tag = layout_new<LayoutGenTag>();
+    if (!tag) {
+        return;
+    }
+    tag->generation = generation;
+    tag->entry = entry;
+    tag->entry_next = entry->tags;
+    entry->tags = tag;
+    
+    LayoutGenTag** bucket = &cache->gen_buckets[gen_bucket_of(cache, generation)];
+    tag->gen_next = *bucket;
+    *bucket = tag;
+    
+    entry->tag_count++;
+    entry->bytes += sizeof(LayoutGenTag);
+    cache->tag_count++;
+    cache->bytes_used += sizeof(LayoutGenTag);
+    
+    if (entry->tag_count > kLayoutCacheMaxTags) {
+        LayoutGenTag** oldest = &entry->tags;
+        while ((*oldest)->entry_next) {
+            oldest = &(*oldest)->entry_next;
+        }
+        LayoutGenTag* dropped = *oldest;
+        *oldest = nullptr;
+        cache_drop_tag(cache, dropped);
+    }
+}
+
+/**
+ * @brief Free a run and its arrays (already unlinked from the cache)
+ */
+void run_free(ShapedRun* run) {
+    layout_free(run->text);
+    layout_free(run->cluster_map);
+    layout_free(run->glyphs);
+    layout_free(run->advances);
+    layout_free(run->offsets);
+    layout_delete(run);
+}
+
+/**
+ * @brief Drop a layout's hold on a run, freeing the run with the last hold
+ */
+void cache_release_run(QalamDWriteLayoutCache* cache, ShapedRun* run) {
+    if (--run->refs > 0) {
+        return;
+    }
+    
+    cache_chain_unlink(&cache->run_buckets[run->hash & (cache->run_bucket_count - 1)],
+                       run, &ShapedRun::hash_next);
+    cache->run_count--;
+    cache->bytes_used -= run->bytes;
+    run_free(run);
+}
+
+/**
+ * @brief Release a layout's runs and destroy it
+ */
+void cache_layout_free(QalamDWriteLayoutCache* cache, QalamDWriteTextLayout* layout) {
+    for (uint32_t i = 0; i < layout->run_count; i++) {
+        cache_release_run(cache, layout->runs[i].run);
+    }
+    qalam_dwrite_text_layout_destroy(layout);
+}
+
+/**
+ * @brief Free an entry and its tags (already unlinked from the cache)
+ */
+void cache_entry_free(QalamDWriteLayoutCache* cache, LayoutCacheEntry* entry) {
+    while (entry->tags) {
+        LayoutGenTag* next = entry->tags->entry_next;
+        layout_delete(entry->tags);
+        entry->tags = next;
+    }
+    cache_layout_free(cache, entry->layout);
+    layout_free(entry->text);
+    layout_delete(entry);
+}
+
+/**
+ * @brief Unlink an entry from every list and free it
+ */
+void cache_evict(QalamDWriteLayoutCache* cache, LayoutCacheEntry* entry) {
+    cache_lru_unlink(cache, entry);
+    cache_chain_unlink(&cache->buckets[entry->hash & (cache->bucket_count - 1)],
+                       entry, &LayoutCacheEntry::hash_next);
+    while (entry->tags) {
+        LayoutGenTag* tag = entry->tags;
+        entry->tags = tag->entry_next;
+        cache_drop_tag(cache, tag);
+    }
+    
+    cache->entry_count--;
+    cache->bytes_used -= entry->bytes;
+    cache_entry_free(cache, entry);
+}
+
+/**
+ * @brief Evict least recently used entries until the cache fits its budget
+ * 
+ * Entries looked up during the current frame are never evicted.
+ */
+void cache_trim(QalamDWriteLayoutCache* cache) {
+    while (cache->bytes_used > cache->byte_budget && cache->lru_tail &&
+           cache->lru_tail->frame != cache->frame) {
+        cache_evict(cache, cache->lru_tail);
+        cache->evictions++;
+    }
+}
+
+/**
+ * @brief Double both bucket tables once entries or tags outnumber buckets
+ * 
+ * On allocation failure the cache keeps its current tables.
+ */
+void cache_grow(QalamDWriteLayoutCache* cache) {
+    if (cache->entry_count <= cache->bucket_count && cache->tag_count <= cache->bucket_count) {
+        return;
+    }
+    
+    size_t count = cache->bucket_count * 2;
+    auto** buckets = layout_array<LayoutCacheEntry*>(count, true);
+    auto** gen_buckets = layout_array<LayoutGenTag*>(count, true);
+    if (!buckets || !gen_buckets) {
+        layout_free(buckets);
+        layout_free(gen_buckets);
+        return;
+    }
+    
+    for (LayoutCacheEntry* entry = cache->lru_head; entry; entry = entry->lru_next) {
+        LayoutCacheEntry** bucket = &buckets[entry->hash & (count - 1)];
+        entry->hash_next = *bucket;
+        *bucket = entry;
+        
+        for (LayoutGenTag* tag = entry->tags; tag; tag = tag->entry_next) {
+            LayoutGenTag** gen_bucket =
+                &gen_buckets[static_cast<size_t>(hash_mix(tag->generation)) & (count - 1)];
+            tag->gen_next = *gen_bucket;
+            *gen_bucket = tag;
+        }
+    }
+    
+    layout_free(cache->buckets);
+    layout_free(cache->gen_buckets);
+    cache->buckets = buckets;
+    cache->gen_buckets = gen_buckets;
+    cache->bucket_count = count;
+}
+
+/**
+ * @brief Mark an entry as used by the current frame
+ */
+void cache_touch(QalamDWriteLayoutCache* cache, LayoutCacheEntry* entry) {
+    entry->frame = cache->frame;
+    if (cache->lru_head != entry) {
+        cache_lru_unlink(cache, entry);
+        cache_lru_push_front(cache, entry);
+    }
+    cache->hits++;
+}
+
+/**
+ * @brief Double the run table once runs outnumber its buckets
+ * 
+ * On allocation failure the cache keeps its current table.
+ */
+void cache_grow_runs(QalamDWriteLayoutCache* cache) {
+    if (cache->run_count <= cache->run_bucket_count) {
+        return;
+    }
+    
+    size_t count = cache->run_bucket_count * 2;
+    auto** buckets = layout_array<ShapedRun*>(count, true);
+    if (!buckets) {
+        return;
+    }
+    
+    for (size_t i = 0; i < cache->run_bucket_count; i++) {
+        ShapedRun* run = cache->run_buckets[i];
+        while (run) {
+            ShapedRun* next = run->hash_next;
+            ShapedRun** bucket = &buckets[run->hash & (count - 1)];
+            run->hash_next = *bucket;
+            *bucket = run;
+            run = next;
+        }
+    }
+    
+    layout_free(cache->run_buckets);
+    cache->run_buckets = buckets;
+    cache->run_bucket_count = count;
+}
+
+/**
+ * @brief Text analysis source and sink for one line
+ * 
+ * Feeds a line to IDWriteTextAnalyzer and records the script and the
+ * resolved bidi level of every character. Lives on the stack, so it is
+ * not reference counted.
+ */
+struct LineAnalysis final : IDWriteTextAnalysisSource, IDWriteTextAnalysisSink {
+    const wchar_t* text;
+    uint32_t length;
+    const wchar_t* locale;
+    bool is_rtl;
+    DWRITE_SCRIPT_ANALYSIS* scripts;    // One per character
+    uint8_t* levels;                    // One per character
+    
+    LineAnalysis(const wchar_t* text, uint32_t length, const wchar_t* locale, bool is_rtl,
+                 DWRITE_SCRIPT_ANALYSIS* scripts, uint8_t* levels)
+        : text(text), length(length), locale(locale), is_rtl(is_rtl), scripts(scripts),
+          levels(levels) {}
+    
+    // IUnknown
+    HRESULT STDMETHODCALLTYPE QueryInterface(REFIID riid, void** object) override {
+        if (riid == __uuidof(IDWriteTextAnalysisSink)) {
+            *object = static_cast<IDWriteTextAnalysisSink*>(this);
+        } else if (riid == __uuidof(IDWriteTextAnalysisSource) || riid == __uuidof(IUnknown)) {
+            *object = static_cast<IDWriteTextAnalysisSource*>(this);
+        } else {
+            *object = nullptr;
+            return E_NOINTERFACE;
+        }
+        return S_OK;
+    }
+    ULONG STDMETHODCALLTYPE AddRef() override { return 1; }
+    ULONG STDMETHODCALLTYPE Release() override { return 1; }
+    
+    // IDWriteTextAnalysisSource
+    HRESULT STDMETHODCALLTYPE GetTextAtPosition(UINT32 position, const WCHAR** text_string,
+                                                UINT32* text_length) override {
+        *text_string = position < length ? text + position : nullptr;
+        *text_length = position < length ? length - position : 0;
+        return S_OK;
+    }
+    HRESULT STDMETHODCALLTYPE GetTextBeforePosition(UINT32 position, const WCHAR** text_string,
+                                                    UINT32* text_length) override {
+        *text_string = position > 0 && position <= length ? text : nullptr;
+        *text_length = position <= length ? position : 0;
+        return S_OK;
+    }
+    DWRITE_READING_DIRECTION STDMETHODCALLTYPE GetParagraphReadingDirection() override {
+        return is_rtl ? DWRITE_READING_DIRECTION_RIGHT_TO_LEFT : DWRITE_READING_DIRECTION_LEFT_TO_RIGHT;
+    }
+    HRESULT STDMETHODCALLTYPE GetLocaleName(UINT32 position, UINT32* text_length,
+                                            const WCHAR** locale_name) override {
+        *text_length = position < length ? length - position : 0;
+        *locale_name = locale;
+        return S_OK;
+    }
+    HRESULT STDMETHODCALLTYPE GetNumberSubstitution(UINT32 position, UINT32* text_length,
+                                                    IDWriteNumberSubstitution** substitution) override {
+        *text_length = position < length ? length - position : 0;
+        *substitution = nullptr;
+        return S_OK;
+    }
+    
+    // IDWriteTextAnalysisSink
+    HRESULT STDMETHODCALLTYPE SetScriptAnalysis(UINT32 position, UINT32 text_length,
+                                                const DWRITE_SCRIPT_ANALYSIS* analysis) override {
+        for (uint32_t i = position; i < position + text_length && i < length; i++) {
+            scripts[i] = *analysis;
+        }
+        return S_OK;
+    }
+    HRESULT STDMETHODCALLTYPE SetLineBreakpoints(UINT32, UINT32, const DWRITE_LINE_BREAKPOINT*) override {
+        return S_OK;
+    }
+    HRESULT STDMETHODCALLTYPE SetBidiLevel(UINT32 position, UINT32 text_length, UINT8,
+                                           UINT8 resolved_level) override {
+        for (uint32_t i = position; i < position + text_length && i < length; i++) {
+            levels[i] = resolved_level;
+        }
+        return S_OK;
+    }
+    HRESULT STDMETHODCALLTYPE SetNumberSubstitution(UINT32, UINT32, IDWriteNumberSubstitution*) override {
+        return S_OK;
+    }
+};
+
+/**
+ * @brief Load the system font collection and text analyzer on first use
+ * 
+ * Enumerating the installed fonts is the slowest part of bringing
+ * DirectWrite up and nothing needs it before the first line of text, so
+ * qalam_dwrite_init() leaves it to here; a font preload usually gets
+ * here first, on its worker thread.
+ */
+void dwrite_load_fonts() {
+    if (g_dwrite.fonts_loaded.load(std::memory_order_acquire)) {
+        return;
+    }
+    
+    std::lock_guard<std::mutex> lock(g_dwrite.fonts_mutex);
+    if (g_dwrite.fonts_loaded.load(std::memory_order_relaxed) || !g_dwrite.dwrite_factory) {
+        return;
+    }
+    
+    QALAM_TRACE_BEGIN(span, QALAM_TRACE_STARTUP, "load_fonts");
+    
+    HRESULT hr = g_dwrite.dwrite_factory->GetSystemFontCollection(
+        g_dwrite.system_fonts.ReleaseAndGetAddressOf(),
+        FALSE  // checkForUpdates
+    );
+    if (FAILED(hr)) {
+        // Non-fatal - formats still resolve their fonts through DirectWrite
+        log_error(hr, "dwrite_load_fonts", "Failed to get system font collection (non-fatal)");
+    }
+    
+    hr = g_dwrite.dwrite_factory->CreateTextAnalyzer(
+        g_dwrite.text_analyzer.ReleaseAndGetAddressOf());
+    if (FAILED(hr)) {
+        // Non-fatal - cached layouts use IDWriteTextLayout instead
+        log_error(hr, "dwrite_load_fonts", "Failed to create text analyzer (non-fatal)");
+    }
+    
+    QALAM_TRACE_END(span);
+    g_dwrite.fonts_loaded.store(true, std::memory_order_release);
+}
+
+/**
+ * @brief Get the text analyzer, loading it on first use
+ * 
+ * @return The analyzer, or nullptr if it could not be created
+ */
+IDWriteTextAnalyzer* dwrite_text_analyzer() {
+    dwrite_load_fonts();
+    return g_dwrite.text_analyzer.Get();
+}
+
+/**
+ * @brief Get the font face a format's text is shaped with
+ * 
+ * Resolved from the format's family, weight, stretch and style on first
+ * use. Returns nullptr when the family is not installed; that text then
+ * needs IDWriteTextLayout's font fallback anyway.
+ */
+IDWriteFontFace* format_font_face(QalamDWriteTextFormat* format) {
+    if (format->font_face || format->face_failed) {
+        return format->font_face.Get();
+    }
+    format->face_failed = true;
+    
+    ComPtr<IDWriteFontCollection> fonts;
+    HRESULT hr = format->format->GetFontCollection(fonts.GetAddressOf());
+    if (FAILED(hr) || !fonts) {
+        dwrite_load_fonts();
+        fonts = g_dwrite.system_fonts;
+    }
+    if (!fonts) {
+        return nullptr;
+    }
+    
+    UINT32 name_length = format->format->GetFontFamilyNameLength() + 1;
+    FrameScratch scratch;
+    wchar_t* name = scratch.array<wchar_t>(name_length);
+    if (!name) {
+        return nullptr;
+    }
+    
+    UINT32 index = 0;
+    BOOL exists = FALSE;
+    hr = format->format->GetFontFamilyName(name, name_length);
+    if (SUCCEEDED(hr)) {
+        hr = fonts->FindFamilyName(name, &index, &exists);
+    }
+    if (FAILED(hr) || !exists) {
+        return nullptr;
+    }
+    
+    ComPtr<IDWriteFontFamily> family;
+    ComPtr<IDWriteFont> font;
+    ComPtr<IDWriteFontFace> face;
+    hr = fonts->GetFontFamily(index, family.GetAddressOf());
+    if (SUCCEEDED(hr)) {
+        hr = family->GetFirstMatchingFont(format->format->GetFontWeight(),
+                                          format->format->GetFontStretch(),
+                                          format->format->GetFontStyle(), font.GetAddressOf());
+    }
+    if (SUCCEEDED(hr)) {
+        hr = font->CreateFontFace(face.GetAddressOf());
+    }
+    if (FAILED(hr)) {
+        log_error(hr, "format_font_face", "Failed to resolve font face");
+        return nullptr;
+    }
+    
+    face->GetMetrics(&format->font_metrics);
+    format->font_face = std::move(face);
+    format->face_failed = false;
+    return format->font_face.Get();
+}
+
+/* ============================================================================
+ * Arabic Family Resolution
+ * ============================================================================ */
+
+/** Families tried, in order, for an Arabic format whose own family has no Arabic */
+const wchar_t* const kArabicFamilies[] = {
+    L"Segoe UI", L"Tahoma", L"Arial", L"Courier New", L"Simplified Arabic", L"Traditional Arabic",
+};
+
+/** Letters a family must have to count as covering Arabic (beh, lam, meem) */
+const UINT32 kArabicProbes[] = { 0x0628, 0x0644, 0x0645 };
+
+/** "QAFC": first field of a family cache file */
+constexpr uint32_t kFamilyCacheMagic = 0x43464151;
+
+/** Version of the family cache file layout */
+constexpr uint32_t kFamilyCacheVersion = 1;
+
+/**
+ * @brief Family cache file header, followed by entry_count FamilyResolutions
+ */
+struct FamilyCacheHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t font_count;                // Installed families when it was written
+    uint32_t entry_count;
+};
+
+/**
+ * @brief Check whether an installed family has Arabic letters
+ */
+bool family_has_arabic(IDWriteFontCollection* fonts, const wchar_t* name) {
+    UINT32 index = 0;
+    BOOL exists = FALSE;
+    HRESULT hr = fonts->FindFamilyName(name, &index, &exists);
+    if (FAILED(hr) || !exists) {
+        return false;
+    }
+    
+    ComPtr<IDWriteFontFamily> family;
+    ComPtr<IDWriteFont> font;
+    hr = fonts->GetFontFamily(index, family.GetAddressOf());
+    if (SUCCEEDED(hr)) {
+        hr = family->GetFirstMatchingFont(DWRITE_FONT_WEIGHT_NORMAL, DWRITE_FONT_STRETCH_NORMAL,
+                                          DWRITE_FONT_STYLE_NORMAL, font.GetAddressOf());
+    }
+    for (UINT32 probe : kArabicProbes) {
+        BOOL has = FALSE;
+        if (FAILED(hr) || FAILED(hr = font->HasCharacter(probe, &has)) || !has) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Choose the family an Arabic format is created with
+ * 
+ * The requested family when it is installed and has Arabic letters,
+ * otherwise the first of kArabicFamilies that does: a face without
+ * them would send every Arabic line to IDWriteTextLayout's font
+ * fallback. When no family qualifies the request is kept. Choices are
+ * remembered for the process, and by a font preload between runs.
+ * 
+ * @param requested Family asked for
+ * @param[out] out Receives the family to use
+ * @return false to use 'requested' as it is (no fonts, or a name too long to keep)
+ */
+bool resolve_arabic_family(const wchar_t* requested, wchar_t (&out)[kFamilyNameMax]) {
+    size_t length = std::wcslen(requested);
+    dwrite_load_fonts();
+    IDWriteFontCollection* fonts = g_dwrite.system_fonts.Get();
+    if (!fonts || length >= kFamilyNameMax) {
+        return false;
+    }
+    
+    std::lock_guard<std::mutex> lock(g_dwrite.fonts_mutex);
+    for (uint32_t i = 0; i < g_dwrite.family_count; i++) {
+        if (std::wcscmp(g_dwrite.families[i].requested, requested) == 0) {
+            std::wmemcpy(out, g_dwrite.families[i].resolved, kFamilyNameMax);
+            return true;
+        }
+    }
+    
+    QALAM_TRACE_BEGIN(span, QALAM_TRACE_STARTUP, "resolve_arabic_family");
+    const wchar_t* resolved = requested;
+    if (!family_has_arabic(fonts, requested)) {
+        for (const wchar_t* candidate : kArabicFamilies) {
+            if (std::wcscmp(candidate, requested) != 0 && family_has_arabic(fonts, candidate)) {
+                resolved = candidate;
+                break;
+            }
+        }
+    }
+    QALAM_TRACE_END(span);
+    
+    std::wmemset(out, 0, kFamilyNameMax);
+    std::wmemcpy(out, resolved, std::wcslen(resolved));
+    if (g_dwrite.family_count < kFamilyResolutionMax) {
+        FamilyResolution* entry = &g_dwrite.families[g_dwrite.family_count++];
+        std::wmemset(entry->requested, 0, kFamilyNameMax);
+        std::wmemcpy(entry->requested, requested, length);
+        std::wmemcpy(entry->resolved, out, kFamilyNameMax);
+        g_dwrite.families_dirty = true;
+    }
+    return true;
+}
+
+/**
+ * @brief Take family choices from a cache file written by an earlier run
+ * 
+ * Choices already made in this process win. The file is ignored when
+ * the number of installed families has changed since it was written:
+ * a font was installed or removed and the choices may be stale.
+ * 
+ * Called with fonts_mutex held, after dwrite_load_fonts().
+ */
+void family_cache_read(const wchar_t* path) {
+    IDWriteFontCollection* fonts = g_dwrite.system_fonts.Get();
+    HANDLE file = fonts ? CreateFileW(path, GENERIC_READ, FILE_SHARE_READ, nullptr,
+                                      OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr)
+                        : INVALID_HANDLE_VALUE;
+    if (file == INVALID_HANDLE_VALUE) {
+        // Written once this run's choices are made
+        g_dwrite.families_dirty = true;
+        return;
+    }
+    
+    FamilyCacheHeader header = {};
+    FamilyResolution entries[kFamilyResolutionMax];
+    LARGE_INTEGER size = {};
+    DWORD read = 0;
+    bool valid = GetFileSizeEx(file, &size) &&
+                 ReadFile(file, &header, sizeof(header), &read, nullptr) &&
+                 read == sizeof(header) && header.magic == kFamilyCacheMagic &&
+                 header.version == kFamilyCacheVersion &&
+                 header.font_count == fonts->GetFontFamilyCount() &&
+                 header.entry_count <= kFamilyResolutionMax &&
+                 size.QuadPart == static_cast<LONGLONG>(
+                     sizeof(header) + header.entry_count * sizeof(FamilyResolution));
+    DWORD entry_bytes = valid ? header.entry_count * sizeof(FamilyResolution) : 0;
+    valid = valid && (entry_bytes == 0 ||
+                      (ReadFile(file, entries, entry_bytes, &read, nullptr) &&
+                       read == entry_bytes));
+    CloseHandle(file);
+    if (!valid) {
+        g_dwrite.families_dirty = true;
+        return;
+    }
+    
+    for (uint32_t i = 0; i < header.entry_count; i++) {
+        FamilyResolution* entry = &entries[i];
+        entry->requested[kFamilyNameMax - 1] = L'\0';
+        entry->resolved[kFamilyNameMax - 1] = L'\0';
+        
+        bool known = false;
+        for (uint32_t j = 0; j < g_dwrite.family_count && !known; j++) {
+            known = std::wcscmp(g_dwrite.families[j].requested, entry->requested) == 0;
+        }
+        if (!known && g_dwrite.family_count < kFamilyResolutionMax) {
+            g_dwrite.families[g_dwrite.family_count++] = *entry;
+        }
+    }
+}
+
+/**
+ * @brief Write this process's family choices to a cache file
+ * 
+ * Called with fonts_mutex held, after dwrite_load_fonts().
+ */
+void family_cache_write(const wchar_t* path) {
+    IDWriteFontCollection* fonts = g_dwrite.system_fonts.Get();
+    if (!fonts) {
+        return;
+    }
+    
+    FamilyCacheHeader header = { kFamilyCacheMagic, kFamilyCacheVersion,
+                                 fonts->GetFontFamilyCount(), g_dwrite.family_count };
+    DWORD entry_bytes = g_dwrite.family_count * sizeof(FamilyResolution);
+    HANDLE file = CreateFileW(path, GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS,
+                              FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        return;
+    }
+    
+    DWORD written = 0;
+    bool ok = WriteFile(file, &header, sizeof(header), &written, nullptr) &&
+              written == sizeof(header) &&
+              (entry_bytes == 0 ||
+               (WriteFile(file, g_dwrite.families, entry_bytes, &written, nullptr) &&
+                written == entry_bytes));
+    HRESULT hr = ok ? S_OK : HRESULT_FROM_WIN32(GetLastError());
+    CloseHandle(file);
+    if (ok) {
+        g_dwrite.families_dirty = false;
+    } else {
+        // A short file fails its size check and is read as no cache
+        log_error(hr, "family_cache_write", "Failed to write font family cache");
+    }
+}
+
+/**
+ * @brief Shape one run with the text analyzer
+ * 
+ * @return S_OK with *out_run set, S_FALSE if the font has no glyph for
+ *         part of the run (IDWriteTextLayout would fall back to another
+ *         font), or an error
+ */
+HRESULT shape_run(QalamDWriteTextFormat* format, const wchar_t* text, uint32_t length,
+                  const DWRITE_SCRIPT_ANALYSIS& script, bool is_rtl, ShapedRun** out_run) {
+    *out_run = nullptr;
+    
+    auto* run = layout_new<ShapedRun>();
+    FrameScratch scratch;
+    auto* text_props = scratch.array<DWRITE_SHAPING_TEXT_PROPERTIES>(length);
+    DWRITE_SHAPING_GLYPH_PROPERTIES* glyph_props = nullptr;
+    if (!run || !text_props) {
+        layout_delete(run);
+        return E_OUTOFMEMORY;
+    }
+    run->text = layout_array<wchar_t>(length);
+    run->cluster_map = layout_array<uint16_t>(length);
+    
+    // Arabic rarely needs more glyphs than characters; grow if it does
+    UINT32 max_glyphs = length * 3 / 2 + 16;
+    UINT32 glyph_count = 0;
+    HRESULT hr = run->text && run->cluster_map ? E_NOT_SUFFICIENT_BUFFER : E_OUTOFMEMORY;
+    while (hr == E_NOT_SUFFICIENT_BUFFER) {
+        layout_free(run->glyphs);
+        run->glyphs = layout_array<uint16_t>(max_glyphs);
+        glyph_props = scratch.array<DWRITE_SHAPING_GLYPH_PROPERTIES>(max_glyphs);
+        if (!run->glyphs || !glyph_props) {
+            hr = E_OUTOFMEMORY;
+            break;
+        }
+        hr = g_dwrite.text_analyzer->GetGlyphs(
+            text, length, format->font_face.Get(), FALSE, is_rtl ? TRUE : FALSE, &script,
+            format->locale, nullptr, nullptr, nullptr, 0, max_glyphs, run->cluster_map,
+            text_props, run->glyphs, glyph_props, &glyph_count);
+        max_glyphs *= 2;
+    }
+    
+    for (UINT32 i = 0; SUCCEEDED(hr) && i < glyph_count; i++) {
+        if (run->glyphs[i] == 0) {
+            hr = S_FALSE;
+        }
+    }
+    
+    if (hr == S_OK) {
+        run->advances = layout_array<float>(glyph_count ? glyph_count : 1);
+        run->offsets = layout_array<DWRITE_GLYPH_OFFSET>(glyph_count ? glyph_count : 1);
+        hr = run->advances && run->offsets ? S_OK : E_OUTOFMEMORY;
+    }
+    if (hr == S_OK) {
+        hr = g_dwrite.text_analyzer->GetGlyphPlacements(
+            text, run->cluster_map, text_props, length, run->glyphs, glyph_props,
+            glyph_count, format->font_face.Get(), format->format->GetFontSize(), FALSE,
+            is_rtl ? TRUE : FALSE, &script, format->locale, nullptr, nullptr, 0,
+            run->advances, run->offsets);
+    }
+    if (hr != S_OK) {
+        run_free(run);
+        return hr;
+    }
+    
+    std::memcpy(run->text, text, length * sizeof(wchar_t));
+    run->format = format;
+    run->script = script;
+    run->is_rtl = is_rtl;
+    run->text_length = length;
+    run->glyph_count = glyph_count;
+    for (UINT32 i = 0; i < glyph_count; i++) {
+        run->width += run->advances[i];
+    }
+    run->bytes = sizeof(ShapedRun) + length * (sizeof(wchar_t) + sizeof(uint16_t)) +
+                 glyph_count * (sizeof(uint16_t) + sizeof(float) + sizeof(DWRITE_GLYPH_OFFSET));
+    
+    *out_run = run;
+    return S_OK;
+}
+
+/**
+ * @brief Get a shaped run from the cache, shaping it on a miss
+ * 
+ * The caller holds the returned run until cache_release_run().
+ */
+HRESULT cache_get_run(QalamDWriteLayoutCache* cache, QalamDWriteTextFormat* format,
+                      const wchar_t* text, uint32_t length, const DWRITE_SCRIPT_ANALYSIS& script,
+                      bool is_rtl, ShapedRun** out_run) {
+    uint64_t hash = hash_run(text, length, format, script, is_rtl);
+    
+    ShapedRun* run = cache->run_buckets[hash & (cache->run_bucket_count - 1)];
+    for (; run; run = run->hash_next) {
+        if (run->hash == hash && run->format == format && run->is_rtl == is_rtl &&
+            run->script.script == script.script && run->script.shapes == script.shapes &&
+            run->text_length == length &&
+            std::memcmp(run->text, text, length * sizeof(wchar_t)) == 0) {
+            run->refs++;
+            cache->runs_reused++;
+            *out_run = run;
+            return S_OK;
+        }
+    }
+    
+    HRESULT hr = shape_run(format, text, length, script, is_rtl, &run);
+    if (hr != S_OK) {
+        return hr;
+    }
+    
+    run->hash = hash;
+    run->refs = 1;
+    ShapedRun** bucket = &cache->run_buckets[hash & (cache->run_bucket_count - 1)];
+    run->hash_next = *bucket;
+    *bucket = run;
+    cache->run_count++;
+    cache->bytes_used += run->bytes;
+    cache->runs_shaped++;
+    cache_grow_runs(cache);
+    
+    *out_run = run;
+    return S_OK;
+}
+
+/**
+ * @brief Check whether a long run may be split before a character
+ * 
+ * Splits go after a space and never before a combining mark, so they
+ * cut neither a cluster nor a joining context.
+ */
+inline bool is_run_split_point(const wchar_t* text, uint32_t position) {
+    wchar_t c = text[position];
+    return text[position - 1] == L' ' && c != L' ' &&
+           !(c >= 0x0300 && c <= 0x036F) && !(c >= 0x064B && c <= 0x065F) && c != 0x0670;
+}
+
+/**
+ * @brief Find where the run starting at 'start' ends
+ */
+uint32_t run_end(const wchar_t* text, uint32_t length, const DWRITE_SCRIPT_ANALYSIS* scripts,
+                 const uint8_t* levels, uint32_t start) {
+    uint32_t end = start + 1;
+    while (end < length && scripts[end].script == scripts[start].script &&
+           scripts[end].shapes == scripts[start].shapes && levels[end] == levels[start] &&
+           !(end - start >= kShapedRunSplitLength && is_run_split_point(text, end))) {
+        end++;
+    }
+    return end;
+}
+
+/**
+ * @brief Put runs in visual order (rule L2 of the Unicode bidi algorithm)
+ * 
+ * From the highest level down to the lowest odd level, every sequence
+ * of runs at that level or above is reversed.
+ */
+void reorder_runs(PlacedRun* runs, uint32_t count) {
+    uint8_t highest = 0;
+    uint8_t lowest = UINT8_MAX;
+    for (uint32_t i = 0; i < count; i++) {
+        highest = runs[i].bidi_level > highest ? runs[i].bidi_level : highest;
+        lowest = runs[i].bidi_level < lowest ? runs[i].bidi_level : lowest;
+    }
+    
+    for (int level = highest; level >= (lowest | 1); level--) {
+        uint32_t i = 0;
+        while (i < count) {
+            if (runs[i].bidi_level < level) {
+                i++;
+                continue;
+            }
+            uint32_t end = i;
+            while (end < count && runs[end].bidi_level >= level) {
+                end++;
+            }
+            for (uint32_t a = i, b = end - 1; a < b; a++, b--) {
+                PlacedRun swap = runs[a];
+                runs[a] = runs[b];
+                runs[b] = swap;
+            }
+            i = end;
+        }
+    }
+}
+
+/**
+ * @brief Lay a single line out from shaped runs
+ * 
+ * Itemizes the text by script and bidi level, takes each run from the
+ * cache's run table (shaping only the runs it does not hold yet) and
+ * places the runs in visual order. An edit therefore reshapes only the
+ * runs whose text it changed.
+ * 
+ * @return S_OK with *out_layout set, S_FALSE if the text needs
+ *         IDWriteTextLayout (control characters such as tabs, glyphs
+ *         missing from the font, wrapping, very long runs), or an error
+ */
+HRESULT cache_shape_layout(QalamDWriteLayoutCache* cache, const wchar_t* text, uint32_t length,
+                           const QalamDWriteLayoutKey* key, QalamDWriteTextLayout** out_layout) {
+    *out_layout = nullptr;
+    
+    QalamDWriteTextFormat* format = key->format;
+    if (!dwrite_text_analyzer() || !format_font_face(format)) {
+        return S_FALSE;
+    }
+    for (uint32_t i = 0; i < length; i++) {
+        if (text[i] < 0x20 || text[i] == 0x7F) {
+            return S_FALSE;
+        }
+    }
+    
+    FrameScratch scratch;
+    auto* scripts = scratch.array<DWRITE_SCRIPT_ANALYSIS>(length ? length : 1, true);
+    auto* levels = scratch.array<uint8_t>(length ? length : 1);
+    auto* layout = layout_new<QalamDWriteTextLayout>();
+    if (!scripts || !levels || !layout) {
+        layout_delete(layout);
+        return E_OUTOFMEMORY;
+    }
+    std::memset(levels, format->is_rtl ? 1 : 0, length ? length : 1);
+    
+    HRESULT hr = S_OK;
+    if (length > 0) {
+        LineAnalysis analysis(text, length, format->locale, format->is_rtl, scripts, levels);
+        hr = g_dwrite.text_analyzer->AnalyzeScript(&analysis, 0, length, &analysis);
+        if (SUCCEEDED(hr)) {
+            hr = g_dwrite.text_analyzer->AnalyzeBidi(&analysis, 0, length, &analysis);
+        }
+    }
+    
+    uint32_t run_count = 0;
+    for (uint32_t start = 0; SUCCEEDED(hr) && start < length; run_count++) {
+        start = run_end(text, length, scripts, levels, start);
+    }
+    if (SUCCEEDED(hr)) {
+        layout->runs = layout_array<PlacedRun>(run_count ? run_count : 1);
+        hr = layout->runs ? S_OK : E_OUTOFMEMORY;
+    }
+    
+    for (uint32_t start = 0; hr == S_OK && start < length;) {
+        uint32_t end = run_end(text, length, scripts, levels, start);
+        ShapedRun* run = nullptr;
+        hr = end - start > kShapedRunMaxLength ? S_FALSE :
+             cache_get_run(cache, format, text + start, end - start, scripts[start],
+                           (levels[start] & 1) != 0, &run);
+        if (hr == S_OK) {
+            layout->runs[layout->run_count++] = { run, start, levels[start], 0.0f };
+        }
+        start = end;
+    }
+    
+    if (hr == S_OK) {
+        reorder_runs(layout->runs, layout->run_count);
+        for (uint32_t i = 0; i < layout->run_count; i++) {
+            layout->runs[i].x = layout->width;
+            layout->width += layout->runs[i].run->width;
+        }
+        if (layout->width > key->max_width &&
+            format->format->GetWordWrapping() != DWRITE_WORD_WRAPPING_NO_WRAP) {
+            hr = S_FALSE;
+        }
+    }
+    
+    if (hr != S_OK) {
+        cache_layout_free(cache, layout);
+        return hr;
+    }
+    
+    // Alignment follows the reading direction, as in IDWriteTextLayout
+    float free_space = key->max_width - layout->width;
+    switch (format->format->GetTextAlignment()) {
+        case DWRITE_TEXT_ALIGNMENT_TRAILING:
+            layout->origin_x = format->is_rtl ? 0.0f : free_space;
+            break;
+        case DWRITE_TEXT_ALIGNMENT_CENTER:
+            layout->origin_x = free_space / 2.0f;
+            break;
+        default:
+            layout->origin_x = format->is_rtl ? free_space : 0.0f;
+            break;
+    }
+    
+    const DWRITE_FONT_METRICS& metrics = format->font_metrics;
+    float scale = format->format->GetFontSize() / (metrics.designUnitsPerEm ? metrics.designUnitsPerEm : 1);
+    layout->height = (metrics.ascent + metrics.descent + metrics.lineGap) * scale;
+    layout->baseline = metrics.ascent * scale;
+    layout->is_rtl = format->is_rtl;
+    layout->shaped = true;
+    layout->format = format;
+    layout->text_length = length;
+    layout->max_width = key->max_width;
+    layout->max_height = key->max_height;
+    
+    *out_layout = layout;
+    return S_OK;
+}
+
+/**
+ * @brief Create an IDWriteTextLayout, configured for RTL formats
+ */
+HRESULT create_dwrite_layout(const wchar_t* text, uint32_t text_length,
+                             QalamDWriteTextFormat* format, float max_width, float max_height,
+                             IDWriteTextLayout** out_layout) {
+    QALAM_TRACE_BEGIN(span, QALAM_TRACE_LAYOUT, "CreateTextLayout");
+    HRESULT hr = g_dwrite.dwrite_factory->CreateTextLayout(
+        text,
+        text_length,
+        format->format.Get(),
+        max_width,
+        max_height,
+        out_layout
+    );
+    
+    // Configure RTL on layout if format is RTL
+    if (SUCCEEDED(hr) && format->is_rtl) {
+        (*out_layout)->SetReadingDirection(DWRITE_READING_DIRECTION_RIGHT_TO_LEFT);
+        (*out_layout)->SetFlowDirection(DWRITE_FLOW_DIRECTION_TOP_TO_BOTTOM);
+    }
+    
+    QALAM_TRACE_COUNTER(QALAM_TRACE_LAYOUT, "layout_chars", text_length);
+    QALAM_TRACE_END(span);
+    return hr;
+}
+
+/**
+ * @brief Get a layout's IDWriteTextLayout, creating it for shaped layouts
+ * 
+ * Shaped layouts draw without one; hit testing still goes through it.
+ */
+HRESULT layout_dwrite(QalamDWriteTextLayout* layout, IDWriteTextLayout** out_layout) {
+    if (!layout->layout && layout->shaped) {
+        HRESULT hr = create_dwrite_layout(layout->text, layout->text_length, layout->format,
+                                          layout->max_width, layout->max_height,
+                                          layout->layout.GetAddressOf());
+        if (FAILED(hr)) {
+            return hr;
+        }
+    }
+    
+    *out_layout = layout->layout.Get();
+    return S_OK;
+}
+
+/**
+ * @brief Brush of the style range at a text position, or 'fallback'
+ */
+QalamDWriteBrush* style_brush_at(const QalamDWriteTextLayout* layout, uint32_t position,
+                                 QalamDWriteBrush* fallback) {
+    const QalamStyleRange* begin = layout->styles;
+    const QalamStyleRange* end = begin + layout->style_count;
+    const QalamStyleRange* range = std::upper_bound(
+        begin, end, position,
+        [](uint32_t p, const QalamStyleRange& r) { return p < r.start; });
+    if (range == begin) {
+        return fallback;
+    }
+    
+    range--;
+    if (position - range->start >= range->length || range->style >= layout->style_brush_count) {
+        return fallback;
+    }
+    QalamDWriteBrush* brush = layout->style_brushes[range->style];
+    return brush && brush->brush ? brush : fallback;
+}
+
+/**
+ * @brief Draw a shaped run in pieces of whole clusters, one per brush
+ *
+ * The glyphs are the run's own, so styling never reshapes it. Right-to-left
+ * pieces are drawn leftwards from where the previous piece ended.
+ */
+void draw_styled_run(ID2D1RenderTarget* target, const QalamDWriteTextLayout* layout,
+                     const PlacedRun& placed, DWRITE_GLYPH_RUN* glyph_run, float left,
+                     float baseline, QalamDWriteBrush* brush) {
+    const ShapedRun* run = placed.run;
+    float advance = 0.0f;
+    
+    for (uint32_t i = 0; i < run->text_length;) {
+        QalamDWriteBrush* piece_brush = style_brush_at(layout, placed.text_position + i, brush);
+        uint32_t end = i + 1;
+        while (end < run->text_length &&
+               (run->cluster_map[end] == run->cluster_map[end - 1] ||
+                style_brush_at(layout, placed.text_position + end, brush) == piece_brush)) {
+            end++;
+        }
+    
+        uint32_t glyph_start = run->cluster_map[i];
+        uint32_t glyph_end = end < run->text_length ? run->cluster_map[end] : run->glyph_count;
+        float width = 0.0f;
+        for (uint32_t g = glyph_start; g < glyph_end; g++) {
+            width += run->advances[g];
+        }
+    
+        if (glyph_end > glyph_start) {
+            glyph_run->glyphCount = glyph_end - glyph_start;
+            glyph_run->glyphIndices = run->glyphs + glyph_start;
+            glyph_run->glyphAdvances = run->advances + glyph_start;
+            glyph_run->glyphOffsets = run->offsets + glyph_start;
+            float origin = run->is_rtl ? left + run->width - advance : left + advance;
+            target->DrawGlyphRun(D2D1::Point2F(origin, baseline), glyph_run,
+                                 piece_brush->brush.Get(), DWRITE_MEASURING_MODE_NATURAL);
+        }
+        advance += width;
+        i = end;
+    }
+}
+
+/**
+ * @brief Set an IDWriteTextLayout's drawing effects to its style brushes
+ *
+ * Brushes are recreated as new objects after a device loss, so the
+ * effects are set again when the target's device generation moves on.
+ */
+void layout_apply_effects(QalamDWriteTextLayout* layout, uint32_t generation) {
+    IDWriteTextLayout* dwrite_layout = layout->layout.Get();
+    if (layout->has_effects) {
+        dwrite_layout->SetDrawingEffect(nullptr, DWRITE_TEXT_RANGE{ 0, layout->text_length });
+    }
+    
+    layout->has_effects = false;
+    for (uint32_t i = 0; i < layout->style_count; i++) {
+        const QalamStyleRange& range = layout->styles[i];
+        QalamDWriteBrush* brush = range.style < layout->style_brush_count
+            ? layout->style_brushes[range.style] : nullptr;
+        if (brush && brush->brush) {
+            dwrite_layout->SetDrawingEffect(brush->brush.Get(),
+                                            DWRITE_TEXT_RANGE{ range.start, range.length });
+            layout->has_effects = true;
+        }
+    }
+    
+    layout->effects_generation = generation;
+    layout->effects_dirty = false;
+}
+
+/**
+ * @brief Collect a shaped layout's clusters in visual order
+ */
+HRESULT shaped_clusters(const QalamDWriteTextLayout* layout, CaretCluster** out_clusters,
+                        uint32_t* out_count) {
+    uint32_t count = 0;
+    for (uint32_t r = 0; r < layout->run_count; r++) {
+        const ShapedRun* run = layout->runs[r].run;
+        for (uint32_t i = 0; i < run->text_length; i++) {
+            if (i == 0 || run->cluster_map[i] != run->cluster_map[i - 1]) {
+                count++;
+            }
+        }
+    }
+    
+    auto* clusters = layout_array<CaretCluster>(count ? count : 1);
+    if (!clusters) {
+        return E_OUTOFMEMORY;
+    }
+    
+    uint32_t n = 0;
+    for (uint32_t r = 0; r < layout->run_count; r++) {
+        const PlacedRun& placed = layout->runs[r];
+        const ShapedRun* run = placed.run;
+        float run_left = layout->origin_x + placed.x;
+        float advance = 0.0f;
+        uint32_t first = n;
+        
+        for (uint32_t i = 0; i < run->text_length;) {
+            uint32_t end = i + 1;
+            while (end < run->text_length && run->cluster_map[end] == run->cluster_map[i]) {
+                end++;
+            }
+            uint32_t glyph_end = end < run->text_length ? run->cluster_map[end] : run->glyph_count;
+            float width = 0.0f;
+            for (uint32_t g = run->cluster_map[i]; g < glyph_end; g++) {
+                width += run->advances[g];
+            }
+            
+            // Right-to-left glyphs advance leftwards from the run's right edge
+            CaretCluster& cluster = clusters[n++];
+            cluster.position = placed.text_position + i;
+            cluster.length = end - i;
+            cluster.is_rtl = run->is_rtl;
+            cluster.left = run->is_rtl ? run_left + run->width - advance - width : run_left + advance;
+            cluster.right = cluster.left + width;
+            advance += width;
+            i = end;
+        }
+        
+        if (run->is_rtl) {
+            std::reverse(clusters + first, clusters + n);
+        }
+    }
+    
+    *out_clusters = clusters;
+    *out_count = n;
+    return S_OK;
+}
+
+/**
+ * @brief Collect an IDWriteTextLayout's clusters in visual order
+ * 
+ * Hit tests every cluster once.
+ * 
+ * @param[out] out_origin Caret x of an empty layout
+ */
+HRESULT text_layout_clusters(QalamDWriteTextLayout* layout, CaretCluster** out_clusters,
+                             uint32_t* out_count, float* out_origin) {
+    IDWriteTextLayout* dwrite_layout = nullptr;
+    DWRITE_TEXT_METRICS text_metrics;
+    HRESULT hr = layout_dwrite(layout, &dwrite_layout);
+    if (SUCCEEDED(hr)) {
+        hr = dwrite_layout->GetMetrics(&text_metrics);
+    }
+    if (SUCCEEDED(hr) && text_metrics.lineCount > 1) {
+        return E_INVALIDARG;
+    }
+    
+    UINT32 count = 0;
+    if (SUCCEEDED(hr)) {
+        hr = dwrite_layout->GetClusterMetrics(nullptr, 0, &count);
+        hr = hr == E_NOT_SUFFICIENT_BUFFER ? S_OK : hr;
+    }
+    if (FAILED(hr)) {
+        return hr;
+    }
+    
+    FrameScratch scratch;
+    auto* metrics = scratch.array<DWRITE_CLUSTER_METRICS>(count ? count : 1);
+    auto* clusters = layout_array<CaretCluster>(count ? count : 1);
+    if (!metrics || !clusters) {
+        layout_free(clusters);
+        return E_OUTOFMEMORY;
+    }
+    
+    float x = 0.0f;
+    float y = 0.0f;
+    DWRITE_HIT_TEST_METRICS hit;
+    hr = dwrite_layout->HitTestTextPosition(0, FALSE, &x, &y, &hit);
+    if (SUCCEEDED(hr) && count > 0) {
+        hr = dwrite_layout->GetClusterMetrics(metrics, count, &count);
+    }
+    
+    uint32_t position = 0;
+    for (UINT32 i = 0; SUCCEEDED(hr) && i < count; i++) {
+        hr = dwrite_layout->HitTestTextPosition(position, FALSE, &x, &y, &hit);
+        clusters[i].position = position;
+        clusters[i].length = metrics[i].length;
+        clusters[i].left = hit.left;
+        clusters[i].right = hit.left + hit.width;
+        clusters[i].is_rtl = (hit.bidiLevel & 1) != 0;
+        position += metrics[i].length;
+    }
+    if (FAILED(hr)) {
+        layout_free(clusters);
+        return hr;
+    }
+    
+    std::stable_sort(clusters, clusters + count, [](const CaretCluster& a, const CaretCluster& b) {
+        return a.left < b.left;
+    });
+    
+    *out_clusters = clusters;
+    *out_count = count;
+    *out_origin = count == 0 ? x : 0.0f;
+    return S_OK;
+}
+
+/**
+ * @brief Pair the k-th cluster edge from the left with a text position
+ * 
+ * The caret of a position stands at the leading edge of the cluster
+ * starting there, so an edge belongs to the cluster on its right when
+ * that one is left-to-right, or to the cluster on its left when that
+ * one is right-to-left. Where a left-to-right cluster meets a
+ * right-to-left one only trailing edges meet; the position after the
+ * left cluster is used.
+ */
+QalamDWriteCaretStop visual_stop(const CaretCluster* clusters, uint32_t count, uint32_t k) {
+    const CaretCluster* left = k > 0 ? &clusters[k - 1] : nullptr;
+    const CaretCluster* right = k < count ? &clusters[k] : nullptr;
+    float x = right ? right->left : left->right;
+    
+    if (right && !right->is_rtl) {
+        return { right->position, x };
+    }
+    if (left && left->is_rtl) {
+        return { left->position, x };
+    }
+    if (left) {
+        return { left->position + left->length, x };
+    }
+    return { right->position + right->length, x };
+}
+
+/**
+ * @brief Build a layout's caret table if it has none yet
+ */
+HRESULT layout_build_carets(QalamDWriteTextLayout* layout) {
+    if (layout->caret_stops) {
+        return S_OK;
+    }
+    
+    CaretCluster* clusters = nullptr;
+    uint32_t count = 0;
+    float origin = layout->origin_x;
+    HRESULT hr = layout->shaped ? shaped_clusters(layout, &clusters, &count)
+                                : text_layout_clusters(layout, &clusters, &count, &origin);
+    if (FAILED(hr)) {
+        return hr;
+    }
+    
+    auto* stops = layout_array<QalamDWriteCaretStop>(2 * (count + 1));
+    FrameScratch scratch;
+    uint32_t* order = scratch.array<uint32_t>(count ? count : 1);
+    if (!stops || !order) {
+        layout_free(clusters);
+        layout_free(stops);
+        return E_OUTOFMEMORY;
+    }
+    
+    // Logical stops: the leading edge of each cluster in text order, then
+    // the trailing edge of the last one
+    for (uint32_t i = 0; i < count; i++) {
+        order[i] = i;
+    }
+    std::sort(order, order + count, [clusters](uint32_t a, uint32_t b) {
+        return clusters[a].position < clusters[b].position;
+    });
+    for (uint32_t i = 0; i < count; i++) {
+        const CaretCluster& cluster = clusters[order[i]];
+        stops[i] = { cluster.position, cluster.is_rtl ? cluster.right : cluster.left };
+    }
+    if (count > 0) {
+        const CaretCluster& last = clusters[order[count - 1]];
+        stops[count] = { last.position + last.length, last.is_rtl ? last.left : last.right };
+    } else {
+        stops[0] = { 0, origin };
+    }
+    
+    // Visual stops: every cluster edge from left to right
+    QalamDWriteCaretStop* visual = stops + count + 1;
+    for (uint32_t k = 0; k <= count; k++) {
+        visual[k] = count > 0 ? visual_stop(clusters, count, k) : stops[0];
+    }
+    
+    layout->clusters = clusters;
+    layout->caret_stops = stops;
+    layout->cluster_count = count;
+    return S_OK;
+}
+
+/**
+ * @brief Build a layout's caret table, converting failures for the C API
+ */
+QalamResult layout_carets(QalamDWriteTextLayout* layout, const char* function) {
+    HRESULT hr = layout_build_carets(layout);
+    if (FAILED(hr) && hr != E_INVALIDARG) {
+        log_error(hr, function, "Failed to build caret stops");
+    }
+    return hr_to_result(hr);
+}
+
+/**
+ * @brief Find the logical stop of the cluster containing a text position
+ */
+uint32_t logical_stop_index(const QalamDWriteTextLayout* layout, uint32_t text_position) {
+    const QalamDWriteCaretStop* stops = layout->caret_stops;
+    const QalamDWriteCaretStop* end = stops + layout->cluster_count + 1;
+    const QalamDWriteCaretStop* it = std::upper_bound(
+        stops, end, text_position, [](uint32_t position, const QalamDWriteCaretStop& stop) {
+            return position < stop.text_position;
+        });
+    return it == stops ? 0 : static_cast<uint32_t>(it - stops - 1);
+}
+
+/**
+ * @brief Find the visual stop nearest to an x
+ */
+uint32_t visual_stop_index(const QalamDWriteTextLayout* layout, float x) {
+    const QalamDWriteCaretStop* stops = layout->caret_stops + layout->cluster_count + 1;
+    uint32_t count = layout->cluster_count + 1;
+    const QalamDWriteCaretStop* it = std::lower_bound(
+        stops, stops + count, x, [](const QalamDWriteCaretStop& stop, float value) {
+            return stop.x < value;
+        });
+    
+    uint32_t index = static_cast<uint32_t>(it - stops);
+    if (index == count || (index > 0 && x - stops[index - 1].x < stops[index].x - x)) {
+        index--;
+    }
+    return index;
+}
+
+/** Swap chain buffers: one on screen, one being drawn */
+constexpr UINT kSwapChainBufferCount = 2;
+
+/** Frames the swap chain may queue ahead of the display */
+constexpr UINT kSwapChainMaxLatency = 1;
+
+/**
+ * @brief Check whether an HRESULT means the device has to be recreated
+ */
+inline bool is_device_lost(HRESULT hr) {
+    return hr == D2DERR_RECREATE_TARGET || hr == DXGI_ERROR_DEVICE_REMOVED ||
+           hr == DXGI_ERROR_DEVICE_RESET;
+}
+
+/**
+ * @brief Get the client area of a window in pixels (at least 1x1)
+ */
+D2D1_SIZE_U client_size(HWND hwnd) {
+    RECT rc = {};
+    GetClientRect(hwnd, &rc);
+    D2D1_SIZE_U size = D2D1::SizeU(
+        static_cast<UINT32>(rc.right - rc.left),
+        static_cast<UINT32>(rc.bottom - rc.top)
+    );
+    if (size.width == 0) size.width = 1;
+    if (size.height == 0) size.height = 1;
+    return size;
+}
+
+/**
+ * @brief Point the device context at the swap chain's back buffer
+ */
+HRESULT rt_bind_back_buffer(QalamDWriteRenderTarget* target) {
+    ComPtr<IDXGISurface> surface;
+    HRESULT hr = target->swap_chain->GetBuffer(0, IID_PPV_ARGS(surface.GetAddressOf()));
+    if (FAILED(hr)) {
+        return hr;
+    }
+    
+    float dpi = static_cast<float>(GetDpiForWindow(target->hwnd));
+    if (dpi <= 0.0f) {
+        dpi = 96.0f;
+    }
+    
+    D2D1_BITMAP_PROPERTIES1 props = D2D1::BitmapProperties1(
+        D2D1_BITMAP_OPTIONS_TARGET | D2D1_BITMAP_OPTIONS_CANNOT_DRAW,
+        D2D1::PixelFormat(DXGI_FORMAT_B8G8R8A8_UNORM, D2D1_ALPHA_MODE_IGNORE),
+        dpi, dpi
+    );
+    hr = target->context->CreateBitmapFromDxgiSurface(
+        surface.Get(), &props, target->back_buffer.ReleaseAndGetAddressOf());
+    if (FAILED(hr)) {
+        return hr;
+    }
+    
+    target->context->SetDpi(dpi, dpi);
+    target->context->SetTarget(target->back_buffer.Get());
+    return S_OK;
+}
+
+/**
+ * @brief Get the smallest rect holding two rects
+ */
+RECT rect_union(const RECT& a, const RECT& b) {
+    return { a.left < b.left ? a.left : b.left, a.top < b.top ? a.top : b.top,
+             a.right > b.right ? a.right : b.right, a.bottom > b.bottom ? a.bottom : b.bottom };
+}
+
+/**
+ * @brief Check whether two rects overlap or share an edge
+ */
+bool rects_touch(const RECT& a, const RECT& b) {
+    return a.left <= b.right && b.left <= a.right && a.top <= b.bottom && b.top <= a.bottom;
+}
+
+/**
+ * @brief Get the area of a rect in pixels
+ */
+int64_t rect_area(const RECT& rect) {
+    return static_cast<int64_t>(rect.right - rect.left) * (rect.bottom - rect.top);
+}
+
+/**
+ * @brief Create the flip-model backend: D3D11 device, swap chain, D2D context
+ * 
+ * Uses DXGI_SWAP_EFFECT_FLIP_SEQUENTIAL rather than FLIP_DISCARD because
+ * the back buffer has to keep the previous frame for dirty-rect presents.
+ */
+HRESULT rt_create_flip(QalamDWriteRenderTarget* target) {
+    ComPtr<ID2D1Factory1> factory1;
+    HRESULT hr = g_dwrite.d2d_factory.As(&factory1);
+    if (FAILED(hr)) {
+        return hr;
+    }
+    
+    // BGRA support is required for Direct2D interop; fall back to WARP
+    // where no hardware device is available (e.g. some remote sessions)
+    static const D3D_FEATURE_LEVEL levels[] = {
+        D3D_FEATURE_LEVEL_11_1, D3D_FEATURE_LEVEL_11_0,
+        D3D_FEATURE_LEVEL_10_1, D3D_FEATURE_LEVEL_10_0,
+        D3D_FEATURE_LEVEL_9_3, D3D_FEATURE_LEVEL_9_2, D3D_FEATURE_LEVEL_9_1
+    };
+    const UINT level_count = static_cast<UINT>(sizeof(levels) / sizeof(levels[0]));
+    hr = D3D11CreateDevice(nullptr, D3D_DRIVER_TYPE_HARDWARE, nullptr,
+                           D3D11_CREATE_DEVICE_BGRA_SUPPORT, levels, level_count,
+                           D3D11_SDK_VERSION, target->d3d_device.ReleaseAndGetAddressOf(),
+                           nullptr, nullptr);
+    if (FAILED(hr)) {
+        hr = D3D11CreateDevice(nullptr, D3D_DRIVER_TYPE_WARP, nullptr,
+                               D3D11_CREATE_DEVICE_BGRA_SUPPORT, levels, level_count,
+                               D3D11_SDK_VERSION, target->d3d_device.ReleaseAndGetAddressOf(),
+                               nullptr, nullptr);
+    }
+    if (FAILED(hr)) {
+        return hr;
+    }
+    
+    ComPtr<IDXGIDevice1> dxgi_device;
+    ComPtr<IDXGIAdapter> adapter;
+    ComPtr<IDXGIFactory2> dxgi_factory;
+    hr = target->d3d_device.As(&dxgi_device);
+    if (SUCCEEDED(hr)) {
+        hr = dxgi_device->GetAdapter(adapter.GetAddressOf());
+    }
+    if (SUCCEEDED(hr)) {
+        hr = adapter->GetParent(IID_PPV_ARGS(dxgi_factory.GetAddressOf()));
+    }
+    if (FAILED(hr)) {
+        return hr;
+    }
+    
+    D2D1_SIZE_U size = client_size(target->hwnd);
+    DXGI_SWAP_CHAIN_DESC1 desc = {};
+    desc.Width = size.width;
+    desc.Height = size.height;
+    desc.Format = DXGI_FORMAT_B8G8R8A8_UNORM;
+    desc.SampleDesc.Count = 1;
+    desc.BufferUsage = DXGI_USAGE_RENDER_TARGET_OUTPUT;
+    desc.BufferCount = kSwapChainBufferCount;
+    desc.Scaling = DXGI_SCALING_NONE;
+    desc.SwapEffect = DXGI_SWAP_EFFECT_FLIP_SEQUENTIAL;
+    desc.AlphaMode = DXGI_ALPHA_MODE_IGNORE;
+    desc.Flags = DXGI_SWAP_CHAIN_FLAG_FRAME_LATENCY_WAITABLE_OBJECT;
+    
+    hr = dxgi_factory->CreateSwapChainForHwnd(
+        target->d3d_device.Get(), target->hwnd, &desc, nullptr, nullptr,
+        target->swap_chain.ReleaseAndGetAddressOf());
+    if (FAILED(hr)) {
+        return hr;
+    }
+    dxgi_factory->MakeWindowAssociation(target->hwnd, DXGI_MWA_NO_ALT_ENTER);
+    
+    // Queue at most one frame, and let the caller wait until it may draw
+    ComPtr<IDXGISwapChain2> swap_chain2;
+    hr = target->swap_chain.As(&swap_chain2);
+    if (SUCCEEDED(hr)) {
+        hr = swap_chain2->SetMaximumFrameLatency(kSwapChainMaxLatency);
+    }
+    if (FAILED(hr)) {
+        return hr;
+    }
+    target->frame_waitable = swap_chain2->GetFrameLatencyWaitableObject();
+    
+    ComPtr<ID2D1Device> d2d_device;
+    hr = factory1->CreateDevice(dxgi_device.Get(), d2d_device.GetAddressOf());
+    if (SUCCEEDED(hr)) {
+        hr = d2d_device->CreateDeviceContext(D2D1_DEVICE_CONTEXT_OPTIONS_NONE,
+                                             target->context.ReleaseAndGetAddressOf());
+    }
+    if (SUCCEEDED(hr)) {
+        hr = rt_bind_back_buffer(target);
+    }
+    if (FAILED(hr)) {
+        return hr;
+    }
+    
+    target->target = target->context;
+    return S_OK;
+}
+
+/**
+ * @brief Create the HWND render target backend
+ */
+HRESULT rt_create_hwnd(QalamDWriteRenderTarget* target) {
+    D2D1_RENDER_TARGET_PROPERTIES rt_props = D2D1::RenderTargetProperties(
+        D2D1_RENDER_TARGET_TYPE_DEFAULT,
+        D2D1::PixelFormat(DXGI_FORMAT_B8G8R8A8_UNORM, D2D1_ALPHA_MODE_PREMULTIPLIED),
+        0.0f, 0.0f,  // Default DPI
+        D2D1_RENDER_TARGET_USAGE_NONE,
+        D2D1_FEATURE_LEVEL_DEFAULT
+    );
+    
+    D2D1_HWND_RENDER_TARGET_PROPERTIES hwnd_rt_props = D2D1::HwndRenderTargetProperties(
+        target->hwnd,
+        client_size(target->hwnd),
+        D2D1_PRESENT_OPTIONS_NONE
+    );
+    
+    HRESULT hr = g_dwrite.d2d_factory->CreateHwndRenderTarget(
+        rt_props,
+        hwnd_rt_props,
+        target->hwnd_target.ReleaseAndGetAddressOf()
+    );
+    if (FAILED(hr)) {
+        return hr;
+    }
+    
+    target->target = target->hwnd_target;
+    return S_OK;
+}
+
+/**
+ * @brief Release every device-dependent resource of a target
+ */
+void rt_release(QalamDWriteRenderTarget* target) {
+    if (target->frame_waitable) {
+        CloseHandle(target->frame_waitable);
+        target->frame_waitable = nullptr;
+    }
+    if (target->context) {
+        target->context->SetTarget(nullptr);
+    }
+    target->target.Reset();
+    target->back_buffer.Reset();
+    target->context.Reset();
+    target->swap_chain.Reset();
+    target->d3d_device.Reset();
+    target->hwnd_target.Reset();
+    
+    for (QalamDWriteBrush* brush = target->brushes; brush; brush = brush->next) {
+        brush->brush.Reset();
+    }
+}
+
+/**
+ * @brief Create the target's device resources and recreate its brushes
+ */
+HRESULT rt_create(QalamDWriteRenderTarget* target) {
+    HRESULT hr = rt_create_flip(target);
+    if (FAILED(hr)) {
+        log_error(hr, "qalam_dwrite_render_target_create",
+                  "Flip-model swap chain unavailable, using HWND render target");
+        rt_release(target);
+        hr = rt_create_hwnd(target);
+    }
+    if (FAILED(hr)) {
+        rt_release(target);
+        return hr;
+    }
+    
+    for (QalamDWriteBrush* brush = target->brushes; brush; brush = brush->next) {
+        hr = target->target->CreateSolidColorBrush(brush->color, brush->brush.GetAddressOf());
+        if (FAILED(hr)) {
+            rt_release(target);
+            return hr;
+        }
+    }
+    
+    target->has_dirty = false;
+    target->dirty_count = 0;
+    target->full_present = true;
+    target->device_generation++;
+    return S_OK;
+}
+
+/**
+ * @brief Rebuild a target after device loss
+ * 
+ * The frame that hit the loss is gone, so the window is invalidated
+ * to have it drawn again.
+ */
+HRESULT rt_recover(QalamDWriteRenderTarget* target, HRESULT lost, const char* function) {
+    log_error(lost, function, "Device lost - recreating render target");
+    rt_release(target);
+    HRESULT hr = rt_create(target);
+    if (SUCCEEDED(hr)) {
+        InvalidateRect(target->hwnd, nullptr, FALSE);
+    } else {
+        log_error(hr, function, "Failed to recreate render target");
+    }
+    return hr;
+}
+
+/** Padding around each glyph in the atlas bitmap, in pixels */
+constexpr uint32_t kAtlasPadding = 1;
+
+/** Buckets of a glyph atlas' cluster table */
+constexpr size_t kAtlasClusterBuckets = 1024;
+
+/** Clusters a glyph atlas keeps before it drops them all */
+constexpr size_t kAtlasMaxClusters = 4096;
+
+/** Slots of an atlas table on its first insert */
+constexpr uint32_t kAtlasTableInitialSize = 256;
+
+/** ASCII table entry not looked up yet */
+constexpr uint32_t kAtlasUnresolved = 0xFFFFFFFFu;
+
+/** Character no face of the atlas can draw */
+constexpr uint32_t kAtlasNoGlyph = 0xFFFFFFFEu;
+
+template <typename Value>
+Value* table_find(const AtlasTable<Value>& table, uint32_t key) {
+    if (table.capacity == 0) {
+        return nullptr;
+    }
+    uint32_t mask = table.capacity - 1;
+    for (uint32_t i = static_cast<uint32_t>(hash_mix(key)) & mask;; i = (i + 1) & mask) {
+        if (table.keys[i] == key) {
+            return &table.values[i];
+        }
+        if (table.keys[i] == 0) {
+            return nullptr;
+        }
+    }
+}
+
+/**
+ * @brief Double a table's slots (on allocation failure it keeps its own)
+ */
+template <typename Value>
+bool table_grow(AtlasTable<Value>* table) {
+    uint32_t capacity = table->capacity ? table->capacity * 2 : kAtlasTableInitialSize;
+    auto* keys = layout_array<uint32_t>(capacity, true);
+    auto* values = layout_array<Value>(capacity);
+    if (!keys || !values) {
+        layout_free(keys);
+        layout_free(values);
+        return false;
+    }
+    
+    uint32_t mask = capacity - 1;
+    for (uint32_t i = 0; i < table->capacity; i++) {
+        if (table->keys[i]) {
+            uint32_t j = static_cast<uint32_t>(hash_mix(table->keys[i])) & mask;
+            while (keys[j]) {
+                j = (j + 1) & mask;
+            }
+            keys[j] = table->keys[i];
+            values[j] = table->values[i];
+        }
+    }
+    
+    layout_free(table->keys);
+    layout_free(table->values);
+    table->keys = keys;
+    table->values = values;
+    table->capacity = capacity;
+    return true;
+}
+
+/**
+ * @brief Add a key that is not in the table yet
+ * 
+ * @return false if the table could not grow; the key is then not kept
+ */
+template <typename Value>
+bool table_insert(AtlasTable<Value>* table, uint32_t key, const Value& value) {
+    if ((table->count + 1) * 2 > table->capacity && !table_grow(table)) {
+        return false;
+    }
+    uint32_t mask = table->capacity - 1;
+    uint32_t i = static_cast<uint32_t>(hash_mix(key)) & mask;
+    while (table->keys[i]) {
+        i = (i + 1) & mask;
+    }
+    table->keys[i] = key;
+    table->values[i] = value;
+    table->count++;
+    return true;
+}
+
+template <typename Value>
+void table_clear(AtlasTable<Value>* table) {
+    if (table->keys) {
+        std::memset(table->keys, 0, table->capacity * sizeof(uint32_t));
+    }
+    table->count = 0;
+}
+
+template <typename Value>
+void table_free(AtlasTable<Value>* table) {
+    layout_free(table->keys);
+    layout_free(table->values);
+    *table = AtlasTable<Value>();
+}
+
+/**
+ * @brief Create the format of one style from the format an atlas was given
+ */
+HRESULT atlas_create_style(const QalamDWriteGlyphAtlas* atlas, const QalamDWriteTextFormat* base,
+                           uint32_t style, QalamDWriteTextFormat** out_format) {
+    *out_format = nullptr;
+    
+    IDWriteTextFormat* format = base->format.Get();
+    DWRITE_FONT_WEIGHT weight = format->GetFontWeight();
+    if ((style & QALAM_DWRITE_GLYPH_BOLD) && weight < DWRITE_FONT_WEIGHT_BOLD) {
+        weight = DWRITE_FONT_WEIGHT_BOLD;
+    }
+    DWRITE_FONT_STYLE font_style = (style & QALAM_DWRITE_GLYPH_ITALIC)
+        ? DWRITE_FONT_STYLE_ITALIC : format->GetFontStyle();
+    
+    ComPtr<IDWriteTextFormat> styled;
+    HRESULT hr = g_dwrite.dwrite_factory->CreateTextFormat(
+        atlas->family, atlas->fonts.Get(), weight, font_style, format->GetFontStretch(),
+        atlas->font_size, base->locale, styled.GetAddressOf());
+    if (FAILED(hr)) {
+        return hr;
+    }
+    
+    auto* result = layout_new<QalamDWriteTextFormat>();
+    if (!result) {
+        return E_OUTOFMEMORY;
+    }
+    result->format = std::move(styled);
+    result->locale = base->locale;
+    *out_format = result;
+    return S_OK;
+}
+
+void atlas_set_face(QalamDWriteGlyphAtlas* atlas, uint32_t index, IDWriteFontFace* face) {
+    DWRITE_FONT_METRICS metrics;
+    face->GetMetrics(&metrics);
+    atlas->faces[index].face = face;
+    atlas->faces[index].design_scale = atlas->font_size / metrics.designUnitsPerEm;
+}
+
+/**
+ * @brief Get a fallback face's index, adding the face if it is new
+ * 
+ * @return The index, or kAtlasMaxFaces once the face list is full
+ */
+uint32_t atlas_face_index(QalamDWriteGlyphAtlas* atlas, IDWriteFontFace* face) {
+    for (uint32_t i = 0; i < atlas->face_count; i++) {
+        if (atlas->faces[i].face.Get() == face) {
+            return i;
+        }
+    }
+    if (atlas->face_count == kAtlasMaxFaces) {
+        return kAtlasMaxFaces;
+    }
+    atlas_set_face(atlas, atlas->face_count, face);
+    return atlas->face_count++;
+}
+
+/**
+ * @brief Find the face and glyph a character of a style is drawn with
+ * 
+ * The style's own face first, then the system font fallback. A
+ * character no font has is drawn as the style face's missing glyph.
+ */
+uint32_t atlas_resolve_char(QalamDWriteGlyphAtlas* atlas, uint32_t codepoint, uint32_t style) {
+    IDWriteFontFace* face = atlas->faces[style].face.Get();
+    UINT32 character = codepoint;
+    UINT16 glyph = 0;
+    if (face && SUCCEEDED(face->GetGlyphIndices(&character, 1, &glyph)) && glyph != 0) {
+        return style << 16 | glyph;
+    }
+    
+    if (atlas->fallback) {
+        wchar_t text[2];
+        uint32_t length = 1;
+        if (character >= 0x10000) {
+            text[0] = static_cast<wchar_t>(0xD800 | ((character - 0x10000) >> 10));
+            text[1] = static_cast<wchar_t>(0xDC00 | ((character - 0x10000) & 0x3FF));
+            length = 2;
+        } else {
+            text[0] = static_cast<wchar_t>(character);
+        }
+        
+        IDWriteTextFormat* format = atlas->styles[style]->format.Get();
+        LineAnalysis source(text, length, atlas->styles[style]->locale, false, nullptr, nullptr);
+        UINT32 mapped_length = 0;
+        FLOAT mapped_scale = 1.0f;
+        ComPtr<IDWriteFont> font;
+        ComPtr<IDWriteFontFace> mapped;
+        HRESULT hr = atlas->fallback->MapCharacters(
+            &source, 0, length, atlas->fonts.Get(), atlas->family, format->GetFontWeight(),
+            format->GetFontStyle(), format->GetFontStretch(), &mapped_length,
+            font.GetAddressOf(), &mapped_scale);
+        if (SUCCEEDED(hr) && font) {
+            hr = font->CreateFontFace(mapped.GetAddressOf());
+        }
+        if (SUCCEEDED(hr) && mapped &&
+            SUCCEEDED(mapped->GetGlyphIndices(&character, 1, &glyph)) && glyph != 0) {
+            uint32_t index = atlas_face_index(atlas, mapped.Get());
+            if (index < kAtlasMaxFaces) {
+                return index << 16 | glyph;
+            }
+        }
+    }
+    
+    return face ? style << 16 : kAtlasNoGlyph;
+}
+
+/**
+ * @brief Get the glyph key a character of a style is drawn with
+ * 
+ * @return The key, or 0 if nothing can draw the character
+ */
+uint32_t atlas_char_key(QalamDWriteGlyphAtlas* atlas, uint32_t codepoint, uint32_t style) {
+    uint32_t resolved;
+    if (codepoint > 0x10FFFF) {
+        codepoint = 0xFFFD;
+    }
+    if (codepoint < 128) {
+        uint32_t& entry = atlas->ascii[style][codepoint];
+        if (entry == kAtlasUnresolved) {
+            entry = atlas_resolve_char(atlas, codepoint, style);
+        }
+        resolved = entry;
+    } else {
+        uint32_t key = codepoint | style << 21;
+        const uint32_t* entry = table_find(atlas->chars, key);
+        if (entry) {
+            resolved = *entry;
+        } else {
+            // Not kept on allocation failure: resolved again next time
+            resolved = atlas_resolve_char(atlas, codepoint, style);
+            table_insert(&atlas->chars, key, resolved);
+        }
+    }
+    
+    if (resolved == kAtlasNoGlyph) {
+        return 0;
+    }
+    return ((resolved >> 16) + 1) << 16 | (resolved & 0xFFFF);
+}
+
+/**
+ * @brief Measure a cell at the atlas' DPI, snapped to whole pixels
+ */
+void atlas_measure_cell(QalamDWriteGlyphAtlas* atlas) {
+    float width = atlas->font_size * 0.6f;
+    float height = atlas->font_size * 1.2f;
+    float baseline = atlas->font_size * 0.95f;
+    
+    const AtlasFace& regular = atlas->faces[0];
+    if (regular.face) {
+        DWRITE_FONT_METRICS metrics;
+        regular.face->GetMetrics(&metrics);
+        baseline = metrics.ascent * regular.design_scale;
+        height = (metrics.ascent + metrics.descent + metrics.lineGap) * regular.design_scale;
+        
+        UINT32 zero = L'0';
+        UINT16 glyph = 0;
+        DWRITE_GLYPH_METRICS glyph_metrics;
+        if (SUCCEEDED(regular.face->GetGlyphIndices(&zero, 1, &glyph)) && glyph != 0 &&
+            SUCCEEDED(regular.face->GetDesignGlyphMetrics(&glyph, 1, &glyph_metrics, FALSE))) {
+            width = glyph_metrics.advanceWidth * regular.design_scale;
+        }
+    }
+    
+    float scale = atlas->scale;
+    atlas->cell.cell_width = std::max(1.0f, std::round(width * scale)) / scale;
+    atlas->cell.cell_height = std::max(1.0f, std::round(height * scale)) / scale;
+    atlas->cell.baseline = std::round(baseline * scale) / scale;
+}
+
+/**
+ * @brief Forget every glyph placed in the bitmap
+ */
+void atlas_reset_bitmap(QalamDWriteGlyphAtlas* atlas) {
+    table_clear(&atlas->glyphs);
+    atlas->shelf_x = 0;
+    atlas->shelf_y = 0;
+    atlas->shelf_height = 0;
+    atlas->needs_clear = true;
+}
+
+/**
+ * @brief Follow the target's DPI and device, recreating the bitmap
+ * 
+ * @return true if the atlas can draw
+ */
+bool atlas_sync(QalamDWriteGlyphAtlas* atlas) {
+    QalamDWriteRenderTarget* target = atlas->target;
+    if (!target->target) {
+        return false;
+    }
+    
+    float dpi_x = 96.0f;
+    float dpi_y = 96.0f;
+    target->target->GetDpi(&dpi_x, &dpi_y);
+    if (dpi_x != atlas->dpi) {
+        atlas->dpi = dpi_x;
+        atlas->scale = dpi_x / 96.0f;
+        atlas_measure_cell(atlas);
+        atlas->device_generation = 0;
+    }
+    if (atlas->device_generation == target->device_generation) {
+        return atlas->bitmap_target.Get() != nullptr;
+    }
+    
+    atlas->device_generation = target->device_generation;
+    atlas->white.Reset();
+    atlas->bitmap.Reset();
+    atlas->bitmap_target.Reset();
+    atlas->drawn = false;
+    atlas_reset_bitmap(atlas);
+    
+    // At 96 DPI one DIP of the bitmap is one pixel
+    D2D1_SIZE_F size = D2D1::SizeF(static_cast<float>(kAtlasSize), static_cast<float>(kAtlasSize));
+    D2D1_SIZE_U pixels = D2D1::SizeU(kAtlasSize, kAtlasSize);
+    D2D1_PIXEL_FORMAT format = D2D1::PixelFormat(DXGI_FORMAT_A8_UNORM, D2D1_ALPHA_MODE_PREMULTIPLIED);
+    HRESULT hr = target->target->CreateCompatibleRenderTarget(
+        &size, &pixels, &format, D2D1_COMPATIBLE_RENDER_TARGET_OPTIONS_NONE,
+        atlas->bitmap_target.GetAddressOf());
+    if (SUCCEEDED(hr)) {
+        hr = atlas->bitmap_target->GetBitmap(atlas->bitmap.GetAddressOf());
+    }
+    if (SUCCEEDED(hr)) {
+        hr = atlas->bitmap_target->CreateSolidColorBrush(D2D1::ColorF(1.0f, 1.0f, 1.0f, 1.0f),
+                                                         atlas->white.GetAddressOf());
+    }
+    if (FAILED(hr)) {
+        log_error(hr, "qalam_dwrite_glyph_atlas", "Failed to create atlas bitmap");
+        atlas->white.Reset();
+        atlas->bitmap.Reset();
+        atlas->bitmap_target.Reset();
+        return false;
+    }
+    
+    // An alpha-only bitmap cannot hold ClearType's subpixel coverage
+    atlas->bitmap_target->SetTextAntialiasMode(D2D1_TEXT_ANTIALIAS_MODE_GRAYSCALE);
+    return true;
+}
+
+/**
+ * @brief Measure the box a glyph takes in the bitmap
+ * 
+ * @return false for a glyph with nothing to draw
+ */
+bool atlas_glyph_box(const QalamDWriteGlyphAtlas* atlas, uint32_t key, AtlasGlyph* slot) {
+    const AtlasFace& face = atlas->faces[(key >> 16) - 1];
+    UINT16 glyph = static_cast<UINT16>(key & 0xFFFF);
+    DWRITE_GLYPH_METRICS metrics;
+    if (FAILED(face.face->GetDesignGlyphMetrics(&glyph, 1, &metrics, FALSE))) {
+        return false;
+    }
+    
+    int32_t advance_width = static_cast<int32_t>(metrics.advanceWidth);
+    int32_t advance_height = static_cast<int32_t>(metrics.advanceHeight);
+    if (advance_width - metrics.leftSideBearing - metrics.rightSideBearing <= 0 ||
+        advance_height - metrics.topSideBearing - metrics.bottomSideBearing <= 0) {
+        return false;
+    }
+    
+    // Simulated bold and oblique reach past the design metrics
+    float k = face.design_scale * atlas->scale;
+    float padding = static_cast<float>(kAtlasPadding);
+    if (face.face->GetSimulations() != DWRITE_FONT_SIMULATIONS_NONE) {
+        padding += std::ceil(atlas->font_size * atlas->scale * 0.25f);
+    }
+    float left = std::floor(metrics.leftSideBearing * k) - padding;
+    float right = std::ceil((advance_width - metrics.rightSideBearing) * k) + padding;
+    float top = std::floor(-(metrics.verticalOriginY - metrics.topSideBearing) * k) - padding;
+    float bottom = std::ceil(-(metrics.verticalOriginY - advance_height + metrics.bottomSideBearing) * k) +
+                   padding;
+    if (right - left > kAtlasSize || bottom - top > kAtlasSize) {
+        return false;
+    }
+    
+    slot->left = static_cast<int16_t>(left);
+    slot->top = static_cast<int16_t>(top);
+    slot->width = static_cast<uint16_t>(right - left);
+    slot->height = static_cast<uint16_t>(bottom - top);
+    return true;
+}
+
+/**
+ * @brief Find room for a glyph on the current shelf or a new one
+ * 
+ * @return false if the bitmap is full
+ */
+bool atlas_place(QalamDWriteGlyphAtlas* atlas, AtlasGlyph* slot) {
+    if (atlas->shelf_x + slot->width > kAtlasSize) {
+        atlas->shelf_y += atlas->shelf_height;
+        atlas->shelf_x = 0;
+        atlas->shelf_height = 0;
+    }
+    if (atlas->shelf_y + slot->height > kAtlasSize) {
+        return false;
+    }
+    
+    slot->x = static_cast<uint16_t>(atlas->shelf_x);
+    slot->y = static_cast<uint16_t>(atlas->shelf_y);
+    atlas->shelf_x += slot->width;
+    atlas->shelf_height = std::max(atlas->shelf_height, static_cast<uint32_t>(slot->height));
+    return true;
+}
+
+/**
+ * @brief Rasterize the glyphs of a call that are not in the bitmap yet
+ * 
+ * They are drawn in one pass over the bitmap. When it fills up, it is
+ * emptied once and every glyph of the call placed again, so a call
+ * never evicts glyphs it is about to draw. Pending drawing from the
+ * bitmap is flushed first, as it still needs the old contents.
+ * Keys of 0 are skipped.
+ */
+void atlas_rasterize(QalamDWriteGlyphAtlas* atlas, const uint32_t* keys, uint32_t count) {
+    for (int attempt = 0; attempt < 2; attempt++) {
+        bool drawing = false;
+        bool full = false;
+        
+        for (uint32_t i = 0; i < count; i++) {
+            if (keys[i] == 0 || table_find(atlas->glyphs, keys[i])) {
+                continue;
+            }
+            
+            AtlasGlyph slot = {};
+            if (atlas_glyph_box(atlas, keys[i], &slot)) {
+                if (!atlas_place(atlas, &slot)) {
+                    full = true;
+                    break;
+                }
+                
+                if (!drawing) {
+                    if (atlas->drawn) {
+                        atlas->target->target->Flush();
+                        atlas->drawn = false;
+                    }
+                    atlas->bitmap_target->BeginDraw();
+                    if (atlas->needs_clear) {
+                        atlas->bitmap_target->Clear(D2D1::ColorF(0.0f, 0.0f, 0.0f, 0.0f));
+                        atlas->needs_clear = false;
+                    }
+                    drawing = true;
+                }
+                
+                UINT16 glyph = static_cast<UINT16>(keys[i] & 0xFFFF);
+                DWRITE_GLYPH_RUN run = {};
+                run.fontFace = atlas->faces[(keys[i] >> 16) - 1].face.Get();
+                run.fontEmSize = atlas->font_size * atlas->scale;
+                run.glyphCount = 1;
+                run.glyphIndices = &glyph;
+                atlas->bitmap_target->DrawGlyphRun(
+                    D2D1::Point2F(static_cast<float>(slot.x - slot.left),
+                                  static_cast<float>(slot.y - slot.top)),
+                    &run, atlas->white.Get(), DWRITE_MEASURING_MODE_NATURAL);
+                atlas->glyphs_rasterized++;
+            } else {
+                slot.width = 0;
+            }
+            table_insert(&atlas->glyphs, keys[i], slot);
+        }
+        
+        if (drawing) {
+            HRESULT hr = atlas->bitmap_target->EndDraw();
+            if (FAILED(hr)) {
+                // Device loss comes back from the target's own EndDraw
+                log_error(hr, "qalam_dwrite_glyph_atlas", "Failed to rasterize glyphs");
+                atlas_reset_bitmap(atlas);
+                return;
+            }
+        }
+        if (!full) {
+            return;
+        }
+        
+        atlas_reset_bitmap(atlas);
+        atlas->flushes++;
+    }
+}
+
+/**
+ * @brief Make room for the glyph keys of one call
+ */
+bool atlas_reserve_keys(QalamDWriteGlyphAtlas* atlas, uint32_t count) {
+    if (count <= atlas->key_capacity) {
+        return true;
+    }
+    auto* keys = layout_array<uint32_t>(count);
+    if (!keys) {
+        return false;
+    }
+    layout_free(atlas->keys);
+    atlas->keys = keys;
+    atlas->key_capacity = count;
+    return true;
+}
+
+/**
+ * @brief Fill glyphs from the bitmap as opacity masks
+ * 
+ * FillOpacityMask() needs aliased drawing; the target's mode is
+ * restored by atlas_end_masks().
+ */
+D2D1_ANTIALIAS_MODE atlas_begin_masks(QalamDWriteGlyphAtlas* atlas) {
+    ID2D1RenderTarget* target = atlas->target->target.Get();
+    D2D1_ANTIALIAS_MODE mode = target->GetAntialiasMode();
+    target->SetAntialiasMode(D2D1_ANTIALIAS_MODE_ALIASED);
+    atlas->drawn = true;
+    return mode;
+}
+
+void atlas_end_masks(QalamDWriteGlyphAtlas* atlas, D2D1_ANTIALIAS_MODE mode) {
+    atlas->target->target->SetAntialiasMode(mode);
+}
+
+/**
+ * @brief Draw a glyph of the bitmap with its origin at a pixel
+ */
+void atlas_draw_glyph(QalamDWriteGlyphAtlas* atlas, uint32_t key, float origin_x, float origin_y,
+                      ID2D1Brush* brush) {
+    const AtlasGlyph* slot = table_find(atlas->glyphs, key);
+    if (!slot || slot->width == 0) {
+        return;
+    }
+    
+    float inverse = 1.0f / atlas->scale;
+    float left = (origin_x + slot->left) * inverse;
+    float top = (origin_y + slot->top) * inverse;
+    D2D1_RECT_F dest = D2D1::RectF(left, top, left + slot->width * inverse,
+                                   top + slot->height * inverse);
+    D2D1_RECT_F source = D2D1::RectF(slot->x, slot->y, static_cast<float>(slot->x + slot->width),
+                                     static_cast<float>(slot->y + slot->height));
+    atlas->target->target->FillOpacityMask(atlas->bitmap.Get(), brush,
+                                           D2D1_OPACITY_MASK_CONTENT_TEXT_GRAYSCALE,
+                                           &dest, &source);
+}
+
+void atlas_clear_clusters(QalamDWriteGlyphAtlas* atlas) {
+    for (size_t i = 0; i < kAtlasClusterBuckets; i++) {
+        AtlasCluster* cluster = atlas->cluster_buckets[i];
+        while (cluster) {
+            AtlasCluster* next = cluster->hash_next;
+            if (cluster->run) {
+                run_free(cluster->run);
+            }
+            layout_free(cluster->text);
+            layout_delete(cluster);
+            cluster = next;
+        }
+        atlas->cluster_buckets[i] = nullptr;
+    }
+    atlas->cluster_count = 0;
+}
+
+/**
+ * @brief Shape a cluster with its style's face
+ * 
+ * @return S_OK with *out_run set, S_FALSE if the face cannot shape the
+ *         text (so neither can the atlas), or an error worth trying again
+ */
+HRESULT atlas_shape(QalamDWriteGlyphAtlas* atlas, const wchar_t* text, uint32_t length,
+                    bool is_rtl, uint32_t style, ShapedRun** out_run) {
+    *out_run = nullptr;
+    QalamDWriteTextFormat* format = atlas->styles[style];
+    if (!dwrite_text_analyzer() || !format_font_face(format) || length > kShapedRunMaxLength) {
+        return S_FALSE;
+    }
+    
+    FrameScratch scratch;
+    auto* scripts = scratch.array<DWRITE_SCRIPT_ANALYSIS>(length, true);
+    auto* levels = scratch.array<uint8_t>(length, true);
+    if (!scripts || !levels) {
+        return E_OUTOFMEMORY;
+    }
+    
+    LineAnalysis analysis(text, length, format->locale, is_rtl, scripts, levels);
+    HRESULT hr = g_dwrite.text_analyzer->AnalyzeScript(&analysis, 0, length, &analysis);
+    if (FAILED(hr)) {
+        return hr;
+    }
+    
+    // Clusters are a single script and direction: spaces between Arabic
+    // words take the script of the words around them
+    return shape_run(format, text, length, scripts[0], is_rtl, out_run);
+}
+
+/**
+ * @brief Get a shaped cluster, shaping it on a miss
+ * 
+ * @return The cluster, or nullptr on allocation failure
+ */
+AtlasCluster* atlas_get_cluster(QalamDWriteGlyphAtlas* atlas, const wchar_t* text, uint32_t length,
+                                bool is_rtl, uint32_t style) {
+    uint64_t hash = hash_text(text, length) ^ hash_mix(style << 1 | (is_rtl ? 1u : 0u));
+    AtlasCluster** bucket = &atlas->cluster_buckets[hash & (kAtlasClusterBuckets - 1)];
+    for (AtlasCluster* cluster = *bucket; cluster; cluster = cluster->hash_next) {
+        if (cluster->hash == hash && cluster->style == style && cluster->is_rtl == is_rtl &&
+            cluster->text_length == length &&
+            std::memcmp(cluster->text, text, length * sizeof(wchar_t)) == 0) {
+            atlas->clusters_reused++;
+            return cluster;
+        }
+    }
+    
+    ShapedRun* run = nullptr;
+    HRESULT hr = atlas_shape(atlas, text, length, is_rtl, style, &run);
+    if (FAILED(hr)) {
+        return nullptr;
+    }
+    atlas->clusters_shaped++;
+    
+    auto* cluster = layout_new<AtlasCluster>();
+    wchar_t* copy = layout_array<wchar_t>(length);
+    if (!cluster || !copy) {
+        if (run) {
+            run_free(run);
+        }
+        layout_delete(cluster);
+        layout_free(copy);
+        return nullptr;
+    }
+    
+    if (atlas->cluster_count >= kAtlasMaxClusters) {
+        atlas_clear_clusters(atlas);
+    }
+    std::memcpy(copy, text, length * sizeof(wchar_t));
+    cluster->hash = hash;
+    cluster->style = style;
+    cluster->is_rtl = is_rtl;
+    cluster->text_length = length;
+    cluster->text = copy;
+    cluster->run = run;
+    cluster->hash_next = *bucket;
+    *bucket = cluster;
+    atlas->cluster_count++;
+    return cluster;
+}
+
+/**
+ * @brief Font preload worker
+ */
+DWORD WINAPI font_preload_thread(void* param) {
+    auto* preload = static_cast<QalamDWriteFontPreload*>(param);
+    QALAM_TRACE_BEGIN(span, QALAM_TRACE_STARTUP, "font_preload");
+    
+    dwrite_load_fonts();
+    if (preload->cache_path) {
+        std::lock_guard<std::mutex> lock(g_dwrite.fonts_mutex);
+        family_cache_read(preload->cache_path);
+    }
+    
+    preload->result = qalam_dwrite_text_format_create_arabic(preload->family, preload->size,
+                                                             &preload->format);
+    if (preload->result == QALAM_OK) {
+        // Resolve the face the first line is shaped with while still off the UI thread
+        format_font_face(preload->format);
+    }
+    
+    if (preload->cache_path) {
+        std::lock_guard<std::mutex> lock(g_dwrite.fonts_mutex);
+        if (g_dwrite.families_dirty) {
+            family_cache_write(preload->cache_path);
+        }
+    }
+    qalam_frame_release();
+    
+    QALAM_TRACE_END(span);
+    qalam_trace_startup_mark(QALAM_STARTUP_FONTS_READY);
+    InterlockedExchange(&preload->done, 1);
+    if (preload->ready) {
+        preload->ready(preload->user_data);
+    }
+    return 0;
+}
+
 } // anonymous namespace
 
 /* ============================================================================
@@ -184,19 +3057,12 @@ extern "C" QalamResult qalam_dwrite_init(void) {
         return QALAM_ERROR_DIRECTWRITE_INIT;
     }
     
-    // Get system font collection
-    hr = g_dwrite.dwrite_factory->GetSystemFontCollection(
-        g_dwrite.system_fonts.ReleaseAndGetAddressOf(),
-        FALSE  // checkForUpdates
-    );
-    
-    if (FAILED(hr)) {
-        // Non-fatal - continue without system fonts cached
-        log_error(hr, "qalam_dwrite_init", "Failed to get system font collection (non-fatal)");
-    }
+    // The system font collection and text analyzer are loaded on first
+    // use (dwrite_load_fonts()), off the path to the first frame
     
     g_dwrite.initialized = true;
     g_dwrite.ref_count = 1;
+    qalam_trace_startup_mark(QALAM_STARTUP_DWRITE_INIT);
     
     return QALAM_OK;
 }
@@ -212,7 +3078,14 @@ extern "C" void qalam_dwrite_shutdown(void) {
     
     if (g_dwrite.ref_count == 0 && g_dwrite.initialized) {
         // Release all resources
-        g_dwrite.system_fonts.Reset();
+        {
+            std::lock_guard<std::mutex> fonts_lock(g_dwrite.fonts_mutex);
+            g_dwrite.text_analyzer.Reset();
+            g_dwrite.system_fonts.Reset();
+            g_dwrite.fonts_loaded.store(false, std::memory_order_release);
+            g_dwrite.family_count = 0;
+            g_dwrite.families_dirty = false;
+        }
         g_dwrite.dwrite_factory.Reset();
         g_dwrite.d2d_factory.Reset();
         
@@ -297,13 +3170,14 @@ extern "C" QalamResult qalam_dwrite_text_format_create(
     }
     
     // Create wrapper structure
-    auto* result = new (std::nothrow) QalamDWriteTextFormat();
+    auto* result = layout_new<QalamDWriteTextFormat>();
     if (!result) {
         return QALAM_ERROR_OUT_OF_MEMORY;
     }
     
     result->format = std::move(format);
     result->is_rtl = params->is_rtl;
+    result->locale = locale;
     
     *out_format = result;
     return QALAM_OK;
@@ -314,8 +3188,18 @@ extern "C" QalamResult qalam_dwrite_text_format_create_arabic(
     float font_size,
     QalamDWriteTextFormat** out_format)
 {
+    if (!font_family || !out_format) {
+        return QALAM_ERROR_NULL_POINTER;
+    }
+    
+    if (!g_dwrite.initialized) {
+        return QALAM_ERROR_NOT_INITIALIZED;
+    }
+    
+    wchar_t resolved[kFamilyNameMax];
+    
     QalamDWriteFontParams params = {};
-    params.family = font_family;
+    params.family = resolve_arabic_family(font_family, resolved) ? resolved : font_family;
     params.size = font_size;
     params.weight = QALAM_DWRITE_FONT_WEIGHT_NORMAL;
     params.style = QALAM_DWRITE_FONT_STYLE_NORMAL;
@@ -325,7 +3209,132 @@ extern "C" QalamResult qalam_dwrite_text_format_create_arabic(
 }
 
 extern "C" void qalam_dwrite_text_format_destroy(QalamDWriteTextFormat* format) {
-    delete format;
+    layout_delete(format);
+}
+
+extern "C" bool qalam_dwrite_text_format_is_rtl(const QalamDWriteTextFormat* format) {
+    return format && format->is_rtl;
+}
+
+extern "C" QalamResult qalam_dwrite_text_format_get_family_name(
+    const QalamDWriteTextFormat* format,
+    wchar_t* out_name,
+    uint32_t capacity)
+{
+    if (!format || !out_name) {
+        return QALAM_ERROR_NULL_POINTER;
+    }
+    
+    if (capacity <= format->format->GetFontFamilyNameLength()) {
+        return QALAM_ERROR_INVALID_ARGUMENT;
+    }
+    
+    HRESULT hr = format->format->GetFontFamilyName(out_name, capacity);
+    return hr_to_result(hr);
+}
+
+/* ============================================================================
+ * Font Preloading
+ * ============================================================================ */
+
+extern "C" void qalam_dwrite_font_preload_get_default_options(
+    QalamDWriteFontPreloadOptions* options)
+{
+    if (!options) {
+        return;
+    }
+    
+    options->family = L"Segoe UI";
+    options->size = 16.0f;
+    options->cache_path = nullptr;
+    options->ready = nullptr;
+    options->user_data = nullptr;
+}
+
+extern "C" QalamResult qalam_dwrite_font_preload_start(
+    const QalamDWriteFontPreloadOptions* options,
+    QalamDWriteFontPreload** out_preload)
+{
+    if (!out_preload) {
+        return QALAM_ERROR_NULL_POINTER;
+    }
+    
+    *out_preload = nullptr;
+    
+    if (!g_dwrite.initialized) {
+        return QALAM_ERROR_NOT_INITIALIZED;
+    }
+    
+    QalamDWriteFontPreloadOptions defaults;
+    qalam_dwrite_font_preload_get_default_options(&defaults);
+    if (!options) {
+        options = &defaults;
+    }
+    
+    const wchar_t* family = options->family ? options->family : defaults.family;
+    size_t family_length = std::wcslen(family);
+    if (family_length >= kFamilyNameMax || options->size <= 0.0f) {
+        return QALAM_ERROR_INVALID_ARGUMENT;
+    }
+    
+    auto* preload = layout_new<QalamDWriteFontPreload>();
+    if (!preload) {
+        return QALAM_ERROR_OUT_OF_MEMORY;
+    }
+    
+    std::wmemcpy(preload->family, family, family_length);
+    preload->size = options->size;
+    preload->ready = options->ready;
+    preload->user_data = options->user_data;
+    if (options->cache_path) {
+        size_t path_length = std::wcslen(options->cache_path);
+        preload->cache_path = layout_array<wchar_t>(path_length + 1);
+        if (!preload->cache_path) {
+            layout_delete(preload);
+            return QALAM_ERROR_OUT_OF_MEMORY;
+        }
+        std::wmemcpy(preload->cache_path, options->cache_path, path_length + 1);
+    }
+    
+    preload->thread = CreateThread(nullptr, 0, font_preload_thread, preload, 0, nullptr);
+    if (!preload->thread) {
+        layout_free(preload->cache_path);
+        layout_delete(preload);
+        return QALAM_ERROR_OUT_OF_MEMORY;
+    }
+    
+    *out_preload = preload;
+    return QALAM_OK;
+}
+
+extern "C" bool qalam_dwrite_font_preload_is_ready(const QalamDWriteFontPreload* preload) {
+    return preload && preload->done != 0;
+}
+
+extern "C" QalamResult qalam_dwrite_font_preload_wait(
+    QalamDWriteFontPreload* preload,
+    QalamDWriteTextFormat** out_format)
+{
+    if (!preload || !out_format) {
+        return QALAM_ERROR_NULL_POINTER;
+    }
+    
+    WaitForSingleObject(preload->thread, INFINITE);
+    *out_format = preload->format;
+    preload->format = nullptr;
+    return preload->result;
+}
+
+extern "C" void qalam_dwrite_font_preload_destroy(QalamDWriteFontPreload* preload) {
+    if (!preload) {
+        return;
+    }
+    
+    WaitForSingleObject(preload->thread, INFINITE);
+    CloseHandle(preload->thread);
+    qalam_dwrite_text_format_destroy(preload->format);
+    layout_free(preload->cache_path);
+    layout_delete(preload);
 }
 
 /* ============================================================================
@@ -352,41 +3361,30 @@ extern "C" QalamResult qalam_dwrite_text_layout_create(
     
     // Create text layout
     ComPtr<IDWriteTextLayout> layout;
-    HRESULT hr = g_dwrite.dwrite_factory->CreateTextLayout(
-        text,
-        text_length,
-        format->format.Get(),
-        max_width,
-        max_height,
-        layout.GetAddressOf()
-    );
+    HRESULT hr = create_dwrite_layout(text, text_length, format, max_width, max_height,
+                                      layout.GetAddressOf());
     
     if (FAILED(hr)) {
         log_error(hr, "qalam_dwrite_text_layout_create", "Failed to create text layout");
         return hr_to_result(hr);
     }
     
-    // Configure RTL on layout if format is RTL
-    if (format->is_rtl) {
-        layout->SetReadingDirection(DWRITE_READING_DIRECTION_RIGHT_TO_LEFT);
-        layout->SetFlowDirection(DWRITE_FLOW_DIRECTION_TOP_TO_BOTTOM);
-    }
-    
     // Create wrapper structure
-    auto* result = new (std::nothrow) QalamDWriteTextLayout();
+    auto* result = layout_new<QalamDWriteTextLayout>();
     if (!result) {
         return QALAM_ERROR_OUT_OF_MEMORY;
     }
     
     result->layout = std::move(layout);
     result->is_rtl = format->is_rtl;
+    result->text_length = text_length;
     
     *out_layout = result;
     return QALAM_OK;
 }
 
 extern "C" void qalam_dwrite_text_layout_destroy(QalamDWriteTextLayout* layout) {
-    delete layout;
+    layout_delete(layout);
 }
 
 extern "C" QalamResult qalam_dwrite_text_layout_get_metrics(
@@ -397,6 +3395,18 @@ extern "C" QalamResult qalam_dwrite_text_layout_get_metrics(
         return QALAM_ERROR_NULL_POINTER;
     }
     
+    // A shaped layout is one unwrapped line
+    if (layout->shaped) {
+        out_metrics->left = layout->origin_x;
+        out_metrics->top = 0.0f;
+        out_metrics->width = layout->width;
+        out_metrics->height = layout->height;
+        out_metrics->layout_width = layout->max_width;
+        out_metrics->layout_height = layout->max_height;
+        out_metrics->line_count = 1;
+        return QALAM_OK;
+    }
+    
     DWRITE_TEXT_METRICS metrics;
     HRESULT hr = layout->layout->GetMetrics(&metrics);
     
@@ -429,8 +3439,12 @@ extern "C" QalamResult qalam_dwrite_text_layout_hit_test_point(
     BOOL is_trailing = FALSE;
     BOOL is_inside = FALSE;
     DWRITE_HIT_TEST_METRICS metrics;
+    IDWriteTextLayout* dwrite_layout = nullptr;
     
-    HRESULT hr = layout->layout->HitTestPoint(x, y, &is_trailing, &is_inside, &metrics);
+    HRESULT hr = layout_dwrite(layout, &dwrite_layout);
+    if (SUCCEEDED(hr)) {
+        hr = dwrite_layout->HitTestPoint(x, y, &is_trailing, &is_inside, &metrics);
+    }
     
     if (FAILED(hr)) {
         log_error(hr, "qalam_dwrite_text_layout_hit_test_point", "Failed to hit test point");
@@ -457,43 +3471,482 @@ extern "C" QalamResult qalam_dwrite_text_layout_hit_test_position(
     float* out_y,
     QalamDWriteHitTestResult* out_result)
 {
-    if (!layout || !out_x || !out_y) {
+    if (!layout || !out_x || !out_y) {
+        return QALAM_ERROR_NULL_POINTER;
+    }
+    
+    float x, y;
+    DWRITE_HIT_TEST_METRICS metrics;
+    IDWriteTextLayout* dwrite_layout = nullptr;
+    
+    HRESULT hr = layout_dwrite(layout, &dwrite_layout);
+    if (SUCCEEDED(hr)) {
+        hr = dwrite_layout->HitTestTextPosition(
+            text_position,
+            is_trailing ? TRUE : FALSE,
+            &x,
+            &y,
+            &metrics
+        );
+    }
+    
+    if (FAILED(hr)) {
+        log_error(hr, "qalam_dwrite_text_layout_hit_test_position", "Failed to hit test position");
+        return hr_to_result(hr);
+    }
+    
+    *out_x = x;
+    *out_y = y;
+    
+    if (out_result) {
+        out_result->text_position = metrics.textPosition;
+        out_result->length = metrics.length;
+        out_result->left = metrics.left;
+        out_result->top = metrics.top;
+        out_result->width = metrics.width;
+        out_result->height = metrics.height;
+        out_result->is_trailing_hit = is_trailing;
+        out_result->is_inside = true;
+    }
+    
+    return QALAM_OK;
+}
+
+extern "C" QalamResult qalam_dwrite_text_layout_set_styles(
+    QalamDWriteTextLayout* layout,
+    const QalamStyleRange* ranges,
+    uint32_t range_count,
+    QalamDWriteBrush* const* brushes,
+    uint32_t brush_count)
+{
+    if (!layout || (!ranges && range_count > 0) || (!brushes && brush_count > 0)) {
+        return QALAM_ERROR_NULL_POINTER;
+    }
+    
+    // Ranges are ordered, so those past the text are a suffix to drop
+    uint32_t count = 0;
+    while (count < range_count && ranges[count].start < layout->text_length) {
+        count++;
+    }
+    
+    bool same = count == layout->style_count && brush_count == layout->style_brush_count &&
+                (brush_count == 0 ||
+                 std::memcmp(brushes, layout->style_brushes, brush_count * sizeof(*brushes)) == 0);
+    for (uint32_t i = 0; same && i < count; i++) {
+        const QalamStyleRange& range = ranges[i];
+        const QalamStyleRange& held = layout->styles[i];
+        same = range.start == held.start && range.style == held.style &&
+               std::min(range.length, layout->text_length - range.start) == held.length;
+    }
+    if (same) {
+        return QALAM_OK;
+    }
+    
+    QalamStyleRange* styles = layout->styles;
+    QalamDWriteBrush** style_brushes = layout->style_brushes;
+    if (count != layout->style_count) {
+        styles = count ? layout_array<QalamStyleRange>(count) : nullptr;
+    }
+    if (brush_count != layout->style_brush_count) {
+        style_brushes = brush_count ? layout_array<QalamDWriteBrush*>(brush_count) : nullptr;
+    }
+    if ((count && !styles) || (brush_count && !style_brushes)) {
+        if (styles != layout->styles) {
+            layout_free(styles);
+        }
+        if (style_brushes != layout->style_brushes) {
+            layout_free(style_brushes);
+        }
+        return QALAM_ERROR_OUT_OF_MEMORY;
+    }
+    if (styles != layout->styles) {
+        layout_free(layout->styles);
+    }
+    if (style_brushes != layout->style_brushes) {
+        layout_free(layout->style_brushes);
+    }
+    
+    for (uint32_t i = 0; i < count; i++) {
+        styles[i] = ranges[i];
+        styles[i].length = std::min(ranges[i].length, layout->text_length - ranges[i].start);
+    }
+    if (brush_count) {
+        std::memcpy(style_brushes, brushes, brush_count * sizeof(*brushes));
+    }
+    layout->styles = styles;
+    layout->style_count = count;
+    layout->style_brushes = style_brushes;
+    layout->style_brush_count = brush_count;
+    
+    // Shaped layouts pick the brushes up as they draw
+    layout->effects_dirty = !layout->shaped;
+    return QALAM_OK;
+}
+
+/* ============================================================================
+ * Caret Navigation
+ * ============================================================================ */
+
+extern "C" QalamResult qalam_dwrite_text_layout_get_caret_stops(
+    QalamDWriteTextLayout* layout,
+    const QalamDWriteCaretStop** out_logical,
+    const QalamDWriteCaretStop** out_visual,
+    uint32_t* out_count)
+{
+    if (!layout || !out_count) {
+        return QALAM_ERROR_NULL_POINTER;
+    }
+    
+    QalamResult result = layout_carets(layout, "qalam_dwrite_text_layout_get_caret_stops");
+    if (result != QALAM_OK) {
+        return result;
+    }
+    
+    if (out_logical) {
+        *out_logical = layout->caret_stops;
+    }
+    if (out_visual) {
+        *out_visual = layout->caret_stops + layout->cluster_count + 1;
+    }
+    *out_count = layout->cluster_count + 1;
+    return QALAM_OK;
+}
+
+extern "C" QalamResult qalam_dwrite_text_layout_caret_x(
+    QalamDWriteTextLayout* layout,
+    uint32_t text_position,
+    float* out_x)
+{
+    if (!layout || !out_x) {
+        return QALAM_ERROR_NULL_POINTER;
+    }
+    
+    QalamResult result = layout_carets(layout, "qalam_dwrite_text_layout_caret_x");
+    if (result != QALAM_OK) {
+        return result;
+    }
+    
+    *out_x = layout->caret_stops[logical_stop_index(layout, text_position)].x;
+    return QALAM_OK;
+}
+
+extern "C" QalamResult qalam_dwrite_text_layout_caret_move(
+    QalamDWriteTextLayout* layout,
+    uint32_t text_position,
+    int direction,
+    uint32_t* out_position)
+{
+    if (!layout || !out_position) {
+        return QALAM_ERROR_NULL_POINTER;
+    }
+    
+    QalamResult result = layout_carets(layout, "qalam_dwrite_text_layout_caret_move");
+    if (result != QALAM_OK) {
+        return result;
+    }
+    
+    // Find the caret on screen, preferring the stop of the same position
+    const QalamDWriteCaretStop& caret = layout->caret_stops[logical_stop_index(layout, text_position)];
+    const QalamDWriteCaretStop* visual = layout->caret_stops + layout->cluster_count + 1;
+    uint32_t last = layout->cluster_count;
+    uint32_t index = visual_stop_index(layout, caret.x);
+    if (visual[index].text_position != caret.text_position) {
+        if (index > 0 && visual[index - 1].text_position == caret.text_position) {
+            index--;
+        } else if (index < last && visual[index + 1].text_position == caret.text_position) {
+            index++;
+        }
+    }
+    
+    if (direction < 0 && index > 0) {
+        index--;
+    } else if (direction > 0 && index < last) {
+        index++;
+    } else {
+        *out_position = text_position;
+        return QALAM_OK;
+    }
+    
+    *out_position = visual[index].text_position;
+    return QALAM_OK;
+}
+
+extern "C" QalamResult qalam_dwrite_text_layout_caret_at(
+    QalamDWriteTextLayout* layout,
+    float x,
+    uint32_t* out_position)
+{
+    if (!layout || !out_position) {
+        return QALAM_ERROR_NULL_POINTER;
+    }
+    
+    QalamResult result = layout_carets(layout, "qalam_dwrite_text_layout_caret_at");
+    if (result != QALAM_OK) {
+        return result;
+    }
+    
+    uint32_t index = visual_stop_index(layout, x);
+    *out_position = layout->caret_stops[layout->cluster_count + 1 + index].text_position;
+    return QALAM_OK;
+}
+
+extern "C" QalamResult qalam_dwrite_text_layout_get_range_spans(
+    QalamDWriteTextLayout* layout,
+    uint32_t start,
+    uint32_t end,
+    QalamDWriteSpan* spans,
+    uint32_t max_spans,
+    uint32_t* out_count)
+{
+    if (!layout || !out_count) {
+        return QALAM_ERROR_NULL_POINTER;
+    }
+    
+    *out_count = 0;
+    QalamResult result = layout_carets(layout, "qalam_dwrite_text_layout_get_range_spans");
+    if (result != QALAM_OK) {
+        return result;
+    }
+    
+    // Clusters touched by the range, merged while they are neighbours on screen
+    uint32_t count = 0;
+    bool extending = false;
+    for (uint32_t i = 0; i < layout->cluster_count; i++) {
+        const CaretCluster& cluster = layout->clusters[i];
+        bool selected = cluster.position < end && cluster.position + cluster.length > start;
+        if (selected && extending) {
+            if (spans && count <= max_spans) {
+                spans[count - 1].right = cluster.right;
+            }
+        } else if (selected) {
+            if (spans && count < max_spans) {
+                spans[count] = { cluster.left, cluster.right };
+            }
+            count++;
+        }
+        extending = selected;
+    }
+    
+    *out_count = count;
+    return QALAM_OK;
+}
+
+/* ============================================================================
+ * Text Layout Cache
+ * ============================================================================ */
+
+extern "C" QalamResult qalam_dwrite_layout_cache_create(
+    size_t byte_budget,
+    QalamDWriteLayoutCache** out_cache)
+{
+    if (!out_cache) {
+        return QALAM_ERROR_NULL_POINTER;
+    }
+    
+    *out_cache = nullptr;
+    
+    auto* cache = layout_new<QalamDWriteLayoutCache>();
+    if (!cache) {
+        return QALAM_ERROR_OUT_OF_MEMORY;
+    }
+    
+    cache->buckets = layout_array<LayoutCacheEntry*>(kLayoutCacheInitialBuckets, true);
+    cache->gen_buckets = layout_array<LayoutGenTag*>(kLayoutCacheInitialBuckets, true);
+    cache->run_buckets = layout_array<ShapedRun*>(kLayoutCacheInitialBuckets, true);
+    if (!cache->buckets || !cache->gen_buckets || !cache->run_buckets) {
+        layout_free(cache->buckets);
+        layout_free(cache->gen_buckets);
+        layout_free(cache->run_buckets);
+        layout_delete(cache);
+        return QALAM_ERROR_OUT_OF_MEMORY;
+    }
+    
+    cache->bucket_count = kLayoutCacheInitialBuckets;
+    cache->run_bucket_count = kLayoutCacheInitialBuckets;
+    cache->byte_budget = byte_budget ? byte_budget : QALAM_DWRITE_LAYOUT_CACHE_DEFAULT_BUDGET;
+    
+    *out_cache = cache;
+    return QALAM_OK;
+}
+
+extern "C" void qalam_dwrite_layout_cache_destroy(QalamDWriteLayoutCache* cache) {
+    if (!cache) {
+        return;
+    }
+    
+    qalam_dwrite_layout_cache_clear(cache);
+    layout_free(cache->buckets);
+    layout_free(cache->gen_buckets);
+    layout_free(cache->run_buckets);
+    layout_delete(cache);
+}
+
+extern "C" void qalam_dwrite_layout_cache_begin_frame(QalamDWriteLayoutCache* cache) {
+    if (!cache) {
+        return;
+    }
+    
+    cache->frame++;
+    cache_trim(cache);
+}
+
+extern "C" QalamDWriteTextLayout* qalam_dwrite_layout_cache_find(
+    QalamDWriteLayoutCache* cache,
+    const QalamDWriteLayoutKey* key)
+{
+    if (!cache || !key || key->generation == 0) {
+        return nullptr;
+    }
+    
+    LayoutGenTag* tag = cache->gen_buckets[gen_bucket_of(cache, key->generation)];
+    for (; tag; tag = tag->gen_next) {
+        if (tag->generation == key->generation && entry_matches_key(tag->entry, key)) {
+            cache_touch(cache, tag->entry);
+            return tag->entry->layout;
+        }
+    }
+    
+    return nullptr;
+}
+
+extern "C" QalamResult qalam_dwrite_layout_cache_get(
+    QalamDWriteLayoutCache* cache,
+    const wchar_t* text,
+    uint32_t text_length,
+    const QalamDWriteLayoutKey* key,
+    QalamDWriteTextLayout** out_layout)
+{
+    if (!cache || !text || !key || !key->format || !out_layout) {
         return QALAM_ERROR_NULL_POINTER;
     }
     
-    float x, y;
-    DWRITE_HIT_TEST_METRICS metrics;
+    *out_layout = nullptr;
     
-    HRESULT hr = layout->layout->HitTestTextPosition(
-        text_position,
-        is_trailing ? TRUE : FALSE,
-        &x,
-        &y,
-        &metrics
-    );
+    uint64_t hash = hash_layout_text(text, text_length, key);
+    
+    // Same text and key laid out before: no shaping needed
+    LayoutCacheEntry* entry = cache->buckets[hash & (cache->bucket_count - 1)];
+    for (; entry; entry = entry->hash_next) {
+        if (entry->hash == hash && entry->text_length == text_length &&
+            entry_matches_key(entry, key) &&
+            std::memcmp(entry->text, text, text_length * sizeof(wchar_t)) == 0) {
+            cache_touch(cache, entry);
+            cache_add_generation(cache, entry, key->generation);
+            cache_grow(cache);
+            *out_layout = entry->layout;
+            return QALAM_OK;
+        }
+    }
     
+    // Miss: shape the text from cached runs where possible, otherwise
+    // through IDWriteTextLayout, and keep the layout
+    QalamDWriteTextLayout* layout = nullptr;
+    size_t layout_bytes = 0;
+    QALAM_TRACE_BEGIN(span, QALAM_TRACE_LAYOUT, "shape_layout");
+    HRESULT hr = cache_shape_layout(cache, text, text_length, key, &layout);
+    QALAM_TRACE_END(span);
+    if (hr == E_OUTOFMEMORY) {
+        return QALAM_ERROR_OUT_OF_MEMORY;
+    }
     if (FAILED(hr)) {
-        log_error(hr, "qalam_dwrite_text_layout_hit_test_position", "Failed to hit test position");
-        return hr_to_result(hr);
+        log_error(hr, "qalam_dwrite_layout_cache_get", "Failed to shape text (using text layout)");
     }
     
-    *out_x = x;
-    *out_y = y;
+    if (layout) {
+        layout_bytes = sizeof(QalamDWriteTextLayout) + layout->run_count * sizeof(PlacedRun) +
+                       static_cast<size_t>(text_length) * sizeof(wchar_t);
+    } else {
+        QalamResult result = qalam_dwrite_text_layout_create(
+            text, text_length, key->format, key->max_width, key->max_height, &layout);
+        if (result != QALAM_OK) {
+            return result;
+        }
+        layout_bytes = kLayoutCacheEntryBytes + static_cast<size_t>(text_length) * kLayoutCacheCharBytes;
+        cache->fallbacks++;
+    }
     
-    if (out_result) {
-        out_result->text_position = metrics.textPosition;
-        out_result->length = metrics.length;
-        out_result->left = metrics.left;
-        out_result->top = metrics.top;
-        out_result->width = metrics.width;
-        out_result->height = metrics.height;
-        out_result->is_trailing_hit = is_trailing;
-        out_result->is_inside = true;
+    entry = layout_new<LayoutCacheEntry>();
+    wchar_t* copy = layout_array<wchar_t>(text_length ? text_length : 1);
+    if (!entry || !copy) {
+        layout_delete(entry);
+        layout_free(copy);
+        cache_layout_free(cache, layout);
+        return QALAM_ERROR_OUT_OF_MEMORY;
     }
+    std::memcpy(copy, text, text_length * sizeof(wchar_t));
+    layout->text = copy;
+    
+    entry->hash = hash;
+    entry->format = key->format;
+    entry->max_width = key->max_width;
+    entry->max_height = key->max_height;
+    entry->dpi = key->dpi;
+    entry->tags = nullptr;
+    entry->tag_count = 0;
+    entry->frame = cache->frame;
+    entry->bytes = sizeof(LayoutCacheEntry) + layout_bytes;
+    entry->text_length = text_length;
+    entry->text = copy;
+    entry->layout = layout;
     
+    LayoutCacheEntry** bucket = &cache->buckets[hash & (cache->bucket_count - 1)];
+    entry->hash_next = *bucket;
+    *bucket = entry;
+    cache_lru_push_front(cache, entry);
+    
+    cache->entry_count++;
+    cache->bytes_used += entry->bytes;
+    cache_add_generation(cache, entry, key->generation);
+    cache->misses++;
+    
+    cache_grow(cache);
+    cache_trim(cache);
+    
+    *out_layout = layout;
     return QALAM_OK;
 }
 
+extern "C" void qalam_dwrite_layout_cache_clear(QalamDWriteLayoutCache* cache) {
+    if (!cache) {
+        return;
+    }
+    
+    LayoutCacheEntry* entry = cache->lru_head;
+    while (entry) {
+        LayoutCacheEntry* next = entry->lru_next;
+        cache_entry_free(cache, entry);
+        entry = next;
+    }
+    
+    std::memset(cache->buckets, 0, cache->bucket_count * sizeof(LayoutCacheEntry*));
+    std::memset(cache->gen_buckets, 0, cache->bucket_count * sizeof(LayoutGenTag*));
+    cache->lru_head = nullptr;
+    cache->lru_tail = nullptr;
+    cache->entry_count = 0;
+    cache->tag_count = 0;
+    cache->bytes_used = 0;
+}
+
+extern "C" void qalam_dwrite_layout_cache_get_stats(
+    const QalamDWriteLayoutCache* cache,
+    QalamDWriteLayoutCacheStats* out_stats)
+{
+    if (!cache || !out_stats) {
+        return;
+    }
+    
+    out_stats->entry_count = cache->entry_count;
+    out_stats->bytes_used = cache->bytes_used;
+    out_stats->byte_budget = cache->byte_budget;
+    out_stats->hits = cache->hits;
+    out_stats->misses = cache->misses;
+    out_stats->evictions = cache->evictions;
+    out_stats->run_count = cache->run_count;
+    out_stats->runs_shaped = cache->runs_shaped;
+    out_stats->runs_reused = cache->runs_reused;
+    out_stats->fallbacks = cache->fallbacks;
+}
+
 /* ============================================================================
  * Render Target Management
  * ============================================================================ */
@@ -514,58 +3967,26 @@ extern "C" QalamResult qalam_dwrite_render_target_create(
     
     HWND window = static_cast<HWND>(hwnd);
     
-    // Get client area dimensions
+    // Validate the window before creating any device
     RECT rc;
     if (!GetClientRect(window, &rc)) {
         return QALAM_ERROR_WINDOW_CREATE;
     }
     
-    D2D1_SIZE_U size = D2D1::SizeU(
-        static_cast<UINT32>(rc.right - rc.left),
-        static_cast<UINT32>(rc.bottom - rc.top)
-    );
-    
-    // Ensure minimum size
-    if (size.width == 0) size.width = 1;
-    if (size.height == 0) size.height = 1;
-    
-    // Create render target properties
-    D2D1_RENDER_TARGET_PROPERTIES rt_props = D2D1::RenderTargetProperties(
-        D2D1_RENDER_TARGET_TYPE_DEFAULT,
-        D2D1::PixelFormat(DXGI_FORMAT_B8G8R8A8_UNORM, D2D1_ALPHA_MODE_PREMULTIPLIED),
-        0.0f, 0.0f,  // Default DPI
-        D2D1_RENDER_TARGET_USAGE_NONE,
-        D2D1_FEATURE_LEVEL_DEFAULT
-    );
-    
-    D2D1_HWND_RENDER_TARGET_PROPERTIES hwnd_rt_props = D2D1::HwndRenderTargetProperties(
-        window,
-        size,
-        D2D1_PRESENT_OPTIONS_NONE
-    );
-    
-    // Create HWND render target
-    ComPtr<ID2D1HwndRenderTarget> target;
-    HRESULT hr = g_dwrite.d2d_factory->CreateHwndRenderTarget(
-        rt_props,
-        hwnd_rt_props,
-        target.GetAddressOf()
-    );
-    
-    if (FAILED(hr)) {
-        log_error(hr, "qalam_dwrite_render_target_create", "Failed to create render target");
-        return QALAM_ERROR_RENDER_TARGET;
-    }
-    
     // Create wrapper structure
-    auto* result = new (std::nothrow) QalamDWriteRenderTarget();
+    auto* result = layout_new<QalamDWriteRenderTarget>();
     if (!result) {
         return QALAM_ERROR_OUT_OF_MEMORY;
     }
-    
-    result->target = std::move(target);
     result->hwnd = window;
     
+    HRESULT hr = rt_create(result);
+    if (FAILED(hr)) {
+        log_error(hr, "qalam_dwrite_render_target_create", "Failed to create render target");
+        layout_delete(result);
+        return QALAM_ERROR_RENDER_TARGET;
+    }
+    
     *out_target = result;
     return QALAM_OK;
 }
@@ -583,25 +4004,59 @@ extern "C" QalamResult qalam_dwrite_render_target_resize(
     if (width == 0) width = 1;
     if (height == 0) height = 1;
     
-    D2D1_SIZE_U size = D2D1::SizeU(width, height);
-    
-    HRESULT hr = target->target->Resize(size);
+    HRESULT hr;
+    if (!target->target) {
+        // An earlier recovery failed; try again at the new size
+        hr = rt_recover(target, D2DERR_RECREATE_TARGET, "qalam_dwrite_render_target_resize");
+    } else if (target->swap_chain) {
+        // The back buffer must be released before the buffers can be resized
+        target->context->SetTarget(nullptr);
+        target->back_buffer.Reset();
+        hr = target->swap_chain->ResizeBuffers(
+            0, width, height, DXGI_FORMAT_UNKNOWN,
+            DXGI_SWAP_CHAIN_FLAG_FRAME_LATENCY_WAITABLE_OBJECT);
+        if (SUCCEEDED(hr)) {
+            hr = rt_bind_back_buffer(target);
+        }
+        if (is_device_lost(hr)) {
+            hr = rt_recover(target, hr, "qalam_dwrite_render_target_resize");
+        }
+    } else {
+        hr = target->hwnd_target->Resize(D2D1::SizeU(width, height));
+        if (is_device_lost(hr)) {
+            hr = rt_recover(target, hr, "qalam_dwrite_render_target_resize");
+        }
+    }
     
     if (FAILED(hr)) {
         log_error(hr, "qalam_dwrite_render_target_resize", "Failed to resize render target");
         
-        if (hr == D2DERR_RECREATE_TARGET) {
+        if (is_device_lost(hr)) {
             return QALAM_ERROR_RENDER_TARGET;
         }
         
         return hr_to_result(hr);
     }
     
+    target->has_dirty = false;
+    target->dirty_count = 0;
+    target->full_present = true;
     return QALAM_OK;
 }
 
 extern "C" void qalam_dwrite_render_target_destroy(QalamDWriteRenderTarget* target) {
-    delete target;
+    if (!target) {
+        return;
+    }
+    
+    // Brushes outliving the target keep their (now unused) D2D brush
+    for (QalamDWriteBrush* brush = target->brushes; brush; brush = brush->next) {
+        brush->owner = nullptr;
+    }
+    target->brushes = nullptr;
+    
+    rt_release(target);
+    layout_delete(target);
 }
 
 extern "C" void qalam_dwrite_render_target_get_dpi(
@@ -613,9 +4068,28 @@ extern "C" void qalam_dwrite_render_target_get_dpi(
         return;
     }
     
+    if (!target->target) {
+        *out_dpi_x = 96.0f;
+        *out_dpi_y = 96.0f;
+        return;
+    }
+    
     target->target->GetDpi(out_dpi_x, out_dpi_y);
 }
 
+extern "C" bool qalam_dwrite_render_target_is_flip_model(const QalamDWriteRenderTarget* target) {
+    return target && target->swap_chain;
+}
+
+extern "C" void* qalam_dwrite_render_target_get_frame_waitable(QalamDWriteRenderTarget* target) {
+    return target ? target->frame_waitable : nullptr;
+}
+
+extern "C" bool qalam_dwrite_render_is_full_frame(const QalamDWriteRenderTarget* target) {
+    // The HWND render target does not keep its previous frame
+    return !target || !target->swap_chain || target->full_present;
+}
+
 /* ============================================================================
  * Brush Management
  * ============================================================================ */
@@ -631,6 +4105,10 @@ extern "C" QalamResult qalam_dwrite_brush_create_solid(
     
     *out_brush = nullptr;
     
+    if (!target->target) {
+        return QALAM_ERROR_RENDER_TARGET;
+    }
+    
     ComPtr<ID2D1SolidColorBrush> brush;
     HRESULT hr = target->target->CreateSolidColorBrush(
         to_d2d_color(color),
@@ -643,19 +4121,34 @@ extern "C" QalamResult qalam_dwrite_brush_create_solid(
     }
     
     // Create wrapper structure
-    auto* result = new (std::nothrow) QalamDWriteBrush();
+    auto* result = layout_new<QalamDWriteBrush>();
     if (!result) {
         return QALAM_ERROR_OUT_OF_MEMORY;
     }
     
     result->brush = std::move(brush);
+    result->color = to_d2d_color(color);
+    result->owner = target;
+    result->next = target->brushes;
+    target->brushes = result;
     
     *out_brush = result;
     return QALAM_OK;
 }
 
 extern "C" void qalam_dwrite_brush_destroy(QalamDWriteBrush* brush) {
-    delete brush;
+    if (!brush) {
+        return;
+    }
+    
+    if (brush->owner) {
+        QalamDWriteBrush** link = &brush->owner->brushes;
+        while (*link != brush) {
+            link = &(*link)->next;
+        }
+        *link = brush->next;
+    }
+    layout_delete(brush);
 }
 
 extern "C" void qalam_dwrite_brush_set_color(QalamDWriteBrush* brush, QalamDWriteColor color) {
@@ -663,19 +4156,116 @@ extern "C" void qalam_dwrite_brush_set_color(QalamDWriteBrush* brush, QalamDWrit
         return;
     }
     
-    brush->brush->SetColor(to_d2d_color(color));
+    brush->color = to_d2d_color(color);
+    if (brush->brush) {
+        brush->brush->SetColor(brush->color);
+    }
 }
 
 /* ============================================================================
  * Rendering Operations
  * ============================================================================ */
 
+extern "C" bool qalam_dwrite_render_wait_for_frame(QalamDWriteRenderTarget* target,
+                                                   uint32_t timeout_ms) {
+    if (!target || !target->frame_waitable) {
+        return true;
+    }
+    
+    return WaitForSingleObjectEx(target->frame_waitable, timeout_ms, TRUE) == WAIT_OBJECT_0;
+}
+
+extern "C" void qalam_dwrite_render_add_dirty_rect(
+    QalamDWriteRenderTarget* target,
+    float x,
+    float y,
+    float width,
+    float height)
+{
+    if (!target || !target->swap_chain || !(width > 0.0f) || !(height > 0.0f)) {
+        return;
+    }
+    
+    // Round outwards to whole pixels and clip to the back buffer
+    float dpi_x = 96.0f;
+    float dpi_y = 96.0f;
+    target->context->GetDpi(&dpi_x, &dpi_y);
+    D2D1_SIZE_U size = target->back_buffer ? target->back_buffer->GetPixelSize() : D2D1::SizeU(1, 1);
+    
+    float scale_x = dpi_x / 96.0f;
+    float scale_y = dpi_y / 96.0f;
+    LONG left = static_cast<LONG>(std::floor(x * scale_x));
+    LONG top = static_cast<LONG>(std::floor(y * scale_y));
+    LONG right = static_cast<LONG>(std::ceil((x + width) * scale_x));
+    LONG bottom = static_cast<LONG>(std::ceil((y + height) * scale_y));
+    if (left < 0) left = 0;
+    if (top < 0) top = 0;
+    if (right > static_cast<LONG>(size.width)) right = static_cast<LONG>(size.width);
+    if (bottom > static_cast<LONG>(size.height)) bottom = static_cast<LONG>(size.height);
+    if (left >= right || top >= bottom) {
+        return;
+    }
+    
+    RECT rect = { left, top, right, bottom };
+    if (!target->has_dirty) {
+        target->dirty = rect;
+        target->has_dirty = true;
+    } else {
+        target->dirty = rect_union(target->dirty, rect);
+    }
+    
+    // Fold the rect into any it overlaps or touches, which may in turn
+    // reach others; when the list is full, into the one that grows least
+    UINT count = target->dirty_count;
+    RECT* rects = target->dirty_rects;
+    for (UINT i = 0; i < count;) {
+        if (rects_touch(rects[i], rect)) {
+            rect = rect_union(rects[i], rect);
+            rects[i] = rects[--count];
+            i = 0;
+        } else {
+            i++;
+        }
+    }
+    if (count == kMaxDirtyRects) {
+        UINT best = 0;
+        for (UINT i = 1; i < count; i++) {
+            if (rect_area(rect_union(rects[i], rect)) - rect_area(rects[i]) <
+                rect_area(rect_union(rects[best], rect)) - rect_area(rects[best])) {
+                best = i;
+            }
+        }
+        rect = rect_union(rects[best], rect);
+        rects[best] = rects[--count];
+    }
+    rects[count++] = rect;
+    target->dirty_count = count;
+}
+
 extern "C" void qalam_dwrite_render_begin(QalamDWriteRenderTarget* target) {
     if (!target) {
         return;
     }
     
+    if (!target->target &&
+        FAILED(rt_recover(target, D2DERR_RECREATE_TARGET, "qalam_dwrite_render_begin"))) {
+        return;
+    }
+    
     target->target->BeginDraw();
+    
+    // Dirty-rect frames only touch the dirty region; the rest of the
+    // back buffer still holds the previous frame
+    target->clipped = target->swap_chain && target->has_dirty && !target->full_present;
+    if (target->clipped) {
+        float dpi_x = 96.0f;
+        float dpi_y = 96.0f;
+        target->context->GetDpi(&dpi_x, &dpi_y);
+        target->target->PushAxisAlignedClip(
+            D2D1::RectF(target->dirty.left * 96.0f / dpi_x, target->dirty.top * 96.0f / dpi_y,
+                        target->dirty.right * 96.0f / dpi_x, target->dirty.bottom * 96.0f / dpi_y),
+            D2D1_ANTIALIAS_MODE_ALIASED);
+    }
 }
 
 extern "C" QalamResult qalam_dwrite_render_end(QalamDWriteRenderTarget* target) {
@@ -683,23 +4273,52 @@ extern "C" QalamResult qalam_dwrite_render_end(QalamDWriteRenderTarget* target)
         return QALAM_ERROR_NULL_POINTER;
     }
     
+    if (!target->target) {
+        return QALAM_ERROR_RENDER_TARGET;
+    }
+    
+    if (target->clipped) {
+        target->target->PopAxisAlignedClip();
+        target->clipped = false;
+    }
+    
+    QALAM_TRACE_BEGIN(span, QALAM_TRACE_RENDER, "render_end");
     HRESULT hr = target->target->EndDraw();
     
+    if (SUCCEEDED(hr) && target->swap_chain) {
+        // Synchronized to vblank; DWM only recomposes the dirty region
+        DXGI_PRESENT_PARAMETERS params = {};
+        if (target->has_dirty && !target->full_present) {
+            params.DirtyRectsCount = target->dirty_count;
+            params.pDirtyRects = target->dirty_rects;
+        }
+        hr = target->swap_chain->Present1(1, 0, &params);
+        QALAM_TRACE_COUNTER(QALAM_TRACE_RENDER, "present_rects", params.DirtyRectsCount);
+    }
+    QALAM_TRACE_END(span);
+    
+    target->has_dirty = false;
+    target->dirty_count = 0;
+    
+    // The frame's scratch is done with once it is presented
+    qalam_frame_reset();
+    
     if (FAILED(hr)) {
-        if (hr == D2DERR_RECREATE_TARGET) {
-            log_error(hr, "qalam_dwrite_render_end", "Device lost - recreate target");
-            return QALAM_ERROR_RENDER_TARGET;
+        if (is_device_lost(hr)) {
+            return SUCCEEDED(rt_recover(target, hr, "qalam_dwrite_render_end"))
+                ? QALAM_OK : QALAM_ERROR_RENDER_TARGET;
         }
         
         log_error(hr, "qalam_dwrite_render_end", "EndDraw failed");
         return hr_to_result(hr);
     }
     
+    target->full_present = false;
     return QALAM_OK;
 }
 
 extern "C" void qalam_dwrite_render_clear(QalamDWriteRenderTarget* target, QalamDWriteColor color) {
-    if (!target) {
+    if (!target || !target->target) {
         return;
     }
     
@@ -713,10 +4332,47 @@ extern "C" void qalam_dwrite_render_draw_text(
     float y,
     QalamDWriteBrush* brush)
 {
-    if (!target || !layout || !brush) {
+    if (!target || !target->target || !layout || !brush || !brush->brush) {
         return;
     }
     
+    if (layout->shaped) {
+        DWRITE_GLYPH_RUN glyph_run = {};
+        glyph_run.fontFace = layout->format->font_face.Get();
+        glyph_run.fontEmSize = layout->format->format->GetFontSize();
+        
+        for (uint32_t i = 0; i < layout->run_count; i++) {
+            const PlacedRun& placed = layout->runs[i];
+            const ShapedRun* run = placed.run;
+            glyph_run.bidiLevel = placed.bidi_level;
+            if (layout->style_count > 0) {
+                draw_styled_run(target->target.Get(), layout, placed, &glyph_run,
+                                x + layout->origin_x + placed.x, y + layout->baseline, brush);
+                continue;
+            }
+            
+            glyph_run.glyphCount = run->glyph_count;
+            glyph_run.glyphIndices = run->glyphs;
+            glyph_run.glyphAdvances = run->advances;
+            glyph_run.glyphOffsets = run->offsets;
+            
+            // Right-to-left runs are drawn leftwards from their right edge
+            float origin = x + layout->origin_x + placed.x + (run->is_rtl ? run->width : 0.0f);
+            target->target->DrawGlyphRun(
+                D2D1::Point2F(origin, y + layout->baseline),
+                &glyph_run,
+                brush->brush.Get(),
+                DWRITE_MEASURING_MODE_NATURAL
+            );
+        }
+        return;
+    }
+    
+    if (layout->effects_dirty ||
+        (layout->has_effects && layout->effects_generation != target->device_generation)) {
+        layout_apply_effects(layout, target->device_generation);
+    }
+    
     target->target->DrawTextLayout(
         D2D1::Point2F(x, y),
         layout->layout.Get(),
@@ -734,7 +4390,7 @@ extern "C" void qalam_dwrite_render_draw_rect(
     QalamDWriteBrush* brush,
     bool filled)
 {
-    if (!target || !brush) {
+    if (!target || !target->target || !brush || !brush->brush) {
         return;
     }
     
@@ -756,7 +4412,7 @@ extern "C" void qalam_dwrite_render_draw_line(
     QalamDWriteBrush* brush,
     float stroke_width)
 {
-    if (!target || !brush) {
+    if (!target || !target->target || !brush || !brush->brush) {
         return;
     }
     
@@ -768,6 +4424,219 @@ extern "C" void qalam_dwrite_render_draw_line(
     );
 }
 
+/* ============================================================================
+ * Glyph Atlas
+ * ============================================================================ */
+
+extern "C" QalamResult qalam_dwrite_glyph_atlas_create(
+    QalamDWriteRenderTarget* target,
+    QalamDWriteTextFormat* format,
+    QalamDWriteGlyphAtlas** out_atlas)
+{
+    if (!target || !format || !out_atlas) {
+        return QALAM_ERROR_NULL_POINTER;
+    }
+    
+    if (!g_dwrite.initialized) {
+        return QALAM_ERROR_NOT_INITIALIZED;
+    }
+    
+    *out_atlas = nullptr;
+    
+    auto* atlas = layout_new<QalamDWriteGlyphAtlas>();
+    if (!atlas) {
+        return QALAM_ERROR_OUT_OF_MEMORY;
+    }
+    atlas->target = target;
+    atlas->font_size = format->format->GetFontSize();
+    
+    UINT32 name_length = format->format->GetFontFamilyNameLength() + 1;
+    atlas->family = layout_array<wchar_t>(name_length);
+    atlas->cluster_buckets = layout_array<AtlasCluster*>(kAtlasClusterBuckets, true);
+    HRESULT hr = atlas->family && atlas->cluster_buckets ? S_OK : E_OUTOFMEMORY;
+    if (SUCCEEDED(hr)) {
+        hr = format->format->GetFontFamilyName(atlas->family, name_length);
+    }
+    if (SUCCEEDED(hr)) {
+        format->format->GetFontCollection(atlas->fonts.GetAddressOf());
+    }
+    
+    // A style whose family is not installed is drawn from fallback fonts
+    for (uint32_t style = 0; SUCCEEDED(hr) && style < kAtlasStyleCount; style++) {
+        hr = atlas_create_style(atlas, format, style, &atlas->styles[style]);
+        IDWriteFontFace* face = SUCCEEDED(hr) ? format_font_face(atlas->styles[style]) : nullptr;
+        if (face) {
+            atlas_set_face(atlas, style, face);
+        }
+    }
+    if (FAILED(hr)) {
+        log_error(hr, "qalam_dwrite_glyph_atlas_create", "Failed to create style formats");
+        qalam_dwrite_glyph_atlas_destroy(atlas);
+        return hr_to_result(hr);
+    }
+    
+    // IDWriteFactory2 needs Windows 8.1; without it missing characters
+    // are drawn as the font's missing glyph
+    ComPtr<IDWriteFactory2> factory2;
+    if (SUCCEEDED(g_dwrite.dwrite_factory.As(&factory2))) {
+        factory2->GetSystemFontFallback(atlas->fallback.GetAddressOf());
+    }
+    
+    for (uint32_t style = 0; style < kAtlasStyleCount; style++) {
+        std::fill(atlas->ascii[style], atlas->ascii[style] + 128, kAtlasUnresolved);
+    }
+    
+    float dpi_y = 96.0f;
+    if (target->target) {
+        target->target->GetDpi(&atlas->dpi, &dpi_y);
+    }
+    atlas->scale = atlas->dpi / 96.0f;
+    atlas_measure_cell(atlas);
+    
+    *out_atlas = atlas;
+    return QALAM_OK;
+}
+
+extern "C" void qalam_dwrite_glyph_atlas_destroy(QalamDWriteGlyphAtlas* atlas) {
+    if (!atlas) {
+        return;
+    }
+    
+    if (atlas->cluster_buckets) {
+        atlas_clear_clusters(atlas);
+    }
+    layout_free(atlas->cluster_buckets);
+    for (uint32_t style = 0; style < kAtlasStyleCount; style++) {
+        layout_delete(atlas->styles[style]);
+    }
+    table_free(&atlas->chars);
+    table_free(&atlas->glyphs);
+    layout_free(atlas->keys);
+    layout_free(atlas->family);
+    layout_delete(atlas);
+}
+
+extern "C" void qalam_dwrite_glyph_atlas_get_cell_metrics(
+    QalamDWriteGlyphAtlas* atlas,
+    QalamDWriteCellMetrics* out_metrics)
+{
+    if (!atlas || !out_metrics) {
+        return;
+    }
+    
+    atlas_sync(atlas);
+    *out_metrics = atlas->cell;
+}
+
+extern "C" void qalam_dwrite_glyph_atlas_draw_cells(
+    QalamDWriteGlyphAtlas* atlas,
+    const uint32_t* codepoints,
+    uint32_t count,
+    uint32_t style,
+    float x,
+    float y,
+    QalamDWriteBrush* brush)
+{
+    if (!atlas || !codepoints || count == 0 || !brush || !brush->brush || !atlas_sync(atlas) ||
+        !atlas_reserve_keys(atlas, count)) {
+        return;
+    }
+    
+    style &= QALAM_DWRITE_GLYPH_BOLD | QALAM_DWRITE_GLYPH_ITALIC;
+    for (uint32_t i = 0; i < count; i++) {
+        atlas->keys[i] = codepoints[i] > L' ' ? atlas_char_key(atlas, codepoints[i], style) : 0;
+    }
+    atlas_rasterize(atlas, atlas->keys, count);
+    
+    // Cells start on whole pixels, so every copy of a glyph looks the same
+    float scale = atlas->scale;
+    float cell_width = std::round(atlas->cell.cell_width * scale);
+    float origin_x = std::round(x * scale);
+    float origin_y = std::round(y * scale) + std::round(atlas->cell.baseline * scale);
+    
+    D2D1_ANTIALIAS_MODE mode = atlas_begin_masks(atlas);
+    for (uint32_t i = 0; i < count; i++) {
+        if (atlas->keys[i]) {
+            atlas_draw_glyph(atlas, atlas->keys[i], origin_x + cell_width * i, origin_y,
+                             brush->brush.Get());
+        }
+    }
+    atlas_end_masks(atlas, mode);
+}
+
+extern "C" bool qalam_dwrite_glyph_atlas_draw_cluster(
+    QalamDWriteGlyphAtlas* atlas,
+    const wchar_t* text,
+    uint32_t length,
+    uint32_t cells,
+    bool is_rtl,
+    uint32_t style,
+    float x,
+    float y,
+    QalamDWriteBrush* brush)
+{
+    if (!atlas || !text || length == 0) {
+        return false;
+    }
+    
+    style &= QALAM_DWRITE_GLYPH_BOLD | QALAM_DWRITE_GLYPH_ITALIC;
+    AtlasCluster* cluster = atlas_get_cluster(atlas, text, length, is_rtl, style);
+    if (!cluster || !cluster->run) {
+        return false;
+    }
+    
+    const ShapedRun* run = cluster->run;
+    if (!brush || !brush->brush || !atlas_sync(atlas) || !atlas_reserve_keys(atlas, run->glyph_count)) {
+        return true;
+    }
+    
+    for (uint32_t i = 0; i < run->glyph_count; i++) {
+        atlas->keys[i] = (style + 1) << 16 | run->glyphs[i];
+    }
+    atlas_rasterize(atlas, atlas->keys, run->glyph_count);
+    
+    // Glyphs keep their size; only their positions are narrowed to fit
+    float scale = atlas->scale;
+    float span = cells * std::round(atlas->cell.cell_width * scale);
+    float width = run->width * scale;
+    float fit = width > span ? span / width : 1.0f;
+    float start = std::round(x * scale);
+    float baseline = std::round(y * scale) + std::round(atlas->cell.baseline * scale);
+    
+    D2D1_ANTIALIAS_MODE mode = atlas_begin_masks(atlas);
+    float pen = 0.0f;
+    for (uint32_t i = 0; i < run->glyph_count; i++) {
+        float advance = run->advances[i] * scale;
+        float offset = run->offsets[i].advanceOffset * scale;
+        
+        // Right-to-left glyphs are placed leftwards from the right edge
+        float glyph_x = is_rtl ? start + span - (pen + advance + offset) * fit
+                               : start + (pen + offset) * fit;
+        float glyph_y = baseline - run->offsets[i].ascenderOffset * scale;
+        atlas_draw_glyph(atlas, atlas->keys[i], std::round(glyph_x), std::round(glyph_y),
+                         brush->brush.Get());
+        pen += advance;
+    }
+    atlas_end_masks(atlas, mode);
+    return true;
+}
+
+extern "C" void qalam_dwrite_glyph_atlas_get_stats(
+    const QalamDWriteGlyphAtlas* atlas,
+    QalamDWriteGlyphAtlasStats* out_stats)
+{
+    if (!atlas || !out_stats) {
+        return;
+    }
+    
+    out_stats->glyph_count = atlas->glyphs.count;
+    out_stats->cluster_count = atlas->cluster_count;
+    out_stats->glyphs_rasterized = atlas->glyphs_rasterized;
+    out_stats->clusters_shaped = atlas->clusters_shaped;
+    out_stats->clusters_reused = atlas->clusters_reused;
+    out_stats->flushes = atlas->flushes;
+}
+
 /* ============================================================================
  * Utility Functions
  * ============================================================================ */
@@ -0,0 +1,938 @@
+/**
+ * @file editor_view.c
+ * @brief Qalam IDE - Virtualized Editor View Implementation
+ *
+ * The scroll position is held as an anchor line and an offset into it
+ * rather than as a pixel position: five million lines at twenty DIPs
+ * each is past the range a float can hold to the pixel, while the line
+ * number is exact and the offset stays below one line height.
+ *
+ * Each frame looks a line up in the layout cache by its generation
+ * first. Only on a miss is the line's text read from the buffer and
+ * laid out (or matched by content); that also gives the line its
+ * generation in the cache, so the next frame finds it without reading
+ * the text again.
+ *
+ * Changes to the buffer, the cursor and the scroll position mark the
+ * rows they touch dirty, as full-width bands of the viewport. An edit
+ * within a line marks that line; one that adds or removes lines marks
+ * from there to the bottom, since every row below it moved. Bands that
+ * touch are merged, so typing in one line leaves one line's rect to
+ * invalidate and present.
+ *
+ * Cursor movement, hit testing and selection painting work from the
+ * caret table each cached layout keeps, so none of them lays a line out
+ * again or walks its clusters.
+ *
+ * @version 0.0.2
+ * @copyright (c) 2026 Qalam Project
+ *
+ * @note Thread Safety: See editor_view.h.
+ */
+
+#include "editor_view.h"
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+/** Layout box width used to measure the line height */
+#define EDITOR_VIEW_MEASURE_WIDTH   100000.0f
+
+/*=============================================================================
+ * Internal Structures
+ *============================================================================*/
+
+/**
+ * @brief A line drawn by the current frame
+ */
+typedef struct EditorViewLine {
+    QalamDWriteTextLayout* layout;  /**< Cached layout (NULL for an empty line) */
+    float y;                        /**< Top of the line in the viewport */
+} EditorViewLine;
+
+/**
+ * @brief Editor view state
+ */
+struct EditorView {
+    QalamBuffer* buffer;            /**< Buffer shown, or NULL */
+    QalamDWriteLayoutCache* cache;  /**< Layouts of recently shown lines */
+    QalamDWriteLayoutKey key;       /**< Key shared by every line (but the generation) */
+    EditorViewOptions options;      /**< Options, line height resolved */
+    float width;                    /**< Viewport width in DIPs */
+    float height;                   /**< Viewport height in DIPs */
+
+    /* Scroll state */
+    size_t anchor_line;             /**< Line at the top of the viewport */
+    float anchor_offset;            /**< DIPs of it above the viewport, below one line */
+
+    /* Dirty region, as full-width bands in viewport DIPs */
+    QalamRect dirty[EDITOR_VIEW_MAX_DIRTY_RECTS]; /**< Disjoint dirty bands */
+    size_t dirty_count;             /**< Entries in 'dirty' */
+
+    /* Syntax highlighting */
+    QalamHighlighter* highlighter;  /**< Source of line styles, or NULL */
+    QalamDWriteBrush* style_brushes[QALAM_SYNTAX_STYLE_COUNT]; /**< Brush of each style */
+
+    /* Current frame */
+    EditorViewLine* lines;          /**< Visible lines of the frame */
+    size_t line_capacity;           /**< Allocated entries in 'lines' */
+    EditorViewStats stats;          /**< What the frame did */
+};
+
+/*=============================================================================
+ * Internal Helper Functions
+ *============================================================================*/
+
+/**
+ * @brief Get the number of lines in the shown buffer
+ */
+static size_t editor_view_line_count(const EditorView* view) {
+    return view->buffer ? qalam_buffer_get_line_count(view->buffer) : 0;
+}
+
+/**
+ * @brief Get the last line that may be at the top of the viewport
+ */
+static size_t editor_view_last_anchor(const EditorView* view) {
+    size_t count = editor_view_line_count(view);
+    return count > 0 ? count - 1 : 0;
+}
+
+/**
+ * @brief Pull the anchor back inside the buffer (it may have shrunk)
+ */
+static void editor_view_clamp_anchor(EditorView* view) {
+    size_t last = editor_view_last_anchor(view);
+    if (view->anchor_line >= last) {
+        view->anchor_line = last;
+        view->anchor_offset = 0.0f;
+    }
+}
+
+/**
+ * @brief Add a band of rows to the dirty region
+ */
+static void editor_view_mark_band(EditorView* view, double top, double bottom) {
+    if (top < 0.0) {
+        top = 0.0;
+    }
+    if (bottom > view->height) {
+        bottom = view->height;
+    }
+    if (!(top < bottom)) {
+        return;
+    }
+
+    /* Fold in every band it overlaps or touches */
+    QalamRect band = { 0.0f, (float)top, view->width, (float)bottom };
+    for (size_t i = 0; i < view->dirty_count;) {
+        QalamRect* other = &view->dirty[i];
+        if (other->top <= band.bottom && band.top <= other->bottom) {
+            band.top = other->top < band.top ? other->top : band.top;
+            band.bottom = other->bottom > band.bottom ? other->bottom : band.bottom;
+            *other = view->dirty[--view->dirty_count];
+            i = 0;
+        } else {
+            i++;
+        }
+    }
+
+    /* Out of entries: merge with the nearest band */
+    if (view->dirty_count == EDITOR_VIEW_MAX_DIRTY_RECTS) {
+        size_t nearest = 0;
+        float nearest_gap = 0.0f;
+        for (size_t i = 0; i < view->dirty_count; i++) {
+            const QalamRect* other = &view->dirty[i];
+            float gap = other->top > band.bottom ? other->top - band.bottom
+                                                 : band.top - other->bottom;
+            if (i == 0 || gap < nearest_gap) {
+                nearest = i;
+                nearest_gap = gap;
+            }
+        }
+        QalamRect* other = &view->dirty[nearest];
+        band.top = other->top < band.top ? other->top : band.top;
+        band.bottom = other->bottom > band.bottom ? other->bottom : band.bottom;
+        *other = view->dirty[--view->dirty_count];
+    }
+
+    view->dirty[view->dirty_count++] = band;
+}
+
+/**
+ * @brief Add the rows of lines [first, end) to the dirty region
+ *
+ * @param end Line after the last one, or SIZE_MAX for the bottom of the viewport
+ */
+static void editor_view_mark_lines(EditorView* view, size_t first, size_t end) {
+    if (end <= view->anchor_line || first >= end) {
+        return;
+    }
+
+    double line_height = view->options.line_height;
+    double origin = (double)view->options.padding_top - view->anchor_offset;
+    double top = first < view->anchor_line
+        ? 0.0 : origin + (double)(first - view->anchor_line) * line_height;
+    double bottom = end == SIZE_MAX
+        ? view->height : origin + (double)(end - view->anchor_line) * line_height;
+    editor_view_mark_band(view, top, bottom);
+}
+
+/**
+ * @brief Mark the whole viewport dirty
+ */
+static void editor_view_mark_all(EditorView* view) {
+    view->dirty_count = 0;
+    editor_view_mark_band(view, 0.0, view->height);
+}
+
+/**
+ * @brief Measure the height of one line of a format
+ */
+static QalamResult editor_view_measure_line(QalamDWriteTextFormat* format, float* height) {
+    static const wchar_t sample[] = L"Mم";
+    QalamDWriteTextLayout* layout = NULL;
+    QalamDWriteTextMetrics metrics;
+
+    QalamResult result = qalam_dwrite_text_layout_create(
+        sample, (uint32_t)(sizeof(sample) / sizeof(sample[0]) - 1), format,
+        EDITOR_VIEW_MEASURE_WIDTH, EDITOR_VIEW_MEASURE_WIDTH, &layout);
+    if (result != QALAM_OK) {
+        return result;
+    }
+
+    result = qalam_dwrite_text_layout_get_metrics(layout, &metrics);
+    qalam_dwrite_text_layout_destroy(layout);
+    if (result != QALAM_OK) {
+        return result;
+    }
+    if (!(metrics.height > 0.0f)) {
+        return QALAM_ERROR_INVALID_ARGUMENT;
+    }
+
+    *height = metrics.height;
+    return QALAM_OK;
+}
+
+/**
+ * @brief Get the layout of a line for the current frame
+ *
+ * @param[out] out_layout Receives the layout, or NULL for an empty line
+ */
+static QalamResult editor_view_lookup(EditorView* view, size_t line,
+                                      QalamDWriteTextLayout** out_layout) {
+    QalamTextView text;
+
+    *out_layout = NULL;
+
+    view->key.generation = qalam_buffer_get_line_generation(view->buffer, line);
+    if (view->key.generation != 0) {
+        *out_layout = qalam_dwrite_layout_cache_find(view->cache, &view->key);
+        if (*out_layout) {
+            return QALAM_OK;
+        }
+    }
+
+    /* Generation not seen yet: read the line (only the cursor line can
+     * straddle the gap, so asking for one segment is cheap) */
+    QalamResult result = qalam_buffer_get_line_view(view->buffer, line, true, &text);
+    if (result != QALAM_OK) {
+        return result;
+    }
+    view->stats.lines_fetched++;
+
+    if (text.length == 0) {
+        return QALAM_OK;
+    }
+
+    uint32_t length = text.length > UINT32_MAX ? UINT32_MAX : (uint32_t)text.length;
+    return qalam_dwrite_layout_cache_get(view->cache, text.segments[0], length,
+                                         &view->key, out_layout);
+}
+
+/**
+ * @brief Get the caret x of a text position on a line
+ *
+ * @param layout Line layout, or NULL for an empty line
+ */
+static QalamResult editor_view_caret_x(const EditorView* view, QalamDWriteTextLayout* layout,
+                                       size_t column, float* x) {
+    if (!layout) {
+        /* An empty line's caret stands where its text would start */
+        *x = qalam_dwrite_text_format_is_rtl(view->key.format) ? view->key.max_width : 0.0f;
+        return QALAM_OK;
+    }
+
+    uint32_t position = column > UINT32_MAX ? UINT32_MAX : (uint32_t)column;
+    return qalam_dwrite_text_layout_caret_x(layout, position, x);
+}
+
+/*=============================================================================
+ * Lifecycle
+ *============================================================================*/
+
+/**
+ * @brief Get default editor view options
+ */
+QalamResult editor_view_get_default_options(EditorViewOptions* options) {
+    if (!options) {
+        return QALAM_ERROR_NULL_POINTER;
+    }
+
+    memset(options, 0, sizeof(EditorViewOptions));
+    options->line_height = 0.0f;
+    options->padding_left = 8.0f;
+    options->padding_right = 8.0f;
+    options->padding_top = 4.0f;
+    options->overscan_lines = EDITOR_VIEW_DEFAULT_OVERSCAN;
+    options->cache_budget = 0;
+
+    return QALAM_OK;
+}
+
+/**
+ * @brief Create an editor view
+ */
+QalamResult editor_view_create(EditorView** view, QalamDWriteTextFormat* format,
+                               const EditorViewOptions* options) {
+    if (!view || !format) {
+        return QALAM_ERROR_NULL_POINTER;
+    }
+
+    *view = NULL;
+
+    EditorView* v = (EditorView*)qalam_mem_calloc(QALAM_MEMORY_UI, 1, sizeof(EditorView));
+    if (!v) {
+        return QALAM_ERROR_OUT_OF_MEMORY;
+    }
+
+    if (options) {
+        v->options = *options;
+    } else {
+        editor_view_get_default_options(&v->options);
+    }
+
+    QalamResult result = QALAM_OK;
+    if (!(v->options.line_height > 0.0f)) {
+        result = editor_view_measure_line(format, &v->options.line_height);
+    }
+    if (result == QALAM_OK) {
+        result = qalam_dwrite_layout_cache_create(v->options.cache_budget, &v->cache);
+    }
+    if (result != QALAM_OK) {
+        qalam_mem_free(v);
+        return result;
+    }
+
+    v->key.format = format;
+    v->key.max_width = 1.0f;
+    v->key.max_height = v->options.line_height;
+    v->key.dpi = 96.0f;
+
+    *view = v;
+    return QALAM_OK;
+}
+
+/**
+ * @brief Destroy an editor view
+ */
+void editor_view_destroy(EditorView* view) {
+    if (!view) {
+        return;
+    }
+
+    qalam_dwrite_layout_cache_destroy(view->cache);
+    qalam_mem_free(view->lines);
+    qalam_mem_free(view);
+}
+
+/**
+ * @brief Show a buffer, scrolled to its first line
+ */
+void editor_view_set_buffer(EditorView* view, QalamBuffer* buffer) {
+    if (!view) {
+        return;
+    }
+
+    view->buffer = buffer;
+    view->anchor_line = 0;
+    view->anchor_offset = 0.0f;
+    memset(&view->stats, 0, sizeof(EditorViewStats));
+    editor_view_mark_all(view);
+}
+
+/**
+ * @brief Draw the shown buffer with a highlighter's styles
+ */
+void editor_view_set_highlighter(EditorView* view, QalamHighlighter* highlighter,
+                                 QalamDWriteBrush* const* brushes, size_t brush_count) {
+    if (!view) {
+        return;
+    }
+
+    memset(view->style_brushes, 0, sizeof(view->style_brushes));
+    if (brush_count > QALAM_SYNTAX_STYLE_COUNT) {
+        brush_count = QALAM_SYNTAX_STYLE_COUNT;
+    }
+    if (brushes) {
+        memcpy(view->style_brushes, brushes, brush_count * sizeof(QalamDWriteBrush*));
+    }
+    view->highlighter = highlighter;
+    editor_view_mark_all(view);
+}
+
+/**
+ * @brief Set the viewport size and DPI
+ */
+QalamResult editor_view_resize(EditorView* view, float width, float height, float dpi) {
+    if (!view) {
+        return QALAM_ERROR_NULL_POINTER;
+    }
+
+    if (!(width >= 0.0f) || !(height >= 0.0f) || !(dpi > 0.0f)) {
+        return QALAM_ERROR_INVALID_ARGUMENT;
+    }
+
+    view->width = width;
+    view->height = height;
+
+    /* Layouts of the old width or DPI no longer match the key and age out */
+    float text_width = width - view->options.padding_left - view->options.padding_right;
+    view->key.max_width = text_width > 1.0f ? text_width : 1.0f;
+    view->key.dpi = dpi;
+    editor_view_mark_all(view);
+
+    return QALAM_OK;
+}
+
+/*=============================================================================
+ * Scrolling
+ *============================================================================*/
+
+/**
+ * @brief Scroll so a line is at the top of the viewport
+ */
+void editor_view_scroll_to_line(EditorView* view, size_t line_number) {
+    if (!view) {
+        return;
+    }
+
+    size_t anchor = view->anchor_line;
+    float offset = view->anchor_offset;
+    view->anchor_line = line_number;
+    view->anchor_offset = 0.0f;
+    editor_view_clamp_anchor(view);
+
+    if (view->anchor_line != anchor || view->anchor_offset != offset) {
+        editor_view_mark_all(view);
+    }
+}
+
+/**
+ * @brief Move the scroll anchor by a distance
+ */
+static void editor_view_move_anchor(EditorView* view, float delta) {
+    double line_height = view->options.line_height;
+    double position = (double)view->anchor_offset + delta;
+    double steps = floor(position / line_height);
+    float offset = (float)(position - steps * line_height);
+
+    if (steps < 0.0) {
+        if (-steps > (double)view->anchor_line) {
+            view->anchor_line = 0;
+            view->anchor_offset = 0.0f;
+            return;
+        }
+        view->anchor_line -= (size_t)-steps;
+    } else {
+        size_t last = editor_view_last_anchor(view);
+        if (view->anchor_line > last || steps >= (double)(last - view->anchor_line)) {
+            view->anchor_line = last;
+            view->anchor_offset = 0.0f;
+            return;
+        }
+        view->anchor_line += (size_t)steps;
+    }
+
+    view->anchor_offset = offset < (float)line_height ? offset : 0.0f;
+}
+
+/**
+ * @brief Scroll by a distance
+ */
+void editor_view_scroll_by(EditorView* view, float delta) {
+    if (!view || !isfinite(delta)) {
+        return;
+    }
+
+    size_t anchor = view->anchor_line;
+    float offset = view->anchor_offset;
+    editor_view_move_anchor(view, delta);
+
+    if (view->anchor_line != anchor || view->anchor_offset != offset) {
+        editor_view_mark_all(view);
+    }
+}
+
+/**
+ * @brief Get the line at the top of the viewport
+ */
+size_t editor_view_get_anchor_line(const EditorView* view, float* offset) {
+    if (!view) {
+        if (offset) {
+            *offset = 0.0f;
+        }
+        return 0;
+    }
+
+    if (offset) {
+        *offset = view->anchor_offset;
+    }
+    return view->anchor_line;
+}
+
+/**
+ * @brief Get the line under a vertical position of the viewport
+ */
+size_t editor_view_line_at(const EditorView* view, float y) {
+    if (!view) {
+        return 0;
+    }
+
+    double position = (double)y - view->options.padding_top + view->anchor_offset;
+    if (!(position > 0.0)) {
+        return view->anchor_line;
+    }
+    return view->anchor_line + (size_t)(position / view->options.line_height);
+}
+
+/**
+ * @brief Keep the anchor on the same text after a buffer change
+ */
+void editor_view_on_buffer_change(EditorView* view, const QalamBufferChange* change) {
+    if (!view || !change) {
+        return;
+    }
+
+    size_t anchor = view->anchor_line;
+    float offset = view->anchor_offset;
+    size_t old_end = change->first_line + change->old_line_count;
+
+    if (change->first_line > anchor) {
+        /* Below the anchor */
+    } else if (old_end <= anchor) {
+        /* Entirely above the anchor: follow the anchor's text, so nothing
+         * on screen moves */
+        view->anchor_line = anchor - change->old_line_count + change->new_line_count;
+        editor_view_clamp_anchor(view);
+        return;
+    } else {
+        /* The anchor line itself was replaced: stay within what replaced it */
+        size_t into = anchor - change->first_line;
+        if (into >= change->new_line_count) {
+            view->anchor_line = change->first_line + change->new_line_count - 1;
+            view->anchor_offset = 0.0f;
+        }
+    }
+    editor_view_clamp_anchor(view);
+
+    if (view->anchor_line != anchor || view->anchor_offset != offset) {
+        editor_view_mark_all(view);
+    } else if (change->old_line_count == change->new_line_count) {
+        editor_view_mark_lines(view, change->first_line, change->first_line + change->new_line_count);
+    } else {
+        editor_view_mark_lines(view, change->first_line, SIZE_MAX);
+    }
+}
+
+/*=============================================================================
+ * Dirty Region
+ *============================================================================*/
+
+/**
+ * @brief Mark lines dirty
+ */
+void editor_view_invalidate_lines(EditorView* view, size_t first_line, size_t line_count) {
+    if (!view || line_count == 0) {
+        return;
+    }
+
+    size_t end = line_count > SIZE_MAX - first_line ? SIZE_MAX : first_line + line_count;
+    editor_view_mark_lines(view, first_line, end);
+}
+
+/**
+ * @brief Mark the whole viewport dirty
+ */
+void editor_view_invalidate(EditorView* view) {
+    if (view) {
+        editor_view_mark_all(view);
+    }
+}
+
+/**
+ * @brief Get the dirty region
+ */
+size_t editor_view_get_dirty_rects(const EditorView* view, QalamRect* rects, size_t max_rects) {
+    if (!view) {
+        return 0;
+    }
+
+    size_t count = view->dirty_count < max_rects ? view->dirty_count : max_rects;
+    if (rects && count > 0) {
+        memcpy(rects, view->dirty, count * sizeof(QalamRect));
+    }
+    return view->dirty_count;
+}
+
+/**
+ * @brief Hand the dirty region to a render target and clear it
+ */
+void editor_view_submit_dirty_rects(EditorView* view, QalamDWriteRenderTarget* target) {
+    if (!view) {
+        return;
+    }
+
+    for (size_t i = 0; target && i < view->dirty_count; i++) {
+        const QalamRect* rect = &view->dirty[i];
+        qalam_dwrite_render_add_dirty_rect(target, rect->left, rect->top,
+                                           rect->right - rect->left, rect->bottom - rect->top);
+    }
+    view->dirty_count = 0;
+}
+
+/*=============================================================================
+ * Rendering
+ *============================================================================*/
+
+/**
+ * @brief Lay out the lines of the next frame
+ */
+QalamResult editor_view_layout(EditorView* view) {
+    if (!view) {
+        return QALAM_ERROR_NULL_POINTER;
+    }
+
+    qalam_dwrite_layout_cache_begin_frame(view->cache);
+    memset(&view->stats, 0, sizeof(EditorViewStats));
+
+    size_t line_count = editor_view_line_count(view);
+    if (line_count == 0) {
+        return QALAM_OK;
+    }
+    editor_view_clamp_anchor(view);
+
+    /* Lines reaching into the viewport, from the anchor down */
+    float line_height = view->options.line_height;
+    float top = view->options.padding_top - view->anchor_offset;
+    size_t visible = 0;
+    if (view->height > top) {
+        visible = (size_t)ceilf((view->height - top) / line_height);
+    }
+    if (visible > line_count - view->anchor_line) {
+        visible = line_count - view->anchor_line;
+    }
+
+    if (visible > view->line_capacity) {
+        EditorViewLine* lines = (EditorViewLine*)qalam_mem_realloc(
+            QALAM_MEMORY_UI, view->lines, visible * sizeof(EditorViewLine));
+        if (!lines) {
+            return QALAM_ERROR_OUT_OF_MEMORY;
+        }
+        view->lines = lines;
+        view->line_capacity = visible;
+    }
+
+    size_t overscan = view->options.overscan_lines;
+    size_t first = view->anchor_line - (view->anchor_line < overscan ? view->anchor_line : overscan);
+    size_t end = view->anchor_line + visible;
+    end = line_count - end > overscan ? end + overscan : line_count;
+
+    view->stats.first_line = view->anchor_line;
+    view->stats.visible_lines = visible;
+    if (view->highlighter) {
+        qalam_highlighter_set_viewport(view->highlighter, first, end - first);
+    }
+
+    for (size_t line = first; line < end; line++) {
+        QalamDWriteTextLayout* layout = NULL;
+        QalamResult result = editor_view_lookup(view, line, &layout);
+        view->stats.lines_laid_out++;
+        if (result != QALAM_OK) {
+            view->stats.visible_lines = 0;
+            return result;
+        }
+
+        if (line >= view->anchor_line && line < view->anchor_line + visible) {
+            EditorViewLine* entry = &view->lines[line - view->anchor_line];
+            entry->layout = layout;
+            entry->y = top + (float)(line - view->anchor_line) * line_height;
+        }
+    }
+
+    return QALAM_OK;
+}
+
+/**
+ * @brief Lay out and draw the visible lines
+ */
+QalamResult editor_view_render(EditorView* view, QalamDWriteRenderTarget* target,
+                               QalamDWriteBrush* brush) {
+    if (!view || !target || !brush) {
+        return QALAM_ERROR_NULL_POINTER;
+    }
+
+    QalamResult result = editor_view_layout(view);
+    if (result != QALAM_OK) {
+        return result;
+    }
+
+    editor_view_draw_text(view, target, brush);
+    return QALAM_OK;
+}
+
+/**
+ * @brief Draw the lines laid out by the last editor_view_layout()
+ */
+void editor_view_draw_text(EditorView* view, QalamDWriteRenderTarget* target,
+                           QalamDWriteBrush* brush) {
+    if (!view || !target || !brush) {
+        return;
+    }
+
+    for (size_t i = 0; i < view->stats.visible_lines; i++) {
+        QalamDWriteTextLayout* layout = view->lines[i].layout;
+        if (layout) {
+            /* Lines with the same text share a layout: style it for this one */
+            const QalamStyleRange* ranges = NULL;
+            size_t count = 0;
+            if (view->highlighter) {
+                count = qalam_highlighter_get_line_styles(view->highlighter,
+                                                          view->stats.first_line + i, &ranges);
+            }
+            if (qalam_dwrite_text_layout_set_styles(layout, ranges, (uint32_t)count,
+                                                    view->style_brushes,
+                                                    QALAM_SYNTAX_STYLE_COUNT) != QALAM_OK) {
+                qalam_dwrite_text_layout_set_styles(layout, NULL, 0, NULL, 0);
+            }
+            qalam_dwrite_render_draw_text(target, layout,
+                                          view->options.padding_left, view->lines[i].y,
+                                          brush);
+        }
+    }
+}
+
+/**
+ * @brief Fill the buffer's selection on the lines laid out by the last
+ *        editor_view_layout()
+ */
+QalamResult editor_view_draw_selection(EditorView* view, QalamDWriteRenderTarget* target,
+                                       QalamDWriteBrush* brush) {
+    QalamDWriteSpan spans[EDITOR_VIEW_MAX_SELECTION_SPANS];
+    QalamSelection selection;
+
+    if (!view || !target || !brush) {
+        return QALAM_ERROR_NULL_POINTER;
+    }
+    if (!view->buffer || view->stats.visible_lines == 0) {
+        return QALAM_OK;
+    }
+
+    QalamResult result = qalam_buffer_get_selection(view->buffer, &selection);
+    if (result != QALAM_OK || !selection.is_active) {
+        return result;
+    }
+
+    QalamCursor start = selection.start;
+    QalamCursor end = selection.end;
+    if (end.line < start.line || (end.line == start.line && end.column < start.column)) {
+        start = selection.end;
+        end = selection.start;
+    }
+
+    size_t first = view->anchor_line;
+    for (size_t i = 0; i < view->stats.visible_lines; i++) {
+        size_t line = first + i;
+        QalamDWriteTextLayout* layout = view->lines[i].layout;
+        if (line < start.line || line > end.line || !layout) {
+            continue;
+        }
+
+        size_t from = line == start.line ? start.column : 0;
+        size_t to = line == end.line ? end.column : UINT32_MAX;
+        uint32_t count = 0;
+        result = qalam_dwrite_text_layout_get_range_spans(
+            layout, from > UINT32_MAX ? UINT32_MAX : (uint32_t)from,
+            to > UINT32_MAX ? UINT32_MAX : (uint32_t)to,
+            spans, EDITOR_VIEW_MAX_SELECTION_SPANS, &count);
+        if (result != QALAM_OK) {
+            return result;
+        }
+
+        /* Past the array only the last span is cut short; it still ends
+         * where the selection does */
+        if (count > EDITOR_VIEW_MAX_SELECTION_SPANS) {
+            count = EDITOR_VIEW_MAX_SELECTION_SPANS;
+        }
+        for (uint32_t s = 0; s < count; s++) {
+            qalam_dwrite_render_draw_rect(target, view->options.padding_left + spans[s].left,
+                                          view->lines[i].y, spans[s].right - spans[s].left,
+                                          view->options.line_height, brush, true);
+        }
+    }
+
+    return QALAM_OK;
+}
+
+/*=============================================================================
+ * Cursor and Hit Testing
+ *============================================================================*/
+
+/**
+ * @brief Move the cursor one caret stop left or right on screen
+ */
+QalamResult editor_view_move_cursor_visual(EditorView* view, int direction) {
+    QalamDWriteTextLayout* layout = NULL;
+    QalamCursor cursor;
+
+    if (!view) {
+        return QALAM_ERROR_NULL_POINTER;
+    }
+    if (!view->buffer || direction == 0) {
+        return QALAM_OK;
+    }
+
+    QalamResult result = qalam_buffer_get_cursor(view->buffer, &cursor);
+    if (result == QALAM_OK) {
+        result = editor_view_lookup(view, cursor.line, &layout);
+    }
+    if (result != QALAM_OK) {
+        return result;
+    }
+
+    if (layout) {
+        uint32_t column = cursor.column > UINT32_MAX ? UINT32_MAX : (uint32_t)cursor.column;
+        uint32_t moved = column;
+        result = qalam_dwrite_text_layout_caret_move(layout, column, direction, &moved);
+        if (result != QALAM_OK) {
+            return result;
+        }
+        if (moved != column) {
+            editor_view_mark_lines(view, cursor.line, cursor.line + 1);
+            return qalam_buffer_set_cursor(view->buffer, cursor.line, moved);
+        }
+    }
+
+    /* At the edge of the line: continue on the next line in reading order,
+     * which for a right-to-left format is the one before when moving left */
+    bool forward = (direction > 0) != qalam_dwrite_text_format_is_rtl(view->key.format);
+    size_t line = cursor.line;
+    size_t column = 0;
+    if (forward && line + 1 < editor_view_line_count(view)) {
+        line++;
+    } else if (!forward && line > 0) {
+        line--;
+        column = SIZE_MAX;
+    } else {
+        return QALAM_OK;
+    }
+
+    editor_view_mark_lines(view, cursor.line, cursor.line + 1);
+    editor_view_mark_lines(view, line, line + 1);
+    return qalam_buffer_set_cursor(view->buffer, line, column);
+}
+
+/**
+ * @brief Find the line and column of the caret stop nearest to a point
+ */
+QalamResult editor_view_hit_test(EditorView* view, float x, float y,
+                                 size_t* line, size_t* column) {
+    QalamDWriteTextLayout* layout = NULL;
+
+    if (!view || !line || !column) {
+        return QALAM_ERROR_NULL_POINTER;
+    }
+
+    *line = 0;
+    *column = 0;
+    size_t line_count = editor_view_line_count(view);
+    if (line_count == 0) {
+        return QALAM_OK;
+    }
+
+    size_t hit = editor_view_line_at(view, y);
+    if (hit >= line_count) {
+        hit = line_count - 1;
+    }
+
+    QalamResult result = editor_view_lookup(view, hit, &layout);
+    if (result != QALAM_OK) {
+        return result;
+    }
+
+    uint32_t position = 0;
+    if (layout) {
+        result = qalam_dwrite_text_layout_caret_at(layout, x - view->options.padding_left,
+                                                   &position);
+        if (result != QALAM_OK) {
+            return result;
+        }
+    }
+
+    *line = hit;
+    *column = position;
+    return QALAM_OK;
+}
+
+/**
+ * @brief Get where the cursor's caret is drawn
+ */
+QalamResult editor_view_get_caret_point(EditorView* view, float* x, float* y) {
+    QalamDWriteTextLayout* layout = NULL;
+    QalamCursor cursor;
+
+    if (!view || !x || !y) {
+        return QALAM_ERROR_NULL_POINTER;
+    }
+
+    *x = view->options.padding_left;
+    *y = view->options.padding_top;
+    if (!view->buffer) {
+        return QALAM_OK;
+    }
+
+    QalamResult result = qalam_buffer_get_cursor(view->buffer, &cursor);
+    if (result == QALAM_OK) {
+        result = editor_view_lookup(view, cursor.line, &layout);
+    }
+
+    float caret = 0.0f;
+    if (result == QALAM_OK) {
+        result = editor_view_caret_x(view, layout, cursor.column, &caret);
+    }
+    if (result != QALAM_OK) {
+        return result;
+    }
+
+    double lines = (double)cursor.line - (double)view->anchor_line;
+    *x = view->options.padding_left + caret;
+    *y = (float)(view->options.padding_top - view->anchor_offset +
+                 lines * view->options.line_height);
+    return QALAM_OK;
+}
+
+/**
+ * @brief Get what the last frame did
+ */
+void editor_view_get_stats(const EditorView* view, EditorViewStats* stats) {
+    if (!stats) {
+        return;
+    }
+
+    if (!view) {
+        memset(stats, 0, sizeof(EditorViewStats));
+        return;
+    }
+
+    *stats = view->stats;
+}
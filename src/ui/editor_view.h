@@ -0,0 +1,370 @@
+/**
+ * @file editor_view.h
+ * @brief Qalam IDE - Virtualized Editor View (Internal Header)
+ *
+ * Internal header for the view that draws a buffer into a window. The
+ * view never walks the document: it keeps a scroll anchor (the line at
+ * the top of the viewport and how far it is scrolled past) and, each
+ * frame, asks the buffer only for the lines that reach into the
+ * viewport plus a few lines of overscan above and below. Lines are
+ * laid out once through a layout cache keyed on their change
+ * generation, so a line whose generation is unchanged is drawn again
+ * without reading its text. Frame cost therefore depends on the
+ * viewport height, not on the size of the buffer.
+ *
+ * Edits, cursor moves and scrolling mark the rows they change dirty, so
+ * a frame can redraw and present only those (see "Dirty Region").
+ *
+ * Lines have a single, fixed height and are not wrapped, so the line
+ * at any vertical position is found with a division and a line's caret
+ * positions are a single row of caret stops.
+ *
+ * @version 0.0.2
+ * @copyright (c) 2026 Qalam Project
+ *
+ * @note Thread Safety: Not thread-safe. Use the view from the thread
+ *       that owns its buffer.
+ */
+
+#ifndef QALAM_EDITOR_VIEW_H
+#define QALAM_EDITOR_VIEW_H
+
+#include "qalam.h"
+#include "editor.h"
+#include "ui.h"
+#include "dwrite_api.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*=============================================================================
+ * Configuration Constants
+ *============================================================================*/
+
+/** Default lines laid out above and below the viewport */
+#define EDITOR_VIEW_DEFAULT_OVERSCAN    4
+
+/** Most separate dirty bands kept; more are merged with their nearest */
+#define EDITOR_VIEW_MAX_DIRTY_RECTS     8
+
+/** Most separate selection spans filled on one line */
+#define EDITOR_VIEW_MAX_SELECTION_SPANS 16
+
+/*=============================================================================
+ * Editor View Structures
+ *============================================================================*/
+
+/**
+ * @brief Editor view options
+ */
+typedef struct EditorViewOptions {
+    float line_height;              /**< Line height in DIPs (0 to measure the format) */
+    float padding_left;             /**< Space left of the text in DIPs */
+    float padding_right;            /**< Space right of the text in DIPs */
+    float padding_top;              /**< Space above the first line in DIPs */
+    size_t overscan_lines;          /**< Lines laid out beyond each edge of the viewport */
+    size_t cache_budget;            /**< Layout cache budget in bytes (0 for the default) */
+} EditorViewOptions;
+
+/**
+ * @brief What the last frame did
+ */
+typedef struct EditorViewStats {
+    size_t first_line;              /**< First line reaching into the viewport */
+    size_t visible_lines;           /**< Lines reaching into the viewport */
+    size_t lines_laid_out;          /**< Lines looked up, overscan included */
+    size_t lines_fetched;           /**< Lines whose text had to be read from the buffer */
+} EditorViewStats;
+
+/**
+ * @brief Opaque editor view
+ */
+typedef struct EditorView EditorView;
+
+/*=============================================================================
+ * Lifecycle
+ *============================================================================*/
+
+/**
+ * @brief Get default editor view options
+ *
+ * @param[out] options Pointer to options structure to fill
+ * @return QALAM_OK on success
+ */
+QalamResult editor_view_get_default_options(EditorViewOptions* options);
+
+/**
+ * @brief Create an editor view
+ *
+ * The view owns its layout cache. DirectWrite must be initialized.
+ *
+ * @param[out] view Receives the view
+ * @param format Text format for every line (must outlive the view)
+ * @param options View options (NULL for defaults)
+ * @return QALAM_OK on success, error code on failure
+ */
+QalamResult editor_view_create(EditorView** view, QalamDWriteTextFormat* format,
+                               const EditorViewOptions* options);
+
+/**
+ * @brief Destroy an editor view and its cached layouts
+ *
+ * @param view View to destroy (may be NULL)
+ */
+void editor_view_destroy(EditorView* view);
+
+/**
+ * @brief Show a buffer, scrolled to its first line
+ *
+ * @param view Editor view
+ * @param buffer Buffer to show (NULL for none; must outlive its use)
+ */
+void editor_view_set_buffer(EditorView* view, QalamBuffer* buffer);
+
+/**
+ * @brief Draw the shown buffer with a highlighter's styles
+ *
+ * Each frame tells the highlighter which lines it lays out, so those
+ * are lexed first, and draws each line with the styles the highlighter
+ * has for it. Styles only change brushes, so restyling a line does not
+ * lay it out again. After qalam_highlighter_update() reports lines,
+ * pass them to editor_view_invalidate_lines().
+ *
+ * @param view Editor view
+ * @param highlighter Highlighter of the shown buffer (NULL to draw
+ *        unstyled; must outlive its use)
+ * @param brushes Brush of each QalamSyntaxStyle, NULL entries for the
+ *        text brush (copied; the brushes must outlive their use)
+ * @param brush_count Entries in 'brushes' (at most
+ *        QALAM_SYNTAX_STYLE_COUNT are used)
+ */
+void editor_view_set_highlighter(EditorView* view, QalamHighlighter* highlighter,
+                                 QalamDWriteBrush* const* brushes, size_t brush_count);
+
+/**
+ * @brief Set the viewport size and DPI
+ *
+ * @param view Editor view
+ * @param width Viewport width in DIPs
+ * @param height Viewport height in DIPs
+ * @param dpi DPI the view is drawn at
+ * @return QALAM_OK on success, QALAM_ERROR_INVALID_ARGUMENT for a
+ *         negative size or a DPI that is not positive
+ */
+QalamResult editor_view_resize(EditorView* view, float width, float height, float dpi);
+
+/*=============================================================================
+ * Scrolling
+ *============================================================================*/
+
+/**
+ * @brief Scroll so a line is at the top of the viewport
+ *
+ * @param view Editor view
+ * @param line_number Line number (0-based; clamped to the last line)
+ */
+void editor_view_scroll_to_line(EditorView* view, size_t line_number);
+
+/**
+ * @brief Scroll by a distance
+ *
+ * @param view Editor view
+ * @param delta DIPs to scroll (positive moves towards the end)
+ */
+void editor_view_scroll_by(EditorView* view, float delta);
+
+/**
+ * @brief Get the line at the top of the viewport
+ *
+ * @param view Editor view
+ * @param[out] offset DIPs of that line scrolled above the viewport (optional)
+ * @return Anchor line number
+ */
+size_t editor_view_get_anchor_line(const EditorView* view, float* offset);
+
+/**
+ * @brief Get the line under a vertical position of the viewport
+ *
+ * @param view Editor view
+ * @param y Position in DIPs from the top of the viewport
+ * @return Line number (not clamped to the buffer)
+ */
+size_t editor_view_line_at(const EditorView* view, float y);
+
+/**
+ * @brief Keep the anchor on the same text after a buffer change
+ *
+ * Call from the buffer's change callback. Lines inserted or removed
+ * above the anchor move it, so the viewport does not jump. The rows of
+ * the changed lines are marked dirty, down to the bottom of the viewport
+ * when lines were inserted or removed.
+ *
+ * @param view Editor view
+ * @param change Change reported by the buffer
+ */
+void editor_view_on_buffer_change(EditorView* view, const QalamBufferChange* change);
+
+/*=============================================================================
+ * Dirty Region
+ *
+ * Typical use: after a change, invalidate each rect from
+ * editor_view_get_dirty_rects() with qalam_window_invalidate_rect(); when
+ * painting, call editor_view_submit_dirty_rects() before
+ * qalam_dwrite_render_begin() so the frame is clipped to them and they
+ * become its Present1() dirty rects.
+ *============================================================================*/
+
+/**
+ * @brief Mark lines dirty, e.g. after the cursor moved onto them
+ *
+ * @param view Editor view
+ * @param first_line First line
+ * @param line_count Number of lines
+ */
+void editor_view_invalidate_lines(EditorView* view, size_t first_line, size_t line_count);
+
+/**
+ * @brief Mark the whole viewport dirty
+ *
+ * @param view Editor view
+ */
+void editor_view_invalidate(EditorView* view);
+
+/**
+ * @brief Get the dirty region
+ *
+ * Rects are full-width bands of the viewport in DIPs, neither
+ * overlapping nor touching.
+ *
+ * @param view Editor view
+ * @param[out] rects Array to receive the rects (may be NULL to count them)
+ * @param max_rects Entries available in 'rects'
+ * @return Number of dirty rects, including any that did not fit
+ */
+size_t editor_view_get_dirty_rects(const EditorView* view, QalamRect* rects, size_t max_rects);
+
+/**
+ * @brief Hand the dirty region to a render target and clear it
+ *
+ * Call before qalam_dwrite_render_begin().
+ *
+ * @param view Editor view
+ * @param target Render target (NULL to only clear the region)
+ */
+void editor_view_submit_dirty_rects(EditorView* view, QalamDWriteRenderTarget* target);
+
+/*=============================================================================
+ * Rendering
+ *============================================================================*/
+
+/**
+ * @brief Lay out the lines of the next frame
+ *
+ * Starts a new layout cache frame and looks up the lines in and around
+ * the viewport. Layouts stay valid until the next call.
+ *
+ * @param view Editor view
+ * @return QALAM_OK on success, error code on failure
+ */
+QalamResult editor_view_layout(EditorView* view);
+
+/**
+ * @brief Lay out and draw the visible lines
+ *
+ * Must be called between qalam_dwrite_render_begin() and
+ * qalam_dwrite_render_end(); clearing the background is up to the caller.
+ *
+ * @param view Editor view
+ * @param target Render target
+ * @param brush Brush for the text
+ * @return QALAM_OK on success, error code on failure
+ */
+QalamResult editor_view_render(EditorView* view, QalamDWriteRenderTarget* target,
+                               QalamDWriteBrush* brush);
+
+/**
+ * @brief Draw the lines laid out by the last editor_view_layout()
+ *
+ * For callers that draw between layout and text, e.g. the selection.
+ * Must be called between qalam_dwrite_render_begin() and
+ * qalam_dwrite_render_end().
+ *
+ * @param view Editor view
+ * @param target Render target
+ * @param brush Brush for the text
+ */
+void editor_view_draw_text(EditorView* view, QalamDWriteRenderTarget* target,
+                           QalamDWriteBrush* brush);
+
+/**
+ * @brief Fill the buffer's selection on the lines laid out by the last
+ *        editor_view_layout()
+ *
+ * In bidi text a selection can cover several separate spans of a line;
+ * each is filled on its own. Draw it before the text.
+ *
+ * @param view Editor view
+ * @param target Render target
+ * @param brush Brush for the selection
+ * @return QALAM_OK on success, error code on failure
+ */
+QalamResult editor_view_draw_selection(EditorView* view, QalamDWriteRenderTarget* target,
+                                       QalamDWriteBrush* brush);
+
+/**
+ * @brief Get what the last frame did
+ *
+ * @param view Editor view
+ * @param[out] stats Pointer to receive the statistics
+ */
+void editor_view_get_stats(const EditorView* view, EditorViewStats* stats);
+
+/*=============================================================================
+ * Cursor and Hit Testing
+ *============================================================================*/
+
+/**
+ * @brief Move the buffer's cursor one caret stop left or right on screen
+ *
+ * Follows the arrow key's direction through mixed right-to-left and
+ * left-to-right text. At the edge of a line the cursor continues on the
+ * next line in reading order. The lines the cursor left and reached are
+ * marked dirty. Home and End stay logical; use
+ * qalam_buffer_cursor_to_line_start() and qalam_buffer_cursor_to_line_end().
+ *
+ * @param view Editor view
+ * @param direction Negative to move left, positive to move right
+ * @return QALAM_OK on success, error code on failure
+ */
+QalamResult editor_view_move_cursor_visual(EditorView* view, int direction);
+
+/**
+ * @brief Find the line and column of the caret stop nearest to a point
+ *
+ * @param view Editor view
+ * @param x Position in DIPs from the left of the viewport
+ * @param y Position in DIPs from the top of the viewport
+ * @param[out] line Receives the line (clamped to the last line)
+ * @param[out] column Receives the column
+ * @return QALAM_OK on success, error code on failure
+ */
+QalamResult editor_view_hit_test(EditorView* view, float x, float y,
+                                 size_t* line, size_t* column);
+
+/**
+ * @brief Get where the cursor's caret is drawn
+ *
+ * @param view Editor view
+ * @param[out] x Receives the caret x in DIPs from the left of the viewport
+ * @param[out] y Receives the top of the cursor line in DIPs from the top
+ *        of the viewport (outside the viewport when scrolled away)
+ * @return QALAM_OK on success, error code on failure
+ */
+QalamResult editor_view_get_caret_point(EditorView* view, float* x, float* y);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* QALAM_EDITOR_VIEW_H */
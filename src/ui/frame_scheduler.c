@@ -0,0 +1,462 @@
+/**
+ * @file frame_scheduler.c
+ * @brief Qalam IDE - Frame Scheduler Implementation
+ *
+ * One pass of the loop:
+ *
+ *   1. Dispatch every message already queued for the thread. Typed
+ *      characters land in the input queue; paints and other changes only
+ *      mark the scheduler dirty.
+ *   2. Insert the input queue into the buffer in one call.
+ *   3. If nothing is dirty, sleep until a message or a registered handle
+ *      wakes the thread.
+ *   4. Otherwise wait for the swap chain to take a frame, still waking for
+ *      messages and handles (they are handled and the pass starts over,
+ *      so input that arrives while waiting is in the frame), then draw.
+ *
+ * The frame latency waitable is a semaphore that the wait in step 4
+ * consumes, so a frame is drawn only once per signal, which is once per
+ * vertical blank at a frame latency of one. Without a waitable the loop
+ * draws and then blocks in DwmFlush() until the compositor's next frame.
+ *
+ * The input queue is a fixed array of UTF-8 allocated with the scheduler,
+ * so queueing a character never allocates; past the limit it is inserted
+ * mid-drain and refilled.
+ *
+ * @version 0.0.2
+ * @copyright (c) 2026 Qalam Project
+ *
+ * @note Thread Safety: See frame_scheduler.h.
+ */
+
+#include "frame_scheduler.h"
+#include <dwmapi.h>
+#include <stdlib.h>
+#include <string.h>
+
+/** Bytes past the limit one character can take */
+#define FRAME_SCHEDULER_CHAR_BYTES  4
+
+/*=============================================================================
+ * Internal Structures
+ *============================================================================*/
+
+/**
+ * @brief A handle the loop waits on
+ */
+typedef struct FrameSchedulerHandle {
+    HANDLE handle;                          /**< Handle */
+    FrameSchedulerHandleCallback callback;  /**< Called when signaled */
+    void* user_data;                        /**< Context for 'callback' */
+} FrameSchedulerHandle;
+
+/**
+ * @brief Frame scheduler state
+ */
+struct FrameScheduler {
+    QalamDWriteRenderTarget* target;        /**< Target frames are drawn on, or NULL */
+    FrameSchedulerOptions options;          /**< Options, defaults resolved */
+    FrameSchedulerFrameCallback frame_callback; /**< Draws a frame */
+    void* frame_user_data;                  /**< Context for 'frame_callback' */
+    bool dirty;                             /**< A frame has been asked for */
+
+    /* Handles waited on */
+    FrameSchedulerHandle handles[FRAME_SCHEDULER_MAX_HANDLES]; /**< Registered handles */
+    size_t handle_count;                    /**< Entries in 'handles' */
+
+    /* Input queue */
+    QalamBuffer* buffer;                    /**< Buffer queued text goes to */
+    char* input;                            /**< Queued UTF-8 text */
+    size_t input_length;                    /**< Bytes in 'input' */
+    uint32_t high_surrogate;                /**< First half of a pair, or 0 */
+
+    FrameSchedulerStats stats;              /**< What the loop has done */
+};
+
+/*=============================================================================
+ * Internal Helper Functions
+ *============================================================================*/
+
+/**
+ * @brief Append a character to the input queue as UTF-8
+ */
+static void frame_scheduler_append(FrameScheduler* scheduler, uint32_t codepoint) {
+    char* out = scheduler->input + scheduler->input_length;
+
+    if (codepoint < 0x80) {
+        out[0] = (char)codepoint;
+        scheduler->input_length += 1;
+    } else if (codepoint < 0x800) {
+        out[0] = (char)(0xC0 | (codepoint >> 6));
+        out[1] = (char)(0x80 | (codepoint & 0x3F));
+        scheduler->input_length += 2;
+    } else if (codepoint < 0x10000) {
+        out[0] = (char)(0xE0 | (codepoint >> 12));
+        out[1] = (char)(0x80 | ((codepoint >> 6) & 0x3F));
+        out[2] = (char)(0x80 | (codepoint & 0x3F));
+        scheduler->input_length += 3;
+    } else {
+        out[0] = (char)(0xF0 | (codepoint >> 18));
+        out[1] = (char)(0x80 | ((codepoint >> 12) & 0x3F));
+        out[2] = (char)(0x80 | ((codepoint >> 6) & 0x3F));
+        out[3] = (char)(0x80 | (codepoint & 0x3F));
+        scheduler->input_length += 4;
+    }
+}
+
+/**
+ * @brief Call the callback of a signaled handle
+ */
+static void frame_scheduler_signaled(FrameScheduler* scheduler, size_t index) {
+    FrameSchedulerHandle entry = scheduler->handles[index];
+    if (entry.callback && entry.callback(entry.handle, entry.user_data)) {
+        scheduler->dirty = true;
+    }
+}
+
+/**
+ * @brief Dispatch every pending message
+ *
+ * @return false once WM_QUIT has been received
+ */
+static bool frame_scheduler_drain(FrameScheduler* scheduler, int* exit_code) {
+    MSG msg;
+    while (PeekMessageW(&msg, NULL, 0, 0, PM_REMOVE)) {
+        if (msg.message == WM_QUIT) {
+            *exit_code = (int)msg.wParam;
+            return false;
+        }
+        TranslateMessage(&msg);
+        DispatchMessageW(&msg);
+        scheduler->stats.messages++;
+    }
+    return true;
+}
+
+/**
+ * @brief Wait for a message, a registered handle or an extra handle
+ *
+ * @param extra Handle waited on after the registered ones (may be NULL)
+ * @param timeout_ms Longest wait
+ * @return WAIT_OBJECT_0 + index of the handle signaled (the extra one
+ *         comes after the registered ones), WAIT_OBJECT_0 + the number of
+ *         handles for a message, WAIT_TIMEOUT, or WAIT_FAILED
+ */
+static DWORD frame_scheduler_wait(FrameScheduler* scheduler, HANDLE extra, DWORD timeout_ms) {
+    HANDLE handles[FRAME_SCHEDULER_MAX_HANDLES + 1];
+    DWORD count = 0;
+    for (size_t i = 0; i < scheduler->handle_count; i++) {
+        handles[count++] = scheduler->handles[i].handle;
+    }
+    if (extra) {
+        handles[count++] = extra;
+    }
+
+    return MsgWaitForMultipleObjectsEx(count, handles, timeout_ms, QS_ALLINPUT,
+                                       MWMO_INPUTAVAILABLE);
+}
+
+/**
+ * @brief Draw a frame
+ */
+static void frame_scheduler_draw(FrameScheduler* scheduler) {
+    scheduler->dirty = false;
+    if (scheduler->frame_callback) {
+        scheduler->frame_callback(scheduler->frame_user_data);
+    }
+    scheduler->stats.frames++;
+}
+
+/*=============================================================================
+ * Lifecycle
+ *============================================================================*/
+
+/**
+ * @brief Get default frame scheduler options
+ */
+QalamResult frame_scheduler_get_default_options(FrameSchedulerOptions* options) {
+    if (!options) {
+        return QALAM_ERROR_NULL_POINTER;
+    }
+
+    memset(options, 0, sizeof(FrameSchedulerOptions));
+    options->input_limit = FRAME_SCHEDULER_DEFAULT_INPUT_LIMIT;
+    options->frame_timeout_ms = FRAME_SCHEDULER_DEFAULT_FRAME_TIMEOUT_MS;
+    options->use_dwm_flush = true;
+
+    return QALAM_OK;
+}
+
+/**
+ * @brief Create a frame scheduler
+ */
+QalamResult frame_scheduler_create(FrameScheduler** scheduler, QalamDWriteRenderTarget* target,
+                                   const FrameSchedulerOptions* options) {
+    if (!scheduler) {
+        return QALAM_ERROR_NULL_POINTER;
+    }
+
+    *scheduler = NULL;
+
+    FrameScheduler* s = (FrameScheduler*)qalam_mem_calloc(QALAM_MEMORY_UI, 1,
+                                                          sizeof(FrameScheduler));
+    if (!s) {
+        return QALAM_ERROR_OUT_OF_MEMORY;
+    }
+
+    if (options) {
+        s->options = *options;
+    } else {
+        frame_scheduler_get_default_options(&s->options);
+    }
+    if (s->options.input_limit == 0) {
+        s->options.input_limit = FRAME_SCHEDULER_DEFAULT_INPUT_LIMIT;
+    }
+
+    s->input = (char*)qalam_mem_alloc(QALAM_MEMORY_UI,
+                                      s->options.input_limit + FRAME_SCHEDULER_CHAR_BYTES);
+    if (!s->input) {
+        qalam_mem_free(s);
+        return QALAM_ERROR_OUT_OF_MEMORY;
+    }
+
+    s->target = target;
+    s->dirty = true;
+
+    *scheduler = s;
+    return QALAM_OK;
+}
+
+/**
+ * @brief Destroy a frame scheduler
+ */
+void frame_scheduler_destroy(FrameScheduler* scheduler) {
+    if (!scheduler) {
+        return;
+    }
+
+    qalam_mem_free(scheduler->input);
+    qalam_mem_free(scheduler);
+}
+
+/**
+ * @brief Set what draws a frame
+ */
+void frame_scheduler_set_frame_callback(FrameScheduler* scheduler,
+                                        FrameSchedulerFrameCallback callback, void* user_data) {
+    if (!scheduler) {
+        return;
+    }
+
+    scheduler->frame_callback = callback;
+    scheduler->frame_user_data = user_data;
+}
+
+/**
+ * @brief Wait on a handle too
+ */
+QalamResult frame_scheduler_add_handle(FrameScheduler* scheduler, HANDLE handle,
+                                       FrameSchedulerHandleCallback callback, void* user_data) {
+    if (!scheduler) {
+        return QALAM_ERROR_NULL_POINTER;
+    }
+
+    if (!handle || scheduler->handle_count >= FRAME_SCHEDULER_MAX_HANDLES) {
+        return QALAM_ERROR_INVALID_ARGUMENT;
+    }
+
+    FrameSchedulerHandle* entry = &scheduler->handles[scheduler->handle_count++];
+    entry->handle = handle;
+    entry->callback = callback;
+    entry->user_data = user_data;
+    return QALAM_OK;
+}
+
+/**
+ * @brief Stop waiting on a handle
+ */
+void frame_scheduler_remove_handle(FrameScheduler* scheduler, HANDLE handle) {
+    if (!scheduler) {
+        return;
+    }
+
+    for (size_t i = 0; i < scheduler->handle_count; i++) {
+        if (scheduler->handles[i].handle == handle) {
+            memmove(&scheduler->handles[i], &scheduler->handles[i + 1],
+                    (scheduler->handle_count - i - 1) * sizeof(FrameSchedulerHandle));
+            scheduler->handle_count--;
+            return;
+        }
+    }
+}
+
+/*=============================================================================
+ * Input
+ *============================================================================*/
+
+/**
+ * @brief Set the buffer queued characters are inserted into
+ */
+QalamResult frame_scheduler_set_buffer(FrameScheduler* scheduler, QalamBuffer* buffer) {
+    if (!scheduler) {
+        return QALAM_ERROR_NULL_POINTER;
+    }
+
+    QalamResult result = frame_scheduler_flush_input(scheduler);
+    scheduler->buffer = buffer;
+    scheduler->high_surrogate = 0;
+    return result;
+}
+
+/**
+ * @brief Queue a typed character
+ */
+bool frame_scheduler_queue_char(FrameScheduler* scheduler, uint32_t codepoint) {
+    if (!scheduler) {
+        return false;
+    }
+
+    /* WM_CHAR delivers characters past the BMP as two messages */
+    if (codepoint >= 0xD800 && codepoint <= 0xDBFF) {
+        scheduler->high_surrogate = codepoint;
+        return true;
+    }
+    if (codepoint >= 0xDC00 && codepoint <= 0xDFFF) {
+        if (!scheduler->high_surrogate) {
+            return false;
+        }
+        codepoint = 0x10000 + ((scheduler->high_surrogate - 0xD800) << 10) + (codepoint - 0xDC00);
+    }
+    scheduler->high_surrogate = 0;
+
+    if (codepoint == '\r') {
+        codepoint = '\n';
+    } else if ((codepoint < 0x20 && codepoint != '\t') || codepoint == 0x7F ||
+               codepoint > 0x10FFFF) {
+        return false;
+    }
+
+    if (scheduler->input_length >= scheduler->options.input_limit) {
+        frame_scheduler_flush_input(scheduler);
+    }
+    frame_scheduler_append(scheduler, codepoint);
+    scheduler->stats.chars_queued++;
+    return true;
+}
+
+/**
+ * @brief Insert the queued characters into the buffer
+ */
+QalamResult frame_scheduler_flush_input(FrameScheduler* scheduler) {
+    if (!scheduler) {
+        return QALAM_ERROR_NULL_POINTER;
+    }
+
+    if (scheduler->input_length == 0) {
+        return QALAM_OK;
+    }
+
+    QalamResult result = QALAM_OK;
+    if (scheduler->buffer) {
+        result = qalam_buffer_insert(scheduler->buffer, scheduler->input,
+                                     scheduler->input_length);
+        scheduler->stats.inserts++;
+        scheduler->dirty = true;
+    }
+    scheduler->input_length = 0;
+    return result;
+}
+
+/**
+ * @brief Get the bytes of UTF-8 text queued
+ */
+size_t frame_scheduler_get_queued_bytes(const FrameScheduler* scheduler) {
+    return scheduler ? scheduler->input_length : 0;
+}
+
+/*=============================================================================
+ * Frames
+ *============================================================================*/
+
+/**
+ * @brief Ask for a frame
+ */
+void frame_scheduler_invalidate(FrameScheduler* scheduler) {
+    if (scheduler) {
+        scheduler->dirty = true;
+    }
+}
+
+/**
+ * @brief Check whether a frame has been asked for
+ */
+bool frame_scheduler_is_dirty(const FrameScheduler* scheduler) {
+    return scheduler ? scheduler->dirty : false;
+}
+
+/**
+ * @brief Run the message loop until WM_QUIT
+ */
+int frame_scheduler_run(FrameScheduler* scheduler) {
+    if (!scheduler) {
+        return -1;
+    }
+
+    int exit_code = 0;
+    for (;;) {
+        if (!frame_scheduler_drain(scheduler, &exit_code)) {
+            frame_scheduler_flush_input(scheduler);
+            return exit_code;
+        }
+        frame_scheduler_flush_input(scheduler);
+
+        size_t count = scheduler->handle_count;
+        if (!scheduler->dirty) {
+            /* Idle until there is something to do */
+            scheduler->stats.idle_waits++;
+            DWORD result = frame_scheduler_wait(scheduler, NULL, INFINITE);
+            if (result == WAIT_FAILED) {
+                return -1;
+            }
+            if (result < WAIT_OBJECT_0 + count) {
+                frame_scheduler_signaled(scheduler, result - WAIT_OBJECT_0);
+            }
+            continue;
+        }
+
+        /* Fetched each frame: it changes when the target recovers from device loss */
+        HANDLE waitable = scheduler->target ?
+            (HANDLE)qalam_dwrite_render_target_get_frame_waitable(scheduler->target) : NULL;
+        if (!waitable) {
+            frame_scheduler_draw(scheduler);
+            if (scheduler->options.use_dwm_flush && FAILED(DwmFlush())) {
+                /* Composition is off; fall back to a frame's worth of sleep */
+                Sleep(16);
+            }
+            continue;
+        }
+
+        DWORD result = frame_scheduler_wait(scheduler, waitable,
+                                            scheduler->options.frame_timeout_ms);
+        if (result == WAIT_FAILED) {
+            return -1;
+        }
+        if (result == WAIT_OBJECT_0 + count || result == WAIT_TIMEOUT) {
+            frame_scheduler_draw(scheduler);
+        } else if (result < WAIT_OBJECT_0 + count) {
+            frame_scheduler_signaled(scheduler, result - WAIT_OBJECT_0);
+        }
+        /* Otherwise input arrived first; take it into this frame */
+    }
+}
+
+/**
+ * @brief Get what the scheduler has done so far
+ */
+void frame_scheduler_get_stats(const FrameScheduler* scheduler, FrameSchedulerStats* stats) {
+    if (!scheduler || !stats) {
+        return;
+    }
+
+    *stats = scheduler->stats;
+}
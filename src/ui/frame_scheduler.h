@@ -0,0 +1,253 @@
+/**
+ * @file frame_scheduler.h
+ * @brief Qalam IDE - Frame Scheduler (Internal Header)
+ *
+ * Internal header for the loop that turns window messages into frames.
+ * Each pass drains every pending message first, so a paste through an
+ * IME or a burst of key repeats arrives as many characters before any
+ * frame is drawn. The characters are queued rather than inserted one by
+ * one, and each pass inserts the queue into the buffer with a single
+ * qalam_buffer_insert().
+ *
+ * A frame is drawn only when something marked the scheduler dirty, and
+ * at most once per vertical blank: with a flip-model render target the
+ * loop waits on the swap chain's frame latency waitable, and otherwise
+ * it paces itself with DwmFlush(). While nothing is dirty the loop
+ * sleeps in MsgWaitForMultipleObjectsEx() until a message arrives or a
+ * registered handle (such as a terminal's output waitable) is signaled,
+ * so an idle window uses no CPU.
+ *
+ * @version 0.0.2
+ * @copyright (c) 2026 Qalam Project
+ *
+ * @note Thread Safety: Not thread-safe. Run the scheduler on the thread
+ *       that owns the window.
+ */
+
+#ifndef QALAM_FRAME_SCHEDULER_H
+#define QALAM_FRAME_SCHEDULER_H
+
+#include "qalam.h"
+#include "editor.h"
+#include "dwrite_api.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*=============================================================================
+ * Configuration Constants
+ *============================================================================*/
+
+/** Most handles the loop waits on besides the frame waitable */
+#define FRAME_SCHEDULER_MAX_HANDLES         8
+
+/** Default bytes of queued text that force an insert mid-drain */
+#define FRAME_SCHEDULER_DEFAULT_INPUT_LIMIT (64 * 1024)
+
+/** Default longest wait for the swap chain before drawing anyway */
+#define FRAME_SCHEDULER_DEFAULT_FRAME_TIMEOUT_MS 100
+
+/*=============================================================================
+ * Frame Scheduler Structures
+ *============================================================================*/
+
+/**
+ * @brief Draw one frame
+ *
+ * Called from frame_scheduler_run() when the scheduler is dirty and the
+ * render target can take a frame. The callback draws and presents the
+ * frame itself; it should not wait for the target again.
+ *
+ * @param user_data Context given to frame_scheduler_set_frame_callback()
+ */
+typedef void (*FrameSchedulerFrameCallback)(void* user_data);
+
+/**
+ * @brief Handle a signaled wait handle
+ *
+ * @param handle The handle that was signaled
+ * @param user_data Context given to frame_scheduler_add_handle()
+ * @return true if a frame has to be drawn
+ */
+typedef bool (*FrameSchedulerHandleCallback)(HANDLE handle, void* user_data);
+
+/**
+ * @brief Frame scheduler options
+ */
+typedef struct FrameSchedulerOptions {
+    size_t input_limit;             /**< Queued bytes that force an insert (0 for the default) */
+    uint32_t frame_timeout_ms;      /**< Longest wait for the swap chain per frame */
+    bool use_dwm_flush;             /**< Pace targets without a waitable with DwmFlush() */
+} FrameSchedulerOptions;
+
+/**
+ * @brief What the scheduler has done so far
+ */
+typedef struct FrameSchedulerStats {
+    uint64_t frames;                /**< Frames drawn */
+    uint64_t messages;              /**< Messages dispatched */
+    uint64_t chars_queued;          /**< Characters queued */
+    uint64_t inserts;               /**< qalam_buffer_insert() calls they were applied with */
+    uint64_t idle_waits;            /**< Times the loop slept with nothing dirty */
+} FrameSchedulerStats;
+
+/**
+ * @brief Opaque frame scheduler
+ */
+typedef struct FrameScheduler FrameScheduler;
+
+/*=============================================================================
+ * Lifecycle
+ *============================================================================*/
+
+/**
+ * @brief Get default frame scheduler options
+ *
+ * @param[out] options Pointer to options structure to fill
+ * @return QALAM_OK on success
+ */
+QalamResult frame_scheduler_get_default_options(FrameSchedulerOptions* options);
+
+/**
+ * @brief Create a frame scheduler
+ *
+ * @param[out] scheduler Receives the scheduler
+ * @param target Render target frames are drawn on (NULL to pace with
+ *        DwmFlush() only; must outlive the scheduler)
+ * @param options Scheduler options (NULL for defaults)
+ * @return QALAM_OK on success, error code on failure
+ */
+QalamResult frame_scheduler_create(FrameScheduler** scheduler, QalamDWriteRenderTarget* target,
+                                   const FrameSchedulerOptions* options);
+
+/**
+ * @brief Destroy a frame scheduler, dropping any queued text
+ *
+ * @param scheduler Scheduler to destroy (may be NULL)
+ */
+void frame_scheduler_destroy(FrameScheduler* scheduler);
+
+/**
+ * @brief Set what draws a frame
+ *
+ * @param scheduler Frame scheduler
+ * @param callback Frame callback (NULL for none)
+ * @param user_data Context passed to the callback
+ */
+void frame_scheduler_set_frame_callback(FrameScheduler* scheduler,
+                                        FrameSchedulerFrameCallback callback, void* user_data);
+
+/**
+ * @brief Wait on a handle too, e.g. a terminal's output waitable
+ *
+ * @param scheduler Frame scheduler
+ * @param handle Handle to wait on (must stay valid while registered). An
+ *        event should be auto-reset, or reset by the callback, or the loop
+ *        keeps waking for it
+ * @param callback Called on the loop's thread when the handle is signaled
+ * @param user_data Context passed to the callback
+ * @return QALAM_OK on success, QALAM_ERROR_INVALID_ARGUMENT for a NULL
+ *         handle or when FRAME_SCHEDULER_MAX_HANDLES are already registered
+ */
+QalamResult frame_scheduler_add_handle(FrameScheduler* scheduler, HANDLE handle,
+                                       FrameSchedulerHandleCallback callback, void* user_data);
+
+/**
+ * @brief Stop waiting on a handle
+ *
+ * @param scheduler Frame scheduler
+ * @param handle Handle given to frame_scheduler_add_handle()
+ */
+void frame_scheduler_remove_handle(FrameScheduler* scheduler, HANDLE handle);
+
+/*=============================================================================
+ * Input
+ *============================================================================*/
+
+/**
+ * @brief Set the buffer queued characters are inserted into
+ *
+ * Text queued for the previous buffer is inserted into it first.
+ *
+ * @param scheduler Frame scheduler
+ * @param buffer Buffer (NULL for none; must outlive its use)
+ * @return QALAM_OK, or the error of inserting the queued text
+ */
+QalamResult frame_scheduler_set_buffer(FrameScheduler* scheduler, QalamBuffer* buffer);
+
+/**
+ * @brief Queue a typed character
+ *
+ * Call for QALAM_EVENT_CHAR. A carriage return is queued as a line feed,
+ * and the halves of a surrogate pair may come in separate calls. Other
+ * control characters but tab are not text and are left to the key
+ * handler. Insert the queue with frame_scheduler_flush_input() before
+ * handling anything that depends on the cursor, such as a key that
+ * moves it.
+ *
+ * @param scheduler Frame scheduler
+ * @param codepoint Unicode character, or one half of a surrogate pair
+ * @return true if the character was queued
+ */
+bool frame_scheduler_queue_char(FrameScheduler* scheduler, uint32_t codepoint);
+
+/**
+ * @brief Insert the queued characters into the buffer
+ *
+ * Applies them with one qalam_buffer_insert(), so the buffer reports one
+ * change and records one undo step, and marks the scheduler dirty.
+ *
+ * @param scheduler Frame scheduler
+ * @return QALAM_OK on success (also when nothing is queued), error code
+ *         of the insert on failure (the queued text is dropped)
+ */
+QalamResult frame_scheduler_flush_input(FrameScheduler* scheduler);
+
+/**
+ * @brief Get the bytes of UTF-8 text queued and not yet inserted
+ */
+size_t frame_scheduler_get_queued_bytes(const FrameScheduler* scheduler);
+
+/*=============================================================================
+ * Frames
+ *============================================================================*/
+
+/**
+ * @brief Ask for a frame
+ *
+ * Call where a window would be invalidated, and for QALAM_EVENT_PAINT.
+ *
+ * @param scheduler Frame scheduler
+ */
+void frame_scheduler_invalidate(FrameScheduler* scheduler);
+
+/**
+ * @brief Check whether a frame has been asked for
+ */
+bool frame_scheduler_is_dirty(const FrameScheduler* scheduler);
+
+/**
+ * @brief Run the message loop until WM_QUIT
+ *
+ * Replaces qalam_window_run(). Queued text is inserted before the loop
+ * returns.
+ *
+ * @param scheduler Frame scheduler
+ * @return The WM_QUIT exit code, or -1 if the loop could not wait
+ */
+int frame_scheduler_run(FrameScheduler* scheduler);
+
+/**
+ * @brief Get what the scheduler has done so far
+ *
+ * @param scheduler Frame scheduler
+ * @param[out] stats Pointer to receive the statistics
+ */
+void frame_scheduler_get_stats(const FrameScheduler* scheduler, FrameSchedulerStats* stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* QALAM_FRAME_SCHEDULER_H */
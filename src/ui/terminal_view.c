@@ -0,0 +1,1046 @@
+/**
+ * @file terminal_view.c
+ * @brief Qalam IDE - Terminal View Implementation
+ *
+ * A frame is worked out before it is drawn: terminal_view_submit_dirty_rects()
+ * takes the screen's dirty span of each row, adds the cells the cursor
+ * left and reached, and widens each span so it neither splits a wide
+ * character from its tail nor cuts into a shaped segment. The same spans
+ * become the frame's dirty rects and are what terminal_view_render()
+ * draws, so every cell inside the presented region is drawn again and
+ * every other cell keeps the previous frame.
+ *
+ * A row is drawn in three passes over its span: backgrounds as runs of
+ * one color, then text, then the cursor. Text is split into runs of one
+ * style; a run of plain characters goes to the atlas as one call, and a
+ * segment that needs shaping - Arabic letters, or any cell carrying a
+ * combining mark, joined across single blanks so Arabic words stay in
+ * right-to-left order - is drawn as one cluster over its cells.
+ *
+ * While the view is scrolled back, any change redraws the whole
+ * viewport, since the rows on screen have moved under it.
+ *
+ * @version 0.0.2
+ * @copyright (c) 2026 Qalam Project
+ *
+ * @note Thread Safety: See terminal_view.h.
+ */
+
+#include "terminal_view.h"
+#include <stdlib.h>
+#include <string.h>
+
+/*=============================================================================
+ * Internal Structures
+ *============================================================================*/
+
+/**
+ * @brief Cells of a row the frame draws
+ */
+typedef struct TerminalViewSpan {
+    size_t first;                   /**< First column */
+    size_t end;                     /**< Column after the last (first == end for none) */
+} TerminalViewSpan;
+
+/**
+ * @brief Terminal view state
+ */
+struct TerminalView {
+    QalamDWriteRenderTarget* target; /**< Target drawn on */
+    QalamDWriteGlyphAtlas* atlas;   /**< Glyphs and shaped clusters */
+    QalamDWriteBrush* brush;        /**< Brush for every color, set as needed */
+    uint32_t brush_color;           /**< Current color of 'brush' */
+    QalamTerminal* terminal;        /**< Terminal shown, or NULL */
+    TerminalScreen* screen;         /**< Its screen, or NULL */
+    TerminalViewOptions options;    /**< Options */
+    QalamDWriteCellMetrics metrics; /**< Cell size of the next frame */
+    float width;                    /**< Viewport width in DIPs */
+    float height;                   /**< Viewport height in DIPs */
+    size_t columns;                 /**< Columns the viewport fits */
+    size_t rows;                    /**< Rows the viewport fits */
+
+    /* Scroll state */
+    size_t scroll_offset;           /**< Scrollback rows shown above the screen */
+    uint64_t scrollback_end;        /**< Scrollback end row when last looked at */
+
+    /* Next frame, worked out by terminal_view_collect() */
+    bool collected;                 /**< 'spans' hold the next frame */
+    bool full;                      /**< The frame draws the whole viewport */
+    size_t frame_columns;           /**< Screen columns */
+    size_t frame_rows;              /**< Screen rows */
+    TerminalViewSpan* spans;        /**< Cells to draw of each viewport row */
+    TerminalCursor cursor;          /**< Cursor, in viewport rows */
+    bool cursor_shown;              /**< The cursor is drawn */
+
+    /* Last frame drawn */
+    bool all_dirty;                 /**< Everything must be drawn again */
+    size_t drawn_columns;           /**< Screen columns drawn */
+    size_t drawn_rows;              /**< Screen rows drawn */
+    TerminalCursor drawn_cursor;    /**< Cursor drawn, in viewport rows */
+    bool drawn_cursor_shown;        /**< A cursor was drawn */
+
+    /* Row buffers */
+    size_t row_capacity;            /**< Allocated entries in 'spans' */
+    size_t cell_capacity;           /**< Allocated cells per row buffer */
+    TerminalCell* cells;            /**< A scrollback row being drawn */
+    uint32_t* codepoints;           /**< Characters of a run of cells */
+    wchar_t* text;                  /**< UTF-16 text of a shaped segment */
+    TerminalViewStats stats;        /**< What the frame did */
+};
+
+/** Default palette (0-15) */
+static const uint32_t g_default_palette[TERMINAL_VIEW_PALETTE_SIZE] = {
+    0x0C0C0C, 0xC50F1F, 0x13A10E, 0xC19C00, 0x0037DA, 0x881798, 0x3A96DD, 0xCCCCCC,
+    0x767676, 0xE74856, 0x16C60C, 0xF9F1A5, 0x3B78FF, 0xB4009E, 0x61D6D6, 0xF2F2F2
+};
+
+/*=============================================================================
+ * Internal Helper Functions: Colors
+ *============================================================================*/
+
+/**
+ * @brief Get a color of the 256-color palette
+ */
+static uint32_t terminal_view_palette(const TerminalView* view, uint32_t index) {
+    if (index < TERMINAL_VIEW_PALETTE_SIZE) {
+        return view->options.palette[index];
+    }
+
+    /* 6x6x6 color cube, then a ramp of 24 grays */
+    if (index < 232) {
+        static const uint32_t levels[6] = { 0, 95, 135, 175, 215, 255 };
+        index -= 16;
+        return levels[index / 36] << 16 | levels[index / 6 % 6] << 8 | levels[index % 6];
+    }
+    uint32_t gray = 8 + (index - 232) * 10;
+    return gray << 16 | gray << 8 | gray;
+}
+
+/**
+ * @brief Resolve a cell color to 0xRRGGBB
+ */
+static uint32_t terminal_view_resolve(const TerminalView* view, uint32_t color,
+                                      uint32_t default_color) {
+    switch (TERMINAL_COLOR_KIND(color)) {
+        case 1:
+            return terminal_view_palette(view, color & 0xFFu);
+        case 2:
+            return color & 0xFFFFFFu;
+        default:
+            return default_color;
+    }
+}
+
+/**
+ * @brief Get the colors a cell is drawn in
+ */
+static void terminal_view_cell_colors(const TerminalView* view, const TerminalAttributes* attributes,
+                                      uint32_t* foreground, uint32_t* background) {
+    uint32_t fg = terminal_view_resolve(view, attributes->foreground, view->options.foreground);
+    uint32_t bg = terminal_view_resolve(view, attributes->background, view->options.background);
+
+    if (attributes->flags & TERMINAL_ATTR_INVERSE) {
+        uint32_t swap = fg;
+        fg = bg;
+        bg = swap;
+    }
+    if (attributes->flags & TERMINAL_ATTR_FAINT) {
+        /* Halfway to the background, per channel */
+        fg = ((fg & 0xFEFEFEu) >> 1) + ((bg & 0xFEFEFEu) >> 1);
+    }
+    if (attributes->flags & TERMINAL_ATTR_INVISIBLE) {
+        fg = bg;
+    }
+
+    *foreground = fg;
+    *background = bg;
+}
+
+/**
+ * @brief Set the brush color unless it already has it
+ */
+static void terminal_view_set_color(TerminalView* view, uint32_t color) {
+    if (view->brush_color != color) {
+        qalam_dwrite_brush_set_color(view->brush, qalam_dwrite_color_from_hex(color));
+        view->brush_color = color;
+    }
+}
+
+/**
+ * @brief Get the atlas style of a cell's attributes
+ */
+static uint32_t terminal_view_style(const TerminalAttributes* attributes) {
+    uint32_t style = 0;
+    if (attributes->flags & TERMINAL_ATTR_BOLD) {
+        style |= QALAM_DWRITE_GLYPH_BOLD;
+    }
+    if (attributes->flags & TERMINAL_ATTR_ITALIC) {
+        style |= QALAM_DWRITE_GLYPH_ITALIC;
+    }
+    return style;
+}
+
+/*=============================================================================
+ * Internal Helper Functions: Cells
+ *============================================================================*/
+
+/**
+ * @brief Check for a letter of the Arabic blocks and presentation forms
+ */
+static bool terminal_view_is_arabic(uint32_t character) {
+    return (character >= 0x0600 && character <= 0x08FF) ||
+           (character >= 0xFB50 && character <= 0xFDFF) ||
+           (character >= 0xFE70 && character <= 0xFEFF);
+}
+
+/**
+ * @brief Check whether a cell has to be shaped with its neighbours
+ */
+static bool terminal_view_is_complex(const TerminalCell* cell) {
+    return TERMINAL_CELL_MARK(cell->codepoint) != 0 ||
+           terminal_view_is_arabic(TERMINAL_CELL_CHAR(cell->codepoint));
+}
+
+static bool terminal_view_is_tail(const TerminalCell* cell) {
+    return (cell->attributes.flags & TERMINAL_ATTR_WIDE_TAIL) != 0;
+}
+
+static bool terminal_view_is_blank(const TerminalCell* cell) {
+    return !terminal_view_is_tail(cell) && cell->codepoint <= ' ';
+}
+
+/**
+ * @brief Check whether two cells are drawn with the same attributes
+ */
+static bool terminal_view_same_attributes(const TerminalCell* a, const TerminalCell* b) {
+    return a->attributes.foreground == b->attributes.foreground &&
+           a->attributes.background == b->attributes.background &&
+           ((a->attributes.flags ^ b->attributes.flags) & ~TERMINAL_ATTR_WIDE_TAIL) == 0;
+}
+
+/**
+ * @brief Find the shaped segment a cell belongs to
+ *
+ * A segment is a run of complex cells of one style, with the tails of
+ * wide ones, joined across single blank cells.
+ *
+ * @param cells Row
+ * @param columns Cells in the row
+ * @param column Cell to look at
+ * @param[out] first Receives the segment's first column
+ * @param[out] end Receives the column after its last
+ * @return true if the cell is part of a segment
+ */
+static bool terminal_view_segment_at(const TerminalCell* cells, size_t columns, size_t column,
+                                     size_t* first, size_t* end) {
+    if (column > 0 && terminal_view_is_tail(&cells[column])) {
+        column--;
+    }
+    if (!terminal_view_is_complex(&cells[column])) {
+        /* A blank joins complex cells of its style on both sides */
+        if (!terminal_view_is_blank(&cells[column]) || column == 0 || column + 1 >= columns ||
+            !terminal_view_is_complex(&cells[column - 1]) ||
+            !terminal_view_is_complex(&cells[column + 1]) ||
+            !terminal_view_same_attributes(&cells[column - 1], &cells[column]) ||
+            !terminal_view_same_attributes(&cells[column + 1], &cells[column])) {
+            return false;
+        }
+    }
+
+    size_t f = column;
+    while (f > 0) {
+        const TerminalCell* cell = &cells[f];
+        if (terminal_view_is_complex(&cells[f - 1]) &&
+            terminal_view_same_attributes(&cells[f - 1], cell)) {
+            f--;
+        } else if (f >= 2 && (terminal_view_is_tail(&cells[f - 1]) ||
+                              terminal_view_is_blank(&cells[f - 1])) &&
+                   terminal_view_is_complex(&cells[f - 2]) &&
+                   terminal_view_same_attributes(&cells[f - 1], cell) &&
+                   terminal_view_same_attributes(&cells[f - 2], cell)) {
+            f -= 2;
+        } else {
+            break;
+        }
+    }
+
+    size_t e = column + 1;
+    while (e < columns) {
+        const TerminalCell* last = &cells[e - 1];
+        if (terminal_view_is_tail(&cells[e]) && terminal_view_is_complex(last)) {
+            e++;
+        } else if (terminal_view_is_complex(&cells[e]) &&
+                   terminal_view_same_attributes(&cells[e], last)) {
+            e++;
+        } else if (e + 1 < columns && terminal_view_is_blank(&cells[e]) &&
+                   terminal_view_is_complex(&cells[e + 1]) &&
+                   terminal_view_same_attributes(&cells[e], last) &&
+                   terminal_view_same_attributes(&cells[e + 1], last)) {
+            e += 2;
+        } else {
+            break;
+        }
+    }
+
+    *first = f;
+    *end = e;
+    return true;
+}
+
+/**
+ * @brief Widen a span so it splits no wide character or shaped segment
+ */
+static void terminal_view_extend_span(const TerminalCell* cells, size_t columns,
+                                      TerminalViewSpan* span) {
+    size_t first;
+    size_t end;
+
+    if (span->first > 0 && terminal_view_is_tail(&cells[span->first])) {
+        span->first--;
+    }
+    if (span->end < columns && terminal_view_is_tail(&cells[span->end])) {
+        span->end++;
+    }
+    if (terminal_view_segment_at(cells, columns, span->first, &first, &end) &&
+        first < span->first) {
+        span->first = first;
+    }
+    if (terminal_view_segment_at(cells, columns, span->end - 1, &first, &end) &&
+        end > span->end) {
+        span->end = end;
+    }
+}
+
+/**
+ * @brief Add a cell to a span
+ */
+static void terminal_view_span_add(TerminalViewSpan* span, size_t column) {
+    if (span->first == span->end) {
+        span->first = column;
+        span->end = column + 1;
+    } else if (column < span->first) {
+        span->first = column;
+    } else if (column >= span->end) {
+        span->end = column + 1;
+    }
+}
+
+/*=============================================================================
+ * Internal Helper Functions: Frames
+ *============================================================================*/
+
+/**
+ * @brief Grow the row buffers to a screen size
+ */
+static QalamResult terminal_view_reserve(TerminalView* view, size_t columns, size_t rows) {
+    if (rows > view->row_capacity) {
+        TerminalViewSpan* spans = (TerminalViewSpan*)qalam_mem_realloc(
+            QALAM_MEMORY_TERMINAL, view->spans, rows * sizeof(TerminalViewSpan));
+        if (!spans) {
+            return QALAM_ERROR_OUT_OF_MEMORY;
+        }
+        view->spans = spans;
+        view->row_capacity = rows;
+    }
+
+    if (columns > view->cell_capacity) {
+        TerminalCell* cells = (TerminalCell*)qalam_mem_alloc(QALAM_MEMORY_TERMINAL,
+                                                             columns * sizeof(TerminalCell));
+        uint32_t* codepoints = (uint32_t*)qalam_mem_alloc(QALAM_MEMORY_TERMINAL,
+                                                          columns * sizeof(uint32_t));
+        wchar_t* text = (wchar_t*)qalam_mem_alloc(
+            QALAM_MEMORY_TERMINAL, columns * TERMINAL_CELL_MAX_UTF16 * sizeof(wchar_t));
+        if (!cells || !codepoints || !text) {
+            qalam_mem_free(cells);
+            qalam_mem_free(codepoints);
+            qalam_mem_free(text);
+            return QALAM_ERROR_OUT_OF_MEMORY;
+        }
+        qalam_mem_free(view->cells);
+        qalam_mem_free(view->codepoints);
+        qalam_mem_free(view->text);
+        view->cells = cells;
+        view->codepoints = codepoints;
+        view->text = text;
+        view->cell_capacity = columns;
+    }
+
+    return QALAM_OK;
+}
+
+/**
+ * @brief Get the cells of a viewport row of the next frame
+ *
+ * @return The row (a scrollback row is copied into the view's buffer),
+ *         or NULL if it is past the screen
+ */
+static const TerminalCell* terminal_view_row(TerminalView* view, size_t row) {
+    if (row >= view->scroll_offset) {
+        return terminal_screen_get_row(view->screen, row - view->scroll_offset, NULL);
+    }
+
+    Scrollback* scrollback = terminal_screen_get_scrollback(view->screen);
+    uint64_t number = view->scrollback_end - view->scroll_offset + row;
+    if (scrollback_read_row(scrollback, number, view->cells, view->frame_columns,
+                            NULL, NULL) != QALAM_OK) {
+        memset(view->cells, 0, view->frame_columns * sizeof(TerminalCell));
+    }
+    return view->cells;
+}
+
+/**
+ * @brief Get the cursor as the next frame would draw it
+ */
+static bool terminal_view_current_cursor(const TerminalView* view, size_t columns, size_t rows,
+                                         TerminalCursor* cursor) {
+    terminal_screen_get_cursor(view->screen, cursor);
+    cursor->row += view->scroll_offset;
+    return cursor->visible && cursor->row < rows && cursor->column < columns;
+}
+
+/**
+ * @brief Work out the cells the next frame draws
+ */
+static QalamResult terminal_view_collect(TerminalView* view) {
+    view->collected = false;
+
+    size_t columns = 0;
+    size_t rows = 0;
+    if (view->screen) {
+        terminal_screen_get_size(view->screen, &columns, &rows);
+    }
+    QalamResult result = terminal_view_reserve(view, columns, rows);
+    if (result != QALAM_OK) {
+        return result;
+    }
+
+    QalamDWriteCellMetrics metrics;
+    qalam_dwrite_glyph_atlas_get_cell_metrics(view->atlas, &metrics);
+
+    bool full = view->all_dirty || qalam_dwrite_render_is_full_frame(view->target) ||
+                columns != view->drawn_columns || rows != view->drawn_rows ||
+                metrics.cell_width != view->metrics.cell_width ||
+                metrics.cell_height != view->metrics.cell_height ||
+                metrics.baseline != view->metrics.baseline;
+    view->metrics = metrics;
+
+    TerminalCursor cursor = { 0, 0, false };
+    bool cursor_shown = false;
+    if (view->screen) {
+        Scrollback* scrollback = terminal_screen_get_scrollback(view->screen);
+        uint64_t end = scrollback_get_end_row(scrollback);
+        uint64_t held = end - scrollback_get_first_row(scrollback);
+
+        /* Rows arriving while scrolled back keep the rows being read in place */
+        if (view->scroll_offset > 0 && end > view->scrollback_end) {
+            view->scroll_offset += (size_t)(end - view->scrollback_end);
+        }
+        if (terminal_screen_is_alternate(view->screen)) {
+            held = 0;
+        }
+        if (view->scroll_offset > held) {
+            view->scroll_offset = (size_t)held;
+            full = true;
+        }
+        if (view->scroll_offset > 0 &&
+            (end != view->scrollback_end || terminal_screen_is_dirty(view->screen))) {
+            full = true;
+        }
+        view->scrollback_end = end;
+
+        cursor_shown = terminal_view_current_cursor(view, columns, rows, &cursor);
+    }
+
+    for (size_t row = 0; row < rows; row++) {
+        TerminalViewSpan* span = &view->spans[row];
+        span->first = 0;
+        span->end = full ? columns : 0;
+        if (!full && row >= view->scroll_offset &&
+            !terminal_screen_get_dirty(view->screen, row - view->scroll_offset,
+                                       &span->first, &span->end)) {
+            span->first = 0;
+            span->end = 0;
+        }
+    }
+
+    if (!full) {
+        /* The cells the cursor left and reached */
+        bool moved = cursor_shown != view->drawn_cursor_shown ||
+                     cursor.column != view->drawn_cursor.column ||
+                     cursor.row != view->drawn_cursor.row;
+        if (moved && view->drawn_cursor_shown && view->drawn_cursor.row < rows &&
+            view->drawn_cursor.column < columns) {
+            terminal_view_span_add(&view->spans[view->drawn_cursor.row],
+                                   view->drawn_cursor.column);
+        }
+        if (moved && cursor_shown) {
+            terminal_view_span_add(&view->spans[cursor.row], cursor.column);
+        }
+
+        for (size_t row = view->scroll_offset; row < rows; row++) {
+            TerminalViewSpan* span = &view->spans[row];
+            if (span->first < span->end) {
+                const TerminalCell* cells = terminal_screen_get_row(view->screen,
+                                                                    row - view->scroll_offset,
+                                                                    NULL);
+                terminal_view_extend_span(cells, columns, span);
+            }
+        }
+    }
+
+    view->full = full;
+    view->frame_columns = columns;
+    view->frame_rows = rows;
+    view->cursor = cursor;
+    view->cursor_shown = cursor_shown;
+    view->collected = true;
+    return QALAM_OK;
+}
+
+/*=============================================================================
+ * Internal Helper Functions: Drawing
+ *============================================================================*/
+
+static float terminal_view_cell_x(const TerminalView* view, size_t column) {
+    return view->options.padding_left + (float)column * view->metrics.cell_width;
+}
+
+static float terminal_view_cell_y(const TerminalView* view, size_t row) {
+    return view->options.padding_top + (float)row * view->metrics.cell_height;
+}
+
+/**
+ * @brief Fill the backgrounds of cells [first, end) as runs of one color
+ */
+static void terminal_view_draw_backgrounds(TerminalView* view, const TerminalCell* cells,
+                                           size_t first, size_t end, float y) {
+    size_t column = first;
+    while (column < end) {
+        uint32_t foreground;
+        uint32_t background;
+        terminal_view_cell_colors(view, &cells[column].attributes, &foreground, &background);
+
+        size_t run = column + 1;
+        while (run < end) {
+            uint32_t next_foreground;
+            uint32_t next_background;
+            terminal_view_cell_colors(view, &cells[run].attributes, &next_foreground,
+                                      &next_background);
+            if (next_background != background) {
+                break;
+            }
+            run++;
+        }
+
+        terminal_view_set_color(view, background);
+        qalam_dwrite_render_draw_rect(view->target, terminal_view_cell_x(view, column), y,
+                                      (float)(run - column) * view->metrics.cell_width,
+                                      view->metrics.cell_height, view->brush, true);
+        column = run;
+    }
+}
+
+/**
+ * @brief Draw the underline and strikethrough of cells [first, end)
+ */
+static void terminal_view_draw_decorations(TerminalView* view, uint16_t flags,
+                                           size_t first, size_t end, float y) {
+    float left = terminal_view_cell_x(view, first);
+    float right = terminal_view_cell_x(view, end);
+    float thickness = view->metrics.cell_height >= 32.0f ? 2.0f : 1.0f;
+
+    if (flags & TERMINAL_ATTR_UNDERLINE) {
+        float line_y = y + view->metrics.baseline + thickness * 1.5f;
+        if (line_y > y + view->metrics.cell_height - thickness * 0.5f) {
+            line_y = y + view->metrics.cell_height - thickness * 0.5f;
+        }
+        qalam_dwrite_render_draw_line(view->target, left, line_y, right, line_y,
+                                      view->brush, thickness);
+    }
+    if (flags & TERMINAL_ATTR_STRIKETHROUGH) {
+        float line_y = y + view->metrics.baseline * 0.65f;
+        qalam_dwrite_render_draw_line(view->target, left, line_y, right, line_y,
+                                      view->brush, thickness);
+    }
+}
+
+/**
+ * @brief Draw cells [first, end), of one style, one character per cell
+ */
+static void terminal_view_draw_plain(TerminalView* view, const TerminalCell* cells,
+                                     size_t first, size_t end, float y) {
+    for (size_t column = first; column < end; column++) {
+        view->codepoints[column - first] = TERMINAL_CELL_CHAR(cells[column].codepoint);
+    }
+    qalam_dwrite_glyph_atlas_draw_cells(view->atlas, view->codepoints, (uint32_t)(end - first),
+                                        terminal_view_style(&cells[first].attributes),
+                                        terminal_view_cell_x(view, first), y, view->brush);
+}
+
+/**
+ * @brief Draw a shaped segment [first, end) as one cluster
+ */
+static void terminal_view_draw_segment(TerminalView* view, const TerminalCell* cells,
+                                       size_t first, size_t end, float y) {
+    uint32_t length = 0;
+    bool is_rtl = false;
+    for (size_t column = first; column < end; column++) {
+        const TerminalCell* cell = &cells[column];
+        if (terminal_view_is_tail(cell)) {
+            continue;
+        }
+        if (cell->codepoint <= ' ') {
+            view->text[length++] = L' ';
+            continue;
+        }
+        is_rtl = is_rtl || terminal_view_is_arabic(TERMINAL_CELL_CHAR(cell->codepoint));
+        length += (uint32_t)terminal_cell_to_utf16(cell->codepoint, view->text + length);
+    }
+
+    if (qalam_dwrite_glyph_atlas_draw_cluster(view->atlas, view->text, length,
+                                              (uint32_t)(end - first), is_rtl,
+                                              terminal_view_style(&cells[first].attributes),
+                                              terminal_view_cell_x(view, first), y,
+                                              view->brush)) {
+        view->stats.clusters_drawn++;
+    } else {
+        terminal_view_draw_plain(view, cells, first, end, y);
+    }
+}
+
+/**
+ * @brief Draw the text of cells [first, end), one style run at a time
+ */
+static void terminal_view_draw_text(TerminalView* view, const TerminalCell* cells,
+                                    size_t columns, size_t first, size_t end, float y) {
+    size_t column = first;
+    while (column < end) {
+        size_t segment_first;
+        size_t segment_end;
+        bool shaped = terminal_view_segment_at(cells, columns, column, &segment_first,
+                                               &segment_end);
+
+        size_t run = column + 1;
+        if (shaped) {
+            run = segment_end < end ? segment_end : end;
+        } else {
+            while (run < end && terminal_view_same_attributes(&cells[run], &cells[column]) &&
+                   !terminal_view_segment_at(cells, columns, run, &segment_first,
+                                             &segment_end)) {
+                run++;
+            }
+        }
+
+        uint32_t foreground;
+        uint32_t background;
+        terminal_view_cell_colors(view, &cells[column].attributes, &foreground, &background);
+        if (foreground != background) {
+            terminal_view_set_color(view, foreground);
+            if (shaped) {
+                terminal_view_draw_segment(view, cells, column, run, y);
+            } else {
+                terminal_view_draw_plain(view, cells, column, run, y);
+            }
+            terminal_view_draw_decorations(view, cells[column].attributes.flags, column, run, y);
+        }
+        column = run;
+    }
+}
+
+/**
+ * @brief Draw the cursor block over its cell
+ */
+static void terminal_view_draw_cursor(TerminalView* view) {
+    const TerminalCell* cells = terminal_view_row(view, view->cursor.row);
+    if (!cells) {
+        return;
+    }
+
+    size_t column = view->cursor.column;
+    if (column > 0 && terminal_view_is_tail(&cells[column])) {
+        column--;
+    }
+    size_t width = column + 1 < view->frame_columns &&
+                   terminal_view_is_tail(&cells[column + 1]) ? 2 : 1;
+    float x = terminal_view_cell_x(view, column);
+    float y = terminal_view_cell_y(view, view->cursor.row);
+
+    terminal_view_set_color(view, view->options.cursor);
+    qalam_dwrite_render_draw_rect(view->target, x, y, (float)width * view->metrics.cell_width,
+                                  view->metrics.cell_height, view->brush, true);
+
+    /* The character under it, in its background color */
+    uint32_t character = TERMINAL_CELL_CHAR(cells[column].codepoint);
+    if (character > ' ') {
+        uint32_t foreground;
+        uint32_t background;
+        terminal_view_cell_colors(view, &cells[column].attributes, &foreground, &background);
+        terminal_view_set_color(view, background);
+        qalam_dwrite_glyph_atlas_draw_cells(view->atlas, &character, 1,
+                                            terminal_view_style(&cells[column].attributes),
+                                            x, y, view->brush);
+    }
+}
+
+/*=============================================================================
+ * Lifecycle
+ *============================================================================*/
+
+/**
+ * @brief Get default terminal view options
+ */
+QalamResult terminal_view_get_default_options(TerminalViewOptions* options) {
+    if (!options) {
+        return QALAM_ERROR_NULL_POINTER;
+    }
+
+    memset(options, 0, sizeof(TerminalViewOptions));
+    options->padding_left = 4.0f;
+    options->padding_top = 4.0f;
+    options->foreground = 0xCCCCCC;
+    options->background = 0x0C0C0C;
+    options->cursor = 0xFFFFFF;
+    memcpy(options->palette, g_default_palette, sizeof(g_default_palette));
+
+    return QALAM_OK;
+}
+
+/**
+ * @brief Create a terminal view
+ */
+QalamResult terminal_view_create(TerminalView** view, QalamDWriteRenderTarget* target,
+                                 QalamDWriteTextFormat* format,
+                                 const TerminalViewOptions* options) {
+    if (!view || !target || !format) {
+        return QALAM_ERROR_NULL_POINTER;
+    }
+
+    *view = NULL;
+
+    TerminalView* v = (TerminalView*)qalam_mem_calloc(QALAM_MEMORY_TERMINAL, 1,
+                                                      sizeof(TerminalView));
+    if (!v) {
+        return QALAM_ERROR_OUT_OF_MEMORY;
+    }
+
+    if (options) {
+        v->options = *options;
+    } else {
+        terminal_view_get_default_options(&v->options);
+    }
+
+    QalamResult result = qalam_dwrite_glyph_atlas_create(target, format, &v->atlas);
+    if (result == QALAM_OK) {
+        result = qalam_dwrite_brush_create_solid(
+            target, qalam_dwrite_color_from_hex(v->options.foreground), &v->brush);
+    }
+    if (result != QALAM_OK) {
+        qalam_dwrite_glyph_atlas_destroy(v->atlas);
+        qalam_mem_free(v);
+        return result;
+    }
+
+    v->target = target;
+    v->brush_color = v->options.foreground;
+    v->all_dirty = true;
+    qalam_dwrite_glyph_atlas_get_cell_metrics(v->atlas, &v->metrics);
+
+    *view = v;
+    return QALAM_OK;
+}
+
+/**
+ * @brief Destroy a terminal view
+ */
+void terminal_view_destroy(TerminalView* view) {
+    if (!view) {
+        return;
+    }
+
+    qalam_dwrite_brush_destroy(view->brush);
+    qalam_dwrite_glyph_atlas_destroy(view->atlas);
+    qalam_mem_free(view->spans);
+    qalam_mem_free(view->cells);
+    qalam_mem_free(view->codepoints);
+    qalam_mem_free(view->text);
+    qalam_mem_free(view);
+}
+
+/**
+ * @brief Show a terminal's screen, scrolled to the bottom
+ */
+void terminal_view_set_terminal(TerminalView* view, QalamTerminal* terminal) {
+    if (!view) {
+        return;
+    }
+
+    view->terminal = terminal;
+    view->screen = qalam_terminal_get_screen(terminal);
+    view->scroll_offset = 0;
+    view->scrollback_end = view->screen ?
+        scrollback_get_end_row(terminal_screen_get_scrollback(view->screen)) : 0;
+    view->drawn_cursor_shown = false;
+    view->collected = false;
+    view->all_dirty = true;
+    memset(&view->stats, 0, sizeof(TerminalViewStats));
+}
+
+/**
+ * @brief Set the viewport size and resize the terminal to fit it
+ */
+QalamResult terminal_view_resize(TerminalView* view, float width, float height) {
+    if (!view) {
+        return QALAM_ERROR_NULL_POINTER;
+    }
+
+    if (!(width >= 0.0f) || !(height >= 0.0f)) {
+        return QALAM_ERROR_INVALID_ARGUMENT;
+    }
+
+    view->width = width;
+    view->height = height;
+    view->collected = false;
+    view->all_dirty = true;
+
+    QalamDWriteCellMetrics metrics;
+    qalam_dwrite_glyph_atlas_get_cell_metrics(view->atlas, &metrics);
+
+    float grid_width = width - view->options.padding_left;
+    float grid_height = height - view->options.padding_top;
+    size_t columns = metrics.cell_width > 0.0f && grid_width > metrics.cell_width ?
+                     (size_t)(grid_width / metrics.cell_width) : 1;
+    size_t rows = metrics.cell_height > 0.0f && grid_height > metrics.cell_height ?
+                  (size_t)(grid_height / metrics.cell_height) : 1;
+    view->columns = columns < TERMINAL_SCREEN_MAX_SIZE ? columns : TERMINAL_SCREEN_MAX_SIZE;
+    view->rows = rows < TERMINAL_SCREEN_MAX_SIZE ? rows : TERMINAL_SCREEN_MAX_SIZE;
+
+    if (!view->terminal) {
+        return QALAM_OK;
+    }
+
+    /* Reflowing the screen rewraps its cells; shaped clusters stay cached */
+    QalamTerminalSize size;
+    if (qalam_terminal_get_size(view->terminal, &size) == QALAM_OK &&
+        (size_t)size.cols == view->columns && (size_t)size.rows == view->rows) {
+        return QALAM_OK;
+    }
+    return qalam_terminal_resize(view->terminal, (short)view->columns, (short)view->rows);
+}
+
+/**
+ * @brief Get the grid the viewport fits
+ */
+void terminal_view_get_grid_size(const TerminalView* view, size_t* columns, size_t* rows) {
+    if (columns) {
+        *columns = view ? view->columns : 0;
+    }
+    if (rows) {
+        *rows = view ? view->rows : 0;
+    }
+}
+
+/*=============================================================================
+ * Scrolling
+ *============================================================================*/
+
+/**
+ * @brief Scroll by a number of rows
+ */
+void terminal_view_scroll_by(TerminalView* view, ptrdiff_t delta) {
+    if (!view || !view->screen || delta == 0) {
+        return;
+    }
+
+    Scrollback* scrollback = terminal_screen_get_scrollback(view->screen);
+    uint64_t end = scrollback_get_end_row(scrollback);
+    uint64_t held = terminal_screen_is_alternate(view->screen) ?
+                    0 : end - scrollback_get_first_row(scrollback);
+
+    /* Rows that arrived since the last frame move the view first */
+    size_t offset = view->scroll_offset;
+    if (offset > 0 && end > view->scrollback_end) {
+        offset += (size_t)(end - view->scrollback_end);
+    }
+    view->scrollback_end = end;
+    if (offset > held) {
+        offset = (size_t)held;
+    }
+
+    if (delta < 0) {
+        size_t back = (size_t)(-delta);
+        offset = held - offset > back ? offset + back : (size_t)held;
+    } else {
+        offset = offset > (size_t)delta ? offset - (size_t)delta : 0;
+    }
+
+    if (offset != view->scroll_offset) {
+        view->scroll_offset = offset;
+        view->collected = false;
+        view->all_dirty = true;
+    }
+}
+
+/**
+ * @brief Scroll back down to the screen
+ */
+void terminal_view_scroll_to_bottom(TerminalView* view) {
+    if (view && view->scroll_offset > 0) {
+        view->scroll_offset = 0;
+        view->collected = false;
+        view->all_dirty = true;
+    }
+}
+
+/**
+ * @brief Get how far the view is scrolled back
+ */
+size_t terminal_view_get_scroll_offset(const TerminalView* view) {
+    return view ? view->scroll_offset : 0;
+}
+
+/*=============================================================================
+ * Dirty Region
+ *============================================================================*/
+
+/**
+ * @brief Check whether the next frame has anything to draw
+ */
+bool terminal_view_is_dirty(const TerminalView* view) {
+    if (!view) {
+        return false;
+    }
+    if (view->all_dirty) {
+        return true;
+    }
+    if (!view->screen) {
+        return false;
+    }
+    if (terminal_screen_is_dirty(view->screen)) {
+        return true;
+    }
+
+    TerminalCursor cursor;
+    bool shown = terminal_view_current_cursor(view, view->drawn_columns, view->drawn_rows,
+                                              &cursor);
+    return shown != view->drawn_cursor_shown ||
+           (shown && (cursor.column != view->drawn_cursor.column ||
+                      cursor.row != view->drawn_cursor.row));
+}
+
+/**
+ * @brief Mark the whole viewport dirty
+ */
+void terminal_view_invalidate(TerminalView* view) {
+    if (view) {
+        view->collected = false;
+        view->all_dirty = true;
+    }
+}
+
+/**
+ * @brief Work out the next frame and hand its rows to the render target
+ */
+QalamResult terminal_view_submit_dirty_rects(TerminalView* view) {
+    if (!view) {
+        return QALAM_ERROR_NULL_POINTER;
+    }
+
+    QalamResult result = terminal_view_collect(view);
+    if (result != QALAM_OK) {
+        return result;
+    }
+
+    if (view->full) {
+        qalam_dwrite_render_add_dirty_rect(view->target, 0.0f, 0.0f, view->width, view->height);
+        return QALAM_OK;
+    }
+
+    /* The target merges rects that touch, so neighbouring rows become one */
+    for (size_t row = 0; row < view->frame_rows; row++) {
+        const TerminalViewSpan* span = &view->spans[row];
+        if (span->first < span->end) {
+            qalam_dwrite_render_add_dirty_rect(
+                view->target, terminal_view_cell_x(view, span->first),
+                terminal_view_cell_y(view, row),
+                (float)(span->end - span->first) * view->metrics.cell_width,
+                view->metrics.cell_height);
+        }
+    }
+    return QALAM_OK;
+}
+
+/*=============================================================================
+ * Rendering
+ *============================================================================*/
+
+/**
+ * @brief Draw the dirty cells and the cursor, then mark the screen clean
+ */
+QalamResult terminal_view_render(TerminalView* view) {
+    if (!view) {
+        return QALAM_ERROR_NULL_POINTER;
+    }
+
+    if (!view->collected) {
+        QalamResult result = terminal_view_collect(view);
+        if (result != QALAM_OK) {
+            return result;
+        }
+    }
+
+    memset(&view->stats, 0, sizeof(TerminalViewStats));
+
+    if (view->full) {
+        terminal_view_set_color(view, view->options.background);
+        qalam_dwrite_render_draw_rect(view->target, 0.0f, 0.0f, view->width, view->height,
+                                      view->brush, true);
+    }
+
+    for (size_t row = 0; view->screen && row < view->frame_rows; row++) {
+        const TerminalViewSpan* span = &view->spans[row];
+        if (span->first >= span->end) {
+            continue;
+        }
+        const TerminalCell* cells = terminal_view_row(view, row);
+        if (!cells) {
+            continue;
+        }
+
+        float y = terminal_view_cell_y(view, row);
+        terminal_view_draw_backgrounds(view, cells, span->first, span->end, y);
+        terminal_view_draw_text(view, cells, view->frame_columns, span->first, span->end, y);
+        view->stats.rows_drawn++;
+        view->stats.cells_drawn += span->end - span->first;
+    }
+
+    if (view->cursor_shown) {
+        const TerminalViewSpan* span = &view->spans[view->cursor.row];
+        if (view->cursor.column >= span->first && view->cursor.column < span->end) {
+            terminal_view_draw_cursor(view);
+        }
+    }
+
+    if (view->screen) {
+        terminal_screen_clear_dirty(view->screen);
+    }
+    view->drawn_columns = view->frame_columns;
+    view->drawn_rows = view->frame_rows;
+    view->drawn_cursor = view->cursor;
+    view->drawn_cursor_shown = view->cursor_shown;
+    view->all_dirty = false;
+    view->collected = false;
+
+    qalam_dwrite_glyph_atlas_get_stats(view->atlas, &view->stats.atlas);
+    return QALAM_OK;
+}
+
+/**
+ * @brief Get what the last frame did
+ */
+void terminal_view_get_stats(const TerminalView* view, TerminalViewStats* stats) {
+    if (!view || !stats) {
+        return;
+    }
+
+    *stats = view->stats;
+}
@@ -0,0 +1,238 @@
+/**
+ * @file terminal_view.h
+ * @brief Qalam IDE - Terminal View (Internal Header)
+ *
+ * Internal header for the view that draws a terminal's screen into a
+ * window. Text is drawn cell by cell from a glyph atlas rather than
+ * through a text layout per row, so a frame costs a few atlas quads per
+ * changed cell and a full-screen program redrawing every frame stays
+ * cheap.
+ *
+ * Each frame draws only the cells the screen marked dirty, plus the
+ * cells the cursor left and reached, and presents just their rows (see
+ * "Dirty Region"). Arabic words and cells carrying combining marks are
+ * drawn as one shaped cluster across the cells they take; the atlas
+ * keeps clusters by their text, so a word that is redrawn, scrolled or
+ * moved by a reflow is not shaped again.
+ *
+ * The view can be scrolled back into the screen's scrollback. While it
+ * is, rows arriving at the bottom move the view with them, so the rows
+ * being read stay in place.
+ *
+ * @version 0.0.2
+ * @copyright (c) 2026 Qalam Project
+ *
+ * @note Thread Safety: Not thread-safe. Use the view from the thread
+ *       that pumps its terminal's output.
+ */
+
+#ifndef QALAM_TERMINAL_VIEW_H
+#define QALAM_TERMINAL_VIEW_H
+
+#include "qalam.h"
+#include "terminal.h"
+#include "terminal_screen.h"
+#include "dwrite_api.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*=============================================================================
+ * Configuration Constants
+ *============================================================================*/
+
+/** Colors of the 16-color palette */
+#define TERMINAL_VIEW_PALETTE_SIZE      16
+
+/*=============================================================================
+ * Terminal View Structures
+ *============================================================================*/
+
+/**
+ * @brief Terminal view options
+ *
+ * Colors are 0xRRGGBB.
+ */
+typedef struct TerminalViewOptions {
+    float padding_left;             /**< Space left of the grid in DIPs */
+    float padding_top;              /**< Space above the grid in DIPs */
+    uint32_t foreground;            /**< Default foreground */
+    uint32_t background;            /**< Default background */
+    uint32_t cursor;                /**< Cursor block */
+    uint32_t palette[TERMINAL_VIEW_PALETTE_SIZE]; /**< Colors 0-15 (the rest are fixed) */
+} TerminalViewOptions;
+
+/**
+ * @brief What the last frame did
+ */
+typedef struct TerminalViewStats {
+    size_t rows_drawn;              /**< Rows with cells drawn */
+    size_t cells_drawn;             /**< Cells drawn */
+    size_t clusters_drawn;          /**< Shaped clusters drawn */
+    QalamDWriteGlyphAtlasStats atlas; /**< Atlas totals after the frame */
+} TerminalViewStats;
+
+/**
+ * @brief Opaque terminal view
+ */
+typedef struct TerminalView TerminalView;
+
+/*=============================================================================
+ * Lifecycle
+ *============================================================================*/
+
+/**
+ * @brief Get default terminal view options
+ *
+ * @param[out] options Pointer to options structure to fill
+ * @return QALAM_OK on success
+ */
+QalamResult terminal_view_get_default_options(TerminalViewOptions* options);
+
+/**
+ * @brief Create a terminal view
+ *
+ * The view owns its glyph atlas and brush. DirectWrite must be
+ * initialized.
+ *
+ * @param[out] view Receives the view
+ * @param target Render target to draw on (must outlive the view)
+ * @param format Monospaced text format for the grid (only read during creation)
+ * @param options View options (NULL for defaults)
+ * @return QALAM_OK on success, error code on failure
+ */
+QalamResult terminal_view_create(TerminalView** view, QalamDWriteRenderTarget* target,
+                                 QalamDWriteTextFormat* format,
+                                 const TerminalViewOptions* options);
+
+/**
+ * @brief Destroy a terminal view, its atlas and brush
+ *
+ * @param view View to destroy (may be NULL)
+ */
+void terminal_view_destroy(TerminalView* view);
+
+/**
+ * @brief Show a terminal's screen, scrolled to the bottom
+ *
+ * @param view Terminal view
+ * @param terminal Terminal to show (NULL for none; must outlive its use)
+ */
+void terminal_view_set_terminal(TerminalView* view, QalamTerminal* terminal);
+
+/**
+ * @brief Set the viewport size and resize the terminal to fit it
+ *
+ * The grid takes as many whole cells as fit at the target's current
+ * DPI; call again after a DPI change. The terminal is resized through
+ * qalam_terminal_resize(), which reflows its screen.
+ *
+ * @param view Terminal view
+ * @param width Viewport width in DIPs
+ * @param height Viewport height in DIPs
+ * @return QALAM_OK on success, QALAM_ERROR_INVALID_ARGUMENT for a
+ *         negative size, or the error of qalam_terminal_resize()
+ */
+QalamResult terminal_view_resize(TerminalView* view, float width, float height);
+
+/**
+ * @brief Get the grid the viewport fits
+ *
+ * @param view Terminal view
+ * @param[out] columns Receives the columns (optional)
+ * @param[out] rows Receives the rows (optional)
+ */
+void terminal_view_get_grid_size(const TerminalView* view, size_t* columns, size_t* rows);
+
+/*=============================================================================
+ * Scrolling
+ *============================================================================*/
+
+/**
+ * @brief Scroll by a number of rows
+ *
+ * @param view Terminal view
+ * @param delta Rows to scroll (negative moves back into the scrollback)
+ */
+void terminal_view_scroll_by(TerminalView* view, ptrdiff_t delta);
+
+/**
+ * @brief Scroll back down to the screen
+ *
+ * @param view Terminal view
+ */
+void terminal_view_scroll_to_bottom(TerminalView* view);
+
+/**
+ * @brief Get how far the view is scrolled back
+ *
+ * @param view Terminal view
+ * @return Scrollback rows shown above the screen (0 at the bottom)
+ */
+size_t terminal_view_get_scroll_offset(const TerminalView* view);
+
+/*=============================================================================
+ * Dirty Region
+ *
+ * Typical use: after pumping the terminal's output, invalidate the
+ * window if terminal_view_is_dirty(); when painting, call
+ * terminal_view_submit_dirty_rects() before qalam_dwrite_render_begin()
+ * and terminal_view_render() after it.
+ *============================================================================*/
+
+/**
+ * @brief Check whether the next frame has anything to draw
+ */
+bool terminal_view_is_dirty(const TerminalView* view);
+
+/**
+ * @brief Mark the whole viewport dirty
+ *
+ * @param view Terminal view
+ */
+void terminal_view_invalidate(TerminalView* view);
+
+/**
+ * @brief Work out the cells of the next frame and hand their rows to the
+ *        render target
+ *
+ * Call before qalam_dwrite_render_begin(). When the target presents the
+ * whole window (after creation, resize or device loss) the next frame
+ * draws every cell.
+ *
+ * @param view Terminal view
+ * @return QALAM_OK on success, QALAM_ERROR_OUT_OF_MEMORY if the row
+ *         buffers could not grow to the screen
+ */
+QalamResult terminal_view_submit_dirty_rects(TerminalView* view);
+
+/*=============================================================================
+ * Rendering
+ *============================================================================*/
+
+/**
+ * @brief Draw the dirty cells and the cursor, then mark the screen clean
+ *
+ * Must be called between qalam_dwrite_render_begin() and
+ * qalam_dwrite_render_end(). Cells outside the frame's dirty region are
+ * left as the previous frame drew them.
+ *
+ * @param view Terminal view
+ * @return QALAM_OK on success, error code on failure
+ */
+QalamResult terminal_view_render(TerminalView* view);
+
+/**
+ * @brief Get what the last frame did
+ *
+ * @param view Terminal view
+ * @param[out] stats Pointer to receive the statistics
+ */
+void terminal_view_get_stats(const TerminalView* view, TerminalViewStats* stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* QALAM_TERMINAL_VIEW_H */
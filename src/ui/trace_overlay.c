@@ -0,0 +1,363 @@
+/**
+ * @file trace_overlay.c
+ * @brief Qalam IDE - Tracing Overlay Implementation
+ *
+ * Frame times come from the performance counter at
+ * trace_overlay_begin_frame() and trace_overlay_end_frame(); the
+ * subsystem rows are the tracing totals taken at the start of each
+ * frame, so they cover everything since the previous one, the reader
+ * thread's work between frames included.
+ *
+ * The panel is one text layout built per drawn frame. Its box is kept so
+ * the next frame can mark the same area dirty before drawing over it.
+ *
+ * @version 0.0.2
+ * @copyright (c) 2026 Qalam Project
+ *
+ * @note Thread Safety: See trace_overlay.h.
+ */
+
+#include "trace_overlay.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <wchar.h>
+
+/** Height marked dirty before the panel has been measured */
+#define TRACE_OVERLAY_DEFAULT_HEIGHT    150.0f
+
+/** Space between the panel's edge and its text */
+#define TRACE_OVERLAY_PADDING           6.0f
+
+/** Characters the panel's text can take */
+#define TRACE_OVERLAY_TEXT_CAPACITY     512
+
+/*=============================================================================
+ * Internal Structures
+ *============================================================================*/
+
+/**
+ * @brief Trace overlay
+ */
+struct TraceOverlay {
+    TraceOverlayOptions options;
+    QalamDWriteRenderTarget* target;
+    QalamDWriteTextFormat* format;
+    QalamDWriteBrush* foreground;
+    QalamDWriteBrush* background;
+    bool visible;
+
+    int64_t frequency;              /**< Performance counter ticks per second */
+    int64_t frame_start;            /**< Counter at the current frame's start */
+    int64_t previous_start;         /**< Counter at the previous frame's start */
+
+    double intervals[TRACE_OVERLAY_HISTORY];    /**< Frame intervals in ms */
+    double costs[TRACE_OVERLAY_HISTORY];        /**< Frame costs in ms */
+    uint64_t frames;                            /**< Frames begun */
+    uint64_t intervals_recorded;                /**< Entries written to intervals */
+    uint64_t costs_recorded;                    /**< Entries written to costs */
+
+    QalamTraceTotals totals;        /**< Taken at the current frame's start */
+    float panel_height;             /**< Height the panel was last drawn at */
+};
+
+/*=============================================================================
+ * Internal Helper Functions
+ *============================================================================*/
+
+static int64_t trace_overlay_now(void) {
+    LARGE_INTEGER now;
+    QueryPerformanceCounter(&now);
+    return now.QuadPart;
+}
+
+static double trace_overlay_ms(const TraceOverlay* overlay, int64_t ticks) {
+    return (double)ticks * 1000.0 / (double)overlay->frequency;
+}
+
+/**
+ * @brief Average and maximum of the recorded part of a history ring
+ */
+static void trace_overlay_history_stats(const double* history, uint64_t recorded,
+                                        double* out_avg, double* out_max) {
+    size_t count = recorded < TRACE_OVERLAY_HISTORY ? (size_t)recorded : TRACE_OVERLAY_HISTORY;
+    double sum = 0.0;
+    double max = 0.0;
+
+    for (size_t i = 0; i < count; i++) {
+        sum += history[i];
+        if (history[i] > max) {
+            max = history[i];
+        }
+    }
+
+    *out_avg = count ? sum / (double)count : 0.0;
+    *out_max = max;
+}
+
+static double trace_overlay_latest(const double* history, uint64_t recorded) {
+    return recorded ? history[(recorded - 1) % TRACE_OVERLAY_HISTORY] : 0.0;
+}
+
+static double ns_to_ms(uint64_t ns) {
+    return (double)ns / 1000000.0;
+}
+
+static double bytes_to_kb(int64_t bytes) {
+    return (double)bytes / 1024.0;
+}
+
+/**
+ * @brief Write the panel's text
+ *
+ * @return Characters written
+ */
+static int trace_overlay_format(const TraceOverlay* overlay, wchar_t* text, size_t capacity) {
+    TraceOverlaySummary s;
+    trace_overlay_get_summary(overlay, &s);
+
+    int length = swprintf(text, capacity,
+                          L"frame  %6.2f ms  avg %6.2f  max %6.2f\n"
+                          L"cpu    %6.2f ms  max %6.2f",
+                          s.frame_interval_ms, s.frame_interval_avg_ms, s.frame_interval_max_ms,
+                          s.frame_cost_ms, s.frame_cost_max_ms);
+    if (length < 0) {
+        return 0;
+    }
+
+    if (!qalam_trace_is_available()) {
+        int added = swprintf(text + length, capacity - (size_t)length,
+                             L"\n(build with QALAM_TRACING for subsystem costs)");
+        return added < 0 ? length : length + added;
+    }
+
+    const QalamTraceTotals* t = &s.totals;
+    int added = swprintf(
+        text + length, capacity - (size_t)length,
+        L"\nbuffer %6.2f ms  %4llu spans  %8.1f KB\n"
+        L"layout %6.2f ms  %4llu spans\n"
+        L"render %6.2f ms\n"
+        L"term   %6.2f ms  %8.1f KB\n"
+        L"pty    %6.2f ms  %8.1f KB read\n"
+        L"syntax %6.2f ms  %8lld lines",
+        ns_to_ms(t->span_ns[QALAM_TRACE_BUFFER]),
+        (unsigned long long)t->spans[QALAM_TRACE_BUFFER],
+        bytes_to_kb(t->counters[QALAM_TRACE_BUFFER]),
+        ns_to_ms(t->span_ns[QALAM_TRACE_LAYOUT]),
+        (unsigned long long)t->spans[QALAM_TRACE_LAYOUT],
+        ns_to_ms(t->span_ns[QALAM_TRACE_RENDER]),
+        ns_to_ms(t->span_ns[QALAM_TRACE_TERMINAL]),
+        bytes_to_kb(t->counters[QALAM_TRACE_TERMINAL]),
+        ns_to_ms(t->span_ns[QALAM_TRACE_TERMINAL_IO]),
+        bytes_to_kb(t->counters[QALAM_TRACE_TERMINAL_IO]),
+        ns_to_ms(t->span_ns[QALAM_TRACE_SYNTAX]),
+        (long long)t->counters[QALAM_TRACE_SYNTAX]);
+    return added < 0 ? length : length + added;
+}
+
+/*=============================================================================
+ * Lifecycle
+ *============================================================================*/
+
+/**
+ * @brief Get default trace overlay options
+ */
+QalamResult trace_overlay_get_default_options(TraceOverlayOptions* options) {
+    if (!options) {
+        return QALAM_ERROR_NULL_POINTER;
+    }
+
+    options->x = 8.0f;
+    options->y = 8.0f;
+    options->width = 300.0f;
+    options->foreground = 0xE0E0E0;
+    options->background = 0x202020;
+
+    return QALAM_OK;
+}
+
+/**
+ * @brief Create a trace overlay
+ */
+QalamResult trace_overlay_create(TraceOverlay** overlay, QalamDWriteRenderTarget* target,
+                                 QalamDWriteTextFormat* format,
+                                 const TraceOverlayOptions* options) {
+    if (!overlay || !target || !format) {
+        return QALAM_ERROR_NULL_POINTER;
+    }
+
+    *overlay = NULL;
+
+    TraceOverlay* o = (TraceOverlay*)qalam_mem_calloc(QALAM_MEMORY_UI, 1, sizeof(TraceOverlay));
+    if (!o) {
+        return QALAM_ERROR_OUT_OF_MEMORY;
+    }
+
+    if (options) {
+        o->options = *options;
+    } else {
+        trace_overlay_get_default_options(&o->options);
+    }
+
+    QalamResult result = qalam_dwrite_brush_create_solid(
+        target, qalam_dwrite_color_from_hex(o->options.foreground), &o->foreground);
+    if (result == QALAM_OK) {
+        result = qalam_dwrite_brush_create_solid(
+            target, qalam_dwrite_color_from_hex(o->options.background), &o->background);
+    }
+    if (result != QALAM_OK) {
+        qalam_dwrite_brush_destroy(o->foreground);
+        qalam_mem_free(o);
+        return result;
+    }
+
+    LARGE_INTEGER frequency;
+    QueryPerformanceFrequency(&frequency);
+    o->frequency = frequency.QuadPart;
+    o->target = target;
+    o->format = format;
+    o->panel_height = TRACE_OVERLAY_DEFAULT_HEIGHT;
+
+    *overlay = o;
+    return QALAM_OK;
+}
+
+/**
+ * @brief Destroy a trace overlay
+ */
+void trace_overlay_destroy(TraceOverlay* overlay) {
+    if (!overlay) {
+        return;
+    }
+
+    qalam_dwrite_brush_destroy(overlay->foreground);
+    qalam_dwrite_brush_destroy(overlay->background);
+    qalam_mem_free(overlay);
+}
+
+/**
+ * @brief Show or hide the panel
+ */
+void trace_overlay_set_visible(TraceOverlay* overlay, bool visible) {
+    if (overlay) {
+        overlay->visible = visible;
+    }
+}
+
+/**
+ * @brief Check whether the panel is shown
+ */
+bool trace_overlay_is_visible(const TraceOverlay* overlay) {
+    return overlay && overlay->visible;
+}
+
+/*=============================================================================
+ * Frames
+ *============================================================================*/
+
+/**
+ * @brief Start timing a frame, and mark the panel dirty if it is shown
+ */
+void trace_overlay_begin_frame(TraceOverlay* overlay) {
+    if (!overlay) {
+        return;
+    }
+
+    int64_t now = trace_overlay_now();
+    if (overlay->frames > 0) {
+        overlay->intervals[overlay->intervals_recorded % TRACE_OVERLAY_HISTORY] =
+            trace_overlay_ms(overlay, now - overlay->previous_start);
+        overlay->intervals_recorded++;
+    }
+    overlay->previous_start = now;
+    overlay->frame_start = now;
+    overlay->frames++;
+
+    qalam_trace_take_totals(&overlay->totals);
+
+    if (overlay->visible) {
+        qalam_dwrite_render_add_dirty_rect(overlay->target, overlay->options.x,
+                                           overlay->options.y, overlay->options.width,
+                                           overlay->panel_height);
+    }
+}
+
+/**
+ * @brief Draw the panel, if it is shown
+ */
+QalamResult trace_overlay_render(TraceOverlay* overlay) {
+    if (!overlay) {
+        return QALAM_ERROR_NULL_POINTER;
+    }
+    if (!overlay->visible) {
+        return QALAM_OK;
+    }
+
+    wchar_t text[TRACE_OVERLAY_TEXT_CAPACITY];
+    int length = trace_overlay_format(overlay, text, TRACE_OVERLAY_TEXT_CAPACITY);
+
+    float text_width = overlay->options.width - 2.0f * TRACE_OVERLAY_PADDING;
+    QalamDWriteTextLayout* layout = NULL;
+    QalamResult result = qalam_dwrite_text_layout_create(
+        text, (uint32_t)length, overlay->format, text_width > 1.0f ? text_width : 1.0f,
+        TRACE_OVERLAY_DEFAULT_HEIGHT * 4.0f, &layout);
+    if (result != QALAM_OK) {
+        return result;
+    }
+
+    QalamDWriteTextMetrics metrics;
+    if (qalam_dwrite_text_layout_get_metrics(layout, &metrics) == QALAM_OK) {
+        /* The line count is fixed, so this settles after the first frame */
+        overlay->panel_height = metrics.height + 2.0f * TRACE_OVERLAY_PADDING;
+    }
+
+    qalam_dwrite_render_draw_rect(overlay->target, overlay->options.x, overlay->options.y,
+                                  overlay->options.width, overlay->panel_height,
+                                  overlay->background, true);
+    qalam_dwrite_render_draw_text(overlay->target, layout,
+                                  overlay->options.x + TRACE_OVERLAY_PADDING,
+                                  overlay->options.y + TRACE_OVERLAY_PADDING,
+                                  overlay->foreground);
+
+    qalam_dwrite_text_layout_destroy(layout);
+    return QALAM_OK;
+}
+
+/**
+ * @brief Stop timing the frame begun by trace_overlay_begin_frame()
+ */
+void trace_overlay_end_frame(TraceOverlay* overlay) {
+    if (!overlay || overlay->frames == 0) {
+        return;
+    }
+
+    overlay->costs[overlay->costs_recorded % TRACE_OVERLAY_HISTORY] =
+        trace_overlay_ms(overlay, trace_overlay_now() - overlay->frame_start);
+    overlay->costs_recorded++;
+}
+
+/**
+ * @brief Get what the panel shows
+ */
+void trace_overlay_get_summary(const TraceOverlay* overlay, TraceOverlaySummary* summary) {
+    if (!summary) {
+        return;
+    }
+
+    memset(summary, 0, sizeof(*summary));
+    if (!overlay) {
+        return;
+    }
+
+    double unused_avg = 0.0;
+    summary->frame_interval_ms = trace_overlay_latest(overlay->intervals,
+                                                      overlay->intervals_recorded);
+    trace_overlay_history_stats(overlay->intervals, overlay->intervals_recorded,
+                                &summary->frame_interval_avg_ms,
+                                &summary->frame_interval_max_ms);
+    summary->frame_cost_ms = trace_overlay_latest(overlay->costs, overlay->costs_recorded);
+    trace_overlay_history_stats(overlay->costs, overlay->costs_recorded, &unused_avg,
+                                &summary->frame_cost_max_ms);
+    summary->totals = overlay->totals;
+    summary->frames = overlay->frames;
+}
@@ -0,0 +1,174 @@
+/**
+ * @file trace_overlay.h
+ * @brief Qalam IDE - Tracing Overlay (Internal Header)
+ *
+ * Internal header for a small panel drawn over the window that shows
+ * how long frames take and where the time went: the interval between
+ * frames, the time spent producing the last one, and what each tracing
+ * category (see "Tracing" in qalam.h) cost since the frame before. The
+ * per-category rows need a build with QALAM_ENABLE_TRACING; without it
+ * the panel shows the frame times alone.
+ *
+ * The panel is hidden until trace_overlay_set_visible() shows it. It is
+ * only redrawn with frames that are drawn anyway, so showing it does not
+ * keep an idle window busy.
+ *
+ * @version 0.0.2
+ * @copyright (c) 2026 Qalam Project
+ *
+ * @note Thread Safety: Not thread-safe. Use the overlay from the thread
+ *       that draws the window.
+ */
+
+#ifndef QALAM_TRACE_OVERLAY_H
+#define QALAM_TRACE_OVERLAY_H
+
+#include "qalam.h"
+#include "dwrite_api.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*=============================================================================
+ * Configuration Constants
+ *============================================================================*/
+
+/** Frames the averages and maxima are taken over */
+#define TRACE_OVERLAY_HISTORY           32
+
+/*=============================================================================
+ * Trace Overlay Structures
+ *============================================================================*/
+
+/**
+ * @brief Trace overlay options
+ *
+ * Colors are 0xRRGGBB.
+ */
+typedef struct TraceOverlayOptions {
+    float x;                        /**< Left edge of the panel in DIPs */
+    float y;                        /**< Top edge of the panel in DIPs */
+    float width;                    /**< Panel width in DIPs */
+    uint32_t foreground;            /**< Text */
+    uint32_t background;            /**< Panel */
+} TraceOverlayOptions;
+
+/**
+ * @brief What the overlay shows, in milliseconds unless noted
+ */
+typedef struct TraceOverlaySummary {
+    double frame_interval_ms;       /**< Between the last two frames */
+    double frame_interval_avg_ms;   /**< Average over the history */
+    double frame_interval_max_ms;   /**< Longest in the history */
+    double frame_cost_ms;           /**< From trace_overlay_begin_frame() to _end_frame() */
+    double frame_cost_max_ms;       /**< Longest in the history */
+    QalamTraceTotals totals;        /**< Tracing totals since the frame before */
+    uint64_t frames;                /**< Frames recorded */
+} TraceOverlaySummary;
+
+/**
+ * @brief Opaque trace overlay
+ */
+typedef struct TraceOverlay TraceOverlay;
+
+/*=============================================================================
+ * Lifecycle
+ *============================================================================*/
+
+/**
+ * @brief Get default trace overlay options
+ *
+ * @param[out] options Pointer to options structure to fill
+ * @return QALAM_OK on success
+ */
+QalamResult trace_overlay_get_default_options(TraceOverlayOptions* options);
+
+/**
+ * @brief Create a trace overlay
+ *
+ * @param[out] overlay Receives the overlay
+ * @param target Render target to draw on (must outlive the overlay)
+ * @param format Text format of the panel, ideally monospaced (must
+ *        outlive the overlay)
+ * @param options Overlay options (NULL for defaults)
+ * @return QALAM_OK on success, error code on failure
+ */
+QalamResult trace_overlay_create(TraceOverlay** overlay, QalamDWriteRenderTarget* target,
+                                 QalamDWriteTextFormat* format,
+                                 const TraceOverlayOptions* options);
+
+/**
+ * @brief Destroy a trace overlay
+ *
+ * @param overlay Overlay to destroy (may be NULL)
+ */
+void trace_overlay_destroy(TraceOverlay* overlay);
+
+/**
+ * @brief Show or hide the panel
+ *
+ * Hiding it leaves the panel on screen until whatever is beneath it is
+ * drawn again; invalidate the views under it.
+ *
+ * @param overlay Trace overlay
+ * @param visible Whether to show the panel
+ */
+void trace_overlay_set_visible(TraceOverlay* overlay, bool visible);
+
+/**
+ * @brief Check whether the panel is shown
+ */
+bool trace_overlay_is_visible(const TraceOverlay* overlay);
+
+/*=============================================================================
+ * Frames
+ *
+ * Typical use, in the frame callback: trace_overlay_begin_frame() first,
+ * before the views submit their dirty rects; trace_overlay_render() last
+ * before qalam_dwrite_render_end(); and trace_overlay_end_frame() after
+ * it. Frames are timed whether or not the panel is shown.
+ *============================================================================*/
+
+/**
+ * @brief Start timing a frame, and mark the panel dirty if it is shown
+ *
+ * Takes the tracing totals since the previous frame (see
+ * qalam_trace_take_totals()).
+ *
+ * @param overlay Trace overlay
+ */
+void trace_overlay_begin_frame(TraceOverlay* overlay);
+
+/**
+ * @brief Draw the panel, if it is shown
+ *
+ * Must be called between qalam_dwrite_render_begin() and
+ * qalam_dwrite_render_end(). The panel's own text layout is counted in
+ * the next frame's layout row.
+ *
+ * @param overlay Trace overlay
+ * @return QALAM_OK on success (also when hidden), error code on failure
+ */
+QalamResult trace_overlay_render(TraceOverlay* overlay);
+
+/**
+ * @brief Stop timing the frame begun by trace_overlay_begin_frame()
+ *
+ * @param overlay Trace overlay
+ */
+void trace_overlay_end_frame(TraceOverlay* overlay);
+
+/**
+ * @brief Get what the panel shows
+ *
+ * @param overlay Trace overlay
+ * @param[out] summary Pointer to receive the summary
+ */
+void trace_overlay_get_summary(const TraceOverlay* overlay, TraceOverlaySummary* summary);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* QALAM_TRACE_OVERLAY_H */
@@ -19,6 +19,8 @@
 /* Include the header for the buffer API */
 #include "editor.h"
 #include "qalam.h"
+#include "text_scan.h"
+#include "syntax_lexer.h"
 
 /*=============================================================================
  * Test Framework Macros
@@ -554,6 +556,109 @@ static int test_get_line(void) {
     return 0;
 }
 
+/**
+ * @brief Check every line against the full content split on newlines
+ */
+static int verify_lines_match_content(QalamBuffer* buffer) {
+    size_t size = qalam_buffer_get_size(buffer);
+    char* content = (char*)malloc(size + 1);
+    char* line = (char*)malloc(size + 1);
+    TEST_ASSERT(content != NULL && line != NULL);
+    
+    size_t written;
+    qalam_buffer_get_content(buffer, content, size + 1, &written);
+    
+    size_t line_number = 0;
+    char* cur = content;
+    for (;;) {
+        char* nl = strchr(cur, '\n');
+        size_t expected_len = nl ? (size_t)(nl - cur) : strlen(cur);
+        
+        QalamResult result = qalam_buffer_get_line(buffer, line_number, line, size + 1, &written);
+        TEST_ASSERT(result == QALAM_OK);
+        TEST_ASSERT_EQ(expected_len, written);
+        TEST_ASSERT(memcmp(cur, line, expected_len) == 0);
+        
+        line_number++;
+        if (!nl) {
+            break;
+        }
+        cur = nl + 1;
+    }
+    
+    TEST_ASSERT_EQ(line_number, qalam_buffer_get_line_count(buffer));
+    
+    free(content);
+    free(line);
+    return 0;
+}
+
+/**
+ * @brief Test line index stays correct across chunk splits and merges
+ */
+static int test_line_index_large_edits(void) {
+    /* Build 5000 short lines so the index spans many chunks */
+    size_t cap = 5000 * 16;
+    char* text = (char*)malloc(cap);
+    TEST_ASSERT(text != NULL);
+    
+    size_t pos = 0;
+    for (int i = 0; i < 5000; i++) {
+        pos += (size_t)sprintf(text + pos, "Line %d\n", i);
+    }
+    
+    QalamBuffer* buffer = NULL;
+    TEST_ASSERT(qalam_buffer_create_from_text(&buffer, text, pos) == QALAM_OK);
+    free(text);
+    
+    TEST_ASSERT_EQ(5001, qalam_buffer_get_line_count(buffer));
+    
+    char line[256];
+    size_t written;
+    qalam_buffer_get_line(buffer, 4321, line, sizeof(line), &written);
+    TEST_ASSERT_STR_EQ("Line 4321", line);
+    
+    /* Jump to a line far into the buffer */
+    QalamCursor cursor;
+    qalam_buffer_set_cursor(buffer, 3000, 2);
+    qalam_buffer_get_cursor(buffer, &cursor);
+    TEST_ASSERT_EQ(3000, cursor.line);
+    TEST_ASSERT_EQ(2, cursor.column);
+    
+    /* Delete a range spanning several chunks */
+    QalamLineInfo first, last;
+    qalam_buffer_get_line_info(buffer, 100, &first);
+    qalam_buffer_get_line_info(buffer, 2900, &last);
+    qalam_buffer_delete_range(buffer, first.start_offset + 2, last.start_offset + 3);
+    TEST_ASSERT_EQ(5001 - 2800, qalam_buffer_get_line_count(buffer));
+    
+    qalam_buffer_get_line(buffer, 100, line, sizeof(line), &written);
+    TEST_ASSERT_STR_EQ("Lie 2900", line);
+    TEST_ASSERT(verify_lines_match_content(buffer) == 0);
+    
+    /* Insert a multi-line paste large enough to split a chunk */
+    char* paste = (char*)malloc(3000 * 4);
+    TEST_ASSERT(paste != NULL);
+    for (int i = 0; i < 3000; i++) {
+        memcpy(paste + i * 4, "ab\n", 3);
+        paste[i * 4 + 3] = 'c';
+    }
+    qalam_buffer_insert_at(buffer, 5, paste, 3000 * 4);
+    free(paste);
+    TEST_ASSERT_EQ(5001 - 2800 + 3000, qalam_buffer_get_line_count(buffer));
+    TEST_ASSERT(verify_lines_match_content(buffer) == 0);
+    
+    /* Delete everything but the first line, then backspace over newlines */
+    qalam_buffer_cursor_to_end(buffer);
+    qalam_buffer_delete(buffer, -10);
+    qalam_buffer_set_cursor(buffer, 1, 0);
+    qalam_buffer_delete(buffer, -1);
+    TEST_ASSERT(verify_lines_match_content(buffer) == 0);
+    
+    qalam_buffer_destroy(buffer);
+    return 0;
+}
+
 /*=============================================================================
  * Empty Buffer Edge Cases
  *============================================================================*/
@@ -828,6 +933,55 @@ static int test_large_content_10mb(void) {
     double mid_insert_time = (double)(end.QuadPart - start.QuadPart) / freq.QuadPart;
     printf("\n    Insert at middle time: %.3f seconds", mid_insert_time);
     
+    /* Time typing 10k single characters in the middle */
+    QalamCursor before, after;
+    qalam_buffer_get_cursor(buffer, &before);
+    
+    QueryPerformanceCounter(&start);
+    for (int i = 0; i < 10000; i++) {
+        qalam_buffer_insert(buffer, "x", 1);
+    }
+    QueryPerformanceCounter(&end);
+    
+    double typing_time = (double)(end.QuadPart - start.QuadPart) / freq.QuadPart;
+    printf("\n    10k keystrokes at middle: %.3f seconds (%.2f us/key)",
+           typing_time, typing_time * 1e6 / 10000);
+    
+    qalam_buffer_get_cursor(buffer, &after);
+    TEST_ASSERT_EQ(before.line, after.line);
+    TEST_ASSERT_EQ(before.column + 10000, after.column);
+    
+    /* Time 10k backspaces over the typed characters */
+    QueryPerformanceCounter(&start);
+    for (int i = 0; i < 10000; i++) {
+        qalam_buffer_delete(buffer, -1);
+    }
+    QueryPerformanceCounter(&end);
+    
+    double backspace_time = (double)(end.QuadPart - start.QuadPart) / freq.QuadPart;
+    printf("\n    10k backspaces at middle: %.3f seconds (%.2f us/key)",
+           backspace_time, backspace_time * 1e6 / 10000);
+    
+    qalam_buffer_get_cursor(buffer, &after);
+    TEST_ASSERT_EQ(before.line, after.line);
+    TEST_ASSERT_EQ(before.column, after.column);
+    
+    /* Same keystrokes in a tiny buffer for comparison */
+    QalamBuffer* small = NULL;
+    qalam_buffer_create_from_text(&small, "short line\nsecond line", 0);
+    qalam_buffer_set_cursor(small, 1, 3);
+    
+    QueryPerformanceCounter(&start);
+    for (int i = 0; i < 10000; i++) {
+        qalam_buffer_insert(small, "x", 1);
+    }
+    QueryPerformanceCounter(&end);
+    
+    double small_time = (double)(end.QuadPart - start.QuadPart) / freq.QuadPart;
+    printf("\n    10k keystrokes in small buffer: %.3f seconds (%.2f us/key)",
+           small_time, small_time * 1e6 / 10000);
+    
+    qalam_buffer_destroy(small);
     free(large_text);
     qalam_buffer_destroy(buffer);
     return 0;
@@ -974,6 +1128,174 @@ static int test_line_info(void) {
     return 0;
 }
 
+/**
+ * @brief Test that cached line info follows edits to the line
+ */
+static int test_line_info_cache(void) {
+    QalamBuffer* buffer = NULL;
+    const char* text = "مرحبا\nHello\nسلام";
+    qalam_buffer_create_from_text(&buffer, text, strlen(text));
+    
+    QalamLineInfo info;
+    
+    /* Query twice: the second answer comes from the cache */
+    qalam_buffer_get_line_info(buffer, 0, &info);
+    qalam_buffer_get_line_info(buffer, 0, &info);
+    TEST_ASSERT(info.direction == QALAM_DIR_RTL);
+    TEST_ASSERT_EQ(10, info.length_bytes);
+    
+    /* Typing Latin into the Arabic line makes it mixed */
+    qalam_buffer_insert_at(buffer, 2, "ab", 2);
+    qalam_buffer_get_line_info(buffer, 0, &info);
+    TEST_ASSERT(info.direction == QALAM_DIR_AUTO);
+    TEST_ASSERT_EQ(12, info.length_bytes);
+    
+    /* Untouched lines keep their answers */
+    qalam_buffer_get_line_info(buffer, 1, &info);
+    TEST_ASSERT(info.direction == QALAM_DIR_LTR);
+    qalam_buffer_get_line_info(buffer, 2, &info);
+    TEST_ASSERT(info.direction == QALAM_DIR_RTL);
+    
+    /* Removing it again restores the original answer */
+    qalam_buffer_delete_range(buffer, 2, 4);
+    qalam_buffer_get_line_info(buffer, 0, &info);
+    TEST_ASSERT(info.direction == QALAM_DIR_RTL);
+    TEST_ASSERT_EQ(10, info.length_bytes);
+    
+    /* Joining lines merges their content */
+    qalam_buffer_delete_range(buffer, 5, 6);
+    TEST_ASSERT_EQ(2, qalam_buffer_get_line_count(buffer));
+    qalam_buffer_get_line_info(buffer, 0, &info);
+    TEST_ASSERT(info.direction == QALAM_DIR_AUTO);
+    TEST_ASSERT_EQ(15, info.length_bytes);
+    qalam_buffer_get_line_info(buffer, 1, &info);
+    TEST_ASSERT(info.direction == QALAM_DIR_RTL);
+    
+    /* Splitting a line gives both halves fresh answers */
+    qalam_buffer_insert_at(buffer, 5, "\n", 1);
+    qalam_buffer_get_line_info(buffer, 0, &info);
+    TEST_ASSERT(info.direction == QALAM_DIR_RTL);
+    qalam_buffer_get_line_info(buffer, 1, &info);
+    TEST_ASSERT(info.direction == QALAM_DIR_LTR);
+    TEST_ASSERT_EQ(5, info.length_bytes);
+    
+    qalam_buffer_destroy(buffer);
+    return 0;
+}
+
+static int test_line_generation(void) {
+    QalamBuffer* buffer = NULL;
+    const char* text = "سطر\nline\nآخر";
+    qalam_buffer_create_from_text(&buffer, text, strlen(text));
+    
+    /* Stable while nothing changes, distinct per line */
+    uint32_t gen0 = qalam_buffer_get_line_generation(buffer, 0);
+    uint32_t gen1 = qalam_buffer_get_line_generation(buffer, 1);
+    uint32_t gen2 = qalam_buffer_get_line_generation(buffer, 2);
+    TEST_ASSERT(gen0 != 0 && gen1 != 0 && gen2 != 0);
+    TEST_ASSERT(gen0 != gen1 && gen1 != gen2 && gen0 != gen2);
+    TEST_ASSERT_EQ(gen1, qalam_buffer_get_line_generation(buffer, 1));
+    TEST_ASSERT_EQ(0, qalam_buffer_get_line_generation(buffer, 3));
+    
+    /* Editing a line replaces only its generation */
+    qalam_buffer_insert_at(buffer, 5, "s", 1);
+    uint32_t edited = qalam_buffer_get_line_generation(buffer, 1);
+    TEST_ASSERT(edited != gen1 && edited != gen0 && edited != gen2);
+    TEST_ASSERT_EQ(gen0, qalam_buffer_get_line_generation(buffer, 0));
+    TEST_ASSERT_EQ(gen2, qalam_buffer_get_line_generation(buffer, 2));
+    
+    /* Lines moved down by a new line above keep theirs */
+    qalam_buffer_insert_at(buffer, 0, "\n", 1);
+    TEST_ASSERT_EQ(4, qalam_buffer_get_line_count(buffer));
+    TEST_ASSERT_EQ(edited, qalam_buffer_get_line_generation(buffer, 2));
+    TEST_ASSERT_EQ(gen2, qalam_buffer_get_line_generation(buffer, 3));
+    
+    /* Undo gives the restored line a new one */
+    qalam_buffer_undo(buffer);
+    TEST_ASSERT(qalam_buffer_get_line_generation(buffer, 0) != gen0);
+    TEST_ASSERT_EQ(edited, qalam_buffer_get_line_generation(buffer, 1));
+    
+    /* Generations are not reused by other buffers */
+    QalamBuffer* other = NULL;
+    qalam_buffer_create_from_text(&other, text, strlen(text));
+    TEST_ASSERT(qalam_buffer_get_line_generation(other, 0) > edited);
+    
+    qalam_buffer_destroy(other);
+    qalam_buffer_destroy(buffer);
+    return 0;
+}
+
+/**
+ * @brief Check that a view spells out the given UTF-8 text
+ */
+static bool view_equals(const QalamTextView* view, const char* expected) {
+    wchar_t wide[256];
+    int wide_len = MultiByteToWideChar(CP_UTF8, 0, expected, (int)strlen(expected), wide, 256);
+    if (wide_len < 0 || view->length != (size_t)wide_len) {
+        return false;
+    }
+    
+    size_t pos = 0;
+    for (size_t i = 0; i < view->segment_count; i++) {
+        if (memcmp(view->segments[i], wide + pos, view->lengths[i] * sizeof(wchar_t)) != 0) {
+            return false;
+        }
+        pos += view->lengths[i];
+    }
+    return pos == view->length;
+}
+
+/**
+ * @brief Test zero-copy line views over the gap buffer
+ */
+static int test_line_view(void) {
+    QalamBuffer* buffer = NULL;
+    const char* text = "Hello\nمرحبا بالعالم\nWorld";
+    qalam_buffer_create_from_text(&buffer, text, strlen(text));
+    
+    /* Typing in the middle of line 1 leaves the gap there */
+    qalam_buffer_set_cursor(buffer, 1, 5);
+    qalam_buffer_insert(buffer, "،", strlen("،"));
+    
+    QalamTextView view;
+    TEST_ASSERT(qalam_buffer_get_line_view(buffer, 1, false, &view) == QALAM_OK);
+    TEST_ASSERT_EQ(2, view.segment_count);
+    TEST_ASSERT(view_equals(&view, "مرحبا، بالعالم"));
+    
+    /* Lines away from the gap are a single segment */
+    TEST_ASSERT(qalam_buffer_get_line_view(buffer, 2, false, &view) == QALAM_OK);
+    TEST_ASSERT_EQ(1, view.segment_count);
+    TEST_ASSERT(view_equals(&view, "World"));
+    
+    /* Asking for one span moves the gap but not the cursor */
+    QalamCursor before, after;
+    qalam_buffer_get_cursor(buffer, &before);
+    TEST_ASSERT(qalam_buffer_get_line_view(buffer, 1, true, &view) == QALAM_OK);
+    TEST_ASSERT_EQ(1, view.segment_count);
+    TEST_ASSERT(view_equals(&view, "مرحبا، بالعالم"));
+    qalam_buffer_get_cursor(buffer, &after);
+    TEST_ASSERT_EQ(before.offset, after.offset);
+    TEST_ASSERT_EQ(before.column, after.column);
+    
+    /* Editing after the view still lands at the cursor */
+    qalam_buffer_insert(buffer, "!", 1);
+    char line[256];
+    size_t written;
+    qalam_buffer_get_line(buffer, 1, line, sizeof(line), &written);
+    TEST_ASSERT_STR_EQ("مرحبا،! بالعالم", line);
+    
+    /* Ranges and empty text */
+    TEST_ASSERT(qalam_buffer_get_range_view(buffer, 0, 5, false, &view) == QALAM_OK);
+    TEST_ASSERT(view_equals(&view, "Hello"));
+    TEST_ASSERT(qalam_buffer_get_range_view(buffer, 3, 3, true, &view) == QALAM_OK);
+    TEST_ASSERT_EQ(0, view.segment_count);
+    TEST_ASSERT_EQ(0, view.length);
+    TEST_ASSERT(qalam_buffer_get_line_view(buffer, 3, false, &view) == QALAM_ERROR_INVALID_RANGE);
+    
+    qalam_buffer_destroy(buffer);
+    return 0;
+}
+
 /*=============================================================================
  * Error Handling Tests
  *============================================================================*/
@@ -1002,77 +1324,2065 @@ static int test_error_handling(void) {
 }
 
 /*=============================================================================
- * Main Test Runner
+ * Text Scanning Kernel Tests
  *============================================================================*/
 
-int main(int argc, char* argv[]) {
-    printf("===========================================\n");
-    printf("  Qalam IDE - Gap Buffer Unit Tests\n");
-    printf("===========================================\n\n");
+/**
+ * @brief Test every kernel level against the scalar results
+ * 
+ * Spans start at every alignment and end inside and past vector widths,
+ * so the vector loops and their scalar tails are both exercised.
+ */
+static int test_text_scan_levels(void) {
+    static const wchar_t alphabet[] = {
+        L'\n', L'a', L'Z', L' ', 0x0627, 0x05D0, 0xFE8D, 0x08A0, 0x4E2D, 0xD83D, 0xDE00
+    };
+    const size_t alphabet_len = sizeof(alphabet) / sizeof(alphabet[0]);
+    
+    wchar_t text[512];
+    unsigned int seed = 7;
+    
+    TextScanLevel supported = text_scan_get_supported_level();
+    TextScanLevel original = text_scan_get_level();
+    
+    for (int round = 0; round < 200; round++) {
+        /* Sparse rounds leave long runs without a newline or a letter */
+        size_t used = round % 3 == 0 ? 3 : alphabet_len;
+        for (size_t i = 0; i < 512; i++) {
+            seed = seed * 1103515245u + 12345u;
+            text[i] = alphabet[(seed >> 16) % used];
+            if (round % 3 == 0 && (seed >> 8) % 64 != 0) {
+                text[i] = L' ';
+            }
+        }
+        
+        size_t start = (size_t)round % 17;
+        size_t length = (size_t)(round * 7) % (512 - start);
+        
+        text_scan_set_level(TEXT_SCAN_SCALAR);
+        size_t count = text_count_newlines(text + start, length);
+        size_t first = text_find_newline(text + start, length);
+        unsigned int flags = text_classify_bidi(text + start, length);
+        
+        for (int level = TEXT_SCAN_SSE2; level <= (int)supported; level++) {
+            TEST_ASSERT_EQ(level, (int)text_scan_set_level((TextScanLevel)level));
+            TEST_ASSERT_EQ(count, text_count_newlines(text + start, length));
+            TEST_ASSERT_EQ(first, text_find_newline(text + start, length));
+            TEST_ASSERT_EQ(flags, text_classify_bidi(text + start, length));
+        }
+    }
     
-    /* Set console to UTF-8 for proper display */
-    SetConsoleOutputCP(CP_UTF8);
+    /* Enough newlines to overflow a 16-bit lane counter */
+    size_t big_len = 8 * 70000 + 5;
+    wchar_t* big = (wchar_t*)malloc(big_len * sizeof(wchar_t));
+    TEST_ASSERT(big != NULL);
+    for (size_t i = 0; i < big_len; i++) {
+        big[i] = L'\n';
+    }
+    for (int level = TEXT_SCAN_SCALAR; level <= (int)supported; level++) {
+        text_scan_set_level((TextScanLevel)level);
+        TEST_ASSERT_EQ(big_len, text_count_newlines(big, big_len));
+    }
     
-    printf("Buffer Creation and Destruction:\n");
-    RUN_TEST(buffer_create_empty);
-    RUN_TEST(buffer_create_with_capacity);
-    RUN_TEST(buffer_create_from_text);
-    RUN_TEST(buffer_destroy_null);
-    RUN_TEST(buffer_create_null_pointer);
+    /* Throughput over newline-free text, as when appending long lines */
+    for (size_t i = 0; i < big_len; i++) {
+        big[i] = 0x0627;
+    }
+    LARGE_INTEGER start_time, end_time, freq;
+    QueryPerformanceFrequency(&freq);
+    for (int level = TEXT_SCAN_SCALAR; level <= (int)supported; level++) {
+        text_scan_set_level((TextScanLevel)level);
+        size_t found = 0;
+        QueryPerformanceCounter(&start_time);
+        for (int rep = 0; rep < 100; rep++) {
+            found += text_find_newline(big, big_len);
+        }
+        QueryPerformanceCounter(&end_time);
+        TEST_ASSERT_EQ(100 * big_len, found);
+        double seconds = (double)(end_time.QuadPart - start_time.QuadPart) / freq.QuadPart;
+        printf("\n    find_newline level %d: %.2f GB/s", level,
+               100.0 * big_len * sizeof(wchar_t) / (seconds > 0 ? seconds : 1e-9) / 1e9);
+    }
     
-    printf("\nInsert Operations:\n");
-    RUN_TEST(insert_at_beginning_empty);
-    RUN_TEST(insert_at_beginning);
-    RUN_TEST(insert_at_middle);
-    RUN_TEST(insert_at_end);
-    RUN_TEST(insert_at_position);
-    RUN_TEST(insert_newlines);
+    free(big);
+
+    /* Control bytes in UTF-8 terminal output, one at each position */
+    char bytes[160];
+    for (size_t i = 0; i < sizeof(bytes); i++) {
+        bytes[i] = (char)(0x80 + i % 0x40);
+    }
+    memcpy(bytes + 7, "م a~", strlen("م a~"));
+    static const char controls[] = { 0x00, 0x07, 0x0A, 0x1B, 0x1F, 0x7F };
+    for (size_t k = 0; k < sizeof(controls); k++) {
+        for (size_t at = 0; at < sizeof(bytes); at += 3) {
+            char saved = bytes[at];
+            bytes[at] = controls[k];
+            for (int level = TEXT_SCAN_SCALAR; level <= (int)supported; level++) {
+                text_scan_set_level((TextScanLevel)level);
+                TEST_ASSERT_EQ(at, text_find_control(bytes, sizeof(bytes)));
+                TEST_ASSERT_EQ(at, text_find_control(bytes, at));
+            }
+            bytes[at] = saved;
+        }
+    }
+
+    text_scan_set_level(original);
+    return 0;
+}
+
+/*=============================================================================
+ * Piece Table Backend Tests
+ *============================================================================*/
+
+static QalamResult create_piece_table_buffer(QalamBuffer** buffer, const char* text) {
+    QalamBufferOptions options;
+    qalam_buffer_get_default_options(&options);
+    options.backend = QALAM_BUFFER_BACKEND_PIECE_TABLE;
+    return qalam_buffer_create_from_text_with_options(buffer, text, 0, &options);
+}
+
+static int test_piece_table_basic(void) {
+    QalamBuffer* buffer = NULL;
+    TEST_ASSERT(create_piece_table_buffer(&buffer, "Hello\nWorld") == QALAM_OK);
+    TEST_ASSERT(qalam_buffer_get_backend(buffer) == QALAM_BUFFER_BACKEND_PIECE_TABLE);
+    TEST_ASSERT_EQ(2, qalam_buffer_get_line_count(buffer));
     
-    printf("\nDelete Operations:\n");
-    RUN_TEST(delete_at_beginning);
-    RUN_TEST(delete_at_middle);
-    RUN_TEST(delete_at_end);
-    RUN_TEST(delete_range);
-    RUN_TEST(delete_newlines);
+    /* Cursor starts at the end, as with the gap buffer */
+    QalamCursor cursor;
+    qalam_buffer_get_cursor(buffer, &cursor);
+    TEST_ASSERT_EQ(11, cursor.offset);
+    TEST_ASSERT_EQ(1, cursor.line);
+    TEST_ASSERT_EQ(5, cursor.column);
     
-    printf("\nCursor Movement:\n");
-    RUN_TEST(cursor_movement);
-    RUN_TEST(cursor_line_start_end);
-    RUN_TEST(cursor_relative_movement);
+    /* Typing extends one piece; inserting elsewhere splits the original */
+    qalam_buffer_insert(buffer, "!", 1);
+    qalam_buffer_insert(buffer, "!", 1);
+    qalam_buffer_insert_at(buffer, 5, ", ", 2);
+    qalam_buffer_insert(buffer, "Qalam", 5);
     
-    printf("\nLine Counting:\n");
-    RUN_TEST(line_count_multiple);
-    RUN_TEST(line_count_insert);
-    RUN_TEST(get_line);
+    char content[256];
+    size_t written;
+    qalam_buffer_get_content(buffer, content, sizeof(content), &written);
+    TEST_ASSERT_STR_EQ("Hello, Qalam\nWorld!!", content);
     
-    printf("\nEmpty Buffer Edge Cases:\n");
-    RUN_TEST(empty_buffer_operations);
-    RUN_TEST(empty_lines);
+    qalam_buffer_get_cursor(buffer, &cursor);
+    TEST_ASSERT_EQ(0, cursor.line);
+    TEST_ASSERT_EQ(12, cursor.column);
     
-    printf("\nUnicode/UTF-16 Handling:\n");
-    RUN_TEST(arabic_text);
-    RUN_TEST(mixed_arabic_english);
-    RUN_TEST(surrogate_pairs);
-    RUN_TEST(delete_surrogate_pair);
+    /* Backspace across the newline joins the lines */
+    qalam_buffer_set_cursor(buffer, 1, 0);
+    qalam_buffer_delete(buffer, -1);
+    qalam_buffer_get_content(buffer, content, sizeof(content), &written);
+    TEST_ASSERT_STR_EQ("Hello, QalamWorld!!", content);
+    TEST_ASSERT_EQ(1, qalam_buffer_get_line_count(buffer));
     
-    printf("\nLarge Content Handling:\n");
-    RUN_TEST(large_content_1mb);
-    RUN_TEST(large_content_10mb);
+    /* Delete a range spanning original and added pieces */
+    qalam_buffer_delete_range(buffer, 3, 15);
+    qalam_buffer_get_content(buffer, content, sizeof(content), &written);
+    TEST_ASSERT_STR_EQ("Helld!!", content);
     
-    printf("\nReplace Operations:\n");
-    RUN_TEST(replace);
+    qalam_buffer_replace(buffer, 0, 7, "مرحبا", strlen("مرحبا"));
+    qalam_buffer_get_content(buffer, content, sizeof(content), &written);
+    TEST_ASSERT_STR_EQ("مرحبا", content);
+    TEST_ASSERT_EQ(10, qalam_buffer_get_size(buffer));
     
-    printf("\nSelection Operations:\n");
-    RUN_TEST(selection);
+    qalam_buffer_destroy(buffer);
+    return 0;
+}
+
+static int test_piece_table_matches_gap(void) {
+    QalamBuffer* gap = NULL;
+    QalamBuffer* pieces = NULL;
+    TEST_ASSERT(qalam_buffer_create_from_text(&gap, "بسم الله\n", 0) == QALAM_OK);
+    TEST_ASSERT(create_piece_table_buffer(&pieces, "بسم الله\n") == QALAM_OK);
+    TEST_ASSERT(qalam_buffer_get_backend(gap) == QALAM_BUFFER_BACKEND_GAP);
+    
+    static const char* snippets[] = { "a", "مرحبا", "\n", "line\nline\n", "😀", "x y z" };
+    unsigned seed = 12345;
+    
+    for (int i = 0; i < 3000; i++) {
+        seed = seed * 1103515245u + 12345u;
+        unsigned op = (seed >> 16) % 5;
+        QalamBufferStats stats;
+        qalam_buffer_get_stats(gap, &stats);
+        size_t offset = (seed >> 8) % (stats.total_chars + 1);
+        
+        if (op <= 1) {
+            const char* text = snippets[(seed >> 4) % 6];
+            qalam_buffer_insert_at(gap, offset, text, strlen(text));
+            qalam_buffer_insert_at(pieces, offset, text, strlen(text));
+        } else if (op == 2) {
+            qalam_buffer_insert(gap, "k", 1);
+            qalam_buffer_insert(pieces, "k", 1);
+        } else if (op == 3) {
+            int count = (int)((seed >> 3) % 7) - 3;
+            qalam_buffer_delete(gap, count);
+            qalam_buffer_delete(pieces, count);
+        } else {
+            size_t end = offset + (seed >> 5) % 12;
+            qalam_buffer_delete_range(gap, offset, end);
+            qalam_buffer_delete_range(pieces, offset, end);
+        }
+        
+        QalamCursor a, b;
+        qalam_buffer_get_cursor(gap, &a);
+        qalam_buffer_get_cursor(pieces, &b);
+        TEST_ASSERT_EQ(a.offset, b.offset);
+        TEST_ASSERT_EQ(a.line, b.line);
+        TEST_ASSERT_EQ(a.column, b.column);
+    }
     
-    printf("\nBuffer Statistics:\n");
-    RUN_TEST(buffer_stats);
+    size_t size = qalam_buffer_get_size(gap);
+    TEST_ASSERT_EQ(size, qalam_buffer_get_size(pieces));
     
-    printf("\nLine Information:\n");
-    RUN_TEST(line_info);
+    char* expected = (char*)malloc(size + 1);
+    char* actual = (char*)malloc(size + 1);
+    TEST_ASSERT(expected != NULL && actual != NULL);
     
-    printf("\nError Handling:\n");
-    RUN_TEST(error_handling);
+    size_t written;
+    qalam_buffer_get_content(gap, expected, size + 1, &written);
+    qalam_buffer_get_content(pieces, actual, size + 1, &written);
+    TEST_ASSERT_STR_EQ(expected, actual);
+    TEST_ASSERT_EQ(qalam_buffer_get_line_count(gap), qalam_buffer_get_line_count(pieces));
+    TEST_ASSERT(verify_lines_match_content(pieces) == 0);
+    
+    free(expected);
+    free(actual);
+    qalam_buffer_destroy(gap);
+    qalam_buffer_destroy(pieces);
+    return 0;
+}
+
+static int test_piece_table_line_view(void) {
+    QalamBuffer* buffer = NULL;
+    TEST_ASSERT(create_piece_table_buffer(&buffer, "first\nبسم الله\nlast") == QALAM_OK);
+    
+    /* Two separate insertions split line 1 into five pieces */
+    qalam_buffer_insert_at(buffer, 7, "x", 1);
+    qalam_buffer_insert_at(buffer, 11, "y", 1);
+    
+    QalamTextView view;
+    TEST_ASSERT(qalam_buffer_get_line_view(buffer, 1, false, &view) == QALAM_OK);
+    TEST_ASSERT(view.segment_count >= 1 && view.segment_count <= QALAM_TEXT_VIEW_MAX_SEGMENTS);
+    TEST_ASSERT(view_equals(&view, "بxسم yالله"));
+    
+    TEST_ASSERT(qalam_buffer_get_line_view(buffer, 1, true, &view) == QALAM_OK);
+    TEST_ASSERT_EQ(1, view.segment_count);
+    TEST_ASSERT(view_equals(&view, "بxسم yالله"));
+    
+    /* Untouched lines point straight at the original text */
+    TEST_ASSERT(qalam_buffer_get_line_view(buffer, 2, true, &view) == QALAM_OK);
+    TEST_ASSERT(view_equals(&view, "last"));
+    
+    qalam_buffer_destroy(buffer);
+    return 0;
+}
+
+static int test_piece_table_file(void) {
+    const wchar_t* path = L"qalam_test_piece_table.txt";
+    
+    /* 3 MB of Arabic lines, so multi-byte characters straddle read chunks */
+    const char* line = "هذا سطر عربي للاختبار 0123456789\n";
+    size_t line_len = strlen(line);
+    size_t line_count = 3 * 1024 * 1024 / line_len;
+    char* text = (char*)malloc(line_count * line_len + 1);
+    TEST_ASSERT(text != NULL);
+    for (size_t i = 0; i < line_count; i++) {
+        memcpy(text + i * line_len, line, line_len);
+    }
+    text[line_count * line_len] = '\0';
+    
+    QalamBuffer* source = NULL;
+    TEST_ASSERT(qalam_buffer_create_from_text(&source, text, line_count * line_len) == QALAM_OK);
+    TEST_ASSERT(qalam_buffer_save(source, path) == QALAM_OK);
+    qalam_buffer_destroy(source);
+    
+    /* AUTO picks the piece table once the file reaches the threshold */
+    QalamBufferOptions options;
+    qalam_buffer_get_default_options(&options);
+    options.large_content_threshold = 1024 * 1024;
+    
+    QalamBuffer* buffer = NULL;
+    TEST_ASSERT(qalam_buffer_create_from_file_with_options(&buffer, path, &options) == QALAM_OK);
+    TEST_ASSERT(qalam_buffer_get_backend(buffer) == QALAM_BUFFER_BACKEND_PIECE_TABLE);
+    TEST_ASSERT(!qalam_buffer_is_modified(buffer));
+    TEST_ASSERT_EQ(line_count + 1, qalam_buffer_get_line_count(buffer));
+    TEST_ASSERT_EQ(line_count * line_len, qalam_buffer_get_size(buffer));
+    
+    char* content = (char*)malloc(line_count * line_len + 1);
+    TEST_ASSERT(content != NULL);
+    size_t written;
+    qalam_buffer_get_content(buffer, content, line_count * line_len + 1, &written);
+    TEST_ASSERT_EQ(line_count * line_len, written);
+    TEST_ASSERT(memcmp(text, content, written) == 0);
+    
+    /* Alternate edits between the two ends of the file */
+    LARGE_INTEGER start, end, freq;
+    QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter(&start);
+    for (int i = 0; i < 1000; i++) {
+        qalam_buffer_set_cursor(buffer, i % 2 ? line_count : 0, 0);
+        qalam_buffer_insert(buffer, "x", 1);
+    }
+    QueryPerformanceCounter(&end);
+    double edit_time = (double)(end.QuadPart - start.QuadPart) / freq.QuadPart;
+    printf("\n    1k far-apart edits (piece table): %.3f seconds (%.2f us/edit)",
+           edit_time, edit_time * 1e6 / 1000);
+    
+    char first[1024];
+    qalam_buffer_get_line(buffer, 0, first, sizeof(first), &written);
+    TEST_ASSERT_EQ(500 + strlen(line) - 1, written);
+    qalam_buffer_get_line(buffer, line_count, first, sizeof(first), &written);
+    TEST_ASSERT_EQ(500, written);
+    
+    /* Saving writes the edited text back out */
+    TEST_ASSERT(qalam_buffer_save(buffer, path) == QALAM_OK);
+    TEST_ASSERT(qalam_buffer_load(buffer, path) == QALAM_OK);
+    TEST_ASSERT_EQ(line_count * line_len + 1000, qalam_buffer_get_size(buffer));
+    
+    /* An explicit gap buffer reads the same file */
+    QalamBuffer* gap = NULL;
+    options.backend = QALAM_BUFFER_BACKEND_GAP;
+    TEST_ASSERT(qalam_buffer_create_from_file_with_options(&gap, path, &options) == QALAM_OK);
+    TEST_ASSERT(qalam_buffer_get_backend(gap) == QALAM_BUFFER_BACKEND_GAP);
+    TEST_ASSERT_EQ(qalam_buffer_get_size(buffer), qalam_buffer_get_size(gap));
+    TEST_ASSERT_EQ(qalam_buffer_get_line_count(buffer), qalam_buffer_get_line_count(gap));
+    
+    free(text);
+    free(content);
+    qalam_buffer_destroy(gap);
+    qalam_buffer_destroy(buffer);
+    DeleteFileW(path);
+    return 0;
+}
+
+static int test_mapped_file_load(void) {
+    const wchar_t* path = L"qalam_test_mapped.txt";
+    
+    /* ~6 MB of numbered Arabic lines: more chunks than the decode cache holds */
+    size_t capacity = 6 * 1024 * 1024 + 64;
+    char* text = (char*)malloc(capacity);
+    TEST_ASSERT(text != NULL);
+    size_t text_len = 0;
+    size_t line_count = 0;
+    while (text_len < 6 * 1024 * 1024) {
+        text_len += (size_t)snprintf(text + text_len, capacity - text_len,
+                                     "سطر رقم %zu للاختبار\n", line_count++);
+    }
+    
+    QalamBuffer* source = NULL;
+    TEST_ASSERT(qalam_buffer_create_from_text(&source, text, text_len) == QALAM_OK);
+    TEST_ASSERT(qalam_buffer_save(source, path) == QALAM_OK);
+    qalam_buffer_destroy(source);
+    
+    QalamBufferOptions options;
+    qalam_buffer_get_default_options(&options);
+    options.map_file = true;
+    
+    QalamBuffer* buffer = NULL;
+    TEST_ASSERT(qalam_buffer_create_from_file_with_options(&buffer, path, &options) == QALAM_OK);
+    TEST_ASSERT(qalam_buffer_get_backend(buffer) == QALAM_BUFFER_BACKEND_PIECE_TABLE);
+    
+    /* The first lines are readable before indexing finishes */
+    char line[256];
+    size_t written;
+    TEST_ASSERT(qalam_buffer_get_line_count(buffer) > 1);
+    TEST_ASSERT(qalam_buffer_get_line(buffer, 0, line, sizeof(line), &written) == QALAM_OK);
+    TEST_ASSERT_STR_EQ("سطر رقم 0 للاختبار", line);
+    
+    /* Editing is allowed while the rest streams in */
+    TEST_ASSERT(qalam_buffer_insert(buffer, "بداية\n", strlen("بداية\n")) == QALAM_OK);
+    
+    TEST_ASSERT(qalam_buffer_wait_load(buffer) == QALAM_OK);
+    bool complete = false;
+    TEST_ASSERT(qalam_buffer_poll_load(buffer, &complete) == QALAM_OK);
+    TEST_ASSERT(complete);
+    
+    size_t loaded, total;
+    qalam_buffer_get_load_progress(buffer, &loaded, &total);
+    TEST_ASSERT_EQ(text_len, total);
+    TEST_ASSERT_EQ(text_len, loaded);
+    TEST_ASSERT_EQ(line_count + 2, qalam_buffer_get_line_count(buffer));
+    TEST_ASSERT_EQ(text_len + strlen("بداية\n"), qalam_buffer_get_size(buffer));
+    
+    qalam_buffer_get_line(buffer, line_count, line, sizeof(line), &written);
+    snprintf(text + text_len + 1, capacity - text_len - 1, "سطر رقم %zu للاختبار", line_count - 1);
+    TEST_ASSERT_STR_EQ(text + text_len + 1, line);
+    TEST_ASSERT(verify_lines_match_content(buffer) == 0);
+    
+    /* Saving over the mapped file detaches the buffer from the mapping */
+    TEST_ASSERT(qalam_buffer_save(buffer, path) == QALAM_OK);
+    TEST_ASSERT(qalam_buffer_delete(buffer, 1) == QALAM_OK);
+    
+    QalamBuffer* reread = NULL;
+    TEST_ASSERT(qalam_buffer_create_from_file(&reread, path) == QALAM_OK);
+    TEST_ASSERT_EQ(text_len + strlen("بداية\n"), qalam_buffer_get_size(reread));
+    TEST_ASSERT(qalam_buffer_get_line(reread, 1, line, sizeof(line), &written) == QALAM_OK);
+    TEST_ASSERT_STR_EQ("سطر رقم 0 للاختبار", line);
+    
+    free(text);
+    qalam_buffer_destroy(reread);
+    qalam_buffer_destroy(buffer);
+    DeleteFileW(path);
+    return 0;
+}
+
+static void count_load_ready(void* user_data) {
+    InterlockedIncrement((volatile LONG*)user_data);
+}
+
+static int test_background_file_load(void) {
+    const wchar_t* path = L"qalam_test_background.txt";
+    
+    /* ~3 MB of Arabic lines of varying length, so chunk boundaries split
+     * both lines and multi-byte characters */
+    size_t capacity = 3 * 1024 * 1024 + 256;
+    char* text = (char*)malloc(capacity);
+    TEST_ASSERT(text != NULL);
+    size_t text_len = 0;
+    size_t line_count = 0;
+    while (text_len < 3 * 1024 * 1024) {
+        text_len += (size_t)snprintf(text + text_len, capacity - text_len, "سطر %zu %.*s\n",
+                                     line_count, (int)(line_count % 7) * 4, "مرحبابالعالمكلههنا");
+        line_count++;
+    }
+    
+    QalamBuffer* source = NULL;
+    TEST_ASSERT(qalam_buffer_create_from_text(&source, text, text_len) == QALAM_OK);
+    TEST_ASSERT(qalam_buffer_save(source, path) == QALAM_OK);
+    qalam_buffer_destroy(source);
+    
+    volatile LONG ready_calls = 0;
+    QalamBufferOptions options;
+    qalam_buffer_get_default_options(&options);
+    options.background_load = true;
+    options.load_ready = count_load_ready;
+    options.load_user_data = (void*)&ready_calls;
+    
+    QalamBuffer* buffer = NULL;
+    TEST_ASSERT(qalam_buffer_create_from_file_with_options(&buffer, path, &options) == QALAM_OK);
+    TEST_ASSERT(qalam_buffer_get_backend(buffer) == QALAM_BUFFER_BACKEND_PIECE_TABLE);
+    
+    /* The top of the file is there at once */
+    char line[256];
+    size_t written;
+    TEST_ASSERT(qalam_buffer_get_line(buffer, 0, line, sizeof(line), &written) == QALAM_OK);
+    TEST_ASSERT_STR_EQ("سطر 0 ", line);
+    
+    bool complete = true;
+    TEST_ASSERT(qalam_buffer_poll_load(buffer, &complete) == QALAM_OK);
+    if (!complete) {
+        TEST_ASSERT(qalam_buffer_insert(buffer, "x", 1) == QALAM_ERROR_BUFFER_READONLY);
+    }
+    
+    TEST_ASSERT(qalam_buffer_wait_load(buffer) == QALAM_OK);
+    TEST_ASSERT(qalam_buffer_poll_load(buffer, &complete) == QALAM_OK);
+    TEST_ASSERT(complete);
+    TEST_ASSERT(ready_calls > 0);
+    
+    size_t loaded, total;
+    qalam_buffer_get_load_progress(buffer, &loaded, &total);
+    TEST_ASSERT_EQ(text_len, total);
+    TEST_ASSERT_EQ(text_len, loaded);
+    TEST_ASSERT_EQ(line_count + 1, qalam_buffer_get_line_count(buffer));
+    TEST_ASSERT_EQ(text_len, qalam_buffer_get_size(buffer));
+    
+    char* content = (char*)malloc(text_len + 1);
+    TEST_ASSERT(content != NULL);
+    TEST_ASSERT(qalam_buffer_get_content(buffer, content, text_len + 1, &written) == QALAM_OK);
+    TEST_ASSERT_EQ(text_len, written);
+    TEST_ASSERT(memcmp(text, content, text_len) == 0);
+    TEST_ASSERT(verify_lines_match_content(buffer) == 0);
+    
+    /* Editable once everything is in */
+    TEST_ASSERT(qalam_buffer_insert(buffer, "بداية\n", strlen("بداية\n")) == QALAM_OK);
+    TEST_ASSERT_EQ(line_count + 2, qalam_buffer_get_line_count(buffer));
+    
+    free(content);
+    free(text);
+    qalam_buffer_destroy(buffer);
+    DeleteFileW(path);
+    return 0;
+}
+
+/*=============================================================================
+ * File Save Tests
+ *============================================================================*/
+
+typedef struct SaveProgress {
+    size_t calls;
+    size_t last_written;
+    size_t total;
+    bool monotonic;
+} SaveProgress;
+
+static void record_save_progress(const QalamBuffer* buffer, size_t bytes_written,
+                                 size_t bytes_total, void* user_data) {
+    SaveProgress* progress = (SaveProgress*)user_data;
+    (void)buffer;
+    if (bytes_written < progress->last_written) {
+        progress->monotonic = false;
+    }
+    progress->calls++;
+    progress->last_written = bytes_written;
+    progress->total = bytes_total;
+}
+
+static int test_save_streaming(void) {
+    const wchar_t* path = L"qalam_test_save.txt";
+    
+    /* ~5 MB spanning several staging chunks, with 4-byte characters */
+    const char* line = "مرحبا 😀 world 𝒜 سلام\n";
+    size_t line_len = strlen(line);
+    size_t line_count = 5 * 1024 * 1024 / line_len;
+    char* text = (char*)malloc(line_count * line_len + 1);
+    TEST_ASSERT(text != NULL);
+    for (size_t i = 0; i < line_count; i++) {
+        memcpy(text + i * line_len, line, line_len);
+    }
+    size_t text_len = line_count * line_len;
+    text[text_len] = '\0';
+    
+    QalamBufferOptions options;
+    qalam_buffer_get_default_options(&options);
+    options.backend = QALAM_BUFFER_BACKEND_PIECE_TABLE;
+    
+    QalamBuffer* buffer = NULL;
+    TEST_ASSERT(qalam_buffer_create_with_options(&buffer, &options) == QALAM_OK);
+    TEST_ASSERT(qalam_buffer_insert(buffer, text, text_len) == QALAM_OK);
+    
+    /* Scattered edits split the content into many segments */
+    for (size_t i = 0; i < 100; i++) {
+        qalam_buffer_set_cursor(buffer, i * (line_count / 100), 10);
+        qalam_buffer_insert(buffer, "😀", strlen("😀"));
+    }
+    size_t expected = qalam_buffer_get_size(buffer);
+    TEST_ASSERT_EQ(text_len + 100 * strlen("😀"), expected);
+    
+    SaveProgress progress = { 0, 0, 0, true };
+    TEST_ASSERT(qalam_buffer_save_with_progress(buffer, path, record_save_progress,
+                                                &progress) == QALAM_OK);
+    TEST_ASSERT(!qalam_buffer_is_modified(buffer));
+    TEST_ASSERT(progress.calls > 1);
+    TEST_ASSERT(progress.monotonic);
+    TEST_ASSERT_EQ(expected, progress.total);
+    TEST_ASSERT_EQ(expected, progress.last_written);
+    
+    /* The temporary file is gone once it has replaced the target */
+    HANDLE temp = CreateFileW(L"qalam_test_save.txt.qalam-save", GENERIC_READ, 0, NULL,
+                              OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    TEST_ASSERT(temp == INVALID_HANDLE_VALUE);
+    
+    char* saved = (char*)malloc(expected + 1);
+    char* reread_text = (char*)malloc(expected + 1);
+    TEST_ASSERT(saved != NULL && reread_text != NULL);
+    size_t written;
+    qalam_buffer_get_content(buffer, saved, expected + 1, &written);
+    
+    QalamBuffer* reread = NULL;
+    TEST_ASSERT(qalam_buffer_create_from_file(&reread, path) == QALAM_OK);
+    qalam_buffer_get_content(reread, reread_text, expected + 1, &written);
+    TEST_ASSERT_EQ(expected, written);
+    TEST_ASSERT(memcmp(saved, reread_text, expected) == 0);
+    
+    /* Saving over an existing file, and saving empty content */
+    QalamBuffer* empty = NULL;
+    TEST_ASSERT(qalam_buffer_create(&empty) == QALAM_OK);
+    progress.calls = 0;
+    TEST_ASSERT(qalam_buffer_save_with_progress(empty, path, record_save_progress,
+                                                &progress) == QALAM_OK);
+    TEST_ASSERT_EQ(1, progress.calls);
+    TEST_ASSERT_EQ(0, progress.total);
+    TEST_ASSERT(qalam_buffer_load(reread, path) == QALAM_OK);
+    TEST_ASSERT_EQ(0, qalam_buffer_get_size(reread));
+    
+    free(text);
+    free(saved);
+    free(reread_text);
+    qalam_buffer_destroy(empty);
+    qalam_buffer_destroy(reread);
+    qalam_buffer_destroy(buffer);
+    DeleteFileW(path);
+    return 0;
+}
+
+/*=============================================================================
+ * Undo/Redo Tests
+ *============================================================================*/
+
+static int test_undo_typing(void) {
+    QalamBuffer* buffer = NULL;
+    TEST_ASSERT(qalam_buffer_create(&buffer) == QALAM_OK);
+    TEST_ASSERT(!qalam_buffer_can_undo(buffer));
+    
+    /* Typed characters form a single undo group */
+    const char* word = "سلام";
+    const char* p = word;
+    while (*p) {
+        size_t n = ((unsigned char)*p >= 0xC0) ? 2 : 1;
+        TEST_ASSERT(qalam_buffer_insert(buffer, p, n) == QALAM_OK);
+        p += n;
+    }
+    TEST_ASSERT(qalam_buffer_insert(buffer, " 😀", strlen(" 😀")) == QALAM_OK);
+    TEST_ASSERT(qalam_buffer_insert(buffer, "!", 1) == QALAM_OK);
+    
+    char out[64];
+    size_t written;
+    TEST_ASSERT(qalam_buffer_undo(buffer) == QALAM_OK);
+    qalam_buffer_get_content(buffer, out, sizeof(out), &written);
+    TEST_ASSERT_STR_EQ("سلام 😀", out);
+    TEST_ASSERT(qalam_buffer_undo(buffer) == QALAM_OK);
+    qalam_buffer_get_content(buffer, out, sizeof(out), &written);
+    TEST_ASSERT_STR_EQ("سلام", out);
+    TEST_ASSERT(qalam_buffer_undo(buffer) == QALAM_OK);
+    TEST_ASSERT_EQ(0, qalam_buffer_get_size(buffer));
+    TEST_ASSERT(!qalam_buffer_can_undo(buffer));
+    
+    TEST_ASSERT(qalam_buffer_redo(buffer) == QALAM_OK);
+    TEST_ASSERT(qalam_buffer_redo(buffer) == QALAM_OK);
+    TEST_ASSERT(qalam_buffer_redo(buffer) == QALAM_OK);
+    TEST_ASSERT(!qalam_buffer_can_redo(buffer));
+    qalam_buffer_get_content(buffer, out, sizeof(out), &written);
+    TEST_ASSERT_STR_EQ("سلام 😀!", out);
+    
+    /* Backspaces coalesce too, surrogate pairs included */
+    QalamCursor cursor;
+    qalam_buffer_get_cursor(buffer, &cursor);
+    TEST_ASSERT_EQ(8, cursor.column);
+    for (int i = 0; i < 4; i++) {
+        TEST_ASSERT(qalam_buffer_delete(buffer, -1) == QALAM_OK);
+    }
+    qalam_buffer_get_content(buffer, out, sizeof(out), &written);
+    TEST_ASSERT_STR_EQ("سلا", out);
+    
+    TEST_ASSERT(qalam_buffer_undo(buffer) == QALAM_OK);
+    qalam_buffer_get_content(buffer, out, sizeof(out), &written);
+    TEST_ASSERT_STR_EQ("سلام 😀!", out);
+    qalam_buffer_get_cursor(buffer, &cursor);
+    TEST_ASSERT_EQ(8, cursor.column);
+    
+    /* Forward deletes from the start coalesce separately */
+    qalam_buffer_cursor_to_start(buffer);
+    TEST_ASSERT(qalam_buffer_delete(buffer, 1) == QALAM_OK);
+    TEST_ASSERT(qalam_buffer_delete(buffer, 1) == QALAM_OK);
+    TEST_ASSERT(qalam_buffer_undo(buffer) == QALAM_OK);
+    qalam_buffer_get_content(buffer, out, sizeof(out), &written);
+    TEST_ASSERT_STR_EQ("سلام 😀!", out);
+    qalam_buffer_get_cursor(buffer, &cursor);
+    TEST_ASSERT_EQ(0, cursor.offset);
+    
+    qalam_buffer_destroy(buffer);
+    return 0;
+}
+
+static int test_undo_groups(void) {
+    QalamBufferBackend backends[] = { QALAM_BUFFER_BACKEND_GAP, QALAM_BUFFER_BACKEND_PIECE_TABLE };
+    
+    for (size_t b = 0; b < 2; b++) {
+        QalamBufferOptions options;
+        qalam_buffer_get_default_options(&options);
+        options.backend = backends[b];
+        
+        QalamBuffer* buffer = NULL;
+        const char* text = "first line\nsecond line\nthird line";
+        TEST_ASSERT(qalam_buffer_create_from_text_with_options(&buffer, text, strlen(text),
+                                                               &options) == QALAM_OK);
+        TEST_ASSERT(!qalam_buffer_can_undo(buffer));
+        
+        /* A replace is one group, and restores the selection it replaced */
+        TEST_ASSERT(qalam_buffer_set_selection(buffer, 1, 0, 1, 6) == QALAM_OK);
+        TEST_ASSERT(qalam_buffer_replace(buffer, 11, 17, "2nd", 3) == QALAM_OK);
+        qalam_buffer_clear_selection(buffer);
+        
+        char out[128];
+        size_t written;
+        qalam_buffer_get_line(buffer, 1, out, sizeof(out), &written);
+        TEST_ASSERT_STR_EQ("2nd line", out);
+        
+        TEST_ASSERT(qalam_buffer_undo(buffer) == QALAM_OK);
+        qalam_buffer_get_content(buffer, out, sizeof(out), &written);
+        TEST_ASSERT_STR_EQ(text, out);
+        QalamSelection selection;
+        qalam_buffer_get_selection(buffer, &selection);
+        TEST_ASSERT(selection.is_active);
+        TEST_ASSERT_EQ(1, selection.start.line);
+        TEST_ASSERT_EQ(6, selection.end.column);
+        TEST_ASSERT_EQ(3, qalam_buffer_get_line_count(buffer));
+        
+        /* Explicit groups collect several edits, nested or not */
+        TEST_ASSERT(qalam_buffer_begin_undo_group(buffer) == QALAM_OK);
+        TEST_ASSERT(qalam_buffer_insert_at(buffer, 0, "> ", 2) == QALAM_OK);
+        TEST_ASSERT(qalam_buffer_begin_undo_group(buffer) == QALAM_OK);
+        TEST_ASSERT(qalam_buffer_insert_at(buffer, 13, "> ", 2) == QALAM_OK);
+        TEST_ASSERT(qalam_buffer_delete_range(buffer, 27, 33) == QALAM_OK);
+        TEST_ASSERT(qalam_buffer_undo(buffer) == QALAM_ERROR_INVALID_ARGUMENT);
+        TEST_ASSERT(qalam_buffer_end_undo_group(buffer) == QALAM_OK);
+        TEST_ASSERT(qalam_buffer_end_undo_group(buffer) == QALAM_OK);
+        TEST_ASSERT(qalam_buffer_end_undo_group(buffer) == QALAM_ERROR_INVALID_ARGUMENT);
+        
+        qalam_buffer_get_content(buffer, out, sizeof(out), &written);
+        TEST_ASSERT_STR_EQ("> first line\n> second line\nline", out);
+        TEST_ASSERT(qalam_buffer_undo(buffer) == QALAM_OK);
+        qalam_buffer_get_content(buffer, out, sizeof(out), &written);
+        TEST_ASSERT_STR_EQ(text, out);
+        TEST_ASSERT(qalam_buffer_redo(buffer) == QALAM_OK);
+        qalam_buffer_get_content(buffer, out, sizeof(out), &written);
+        TEST_ASSERT_STR_EQ("> first line\n> second line\nline", out);
+        
+        /* An empty group leaves redo alone; a new edit discards it */
+        TEST_ASSERT(qalam_buffer_undo(buffer) == QALAM_OK);
+        TEST_ASSERT(qalam_buffer_begin_undo_group(buffer) == QALAM_OK);
+        TEST_ASSERT(qalam_buffer_end_undo_group(buffer) == QALAM_OK);
+        TEST_ASSERT(qalam_buffer_can_redo(buffer));
+        TEST_ASSERT(qalam_buffer_insert_at(buffer, 0, "x", 1) == QALAM_OK);
+        TEST_ASSERT(!qalam_buffer_can_redo(buffer));
+        TEST_ASSERT(qalam_buffer_undo(buffer) == QALAM_OK);
+        TEST_ASSERT(qalam_buffer_undo(buffer) == QALAM_OK);
+        TEST_ASSERT(!qalam_buffer_can_undo(buffer));
+        TEST_ASSERT(verify_lines_match_content(buffer) == 0);
+        
+        qalam_buffer_clear_undo(buffer);
+        TEST_ASSERT(!qalam_buffer_can_redo(buffer));
+        qalam_buffer_destroy(buffer);
+    }
+    
+    return 0;
+}
+
+static int test_undo_large(void) {
+    QalamBufferBackend backends[] = { QALAM_BUFFER_BACKEND_GAP, QALAM_BUFFER_BACKEND_PIECE_TABLE };
+    const char* names[] = { "gap", "piece table" };
+    LARGE_INTEGER start, end, freq;
+    QueryPerformanceFrequency(&freq);
+    
+    for (size_t b = 0; b < 2; b++) {
+        QalamBufferOptions options;
+        qalam_buffer_get_default_options(&options);
+        options.backend = backends[b];
+        
+        QalamBuffer* buffer = NULL;
+        TEST_ASSERT(qalam_buffer_create_with_options(&buffer, &options) == QALAM_OK);
+        
+        /* 100k keystrokes, then backspace over half of them */
+        for (int i = 0; i < 100000; i++) {
+            char ch = (i % 64 == 63) ? '\n' : (char)('a' + i % 26);
+            qalam_buffer_insert(buffer, &ch, 1);
+        }
+        for (int i = 0; i < 50000; i++) {
+            qalam_buffer_delete(buffer, -1);
+        }
+        TEST_ASSERT_EQ(50000, qalam_buffer_get_size(buffer));
+        
+        QueryPerformanceCounter(&start);
+        TEST_ASSERT(qalam_buffer_undo(buffer) == QALAM_OK);
+        TEST_ASSERT_EQ(100000, qalam_buffer_get_size(buffer));
+        TEST_ASSERT(qalam_buffer_undo(buffer) == QALAM_OK);
+        QueryPerformanceCounter(&end);
+        TEST_ASSERT_EQ(0, qalam_buffer_get_size(buffer));
+        TEST_ASSERT_EQ(1, qalam_buffer_get_line_count(buffer));
+        TEST_ASSERT(!qalam_buffer_can_undo(buffer));
+        printf("\n    Undo 100k keystrokes (%s): %.3f ms", names[b],
+               (double)(end.QuadPart - start.QuadPart) * 1000.0 / freq.QuadPart);
+        
+        TEST_ASSERT(qalam_buffer_redo(buffer) == QALAM_OK);
+        TEST_ASSERT(qalam_buffer_redo(buffer) == QALAM_OK);
+        TEST_ASSERT_EQ(50000, qalam_buffer_get_size(buffer));
+        TEST_ASSERT(verify_lines_match_content(buffer) == 0);
+        qalam_buffer_destroy(buffer);
+    }
+    
+    /* A 16 MB paste deleted and restored through the piece table */
+    size_t paste_len = 16 * 1024 * 1024;
+    char* paste = (char*)malloc(paste_len);
+    TEST_ASSERT(paste != NULL);
+    for (size_t i = 0; i < paste_len; i++) {
+        paste[i] = (i % 80 == 79) ? '\n' : (char)('a' + i % 26);
+    }
+    
+    QalamBufferOptions options;
+    qalam_buffer_get_default_options(&options);
+    options.backend = QALAM_BUFFER_BACKEND_PIECE_TABLE;
+    QalamBuffer* buffer = NULL;
+    TEST_ASSERT(qalam_buffer_create_with_options(&buffer, &options) == QALAM_OK);
+    TEST_ASSERT(qalam_buffer_insert(buffer, paste, paste_len) == QALAM_OK);
+    size_t lines = qalam_buffer_get_line_count(buffer);
+    TEST_ASSERT(qalam_buffer_delete_range(buffer, 0, paste_len) == QALAM_OK);
+    
+    QueryPerformanceCounter(&start);
+    TEST_ASSERT(qalam_buffer_undo(buffer) == QALAM_OK);
+    QueryPerformanceCounter(&end);
+    TEST_ASSERT_EQ(paste_len, qalam_buffer_get_size(buffer));
+    TEST_ASSERT_EQ(lines, qalam_buffer_get_line_count(buffer));
+    printf("\n    Undo 16 MB delete (piece table): %.3f ms",
+           (double)(end.QuadPart - start.QuadPart) * 1000.0 / freq.QuadPart);
+    
+    TEST_ASSERT(qalam_buffer_undo(buffer) == QALAM_OK);
+    TEST_ASSERT_EQ(0, qalam_buffer_get_size(buffer));
+    TEST_ASSERT(qalam_buffer_redo(buffer) == QALAM_OK);
+    TEST_ASSERT_EQ(paste_len, qalam_buffer_get_size(buffer));
+    
+    free(paste);
+    qalam_buffer_destroy(buffer);
+    return 0;
+}
+
+/*=============================================================================
+ * Edit Transaction Tests
+ *============================================================================*/
+
+typedef struct ChangeLog {
+    int calls;
+    QalamBufferChange last;
+} ChangeLog;
+
+static void record_change(const QalamBuffer* buffer, const QalamBufferChange* change,
+                          void* user_data) {
+    (void)buffer;
+    ChangeLog* log = (ChangeLog*)user_data;
+    log->calls++;
+    log->last = *change;
+}
+
+static int test_change_callback(void) {
+    QalamBuffer* buffer = NULL;
+    const char* text = "one\ntwo\nthree";
+    TEST_ASSERT(qalam_buffer_create_from_text(&buffer, text, strlen(text)) == QALAM_OK);
+    
+    ChangeLog log = { 0 };
+    TEST_ASSERT(qalam_buffer_set_change_callback(buffer, record_change, &log) == QALAM_OK);
+    
+    /* Splitting a line turns one line into two */
+    TEST_ASSERT(qalam_buffer_insert_at(buffer, 5, "\n", 1) == QALAM_OK);
+    TEST_ASSERT_EQ(1, log.calls);
+    TEST_ASSERT_EQ(1, log.last.first_line);
+    TEST_ASSERT_EQ(1, log.last.old_line_count);
+    TEST_ASSERT_EQ(2, log.last.new_line_count);
+    
+    /* Joining lines 0-2 leaves one */
+    TEST_ASSERT(qalam_buffer_delete_range(buffer, 2, 7) == QALAM_OK);
+    TEST_ASSERT_EQ(2, log.calls);
+    TEST_ASSERT_EQ(0, log.last.first_line);
+    TEST_ASSERT_EQ(3, log.last.old_line_count);
+    TEST_ASSERT_EQ(1, log.last.new_line_count);
+    
+    /* A replace is reported once, covering both halves */
+    TEST_ASSERT(qalam_buffer_replace(buffer, 0, 3, "x\ny", 3) == QALAM_OK);
+    TEST_ASSERT_EQ(3, log.calls);
+    TEST_ASSERT_EQ(0, log.last.first_line);
+    TEST_ASSERT_EQ(1, log.last.old_line_count);
+    TEST_ASSERT_EQ(2, log.last.new_line_count);
+    
+    TEST_ASSERT(qalam_buffer_undo(buffer) == QALAM_OK);
+    TEST_ASSERT_EQ(4, log.calls);
+    TEST_ASSERT_EQ(2, log.last.old_line_count);
+    TEST_ASSERT_EQ(1, log.last.new_line_count);
+    
+    TEST_ASSERT(qalam_buffer_set_change_callback(buffer, NULL, NULL) == QALAM_OK);
+    TEST_ASSERT(qalam_buffer_insert(buffer, "z", 1) == QALAM_OK);
+    TEST_ASSERT_EQ(4, log.calls);
+    
+    qalam_buffer_destroy(buffer);
+    return 0;
+}
+
+static int test_edit_transaction(void) {
+    QalamBufferBackend backends[] = { QALAM_BUFFER_BACKEND_GAP, QALAM_BUFFER_BACKEND_PIECE_TABLE };
+    
+    for (size_t b = 0; b < 2; b++) {
+        QalamBufferOptions options;
+        qalam_buffer_get_default_options(&options);
+        options.backend = backends[b];
+        
+        QalamBuffer* buffer = NULL;
+        const char* text = "let a = 1;\nlet b = a;\nlet c = a + b;";
+        TEST_ASSERT(qalam_buffer_create_from_text_with_options(&buffer, text, strlen(text),
+                                                               &options) == QALAM_OK);
+        ChangeLog log = { 0 };
+        qalam_buffer_set_change_callback(buffer, record_change, &log);
+        
+        /* Queueing needs an open transaction, in document order */
+        TEST_ASSERT(qalam_buffer_edit_replace(buffer, 0, 3, "var", 3) == QALAM_ERROR_INVALID_ARGUMENT);
+        TEST_ASSERT(qalam_buffer_begin_edit(buffer) == QALAM_OK);
+        TEST_ASSERT(qalam_buffer_begin_edit(buffer) == QALAM_ERROR_INVALID_ARGUMENT);
+        TEST_ASSERT(qalam_buffer_edit_replace(buffer, 0, 3, "const", 5) == QALAM_OK);
+        TEST_ASSERT(qalam_buffer_edit_replace(buffer, 2, 4, "x", 1) == QALAM_ERROR_INVALID_RANGE);
+        
+        /* Rename 'a' to 'alpha', split one line, and put the cursor in an edit */
+        TEST_ASSERT(qalam_buffer_edit_replace(buffer, 4, 5, "alpha", 5) == QALAM_OK);
+        TEST_ASSERT(qalam_buffer_edit_replace(buffer, 19, 20, "alpha", 5) == QALAM_OK);
+        TEST_ASSERT(qalam_buffer_edit_replace(buffer, 21, 21, "\n", 1) == QALAM_OK);
+        TEST_ASSERT(qalam_buffer_edit_replace(buffer, 30, 31, "alpha", 5) == QALAM_OK);
+        qalam_buffer_set_cursor_offset(buffer, 30);
+        TEST_ASSERT(qalam_buffer_commit_edit(buffer) == QALAM_OK);
+        TEST_ASSERT(qalam_buffer_commit_edit(buffer) == QALAM_ERROR_INVALID_ARGUMENT);
+        
+        char out[128];
+        size_t written;
+        qalam_buffer_get_content(buffer, out, sizeof(out), &written);
+        TEST_ASSERT_STR_EQ("const alpha = 1;\nlet b = alpha;\n\nlet c = alpha + b;", out);
+        TEST_ASSERT_EQ(4, qalam_buffer_get_line_count(buffer));
+        TEST_ASSERT(verify_lines_match_content(buffer) == 0);
+        
+        QalamCursor cursor;
+        qalam_buffer_get_cursor(buffer, &cursor);
+        TEST_ASSERT_EQ(3, cursor.line);
+        TEST_ASSERT_EQ(13, cursor.column);
+        
+        TEST_ASSERT_EQ(1, log.calls);
+        TEST_ASSERT_EQ(0, log.last.first_line);
+        TEST_ASSERT_EQ(3, log.last.old_line_count);
+        TEST_ASSERT_EQ(4, log.last.new_line_count);
+        
+        /* One undo group */
+        TEST_ASSERT(qalam_buffer_undo(buffer) == QALAM_OK);
+        qalam_buffer_get_content(buffer, out, sizeof(out), &written);
+        TEST_ASSERT_STR_EQ(text, out);
+        TEST_ASSERT(!qalam_buffer_can_undo(buffer));
+        TEST_ASSERT(qalam_buffer_redo(buffer) == QALAM_OK);
+        qalam_buffer_get_content(buffer, out, sizeof(out), &written);
+        TEST_ASSERT_STR_EQ("const alpha = 1;\nlet b = alpha;\n\nlet c = alpha + b;", out);
+        
+        /* A range past the end applies nothing; cancel drops the queue */
+        TEST_ASSERT(qalam_buffer_begin_edit(buffer) == QALAM_OK);
+        TEST_ASSERT(qalam_buffer_edit_replace(buffer, 0, 5, "", 0) == QALAM_OK);
+        TEST_ASSERT(qalam_buffer_edit_replace(buffer, 40, 100, "", 0) == QALAM_OK);
+        TEST_ASSERT(qalam_buffer_commit_edit(buffer) == QALAM_ERROR_INVALID_RANGE);
+        TEST_ASSERT(qalam_buffer_begin_edit(buffer) == QALAM_OK);
+        TEST_ASSERT(qalam_buffer_edit_replace(buffer, 0, 5, "", 0) == QALAM_OK);
+        qalam_buffer_cancel_edit(buffer);
+        qalam_buffer_get_content(buffer, out, sizeof(out), &written);
+        TEST_ASSERT_STR_EQ("const alpha = 1;\nlet b = alpha;\n\nlet c = alpha + b;", out);
+        
+        qalam_buffer_destroy(buffer);
+    }
+    
+    return 0;
+}
+
+static int test_edit_transaction_large(void) {
+    /* 10k matches of "foo" between short lines */
+    const char* line = "call foo(x);\n";
+    size_t line_len = strlen(line);
+    size_t matches = 10000;
+    char* text = (char*)malloc(line_len * matches);
+    TEST_ASSERT(text != NULL);
+    for (size_t i = 0; i < matches; i++) {
+        memcpy(text + i * line_len, line, line_len);
+    }
+    
+    QalamBufferBackend backends[] = { QALAM_BUFFER_BACKEND_GAP, QALAM_BUFFER_BACKEND_PIECE_TABLE };
+    const char* names[] = { "gap", "piece table" };
+    LARGE_INTEGER start, end, freq;
+    QueryPerformanceFrequency(&freq);
+    
+    for (size_t b = 0; b < 2; b++) {
+        QalamBufferOptions options;
+        qalam_buffer_get_default_options(&options);
+        options.backend = backends[b];
+        
+        QalamBuffer* buffer = NULL;
+        TEST_ASSERT(qalam_buffer_create_from_text_with_options(&buffer, text, line_len * matches,
+                                                               &options) == QALAM_OK);
+        
+        QueryPerformanceCounter(&start);
+        TEST_ASSERT(qalam_buffer_begin_edit(buffer) == QALAM_OK);
+        for (size_t i = 0; i < matches; i++) {
+            size_t at = i * line_len + 5;
+            TEST_ASSERT(qalam_buffer_edit_replace(buffer, at, at + 3, "bar_baz", 7) == QALAM_OK);
+        }
+        TEST_ASSERT(qalam_buffer_commit_edit(buffer) == QALAM_OK);
+        QueryPerformanceCounter(&end);
+        printf("\n    Replace 10k matches (%s): %.3f ms", names[b],
+               (double)(end.QuadPart - start.QuadPart) * 1000.0 / freq.QuadPart);
+        
+        TEST_ASSERT_EQ((line_len + 4) * matches, qalam_buffer_get_size(buffer));
+        TEST_ASSERT_EQ(matches + 1, qalam_buffer_get_line_count(buffer));
+        
+        char out[64];
+        size_t written;
+        qalam_buffer_get_line(buffer, matches - 1, out, sizeof(out), &written);
+        TEST_ASSERT_STR_EQ("call bar_baz(x);", out);
+        
+        TEST_ASSERT(qalam_buffer_undo(buffer) == QALAM_OK);
+        TEST_ASSERT_EQ(line_len * matches, qalam_buffer_get_size(buffer));
+        qalam_buffer_get_line(buffer, 5000, out, sizeof(out), &written);
+        TEST_ASSERT_STR_EQ("call foo(x);", out);
+        
+        qalam_buffer_destroy(buffer);
+    }
+    
+    free(text);
+    return 0;
+}
+
+/*=============================================================================
+ * Search Tests
+ *============================================================================*/
+
+static int test_search_basic(void) {
+    QalamBufferBackend backends[] = { QALAM_BUFFER_BACKEND_GAP, QALAM_BUFFER_BACKEND_PIECE_TABLE };
+    
+    for (size_t b = 0; b < 2; b++) {
+        QalamBufferOptions options;
+        qalam_buffer_get_default_options(&options);
+        options.backend = backends[b];
+        
+        const char* text = "Hello world, hello WORLD";
+        QalamBuffer* buffer = NULL;
+        TEST_ASSERT(qalam_buffer_create_from_text_with_options(&buffer, text, strlen(text),
+                                                               &options) == QALAM_OK);
+        
+        /* Split the storage inside the first "world" */
+        TEST_ASSERT(qalam_buffer_insert_at(buffer, 8, "x", 1) == QALAM_OK);
+        TEST_ASSERT(qalam_buffer_delete_range(buffer, 8, 9) == QALAM_OK);
+        
+        QalamSearchMatch match;
+        bool found = false;
+        TEST_ASSERT(qalam_buffer_find(buffer, "world", 5, 0, NULL, &match, &found) == QALAM_OK);
+        TEST_ASSERT(found);
+        TEST_ASSERT_EQ(6, match.start_offset);
+        TEST_ASSERT_EQ(11, match.end_offset);
+        
+        TEST_ASSERT(qalam_buffer_find_next(buffer, &match, &found) == QALAM_OK);
+        TEST_ASSERT(!found);
+        
+        /* Short patterns take the candidate scan; case folding covers both */
+        QalamSearchOptions search;
+        qalam_buffer_get_default_search_options(&search);
+        search.ignore_case = true;
+        TEST_ASSERT(qalam_buffer_find(buffer, "wo", 2, 7, &search, &match, &found) == QALAM_OK);
+        TEST_ASSERT(found);
+        TEST_ASSERT_EQ(19, match.start_offset);
+        
+        size_t count = 0;
+        TEST_ASSERT(qalam_buffer_find_all(buffer, "HELLO", 5, &search, NULL, NULL, &count) == QALAM_OK);
+        TEST_ASSERT_EQ(2, count);
+        
+        /* find_all leaves find_next with the pattern of the last find */
+        TEST_ASSERT(qalam_buffer_find_next(buffer, &match, &found) == QALAM_OK);
+        TEST_ASSERT(!found);
+        
+        search.wrap = true;
+        TEST_ASSERT(qalam_buffer_find(buffer, "hello", 5, 20, &search, &match, &found) == QALAM_OK);
+        TEST_ASSERT(found);
+        TEST_ASSERT_EQ(0, match.start_offset);
+        TEST_ASSERT(qalam_buffer_find_next(buffer, &match, &found) == QALAM_OK);
+        TEST_ASSERT(found);
+        TEST_ASSERT_EQ(13, match.start_offset);
+        
+        TEST_ASSERT(qalam_buffer_find(buffer, "", 0, 0, NULL, &match, &found) ==
+                    QALAM_ERROR_INVALID_ARGUMENT);
+        TEST_ASSERT(qalam_buffer_find_next(buffer, &match, &found) == QALAM_ERROR_INVALID_ARGUMENT);
+        
+        qalam_buffer_destroy(buffer);
+    }
+    
+    return 0;
+}
+
+static int test_search_arabic(void) {
+    /* "قَرَأَ الكِتَابَ" followed by "كـتاب" with a tatweel */
+    const char* text = "\xD9\x82\xD9\x8E\xD8\xB1\xD9\x8E\xD8\xA3\xD9\x8E "
+                       "\xD8\xA7\xD9\x84\xD9\x83\xD9\x90\xD8\xAA\xD9\x8E\xD8\xA7\xD8\xA8\xD9\x8E "
+                       "\xD9\x83\xD9\x80\xD8\xAA\xD8\xA7\xD8\xA8";
+    const char* qara = "\xD9\x82\xD8\xB1\xD8\xA7";                  /* قرا */
+    const char* kitab = "\xD9\x83\xD8\xAA\xD8\xA7\xD8\xA8";         /* كتاب */
+    const char* kitab_marked = "\xD9\x83\xD9\x90\xD8\xAA\xD9\x8E\xD8\xA7\xD8\xA8"; /* كِتَاب */
+    
+    QalamBuffer* buffer = NULL;
+    TEST_ASSERT(qalam_buffer_create_from_text(&buffer, text, strlen(text)) == QALAM_OK);
+    
+    QalamSearchMatch match;
+    bool found = true;
+    TEST_ASSERT(qalam_buffer_find(buffer, qara, strlen(qara), 0, NULL, &match, &found) == QALAM_OK);
+    TEST_ASSERT(!found);
+    
+    QalamSearchOptions search;
+    qalam_buffer_get_default_search_options(&search);
+    search.arabic_folding = true;
+    
+    /* Hamza on the alef folds away; the match covers the last fatha */
+    TEST_ASSERT(qalam_buffer_find(buffer, qara, strlen(qara), 0, &search, &match, &found) == QALAM_OK);
+    TEST_ASSERT(found);
+    TEST_ASSERT_EQ(0, match.start_offset);
+    TEST_ASSERT_EQ(6, match.end_offset);
+    
+    TEST_ASSERT(qalam_buffer_find(buffer, kitab, strlen(kitab), 0, &search, &match, &found) == QALAM_OK);
+    TEST_ASSERT(found);
+    TEST_ASSERT_EQ(9, match.start_offset);
+    TEST_ASSERT_EQ(16, match.end_offset);
+    
+    TEST_ASSERT(qalam_buffer_find_next(buffer, &match, &found) == QALAM_OK);
+    TEST_ASSERT(found);
+    TEST_ASSERT_EQ(17, match.start_offset);
+    TEST_ASSERT_EQ(22, match.end_offset);
+    
+    /* Harakat in the pattern are skipped too, also across a split */
+    TEST_ASSERT(qalam_buffer_set_cursor_offset(buffer, 11) == QALAM_OK);
+    TEST_ASSERT(qalam_buffer_insert(buffer, "x", 1) == QALAM_OK);
+    TEST_ASSERT(qalam_buffer_delete(buffer, -1) == QALAM_OK);
+    size_t count = 0;
+    TEST_ASSERT(qalam_buffer_find_all(buffer, kitab_marked, strlen(kitab_marked), &search,
+                                      NULL, NULL, &count) == QALAM_OK);
+    TEST_ASSERT_EQ(2, count);
+    
+    qalam_buffer_destroy(buffer);
+    return 0;
+}
+
+typedef struct CancelAfter {
+    int polls;
+    int cancel_at;
+} CancelAfter;
+
+static bool cancel_after(void* user_data) {
+    CancelAfter* cancel = (CancelAfter*)user_data;
+    return ++cancel->polls >= cancel->cancel_at;
+}
+
+static int test_search_large(void) {
+    const char* line = "the quick brown fox jumps over the lazy dog\n";
+    size_t line_len = strlen(line);
+    size_t lines = (10 * 1024 * 1024) / line_len;
+    char* text = (char*)malloc(line_len * lines);
+    TEST_ASSERT(text != NULL);
+    for (size_t i = 0; i < lines; i++) {
+        memcpy(text + i * line_len, line, line_len);
+    }
+    
+    QalamBuffer* buffer = NULL;
+    TEST_ASSERT(qalam_buffer_create_from_text(&buffer, text, line_len * lines) == QALAM_OK);
+    TEST_ASSERT(qalam_buffer_set_cursor_offset(buffer, line_len * lines / 2) == QALAM_OK);
+    TEST_ASSERT(qalam_buffer_insert(buffer, "x", 1) == QALAM_OK);
+    
+    LARGE_INTEGER start, end, freq;
+    QueryPerformanceFrequency(&freq);
+    
+    size_t count = 0;
+    QueryPerformanceCounter(&start);
+    TEST_ASSERT(qalam_buffer_find_all(buffer, "lazy dog", 8, NULL, NULL, NULL, &count) == QALAM_OK);
+    QueryPerformanceCounter(&end);
+    TEST_ASSERT_EQ(lines, count);
+    printf("\n    Find all in 10MB (%zu matches): %.3f ms", count,
+           (double)(end.QuadPart - start.QuadPart) * 1000.0 / freq.QuadPart);
+    
+    QalamSearchOptions search;
+    qalam_buffer_get_default_search_options(&search);
+    search.arabic_folding = true;
+    QalamSearchMatch match;
+    bool found = true;
+    QueryPerformanceCounter(&start);
+    TEST_ASSERT(qalam_buffer_find(buffer, "\xD8\xA3\xD9\x86", 4, 0, &search, &match, &found) ==
+                QALAM_OK);
+    QueryPerformanceCounter(&end);
+    TEST_ASSERT(!found);
+    printf("\n    Folded search of 10MB, no match: %.3f ms",
+           (double)(end.QuadPart - start.QuadPart) * 1000.0 / freq.QuadPart);
+    
+    /* A pending cancel is seen before anything is scanned */
+    CancelAfter cancel = { 0, 1 };
+    search.cancel = cancel_after;
+    search.cancel_user_data = &cancel;
+    TEST_ASSERT(qalam_buffer_find_all(buffer, "dog", 3, &search, NULL, NULL, &count) ==
+                QALAM_ERROR_CANCELLED);
+    TEST_ASSERT_EQ(0, count);
+    
+    /* Matches found before a later cancel stand */
+    cancel.polls = 0;
+    cancel.cancel_at = 3;
+    TEST_ASSERT(qalam_buffer_find_all(buffer, "dog", 3, &search, NULL, NULL, &count) ==
+                QALAM_ERROR_CANCELLED);
+    TEST_ASSERT(count > 0 && count < lines);
+    
+    qalam_buffer_destroy(buffer);
+    free(text);
+    return 0;
+}
+
+/*=============================================================================
+ * Virtual Memory Gap Buffer Tests
+ *============================================================================*/
+
+static QalamResult create_virtual_buffer(QalamBuffer** buffer, const char* text) {
+    QalamBufferOptions options;
+    qalam_buffer_get_default_options(&options);
+    options.backend = QALAM_BUFFER_BACKEND_GAP;
+    options.virtual_memory = true;
+    return qalam_buffer_create_from_text_with_options(buffer, text, 0, &options);
+}
+
+static int test_virtual_matches_heap(void) {
+    QalamBuffer* heap = NULL;
+    QalamBuffer* vm = NULL;
+    TEST_ASSERT(qalam_buffer_create_from_text(&heap, "بسم الله\n", 0) == QALAM_OK);
+    TEST_ASSERT(create_virtual_buffer(&vm, "بسم الله\n") == QALAM_OK);
+    TEST_ASSERT(qalam_buffer_get_backend(vm) == QALAM_BUFFER_BACKEND_GAP);
+    
+    /* Big pastes cross commit steps; random offsets move the gap far */
+    char* paste = (char*)malloc(200000);
+    TEST_ASSERT(paste != NULL);
+    for (size_t i = 0; i < 200000; i++) {
+        paste[i] = (i % 61 == 60) ? '\n' : (char)('a' + i % 26);
+    }
+    
+    unsigned seed = 777;
+    for (int i = 0; i < 2000; i++) {
+        seed = seed * 1103515245u + 12345u;
+        unsigned op = (seed >> 16) % 6;
+        QalamBufferStats stats;
+        qalam_buffer_get_stats(heap, &stats);
+        size_t offset = (seed >> 8) % (stats.total_chars + 1);
+        
+        if (op == 0) {
+            size_t length = 1 + (seed >> 4) % 200000;
+            qalam_buffer_insert_at(heap, offset, paste, length);
+            qalam_buffer_insert_at(vm, offset, paste, length);
+        } else if (op <= 2) {
+            qalam_buffer_insert_at(heap, offset, "مرحبا\n", strlen("مرحبا\n"));
+            qalam_buffer_insert_at(vm, offset, "مرحبا\n", strlen("مرحبا\n"));
+        } else if (op == 3) {
+            qalam_buffer_insert(heap, "k", 1);
+            qalam_buffer_insert(vm, "k", 1);
+        } else {
+            size_t end = offset + (seed >> 5) % (op == 4 ? 16 : 150000);
+            qalam_buffer_delete_range(heap, offset, end);
+            qalam_buffer_delete_range(vm, offset, end);
+        }
+    }
+    
+    /* Undo all the way back, then part of the way forward */
+    for (int i = 0; i < 3; i++) {
+        TEST_ASSERT(qalam_buffer_undo(heap) == qalam_buffer_undo(vm));
+    }
+    
+    size_t size = qalam_buffer_get_size(heap);
+    TEST_ASSERT_EQ(size, qalam_buffer_get_size(vm));
+    
+    char* expected = (char*)malloc(size + 1);
+    char* actual = (char*)malloc(size + 1);
+    TEST_ASSERT(expected != NULL && actual != NULL);
+    
+    size_t written;
+    qalam_buffer_get_content(heap, expected, size + 1, &written);
+    qalam_buffer_get_content(vm, actual, size + 1, &written);
+    TEST_ASSERT_STR_EQ(expected, actual);
+    TEST_ASSERT(verify_lines_match_content(vm) == 0);
+    
+    free(expected);
+    free(actual);
+    free(paste);
+    qalam_buffer_destroy(heap);
+    qalam_buffer_destroy(vm);
+    return 0;
+}
+
+static int test_virtual_growth(void) {
+    QalamBuffer* buffer = NULL;
+    TEST_ASSERT(create_virtual_buffer(&buffer, NULL) == QALAM_OK);
+    
+    QalamBufferStats stats;
+    TEST_ASSERT(qalam_buffer_get_stats(buffer, &stats) == QALAM_OK);
+    TEST_ASSERT(stats.capacity < 64 * 1024);
+    
+    /* Grow to 16 MB of UTF-16 in 64 KB appends; only what is used is committed */
+    char chunk[32 * 1024];
+    for (size_t i = 0; i < sizeof(chunk); i++) {
+        chunk[i] = (i % 80 == 79) ? '\n' : 'x';
+    }
+    for (int i = 0; i < 256; i++) {
+        TEST_ASSERT(qalam_buffer_insert(buffer, chunk, sizeof(chunk)) == QALAM_OK);
+    }
+    
+    size_t content = 256 * sizeof(chunk);
+    size_t margin = (2 * 1024 * 1024 + 128 * 1024) / sizeof(wchar_t);
+    TEST_ASSERT(qalam_buffer_get_stats(buffer, &stats) == QALAM_OK);
+    TEST_ASSERT_EQ(content, stats.total_chars);
+    TEST_ASSERT(stats.capacity >= content && stats.capacity <= content + margin);
+    
+    /* Moving the gap to the start moves the text to the end of the range;
+     * the pages it leaves are given back */
+    TEST_ASSERT(qalam_buffer_insert_at(buffer, 0, "بسم", strlen("بسم")) == QALAM_OK);
+    TEST_ASSERT(qalam_buffer_get_stats(buffer, &stats) == QALAM_OK);
+    TEST_ASSERT(stats.capacity <= content + 3 + margin);
+    
+    char head[16];
+    size_t written;
+    TEST_ASSERT(qalam_buffer_get_range(buffer, 0, 5, head, sizeof(head), &written) == QALAM_OK);
+    TEST_ASSERT_STR_EQ("بسمxx", head);
+    
+    /* Deleting most of it decommits the middle */
+    TEST_ASSERT(qalam_buffer_delete_range(buffer, 3, 3 + content - 100) == QALAM_OK);
+    TEST_ASSERT(qalam_buffer_get_stats(buffer, &stats) == QALAM_OK);
+    TEST_ASSERT_EQ(103, stats.total_chars);
+    TEST_ASSERT(stats.capacity <= margin);
+    
+    /* ...and undo brings it all back */
+    TEST_ASSERT(qalam_buffer_undo(buffer) == QALAM_OK);
+    TEST_ASSERT(qalam_buffer_get_stats(buffer, &stats) == QALAM_OK);
+    TEST_ASSERT_EQ(content + 3, stats.total_chars);
+    TEST_ASSERT(verify_lines_match_content(buffer) == 0);
+    
+    qalam_buffer_destroy(buffer);
+    return 0;
+}
+
+/*=============================================================================
+ * Tracing Tests
+ *============================================================================*/
+
+static int test_trace_totals(void) {
+    QalamTraceTotals totals;
+    TEST_ASSERT(qalam_trace_init() == QALAM_OK);
+    qalam_trace_take_totals(&totals);
+    
+    QalamTraceSpan span;
+    qalam_trace_span_begin(&span, QALAM_TRACE_BUFFER, "test_span");
+    Sleep(2);
+    qalam_trace_span_end(&span);
+    qalam_trace_span_begin(&span, QALAM_TRACE_BUFFER, "test_span");
+    qalam_trace_span_end(&span);
+    qalam_trace_counter(QALAM_TRACE_BUFFER, "test_bytes", 100);
+    qalam_trace_counter(QALAM_TRACE_BUFFER, "test_bytes", 28);
+    qalam_trace_counter(QALAM_TRACE_TERMINAL_IO, "test_bytes", 7);
+    
+    /* Out-of-range categories are ignored */
+    qalam_trace_counter(QALAM_TRACE_CATEGORY_COUNT, "test_bytes", 1);
+    qalam_trace_span_end(NULL);
+    
+    qalam_trace_take_totals(&totals);
+    TEST_ASSERT_EQ(2, totals.spans[QALAM_TRACE_BUFFER]);
+    TEST_ASSERT(totals.span_ns[QALAM_TRACE_BUFFER] >= 1000000);
+    TEST_ASSERT_EQ(128, totals.counters[QALAM_TRACE_BUFFER]);
+    TEST_ASSERT_EQ(7, totals.counters[QALAM_TRACE_TERMINAL_IO]);
+    TEST_ASSERT_EQ(0, totals.spans[QALAM_TRACE_LAYOUT]);
+    
+    /* Taking the totals starts new ones */
+    qalam_trace_take_totals(&totals);
+    TEST_ASSERT_EQ(0, totals.spans[QALAM_TRACE_BUFFER]);
+    TEST_ASSERT_EQ(0, totals.span_ns[QALAM_TRACE_BUFFER]);
+    TEST_ASSERT_EQ(0, totals.counters[QALAM_TRACE_BUFFER]);
+    
+    qalam_trace_shutdown();
+    return 0;
+}
+
+static int test_trace_startup(void) {
+    QalamStartupTimings timings;
+    qalam_trace_startup_reset();
+    qalam_trace_get_startup(&timings);
+    TEST_ASSERT_EQ(0, timings.reached);
+    
+    /* The first mark starts the clock when BEGIN was never marked */
+    qalam_trace_startup_mark(QALAM_STARTUP_DWRITE_INIT);
+    Sleep(2);
+    qalam_trace_startup_mark(QALAM_STARTUP_FIRST_PAINT);
+    qalam_trace_get_startup(&timings);
+    TEST_ASSERT_EQ((1u << QALAM_STARTUP_BEGIN) | (1u << QALAM_STARTUP_DWRITE_INIT) |
+                   (1u << QALAM_STARTUP_FIRST_PAINT), timings.reached);
+    TEST_ASSERT(timings.phase_ns[QALAM_STARTUP_FIRST_PAINT] >= 1000000);
+    TEST_ASSERT_EQ(0, timings.phase_ns[QALAM_STARTUP_FIRST_TEXT]);
+    
+    /* Later marks of a phase keep the first */
+    uint64_t first_paint = timings.phase_ns[QALAM_STARTUP_FIRST_PAINT];
+    Sleep(2);
+    qalam_trace_startup_mark(QALAM_STARTUP_FIRST_PAINT);
+    qalam_trace_startup_mark(QALAM_STARTUP_PHASE_COUNT);
+    qalam_trace_get_startup(&timings);
+    TEST_ASSERT_EQ(first_paint, timings.phase_ns[QALAM_STARTUP_FIRST_PAINT]);
+    
+    TEST_ASSERT(strcmp(qalam_trace_startup_phase_name(QALAM_STARTUP_FIRST_PAINT),
+                       "first_paint") == 0);
+    TEST_ASSERT(strcmp(qalam_trace_startup_phase_name(QALAM_STARTUP_PHASE_COUNT),
+                       "unknown") == 0);
+    
+    qalam_trace_startup_reset();
+    qalam_trace_get_startup(&timings);
+    TEST_ASSERT_EQ(0, timings.reached);
+    return 0;
+}
+
+/*=============================================================================
+ * Memory Tests
+ *============================================================================*/
+
+/**
+ * @brief Allocator that counts its calls and refuses to go past a limit
+ */
+typedef struct CountingAllocator {
+    size_t limit;
+    size_t live;
+    size_t calls[QALAM_MEMORY_TAG_COUNT];
+} CountingAllocator;
+
+static void* counting_allocate(size_t size, QalamMemoryTag tag, void* user_data) {
+    CountingAllocator* counter = (CountingAllocator*)user_data;
+    counter->calls[tag]++;
+    if (counter->live + size > counter->limit) {
+        return NULL;
+    }
+    
+    size_t* block = (size_t*)malloc(sizeof(size_t) * 2 + size);
+    if (!block) {
+        return NULL;
+    }
+    block[0] = size;
+    counter->live += size;
+    return block + 2;
+}
+
+static void counting_release(void* block, QalamMemoryTag tag, void* user_data) {
+    CountingAllocator* counter = (CountingAllocator*)user_data;
+    (void)tag;
+    size_t* header = (size_t*)block - 2;
+    counter->live -= header[0];
+    free(header);
+}
+
+static int test_memory_tags(void) {
+    QalamMemoryStats before;
+    QalamMemoryStats after;
+    qalam_memory_get_stats(&before);
+    
+    QalamBuffer* buffer = NULL;
+    TEST_ASSERT(qalam_buffer_create_from_text(&buffer, "Hello\nمرحبا\n", 0) == QALAM_OK);
+    
+    QalamBufferStats stats;
+    TEST_ASSERT(qalam_buffer_get_stats(buffer, &stats) == QALAM_OK);
+    TEST_ASSERT(stats.memory.blocks[QALAM_MEMORY_BUFFER] > before.blocks[QALAM_MEMORY_BUFFER]);
+    TEST_ASSERT(stats.memory.bytes[QALAM_MEMORY_BUFFER] >=
+                before.bytes[QALAM_MEMORY_BUFFER] + stats.capacity * sizeof(wchar_t));
+    TEST_ASSERT(stats.memory.peak_bytes[QALAM_MEMORY_BUFFER] >=
+                stats.memory.bytes[QALAM_MEMORY_BUFFER]);
+    
+    qalam_buffer_destroy(buffer);
+    qalam_memory_get_stats(&after);
+    TEST_ASSERT_EQ(before.blocks[QALAM_MEMORY_BUFFER], after.blocks[QALAM_MEMORY_BUFFER]);
+    TEST_ASSERT_EQ(before.bytes[QALAM_MEMORY_BUFFER], after.bytes[QALAM_MEMORY_BUFFER]);
+    TEST_ASSERT(after.allocations[QALAM_MEMORY_BUFFER] > before.allocations[QALAM_MEMORY_BUFFER]);
+    
+    /* Blocks keep their tag through a resize */
+    char* block = (char*)qalam_mem_alloc(QALAM_MEMORY_UNDO, 10);
+    TEST_ASSERT(block != NULL);
+    memcpy(block, "0123456789", 10);
+    block = (char*)qalam_mem_realloc(QALAM_MEMORY_BUFFER, block, 4000);
+    TEST_ASSERT(block != NULL);
+    TEST_ASSERT(memcmp(block, "0123456789", 10) == 0);
+    qalam_memory_get_stats(&after);
+    TEST_ASSERT_EQ(before.bytes[QALAM_MEMORY_UNDO] + 4000, after.bytes[QALAM_MEMORY_UNDO]);
+    qalam_mem_free(block);
+    qalam_memory_get_stats(&after);
+    TEST_ASSERT_EQ(before.bytes[QALAM_MEMORY_UNDO], after.bytes[QALAM_MEMORY_UNDO]);
+    
+    return 0;
+}
+
+static int test_memory_allocator(void) {
+    CountingAllocator counter;
+    memset(&counter, 0, sizeof(counter));
+    counter.limit = 64 * 1024;
+    
+    QalamAllocator allocator = { counting_allocate, NULL, counting_release, &counter };
+    QalamAllocator incomplete = { NULL, NULL, counting_release, &counter };
+    TEST_ASSERT(qalam_memory_set_allocator(&incomplete) == QALAM_ERROR_INVALID_ARGUMENT);
+    TEST_ASSERT(qalam_memory_set_allocator(&allocator) == QALAM_OK);
+    
+    /* Every buffer allocation goes through the callbacks, tagged */
+    QalamBuffer* buffer = NULL;
+    TEST_ASSERT(qalam_buffer_create_from_text(&buffer, "Hello, World!", 0) == QALAM_OK);
+    TEST_ASSERT(counter.calls[QALAM_MEMORY_BUFFER] > 0);
+    TEST_ASSERT(counter.live > 0);
+    
+    /* Not while blocks from this allocator are live */
+    TEST_ASSERT(qalam_memory_set_allocator(NULL) == QALAM_ERROR_ALREADY_INITIALIZED);
+    
+    /* Resizing without a reallocate callback copies the contents */
+    size_t chunk = 4096;
+    char* text = (char*)malloc(chunk + 1);
+    TEST_ASSERT(text != NULL);
+    memset(text, 'x', chunk);
+    text[chunk] = '\0';
+    QalamResult result = QALAM_OK;
+    for (int i = 0; i < 64 && result == QALAM_OK; i++) {
+        result = qalam_buffer_insert_at(buffer, 0, text, chunk);
+    }
+    free(text);
+    
+    /* The limit fails the allocation, and the buffer stays usable */
+    QalamMemoryStats stats;
+    qalam_memory_get_stats(&stats);
+    TEST_ASSERT(result == QALAM_ERROR_OUT_OF_MEMORY);
+    TEST_ASSERT(stats.failures[QALAM_MEMORY_BUFFER] > 0);
+    TEST_ASSERT(counter.live <= counter.limit);
+    TEST_ASSERT(qalam_buffer_insert_at(buffer, 0, "ok", 2) == QALAM_OK);
+    
+    qalam_buffer_destroy(buffer);
+    TEST_ASSERT_EQ(0, counter.live);
+    TEST_ASSERT(qalam_memory_set_allocator(NULL) == QALAM_OK);
+    return 0;
+}
+
+static int test_frame_arena(void) {
+    size_t mark = qalam_frame_mark();
+    char* first = (char*)qalam_frame_alloc(10);
+    char* second = (char*)qalam_frame_alloc(100);
+    TEST_ASSERT(first != NULL && second != NULL);
+    TEST_ASSERT_EQ(0, (uintptr_t)first % 16);
+    TEST_ASSERT_EQ(0, (uintptr_t)second % 16);
+    TEST_ASSERT(second >= first + 10);
+    
+    /* Rewinding hands the same memory out again */
+    qalam_frame_rewind(mark);
+    TEST_ASSERT(qalam_frame_alloc(10) == first);
+    
+    /* A frame that outgrows a block comes back as one block that fits */
+    for (int i = 0; i < 8; i++) {
+        TEST_ASSERT(qalam_frame_alloc(48 * 1024) != NULL);
+    }
+    QalamMemoryStats stats;
+    qalam_memory_get_stats(&stats);
+    TEST_ASSERT(stats.blocks[QALAM_MEMORY_FRAME] > 1);
+    
+    qalam_frame_reset();
+    TEST_ASSERT_EQ(0, qalam_frame_mark());
+    for (int i = 0; i < 8; i++) {
+        TEST_ASSERT(qalam_frame_alloc(48 * 1024) != NULL);
+    }
+    qalam_memory_get_stats(&stats);
+    TEST_ASSERT_EQ(1, stats.blocks[QALAM_MEMORY_FRAME]);
+    
+    /* Releasing frees the last block too */
+    qalam_frame_release();
+    qalam_memory_get_stats(&stats);
+    TEST_ASSERT_EQ(0, stats.blocks[QALAM_MEMORY_FRAME]);
+    TEST_ASSERT_EQ(0, qalam_frame_mark());
+    return 0;
+}
+
+/*=============================================================================
+ * Hibernation Tests
+ *============================================================================*/
+
+/**
+ * @brief Hibernate, check what is answered asleep, and wake by reading
+ */
+static int check_hibernate_round_trip(QalamBuffer* buffer) {
+    size_t size = qalam_buffer_get_size(buffer);
+    size_t lines = qalam_buffer_get_line_count(buffer);
+    char* before = (char*)malloc(size + 1);
+    char* after = (char*)malloc(size + 1);
+    TEST_ASSERT(before != NULL && after != NULL);
+    size_t written;
+    TEST_ASSERT(qalam_buffer_get_content(buffer, before, size + 1, &written) == QALAM_OK);
+    
+    size_t resident = qalam_buffer_get_resident_size(buffer);
+    TEST_ASSERT(qalam_buffer_hibernate(buffer) == QALAM_OK);
+    TEST_ASSERT(qalam_buffer_is_hibernated(buffer));
+    TEST_ASSERT(qalam_buffer_get_resident_size(buffer) < resident);
+    
+    /* Sizes and lines come without waking it */
+    QalamBufferStats stats;
+    TEST_ASSERT(qalam_buffer_get_stats(buffer, &stats) == QALAM_OK);
+    TEST_ASSERT(stats.is_hibernated);
+    TEST_ASSERT_EQ(size, stats.total_bytes);
+    TEST_ASSERT_EQ(size, qalam_buffer_get_size(buffer));
+    TEST_ASSERT_EQ(lines, qalam_buffer_get_line_count(buffer));
+    TEST_ASSERT(qalam_buffer_is_hibernated(buffer));
+    
+    TEST_ASSERT(qalam_buffer_get_content(buffer, after, size + 1, &written) == QALAM_OK);
+    TEST_ASSERT(!qalam_buffer_is_hibernated(buffer));
+    TEST_ASSERT_STR_EQ(before, after);
+    TEST_ASSERT(verify_lines_match_content(buffer) == 0);
+    
+    free(before);
+    free(after);
+    return 0;
+}
+
+static int test_hibernate_gap(void) {
+    QalamBuffer* heap = NULL;
+    QalamBuffer* vm = NULL;
+    TEST_ASSERT(qalam_buffer_create_from_text(&heap, "بسم الله\nint main(void);\n", 0) == QALAM_OK);
+    TEST_ASSERT(create_virtual_buffer(&vm, "بسم الله\nint main(void);\n") == QALAM_OK);
+    
+    QalamBuffer* buffers[2] = { heap, vm };
+    for (int i = 0; i < 2; i++) {
+        QalamBuffer* buffer = buffers[i];
+        TEST_ASSERT(qalam_buffer_set_cursor(buffer, 1, 4) == QALAM_OK);
+        TEST_ASSERT(qalam_buffer_insert(buffer, "قلم ", strlen("قلم ")) == QALAM_OK);
+        TEST_ASSERT(qalam_buffer_delete_range(buffer, 0, 4) == QALAM_OK);
+        TEST_ASSERT(check_hibernate_round_trip(buffer) == 0);
+        
+        /* The cursor and undo history survive, and edits work asleep */
+        QalamCursor cursor;
+        TEST_ASSERT(qalam_buffer_get_cursor(buffer, &cursor) == QALAM_OK);
+        TEST_ASSERT_EQ(0, cursor.offset);
+        TEST_ASSERT(qalam_buffer_hibernate(buffer) == QALAM_OK);
+        TEST_ASSERT(qalam_buffer_undo(buffer) == QALAM_OK);
+        TEST_ASSERT(qalam_buffer_hibernate(buffer) == QALAM_OK);
+        TEST_ASSERT(qalam_buffer_undo(buffer) == QALAM_OK);
+        
+        char line[64];
+        size_t written;
+        TEST_ASSERT(qalam_buffer_get_line(buffer, 1, line, sizeof(line), &written) == QALAM_OK);
+        TEST_ASSERT_STR_EQ("int main(void);", line);
+        TEST_ASSERT(qalam_buffer_hibernate(buffer) == QALAM_OK);
+        TEST_ASSERT(qalam_buffer_redo(buffer) == QALAM_OK);
+        TEST_ASSERT(qalam_buffer_get_line(buffer, 1, line, sizeof(line), &written) == QALAM_OK);
+        TEST_ASSERT_STR_EQ("int قلم main(void);", line);
+    }
+    
+    /* Shrinking gives back the heap buffer's growth room */
+    char chunk[8192];
+    memset(chunk, 'x', sizeof(chunk));
+    for (int i = 0; i < 16; i++) {
+        TEST_ASSERT(qalam_buffer_insert(heap, chunk, sizeof(chunk)) == QALAM_OK);
+    }
+    TEST_ASSERT(qalam_buffer_delete_range(heap, 0, 15 * sizeof(chunk)) == QALAM_OK);
+    size_t resident = qalam_buffer_get_resident_size(heap);
+    TEST_ASSERT(qalam_buffer_shrink_to_fit(heap) == QALAM_OK);
+    TEST_ASSERT(qalam_buffer_get_resident_size(heap) < resident);
+    TEST_ASSERT(check_hibernate_round_trip(heap) == 0);
+    
+    /* Empty buffers hibernate too */
+    QalamBuffer* empty = NULL;
+    TEST_ASSERT(qalam_buffer_create(&empty) == QALAM_OK);
+    TEST_ASSERT(qalam_buffer_hibernate(empty) == QALAM_OK);
+    TEST_ASSERT_EQ(0, qalam_buffer_get_size(empty));
+    TEST_ASSERT(qalam_buffer_insert(empty, "ا", strlen("ا")) == QALAM_OK);
+    TEST_ASSERT_EQ(strlen("ا"), qalam_buffer_get_size(empty));
+    
+    qalam_buffer_destroy(empty);
+    qalam_buffer_destroy(heap);
+    qalam_buffer_destroy(vm);
+    return 0;
+}
+
+static int test_hibernate_pieces(void) {
+    QalamBuffer* buffer = NULL;
+    TEST_ASSERT(create_piece_table_buffer(&buffer, "سطر أول\nسطر ثان\n") == QALAM_OK);
+    TEST_ASSERT(qalam_buffer_insert_at(buffer, 4, "🌙", strlen("🌙")) == QALAM_OK);
+    TEST_ASSERT(qalam_buffer_delete_range(buffer, 0, 2) == QALAM_OK);
+    TEST_ASSERT(check_hibernate_round_trip(buffer) == 0);
+    
+    /* Undo spans still point at the right text after a wake */
+    TEST_ASSERT(qalam_buffer_hibernate(buffer) == QALAM_OK);
+    TEST_ASSERT(qalam_buffer_undo(buffer) == QALAM_OK);
+    TEST_ASSERT(qalam_buffer_undo(buffer) == QALAM_OK);
+    
+    char line[64];
+    size_t written;
+    TEST_ASSERT(qalam_buffer_get_line(buffer, 0, line, sizeof(line), &written) == QALAM_OK);
+    TEST_ASSERT_STR_EQ("سطر أول", line);
+    TEST_ASSERT(qalam_buffer_hibernate(buffer) == QALAM_OK);
+    TEST_ASSERT(qalam_buffer_redo(buffer) == QALAM_OK);
+    TEST_ASSERT(qalam_buffer_get_line(buffer, 0, line, sizeof(line), &written) == QALAM_OK);
+    TEST_ASSERT_STR_EQ("سطر 🌙أول", line);
+    TEST_ASSERT(verify_lines_match_content(buffer) == 0);
+    
+    qalam_buffer_destroy(buffer);
+    return 0;
+}
+
+static int test_workspace_budget(void) {
+    QalamWorkspaceOptions options;
+    TEST_ASSERT(qalam_workspace_get_default_options(&options) == QALAM_OK);
+    options.memory_budget = 1;
+    options.shrink_after_ms = 0;
+    options.hibernate_after_ms = 0;
+    
+    QalamWorkspace* workspace = NULL;
+    TEST_ASSERT(qalam_workspace_create(&workspace, &options) == QALAM_OK);
+    
+    QalamBuffer* buffers[3];
+    for (int i = 0; i < 3; i++) {
+        TEST_ASSERT(qalam_buffer_create_from_text(&buffers[i], "مرحبا\n", 0) == QALAM_OK);
+        TEST_ASSERT(qalam_workspace_add(workspace, buffers[i]) == QALAM_OK);
+    }
+    TEST_ASSERT(qalam_workspace_add(workspace, buffers[0]) == QALAM_ERROR_INVALID_ARGUMENT);
+    TEST_ASSERT_EQ(3, qalam_workspace_get_count(workspace));
+    TEST_ASSERT(qalam_workspace_get_buffer(workspace, 2) == buffers[2]);
+    TEST_ASSERT(qalam_workspace_focus(workspace, buffers[1]) == QALAM_OK);
+    TEST_ASSERT(qalam_workspace_get_active(workspace) == buffers[1]);
+    
+    /* Over budget: everything but the active buffer hibernates */
+    TEST_ASSERT(qalam_workspace_apply_policy(workspace) == QALAM_OK);
+    TEST_ASSERT(qalam_buffer_is_hibernated(buffers[0]));
+    TEST_ASSERT(!qalam_buffer_is_hibernated(buffers[1]));
+    TEST_ASSERT(qalam_buffer_is_hibernated(buffers[2]));
+    
+    QalamWorkspaceStats stats;
+    TEST_ASSERT(qalam_workspace_get_stats(workspace, &stats) == QALAM_OK);
+    TEST_ASSERT_EQ(3, stats.buffer_count);
+    TEST_ASSERT_EQ(2, stats.hibernated_count);
+    TEST_ASSERT_EQ(2, stats.hibernations);
+    
+    /* Focus wakes a buffer; with room in the budget nothing else changes */
+    TEST_ASSERT(qalam_workspace_focus(workspace, buffers[0]) == QALAM_OK);
+    TEST_ASSERT(!qalam_buffer_is_hibernated(buffers[0]));
+    options.memory_budget = 0;
+    TEST_ASSERT(qalam_workspace_set_options(workspace, &options) == QALAM_OK);
+    TEST_ASSERT(qalam_workspace_apply_policy(workspace) == QALAM_OK);
+    TEST_ASSERT(!qalam_buffer_is_hibernated(buffers[1]));
+    TEST_ASSERT(qalam_workspace_get_stats(workspace, &stats) == QALAM_OK);
+    TEST_ASSERT_EQ(1, stats.rehydrations);
+    TEST_ASSERT_EQ(1, stats.hibernated_count);
+    
+    /* Removing hands the buffer back */
+    TEST_ASSERT(qalam_workspace_remove(workspace, buffers[0]) == QALAM_OK);
+    TEST_ASSERT(qalam_workspace_get_active(workspace) == NULL);
+    TEST_ASSERT(qalam_workspace_remove(workspace, buffers[0]) == QALAM_ERROR_INVALID_ARGUMENT);
+    TEST_ASSERT_EQ(2, qalam_workspace_get_count(workspace));
+    qalam_buffer_destroy(buffers[0]);
+    
+    qalam_workspace_destroy(workspace);
+    return 0;
+}
+
+/*=============================================================================
+ * Syntax Highlighting Tests
+ *============================================================================*/
+
+static int test_syntax_lexer(void) {
+    static const wchar_t line[] = L"صحيح س = ١٢ + 3.5. // تعليق";
+    SyntaxRangeList list;
+    memset(&list, 0, sizeof(list));
+    uint32_t state = 99;
+    
+    TEST_ASSERT(syntax_lex_line(line, sizeof(line) / sizeof(wchar_t) - 1, SYNTAX_STATE_NORMAL,
+                                &list, &state) == QALAM_OK);
+    TEST_ASSERT_EQ(SYNTAX_STATE_NORMAL, state);
+    TEST_ASSERT_EQ(6, list.count);
+    TEST_ASSERT_EQ(QALAM_SYNTAX_TYPE, list.ranges[0].style);
+    TEST_ASSERT_EQ(4, list.ranges[0].length);
+    TEST_ASSERT_EQ(QALAM_SYNTAX_OPERATOR, list.ranges[1].style);
+    TEST_ASSERT_EQ(7, list.ranges[1].start);
+    TEST_ASSERT_EQ(QALAM_SYNTAX_NUMBER, list.ranges[2].style);
+    TEST_ASSERT_EQ(2, list.ranges[2].length);
+    TEST_ASSERT_EQ(QALAM_SYNTAX_NUMBER, list.ranges[4].style);
+    TEST_ASSERT_EQ(3, list.ranges[4].length);
+    TEST_ASSERT_EQ(QALAM_SYNTAX_COMMENT, list.ranges[5].style);
+    TEST_ASSERT_EQ(19, list.ranges[5].start);
+    TEST_ASSERT_EQ(8, list.ranges[5].length);
+    
+    /* A block comment carries its state into the next line */
+    list.count = 0;
+    TEST_ASSERT(syntax_lex_line(L"#تضمين /* بداية", 15, SYNTAX_STATE_NORMAL,
+                                &list, &state) == QALAM_OK);
+    TEST_ASSERT_EQ(SYNTAX_STATE_BLOCK_COMMENT, state);
+    TEST_ASSERT_EQ(2, list.count);
+    TEST_ASSERT_EQ(QALAM_SYNTAX_PREPROCESSOR, list.ranges[0].style);
+    TEST_ASSERT_EQ(6, list.ranges[0].length);
+    
+    list.count = 0;
+    TEST_ASSERT(syntax_lex_line(L"نهاية */ إذا \"نص\"", 17, state, &list, &state) == QALAM_OK);
+    TEST_ASSERT_EQ(SYNTAX_STATE_NORMAL, state);
+    TEST_ASSERT_EQ(3, list.count);
+    TEST_ASSERT_EQ(QALAM_SYNTAX_COMMENT, list.ranges[0].style);
+    TEST_ASSERT_EQ(8, list.ranges[0].length);
+    TEST_ASSERT_EQ(QALAM_SYNTAX_KEYWORD, list.ranges[1].style);
+    TEST_ASSERT_EQ(QALAM_SYNTAX_STRING, list.ranges[2].style);
+    TEST_ASSERT_EQ(4, list.ranges[2].length);
+    
+    syntax_range_list_free(&list);
+    return 0;
+}
+
+static void forward_change(const QalamBuffer* buffer, const QalamBufferChange* change,
+                           void* user_data) {
+    (void)buffer;
+    qalam_highlighter_on_buffer_change((QalamHighlighter*)user_data, change);
+}
+
+/**
+ * @brief Pump a highlighter until every line is lexed
+ */
+static bool highlight_to_completion(QalamHighlighter* highlighter) {
+    for (int i = 0; i < 20000; i++) {
+        if (qalam_highlighter_update(highlighter, NULL, NULL) != QALAM_OK) {
+            return false;
+        }
+        if (qalam_highlighter_is_complete(highlighter)) {
+            return true;
+        }
+        Sleep(1);
+    }
+    return false;
+}
+
+static uint32_t first_style(const QalamHighlighter* highlighter, size_t line) {
+    const QalamStyleRange* ranges = NULL;
+    size_t count = qalam_highlighter_get_line_styles(highlighter, line, &ranges);
+    return count > 0 ? ranges[0].style : QALAM_SYNTAX_PLAIN;
+}
+
+static int test_highlight_incremental(void) {
+    enum { LINES = 3000 };
+    static const char row[] = "صحيح س = ١.\n";
+    size_t row_bytes = sizeof(row) - 1;
+    char* text = (char*)malloc(LINES * row_bytes + 1);
+    TEST_ASSERT(text != NULL);
+    for (size_t i = 0; i < LINES; i++) {
+        memcpy(text + i * row_bytes, row, row_bytes);
+    }
+    text[LINES * row_bytes] = '\0';
+    
+    QalamBuffer* buffer = NULL;
+    TEST_ASSERT(qalam_buffer_create_from_text(&buffer, text, LINES * row_bytes) == QALAM_OK);
+    free(text);
+    
+    QalamHighlighterOptions options;
+    TEST_ASSERT(qalam_highlighter_get_default_options(&options) == QALAM_OK);
+    options.batch_chars = 4096;
+    QalamHighlighter* highlighter = NULL;
+    TEST_ASSERT(qalam_highlighter_create(&highlighter, buffer, &options) == QALAM_OK);
+    TEST_ASSERT(qalam_buffer_set_change_callback(buffer, forward_change, highlighter) == QALAM_OK);
+    TEST_ASSERT(!qalam_highlighter_is_complete(highlighter));
+    
+    TEST_ASSERT(highlight_to_completion(highlighter));
+    TEST_ASSERT_EQ(QALAM_SYNTAX_TYPE, first_style(highlighter, 0));
+    TEST_ASSERT_EQ(QALAM_SYNTAX_TYPE, first_style(highlighter, LINES - 1));
+    
+    QalamHighlighterStats before;
+    QalamHighlighterStats after;
+    TEST_ASSERT(qalam_highlighter_get_stats(highlighter, &before) == QALAM_OK);
+    TEST_ASSERT_EQ(LINES + 1, before.line_count);
+    TEST_ASSERT_EQ(0, before.pending_lines);
+    
+    /* An edit that leaves the end state alone relexes its own line */
+    QalamLineInfo info;
+    TEST_ASSERT(qalam_buffer_get_line_info(buffer, 100, &info) == QALAM_OK);
+    size_t line_start = info.start_offset;
+    static const char keyword[] = "إذا ";
+    TEST_ASSERT(qalam_buffer_insert_at(buffer, line_start, keyword, strlen(keyword)) == QALAM_OK);
+    TEST_ASSERT(highlight_to_completion(highlighter));
+    TEST_ASSERT(qalam_highlighter_get_stats(highlighter, &after) == QALAM_OK);
+    TEST_ASSERT(after.lines_lexed - before.lines_lexed <= 2);
+    TEST_ASSERT_EQ(QALAM_SYNTAX_KEYWORD, first_style(highlighter, 100));
+    
+    /* Opening a block comment runs down to the end of the file... */
+    before = after;
+    TEST_ASSERT(qalam_buffer_insert_at(buffer, line_start, "/*", strlen("/*")) == QALAM_OK);
+    TEST_ASSERT(highlight_to_completion(highlighter));
+    TEST_ASSERT(qalam_highlighter_get_stats(highlighter, &after) == QALAM_OK);
+    TEST_ASSERT(after.lines_lexed - before.lines_lexed >= LINES - 100);
+    TEST_ASSERT_EQ(QALAM_SYNTAX_COMMENT, first_style(highlighter, 2000));
+    TEST_ASSERT_EQ(QALAM_SYNTAX_TYPE, first_style(highlighter, 99));
+    
+    /* ...and closing it two lines down stops once the old states line up */
+    before = after;
+    TEST_ASSERT(qalam_buffer_get_line_info(buffer, 102, &info) == QALAM_OK);
+    size_t close_at = info.start_offset + 2;
+    TEST_ASSERT(qalam_buffer_insert_at(buffer, close_at, "*/", strlen("*/")) == QALAM_OK);
+    TEST_ASSERT(highlight_to_completion(highlighter));
+    TEST_ASSERT_EQ(QALAM_SYNTAX_TYPE, first_style(highlighter, 2000));
+    TEST_ASSERT_EQ(QALAM_SYNTAX_COMMENT, first_style(highlighter, 101));
+    
+    before = after;
+    TEST_ASSERT(qalam_highlighter_get_stats(highlighter, &before) == QALAM_OK);
+    TEST_ASSERT(qalam_buffer_delete_range(buffer, close_at, close_at + 2) == QALAM_OK);
+    TEST_ASSERT(qalam_buffer_insert_at(buffer, close_at, "*/", strlen("*/")) == QALAM_OK);
+    TEST_ASSERT(highlight_to_completion(highlighter));
+    TEST_ASSERT(qalam_highlighter_get_stats(highlighter, &after) == QALAM_OK);
+    TEST_ASSERT(after.lines_lexed - before.lines_lexed <= 4);
+    
+    /* Lines removed and added keep the states in step */
+    TEST_ASSERT(qalam_buffer_get_line_info(buffer, 10, &info) == QALAM_OK);
+    TEST_ASSERT(qalam_buffer_delete_range(buffer, 0, info.start_offset) == QALAM_OK);
+    static const char comment[] = "/* أ\nب\nج */\n";
+    TEST_ASSERT(qalam_buffer_insert_at(buffer, 0, comment, strlen(comment)) == QALAM_OK);
+    TEST_ASSERT(highlight_to_completion(highlighter));
+    TEST_ASSERT(qalam_highlighter_get_stats(highlighter, &after) == QALAM_OK);
+    TEST_ASSERT_EQ(qalam_buffer_get_line_count(buffer), after.line_count);
+    TEST_ASSERT_EQ(QALAM_SYNTAX_COMMENT, first_style(highlighter, 1));
+    TEST_ASSERT_EQ(QALAM_SYNTAX_TYPE, first_style(highlighter, 3));
+    
+    qalam_buffer_set_change_callback(buffer, NULL, NULL);
+    qalam_highlighter_destroy(highlighter);
+    qalam_buffer_destroy(buffer);
+    return 0;
+}
+
+static int test_highlight_viewport_first(void) {
+    enum { LINES = 5000 };
+    static const char row[] = "اطبع(\"سطر\").\n";
+    size_t row_bytes = sizeof(row) - 1;
+    char* text = (char*)malloc(LINES * row_bytes + 1);
+    TEST_ASSERT(text != NULL);
+    for (size_t i = 0; i < LINES; i++) {
+        memcpy(text + i * row_bytes, row, row_bytes);
+    }
+    
+    QalamBuffer* buffer = NULL;
+    TEST_ASSERT(qalam_buffer_create_from_text(&buffer, text, LINES * row_bytes) == QALAM_OK);
+    free(text);
+    
+    QalamHighlighterOptions options;
+    TEST_ASSERT(qalam_highlighter_get_default_options(&options) == QALAM_OK);
+    options.batch_chars = 64;
+    QalamHighlighter* highlighter = NULL;
+    TEST_ASSERT(qalam_highlighter_create(&highlighter, buffer, &options) == QALAM_OK);
+    qalam_highlighter_set_viewport(highlighter, 4000, 40);
+    
+    /* The first job is the viewport, before any line above it */
+    size_t first = 0;
+    size_t count = 0;
+    for (int i = 0; i < 20000 && count == 0; i++) {
+        TEST_ASSERT(qalam_highlighter_update(highlighter, &first, &count) == QALAM_OK);
+        if (count == 0) {
+            Sleep(1);
+        }
+    }
+    TEST_ASSERT_EQ(4000, first);
+    TEST_ASSERT_EQ(40, count);
+    TEST_ASSERT_EQ(QALAM_SYNTAX_BUILTIN, first_style(highlighter, 4039));
+    TEST_ASSERT_EQ(QALAM_SYNTAX_PLAIN, first_style(highlighter, 0));
+    
+    const QalamStyleRange* ranges = NULL;
+    TEST_ASSERT_EQ(2, qalam_highlighter_get_line_styles(highlighter, 4000, &ranges));
+    TEST_ASSERT_EQ(QALAM_SYNTAX_STRING, ranges[1].style);
+    TEST_ASSERT_EQ(5, ranges[1].start);
+    TEST_ASSERT_EQ(0, qalam_highlighter_get_line_styles(highlighter, LINES + 10, &ranges));
+    
+    QalamHighlighterStats stats;
+    TEST_ASSERT(qalam_highlighter_get_stats(highlighter, &stats) == QALAM_OK);
+    TEST_ASSERT_EQ(1, stats.jobs);
+    TEST_ASSERT_EQ(LINES + 1 - 40, stats.pending_lines);
+    
+    /* Destroying with a job in flight waits for it */
+    qalam_highlighter_destroy(highlighter);
+    qalam_buffer_destroy(buffer);
+    return 0;
+}
+
+
+/*=============================================================================
+ * Main Test Runner
+ *============================================================================*/
+
+int main(int argc, char* argv[]) {
+    printf("===========================================\n");
+    printf("  Qalam IDE - Gap Buffer Unit Tests\n");
+    printf("===========================================\n\n");
+    
+    /* Set console to UTF-8 for proper display */
+    SetConsoleOutputCP(CP_UTF8);
+    
+    printf("Buffer Creation and Destruction:\n");
+    RUN_TEST(buffer_create_empty);
+    RUN_TEST(buffer_create_with_capacity);
+    RUN_TEST(buffer_create_from_text);
+    RUN_TEST(buffer_destroy_null);
+    RUN_TEST(buffer_create_null_pointer);
+    
+    printf("\nInsert Operations:\n");
+    RUN_TEST(insert_at_beginning_empty);
+    RUN_TEST(insert_at_beginning);
+    RUN_TEST(insert_at_middle);
+    RUN_TEST(insert_at_end);
+    RUN_TEST(insert_at_position);
+    RUN_TEST(insert_newlines);
+    
+    printf("\nDelete Operations:\n");
+    RUN_TEST(delete_at_beginning);
+    RUN_TEST(delete_at_middle);
+    RUN_TEST(delete_at_end);
+    RUN_TEST(delete_range);
+    RUN_TEST(delete_newlines);
+    
+    printf("\nCursor Movement:\n");
+    RUN_TEST(cursor_movement);
+    RUN_TEST(cursor_line_start_end);
+    RUN_TEST(cursor_relative_movement);
+    
+    printf("\nLine Counting:\n");
+    RUN_TEST(line_count_multiple);
+    RUN_TEST(line_count_insert);
+    RUN_TEST(get_line);
+    RUN_TEST(line_index_large_edits);
+    
+    printf("\nEmpty Buffer Edge Cases:\n");
+    RUN_TEST(empty_buffer_operations);
+    RUN_TEST(empty_lines);
+    
+    printf("\nUnicode/UTF-16 Handling:\n");
+    RUN_TEST(arabic_text);
+    RUN_TEST(mixed_arabic_english);
+    RUN_TEST(surrogate_pairs);
+    RUN_TEST(delete_surrogate_pair);
+    
+    printf("\nLarge Content Handling:\n");
+    RUN_TEST(large_content_1mb);
+    RUN_TEST(large_content_10mb);
+    
+    printf("\nReplace Operations:\n");
+    RUN_TEST(replace);
+    
+    printf("\nSelection Operations:\n");
+    RUN_TEST(selection);
+    
+    printf("\nBuffer Statistics:\n");
+    RUN_TEST(buffer_stats);
+    
+    printf("\nLine Information:\n");
+    RUN_TEST(line_info);
+    RUN_TEST(line_info_cache);
+    RUN_TEST(line_generation);
+    RUN_TEST(line_view);
+    
+    printf("\nError Handling:\n");
+    RUN_TEST(error_handling);
+    
+    printf("\nText Scanning Kernels:\n");
+    RUN_TEST(text_scan_levels);
+    
+    printf("\nPiece Table Backend:\n");
+    RUN_TEST(piece_table_basic);
+    RUN_TEST(piece_table_matches_gap);
+    RUN_TEST(piece_table_line_view);
+    RUN_TEST(piece_table_file);
+    RUN_TEST(mapped_file_load);
+    RUN_TEST(background_file_load);
+    
+    printf("\nFile Save:\n");
+    RUN_TEST(save_streaming);
+    
+    printf("\nUndo/Redo:\n");
+    RUN_TEST(undo_typing);
+    RUN_TEST(undo_groups);
+    RUN_TEST(undo_large);
+    
+    printf("\nEdit Transactions:\n");
+    RUN_TEST(change_callback);
+    RUN_TEST(edit_transaction);
+    RUN_TEST(edit_transaction_large);
+    
+    printf("\nSearch:\n");
+    RUN_TEST(search_basic);
+    RUN_TEST(search_arabic);
+    RUN_TEST(search_large);
+    
+    printf("\nVirtual Memory Gap Buffer:\n");
+    RUN_TEST(virtual_matches_heap);
+    RUN_TEST(virtual_growth);
+    
+    printf("\nTracing:\n");
+    RUN_TEST(trace_totals);
+    RUN_TEST(trace_startup);
+    
+    printf("\nMemory:\n");
+    RUN_TEST(memory_tags);
+    RUN_TEST(memory_allocator);
+    RUN_TEST(frame_arena);
+    
+    printf("\nHibernation:\n");
+    RUN_TEST(hibernate_gap);
+    RUN_TEST(hibernate_pieces);
+    RUN_TEST(workspace_budget);
+    
+    printf("\nSyntax Highlighting:\n");
+    RUN_TEST(syntax_lexer);
+    RUN_TEST(highlight_incremental);
+    RUN_TEST(highlight_viewport_first);
     
     printf("\n===========================================\n");
     printf("  Test Results: %d/%d passed", g_tests_passed, g_tests_total);
@@ -4,16 +4,24 @@
  * 
  * Tests for the DirectWrite text rendering system using the new pure C API:
  * - Factory initialization/shutdown
- * - Text format creation
+ * - Text format creation, Arabic family resolution and font preloading
  * - Arabic text layout creation
  * - Text measurement
  * - Hit testing (point to position, position to point)
+ * - Layout and shaped glyph run caching
+ * - Syntax style ranges on cached layouts
+ * - Bidi caret navigation
+ * - Editor view virtualization and dirty regions
+ * - Frame scheduler input coalescing
+ * - Glyph atlas argument checks
  * 
  * @version 0.0.2
  * @copyright (c) 2026 Qalam Project
  */
 
 #include "dwrite_api.h"
+#include "editor_view.h"
+#include "frame_scheduler.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -273,6 +281,76 @@ TEST(text_format_weights) {
     TEST_PASSED();
 }
 
+/**
+ * @brief Test Arabic family resolution and font preloading with a cache file
+ */
+TEST(font_preload) {
+    QalamDWriteFontPreload* preload = NULL;
+    QalamDWriteTextFormat* format = NULL;
+    wchar_t name[64];
+    const wchar_t* cache_path = L"qalam_test_fonts.cache";
+    
+    DeleteFileW(cache_path);
+    
+    ASSERT_OK(qalam_dwrite_init());
+    
+    /* A family that is not installed gets one with Arabic letters */
+    ASSERT_OK(qalam_dwrite_text_format_create_arabic(L"Missing Qalam Family", 16.0f, &format));
+    ASSERT_OK(qalam_dwrite_text_format_get_family_name(format, name, 64));
+    ASSERT(wcscmp(name, L"Segoe UI") == 0);
+    ASSERT_EQ(QALAM_ERROR_INVALID_ARGUMENT,
+              qalam_dwrite_text_format_get_family_name(format, name, 4));
+    qalam_dwrite_text_format_destroy(format);
+    format = NULL;
+    
+    QalamDWriteFontPreloadOptions options;
+    qalam_dwrite_font_preload_get_default_options(&options);
+    options.family = L"Missing Qalam Family";
+    options.cache_path = cache_path;
+    ASSERT_OK(qalam_dwrite_font_preload_start(&options, &preload));
+    ASSERT_NOT_NULL(preload);
+    ASSERT_OK(qalam_dwrite_font_preload_wait(preload, &format));
+    ASSERT_NOT_NULL(format);
+    ASSERT(qalam_dwrite_font_preload_is_ready(preload));
+    ASSERT(qalam_dwrite_text_format_is_rtl(format));
+    
+    /* The format is handed over once */
+    QalamDWriteTextFormat* again = format;
+    ASSERT_OK(qalam_dwrite_font_preload_wait(preload, &again));
+    ASSERT(again == NULL);
+    qalam_dwrite_font_preload_destroy(preload);
+    qalam_dwrite_text_format_destroy(format);
+    format = NULL;
+    qalam_dwrite_shutdown();
+    
+    /* The next run takes the choice from the cache file */
+    HANDLE file = CreateFileW(cache_path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING,
+                              FILE_ATTRIBUTE_NORMAL, NULL);
+    ASSERT(file != INVALID_HANDLE_VALUE);
+    CloseHandle(file);
+    
+    ASSERT_OK(qalam_dwrite_init());
+    ASSERT_OK(qalam_dwrite_font_preload_start(&options, &preload));
+    ASSERT_OK(qalam_dwrite_font_preload_wait(preload, &format));
+    ASSERT_OK(qalam_dwrite_text_format_get_family_name(format, name, 64));
+    ASSERT(wcscmp(name, L"Segoe UI") == 0);
+    qalam_dwrite_font_preload_destroy(preload);
+    qalam_dwrite_text_format_destroy(format);
+    
+    /* Started without DirectWrite, or with a size of zero */
+    preload = NULL;
+    options.size = 0.0f;
+    ASSERT_EQ(QALAM_ERROR_INVALID_ARGUMENT, qalam_dwrite_font_preload_start(&options, &preload));
+    ASSERT(preload == NULL);
+    qalam_dwrite_shutdown();
+    ASSERT_EQ(QALAM_ERROR_NOT_INITIALIZED, qalam_dwrite_font_preload_start(NULL, &preload));
+    qalam_dwrite_font_preload_destroy(NULL);
+    
+    DeleteFileW(cache_path);
+    
+    TEST_PASSED();
+}
+
 /*=============================================================================
  * Test Cases: Text Layout Creation
  *============================================================================*/
@@ -691,6 +769,743 @@ TEST(hit_test_rtl) {
     TEST_PASSED();
 }
 
+/*=============================================================================
+ * Test Cases: Layout Cache
+ *============================================================================*/
+
+/**
+ * @brief Test layout reuse, generation lookup and budgeted eviction
+ */
+TEST(layout_cache) {
+    QalamResult result;
+    QalamDWriteTextFormat* format = NULL;
+    QalamDWriteLayoutCache* cache = NULL;
+    QalamDWriteTextLayout* first = NULL;
+    QalamDWriteTextLayout* layout = NULL;
+    QalamDWriteLayoutCacheStats stats;
+    const wchar_t* text = L"مرحبا بالعالم";
+    
+    /* Initialize */
+    result = qalam_dwrite_init();
+    ASSERT_OK(result);
+    
+    result = qalam_dwrite_text_format_create_arabic(L"Segoe UI", 14.0f, &format);
+    ASSERT_OK(result);
+    
+    result = qalam_dwrite_layout_cache_create(64 * 1024, &cache);
+    ASSERT_OK(result);
+    
+    QalamDWriteLayoutKey key = {
+        .format = format,
+        .max_width = 1000.0f,
+        .max_height = 100.0f,
+        .dpi = 96.0f,
+        .generation = 0
+    };
+    
+    /* The same text and key return the same layout */
+    result = qalam_dwrite_layout_cache_get(cache, text, (uint32_t)wcslen(text), &key, &first);
+    ASSERT_OK(result);
+    ASSERT_NOT_NULL(first);
+    result = qalam_dwrite_layout_cache_get(cache, text, (uint32_t)wcslen(text), &key, &layout);
+    ASSERT_OK(result);
+    ASSERT(layout == first);
+    
+    qalam_dwrite_layout_cache_get_stats(cache, &stats);
+    ASSERT_EQ(1, stats.entry_count);
+    ASSERT_EQ(1, stats.hits);
+    ASSERT_EQ(1, stats.misses);
+    
+    /* A different layout box is a different layout */
+    key.max_width = 500.0f;
+    result = qalam_dwrite_layout_cache_get(cache, text, (uint32_t)wcslen(text), &key, &layout);
+    ASSERT_OK(result);
+    ASSERT(layout != first);
+    key.max_width = 1000.0f;
+    
+    /* Tagged layouts are found by generation alone */
+    key.generation = 42;
+    result = qalam_dwrite_layout_cache_get(cache, text, (uint32_t)wcslen(text), &key, &layout);
+    ASSERT_OK(result);
+    ASSERT(layout == first);
+    ASSERT(qalam_dwrite_layout_cache_find(cache, &key) == first);
+    key.generation = 43;
+    ASSERT(qalam_dwrite_layout_cache_find(cache, &key) == NULL);
+    
+    /* Lines with the same text share a layout under each generation */
+    result = qalam_dwrite_layout_cache_get(cache, text, (uint32_t)wcslen(text), &key, &layout);
+    ASSERT_OK(result);
+    ASSERT(qalam_dwrite_layout_cache_find(cache, &key) == first);
+    key.generation = 42;
+    ASSERT(qalam_dwrite_layout_cache_find(cache, &key) == first);
+    key.generation = 0;
+    
+    /* Layouts of the current frame survive going over budget */
+    wchar_t line[128];
+    for (int i = 0; i < 100; i++) {
+        swprintf(line, 128, L"سطر رقم %d من النص العربي الطويل", i);
+        result = qalam_dwrite_layout_cache_get(cache, line, (uint32_t)wcslen(line), &key, &layout);
+        ASSERT_OK(result);
+    }
+    qalam_dwrite_layout_cache_get_stats(cache, &stats);
+    ASSERT_EQ(102, stats.entry_count);
+    ASSERT(stats.bytes_used > stats.byte_budget);
+    ASSERT_EQ(0, stats.evictions);
+    
+    /* The next frame trims back to the budget, oldest first */
+    qalam_dwrite_layout_cache_begin_frame(cache);
+    qalam_dwrite_layout_cache_get_stats(cache, &stats);
+    ASSERT(stats.bytes_used <= stats.byte_budget);
+    ASSERT(stats.evictions > 0);
+    
+    uint64_t misses = stats.misses;
+    result = qalam_dwrite_layout_cache_get(cache, line, (uint32_t)wcslen(line), &key, &layout);
+    ASSERT_OK(result);
+    result = qalam_dwrite_layout_cache_get(cache, text, (uint32_t)wcslen(text), &key, &layout);
+    ASSERT_OK(result);
+    qalam_dwrite_layout_cache_get_stats(cache, &stats);
+    ASSERT_EQ(misses + 1, stats.misses);
+    
+    /* Clearing releases everything */
+    qalam_dwrite_layout_cache_clear(cache);
+    qalam_dwrite_layout_cache_get_stats(cache, &stats);
+    ASSERT_EQ(0, stats.entry_count);
+    ASSERT_EQ(0, stats.bytes_used);
+    
+    /* Cleanup */
+    qalam_dwrite_layout_cache_destroy(cache);
+    qalam_dwrite_text_format_destroy(format);
+    qalam_dwrite_shutdown();
+    
+    TEST_PASSED();
+}
+
+/**
+ * @brief Test that cached layouts share shaped runs and an edit reshapes one run
+ */
+TEST(glyph_run_cache) {
+    QalamResult result;
+    QalamDWriteTextFormat* format = NULL;
+    QalamDWriteLayoutCache* cache = NULL;
+    QalamDWriteTextLayout* layout = NULL;
+    QalamDWriteLayoutCacheStats stats;
+    QalamDWriteTextMetrics metrics;
+    QalamDWriteHitTestResult hit;
+    float x = 0.0f;
+    float y = 0.0f;
+    wchar_t line[128];
+    
+    /* Twenty distinct five-character words: long enough for three runs */
+    uint32_t length = 0;
+    for (int i = 0; i < 20; i++) {
+        line[length++] = L'ك';
+        line[length++] = L'ل';
+        line[length++] = L'م';
+        line[length++] = (wchar_t)(L'ب' + i % 18);
+        line[length++] = L' ';
+    }
+    line[length] = L'\0';
+    
+    result = qalam_dwrite_init();
+    ASSERT_OK(result);
+    
+    result = qalam_dwrite_text_format_create_arabic(L"Segoe UI", 14.0f, &format);
+    ASSERT_OK(result);
+    
+    result = qalam_dwrite_layout_cache_create(0, &cache);
+    ASSERT_OK(result);
+    
+    QalamDWriteLayoutKey key = {
+        .format = format,
+        .max_width = 2000.0f,
+        .max_height = 100.0f,
+        .dpi = 96.0f,
+        .generation = 0
+    };
+    
+    result = qalam_dwrite_layout_cache_get(cache, line, length, &key, &layout);
+    ASSERT_OK(result);
+    ASSERT_NOT_NULL(layout);
+    qalam_dwrite_layout_cache_get_stats(cache, &stats);
+    ASSERT_EQ(0, stats.fallbacks);
+    ASSERT_EQ(3, stats.runs_shaped);
+    ASSERT_EQ(3, stats.run_count);
+    
+    result = qalam_dwrite_text_layout_get_metrics(layout, &metrics);
+    ASSERT_OK(result);
+    ASSERT_EQ(1, metrics.line_count);
+    ASSERT(metrics.width > 0.0f);
+    ASSERT(metrics.height > 0.0f);
+    
+    /* Shaped layouts can still be hit tested */
+    result = qalam_dwrite_text_layout_hit_test_position(layout, 3, false, &x, &y, &hit);
+    ASSERT_OK(result);
+    
+    /* Changing one letter of a middle word reshapes only its run */
+    line[50] = L'م';
+    result = qalam_dwrite_layout_cache_get(cache, line, length, &key, &layout);
+    ASSERT_OK(result);
+    qalam_dwrite_layout_cache_get_stats(cache, &stats);
+    ASSERT_EQ(2, stats.entry_count);
+    ASSERT_EQ(4, stats.runs_shaped);
+    ASSERT_EQ(2, stats.runs_reused);
+    ASSERT_EQ(4, stats.run_count);
+    
+    /* Mixed-direction text is split at the script and bidi level changes */
+    uint64_t shaped = stats.runs_shaped;
+    const wchar_t* mixed = L"مرحبا Qalam بالعالم";
+    result = qalam_dwrite_layout_cache_get(cache, mixed, (uint32_t)wcslen(mixed), &key, &layout);
+    ASSERT_OK(result);
+    qalam_dwrite_layout_cache_get_stats(cache, &stats);
+    ASSERT_EQ(shaped + 3, stats.runs_shaped);
+    ASSERT_EQ(0, stats.fallbacks);
+    
+    /* Tabs need tab stops, so such lines use a full text layout */
+    const wchar_t* tabbed = L"\tكلمة";
+    result = qalam_dwrite_layout_cache_get(cache, tabbed, (uint32_t)wcslen(tabbed), &key, &layout);
+    ASSERT_OK(result);
+    ASSERT_NOT_NULL(layout);
+    qalam_dwrite_layout_cache_get_stats(cache, &stats);
+    ASSERT_EQ(1, stats.fallbacks);
+    
+    /* Runs are freed with the last layout holding them */
+    qalam_dwrite_layout_cache_clear(cache);
+    qalam_dwrite_layout_cache_get_stats(cache, &stats);
+    ASSERT_EQ(0, stats.run_count);
+    ASSERT_EQ(0, stats.bytes_used);
+    
+    /* Cleanup */
+    qalam_dwrite_layout_cache_destroy(cache);
+    qalam_dwrite_text_format_destroy(format);
+    qalam_dwrite_shutdown();
+    
+    TEST_PASSED();
+}
+
+/**
+ * @brief Test that style ranges restyle a layout without reshaping it
+ */
+TEST(layout_styles) {
+    QalamResult result;
+    QalamDWriteTextFormat* format = NULL;
+    QalamDWriteLayoutCache* cache = NULL;
+    QalamDWriteTextLayout* layout = NULL;
+    QalamDWriteLayoutCacheStats stats;
+    QalamDWriteBrush* brushes[QALAM_SYNTAX_STYLE_COUNT] = { NULL };
+    
+    result = qalam_dwrite_init();
+    ASSERT_OK(result);
+    
+    result = qalam_dwrite_text_format_create_arabic(L"Segoe UI", 14.0f, &format);
+    ASSERT_OK(result);
+    
+    result = qalam_dwrite_layout_cache_create(0, &cache);
+    ASSERT_OK(result);
+    
+    QalamDWriteLayoutKey key = {
+        .format = format,
+        .max_width = 2000.0f,
+        .max_height = 100.0f,
+        .dpi = 96.0f,
+        .generation = 0
+    };
+    
+    const wchar_t* line = L"صحيح س = ١٢ // تعليق";
+    uint32_t length = (uint32_t)wcslen(line);
+    result = qalam_dwrite_layout_cache_get(cache, line, length, &key, &layout);
+    ASSERT_OK(result);
+    qalam_dwrite_layout_cache_get_stats(cache, &stats);
+    uint64_t shaped = stats.runs_shaped;
+    
+    /* The last range runs past the text and is clamped to it */
+    QalamStyleRange ranges[] = {
+        { 0, 4, QALAM_SYNTAX_TYPE },
+        { 7, 1, QALAM_SYNTAX_OPERATOR },
+        { 9, 2, QALAM_SYNTAX_NUMBER },
+        { 12, 100, QALAM_SYNTAX_COMMENT },
+        { 200, 4, QALAM_SYNTAX_STRING },
+    };
+    result = qalam_dwrite_text_layout_set_styles(layout, ranges, 5, brushes,
+                                                 QALAM_SYNTAX_STYLE_COUNT);
+    ASSERT_OK(result);
+    result = qalam_dwrite_text_layout_set_styles(layout, ranges, 5, brushes,
+                                                 QALAM_SYNTAX_STYLE_COUNT);
+    ASSERT_OK(result);
+    
+    /* Restyling keeps the cached layout and its glyphs */
+    QalamDWriteTextLayout* again = NULL;
+    result = qalam_dwrite_layout_cache_get(cache, line, length, &key, &again);
+    ASSERT_OK(result);
+    ASSERT(again == layout);
+    qalam_dwrite_layout_cache_get_stats(cache, &stats);
+    ASSERT_EQ(shaped, stats.runs_shaped);
+    
+    result = qalam_dwrite_text_layout_set_styles(layout, NULL, 0, NULL, 0);
+    ASSERT_OK(result);
+    
+    /* Full text layouts take the ranges as drawing effects */
+    const wchar_t* tabbed = L"\tإذا";
+    result = qalam_dwrite_layout_cache_get(cache, tabbed, (uint32_t)wcslen(tabbed), &key, &layout);
+    ASSERT_OK(result);
+    result = qalam_dwrite_text_layout_set_styles(layout, ranges, 1, brushes,
+                                                 QALAM_SYNTAX_STYLE_COUNT);
+    ASSERT_OK(result);
+    
+    result = qalam_dwrite_text_layout_set_styles(NULL, ranges, 1, brushes, 1);
+    ASSERT_EQ(QALAM_ERROR_NULL_POINTER, result);
+    result = qalam_dwrite_text_layout_set_styles(layout, NULL, 1, brushes, 1);
+    ASSERT_EQ(QALAM_ERROR_NULL_POINTER, result);
+    
+    /* Cleanup */
+    qalam_dwrite_layout_cache_destroy(cache);
+    qalam_dwrite_text_format_destroy(format);
+    qalam_dwrite_shutdown();
+    
+    TEST_PASSED();
+}
+
+/*=============================================================================
+ * Test Cases: Editor View
+ *============================================================================*/
+
+/**
+ * @brief Change callback that keeps an editor view anchored
+ */
+static void on_view_buffer_change(const QalamBuffer* buffer, const QalamBufferChange* change,
+                                  void* user_data) {
+    (void)buffer;
+    editor_view_on_buffer_change((EditorView*)user_data, change);
+}
+
+TEST(caret_stops) {
+    QalamResult result;
+    QalamDWriteTextFormat* format = NULL;
+    QalamDWriteLayoutCache* cache = NULL;
+    QalamDWriteTextLayout* layout = NULL;
+    QalamBuffer* buffer = NULL;
+    EditorView* view = NULL;
+    QalamCursor cursor;
+    const QalamDWriteCaretStop* logical = NULL;
+    const QalamDWriteCaretStop* visual = NULL;
+    QalamDWriteSpan spans[4];
+    uint32_t count = 0;
+    uint32_t position = 0;
+    float x = 0.0f;
+    float y = 0.0f;
+    size_t line = 0;
+    size_t column = 0;
+    
+    /* Right-to-left line: the Latin word sits on the left */
+    const wchar_t* mixed = L"سلم abc";
+    
+    result = qalam_dwrite_init();
+    ASSERT_OK(result);
+    
+    result = qalam_dwrite_text_format_create_arabic(L"Segoe UI", 14.0f, &format);
+    ASSERT_OK(result);
+    ASSERT(qalam_dwrite_text_format_is_rtl(format));
+    
+    result = qalam_dwrite_layout_cache_create(0, &cache);
+    ASSERT_OK(result);
+    
+    QalamDWriteLayoutKey key = {
+        .format = format,
+        .max_width = 200.0f,
+        .max_height = 100.0f,
+        .dpi = 96.0f,
+        .generation = 0
+    };
+    
+    result = qalam_dwrite_layout_cache_get(cache, mixed, (uint32_t)wcslen(mixed), &key, &layout);
+    ASSERT_OK(result);
+    
+    result = qalam_dwrite_text_layout_get_caret_stops(layout, &logical, &visual, &count);
+    ASSERT_OK(result);
+    ASSERT_EQ(8, count);
+    for (uint32_t i = 1; i < count; i++) {
+        ASSERT(logical[i - 1].text_position < logical[i].text_position);
+        ASSERT(visual[i - 1].x < visual[i].x);
+    }
+    
+    /* The first Arabic letter starts at the right edge */
+    result = qalam_dwrite_text_layout_caret_x(layout, 0, &x);
+    ASSERT_OK(result);
+    ASSERT_EQ(visual[count - 1].x, x);
+    ASSERT_EQ(0, visual[count - 1].text_position);
+    
+    /* Moving left runs through the Arabic word, then the Latin word */
+    result = qalam_dwrite_text_layout_caret_move(layout, 0, -1, &position);
+    ASSERT_OK(result);
+    ASSERT_EQ(1, position);
+    result = qalam_dwrite_text_layout_caret_move(layout, 5, -1, &position);
+    ASSERT_OK(result);
+    ASSERT_EQ(4, position);
+    result = qalam_dwrite_text_layout_caret_move(layout, 4, -1, &position);
+    ASSERT_OK(result);
+    ASSERT_EQ(4, position);
+    result = qalam_dwrite_text_layout_caret_move(layout, 0, 1, &position);
+    ASSERT_OK(result);
+    ASSERT_EQ(0, position);
+    
+    result = qalam_dwrite_text_layout_caret_at(layout, visual[1].x + 1.0f, &position);
+    ASSERT_OK(result);
+    ASSERT_EQ(5, position);
+    result = qalam_dwrite_text_layout_caret_at(layout, -1000.0f, &position);
+    ASSERT_OK(result);
+    ASSERT_EQ(4, position);
+    
+    /* A range across the direction change covers two separate spans */
+    result = qalam_dwrite_text_layout_get_range_spans(layout, 2, 5, spans, 4, &count);
+    ASSERT_OK(result);
+    ASSERT_EQ(2, count);
+    ASSERT(spans[0].right < spans[1].left);
+    result = qalam_dwrite_text_layout_get_range_spans(layout, 2, 5, NULL, 0, &count);
+    ASSERT_OK(result);
+    ASSERT_EQ(2, count);
+    
+    float stop_x = visual[1].x;
+    qalam_dwrite_layout_cache_destroy(cache);
+    
+    /* Layouts made by DirectWrite itself build the table by hit testing */
+    result = qalam_dwrite_text_layout_create(L"\tab", 3, format, 200.0f, 100.0f, &layout);
+    ASSERT_OK(result);
+    result = qalam_dwrite_text_layout_get_caret_stops(layout, NULL, NULL, &count);
+    ASSERT_OK(result);
+    ASSERT_EQ(4, count);
+    result = qalam_dwrite_text_layout_caret_at(layout, 1000.0f, &position);
+    ASSERT_OK(result);
+    qalam_dwrite_text_layout_destroy(layout);
+    
+    /* The editor view moves its cursor by the same stops */
+    result = qalam_buffer_create_from_text(&buffer, "سلم abc\nxyz", strlen("سلم abc\nxyz"));
+    ASSERT_OK(result);
+    
+    result = editor_view_create(&view, format, NULL);
+    ASSERT_OK(result);
+    editor_view_set_buffer(view, buffer);
+    result = editor_view_resize(view, 216.0f, 400.0f, 96.0f);
+    ASSERT_OK(result);
+    
+    qalam_buffer_set_cursor(buffer, 0, 0);
+    result = editor_view_get_caret_point(view, &x, &y);
+    ASSERT_OK(result);
+    ASSERT_EQ(208.0f, x);
+    
+    result = editor_view_move_cursor_visual(view, -1);
+    ASSERT_OK(result);
+    qalam_buffer_get_cursor(buffer, &cursor);
+    ASSERT_EQ(0, cursor.line);
+    ASSERT_EQ(1, cursor.column);
+    
+    /* Past the left edge of a right-to-left line is the next line */
+    qalam_buffer_set_cursor(buffer, 0, 4);
+    result = editor_view_move_cursor_visual(view, -1);
+    ASSERT_OK(result);
+    qalam_buffer_get_cursor(buffer, &cursor);
+    ASSERT_EQ(1, cursor.line);
+    ASSERT_EQ(0, cursor.column);
+    
+    result = editor_view_hit_test(view, 8.0f + stop_x + 1.0f, y + 1.0f, &line, &column);
+    ASSERT_OK(result);
+    ASSERT_EQ(0, line);
+    ASSERT_EQ(5, column);
+    
+    editor_view_destroy(view);
+    qalam_buffer_destroy(buffer);
+    qalam_dwrite_text_format_destroy(format);
+    qalam_dwrite_shutdown();
+    
+    TEST_PASSED();
+}
+
+TEST(editor_view_virtualized) {
+    QalamResult result;
+    QalamDWriteTextFormat* format = NULL;
+    QalamBuffer* buffer = NULL;
+    EditorView* view = NULL;
+    EditorViewOptions options;
+    EditorViewStats stats;
+    QalamLineInfo info;
+    float offset = 0.0f;
+    
+    /* A large buffer of short Arabic lines */
+    const size_t line_total = 200000;
+    const char* word = "سطر\n";
+    size_t word_len = strlen(word);
+    char* text = (char*)malloc(line_total * word_len);
+    ASSERT_NOT_NULL(text);
+    for (size_t i = 0; i < line_total; i++) {
+        memcpy(text + i * word_len, word, word_len);
+    }
+    result = qalam_buffer_create_from_text(&buffer, text, line_total * word_len);
+    free(text);
+    ASSERT_OK(result);
+    ASSERT_EQ(line_total + 1, qalam_buffer_get_line_count(buffer));
+    
+    result = qalam_dwrite_init();
+    ASSERT_OK(result);
+    
+    result = qalam_dwrite_text_format_create_arabic(L"Segoe UI", 14.0f, &format);
+    ASSERT_OK(result);
+    
+    editor_view_get_default_options(&options);
+    options.line_height = 20.0f;
+    options.padding_top = 0.0f;
+    result = editor_view_create(&view, format, &options);
+    ASSERT_OK(result);
+    editor_view_set_buffer(view, buffer);
+    result = editor_view_resize(view, 800.0f, 600.0f, 96.0f);
+    ASSERT_OK(result);
+    qalam_buffer_set_change_callback(buffer, on_view_buffer_change, view);
+    
+    /* Only the viewport and the overscan below it are laid out */
+    result = editor_view_layout(view);
+    ASSERT_OK(result);
+    editor_view_get_stats(view, &stats);
+    ASSERT_EQ(0, stats.first_line);
+    ASSERT_EQ(30, stats.visible_lines);
+    ASSERT_EQ(30 + EDITOR_VIEW_DEFAULT_OVERSCAN, stats.lines_laid_out);
+    ASSERT_EQ(30 + EDITOR_VIEW_DEFAULT_OVERSCAN, stats.lines_fetched);
+    
+    /* Unchanged lines are found by generation without reading the buffer */
+    result = editor_view_layout(view);
+    ASSERT_OK(result);
+    editor_view_get_stats(view, &stats);
+    ASSERT_EQ(0, stats.lines_fetched);
+    
+    /* Scrolling ten lines fetches only the lines that came into range */
+    editor_view_scroll_by(view, 10 * 20.0f + 5.0f);
+    ASSERT_EQ(10, editor_view_get_anchor_line(view, &offset));
+    ASSERT(offset == 5.0f);
+    ASSERT_EQ(12, editor_view_line_at(view, 50.0f));
+    result = editor_view_layout(view);
+    ASSERT_OK(result);
+    editor_view_get_stats(view, &stats);
+    ASSERT_EQ(31, stats.visible_lines);
+    ASSERT_EQ(31 + 2 * EDITOR_VIEW_DEFAULT_OVERSCAN, stats.lines_laid_out);
+    ASSERT_EQ(11, stats.lines_fetched);
+    
+    /* Deep in the file the frame does the same amount of work */
+    editor_view_scroll_to_line(view, 150000);
+    result = editor_view_layout(view);
+    ASSERT_OK(result);
+    editor_view_get_stats(view, &stats);
+    ASSERT_EQ(150000, stats.first_line);
+    ASSERT_EQ(30, stats.visible_lines);
+    ASSERT_EQ(30 + 2 * EDITOR_VIEW_DEFAULT_OVERSCAN, stats.lines_laid_out);
+    
+    /* An edit in view refetches just the edited line */
+    result = qalam_buffer_get_line_info(buffer, 150005, &info);
+    ASSERT_OK(result);
+    result = qalam_buffer_insert_at(buffer, info.start_offset, "جديد ", strlen("جديد "));
+    ASSERT_OK(result);
+    result = editor_view_layout(view);
+    ASSERT_OK(result);
+    editor_view_get_stats(view, &stats);
+    ASSERT_EQ(1, stats.lines_fetched);
+    
+    /* Lines inserted above the anchor keep the same text at the top */
+    result = qalam_buffer_insert_at(buffer, 0, "\n\n", 2);
+    ASSERT_OK(result);
+    ASSERT_EQ(150002, editor_view_get_anchor_line(view, NULL));
+    result = editor_view_layout(view);
+    ASSERT_OK(result);
+    editor_view_get_stats(view, &stats);
+    ASSERT_EQ(0, stats.lines_fetched);
+    
+    /* Scrolling is clamped to the buffer */
+    editor_view_scroll_by(view, 1.0e9f);
+    ASSERT_EQ(qalam_buffer_get_line_count(buffer) - 1, editor_view_get_anchor_line(view, NULL));
+    result = editor_view_layout(view);
+    ASSERT_OK(result);
+    editor_view_get_stats(view, &stats);
+    ASSERT_EQ(1, stats.visible_lines);
+    editor_view_scroll_by(view, -1.0e9f);
+    ASSERT_EQ(0, editor_view_get_anchor_line(view, &offset));
+    ASSERT(offset == 0.0f);
+    
+    /* Cleanup */
+    qalam_buffer_set_change_callback(buffer, NULL, NULL);
+    editor_view_destroy(view);
+    qalam_buffer_destroy(buffer);
+    qalam_dwrite_text_format_destroy(format);
+    qalam_dwrite_shutdown();
+    
+    TEST_PASSED();
+}
+
+TEST(editor_view_dirty_rects) {
+    QalamResult result;
+    QalamDWriteTextFormat* format = NULL;
+    QalamBuffer* buffer = NULL;
+    EditorView* view = NULL;
+    EditorViewOptions options;
+    QalamLineInfo info;
+    QalamRect rects[EDITOR_VIEW_MAX_DIRTY_RECTS];
+    
+    result = qalam_buffer_create(&buffer);
+    ASSERT_OK(result);
+    for (int i = 0; i < 100; i++) {
+        result = qalam_buffer_insert(buffer, "سطر\n", strlen("سطر\n"));
+        ASSERT_OK(result);
+    }
+    
+    result = qalam_dwrite_init();
+    ASSERT_OK(result);
+    
+    result = qalam_dwrite_text_format_create_arabic(L"Segoe UI", 14.0f, &format);
+    ASSERT_OK(result);
+    
+    editor_view_get_default_options(&options);
+    options.line_height = 20.0f;
+    options.padding_top = 0.0f;
+    result = editor_view_create(&view, format, &options);
+    ASSERT_OK(result);
+    editor_view_set_buffer(view, buffer);
+    result = editor_view_resize(view, 800.0f, 600.0f, 96.0f);
+    ASSERT_OK(result);
+    qalam_buffer_set_change_callback(buffer, on_view_buffer_change, view);
+    
+    /* A new buffer or size redraws the whole viewport */
+    ASSERT_EQ(1, editor_view_get_dirty_rects(view, rects, EDITOR_VIEW_MAX_DIRTY_RECTS));
+    ASSERT(rects[0].top == 0.0f && rects[0].bottom == 600.0f);
+    editor_view_submit_dirty_rects(view, NULL);
+    ASSERT_EQ(0, editor_view_get_dirty_rects(view, NULL, 0));
+    
+    /* Typing in a line redraws that line only */
+    result = qalam_buffer_get_line_info(buffer, 5, &info);
+    ASSERT_OK(result);
+    result = qalam_buffer_insert_at(buffer, info.start_offset, "ب", strlen("ب"));
+    ASSERT_OK(result);
+    ASSERT_EQ(1, editor_view_get_dirty_rects(view, rects, EDITOR_VIEW_MAX_DIRTY_RECTS));
+    ASSERT(rects[0].top == 100.0f && rects[0].bottom == 120.0f);
+    ASSERT(rects[0].left == 0.0f && rects[0].right == 800.0f);
+    
+    /* A new line moves every row below it */
+    result = qalam_buffer_get_line_info(buffer, 7, &info);
+    ASSERT_OK(result);
+    result = qalam_buffer_insert_at(buffer, info.start_offset, "\n", 1);
+    ASSERT_OK(result);
+    ASSERT_EQ(2, editor_view_get_dirty_rects(view, rects, EDITOR_VIEW_MAX_DIRTY_RECTS));
+    editor_view_submit_dirty_rects(view, NULL);
+    
+    /* The caret moving within a line, then onto the one before */
+    qalam_buffer_set_cursor(buffer, 3, 0);
+    result = editor_view_move_cursor_visual(view, -1);
+    ASSERT_OK(result);
+    ASSERT_EQ(1, editor_view_get_dirty_rects(view, rects, EDITOR_VIEW_MAX_DIRTY_RECTS));
+    ASSERT(rects[0].top == 60.0f && rects[0].bottom == 80.0f);
+    editor_view_submit_dirty_rects(view, NULL);
+    
+    qalam_buffer_set_cursor(buffer, 10, 0);
+    result = editor_view_move_cursor_visual(view, 1);
+    ASSERT_OK(result);
+    ASSERT_EQ(1, editor_view_get_dirty_rects(view, rects, EDITOR_VIEW_MAX_DIRTY_RECTS));
+    ASSERT(rects[0].top == 180.0f && rects[0].bottom == 220.0f);
+    editor_view_submit_dirty_rects(view, NULL);
+    
+    /* Distant lines stay separate rects */
+    editor_view_invalidate_lines(view, 1, 1);
+    editor_view_invalidate_lines(view, 20, 1);
+    ASSERT_EQ(2, editor_view_get_dirty_rects(view, NULL, 0));
+    editor_view_submit_dirty_rects(view, NULL);
+    
+    /* Edits above the viewport leave it untouched */
+    editor_view_scroll_to_line(view, 50);
+    editor_view_submit_dirty_rects(view, NULL);
+    result = qalam_buffer_get_line_info(buffer, 2, &info);
+    ASSERT_OK(result);
+    result = qalam_buffer_insert_at(buffer, info.start_offset, "\n", 1);
+    ASSERT_OK(result);
+    ASSERT_EQ(51, editor_view_get_anchor_line(view, NULL));
+    ASSERT_EQ(0, editor_view_get_dirty_rects(view, NULL, 0));
+    
+    /* Cleanup */
+    qalam_buffer_set_change_callback(buffer, NULL, NULL);
+    editor_view_destroy(view);
+    qalam_buffer_destroy(buffer);
+    qalam_dwrite_text_format_destroy(format);
+    qalam_dwrite_shutdown();
+    
+    TEST_PASSED();
+}
+
+/*=============================================================================
+ * Test Cases: Frame Scheduler
+ *============================================================================*/
+
+static void on_count_change(const QalamBuffer* buffer, const QalamBufferChange* change,
+                            void* user_data) {
+    (void)buffer;
+    (void)change;
+    (*(int*)user_data)++;
+}
+
+/**
+ * @brief Test that typed characters reach the buffer as one insert
+ */
+TEST(frame_scheduler_input) {
+    QalamResult result;
+    QalamBuffer* buffer = NULL;
+    FrameScheduler* scheduler = NULL;
+    FrameSchedulerStats stats;
+    char content[64];
+    size_t written = 0;
+    int changes = 0;
+    const uint32_t typed[] = { 0x0633, 0x0644, 0x0627, 0x0645, '\r', 0xD83D, 0xDE00, 'a' };
+    const char* expected = "سلام\n\xF0\x9F\x98\x80" "a";
+    
+    result = qalam_buffer_create(&buffer);
+    ASSERT_OK(result);
+    qalam_buffer_set_change_callback(buffer, on_count_change, &changes);
+    
+    result = frame_scheduler_create(&scheduler, NULL, NULL);
+    ASSERT_OK(result);
+    result = frame_scheduler_set_buffer(scheduler, buffer);
+    ASSERT_OK(result);
+    
+    /* A burst of characters is queued, not inserted */
+    for (size_t i = 0; i < sizeof(typed) / sizeof(typed[0]); i++) {
+        ASSERT(frame_scheduler_queue_char(scheduler, typed[i]));
+    }
+    ASSERT(!frame_scheduler_queue_char(scheduler, 0x08));
+    ASSERT(!frame_scheduler_queue_char(scheduler, 0xDE00));
+    ASSERT_EQ(strlen(expected), frame_scheduler_get_queued_bytes(scheduler));
+    ASSERT_EQ(0, changes);
+    
+    /* ...and applied as one change and one undo step */
+    result = frame_scheduler_flush_input(scheduler);
+    ASSERT_OK(result);
+    ASSERT_EQ(1, changes);
+    ASSERT(frame_scheduler_is_dirty(scheduler));
+    ASSERT_EQ(0, frame_scheduler_get_queued_bytes(scheduler));
+    result = qalam_buffer_get_content(buffer, content, sizeof(content), &written);
+    ASSERT_OK(result);
+    ASSERT_EQ(strlen(expected), written);
+    ASSERT(memcmp(content, expected, written) == 0);
+    
+    result = qalam_buffer_undo(buffer);
+    ASSERT_OK(result);
+    ASSERT(!qalam_buffer_can_undo(buffer));
+    
+    /* Text still queued when the loop quits is inserted before it returns */
+    ASSERT(frame_scheduler_queue_char(scheduler, 'x'));
+    PostQuitMessage(3);
+    ASSERT_EQ(3, frame_scheduler_run(scheduler));
+    ASSERT_EQ(0, frame_scheduler_get_queued_bytes(scheduler));
+    
+    frame_scheduler_get_stats(scheduler, &stats);
+    ASSERT_EQ(8, stats.chars_queued);
+    ASSERT_EQ(2, stats.inserts);
+    
+    /* Cleanup */
+    qalam_buffer_set_change_callback(buffer, NULL, NULL);
+    frame_scheduler_destroy(scheduler);
+    qalam_buffer_destroy(buffer);
+    
+    TEST_PASSED();
+}
+
 /*=============================================================================
  * Test Cases: Color Utilities
  *============================================================================*/
@@ -761,6 +1576,15 @@ TEST(null_pointer_handling) {
     result = qalam_dwrite_text_format_create(&null_params, &format);
     ASSERT_EQ(QALAM_ERROR_NULL_POINTER, result);
     
+    /* Glyph atlas without a render target */
+    QalamDWriteGlyphAtlas* atlas = NULL;
+    result = qalam_dwrite_glyph_atlas_create(NULL, NULL, &atlas);
+    ASSERT_EQ(QALAM_ERROR_NULL_POINTER, result);
+    ASSERT(atlas == NULL);
+    qalam_dwrite_glyph_atlas_destroy(NULL);
+    ASSERT(!qalam_dwrite_glyph_atlas_draw_cluster(NULL, L"\x0633", 1, 1, true, 0, 0.0f, 0.0f, NULL));
+    ASSERT(qalam_dwrite_render_is_full_frame(NULL));
+    
     /* Cleanup */
     qalam_dwrite_shutdown();
     
@@ -783,6 +1607,7 @@ void run_format_tests(void) {
     RUN_TEST(text_format_create);
     RUN_TEST(arabic_text_format_create);
     RUN_TEST(text_format_weights);
+    RUN_TEST(font_preload);
 }
 
 void run_layout_tests(void) {
@@ -805,6 +1630,21 @@ void run_hit_test_tests(void) {
     RUN_TEST(hit_test_rtl);
 }
 
+void run_layout_cache_tests(void) {
+    printf("\n=== Layout Cache Tests ===\n");
+    RUN_TEST(layout_cache);
+    RUN_TEST(glyph_run_cache);
+    RUN_TEST(layout_styles);
+    RUN_TEST(caret_stops);
+}
+
+void run_editor_view_tests(void) {
+    printf("\n=== Editor View Tests ===\n");
+    RUN_TEST(editor_view_virtualized);
+    RUN_TEST(editor_view_dirty_rects);
+    RUN_TEST(frame_scheduler_input);
+}
+
 void run_utility_tests(void) {
     printf("\n=== Utility Tests ===\n");
     RUN_TEST(color_utilities);
@@ -830,6 +1670,8 @@ int main(void) {
     run_layout_tests();
     run_measurement_tests();
     run_hit_test_tests();
+    run_layout_cache_tests();
+    run_editor_view_tests();
     run_utility_tests();
     run_error_tests();
     
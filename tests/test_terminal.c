@@ -0,0 +1,1266 @@
+/**
+ * @file test_terminal.c
+ * @brief Qalam IDE - Terminal Unit Tests
+ *
+ * Unit tests for the terminal's output path: the single-producer,
+ * single-consumer ring between the pipe reader thread and the thread
+ * that polls the terminal, and the VT parser behind it. Ring tests cover
+ * spans, wrapping, a full ring, waiting for space, and a producer and
+ * consumer running concurrently; parser tests cover text runs, controls,
+ * each kind of sequence, and input split at every byte; scrollback
+ * tests cover rows read back from hot and packed blocks, the memory
+ * budget, and search; screen tests cover wrapping, wide characters and
+ * marks, editing sequences, attributes, scrolling, the alternate screen,
+ * reflow on resize, and dirty tracking.
+ *
+ * @version 0.0.2
+ * @copyright (c) 2026 Qalam Project
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <windows.h>
+
+#include "qalam.h"
+#include "output_ring.h"
+#include "vt_parser.h"
+#include "scrollback.h"
+#include "terminal_screen.h"
+#include "text_scan.h"
+
+/*=============================================================================
+ * Test Framework Macros
+ *============================================================================*/
+
+#define TEST_ASSERT(cond) do { \
+    if (!(cond)) { \
+        printf("FAIL: %s:%d - %s\n", __FILE__, __LINE__, #cond); \
+        g_test_failures++; \
+        return 1; \
+    } \
+} while(0)
+
+#define TEST_ASSERT_EQ(expected, actual) do { \
+    if ((expected) != (actual)) { \
+        printf("FAIL: %s:%d - Expected %llu, got %llu\n", \
+               __FILE__, __LINE__, \
+               (unsigned long long)(expected), \
+               (unsigned long long)(actual)); \
+        g_test_failures++; \
+        return 1; \
+    } \
+} while(0)
+
+#define RUN_TEST(name) do { \
+    printf("  Running %s...", #name); \
+    fflush(stdout); \
+    int result = test_##name(); \
+    if (result == 0) { \
+        printf(" PASSED\n"); \
+        g_tests_passed++; \
+    } else { \
+        printf(" FAILED\n"); \
+        g_tests_failed++; \
+    } \
+    g_tests_total++; \
+} while(0)
+
+/*=============================================================================
+ * Global Test Counters
+ *============================================================================*/
+
+static int g_tests_total = 0;
+static int g_tests_passed = 0;
+static int g_tests_failed = 0;
+static int g_test_failures = 0;  /* Assertion failures within a test */
+
+/*=============================================================================
+ * Output Ring Tests
+ *============================================================================*/
+
+/**
+ * @brief Test capacity rounding and a write/read round trip
+ */
+static int test_ring_basic(void) {
+    OutputRing* ring = NULL;
+    TEST_ASSERT(output_ring_create(NULL, 0) == QALAM_ERROR_NULL_POINTER);
+    TEST_ASSERT(output_ring_create(&ring, 100) == QALAM_OK);
+    TEST_ASSERT_EQ(OUTPUT_RING_MIN_CAPACITY, output_ring_capacity(ring));
+    output_ring_destroy(ring);
+
+    TEST_ASSERT(output_ring_create(&ring, OUTPUT_RING_MIN_CAPACITY * 3) == QALAM_OK);
+    size_t capacity = output_ring_capacity(ring);
+    TEST_ASSERT_EQ(OUTPUT_RING_MIN_CAPACITY * 4, capacity);
+
+    size_t length = 0;
+    output_ring_read_span(ring, &length);
+    TEST_ASSERT_EQ(0, length);
+    TEST_ASSERT_EQ(0, output_ring_used_space(ring));
+
+    char* span = output_ring_write_span(ring, &length);
+    TEST_ASSERT(span != NULL);
+    TEST_ASSERT_EQ(capacity, length);
+    memcpy(span, "مرحبا", strlen("مرحبا"));
+    output_ring_commit(ring, strlen("مرحبا"));
+    TEST_ASSERT_EQ(strlen("مرحبا"), output_ring_used_space(ring));
+    TEST_ASSERT_EQ(capacity - strlen("مرحبا"), output_ring_free_space(ring));
+
+    const char* data = output_ring_read_span(ring, &length);
+    TEST_ASSERT_EQ(strlen("مرحبا"), length);
+    TEST_ASSERT(memcmp(data, "مرحبا", length) == 0);
+    output_ring_consume(ring, length);
+    TEST_ASSERT_EQ(0, output_ring_used_space(ring));
+    TEST_ASSERT_EQ(capacity, output_ring_free_space(ring));
+
+    output_ring_destroy(ring);
+    output_ring_destroy(NULL);
+    return 0;
+}
+
+/**
+ * @brief Test spans around the end of the ring's memory
+ */
+static int test_ring_wrap(void) {
+    OutputRing* ring = NULL;
+    TEST_ASSERT(output_ring_create(&ring, 0) == QALAM_OK);
+    size_t capacity = output_ring_capacity(ring);
+
+    /* Move both positions to 10 bytes before the end */
+    size_t length = 0;
+    output_ring_write_span(ring, &length);
+    output_ring_commit(ring, capacity - 10);
+    output_ring_read_span(ring, &length);
+    TEST_ASSERT_EQ(capacity - 10, length);
+    output_ring_consume(ring, length);
+
+    /* Free space is split: up to the end first, then from the start */
+    char* span = output_ring_write_span(ring, &length);
+    TEST_ASSERT_EQ(10, length);
+    memcpy(span, "0123456789", 10);
+    output_ring_commit(ring, 10);
+    char* start = output_ring_write_span(ring, &length);
+    TEST_ASSERT_EQ(capacity - 10, length);
+    TEST_ASSERT(start == span + 10 - capacity);
+    memcpy(start, "abcdef", 6);
+    output_ring_commit(ring, 6);
+    TEST_ASSERT_EQ(16, output_ring_used_space(ring));
+
+    /* A full drain takes two spans */
+    const char* data = output_ring_read_span(ring, &length);
+    TEST_ASSERT_EQ(10, length);
+    TEST_ASSERT(memcmp(data, "0123456789", 10) == 0);
+    output_ring_consume(ring, length);
+    data = output_ring_read_span(ring, &length);
+    TEST_ASSERT_EQ(6, length);
+    TEST_ASSERT(memcmp(data, "abcdef", 6) == 0);
+    output_ring_consume(ring, length);
+    TEST_ASSERT_EQ(0, output_ring_used_space(ring));
+
+    output_ring_destroy(ring);
+    return 0;
+}
+
+/**
+ * @brief Test a full ring and waiting for space
+ */
+static int test_ring_full(void) {
+    OutputRing* ring = NULL;
+    TEST_ASSERT(output_ring_create(&ring, 0) == QALAM_OK);
+    size_t capacity = output_ring_capacity(ring);
+
+    size_t length = 0;
+    output_ring_write_span(ring, &length);
+    output_ring_commit(ring, length);
+    TEST_ASSERT_EQ(capacity, output_ring_used_space(ring));
+    TEST_ASSERT_EQ(0, output_ring_free_space(ring));
+    output_ring_write_span(ring, &length);
+    TEST_ASSERT_EQ(0, length);
+
+    /* Full: the wait times out, or ends on the cancel event */
+    TEST_ASSERT(!output_ring_wait_space(ring, 1, NULL, 0));
+    HANDLE cancel = CreateEventW(NULL, TRUE, TRUE, NULL);
+    TEST_ASSERT(cancel != NULL);
+    TEST_ASSERT(!output_ring_wait_space(ring, 1, cancel, INFINITE));
+    CloseHandle(cancel);
+
+    /* Space already free: no wait at all */
+    output_ring_consume(ring, 4096);
+    TEST_ASSERT(output_ring_wait_space(ring, 4096, NULL, 0));
+    TEST_ASSERT(!output_ring_wait_space(ring, 4097, NULL, 0));
+
+    output_ring_destroy(ring);
+    return 0;
+}
+
+/** Bytes the stress test moves through the ring */
+#define RING_STRESS_BYTES   (32u * 1024u * 1024u)
+
+/**
+ * @brief Stress test producer: writes a counting pattern in uneven pieces
+ */
+static DWORD WINAPI ring_stress_producer(LPVOID param) {
+    OutputRing* ring = (OutputRing*)param;
+    uint32_t written = 0;
+    uint32_t piece = 1;
+
+    while (written < RING_STRESS_BYTES) {
+        if (output_ring_free_space(ring) == 0) {
+            output_ring_wait_space(ring, 1, NULL, INFINITE);
+            continue;
+        }
+
+        size_t length = 0;
+        char* span = output_ring_write_span(ring, &length);
+        piece = piece * 1103515245u + 12345u;
+        size_t chunk = 1 + (piece >> 16) % 8192;
+        if (chunk > length) {
+            chunk = length;
+        }
+        if (chunk > RING_STRESS_BYTES - written) {
+            chunk = RING_STRESS_BYTES - written;
+        }
+        for (size_t i = 0; i < chunk; i++) {
+            span[i] = (char)((written + i) % 251);
+        }
+        output_ring_commit(ring, chunk);
+        written += (uint32_t)chunk;
+    }
+    return 0;
+}
+
+/**
+ * @brief Test a producer thread and a consumer running at once
+ *
+ * The ring is much smaller than the data, so the producer keeps filling
+ * it and waiting for space.
+ */
+static int test_ring_threads(void) {
+    OutputRing* ring = NULL;
+    TEST_ASSERT(output_ring_create(&ring, 0) == QALAM_OK);
+
+    HANDLE producer = CreateThread(NULL, 0, ring_stress_producer, ring, 0, NULL);
+    TEST_ASSERT(producer != NULL);
+
+    uint32_t consumed = 0;
+    bool in_order = true;
+    while (consumed < RING_STRESS_BYTES && in_order) {
+        size_t length = 0;
+        const char* data = output_ring_read_span(ring, &length);
+        for (size_t i = 0; i < length; i++) {
+            if (data[i] != (char)((consumed + i) % 251)) {
+                in_order = false;
+                break;
+            }
+        }
+        output_ring_consume(ring, length);
+        consumed += (uint32_t)length;
+    }
+
+    WaitForSingleObject(producer, INFINITE);
+    CloseHandle(producer);
+    TEST_ASSERT(in_order);
+    TEST_ASSERT_EQ(RING_STRESS_BYTES, consumed);
+    TEST_ASSERT_EQ(0, output_ring_used_space(ring));
+
+    output_ring_destroy(ring);
+    return 0;
+}
+
+/*=============================================================================
+ * VT Parser Tests
+ *============================================================================*/
+
+/**
+ * @brief Everything a parser reported, flattened into one string
+ *
+ * Text is copied as it is; every other event is written in brackets,
+ * e.g. "[x0a]" for a control or "[csi ?1049 h]" for a sequence. Runs of
+ * printed text are also counted, to check they arrive in one piece.
+ */
+typedef struct ParseLog {
+    char text[4096];
+    size_t length;
+    size_t print_calls;
+} ParseLog;
+
+static void log_append(ParseLog* log, const char* text, size_t length) {
+    if (length > sizeof(log->text) - 1 - log->length) {
+        length = sizeof(log->text) - 1 - log->length;
+    }
+    memcpy(log->text + log->length, text, length);
+    log->length += length;
+    log->text[log->length] = '\0';
+}
+
+static void log_sequence(ParseLog* log, const char* kind, const VtSequence* sequence) {
+    char entry[256];
+    int length = snprintf(entry, sizeof(entry), "[%s %.*s", kind,
+                          (int)sequence->intermediate_count, sequence->intermediates);
+    for (size_t i = 0; i < sequence->param_count; i++) {
+        const char* separator = i == 0 ? "" : (sequence->subparams & (1u << i)) ? ":" : ";";
+        length += snprintf(entry + length, sizeof(entry) - (size_t)length, "%s%u",
+                           separator, (unsigned int)sequence->params[i]);
+    }
+    length += snprintf(entry + length, sizeof(entry) - (size_t)length, " %c]", sequence->final);
+    log_append(log, entry, (size_t)length);
+}
+
+static void on_print(void* user_data, const char* text, size_t length) {
+    ParseLog* log = (ParseLog*)user_data;
+    log->print_calls++;
+    log_append(log, text, length);
+}
+
+static void on_execute(void* user_data, unsigned char control) {
+    char entry[8];
+    int length = snprintf(entry, sizeof(entry), "[x%02x]", control);
+    log_append((ParseLog*)user_data, entry, (size_t)length);
+}
+
+static void on_esc(void* user_data, const VtSequence* sequence) {
+    log_sequence((ParseLog*)user_data, "esc", sequence);
+}
+
+static void on_csi(void* user_data, const VtSequence* sequence) {
+    log_sequence((ParseLog*)user_data, "csi", sequence);
+}
+
+static void on_osc(void* user_data, const char* data, size_t length) {
+    ParseLog* log = (ParseLog*)user_data;
+    log_append(log, "[osc ", 5);
+    log_append(log, data, length);
+    log_append(log, "]", 1);
+}
+
+static void on_osc_length(void* user_data, const char* data, size_t length) {
+    (void)data;
+    *(size_t*)user_data = length;
+}
+
+static void on_dcs_hook(void* user_data, const VtSequence* sequence) {
+    log_sequence((ParseLog*)user_data, "dcs", sequence);
+}
+
+static void on_dcs_put(void* user_data, const char* data, size_t length) {
+    log_append((ParseLog*)user_data, data, length);
+}
+
+static void on_dcs_unhook(void* user_data) {
+    log_append((ParseLog*)user_data, "[/dcs]", 6);
+}
+
+static const VtParserHandler g_log_handler = {
+    on_print, on_execute, on_esc, on_csi, on_osc, on_dcs_hook, on_dcs_put, on_dcs_unhook
+};
+
+/**
+ * @brief Parse 'input' in one call and compare the log with 'expected'
+ */
+static int check_parse(const char* input, const char* expected) {
+    ParseLog log;
+    memset(&log, 0, sizeof(log));
+    VtParser* parser = NULL;
+    TEST_ASSERT(vt_parser_create(&parser, &g_log_handler, &log) == QALAM_OK);
+    vt_parser_parse(parser, input, strlen(input));
+    vt_parser_destroy(parser);
+
+    if (strcmp(expected, log.text) != 0) {
+        printf("FAIL: Expected \"%s\", got \"%s\"\n", expected, log.text);
+        g_test_failures++;
+        return 1;
+    }
+    return 0;
+}
+
+/**
+ * @brief Test text runs and C0 controls
+ */
+static int test_vt_text(void) {
+    VtParser* parser = NULL;
+    TEST_ASSERT(vt_parser_create(NULL, &g_log_handler, NULL) == QALAM_ERROR_NULL_POINTER);
+    TEST_ASSERT(vt_parser_create(&parser, NULL, NULL) == QALAM_ERROR_NULL_POINTER);
+
+    TEST_ASSERT(check_parse("plain text", "plain text") == 0);
+    TEST_ASSERT(check_parse("سطر١\r\nline2\a\b\t", "سطر١[x0d][x0a]line2[x07][x08][x09]") == 0);
+    TEST_ASSERT(check_parse("a\x7f" "b", "ab") == 0);
+    TEST_ASSERT(check_parse("a\x18" "b\x1a", "a[x18]b[x1a]") == 0);
+
+    /* A long line of Arabic is one print call */
+    char line[2048];
+    size_t length = 0;
+    while (length + strlen("مرحبا بالعالم ") < sizeof(line) - 3) {
+        memcpy(line + length, "مرحبا بالعالم ", strlen("مرحبا بالعالم "));
+        length += strlen("مرحبا بالعالم ");
+    }
+    memcpy(line + length, "\r\n", 2);
+    length += 2;
+
+    ParseLog log;
+    memset(&log, 0, sizeof(log));
+    TEST_ASSERT(vt_parser_create(&parser, &g_log_handler, &log) == QALAM_OK);
+    vt_parser_parse(parser, line, length);
+    TEST_ASSERT_EQ(1, log.print_calls);
+    TEST_ASSERT_EQ(length - 2 + strlen("[x0d][x0a]"), log.length);
+    TEST_ASSERT(vt_parser_is_ground(parser));
+    vt_parser_destroy(parser);
+    vt_parser_destroy(NULL);
+    return 0;
+}
+
+/**
+ * @brief Test ESC and CSI sequences and their parameters
+ */
+static int test_vt_sequences(void) {
+    TEST_ASSERT(check_parse("\x1b[m", "[csi  m]") == 0);
+    TEST_ASSERT(check_parse("\x1b[1;31mred\x1b[0m", "[csi 1;31 m]red[csi 0 m]") == 0);
+    TEST_ASSERT(check_parse("\x1b[;5H", "[csi 0;5 H]") == 0);
+    TEST_ASSERT(check_parse("\x1b[?1049h\x1b[?25l", "[csi ?1049 h][csi ?25 l]") == 0);
+    TEST_ASSERT(check_parse("\x1b[38:2::255:0:0m", "[csi 38:2:0:255:0:0 m]") == 0);
+    TEST_ASSERT(check_parse("\x1b[2 q", "[csi  2 q]") == 0);
+    TEST_ASSERT(check_parse("\x1b[99999999C", "[csi 65535 C]") == 0);
+    TEST_ASSERT(check_parse("\x1b" "7\x1b" "8\x1b(B\x1b" "c", "[esc  7][esc  8][esc ( B][esc  c]") == 0);
+
+    /* Controls inside a sequence run without ending it */
+    TEST_ASSERT(check_parse("\x1b[1\r\n;2H", "[x0d][x0a][csi 1;2 H]") == 0);
+
+    /* CAN aborts, ESC starts over */
+    TEST_ASSERT(check_parse("\x1b[12\x18x", "[x18]x") == 0);
+    TEST_ASSERT(check_parse("\x1b[12\x1b[3A", "[csi 3 A]") == 0);
+
+    /* Malformed sequences are dropped up to their final byte */
+    TEST_ASSERT(check_parse("\x1b[1?2hok", "ok") == 0);
+    TEST_ASSERT(check_parse("\x1b[ !\"mok", "ok") == 0);
+
+    /* Parameters past the limit are ignored */
+    char input[256] = "\x1b[";
+    char expected[256] = "[csi ";
+    for (int i = 0; i < VT_MAX_PARAMS + 4; i++) {
+        snprintf(input + strlen(input), sizeof(input) - strlen(input), "%d;", i + 1);
+        if (i < VT_MAX_PARAMS) {
+            snprintf(expected + strlen(expected), sizeof(expected) - strlen(expected),
+                     i == 0 ? "%d" : ";%d", i + 1);
+        }
+    }
+    strcat(input, "m");
+    strcat(expected, " m]");
+    TEST_ASSERT(check_parse(input, expected) == 0);
+
+    /* Defaults for missing or zero parameters */
+    VtSequence sequence;
+    memset(&sequence, 0, sizeof(sequence));
+    sequence.params[0] = 0;
+    sequence.params[1] = 7;
+    sequence.param_count = 2;
+    TEST_ASSERT_EQ(1, vt_sequence_param(&sequence, 0, 1));
+    TEST_ASSERT_EQ(7, vt_sequence_param(&sequence, 1, 1));
+    TEST_ASSERT_EQ(1, vt_sequence_param(&sequence, 2, 1));
+    return 0;
+}
+
+/**
+ * @brief Test OSC, DCS and SOS/PM/APC strings
+ */
+static int test_vt_strings(void) {
+    TEST_ASSERT(check_parse("\x1b]0;عنوان\x07" "after", "[osc 0;عنوان]after") == 0);
+    TEST_ASSERT(check_parse("\x1b]8;;http://x\x1b\\link", "[osc 8;;http://x][esc  \\]link") == 0);
+    TEST_ASSERT(check_parse("\x1bPq#0;1\r\x1b\\", "[dcs  q]#0;1\r[/dcs][esc  \\]") == 0);
+    TEST_ASSERT(check_parse("\x1bP1$r0m\x1b\\", "[dcs $1 r]0m[/dcs][esc  \\]") == 0);
+    TEST_ASSERT(check_parse("\x1b_hidden\x07still\x1b\\shown", "[esc  \\]shown") == 0);
+
+    /* OSC strings are cut at the limit */
+    size_t input_length = VT_MAX_OSC_LENGTH + 35;
+    char* input = (char*)malloc(input_length);
+    TEST_ASSERT(input != NULL);
+    memcpy(input, "\x1b]", 2);
+    memset(input + 2, 'a', input_length - 3);
+    input[input_length - 1] = '\x07';
+
+    size_t osc_length = 0;
+    VtParserHandler handler;
+    memset(&handler, 0, sizeof(handler));
+    handler.osc_dispatch = on_osc_length;
+    VtParser* parser = NULL;
+    TEST_ASSERT(vt_parser_create(&parser, &handler, &osc_length) == QALAM_OK);
+    vt_parser_parse(parser, input, input_length);
+    TEST_ASSERT(vt_parser_is_ground(parser));
+    TEST_ASSERT_EQ(VT_MAX_OSC_LENGTH, osc_length);
+    vt_parser_destroy(parser);
+    free(input);
+
+    /* Reset ends an open DCS string */
+    ParseLog log;
+    memset(&log, 0, sizeof(log));
+    TEST_ASSERT(vt_parser_create(&parser, &g_log_handler, &log) == QALAM_OK);
+    vt_parser_parse(parser, "\x1bPqdata", 7);
+    TEST_ASSERT(!vt_parser_is_ground(parser));
+    vt_parser_reset(parser);
+    TEST_ASSERT(vt_parser_is_ground(parser));
+    TEST_ASSERT(strcmp("[dcs  q]data[/dcs]", log.text) == 0);
+    vt_parser_destroy(parser);
+    return 0;
+}
+
+/**
+ * @brief Test that input split at any byte parses the same as in one call
+ */
+static int test_vt_split(void) {
+    static const char input[] =
+        "\x1b[1;38:5:196mأحمر\x1b[0m 😀 ok\r\n"
+        "\x1b]2;نافذة\x07\x1bP1$rx\x1b\\\x1b[?2004h$ ";
+
+    ParseLog whole;
+    memset(&whole, 0, sizeof(whole));
+    VtParser* parser = NULL;
+    TEST_ASSERT(vt_parser_create(&parser, &g_log_handler, &whole) == QALAM_OK);
+    vt_parser_parse(parser, input, strlen(input));
+    vt_parser_destroy(parser);
+
+    for (size_t split = 1; split < strlen(input); split++) {
+        for (size_t second = split; second <= strlen(input); second++) {
+            ParseLog log;
+            memset(&log, 0, sizeof(log));
+            TEST_ASSERT(vt_parser_create(&parser, &g_log_handler, &log) == QALAM_OK);
+            vt_parser_parse(parser, input, split);
+            vt_parser_parse(parser, input + split, second - split);
+            vt_parser_parse(parser, input + second, strlen(input) - second);
+            vt_parser_destroy(parser);
+
+            if (strcmp(whole.text, log.text) != 0) {
+                printf("FAIL: split at %zu and %zu: \"%s\"\n", split, second, log.text);
+                g_test_failures++;
+                return 1;
+            }
+        }
+    }
+    return 0;
+}
+
+/**
+ * @brief Parse throughput over log-like output at every scan level
+ */
+static int test_vt_throughput(void) {
+    size_t length = 16 * 1024 * 1024;
+    char* data = (char*)malloc(length);
+    TEST_ASSERT(data != NULL);
+
+    /* Lines of mixed text with an occasional colour change */
+    size_t used = 0;
+    for (unsigned int line = 0; used + 160 < length; line++) {
+        int written = snprintf(data + used, length - used,
+                               line % 8 == 0 ? "\x1b[3%um[%06u] سجل الحدث: request served in %u ms\x1b[0m\r\n"
+                                             : "[%06u] سجل الحدث: request served in %u ms%.0u\r\n",
+                               line % 8 == 0 ? line % 7 : line, line % 8 == 0 ? line : line % 97,
+                               line % 8 == 0 ? line % 97 : 0);
+        used += (size_t)written;
+    }
+
+    ParseLog log;
+    VtParserHandler handler;
+    memset(&handler, 0, sizeof(handler));
+    handler.print = on_print;
+
+    TextScanLevel original = text_scan_get_level();
+    LARGE_INTEGER start_time, end_time, freq;
+    QueryPerformanceFrequency(&freq);
+    for (int level = TEXT_SCAN_SCALAR; level <= (int)text_scan_get_supported_level(); level++) {
+        text_scan_set_level((TextScanLevel)level);
+        memset(&log, 0, sizeof(log));
+        VtParser* parser = NULL;
+        TEST_ASSERT(vt_parser_create(&parser, &handler, &log) == QALAM_OK);
+
+        QueryPerformanceCounter(&start_time);
+        for (size_t offset = 0; offset < used; offset += 256 * 1024) {
+            size_t chunk = used - offset < 256 * 1024 ? used - offset : 256 * 1024;
+            vt_parser_parse(parser, data + offset, chunk);
+        }
+        QueryPerformanceCounter(&end_time);
+
+        TEST_ASSERT(vt_parser_is_ground(parser));
+        vt_parser_destroy(parser);
+        double seconds = (double)(end_time.QuadPart - start_time.QuadPart) / freq.QuadPart;
+        printf("\n    parse level %d: %.0f MB/s", level,
+               used / (seconds > 0 ? seconds : 1e-9) / 1e6);
+    }
+    text_scan_set_level(original);
+
+    free(data);
+    return 0;
+}
+
+/*=============================================================================
+ * Scrollback Tests
+ *============================================================================*/
+
+#define SB_WIDTH 80
+
+/**
+ * @brief Fill a row from UTF-8 text, one cell a character, blanks after
+ */
+static void sb_make_row(TerminalCell* cells, size_t width, const char* text, uint32_t foreground) {
+    memset(cells, 0, width * sizeof(TerminalCell));
+    const unsigned char* s = (const unsigned char*)text;
+    size_t column = 0;
+    while (*s && column < width) {
+        uint32_t cp;
+        if (s[0] < 0x80) {
+            cp = *s++;
+        } else if (s[0] < 0xE0) {
+            cp = ((uint32_t)(s[0] & 0x1F) << 6) | (s[1] & 0x3F);
+            s += 2;
+        } else if (s[0] < 0xF0) {
+            cp = ((uint32_t)(s[0] & 0x0F) << 12) | ((uint32_t)(s[1] & 0x3F) << 6) | (s[2] & 0x3F);
+            s += 3;
+        } else {
+            cp = ((uint32_t)(s[0] & 0x07) << 18) | ((uint32_t)(s[1] & 0x3F) << 12) |
+                 ((uint32_t)(s[2] & 0x3F) << 6) | (s[3] & 0x3F);
+            s += 4;
+        }
+        cells[column].codepoint = cp;
+        cells[column].attributes.foreground = foreground;
+        column++;
+    }
+}
+
+static bool sb_cells_equal(const TerminalCell* a, const TerminalCell* b, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        uint32_t ca = a[i].codepoint == ' ' ? 0 : a[i].codepoint;
+        uint32_t cb = b[i].codepoint == ' ' ? 0 : b[i].codepoint;
+        if (ca != cb ||
+            a[i].attributes.foreground != b[i].attributes.foreground ||
+            a[i].attributes.background != b[i].attributes.background ||
+            a[i].attributes.flags != b[i].attributes.flags) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/** A row mixing Arabic, a wide character and attributes */
+static void sb_make_mixed_row(TerminalCell* cells, size_t width, uint64_t n) {
+    char text[64];
+    snprintf(text, sizeof(text), "%llu مرحبا X", (unsigned long long)n);
+    sb_make_row(cells, width, text, TERMINAL_COLOR_INDEXED(n % 8));
+
+    size_t length = strlen(text) - 9 + 5; /* 5 Arabic letters of 2 bytes each */
+    cells[length - 1].codepoint = 0x4E2D;
+    cells[length].codepoint = 0;
+    cells[length].attributes = cells[length - 1].attributes;
+    cells[length].attributes.flags |= TERMINAL_ATTR_WIDE_TAIL;
+    cells[1].attributes.flags = TERMINAL_ATTR_BOLD | TERMINAL_ATTR_UNDERLINE;
+    cells[1].attributes.background = TERMINAL_COLOR_RGB(n & 0xFF, 0x20, 0x30);
+}
+
+static int test_scrollback_round_trip(void) {
+    Scrollback* sb = NULL;
+    TEST_ASSERT_EQ(QALAM_OK, scrollback_create(&sb, 0));
+
+    TerminalCell row[SB_WIDTH];
+    TerminalCell out[SB_WIDTH + 8];
+    const uint64_t count = SCROLLBACK_BLOCK_ROWS * (SCROLLBACK_HOT_BLOCKS + 3) + 5;
+
+    for (uint64_t i = 0; i < count; i++) {
+        sb_make_mixed_row(row, SB_WIDTH, i);
+        TEST_ASSERT_EQ(QALAM_OK, scrollback_push_row(sb, row, SB_WIDTH,
+                                                     (i & 1) ? SCROLLBACK_ROW_WRAPPED : 0));
+    }
+    TEST_ASSERT_EQ(0, scrollback_get_first_row(sb));
+    TEST_ASSERT_EQ(count, scrollback_get_end_row(sb));
+
+    ScrollbackStats stats;
+    scrollback_get_stats(sb, &stats);
+    TEST_ASSERT_EQ(count, stats.rows);
+    TEST_ASSERT_EQ(4, stats.packed_blocks);
+    TEST_ASSERT_EQ(SCROLLBACK_BLOCK_ROWS * (SCROLLBACK_HOT_BLOCKS - 1) + 5, stats.hot_rows);
+
+    /* Every row reads back the same, hot or packed, in any order */
+    for (uint64_t k = 0; k < count; k++) {
+        uint64_t i = (k * 97) % count;
+        size_t length = 0;
+        unsigned int flags = 0;
+        sb_make_mixed_row(row, SB_WIDTH, i);
+        TEST_ASSERT_EQ(QALAM_OK, scrollback_read_row(sb, i, out, SB_WIDTH + 8, &length, &flags));
+        TEST_ASSERT(sb_cells_equal(row, out, SB_WIDTH));
+        TEST_ASSERT(out[SB_WIDTH].codepoint == 0 && out[SB_WIDTH].attributes.flags == 0);
+        TEST_ASSERT_EQ((i & 1) ? SCROLLBACK_ROW_WRAPPED : 0, flags);
+        TEST_ASSERT(length < 32 && length > 10);
+    }
+
+    /* A narrower read is cut off */
+    TEST_ASSERT_EQ(QALAM_OK, scrollback_read_row(sb, 3, out, 4, NULL, NULL));
+    sb_make_mixed_row(row, SB_WIDTH, 3);
+    TEST_ASSERT(sb_cells_equal(row, out, 4));
+
+    TEST_ASSERT_EQ(QALAM_ERROR_INVALID_POSITION, scrollback_read_row(sb, count, out, SB_WIDTH, NULL, NULL));
+
+    /* A width change starts a new block */
+    sb_make_row(out, 20, "narrow", 0);
+    TEST_ASSERT_EQ(QALAM_OK, scrollback_push_row(sb, out, 20, 0));
+    sb_make_row(row, SB_WIDTH, "wide again", 0);
+    TEST_ASSERT_EQ(QALAM_OK, scrollback_push_row(sb, row, SB_WIDTH, 0));
+    size_t length = 0;
+    TEST_ASSERT_EQ(QALAM_OK, scrollback_read_row(sb, count, out, SB_WIDTH, &length, NULL));
+    TEST_ASSERT_EQ(6, length);
+    TEST_ASSERT(out[0].codepoint == 'n' && out[5].codepoint == 'w' && out[6].codepoint == 0);
+    TEST_ASSERT_EQ(QALAM_OK, scrollback_read_row(sb, count + 1, out, SB_WIDTH, &length, NULL));
+    TEST_ASSERT_EQ(10, length);
+
+    scrollback_clear(sb);
+    TEST_ASSERT_EQ(count + 2, scrollback_get_first_row(sb));
+    TEST_ASSERT_EQ(count + 2, scrollback_get_end_row(sb));
+    TEST_ASSERT_EQ(QALAM_ERROR_INVALID_POSITION, scrollback_read_row(sb, 0, out, SB_WIDTH, NULL, NULL));
+
+    scrollback_destroy(sb);
+    return 0;
+}
+
+static int test_scrollback_budget(void) {
+    Scrollback* sb = NULL;
+    const size_t budget = 512 * 1024;
+    TEST_ASSERT_EQ(QALAM_OK, scrollback_create(&sb, budget));
+
+    TerminalCell row[SB_WIDTH];
+    const uint64_t count = 100000;
+    for (uint64_t i = 0; i < count; i++) {
+        sb_make_mixed_row(row, SB_WIDTH, i);
+        TEST_ASSERT_EQ(QALAM_OK, scrollback_push_row(sb, row, SB_WIDTH, 0));
+
+        ScrollbackStats stats;
+        scrollback_get_stats(sb, &stats);
+        TEST_ASSERT(stats.bytes <= budget || stats.packed_blocks == 0);
+    }
+
+    ScrollbackStats stats;
+    scrollback_get_stats(sb, &stats);
+    uint64_t first = scrollback_get_first_row(sb);
+    TEST_ASSERT(first > 0);
+    TEST_ASSERT_EQ(first, stats.rows_dropped);
+    TEST_ASSERT_EQ(count - first, stats.rows);
+    TEST_ASSERT_EQ(0, first % SCROLLBACK_BLOCK_ROWS);
+
+    TerminalCell out[SB_WIDTH];
+    TEST_ASSERT_EQ(QALAM_ERROR_INVALID_POSITION, scrollback_read_row(sb, first - 1, out, SB_WIDTH, NULL, NULL));
+    TEST_ASSERT_EQ(QALAM_OK, scrollback_read_row(sb, first, out, SB_WIDTH, NULL, NULL));
+    sb_make_mixed_row(row, SB_WIDTH, first);
+    TEST_ASSERT(sb_cells_equal(row, out, SB_WIDTH));
+
+    scrollback_destroy(sb);
+    return 0;
+}
+
+static int test_scrollback_find(void) {
+    Scrollback* sb = NULL;
+    TEST_ASSERT_EQ(QALAM_OK, scrollback_create(&sb, 0));
+
+    TerminalCell row[SB_WIDTH];
+    const uint64_t count = SCROLLBACK_BLOCK_ROWS * (SCROLLBACK_HOT_BLOCKS + 4);
+    for (uint64_t i = 0; i < count; i++) {
+        if (i == 10 || i == 300 || i == count - 3) {
+            sb_make_row(row, SB_WIDTH, "build: خطأ في السطر 12, خطأ ERROR", 0);
+        } else {
+            sb_make_mixed_row(row, SB_WIDTH, i);
+        }
+        TEST_ASSERT_EQ(QALAM_OK, scrollback_push_row(sb, row, SB_WIDTH, 0));
+    }
+
+    ScrollbackMatch match;
+    bool found = false;
+    const char* word = "خطأ";
+
+    /* Forwards from the start: packed, then packed, then hot */
+    TEST_ASSERT_EQ(QALAM_OK, scrollback_find(sb, word, strlen(word), 0, 0, false, false, &match, &found));
+    TEST_ASSERT(found);
+    TEST_ASSERT_EQ(10, match.row);
+    TEST_ASSERT_EQ(7, match.column);
+    TEST_ASSERT_EQ(3, match.cells);
+
+    TEST_ASSERT_EQ(QALAM_OK, scrollback_find(sb, word, strlen(word), 10, 8, false, false, &match, &found));
+    TEST_ASSERT(found);
+    TEST_ASSERT_EQ(10, match.row);
+    TEST_ASSERT_EQ(24, match.column);
+
+    TEST_ASSERT_EQ(QALAM_OK, scrollback_find(sb, word, strlen(word), 10, 25, false, false, &match, &found));
+    TEST_ASSERT(found);
+    TEST_ASSERT_EQ(300, match.row);
+
+    TEST_ASSERT_EQ(QALAM_OK, scrollback_find(sb, word, strlen(word), 301, 0, false, false, &match, &found));
+    TEST_ASSERT(found);
+    TEST_ASSERT_EQ(count - 3, match.row);
+
+    /* Backwards from the end */
+    TEST_ASSERT_EQ(QALAM_OK, scrollback_find(sb, word, strlen(word), UINT64_MAX, 0, true, false, &match, &found));
+    TEST_ASSERT(found);
+    TEST_ASSERT_EQ(count - 3, match.row);
+    TEST_ASSERT_EQ(24, match.column);
+
+    TEST_ASSERT_EQ(QALAM_OK, scrollback_find(sb, word, strlen(word), 300, 24, true, false, &match, &found));
+    TEST_ASSERT(found);
+    TEST_ASSERT_EQ(300, match.row);
+    TEST_ASSERT_EQ(7, match.column);
+
+    /* Case folding */
+    TEST_ASSERT_EQ(QALAM_OK, scrollback_find(sb, "error", 5, 0, 0, false, false, &match, &found));
+    TEST_ASSERT(!found);
+    TEST_ASSERT_EQ(QALAM_OK, scrollback_find(sb, "error", 5, 0, 0, false, true, &match, &found));
+    TEST_ASSERT(found);
+    TEST_ASSERT_EQ(10, match.row);
+    TEST_ASSERT_EQ(28, match.column);
+
+    /* Columns count wide tails */
+    const char* wide = "\xE4\xB8\xAD"; /* U+4E2D */
+    TEST_ASSERT_EQ(QALAM_OK, scrollback_find(sb, wide, strlen(wide), 0, 0, false, false, &match, &found));
+    TEST_ASSERT(found);
+    TEST_ASSERT_EQ(0, match.row);
+    TEST_ASSERT_EQ(2, match.cells);
+
+    TEST_ASSERT_EQ(QALAM_OK, scrollback_find(sb, "no such", 7, 0, 0, false, false, &match, &found));
+    TEST_ASSERT(!found);
+    TEST_ASSERT_EQ(QALAM_ERROR_INVALID_ARGUMENT, scrollback_find(sb, "", 0, 0, 0, false, false, &match, &found));
+
+    scrollback_destroy(sb);
+    return 0;
+}
+
+static int test_scrollback_memory(void) {
+    Scrollback* sb = NULL;
+    TEST_ASSERT_EQ(QALAM_OK, scrollback_create(&sb, (size_t)1 << 30));
+
+    /* A million lines of build output at 120 columns */
+    TerminalCell row[120];
+    const uint64_t count = 1000000;
+    LARGE_INTEGER frequency, start, end;
+    QueryPerformanceFrequency(&frequency);
+    QueryPerformanceCounter(&start);
+    for (uint64_t i = 0; i < count; i++) {
+        char text[128];
+        snprintf(text, sizeof(text), "[%6llu/1000000] Compiling src/module_%llu.c -> obj/module_%llu.o",
+                 (unsigned long long)i, (unsigned long long)(i % 977), (unsigned long long)(i % 977));
+        sb_make_row(row, 120, text, i % 10 == 0 ? TERMINAL_COLOR_INDEXED(2) : 0);
+        TEST_ASSERT_EQ(QALAM_OK, scrollback_push_row(sb, row, 120, 0));
+    }
+    QueryPerformanceCounter(&end);
+
+    ScrollbackStats stats;
+    scrollback_get_stats(sb, &stats);
+    TEST_ASSERT_EQ(count, stats.rows);
+
+    size_t unpacked = (size_t)count * 120 * sizeof(TerminalCell);
+    TEST_ASSERT(stats.bytes * 10 < unpacked);
+
+    double seconds = (double)(end.QuadPart - start.QuadPart) / (double)frequency.QuadPart;
+    printf("\n    %llu rows in %.1f MB (%.1f MB as cells), %.0f ns a row",
+           (unsigned long long)count, stats.bytes / 1e6, unpacked / 1e6,
+           seconds * 1e9 / (double)count);
+
+    bool found = false;
+    ScrollbackMatch match;
+    TEST_ASSERT_EQ(QALAM_OK, scrollback_find(sb, "[     5/", 8, 0, 0, false, false, &match, &found));
+    TEST_ASSERT(found);
+    TEST_ASSERT_EQ(5, match.row);
+
+    scrollback_destroy(sb);
+    return 0;
+}
+
+/*=============================================================================
+ * Terminal Screen Tests
+ *============================================================================*/
+
+/**
+ * @brief A screen row as UTF-8, empty cells as spaces, trailing ones dropped
+ */
+static const char* screen_text(TerminalScreen* screen, size_t row) {
+    static char text[1024];
+    size_t columns;
+    terminal_screen_get_size(screen, &columns, NULL);
+    const TerminalCell* cells = terminal_screen_get_row(screen, row, NULL);
+
+    size_t length = 0;
+    size_t kept = 0;
+    for (size_t col = 0; cells && col < columns; col++) {
+        if (cells[col].attributes.flags & TERMINAL_ATTR_WIDE_TAIL) {
+            continue;
+        }
+        if (cells[col].codepoint == 0) {
+            text[length++] = ' ';
+        } else {
+            length += terminal_cell_to_utf8(cells[col].codepoint, text + length);
+            kept = length;
+        }
+    }
+    text[kept] = '\0';
+    return text;
+}
+
+static QalamResult screen_put(TerminalScreen* screen, const char* text) {
+    return terminal_screen_write(screen, text, strlen(text));
+}
+
+static int test_screen_wrap(void) {
+    TerminalScreen* screen = NULL;
+    TEST_ASSERT_EQ(QALAM_OK, terminal_screen_create(&screen, 10, 4, 0));
+
+    TEST_ASSERT_EQ(QALAM_OK, screen_put(screen, "hello\r\n0123456789"));
+    TerminalCursor cursor;
+    terminal_screen_get_cursor(screen, &cursor);
+    TEST_ASSERT_EQ(9, cursor.column);
+    TEST_ASSERT_EQ(1, cursor.row);
+    TEST_ASSERT(cursor.visible);
+
+    /* Filling the last column waits for the next character to wrap */
+    unsigned int flags = 0;
+    terminal_screen_get_row(screen, 1, &flags);
+    TEST_ASSERT_EQ(0, flags);
+    screen_put(screen, "AB\tC");
+    terminal_screen_get_row(screen, 1, &flags);
+    TEST_ASSERT_EQ(SCROLLBACK_ROW_WRAPPED, flags);
+    TEST_ASSERT(strcmp(screen_text(screen, 0), "hello") == 0);
+    TEST_ASSERT(strcmp(screen_text(screen, 1), "0123456789") == 0);
+    TEST_ASSERT(strcmp(screen_text(screen, 2), "AB      C") == 0);
+
+    /* A backspace in the last column undoes the pending wrap */
+    screen_put(screen, "D\b\bxy");
+    TEST_ASSERT(strcmp(screen_text(screen, 2), "AB      xy") == 0);
+    terminal_screen_get_cursor(screen, &cursor);
+    TEST_ASSERT_EQ(2, cursor.row);
+
+    /* Without autowrap the last column is overwritten */
+    screen_put(screen, "\x1b[?7l\r\n0123456789WXYZ\x1b[?7h");
+    TEST_ASSERT(strcmp(screen_text(screen, 3), "012345678Z") == 0);
+
+    terminal_screen_destroy(screen);
+    return 0;
+}
+
+static int test_screen_wide_and_marks(void) {
+    TerminalScreen* screen = NULL;
+    TEST_ASSERT_EQ(QALAM_OK, terminal_screen_create(&screen, 10, 4, 0));
+
+    /* Marks join the character before them; a mark with none is dropped */
+    screen_put(screen, "\xd9\x8e" "\xd8\xa8\xd9\x8e\xd8\xaa\xd9\x90\xd9\x91");
+    const TerminalCell* cells = terminal_screen_get_row(screen, 0, NULL);
+    TEST_ASSERT_EQ(0x0628, TERMINAL_CELL_CHAR(cells[0].codepoint));
+    TEST_ASSERT_EQ(0x064E, terminal_mark_codepoint(TERMINAL_CELL_MARK(cells[0].codepoint)));
+    TEST_ASSERT_EQ(0x062A, TERMINAL_CELL_CHAR(cells[1].codepoint));
+    TEST_ASSERT_EQ(0x0650, terminal_mark_codepoint(TERMINAL_CELL_MARK(cells[1].codepoint)));
+    TEST_ASSERT_EQ(0, cells[2].codepoint);
+    TerminalCursor cursor;
+    terminal_screen_get_cursor(screen, &cursor);
+    TEST_ASSERT_EQ(2, cursor.column);
+
+    /* A wide character takes two cells and wraps rather than split */
+    screen_put(screen, "\r\n12345678\xe4\xb8\xad" "9\xe4\xb8\xad");
+    cells = terminal_screen_get_row(screen, 1, NULL);
+    TEST_ASSERT_EQ(0x4E2D, cells[8].codepoint);
+    TEST_ASSERT(cells[9].attributes.flags & TERMINAL_ATTR_WIDE_TAIL);
+    cells = terminal_screen_get_row(screen, 2, NULL);
+    TEST_ASSERT_EQ('9', cells[0].codepoint);
+    TEST_ASSERT_EQ(0x4E2D, cells[1].codepoint);
+    screen_put(screen, "abcdef\xe4\xb8\xad");
+    cells = terminal_screen_get_row(screen, 2, NULL);
+    TEST_ASSERT_EQ(0, cells[9].codepoint);
+    cells = terminal_screen_get_row(screen, 3, NULL);
+    TEST_ASSERT_EQ(0x4E2D, cells[0].codepoint);
+
+    /* Writing over half of a wide character blanks the other half */
+    screen_put(screen, "\x1b[3;3Hx");
+    cells = terminal_screen_get_row(screen, 2, NULL);
+    TEST_ASSERT_EQ(0, cells[1].codepoint);
+    TEST_ASSERT_EQ('x', cells[2].codepoint);
+    TEST_ASSERT_EQ(0, cells[2].attributes.flags);
+    screen_put(screen, "\x1b[2;9Hy");
+    cells = terminal_screen_get_row(screen, 1, NULL);
+    TEST_ASSERT_EQ('y', cells[8].codepoint);
+    TEST_ASSERT_EQ(0, cells[9].attributes.flags);
+
+    terminal_screen_destroy(screen);
+    return 0;
+}
+
+static int test_screen_editing(void) {
+    TerminalScreen* screen = NULL;
+    TEST_ASSERT_EQ(QALAM_OK, terminal_screen_create(&screen, 10, 5, 0));
+
+    screen_put(screen, "aaaaaaaaaa\r\nbbbbbbbbbb\r\ncccccccccc\r\ndddddddddd");
+    screen_put(screen, "\x1b[2;4H\x1b[K");
+    TEST_ASSERT(strcmp(screen_text(screen, 1), "bbb") == 0);
+    screen_put(screen, "\x1b[1;4H\x1b[1K");
+    TEST_ASSERT(strcmp(screen_text(screen, 0), "    aaaaaa") == 0);
+    screen_put(screen, "\x1b[3;2H\x1b[2@");
+    TEST_ASSERT(strcmp(screen_text(screen, 2), "c  ccccccc") == 0);
+    screen_put(screen, "\x1b[3P");
+    TEST_ASSERT(strcmp(screen_text(screen, 2), "ccccccc") == 0);
+    screen_put(screen, "\x1b[3X");
+    TEST_ASSERT(strcmp(screen_text(screen, 2), "c   ccc") == 0);
+
+    /* Insert and delete lines within the rows below the cursor */
+    screen_put(screen, "\x1b[2;5H\x1b[L");
+    TEST_ASSERT(strcmp(screen_text(screen, 1), "") == 0);
+    TEST_ASSERT(strcmp(screen_text(screen, 2), "bbb") == 0);
+    TEST_ASSERT(strcmp(screen_text(screen, 4), "dddddddddd") == 0);
+    TerminalCursor cursor;
+    terminal_screen_get_cursor(screen, &cursor);
+    TEST_ASSERT_EQ(0, cursor.column);
+    screen_put(screen, "\x1b[2M");
+    TEST_ASSERT(strcmp(screen_text(screen, 1), "c   ccc") == 0);
+    TEST_ASSERT(strcmp(screen_text(screen, 2), "dddddddddd") == 0);
+
+    /* Cursor movement stops at the edges */
+    screen_put(screen, "\x1b[99;99H");
+    terminal_screen_get_cursor(screen, &cursor);
+    TEST_ASSERT_EQ(9, cursor.column);
+    TEST_ASSERT_EQ(4, cursor.row);
+    screen_put(screen, "\x1b[2A\x1b[3D\x1b" "7\x1b[H\x1b" "8");
+    terminal_screen_get_cursor(screen, &cursor);
+    TEST_ASSERT_EQ(6, cursor.column);
+    TEST_ASSERT_EQ(2, cursor.row);
+
+    screen_put(screen, "\x1b[J");
+    TEST_ASSERT(strcmp(screen_text(screen, 2), "dddddd") == 0);
+    screen_put(screen, "\x1b[2J");
+    for (size_t r = 0; r < 5; r++) {
+        TEST_ASSERT(strcmp(screen_text(screen, r), "") == 0);
+    }
+
+    terminal_screen_destroy(screen);
+    return 0;
+}
+
+static int test_screen_attributes(void) {
+    TerminalScreen* screen = NULL;
+    TEST_ASSERT_EQ(QALAM_OK, terminal_screen_create(&screen, 20, 2, 0));
+
+    screen_put(screen, "\x1b[1;31ma\x1b[22;4;38;5;200mb\x1b[38:2::1:2:3;48;2;4;5;6mc"
+                       "\x1b[4:0;7;94;106md\x1b[me\x1b[38;2;1;2;3;1mf");
+    const TerminalCell* cells = terminal_screen_get_row(screen, 0, NULL);
+    TEST_ASSERT_EQ(TERMINAL_ATTR_BOLD, cells[0].attributes.flags);
+    TEST_ASSERT_EQ(TERMINAL_COLOR_INDEXED(1), cells[0].attributes.foreground);
+    TEST_ASSERT_EQ(TERMINAL_ATTR_UNDERLINE, cells[1].attributes.flags);
+    TEST_ASSERT_EQ(TERMINAL_COLOR_INDEXED(200), cells[1].attributes.foreground);
+    TEST_ASSERT_EQ(TERMINAL_COLOR_RGB(1, 2, 3), cells[2].attributes.foreground);
+    TEST_ASSERT_EQ(TERMINAL_COLOR_RGB(4, 5, 6), cells[2].attributes.background);
+    TEST_ASSERT_EQ(TERMINAL_ATTR_INVERSE, cells[3].attributes.flags);
+    TEST_ASSERT_EQ(TERMINAL_COLOR_INDEXED(12), cells[3].attributes.foreground);
+    TEST_ASSERT_EQ(TERMINAL_COLOR_INDEXED(14), cells[3].attributes.background);
+    TEST_ASSERT_EQ(0, cells[4].attributes.flags);
+    TEST_ASSERT_EQ(TERMINAL_COLOR_DEFAULT, cells[4].attributes.foreground);
+    TEST_ASSERT_EQ(TERMINAL_COLOR_RGB(1, 2, 3), cells[5].attributes.foreground);
+    TEST_ASSERT_EQ(TERMINAL_ATTR_BOLD, cells[5].attributes.flags);
+
+    /* Erasing uses the pen's background */
+    screen_put(screen, "\x1b[0;44m\x1b[K");
+    TEST_ASSERT_EQ(TERMINAL_COLOR_INDEXED(4), cells[6].attributes.background);
+    TEST_ASSERT_EQ(TERMINAL_COLOR_INDEXED(4), cells[19].attributes.background);
+
+    terminal_screen_destroy(screen);
+    return 0;
+}
+
+static int test_screen_scrolling(void) {
+    TerminalScreen* screen = NULL;
+    TEST_ASSERT_EQ(QALAM_OK, terminal_screen_create(&screen, 10, 3, 0));
+    Scrollback* scrollback = terminal_screen_get_scrollback(screen);
+
+    screen_put(screen, "one\r\ntwo\r\nthree\r\nfour\r\nfive");
+    TEST_ASSERT(strcmp(screen_text(screen, 0), "three") == 0);
+    TEST_ASSERT(strcmp(screen_text(screen, 2), "five") == 0);
+    TEST_ASSERT_EQ(2, scrollback_get_end_row(scrollback));
+
+    TerminalCell row[10];
+    TEST_ASSERT_EQ(QALAM_OK, scrollback_read_row(scrollback, 1, row, 10, NULL, NULL));
+    TEST_ASSERT_EQ('t', row[0].codepoint);
+    TEST_ASSERT_EQ('w', row[1].codepoint);
+
+    /* Rows leaving a scroll region that is not the whole screen are lost */
+    screen_put(screen, "\x1b[2;3r\x1b[3;1H\nsix");
+    TEST_ASSERT(strcmp(screen_text(screen, 0), "three") == 0);
+    TEST_ASSERT(strcmp(screen_text(screen, 1), "five") == 0);
+    TEST_ASSERT(strcmp(screen_text(screen, 2), "six") == 0);
+    TEST_ASSERT_EQ(2, scrollback_get_end_row(scrollback));
+
+    /* Reverse index at the top margin scrolls the region down */
+    screen_put(screen, "\x1b[2;1H\x1bM");
+    TEST_ASSERT(strcmp(screen_text(screen, 1), "") == 0);
+    TEST_ASSERT(strcmp(screen_text(screen, 2), "five") == 0);
+
+    /* ED 3 clears the scrollback */
+    screen_put(screen, "\x1b[r\x1b[3J");
+    TEST_ASSERT_EQ(scrollback_get_first_row(scrollback), scrollback_get_end_row(scrollback));
+
+    terminal_screen_destroy(screen);
+    return 0;
+}
+
+static int test_screen_alternate(void) {
+    TerminalScreen* screen = NULL;
+    TEST_ASSERT_EQ(QALAM_OK, terminal_screen_create(&screen, 10, 3, 0));
+
+    screen_put(screen, "$ vim\r\n");
+    screen_put(screen, "\x1b[?1049h\x1b[Hfile\r\n~\r\n~\r\n~");
+    TEST_ASSERT(terminal_screen_is_alternate(screen));
+    TEST_ASSERT(strcmp(screen_text(screen, 0), "~") == 0);
+    TEST_ASSERT_EQ(0, scrollback_get_end_row(terminal_screen_get_scrollback(screen)));
+
+    screen_put(screen, "\x1b[?25l");
+    TerminalCursor cursor;
+    terminal_screen_get_cursor(screen, &cursor);
+    TEST_ASSERT(!cursor.visible);
+
+    screen_put(screen, "\x1b[?1049l\x1b[?25h");
+    TEST_ASSERT(!terminal_screen_is_alternate(screen));
+    TEST_ASSERT(strcmp(screen_text(screen, 0), "$ vim") == 0);
+    terminal_screen_get_cursor(screen, &cursor);
+    TEST_ASSERT_EQ(0, cursor.column);
+    TEST_ASSERT_EQ(1, cursor.row);
+    TEST_ASSERT(cursor.visible);
+
+    terminal_screen_destroy(screen);
+    return 0;
+}
+
+static int test_screen_reflow(void) {
+    TerminalScreen* screen = NULL;
+    TEST_ASSERT_EQ(QALAM_OK, terminal_screen_create(&screen, 10, 3, 0));
+    Scrollback* scrollback = terminal_screen_get_scrollback(screen);
+
+    screen_put(screen, "abcdefghijKLMNO\r\nxy");
+
+    /* Wider: the wrapped line joins up */
+    TEST_ASSERT_EQ(QALAM_OK, terminal_screen_resize(screen, 20, 3));
+    TEST_ASSERT(strcmp(screen_text(screen, 0), "abcdefghijKLMNO") == 0);
+    TEST_ASSERT(strcmp(screen_text(screen, 1), "xy") == 0);
+    unsigned int flags = 1;
+    terminal_screen_get_row(screen, 0, &flags);
+    TEST_ASSERT_EQ(0, flags);
+    TerminalCursor cursor;
+    terminal_screen_get_cursor(screen, &cursor);
+    TEST_ASSERT_EQ(2, cursor.column);
+    TEST_ASSERT_EQ(1, cursor.row);
+
+    /* Narrower: rows that no longer fit go to the scrollback */
+    TEST_ASSERT_EQ(QALAM_OK, terminal_screen_resize(screen, 5, 3));
+    TEST_ASSERT(strcmp(screen_text(screen, 0), "fghij") == 0);
+    TEST_ASSERT(strcmp(screen_text(screen, 1), "KLMNO") == 0);
+    TEST_ASSERT(strcmp(screen_text(screen, 2), "xy") == 0);
+    TEST_ASSERT_EQ(1, scrollback_get_end_row(scrollback));
+    TerminalCell row[5];
+    TEST_ASSERT_EQ(QALAM_OK, scrollback_read_row(scrollback, 0, row, 5, NULL, &flags));
+    TEST_ASSERT_EQ('a', row[0].codepoint);
+    TEST_ASSERT_EQ(SCROLLBACK_ROW_WRAPPED, flags);
+    terminal_screen_get_cursor(screen, &cursor);
+    TEST_ASSERT_EQ(2, cursor.column);
+    TEST_ASSERT_EQ(2, cursor.row);
+
+    /* Output carries on at the cursor */
+    screen_put(screen, "z");
+    TEST_ASSERT(strcmp(screen_text(screen, 2), "xyz") == 0);
+
+    /* A wide character moves down whole rather than split */
+    screen_put(screen, "\x1b[2J\x1b[Hab\xe4\xb8\xad\xe4\xb8\xad");
+    TEST_ASSERT_EQ(QALAM_OK, terminal_screen_resize(screen, 3, 4));
+    const TerminalCell* cells = terminal_screen_get_row(screen, 0, &flags);
+    TEST_ASSERT_EQ('a', cells[0].codepoint);
+    TEST_ASSERT_EQ(0, cells[2].codepoint);
+    TEST_ASSERT_EQ(SCROLLBACK_ROW_WRAPPED, flags);
+    cells = terminal_screen_get_row(screen, 1, NULL);
+    TEST_ASSERT_EQ(0x4E2D, cells[0].codepoint);
+    TEST_ASSERT_EQ(0, cells[2].codepoint);
+    cells = terminal_screen_get_row(screen, 2, NULL);
+    TEST_ASSERT_EQ(0x4E2D, cells[0].codepoint);
+
+    /* The alternate screen is cut, not reflowed */
+    screen_put(screen, "\x1b[?1049h\x1b[Hpqr");
+    TEST_ASSERT_EQ(QALAM_OK, terminal_screen_resize(screen, 2, 4));
+    TEST_ASSERT(strcmp(screen_text(screen, 0), "pq") == 0);
+    screen_put(screen, "\x1b[?1049l");
+    TEST_ASSERT(strcmp(screen_text(screen, 0), "ab") == 0);
+
+    TEST_ASSERT_EQ(QALAM_ERROR_INVALID_ARGUMENT, terminal_screen_resize(screen, 0, 4));
+
+    terminal_screen_destroy(screen);
+    return 0;
+}
+
+static int test_screen_dirty(void) {
+    TerminalScreen* screen = NULL;
+    TEST_ASSERT_EQ(QALAM_OK, terminal_screen_create(&screen, 10, 3, 0));
+    TEST_ASSERT(terminal_screen_is_dirty(screen));
+
+    terminal_screen_clear_dirty(screen);
+    TEST_ASSERT(!terminal_screen_is_dirty(screen));
+
+    size_t first = 0;
+    size_t end = 0;
+    screen_put(screen, "\x1b[2;4Hab\x1b[2;8Hc");
+    TEST_ASSERT(terminal_screen_is_dirty(screen));
+    TEST_ASSERT(!terminal_screen_get_dirty(screen, 0, &first, &end));
+    TEST_ASSERT(terminal_screen_get_dirty(screen, 1, &first, &end));
+    TEST_ASSERT_EQ(3, first);
+    TEST_ASSERT_EQ(8, end);
+    TEST_ASSERT(!terminal_screen_get_dirty(screen, 2, &first, &end));
+
+    /* Scrolling moves every row */
+    terminal_screen_clear_dirty(screen);
+    screen_put(screen, "\x1b[3;1H\n");
+    for (size_t r = 0; r < 3; r++) {
+        TEST_ASSERT(terminal_screen_get_dirty(screen, r, &first, &end));
+        TEST_ASSERT_EQ(0, first);
+        TEST_ASSERT_EQ(10, end);
+    }
+
+    /* Moving the cursor alone changes no cell */
+    terminal_screen_clear_dirty(screen);
+    screen_put(screen, "\x1b[H\x1b[5C\r");
+    TEST_ASSERT(!terminal_screen_is_dirty(screen));
+
+    terminal_screen_destroy(screen);
+    return 0;
+}
+
+/*=============================================================================
+ * Test Runner
+ *============================================================================*/
+
+int main(void) {
+    printf("===========================================\n");
+    printf("  Qalam IDE - Terminal Unit Tests\n");
+    printf("===========================================\n\n");
+
+    printf("Output Ring:\n");
+    RUN_TEST(ring_basic);
+    RUN_TEST(ring_wrap);
+    RUN_TEST(ring_full);
+    RUN_TEST(ring_threads);
+
+    printf("\nVT Parser:\n");
+    RUN_TEST(vt_text);
+    RUN_TEST(vt_sequences);
+    RUN_TEST(vt_strings);
+    RUN_TEST(vt_split);
+    RUN_TEST(vt_throughput);
+
+    printf("\nScrollback:\n");
+    RUN_TEST(scrollback_round_trip);
+    RUN_TEST(scrollback_budget);
+    RUN_TEST(scrollback_find);
+    RUN_TEST(scrollback_memory);
+
+    printf("\nTerminal Screen:\n");
+    RUN_TEST(screen_wrap);
+    RUN_TEST(screen_wide_and_marks);
+    RUN_TEST(screen_editing);
+    RUN_TEST(screen_attributes);
+    RUN_TEST(screen_scrolling);
+    RUN_TEST(screen_alternate);
+    RUN_TEST(screen_reflow);
+    RUN_TEST(screen_dirty);
+
+    printf("\n===========================================\n");
+    printf("  Test Results: %d/%d passed", g_tests_passed, g_tests_total);
+    if (g_tests_failed > 0) {
+        printf(" (%d FAILED)", g_tests_failed);
+    }
+    printf("\n===========================================\n");
+
+    return g_tests_failed > 0 ? 1 : 0;
+}